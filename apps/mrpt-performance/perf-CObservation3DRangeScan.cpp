@@ -51,6 +51,7 @@ double obs3d_test_depth_to_3d(int a, int b)
 
 	T3DPointsProjectionParams pp;
 	pp.USE_SSE2 = (a & 0x01) != 0;
+	if (a & 0x02) pp.numThreads = 0;
 
 	TRangeImageFilterParams fp;
 	mrpt::math::CMatrixF minF, maxF;
@@ -157,6 +158,9 @@ void register_tests_CObservation3DRangeScan()
 		lstTests.emplace_back(
 			"3DRangeScan: 320x240 Depth->3D (w/SSE2,min/maxFilter)",
 			obs3d_test_depth_to_3d, 0x01, 0x03);
+		lstTests.emplace_back(
+			"3DRangeScan: 320x240 Depth->3D (w/SSE2,min/maxFilter,all threads)",
+			obs3d_test_depth_to_3d, 0x03, 0x03);
 
 		lstTests.emplace_back(
 			"3DRangeScan: 320x240 Depth->2D scan", obs3d_test_depth_to_2d_scan);
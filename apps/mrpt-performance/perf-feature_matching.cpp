@@ -8,7 +8,9 @@
    +------------------------------------------------------------------------+ */
 
 #include <mrpt/img/CImage.h>
+#include <mrpt/random/RandomGenerators.h>
 #include <mrpt/vision/CFeatureExtraction.h>
+#include <mrpt/vision/descriptor_pairing.h>
 
 #include "common.h"
 
@@ -258,6 +260,37 @@ double feature_matching_test_FAST_SAD(int w, int h)
 	return T;
 }
 
+// ------------------------------------------------------
+//	Benchmark: matchDescriptors() with random ORB descriptors
+// ------------------------------------------------------
+double feature_matching_test_packed_ORB(int nFeats, int nThreads)
+{
+	auto& rng = mrpt::random::getRandomGenerator();
+	CFeatureList feats[2];
+	for (auto& fs : feats)
+		for (int i = 0; i < nFeats; i++)
+		{
+			CFeature f;
+			f.descriptors.ORB.emplace(32);
+			for (auto& v : *f.descriptors.ORB)
+				v = rng.drawUniform32bit() & 0xff;
+			fs.push_back(f);
+		}
+
+	TPackedDescriptors d1, d2;
+	feats[0].getPackedDescriptors(descORB, d1);
+	feats[1].getPackedDescriptors(descORB, d2);
+
+	TDescriptorMatchingParams p;
+	p.numThreads = nThreads;
+	std::vector<TDescriptorMatch> matches;
+
+	CTicTac tictac;
+	const size_t N = 20;
+	for (size_t i = 0; i < N; i++) matchDescriptors(d1, d2, matches, p);
+	return tictac.Tac() / N;
+}
+
 // ------------------------------------------------------
 // register_tests_feature_extraction
 // ------------------------------------------------------
@@ -281,4 +314,10 @@ void register_tests_feature_matching()
 	lstTests.emplace_back(
 		"feature_matching [640x480]: FAST + SAD",
 		feature_matching_test_FAST_SAD, 640, 480);
+	lstTests.emplace_back(
+		"feature_matching [2000x2000]: matchDescriptors ORB, 1 thread",
+		feature_matching_test_packed_ORB, 2000, 1);
+	lstTests.emplace_back(
+		"feature_matching [2000x2000]: matchDescriptors ORB, all threads",
+		feature_matching_test_packed_ORB, 2000, 0);
 }
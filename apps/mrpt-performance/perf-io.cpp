@@ -0,0 +1,161 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2020, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/config.h>
+#include <mrpt/io/CFileGZInputStream.h>
+#include <mrpt/io/CFileGZOutputStream.h>
+#include <mrpt/io/CFileOutputStream.h>
+#include <mrpt/io/CFileZstdOutputStream.h>
+#include <mrpt/system/filesystem.h>
+#include <memory>
+#include <vector>
+
+#include "common.h"
+
+using namespace mrpt;
+using namespace mrpt::io;
+using namespace mrpt::system;
+using namespace std;
+using namespace std::string_literals;
+
+// Codecs to compare:
+enum
+{
+	CODEC_NONE = 0,
+	CODEC_GZ,
+	CODEC_GZ_PARALLEL,
+	CODEC_ZSTD
+};
+
+const string io_test_rawlog_file =
+	mrpt::system::getShareMRPTDir() + "datasets/tests_rgbd.rawlog"s;
+
+// The uncompressed contents of a real rawlog, loaded only once:
+static const std::vector<uint8_t>& io_test_data()
+{
+	static std::vector<uint8_t> data;
+	if (data.empty())
+	{
+		CFileGZInputStream f(io_test_rawlog_file);
+		std::vector<uint8_t> buf(1024 * 1024);
+		for (size_t n; (n = f.Read(buf.data(), buf.size())) != 0;)
+			data.insert(data.end(), buf.begin(), buf.begin() + n);
+	}
+	return data;
+}
+
+static const std::string& io_test_tmp_file()
+{
+	static const std::string f = mrpt::system::getTempFileName();
+	return f;
+}
+
+static void io_write_file(int codec, int level)
+{
+	const auto& data = io_test_data();
+	std::unique_ptr<CStream> out;
+	bool ok = false;
+	switch (codec)
+	{
+		case CODEC_NONE:
+		{
+			auto f = std::make_unique<CFileOutputStream>();
+			ok = f->open(io_test_tmp_file());
+			out = std::move(f);
+		}
+		break;
+		case CODEC_GZ:
+		case CODEC_GZ_PARALLEL:
+		{
+			auto f = std::make_unique<CFileGZOutputStream>();
+			if (codec == CODEC_GZ_PARALLEL) f->setParallelCompression(0);
+			ok = f->open(io_test_tmp_file(), level);
+			out = std::move(f);
+		}
+		break;
+		case CODEC_ZSTD:
+		{
+			auto f = std::make_unique<CFileZstdOutputStream>();
+			ok = f->open(io_test_tmp_file(), level);
+			out = std::move(f);
+		}
+		break;
+	};
+	ASSERT_(ok);
+	// Write in pieces, as CArchive does when serializing objects:
+	const size_t chunk = 64 * 1024;
+	for (size_t i = 0; i < data.size(); i += chunk)
+		out->Write(&data[i], std::min(chunk, data.size() - i));
+}
+
+double io_test_write(int codec, int level)
+{
+	const int N = 10;
+	io_test_data();  // Load before timing
+
+	CTicTac tictac;
+	for (int i = 0; i < N; i++) io_write_file(codec, level);
+	return tictac.Tac() / N;
+}
+
+double io_test_read(int codec, int readAhead)
+{
+	const int N = 10;
+	const int level = codec == CODEC_ZSTD ? 3 : 1;
+	io_write_file(codec, level);
+
+	std::vector<uint8_t> buf(64 * 1024);
+	CTicTac tictac;
+	for (int i = 0; i < N; i++)
+	{
+		// CFileGZInputStream detects the actual codec:
+		CFileGZInputStream f;
+		f.setReadAhead(readAhead != 0);
+		ASSERT_(f.open(io_test_tmp_file()));
+		while (f.Read(buf.data(), buf.size()) != 0)
+		{
+		}
+	}
+	return tictac.Tac() / N;
+}
+
+// ------------------------------------------------------
+// register_tests_io
+// ------------------------------------------------------
+void register_tests_io()
+{
+	if (!mrpt::system::fileExists(io_test_rawlog_file)) return;
+
+	lstTests.emplace_back(
+		"io: write rgbd rawlog (uncompressed)", io_test_write, CODEC_NONE);
+	lstTests.emplace_back(
+		"io: write rgbd rawlog (gz, level=1)", io_test_write, CODEC_GZ, 1);
+	lstTests.emplace_back(
+		"io: write rgbd rawlog (gz, level=6)", io_test_write, CODEC_GZ, 6);
+	lstTests.emplace_back(
+		"io: write rgbd rawlog (gz parallel, level=1)", io_test_write,
+		CODEC_GZ_PARALLEL, 1);
+	lstTests.emplace_back(
+		"io: read rgbd rawlog (uncompressed)", io_test_read, CODEC_NONE);
+	lstTests.emplace_back(
+		"io: read rgbd rawlog (gz)", io_test_read, CODEC_GZ, 0);
+	lstTests.emplace_back(
+		"io: read rgbd rawlog (gz, read-ahead)", io_test_read, CODEC_GZ, 1);
+#if MRPT_HAS_ZSTD
+	lstTests.emplace_back(
+		"io: write rgbd rawlog (zstd, level=1)", io_test_write, CODEC_ZSTD, 1);
+	lstTests.emplace_back(
+		"io: write rgbd rawlog (zstd, level=3)", io_test_write, CODEC_ZSTD, 3);
+	lstTests.emplace_back(
+		"io: read rgbd rawlog (zstd)", io_test_read, CODEC_ZSTD, 0);
+	lstTests.emplace_back(
+		"io: read rgbd rawlog (zstd, read-ahead)", io_test_read, CODEC_ZSTD,
+		1);
+#endif
+}
@@ -900,12 +900,18 @@ void NavlogViewerApp::OnslidLogCmdScroll()
 		for (size_t i = 0; i < log.infoPerPTG.size(); i++)
 			ss << "PTG#" << i
 			   << mrpt::format(
-					  " TPObs:%ss HoloNav:%ss |",
+					  " TPObs:%ss HoloNav:%ss Scores:%ss Total:%ss |",
 					  mrpt::system::unitsFormat(
 						  log.infoPerPTG[i].timeForTPObsTransformation)
 						  .c_str(),
 					  mrpt::system::unitsFormat(
 						  log.infoPerPTG[i].timeForHolonomicMethod)
+						  .c_str(),
+					  mrpt::system::unitsFormat(
+						  log.infoPerPTG[i].timeForMoveCandidateScores)
+						  .c_str(),
+					  mrpt::system::unitsFormat(
+						  log.infoPerPTG[i].timeForPTGEvaluation)
 						  .c_str());
 		ADD_WIN_TEXTMSG(ss.str());
 	}
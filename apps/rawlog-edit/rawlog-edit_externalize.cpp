@@ -7,12 +7,16 @@
    | Released under BSD License. See: https://www.mrpt.org/License          |
    +------------------------------------------------------------------------+ */
 
+#include <mrpt/img/CImageCodecPool.h>
 #include <mrpt/obs/CObservation3DRangeScan.h>
 #include <mrpt/obs/CObservationImage.h>
 #include <mrpt/obs/CObservationPointCloud.h>
 #include <mrpt/obs/CObservationStereoImages.h>
 #include "rawlog-edit-declarations.h"
 
+#include <deque>
+#include <future>
+
 using namespace mrpt;
 using namespace mrpt::obs;
 using namespace mrpt::system;
@@ -36,6 +40,28 @@ DECLARE_OP_FUNCTION(op_externalize)
 		string outDir;
 		bool m_external_txt{false};
 
+		/** Images are encoded and saved in parallel threads */
+		mrpt::img::CImageCodecPool m_codecs;
+		std::deque<std::pair<std::future<bool>, string>> m_pendingSaves;
+
+		void checkOldestSave()
+		{
+			auto& s = m_pendingSaves.front();
+			if (!s.first.get())
+				throw runtime_error(
+					string("*ABORTING*: Error saving image: ") + s.second);
+			m_pendingSaves.pop_front();
+		}
+
+		void saveImage(const mrpt::img::CImage& img, const string& fileName)
+		{
+			m_pendingSaves.emplace_back(
+				m_codecs.enqueueSaveToFile(img, outDir + fileName),
+				outDir + fileName);
+			// Bound the memory used by images waiting to be saved:
+			while (m_pendingSaves.size() > 32) checkOldestSave();
+		}
+
 	   public:
 		size_t entries_converted;
 		size_t entries_skipped;  // Already external
@@ -97,7 +123,7 @@ DECLARE_OP_FUNCTION(op_externalize)
 				{
 					const string fileName =
 						"img_"s + label_time + "_left."s + imgFileExtension;
-					obsSt->imageLeft.saveToFile(outDir + fileName);
+					saveImage(obsSt->imageLeft, fileName);
 					obsSt->imageLeft.setExternalStorage(fileName);
 					entries_converted++;
 				}
@@ -108,7 +134,7 @@ DECLARE_OP_FUNCTION(op_externalize)
 				{
 					const string fileName =
 						"img_"s + label_time + "_right."s + imgFileExtension;
-					obsSt->imageRight.saveToFile(outDir + fileName);
+					saveImage(obsSt->imageRight, fileName);
 					obsSt->imageRight.setExternalStorage(fileName);
 					entries_converted++;
 				}
@@ -124,7 +150,7 @@ DECLARE_OP_FUNCTION(op_externalize)
 				{
 					const string fileName =
 						"img_"s + label_time + "."s + imgFileExtension;
-					obsIm->image.saveToFile(outDir + fileName);
+					saveImage(obsIm->image, fileName);
 					obsIm->image.setExternalStorage(fileName);
 					entries_converted++;
 				}
@@ -167,7 +193,7 @@ DECLARE_OP_FUNCTION(op_externalize)
 				{
 					const string fileName =
 						"3DCAM_"s + label_time + "_INT."s + imgFileExtension;
-					obs3D->intensityImage.saveToFile(outDir + fileName);
+					saveImage(obs3D->intensityImage, fileName);
 					obs3D->intensityImage.setExternalStorage(fileName);
 					entries_converted++;
 				}
@@ -180,7 +206,7 @@ DECLARE_OP_FUNCTION(op_externalize)
 				{
 					const string fileName =
 						"3DCAM_"s + label_time + "_CONF."s + imgFileExtension;
-					obs3D->confidenceImage.saveToFile(outDir + fileName);
+					saveImage(obs3D->confidenceImage, fileName);
 					obs3D->confidenceImage.setExternalStorage(fileName);
 					entries_converted++;
 				}
@@ -214,6 +240,12 @@ DECLARE_OP_FUNCTION(op_externalize)
 			return true;
 		}
 
+		/** Waits until all images have been saved */
+		void waitForPendingSaves()
+		{
+			while (!m_pendingSaves.empty()) checkOldestSave();
+		}
+
 		// This method can be reimplemented to save the modified object to an
 		// output stream.
 		void OnPostProcess(
@@ -233,6 +265,7 @@ DECLARE_OP_FUNCTION(op_externalize)
 	// ---------------------------------
 	CRawlogProcessor_Externalize proc(in_rawlog, cmdline, verbose);
 	proc.doProcessRawlog();
+	proc.waitForPendingSaves();
 
 	// Dump statistics:
 	// ---------------------------------
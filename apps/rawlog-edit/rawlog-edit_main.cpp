@@ -70,6 +70,7 @@ DECLARE_OP_FUNCTION(op_remove_label);
 DECLARE_OP_FUNCTION(op_rename_externals);
 DECLARE_OP_FUNCTION(op_sensors_pose);
 DECLARE_OP_FUNCTION(op_stereo_rectify);
+DECLARE_OP_FUNCTION(op_transcode);
 DECLARE_OP_FUNCTION(op_undistort);
 
 // Declare the supported command line switches ===========
@@ -147,6 +148,11 @@ TCLAP::ValueArg<double> arg_odo_D(
 	"Distance between left-right wheels (meters), used in --recalc-odometry.",
 	false, 0, "D", cmd);
 
+TCLAP::ValueArg<int> arg_compress_level(
+	"", "compress-level",
+	"Compression level for --transcode (default: 1 for gz, 3 for zstd).",
+	false, -1, "N", cmd);
+
 TCLAP::SwitchArg arg_overwrite(
 	"w", "overwrite", "Force overwrite target file without prompting.", cmd,
 	false);
@@ -439,6 +445,16 @@ int main(int argc, char** argv)
 			false));
 		ops_functors["undistort"] = &op_undistort;
 
+		arg_ops.push_back(std::make_unique<TCLAP::ValueArg<std::string>>(
+			"", "transcode",
+			"Op: Re-compresses the rawlog with the given codec: gz, zstd "
+			"(much faster to decompress, and seekable) or none. Objects are "
+			"copied as they are, without being parsed.\n"
+			"Requires: -o (or --output)\n"
+			"Optional: --compress-level to set the compression level\n",
+			false, "", "gz|zstd|none", cmd));
+		ops_functors["transcode"] = &op_transcode;
+
 		// --------------- End of list of possible operations --------
 
 		// Parse arguments:
@@ -0,0 +1,105 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2020, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/io/CFileZstdOutputStream.h>
+#include <mrpt/system/CTicTac.h>
+#include <mrpt/system/string_utils.h>
+#include "rawlog-edit-declarations.h"
+
+#include <memory>
+#include <vector>
+
+using namespace mrpt;
+using namespace mrpt::system;
+using namespace mrpt::io;
+using namespace std;
+
+// ======================================================================
+//		op_transcode
+// ======================================================================
+DECLARE_OP_FUNCTION(op_transcode)
+{
+	string codec;
+	getArgValue<std::string>(cmdline, "transcode", codec);
+	codec = mrpt::system::lowerCase(codec);
+
+	string out_file;
+	if (!getArgValue<std::string>(cmdline, "output", out_file))
+		throw runtime_error(
+			"This operation requires an output file. Use '-o file' or "
+			"'--output file'.");
+	if (fileExists(out_file) && !isFlagSet(cmdline, "overwrite"))
+		throw runtime_error(
+			string("*ABORTING*: Output file already exists: ") + out_file +
+			string("\n. Select a different output path, remove the file or "
+				   "force overwrite with '-w' or '--overwrite'."));
+
+	// -1: default level of each codec
+	int level = -1;
+	getArgValue<int>(cmdline, "compress-level", level);
+
+	std::unique_ptr<CStream> out;
+	std::string errMsg;
+	bool openOk = false;
+	if (codec == "gz")
+	{
+		auto f = std::make_unique<CFileGZOutputStream>();
+		openOk = f->open(out_file, level >= 0 ? level : 1, errMsg);
+		out = std::move(f);
+	}
+	else if (codec == "zstd")
+	{
+		auto f = std::make_unique<CFileZstdOutputStream>();
+		openOk = f->open(out_file, level >= 0 ? level : 3, errMsg);
+		out = std::move(f);
+	}
+	else if (codec == "none")
+	{
+		auto f = std::make_unique<CFileOutputStream>();
+		openOk = f->open(out_file);
+		out = std::move(f);
+	}
+	else
+		throw runtime_error(
+			"Unknown codec for --transcode: '" + codec +
+			"'. Valid values are: gz, zstd, none.");
+
+	if (!openOk)
+		throw runtime_error(
+			"*ABORTING*: Cannot open output file: " + out_file + " " + errMsg);
+
+	VERBOSE_COUT << "Transcoding to '" << out_file << "' (" << codec
+				 << ")...\n";
+
+	// Serialized objects are copied as raw bytes, without being parsed:
+	CTicTac tictac;
+	std::vector<uint8_t> buf(1024 * 1024);
+	uint64_t total = 0;
+	for (;;)
+	{
+		const size_t n = in_rawlog.Read(buf.data(), buf.size());
+		if (!n) break;
+		out->Write(buf.data(), n);
+		total += n;
+	}
+	out.reset();  // Close the file, flushing all pending data
+	const double t = tictac.Tac();
+
+	string in_file;
+	getArgValue<std::string>(cmdline, "input", in_file);
+	const uint64_t inSize = getFileSize(in_file);
+	const uint64_t outSize = getFileSize(out_file);
+	VERBOSE_COUT << "Uncompressed size: " << unitsFormat(double(total))
+				 << "B\n";
+	VERBOSE_COUT << "File size: " << unitsFormat(double(inSize)) << "B -> "
+				 << unitsFormat(double(outSize)) << "B\n";
+	VERBOSE_COUT << format(
+		"Time: %.03f s (%.02f MB/s of uncompressed data)\n", t,
+		t > 0 ? total / (t * 1024 * 1024) : 0.0);
+}
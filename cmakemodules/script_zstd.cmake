@@ -0,0 +1,32 @@
+# Check for the zstd compression library
+# ========================================
+
+option(DISABLE_ZSTD "Disable using the zstd compression library" "OFF")
+mark_as_advanced(DISABLE_ZSTD)
+
+set(CMAKE_MRPT_HAS_ZSTD 0)
+set(CMAKE_MRPT_HAS_ZSTD_SYSTEM 0)
+
+if (NOT DISABLE_ZSTD)
+	find_path(ZSTD_INCLUDE_DIR NAMES zstd.h)
+	find_library(ZSTD_LIBRARY NAMES zstd zstd_static)
+	mark_as_advanced(ZSTD_INCLUDE_DIR ZSTD_LIBRARY)
+
+	if(ZSTD_INCLUDE_DIR AND ZSTD_LIBRARY)
+		set(CMAKE_MRPT_HAS_ZSTD 1)
+		set(CMAKE_MRPT_HAS_ZSTD_SYSTEM 1)
+
+		add_library(imp_zstd INTERFACE IMPORTED)
+		set_target_properties(imp_zstd
+			PROPERTIES
+			INTERFACE_INCLUDE_DIRECTORIES ${ZSTD_INCLUDE_DIR}
+			INTERFACE_LINK_LIBRARIES ${ZSTD_LIBRARY}
+			)
+
+		if ($ENV{VERBOSE})
+			message(STATUS "Found zstd:")
+			message(STATUS "  ZSTD_INCLUDE_DIR :${ZSTD_INCLUDE_DIR}")
+			message(STATUS "  ZSTD_LIBRARY     :${ZSTD_LIBRARY}")
+		endif()
+	endif()
+endif()
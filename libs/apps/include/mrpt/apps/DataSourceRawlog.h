@@ -12,10 +12,20 @@
 #include <mrpt/io/CFileGZInputStream.h>
 #include <mrpt/serialization/CArchive.h>
 #include <mrpt/system/COutputLogger.h>
+#include <memory>
 
 namespace mrpt::apps
 {
 /** Implementation of BaseAppDataSource for reading from a rawlog file
+ *
+ * Entries can be optionally read and deserialized in a background thread,
+ * up to `m_prefetch_depth` entries ahead of the consumer, so that file I/O
+ * and decompression overlap with the processing of previous observations.
+ * Config file parameters (in the app main section), read by derived apps:
+ * - `rawlog_prefetch_depth` (Default=0): Maximum number of rawlog entries to
+ * read ahead. 0 means reading synchronously, in the caller thread.
+ * - `rawlog_prefetch_external_images` (Default=false): Whether to also load
+ * (and decode) externally-stored images in the background thread.
  *
  * \ingroup mrpt_apps_grp
  */
@@ -23,8 +33,8 @@ class DataSourceRawlog : virtual public BaseAppDataSource,
 						 virtual public mrpt::system::COutputLogger
 {
    public:
-	DataSourceRawlog() = default;
-	virtual ~DataSourceRawlog() override = default;
+	DataSourceRawlog();
+	virtual ~DataSourceRawlog() override;
 
    protected:
 	bool impl_get_next_observations(
@@ -37,6 +47,23 @@ class DataSourceRawlog : virtual public BaseAppDataSource,
 	std::size_t m_rawlogEntry = 0;
 	mrpt::io::CFileGZInputStream m_rawlog_io;
 	mrpt::serialization::CArchive::UniquePtr m_rawlog_arch;
+
+	/** Max. number of entries read ahead in a background thread (0=disabled)
+	 * \note (New in MRPT 2.1.0) */
+	std::size_t m_prefetch_depth = 0;
+	/** Also load externally-stored images in the prefetch thread
+	 * \note (New in MRPT 2.1.0) */
+	bool m_prefetch_external_images = false;
+
+   private:
+	struct Prefetcher;
+	std::unique_ptr<Prefetcher> m_prefetcher;
+
+	/** Reads the next entry, skipping those before m_rawlog_offset */
+	bool read_next_entry(
+		mrpt::obs::CActionCollection::Ptr& action,
+		mrpt::obs::CSensoryFrame::Ptr& observations,
+		mrpt::obs::CObservation::Ptr& observation, std::size_t& rawlogEntry);
 };
 
 }  // namespace mrpt::apps
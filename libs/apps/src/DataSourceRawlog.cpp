@@ -11,9 +11,70 @@
 
 #include <mrpt/apps/DataSourceRawlog.h>
 #include <mrpt/obs/CRawlog.h>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
 
 using namespace mrpt::apps;
 
+struct DataSourceRawlog::Prefetcher
+{
+	struct Entry
+	{
+		mrpt::obs::CActionCollection::Ptr action;
+		mrpt::obs::CSensoryFrame::Ptr observations;
+		mrpt::obs::CObservation::Ptr observation;
+		std::size_t rawlogEntry = 0;
+	};
+
+	std::mutex mtx;
+	/** Signaled when the queue has room for more entries, or on stop */
+	std::condition_variable cvSpace;
+	/** Signaled when a new entry is queued, or on EOF */
+	std::condition_variable cvData;
+	std::deque<Entry> queue;
+	bool endOfFile = false, stop = false;
+	/** Error in the reader thread, to be rethrown in the consumer thread */
+	std::exception_ptr error;
+	std::thread thread;
+
+	~Prefetcher()
+	{
+		{
+			std::lock_guard<std::mutex> lck(mtx);
+			stop = true;
+		}
+		cvSpace.notify_all();
+		if (thread.joinable()) thread.join();
+	}
+};
+
+DataSourceRawlog::DataSourceRawlog() = default;
+DataSourceRawlog::~DataSourceRawlog()
+{
+	// Stop the reader thread before closing the file:
+	m_prefetcher.reset();
+}
+
+bool DataSourceRawlog::read_next_entry(
+	mrpt::obs::CActionCollection::Ptr& action,
+	mrpt::obs::CSensoryFrame::Ptr& observations,
+	mrpt::obs::CObservation::Ptr& observation, std::size_t& rawlogEntry)
+{
+	for (;;)
+	{
+		if (!mrpt::obs::CRawlog::getActionObservationPairOrObservation(
+				*m_rawlog_arch, action, observations, observation,
+				rawlogEntry))
+			return false;
+
+		// Optional skip of first N entries
+		if (rawlogEntry >= m_rawlog_offset) return true;
+	}
+}
+
 bool DataSourceRawlog::impl_get_next_observations(
 	mrpt::obs::CActionCollection::Ptr& action,
 	mrpt::obs::CSensoryFrame::Ptr& observations,
@@ -33,27 +94,92 @@ bool DataSourceRawlog::impl_get_next_observations(
 		m_rawlog_arch = mrpt::serialization::archiveUniquePtrFrom(m_rawlog_io);
 
 		MRPT_LOG_INFO_FMT("RAWLOG file: `%s`", m_rawlogFileName.c_str());
+
+		if (m_prefetch_depth > 0)
+		{
+			MRPT_LOG_INFO_FMT(
+				"Prefetching up to %u rawlog entries in a background thread",
+				static_cast<unsigned int>(m_prefetch_depth));
+
+			m_prefetcher = std::make_unique<Prefetcher>();
+			m_prefetcher->thread = std::thread([this]() {
+				auto& p = *m_prefetcher;
+				std::size_t rawlogEntry = m_rawlogEntry;
+				try
+				{
+					for (;;)
+					{
+						{
+							// Backpressure: wait for the consumer
+							std::unique_lock<std::mutex> lck(p.mtx);
+							p.cvSpace.wait(lck, [&]() {
+								return p.stop ||
+									p.queue.size() < m_prefetch_depth;
+							});
+							if (p.stop) return;
+						}
+
+						Prefetcher::Entry e;
+						const bool ok = read_next_entry(
+							e.action, e.observations, e.observation,
+							rawlogEntry);
+						if (ok && m_prefetch_external_images)
+						{
+							if (e.observation) e.observation->load();
+							if (e.observations)
+								for (const auto& o : *e.observations)
+									if (o) o->load();
+						}
+						e.rawlogEntry = rawlogEntry;
+
+						std::lock_guard<std::mutex> lck(p.mtx);
+						if (ok)
+							p.queue.emplace_back(std::move(e));
+						else
+							p.endOfFile = true;
+						p.cvData.notify_one();
+						if (!ok) return;
+					}
+				}
+				catch (...)
+				{
+					std::lock_guard<std::mutex> lck(p.mtx);
+					p.error = std::current_exception();
+					p.endOfFile = true;
+					p.cvData.notify_one();
+				}
+			});
+		}
 	}
 
 	// Read:
-
-	for (;;)
+	if (m_prefetcher)
 	{
-		if (!mrpt::obs::CRawlog::getActionObservationPairOrObservation(
-				*m_rawlog_arch, action, observations, observation,
-				m_rawlogEntry))
+		auto& p = *m_prefetcher;
+		std::unique_lock<std::mutex> lck(p.mtx);
+		p.cvData.wait(lck, [&]() { return !p.queue.empty() || p.endOfFile; });
+		if (p.queue.empty())
+		{
+			if (p.error) std::rethrow_exception(p.error);
 			return false;
+		}
+		auto& e = p.queue.front();
+		action = std::move(e.action);
+		observations = std::move(e.observations);
+		observation = std::move(e.observation);
+		m_rawlogEntry = e.rawlogEntry;
+		p.queue.pop_front();
+		lck.unlock();
+		p.cvSpace.notify_one();
+	}
+	else if (!read_next_entry(
+				 action, observations, observation, m_rawlogEntry))
+		return false;
 
-		// Optional skip of first N entries
-		if (m_rawlogEntry < m_rawlog_offset) continue;
-
-		MRPT_LOG_DEBUG_STREAM("Processing rawlog entry #" << m_rawlogEntry);
-
-		// Ok, accept this new observations:
-		return true;
-	};
+	MRPT_LOG_DEBUG_STREAM("Processing rawlog entry #" << m_rawlogEntry);
 
-	return false;
+	// Ok, accept this new observations:
+	return true;
 
 	MRPT_END
 }
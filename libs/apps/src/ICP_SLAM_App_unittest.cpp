@@ -106,3 +106,20 @@ TEST(ICP_SLAM_App, MapFromRawlog_LM)
 		"2006-01ENE-21-SENA_Telecom Faculty_one_loop_only.rawlog",
 		[](mrpt::config::CConfigFileBase&) {}, tester_for_2006_01_21);
 }
+
+// Same than ICP_SLAM_App_Rawlog, reading the rawlog in a background thread:
+class ICP_SLAM_App_Rawlog_Prefetch : public mrpt::apps::ICP_SLAM_App_Rawlog
+{
+   public:
+	ICP_SLAM_App_Rawlog_Prefetch() { m_prefetch_depth = 5; }
+};
+
+TEST(ICP_SLAM_App, MapFromRawlog_Prefetch)
+{
+	using namespace std::string_literals;
+
+	generic_icp_slam_test<ICP_SLAM_App_Rawlog_Prefetch>(
+		"icp-slam_demo_classic.ini",
+		"2006-01ENE-21-SENA_Telecom Faculty_one_loop_only.rawlog",
+		[](mrpt::config::CConfigFileBase&) {}, tester_for_2006_01_21);
+}
@@ -644,6 +644,10 @@ void RBPF_SLAM_App_Rawlog::impl_initialize(int argc, const char** argv)
 			sect, "rawlog_file", std::string("log.rawlog"), true);
 
 	m_rawlog_offset = params.read_int(sect, "rawlog_offset", 0, true);
+	m_prefetch_depth = params.read_uint64_t(
+		sect, "rawlog_prefetch_depth", m_prefetch_depth);
+	m_prefetch_external_images = params.read_bool(
+		sect, "rawlog_prefetch_external_images", m_prefetch_external_images);
 
 	ASSERT_FILE_EXISTS_(m_rawlogFileName);
 
@@ -102,6 +102,8 @@ void RawlogGrabberApp::runImpl()
 	bool use_sensoryframes = false;
 	int GRABBER_PERIOD_MS = 1000;
 	int rawlog_GZ_compress_level = 1;  // 0: No compress, 1-9: compress level
+	// Threads for GZ compression (0: all cores, 1: compress in this thread)
+	int rawlog_GZ_compress_threads = 1;
 
 	MRPT_LOAD_CONFIG_VAR(rawlog_prefix, string, params, GLOBAL_SECT);
 	MRPT_LOAD_CONFIG_VAR(time_between_launches, int, params, GLOBAL_SECT);
@@ -110,6 +112,7 @@ void RawlogGrabberApp::runImpl()
 	MRPT_LOAD_CONFIG_VAR(GRABBER_PERIOD_MS, int, params, GLOBAL_SECT);
 
 	MRPT_LOAD_CONFIG_VAR(rawlog_GZ_compress_level, int, params, GLOBAL_SECT);
+	MRPT_LOAD_CONFIG_VAR(rawlog_GZ_compress_threads, int, params, GLOBAL_SECT);
 
 	// Build full rawlog file name:
 	string rawlog_postfix = "_";
@@ -174,6 +177,7 @@ void RawlogGrabberApp::runImpl()
 	auto out_arch_obj = archiveFrom(out_file);
 	m_out_arch_ptr = &out_arch_obj;
 
+	out_file.setParallelCompression(rawlog_GZ_compress_threads);
 	out_file.open(rawlog_filename, rawlog_GZ_compress_level);
 
 	CGenericSensor::TListObservations copy_of_m_global_list_obs;
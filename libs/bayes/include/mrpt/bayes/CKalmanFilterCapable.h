@@ -15,6 +15,7 @@
 #include <mrpt/io/vector_loadsave.h>
 #include <mrpt/math/CMatrixDynamic.h>
 #include <mrpt/math/CMatrixFixed.h>
+#include <mrpt/math/CSparseMatrix.h>
 #include <mrpt/math/CVectorFixed.h>
 #include <mrpt/math/num_jacobian.h>
 #include <mrpt/math/utils.h>
@@ -23,6 +24,8 @@
 #include <mrpt/system/CTimeLogger.h>
 #include <mrpt/typemeta/TEnumType.h>
 #include <cstring>  // memcpy
+#include <map>
+#include <memory>
 #include <vector>
 
 namespace mrpt
@@ -32,6 +35,12 @@ namespace bayes
 /** The Kalman Filter algorithm to employ in bayes::CKalmanFilterCapable
  *  For further details on each algorithm see the tutorial:
  * https://www.mrpt.org/Kalman_Filters
+ *
+ * kfSEIF is a Sparse Extended Information Filter for SLAM problems: the
+ * covariance matrix is replaced by a sparse information matrix, and only the
+ * covariances required for data association are recovered at each step (see
+ * TKF_options::SEIF_max_active_landmarks). (New in MRPT 2.1.0)
+ *
  * \sa bayes::CKalmanFilterCapable::KF_options
  * \ingroup mrpt_bayes_grp
  */
@@ -40,7 +49,8 @@ enum TKFMethod
 	kfEKFNaive = 0,
 	kfEKFAlaDavison,
 	kfIKFFull,
-	kfIKF
+	kfIKF,
+	kfSEIF
 };
 
 // Forward declaration:
@@ -67,6 +77,11 @@ struct TKF_options : public mrpt::config::CLoadableOptions
 		verbosity_level = iniFile.read_enum<mrpt::system::VerbosityLevel>(
 			section, "verbosity_level", verbosity_level);
 		MRPT_LOAD_CONFIG_VAR(IKF_iterations, int, iniFile, section);
+		const int SEIF_max_active = iniFile.read_int(
+			section, "SEIF_max_active_landmarks",
+			static_cast<int>(SEIF_max_active_landmarks));
+		ASSERT_GE_(SEIF_max_active, 0);
+		SEIF_max_active_landmarks = static_cast<unsigned int>(SEIF_max_active);
 		MRPT_LOAD_CONFIG_VAR(enable_profiler, bool, iniFile, section);
 		MRPT_LOAD_CONFIG_VAR(
 			use_analytic_transition_jacobian, bool, iniFile, section);
@@ -94,6 +109,9 @@ struct TKF_options : public mrpt::config::CLoadableOptions
 				.c_str());
 		out << mrpt::format(
 			"IKF_iterations                          = %i\n", IKF_iterations);
+		out << mrpt::format(
+			"SEIF_max_active_landmarks               = %u\n",
+			SEIF_max_active_landmarks);
 		out << mrpt::format(
 			"enable_profiler                         = %c\n",
 			enable_profiler ? 'Y' : 'N');
@@ -105,6 +123,12 @@ struct TKF_options : public mrpt::config::CLoadableOptions
 	mrpt::system::VerbosityLevel& verbosity_level;
 	/** Number of refinement iterations, only for the IKF method. */
 	int IKF_iterations{5};
+	/** Only for the kfSEIF method: maximum number of landmarks directly
+	 * linked to the vehicle in the information matrix ("active" landmarks).
+	 * The weakest links are removed beyond this number, which keeps the
+	 * information matrix sparse at the price of an approximation.
+	 * \note (New in MRPT 2.1.0) */
+	unsigned int SEIF_max_active_landmarks{30};
 	/** If enabled (default=false), detailed timing information will be dumped
 	 * to the console thru a CTimerLog at the end of the execution. */
 	bool enable_profiler{false};
@@ -278,9 +302,22 @@ class CKalmanFilterCapable : public mrpt::system::COutputLogger
 	 */
 	inline void getLandmarkCov(size_t idx, KFMatrix_FxF& feat_cov) const
 	{
-		feat_cov = m_pkk.blockCopy<FEAT_SIZE, FEAT_SIZE>(
+		if (KF_options.method == kfSEIF && m_info.initialized)
+		{
+			KFMatrix P;
+			SEIF_recoverCovariance(std::vector<size_t>(1, idx), P);
+			feat_cov =
+				P.template blockCopy<FEAT_SIZE, FEAT_SIZE>(VEH_SIZE, VEH_SIZE);
+			return;
+		}
+		feat_cov = m_pkk.template blockCopy<FEAT_SIZE, FEAT_SIZE>(
 			VEH_SIZE + idx * FEAT_SIZE, VEH_SIZE + idx * FEAT_SIZE);
 	}
+	/** Returns the full covariance matrix of the state vector. This is just
+	 * a copy of m_pkk, except for the kfSEIF method, where it is recovered
+	 * from the information matrix (costly for large maps).
+	 * \note (New in MRPT 2.1.0) */
+	void getFullCovariance(KFMatrix& cov) const;
 
    protected:
 	/** @name Kalman filter state
@@ -288,7 +325,9 @@ class CKalmanFilterCapable : public mrpt::system::COutputLogger
 
 	/** The system state vector. */
 	KFVector m_xkk;
-	/** The system full covariance matrix. */
+	/** The system full covariance matrix. With the kfSEIF method, only the
+	 * covariance of the vehicle (the VEH_SIZE x VEH_SIZE top-left block) is
+	 * kept here. */
 	KFMatrix m_pkk;
 
 	/** @} */
@@ -614,6 +653,44 @@ class CKalmanFilterCapable : public mrpt::system::COutputLogger
 	KFMatrix m_S_1;  // Inverse of m_S
 	KFMatrix m_dh_dx_full_obs;
 	KFMatrix m_aux_K_dh_dx;
+	/** kfSEIF: covariance of the vehicle and the predicted landmarks */
+	KFMatrix m_seifCov;
+
+	/** Information matrix for the kfSEIF method, stored as blocks of the
+	 * vehicle (v) and landmarks (y). Only the upper triangle is stored. */
+	struct TInformationMatrix
+	{
+		bool initialized{false};
+		KFMatrix_VxV vv;
+		/** Links to "active" landmarks, indexed by landmark */
+		std::map<size_t, KFMatrix_VxF> vy;
+		/** Diagonal landmark blocks */
+		std::vector<KFMatrix_FxF> yy;
+		/** Off-diagonal landmark blocks: yy_off[i][j] for j>i */
+		std::vector<std::map<size_t, KFMatrix_FxF>> yy_off;
+
+		/** Returns the block (i,j) of two landmarks (i!=j), creating it if
+		 * it does not exist. Returns false if the block is transposed. */
+		bool landmarksBlock(size_t i, size_t j, KFMatrix_FxF*& blk)
+		{
+			if (i < j)
+			{
+				blk = &yy_off[i][j];
+				return true;
+			}
+			blk = &yy_off[j][i];
+			return false;
+		}
+	};
+	TInformationMatrix m_info;
+	/** A sparse Cholesky factorization of m_info */
+	struct TInfoCholesky
+	{
+		mrpt::math::CSparseMatrix Lambda;
+		std::unique_ptr<mrpt::math::CSparseMatrix::CholeskyDecomp> chol;
+	};
+	/** Cached factorization of m_info, reset each time m_info changes */
+	mutable std::shared_ptr<TInfoCholesky> m_infoChol;
 
    protected:
 	/** The main entry point, executes one complete step: prediction + update.
@@ -627,6 +704,32 @@ class CKalmanFilterCapable : public mrpt::system::COutputLogger
    private:
 	mutable bool m_user_didnt_implement_jacobian{true};
 
+	/** @name kfSEIF methods
+		@{ */
+	/** Added to the diagonal of covariances which are inverted into
+	 * information matrices, since they may be singular (e.g. the initial
+	 * vehicle pose, or the normalization of quaternions). */
+	static constexpr double SEIF_min_variance = 1e-9;
+	/** Builds m_info from the full covariance m_pkk, which is left with the
+	 * vehicle block only */
+	void SEIF_initFromCovariance();
+	/** Prediction step, from the transition Jacobian and noise */
+	void SEIF_predict(const KFMatrix_VxV& dfv_dxv, const KFMatrix_VxV& Q);
+	/** Factorizes m_info, or returns the cached factorization */
+	const TInfoCholesky& SEIF_factorize() const;
+	/** Recovers the covariance of the vehicle and the given landmarks, in
+	 * this order, from the information matrix */
+	void SEIF_recoverCovariance(
+		const std::vector<size_t>& lm_idxs, KFMatrix& cov) const;
+	/** Appends a new landmark y=g(x_v,z), given dg/dx_v and the
+	 * covariance of the landmark from the noise of z */
+	void SEIF_addLandmark(
+		const KFMatrix_FxV& dyn_dxv, const KFMatrix_FxF& noise_cov);
+	/** Removes the weakest vehicle-landmark links, keeping at most
+	 * TKF_options::SEIF_max_active_landmarks */
+	void SEIF_sparsify();
+	/** @} */
+
 	/** Auxiliary functions for Jacobian numeric estimation */
 	static void KF_aux_estimate_trans_jacobian(
 		const KFArray_VEH& x, const std::pair<KFCLASS*, KFArray_ACT>& dat,
@@ -662,6 +765,7 @@ MRPT_FILL_ENUM(kfEKFNaive);
 MRPT_FILL_ENUM(kfEKFAlaDavison);
 MRPT_FILL_ENUM(kfIKFFull);
 MRPT_FILL_ENUM(kfIKF);
+MRPT_FILL_ENUM(kfSEIF);
 MRPT_ENUM_TYPE_END()
 
 // Template implementation:
@@ -15,6 +15,7 @@
 #include <mrpt/containers/stl_containers_utils.h>
 #include <mrpt/math/ops_matrices.h>  // extractSubmatrixSymmetrical()
 #include <Eigen/Dense>
+#include <algorithm>
 
 namespace mrpt
 {
@@ -33,8 +34,21 @@ void CKalmanFilterCapable<
 	m_timLogger.enable(KF_options.enable_profiler);
 	m_timLogger.enter("KF:complete_step");
 
-	ASSERT_(int(m_xkk.size()) == m_pkk.cols());
 	ASSERT_(size_t(m_xkk.size()) >= VEH_SIZE);
+
+	// Sparse information filter: m_pkk only holds the vehicle covariance.
+	const bool seif = KF_options.method == kfSEIF;
+	if (seif)
+	{
+		ASSERTMSG_(FEAT_SIZE != 0, "kfSEIF only applies to SLAM problems");
+		// (Re)build the information matrix for new or reset filters:
+		if (!m_info.initialized || isMapEmpty() ||
+			m_info.yy.size() != getNumberOfLandmarksInTheMap())
+			SEIF_initFromCovariance();
+		ASSERT_EQUAL_(m_pkk.cols(), int(VEH_SIZE));
+	}
+	else
+		ASSERT_(int(m_xkk.size()) == m_pkk.cols());
 	// =============================================================
 	//  1. CREATE ACTION MATRIX u FROM ODOMETRY
 	// =============================================================
@@ -144,8 +158,9 @@ void CKalmanFilterCapable<
 		//  3.2:  All Pxy_i
 		// ====================================
 		// Now, update the cov. of landmarks, if any:
+		if (seif) SEIF_predict(dfv_dxv, Q);
 		KFMatrix_VxF aux;
-		for (size_t i = 0; i < N_map; i++)
+		for (size_t i = 0; i < N_map && !seif; i++)
 		{
 			aux = dfv_dxv.asEigen() * m_pkk.template block<VEH_SIZE, FEAT_SIZE>(
 										  0, VEH_SIZE + i * FEAT_SIZE);
@@ -367,29 +382,43 @@ void CKalmanFilterCapable<
 
 		if (FEAT_SIZE > 0)
 		{  // SLAM-like problem:
+			// With kfSEIF, the required covariances are recovered into
+			// m_seifCov: the vehicle, then the predicted landmarks.
+			if (seif && N_pred > 0)
+			{
+				m_timLogger.enter("KF:6.build m_S:recover cov");
+				SEIF_recoverCovariance(m_predictLMidxs, m_seifCov);
+				m_timLogger.leave("KF:6.build m_S:recover cov");
+			}
+			else if (seif)
+				m_seifCov = m_pkk;
+			const KFMatrix& P = seif ? m_seifCov : m_pkk;
+			auto lmOffset = [&](size_t i) {
+				return VEH_SIZE + FEAT_SIZE * (seif ? i : m_predictLMidxs[i]);
+			};
+
 			// Covariance of the vehicle pose
-			const auto Px = m_pkk.template block<VEH_SIZE, VEH_SIZE>(0, 0);
+			const auto Px = P.asEigen().template block<VEH_SIZE, VEH_SIZE>(0, 0);
 
 			for (size_t i = 0; i < N_pred; ++i)
 			{
-				const size_t lm_idx_i = m_predictLMidxs[i];
 				// Pxyi^t
-				const auto Pxyi_t = m_pkk.template block<FEAT_SIZE, VEH_SIZE>(
-					VEH_SIZE + lm_idx_i * FEAT_SIZE, 0);
+				const auto Pxyi_t =
+					P.asEigen().template block<FEAT_SIZE, VEH_SIZE>(
+						lmOffset(i), 0);
 
 				// Only do j>=i (upper triangle), since m_S is symmetric:
 				for (size_t j = i; j < N_pred; ++j)
 				{
-					const size_t lm_idx_j = m_predictLMidxs[j];
 					// Sij block:
 					mrpt::math::CMatrixFixed<KFTYPE, OBS_SIZE, OBS_SIZE> Sij;
 
-					const auto Pxyj = m_pkk.template block<VEH_SIZE, FEAT_SIZE>(
-						0, VEH_SIZE + lm_idx_j * FEAT_SIZE);
+					const auto Pxyj =
+						P.asEigen().template block<VEH_SIZE, FEAT_SIZE>(
+							0, lmOffset(j));
 					const auto Pyiyj =
-						m_pkk.template block<FEAT_SIZE, FEAT_SIZE>(
-							VEH_SIZE + lm_idx_i * FEAT_SIZE,
-							VEH_SIZE + lm_idx_j * FEAT_SIZE);
+						P.asEigen().template block<FEAT_SIZE, FEAT_SIZE>(
+							lmOffset(i), lmOffset(j));
 
 					// clang-format off
 					Sij = m_Hxs[i].asEigen() * Px     * m_Hxs[j].asEigen().transpose() +
@@ -888,6 +917,106 @@ void CKalmanFilterCapable<
 			}
 			break;
 
+			// --------------------------------------------------------------------
+			// - Sparse Extended Information Filter
+			// --------------------------------------------------------------------
+			case kfSEIF:
+			{
+				// Observations of mapped landmarks, and their index in the
+				// predictions (and in m_seifCov):
+				std::vector<size_t> obsIdxs, predIdxs;
+				for (size_t i = 0; i < data_association.size(); ++i)
+				{
+					if (data_association[i] < 0) continue;
+					const size_t assoc_idx_in_pred =
+						mrpt::containers::find_in_vector(
+							static_cast<size_t>(data_association[i]),
+							m_predictLMidxs);
+					ASSERTMSG_(
+						assoc_idx_in_pred != string::npos,
+						"OnPreComputingPredictions() didn't recommend the "
+						"prediction of a landmark which has been actually "
+						"observed!");
+					obsIdxs.push_back(i);
+					predIdxs.push_back(assoc_idx_in_pred);
+				}
+				const size_t N_upd = obsIdxs.size();
+				if (!N_upd) break;
+
+				// Jacobian wrt the variables in m_seifCov, and innovation:
+				const size_t nI = m_seifCov.cols();
+				KFMatrix H;
+				H.setZero(N_upd * OBS_SIZE, nI);
+				KFVector ytilde(N_upd * OBS_SIZE);
+				std::vector<size_t> S_idxs;
+				for (size_t k = 0; k < N_upd; k++)
+				{
+					const size_t p = predIdxs[k];
+					H.asEigen().template block<OBS_SIZE, VEH_SIZE>(
+						k * OBS_SIZE, 0) = m_Hxs[p].asEigen();
+					H.asEigen().template block<OBS_SIZE, FEAT_SIZE>(
+						k * OBS_SIZE, VEH_SIZE + p * FEAT_SIZE) =
+						m_Hys[p].asEigen();
+					KFArray_OBS ytilde_k = m_Z[obsIdxs[k]];
+					OnSubstractObservationVectors(
+						ytilde_k, m_all_predictions[m_predictLMidxs[p]]);
+					for (size_t j = 0; j < OBS_SIZE; j++)
+					{
+						ytilde[k * OBS_SIZE + j] = ytilde_k[j];
+						S_idxs.push_back(p * OBS_SIZE + j);
+					}
+				}
+				KFMatrix S_observed;
+				mrpt::math::extractSubmatrixSymmetrical(
+					m_S, S_idxs, S_observed);
+				m_S_1 = S_observed.inverse_LLt();
+
+				// Mean: x += P*H'*S^-1*ytilde, where P*v = Lambda^-1*v is
+				// solved with the factorization of the information matrix:
+				m_timLogger.enter("KF:8.update stage:1.SEIF:update xkk");
+				const KFVector v_I = KFVector(
+					H.asEigen().transpose() *
+					(m_S_1.asEigen() * ytilde.asEigen()));
+				const size_t n = m_xkk.size();
+				std::vector<double> v(n, 0.0), dx(n);
+				for (size_t i = 0; i < VEH_SIZE; i++) v[i] = v_I[i];
+				for (size_t k = 0; k < N_pred; k++)
+					for (size_t j = 0; j < FEAT_SIZE; j++)
+						v[VEH_SIZE + m_predictLMidxs[k] * FEAT_SIZE + j] =
+							v_I[VEH_SIZE + k * FEAT_SIZE + j];
+				SEIF_factorize().chol->backsub(v.data(), dx.data(), n);
+				for (size_t i = 0; i < n; i++)
+					m_xkk[i] += static_cast<KFTYPE>(dx[i]);
+				m_timLogger.leave("KF:8.update stage:1.SEIF:update xkk");
+
+				// Vehicle covariance: P - P*H'*S^-1*H*P
+				const KFMatrix PHt(
+					m_seifCov.asEigen() * H.asEigen().transpose());
+				const KFMatrix PHt_S_1(PHt.asEigen() * m_S_1.asEigen());
+				m_pkk = KFMatrix(
+					(m_seifCov.asEigen() -
+					 PHt_S_1.asEigen() * PHt.asEigen().transpose())
+						.template block<VEH_SIZE, VEH_SIZE>(0, 0));
+
+				// Information matrix: Lambda += H'*R^-1*H
+				const KFMatrix_OxO R_1 = R.inverse_LLt();
+				for (size_t k = 0; k < N_upd; k++)
+				{
+					const size_t p = predIdxs[k], lm = m_predictLMidxs[p];
+					const auto Hx = m_Hxs[p].asEigen();
+					const auto Hy = m_Hys[p].asEigen();
+					m_info.vv.asEigen() +=
+						Hx.transpose() * R_1.asEigen() * Hx;
+					// (This makes the landmark "active", if it was not)
+					m_info.vy[lm].asEigen() +=
+						Hx.transpose() * R_1.asEigen() * Hy;
+					m_info.yy[lm].asEigen() +=
+						Hy.transpose() * R_1.asEigen() * Hy;
+				}
+				m_infoChol.reset();
+			}
+			break;
+
 			// --------------------------------------------------------------------
 			// - IKF method, processing each observation scalar secuentially:
 			// --------------------------------------------------------------------
@@ -918,6 +1047,13 @@ void CKalmanFilterCapable<
 		m_timLogger.leave("KF:A.add new landmarks");
 	}  // end if data_association!=empty
 
+	if (seif)
+	{
+		m_timLogger.enter("KF:A.SEIF sparsification");
+		SEIF_sparsify();
+		m_timLogger.leave("KF:A.SEIF sparsification");
+	}
+
 	// Post iteration user code:
 	m_timLogger.enter("KF:B.OnPostIteration");
 	OnPostIteration();
@@ -984,6 +1120,291 @@ void CKalmanFilterCapable<VEH_SIZE, OBS_SIZE, FEAT_SIZE, ACT_SIZE, KFTYPE>::
 	out_x = prediction[0];
 }
 
+template <
+	size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE,
+	typename KFTYPE>
+void CKalmanFilterCapable<VEH_SIZE, OBS_SIZE, FEAT_SIZE, ACT_SIZE, KFTYPE>::
+	getFullCovariance(KFMatrix& cov) const
+{
+	if (KF_options.method == kfSEIF && m_info.initialized)
+	{
+		std::vector<size_t> lms(getNumberOfLandmarksInTheMap());
+		for (size_t i = 0; i < lms.size(); i++) lms[i] = i;
+		SEIF_recoverCovariance(lms, cov);
+	}
+	else
+		cov = m_pkk;
+}
+
+template <
+	size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE,
+	typename KFTYPE>
+void CKalmanFilterCapable<
+	VEH_SIZE, OBS_SIZE, FEAT_SIZE, ACT_SIZE, KFTYPE>::SEIF_initFromCovariance()
+{
+	const size_t n = m_xkk.size(), N = getNumberOfLandmarksInTheMap();
+	ASSERTMSG_(
+		m_pkk.rows() == int(n) && m_pkk.cols() == int(n),
+		"kfSEIF: the full covariance is required to build the information "
+		"matrix");
+
+	KFMatrix P = m_pkk;
+	for (size_t i = 0; i < n; i++) P(i, i) += SEIF_min_variance;
+	const KFMatrix L = P.inverse_LLt();
+
+	auto isZero = [](const auto& m) {
+		return m.asEigen().cwiseAbs().maxCoeff() == 0;
+	};
+
+	m_info = TInformationMatrix();
+	m_info.vv = L.template blockCopy<VEH_SIZE, VEH_SIZE>(0, 0);
+	m_info.yy.resize(N);
+	m_info.yy_off.resize(N);
+	for (size_t i = 0; i < N; i++)
+	{
+		const size_t r = VEH_SIZE + i * FEAT_SIZE;
+		const auto vy = L.template blockCopy<VEH_SIZE, FEAT_SIZE>(0, r);
+		if (!isZero(vy)) m_info.vy[i] = vy;
+		m_info.yy[i] = L.template blockCopy<FEAT_SIZE, FEAT_SIZE>(r, r);
+		for (size_t j = i + 1; j < N; j++)
+		{
+			const auto yy = L.template blockCopy<FEAT_SIZE, FEAT_SIZE>(
+				r, VEH_SIZE + j * FEAT_SIZE);
+			if (!isZero(yy)) m_info.yy_off[i][j] = yy;
+		}
+	}
+	m_info.initialized = true;
+	m_infoChol.reset();
+
+	m_pkk = KFMatrix(m_pkk.template blockCopy<VEH_SIZE, VEH_SIZE>(0, 0));
+}
+
+template <
+	size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE,
+	typename KFTYPE>
+void CKalmanFilterCapable<VEH_SIZE, OBS_SIZE, FEAT_SIZE, ACT_SIZE, KFTYPE>::
+	SEIF_predict(const KFMatrix_VxV& dfv_dxv, const KFMatrix_VxV& Q)
+{
+	// Writing the density of the state as p(y)*p(x|y), where
+	//  p(x|y) = N(x; x_mean + G*(y - y_mean), C), C = Lvv^-1, G = -C*Lvy
+	// the motion x' = f(x) only changes the second factor into:
+	//  p(x'|y) = N(x'; x'_mean + F*G*(y - y_mean), F*C*F' + Q)
+	// hence, without inverting F or Q (which may be singular):
+	//  Lvv' = C'^-1, Lvy' = -C'^-1*F*G
+	//  Lyy' = Lyy + G'*(F'*C'^-1*F - Lvv)*G
+	// G is zero but for active landmarks, so the update is sparse.
+	const auto& F = dfv_dxv.asEigen();
+	const KFMatrix_VxV C = m_info.vv.inverse_LLt();
+	KFMatrix_VxV C2 =
+		KFMatrix_VxV(F * C.asEigen() * F.transpose() + Q.asEigen());
+	for (size_t i = 0; i < VEH_SIZE; i++) C2(i, i) += SEIF_min_variance;
+	const KFMatrix_VxV C2_1 = C2.inverse_LLt();
+	const KFMatrix_VxV M = KFMatrix_VxV(
+		F.transpose() * C2_1.asEigen() * F - m_info.vv.asEigen());
+
+	std::vector<size_t> act;
+	std::vector<KFMatrix_VxF> G;
+	for (auto& lnk : m_info.vy)
+	{
+		act.push_back(lnk.first);
+		G.emplace_back(-C.asEigen() * lnk.second.asEigen());
+		lnk.second = KFMatrix_VxF(-C2_1.asEigen() * F * G.back().asEigen());
+	}
+	// (Active landmarks are sorted, so a<b are upper-triangle blocks)
+	for (size_t a = 0; a < act.size(); a++)
+	{
+		const auto GtM = G[a].asEigen().transpose() * M.asEigen();
+		m_info.yy[act[a]].asEigen() += GtM * G[a].asEigen();
+		for (size_t b = a + 1; b < act.size(); b++)
+			m_info.yy_off[act[a]][act[b]].asEigen() += GtM * G[b].asEigen();
+	}
+	m_info.vv = C2_1;
+	m_infoChol.reset();
+}
+
+template <
+	size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE,
+	typename KFTYPE>
+const typename CKalmanFilterCapable<
+	VEH_SIZE, OBS_SIZE, FEAT_SIZE, ACT_SIZE, KFTYPE>::TInfoCholesky&
+	CKalmanFilterCapable<
+		VEH_SIZE, OBS_SIZE, FEAT_SIZE, ACT_SIZE, KFTYPE>::SEIF_factorize() const
+{
+	if (m_infoChol) return *m_infoChol;
+
+	const size_t n = VEH_SIZE + FEAT_SIZE * m_info.yy.size();
+	auto ch = std::make_shared<TInfoCholesky>();
+	auto& L = ch->Lambda;
+	L.clear(n, n);
+	// Only the upper triangle is used by the Cholesky decomposition:
+	auto insertBlock = [&L](size_t r0, size_t c0, const auto& blk) {
+		for (int r = 0; r < blk.rows(); r++)
+			for (int c = (r0 == c0 ? r : 0); c < blk.cols(); c++)
+				L.insert_entry(r0 + r, c0 + c, blk(r, c));
+	};
+	insertBlock(0, 0, m_info.vv);
+	for (const auto& lnk : m_info.vy)
+		insertBlock(0, VEH_SIZE + lnk.first * FEAT_SIZE, lnk.second);
+	for (size_t i = 0; i < m_info.yy.size(); i++)
+	{
+		const size_t r0 = VEH_SIZE + i * FEAT_SIZE;
+		insertBlock(r0, r0, m_info.yy[i]);
+		for (const auto& yy : m_info.yy_off[i])
+			insertBlock(r0, VEH_SIZE + yy.first * FEAT_SIZE, yy.second);
+	}
+	L.compressFromTriplet();
+	ch->chol = std::make_unique<mrpt::math::CSparseMatrix::CholeskyDecomp>(L);
+	m_infoChol = ch;
+	return *m_infoChol;
+}
+
+template <
+	size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE,
+	typename KFTYPE>
+void CKalmanFilterCapable<VEH_SIZE, OBS_SIZE, FEAT_SIZE, ACT_SIZE, KFTYPE>::
+	SEIF_recoverCovariance(
+		const std::vector<size_t>& lm_idxs, KFMatrix& cov) const
+{
+	// Indices in the state vector of the requested variables:
+	const size_t nI = VEH_SIZE + FEAT_SIZE * lm_idxs.size();
+	std::vector<size_t> idxs(nI);
+	for (size_t i = 0; i < VEH_SIZE; i++) idxs[i] = i;
+	for (size_t k = 0; k < lm_idxs.size(); k++)
+	{
+		ASSERT_BELOW_(lm_idxs[k], m_info.yy.size());
+		for (size_t j = 0; j < FEAT_SIZE; j++)
+			idxs[VEH_SIZE + k * FEAT_SIZE + j] =
+				VEH_SIZE + lm_idxs[k] * FEAT_SIZE + j;
+	}
+
+	// Each column of the covariance is the solution of Lambda*x = e_i:
+	const auto& ch = SEIF_factorize();
+	const size_t n = ch.Lambda.cols();
+	std::vector<double> e(n, 0.0), col(n);
+	cov.setSize(nI, nI);
+	for (size_t c = 0; c < nI; c++)
+	{
+		e[idxs[c]] = 1;
+		ch.chol->backsub(e.data(), col.data(), n);
+		e[idxs[c]] = 0;
+		for (size_t r = 0; r < nI; r++)
+			cov(r, c) = static_cast<KFTYPE>(col[idxs[r]]);
+	}
+}
+
+template <
+	size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE,
+	typename KFTYPE>
+void CKalmanFilterCapable<VEH_SIZE, OBS_SIZE, FEAT_SIZE, ACT_SIZE, KFTYPE>::
+	SEIF_addLandmark(
+		const KFMatrix_FxV& dyn_dxv, const KFMatrix_FxF& noise_cov)
+{
+	// For y = G*x + w, w~N(0,Rn), the information matrix of (x,y) is:
+	//  [ Lxx + G'*Rn^-1*G , -G'*Rn^-1 ]
+	//  [     -Rn^-1*G     ,   Rn^-1   ]
+	KFMatrix_FxF Rn = noise_cov;
+	for (size_t i = 0; i < FEAT_SIZE; i++) Rn(i, i) += SEIF_min_variance;
+	const KFMatrix_FxF Rn_1 = Rn.inverse_LLt();
+	const KFMatrix_VxF Gt_Rn_1 =
+		KFMatrix_VxF(dyn_dxv.asEigen().transpose() * Rn_1.asEigen());
+
+	const size_t idx = m_info.yy.size();
+	m_info.vv.asEigen() += Gt_Rn_1.asEigen() * dyn_dxv.asEigen();
+	m_info.vy[idx] = -Gt_Rn_1;
+	m_info.yy.push_back(Rn_1);
+	m_info.yy_off.emplace_back();
+	m_infoChol.reset();
+}
+
+template <
+	size_t VEH_SIZE, size_t OBS_SIZE, size_t FEAT_SIZE, size_t ACT_SIZE,
+	typename KFTYPE>
+void CKalmanFilterCapable<
+	VEH_SIZE, OBS_SIZE, FEAT_SIZE, ACT_SIZE, KFTYPE>::SEIF_sparsify()
+{
+	const size_t maxActive = KF_options.SEIF_max_active_landmarks;
+	if (m_info.vy.size() <= maxActive) return;
+
+	// Keep the strongest links (m+), deactivate the rest (m0):
+	std::vector<std::pair<KFTYPE, size_t>> links;
+	for (const auto& lnk : m_info.vy)
+		links.emplace_back(lnk.second.asEigen().squaredNorm(), lnk.first);
+	std::sort(links.begin(), links.end(), [](const auto& a, const auto& b) {
+		return a.first > b.first;
+	});
+
+	// Dense information of the active landmarks and the vehicle, in this
+	// order: [m+, x, m0]
+	const size_t nAct = links.size(), nKeep = maxActive;
+	const size_t a = FEAT_SIZE * nKeep,
+				 nI = a + VEH_SIZE + FEAT_SIZE * (nAct - nKeep);
+	auto offset = [&](size_t k) {
+		return k < nKeep ? k * FEAT_SIZE : VEH_SIZE + k * FEAT_SIZE;
+	};
+	KFMatrix D;
+	D.setZero(nI, nI);
+	D.insertMatrix(a, a, m_info.vv);
+	for (size_t k = 0; k < nAct; k++)
+	{
+		const size_t lm = links[k].second, ok = offset(k);
+		const auto& vy = m_info.vy[lm];
+		D.insertMatrix(a, ok, vy);
+		D.insertMatrix(ok, a, vy.transpose());
+		D.insertMatrix(ok, ok, m_info.yy[lm]);
+		for (size_t l = k + 1; l < nAct; l++)
+		{
+			const size_t lm2 = links[l].second, ol = offset(l);
+			const auto& off = m_info.yy_off[std::min(lm, lm2)];
+			const auto it = off.find(std::max(lm, lm2));
+			if (it == off.end()) continue;
+			const KFMatrix_FxF blk =
+				lm < lm2 ? it->second : KFMatrix_FxF(it->second.transpose());
+			D.insertMatrix(ok, ol, blk);
+			D.insertMatrix(ol, ok, blk.transpose());
+		}
+	}
+
+	// SEIF sparsification (Thrun et al., IJRR 2004), conditioned on the
+	// passive landmarks, in terms of marginals of D:
+	//  D' = D(m0 out) - D(x,m0 out) + D(x out)
+	const auto& d = D.asEigen();
+	auto marginalizeOut = [&d](size_t s, size_t len) {
+		return KFMatrix(
+			d - d.middleCols(s, len) *
+					d.block(s, s, len, len).llt().solve(d.middleRows(s, len)));
+	};
+	KFMatrix Dp = marginalizeOut(a + VEH_SIZE, nI - a - VEH_SIZE);
+	Dp.asEigen() -= marginalizeOut(a, nI - a).asEigen();
+	Dp.asEigen() += marginalizeOut(a, VEH_SIZE).asEigen();
+
+	// Write back, removing the links to m0:
+	m_info.vv = Dp.template blockCopy<VEH_SIZE, VEH_SIZE>(a, a);
+	for (size_t k = 0; k < nAct; k++)
+	{
+		const size_t lm = links[k].second, ok = offset(k);
+		if (k < nKeep)
+			m_info.vy[lm] = Dp.template blockCopy<VEH_SIZE, FEAT_SIZE>(a, ok);
+		else
+			m_info.vy.erase(lm);
+		m_info.yy[lm] = Dp.template blockCopy<FEAT_SIZE, FEAT_SIZE>(ok, ok);
+		for (size_t l = k + 1; l < nAct; l++)
+		{
+			const size_t lm2 = links[l].second;
+			const KFMatrix_FxF blk =
+				Dp.template blockCopy<FEAT_SIZE, FEAT_SIZE>(ok, offset(l));
+			KFMatrix_FxF* dst;
+			if (m_info.landmarksBlock(lm, lm2, dst))
+				*dst = blk;
+			else
+				*dst = blk.transpose();
+		}
+	}
+	m_infoChol.reset();
+
+	// The vehicle covariance changes too, since its links were modified:
+	SEIF_recoverCovariance(std::vector<size_t>(), m_pkk);
+}
+
 namespace detail
 {
 // generic version for SLAM. There is a speciation below for NON-SLAM problems.
@@ -1045,6 +1466,17 @@ void addNewLandmarks(
 			for (q = 0; q < FEAT_SIZE; q++)
 				obj.internal_getXkk()[idx + q] = yn[q];
 
+			if (obj.KF_options.method == kfSEIF)
+			{
+				obj.SEIF_addLandmark(
+					dyn_dxv, use_dyn_dhn_jacobian
+								 ? typename KF::KFMatrix_FxF(
+									   mrpt::math::multiply_HCHt(dyn_dhn, R))
+								 : dyn_dhn_R_dyn_dhnT);
+				obj.getProfiler().leave("KF:9.create new LMs");
+				continue;
+			}
+
 			// --------------------
 			// Append to Pkk:
 			// --------------------
@@ -163,6 +163,28 @@ class CParticleFilter : public mrpt::system::COutputLogger
 		 * perform rejection sampling, but just the most-likely (ML) particle
 		 * found in the preliminary weight-determination stage. */
 		bool pfAuxFilterOptimal_MLE{false};
+
+		/** (Default=false) If enabled, the prediction and weight-update
+		 * stages of the particles are split among several threads. Currently
+		 * implemented for PF_algorithm=pfStandardProposal with fixed sample
+		 * size (other algorithms ignore this flag).
+		 *
+		 * Motion model samples are still drawn from the calling thread with
+		 * mrpt::random::getRandomGenerator(), in the same order, so results
+		 * are identical to those of the sequential implementation for any
+		 * number of threads.
+		 *
+		 * \note Weights are only evaluated in parallel if the map(s) support
+		 * concurrent likelihood evaluations (see
+		 * mrpt::maps::CMetricMap::prepareForConcurrentLikelihood()), and
+		 * sequentially otherwise.
+		 */
+		bool parallelProcessing{false};
+
+		/** Number of threads to use if parallelProcessing=true, including
+		 * the calling thread. Default (0) means using as many threads as
+		 * hardware cores. */
+		unsigned int parallelNumThreads{0};
 	};
 
 	/** Statistics for being returned from the "execute" method. */
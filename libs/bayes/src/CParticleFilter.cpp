@@ -133,6 +133,12 @@ void CParticleFilter::TParticleFilterOptions::saveToConfigFile(
 		pfAuxFilterStandard_FirstStageWeightsMonteCarlo,
 		"Only for PF_algorithm==pfAuxiliaryPFStandard");
 	MRPT_SAVE_CONFIG_VAR_COMMENT(pfAuxFilterOptimal_MLE, "See doxygen docs.");
+	MRPT_SAVE_CONFIG_VAR_COMMENT(
+		parallelProcessing,
+		"Split prediction and update of particles among threads.");
+	MRPT_SAVE_CONFIG_VAR_COMMENT(
+		parallelNumThreads,
+		"Number of threads for parallelProcessing (0=number of cores)");
 }
 
 /*---------------------------------------------------------------
@@ -175,6 +181,9 @@ void CParticleFilter::TParticleFilterOptions::loadFromConfigFile(
 		section.c_str());
 	MRPT_LOAD_CONFIG_VAR(
 		pfAuxFilterOptimal_MLE, bool, iniFile, section.c_str());
+	MRPT_LOAD_CONFIG_VAR(parallelProcessing, bool, iniFile, section.c_str());
+	MRPT_LOAD_CONFIG_VAR(
+		parallelNumThreads, int, iniFile, section.c_str());
 
 	MRPT_END
 }
@@ -15,11 +15,15 @@
  * @date   Dec 6, 2018
  */
 
+#include <algorithm>
 #include <atomic>
 #include <condition_variable>
 #include <cstdint>
+#include <deque>
+#include <exception>
 #include <functional>
 #include <future>
+#include <memory>
 #include <mutex>
 #include <queue>
 #include <thread>
@@ -31,6 +35,13 @@ namespace mrpt
  * @{ */
 
 /** A thread pool.
+ *
+ * Tasks are submitted with enqueue(). Data-parallel loops can be run with
+ * parallel_for() and parallel_reduce(), which split an index range into
+ * blocks of a given grain size. The calling thread takes part in the
+ * processing of its own loop, so these methods can be safely nested (i.e.
+ * called from within a task already running in the pool) without the risk
+ * of deadlocks, even if all worker threads are busy.
  *
  * \note Partly based on: https://github.com/progschj/ThreadPool (ZLib license)
  *
@@ -45,7 +56,17 @@ class WorkerThreadsPool
 		POLICY_FIFO,
 		/** If a task arrives and there are more pending tasks than worker
 		   threads, drop previous tasks. */
-		POLICY_DROP_OLD
+		POLICY_DROP_OLD,
+		/** Each worker owns a task deque: tasks enqueued from a worker thread
+		 * go to its own deque (executed in LIFO order for cache locality),
+		 * tasks enqueued from other threads are distributed round-robin.
+		 * Idle workers steal the oldest tasks from other workers. This
+		 * avoids the contention on a single queue mutex when many small
+		 * tasks are submitted. No task is ever dropped.
+		 * \note In this mode, resize() can be called only once (the
+		 * constructor with a number of threads already does it).
+		 */
+		POLICY_WORK_STEALING
 	};
 
 	WorkerThreadsPool() = default;
@@ -65,10 +86,78 @@ class WorkerThreadsPool
 	auto enqueue(F&& f, Args&&... args)
 		-> std::future<typename std::result_of<F(Args...)>::type>;
 
+	/** Runs `f(first, last)` for consecutive blocks `[first,last)` covering
+	 * the whole range `[begin,end)`, in parallel.
+	 * Returns when all blocks are done. The calling thread also processes
+	 * blocks, hence it is safe to call this method from a task running in
+	 * this same pool (nested parallelism).
+	 *
+	 * \param grain Maximum number of indices per block. If `0`, a grain
+	 * size is automatically selected so there are a few blocks per thread.
+	 *
+	 * If any invocation of `f` throws, the first exception is rethrown in
+	 * the calling thread once all blocks have finished.
+	 */
+	template <class F>
+	void parallel_for(
+		std::size_t begin, std::size_t end, F&& f, std::size_t grain = 0);
+
+	/** Parallel map-reduce over the range `[begin,end)`: `map(first,last)`
+	 * returns the partial result (of type `T`) for one block, and all
+	 * partial results are combined with `reduce(T,T)`, starting from
+	 * `identity`. Blocks are defined as in parallel_for().
+	 *
+	 * The reduction is always performed by the calling thread in
+	 * increasing block order, so the result is deterministic (independent
+	 * of threads scheduling) for a given grain size, even for
+	 * non-associative operations (e.g. floating point sums).
+	 */
+	template <class T, class MAP, class REDUCE>
+	T parallel_reduce(
+		std::size_t begin, std::size_t end, const T& identity, MAP&& map,
+		REDUCE&& reduce, std::size_t grain = 0);
+
 	/** Returns the number of enqueued tasks, currently waiting for a free
 	 * working thread to process them.  */
 	std::size_t pendingTasks() const noexcept;
 
+	/** Number of worker threads in the pool */
+	std::size_t size() const noexcept { return threads_.size(); }
+
+	/** Returns the process-wide pool used by the data-parallel algorithms of
+	 * MRPT libraries, so all of them share the same worker threads. It has
+	 * one thread less than hardware cores, since the calling thread also
+	 * takes part in parallel_for() loops, and uses POLICY_WORK_STEALING.
+	 * Created on first use.
+	 * \sa overrideNumCores()
+	 */
+	static WorkerThreadsPool& sharedPool();
+
+	/** Returns the number of threads to actually use given a user parameter
+	 * `numThreads`, where `0` means "as many as hardware cores". Values
+	 * larger than the number of cores are clamped to it. Always >=1.
+	 * \sa overrideNumCores()
+	 */
+	static unsigned int clampNumThreads(unsigned int numThreads) noexcept;
+
+	/** Overrides the number of hardware cores assumed by clampNumThreads()
+	 * and sharedPool(), so unit tests can run parallel code paths even in
+	 * single-core machines. `0` restores the actual number of cores.
+	 * The shared pool is re-created if its size changes, hence this must
+	 * not be called while it is running any task.
+	 * \return The former override value (`0` if none).
+	 * \note Intended for unit tests only.
+	 */
+	static unsigned int overrideNumCores(unsigned int numCores);
+
+	/** Returns the automatic grain size used in parallel_for() for a range of
+	 * `n` elements. */
+	std::size_t defaultGrainSize(std::size_t n) const noexcept
+	{
+		const std::size_t nBlocks = 4 * (threads_.size() + 1);
+		return std::max<std::size_t>(1, (n + nBlocks - 1) / nBlocks);
+	}
+
    private:
 	std::vector<std::thread> threads_;
 	std::atomic_bool do_stop_{false};
@@ -76,6 +165,41 @@ class WorkerThreadsPool
 	std::condition_variable condition_;
 	std::queue<std::function<void()>> tasks_;
 	queue_policy_t policy_{POLICY_FIFO};
+
+	/** Per-worker data for POLICY_WORK_STEALING */
+	struct WorkerQueue
+	{
+		std::mutex mtx;
+		std::deque<std::function<void()>> tasks;
+	};
+	std::vector<std::unique_ptr<WorkerQueue>> worker_queues_;
+	std::atomic_size_t ws_pending_{0};
+	std::atomic_size_t ws_next_queue_{0};
+
+	/** Number of parallel_for() helper tasks not started yet. They become
+	 * no-ops once their loop is done, so they are not reported in clear() */
+	std::atomic_size_t pf_queued_helpers_{0};
+
+	/** Inserts a task in POLICY_WORK_STEALING mode */
+	void ws_push(std::function<void()>&& task);
+	/** Gets a task from the own deque or steals from others. Returns false if
+	 * none is available. */
+	bool ws_pop(std::size_t myIndex, std::function<void()>& task);
+	void ws_worker(std::size_t myIndex);
+
+	/** Shared state of one parallel_for() call */
+	struct ParallelForState
+	{
+		std::size_t begin = 0, end = 0, grain = 1, nBlocks = 0;
+		std::atomic_size_t nextBlock{0}, doneBlocks{0};
+		std::mutex mtx;
+		std::condition_variable cv;
+		std::exception_ptr error;
+		std::function<void(std::size_t, std::size_t)> body;
+
+		/** Processes blocks until there are no more left */
+		void run();
+	};
 };
 
 template <class F, class... Args>
@@ -88,6 +212,14 @@ auto WorkerThreadsPool::enqueue(F&& f, Args&&... args)
 		std::bind(std::forward<F>(f), std::forward<Args>(args)...));
 
 	std::future<return_type> res = task->get_future();
+
+	if (policy_ == POLICY_WORK_STEALING)
+	{
+		if (do_stop_) throw std::runtime_error("enqueue on stopped ThreadPool");
+		ws_push([task]() { (*task)(); });
+		return res;
+	}
+
 	{
 		std::unique_lock<std::mutex> lock(queue_mutex_);
 
@@ -110,5 +242,80 @@ auto WorkerThreadsPool::enqueue(F&& f, Args&&... args)
 	return res;
 }
 
+template <class F>
+void WorkerThreadsPool::parallel_for(
+	std::size_t begin, std::size_t end, F&& f, std::size_t grain)
+{
+	if (end <= begin) return;
+	const std::size_t n = end - begin;
+	if (grain == 0) grain = defaultGrainSize(n);
+
+	// Trivial case: run in this thread.
+	if (threads_.empty() || n <= grain)
+	{
+		f(begin, end);
+		return;
+	}
+
+	auto st = std::make_shared<ParallelForState>();
+	st->begin = begin;
+	st->end = end;
+	st->grain = grain;
+	st->nBlocks = (n + grain - 1) / grain;
+	st->body = [&f](std::size_t i0, std::size_t i1) { f(i0, i1); };
+
+	// Helpers: they may start after all blocks are done (even after we
+	// return), that's why the state is kept alive with a shared_ptr.
+	// Note that the reference to "f" is only used while there are blocks
+	// left, which cannot happen once we have returned.
+	const std::size_t nHelpers = std::min(threads_.size(), st->nBlocks - 1);
+	for (std::size_t i = 0; i < nHelpers; i++)
+	{
+		pf_queued_helpers_++;
+		enqueue([this, st]() {
+			pf_queued_helpers_--;
+			st->run();
+		});
+	}
+
+	// The caller thread also works:
+	st->run();
+
+	// Wait for blocks being processed by other threads:
+	{
+		std::unique_lock<std::mutex> lck(st->mtx);
+		st->cv.wait(lck, [&st]() { return st->doneBlocks == st->nBlocks; });
+	}
+	if (st->error) std::rethrow_exception(st->error);
+}
+
+template <class T, class MAP, class REDUCE>
+T WorkerThreadsPool::parallel_reduce(
+	std::size_t begin, std::size_t end, const T& identity, MAP&& map,
+	REDUCE&& reduce, std::size_t grain)
+{
+	if (end <= begin) return identity;
+	const std::size_t n = end - begin;
+	if (grain == 0) grain = defaultGrainSize(n);
+	const std::size_t nBlocks = (n + grain - 1) / grain;
+
+	std::vector<T> partials(nBlocks, identity);
+	parallel_for(
+		0, nBlocks,
+		[&](std::size_t b0, std::size_t b1) {
+			for (std::size_t b = b0; b < b1; b++)
+			{
+				const std::size_t i0 = begin + b * grain;
+				const std::size_t i1 = std::min(end, i0 + grain);
+				partials[b] = map(i0, i1);
+			}
+		},
+		1);
+
+	T result = identity;
+	for (const auto& p : partials) result = reduce(result, p);
+	return result;
+}
+
 /** @} */
 }  // namespace mrpt
@@ -29,24 +29,93 @@ void WorkerThreadsPool::clear()
 	}
 	condition_.notify_all();
 
-	if (!tasks_.empty())
+	const std::size_t nTasks = pendingTasks();
+	const std::size_t nPending =
+		nTasks - std::min<std::size_t>(nTasks, pf_queued_helpers_);
+	if (nPending != 0)
 		std::cerr
 			<< "[WorkerThreadsPool] Warning: clear() called (probably from a "
 			   "dtor) while having "
-			<< tasks_.size() << " pending tasks. Aborting them.\n";
+			<< nPending << " pending tasks. Aborting them.\n";
 
 	for (auto& t : threads_)
 		if (t.joinable()) t.join();
 	threads_.clear();
+	worker_queues_.clear();
+	ws_pending_ = 0;
+	pf_queued_helpers_ = 0;
+}
+
+namespace
+{
+struct SharedPoolData
+{
+	std::mutex mtx;
+	std::unique_ptr<WorkerThreadsPool> pool;
+	std::atomic_uint numCoresOverride{0};
+
+	unsigned int numCores() const noexcept
+	{
+		const unsigned int n = numCoresOverride;
+		return n != 0 ? n : std::max(1U, std::thread::hardware_concurrency());
+	}
+	void createPool()
+	{
+		pool = std::make_unique<WorkerThreadsPool>(
+			numCores() - 1, WorkerThreadsPool::POLICY_WORK_STEALING);
+	}
+};
+SharedPoolData& sharedPoolData()
+{
+	static SharedPoolData d;
+	return d;
+}
+}  // namespace
+
+WorkerThreadsPool& WorkerThreadsPool::sharedPool()
+{
+	auto& d = sharedPoolData();
+	std::lock_guard<std::mutex> lck(d.mtx);
+	if (!d.pool) d.createPool();
+	return *d.pool;
+}
+
+unsigned int WorkerThreadsPool::clampNumThreads(
+	unsigned int numThreads) noexcept
+{
+	const unsigned int nCores = sharedPoolData().numCores();
+	return (numThreads == 0 || numThreads > nCores) ? nCores : numThreads;
+}
+
+unsigned int WorkerThreadsPool::overrideNumCores(unsigned int numCores)
+{
+	auto& d = sharedPoolData();
+	std::lock_guard<std::mutex> lck(d.mtx);
+	const unsigned int former = d.numCoresOverride.exchange(numCores);
+	if (d.pool && d.pool->size() != d.numCores() - 1) d.createPool();
+	return former;
 }
 
 std::size_t WorkerThreadsPool::pendingTasks() const noexcept
 {
+	if (policy_ == POLICY_WORK_STEALING) return ws_pending_;
 	return tasks_.size();
 }
 
 void WorkerThreadsPool::resize(std::size_t num_threads)
 {
+	if (policy_ == POLICY_WORK_STEALING)
+	{
+		ASSERTMSG_(
+			threads_.empty(),
+			"resize() can be called only once in POLICY_WORK_STEALING");
+		for (std::size_t i = 0; i < num_threads; ++i)
+			worker_queues_.emplace_back(std::make_unique<WorkerQueue>());
+		for (std::size_t i = 0; i < num_threads; ++i)
+			threads_.emplace_back([this, i]() { ws_worker(i); });
+		return;
+	}
+
 	for (std::size_t i = 0; i < num_threads; ++i)
 		threads_.emplace_back([this] {
 			for (;;)
@@ -74,3 +143,116 @@ void WorkerThreadsPool::resize(std::size_t num_threads)
 			}
 		});
 }
+
+// The pool and index of the worker running in the current thread, if any:
+static thread_local const WorkerThreadsPool* tl_ws_pool = nullptr;
+static thread_local std::size_t tl_ws_index = 0;
+
+void WorkerThreadsPool::ws_push(std::function<void()>&& task)
+{
+	ASSERTMSG_(
+		!worker_queues_.empty(), "enqueue() on a pool without threads");
+
+	// From a worker of this pool: push to its own deque.
+	// Otherwise, distribute among workers:
+	const std::size_t idx = (tl_ws_pool == this)
+								? tl_ws_index
+								: (ws_next_queue_++ % worker_queues_.size());
+	{
+		auto& wq = *worker_queues_[idx];
+		std::unique_lock<std::mutex> lock(wq.mtx);
+		wq.tasks.emplace_back(std::move(task));
+		ws_pending_++;
+	}
+	// Acquire the mutex so a worker cannot miss the wake-up between
+	// checking ws_pending_ and going to sleep:
+	{
+		std::unique_lock<std::mutex> lock(queue_mutex_);
+	}
+	condition_.notify_one();
+}
+
+bool WorkerThreadsPool::ws_pop(std::size_t myIndex, std::function<void()>& task)
+{
+	const std::size_t N = worker_queues_.size();
+	// 1st: newest task from own deque.
+	{
+		auto& wq = *worker_queues_[myIndex];
+		std::unique_lock<std::mutex> lock(wq.mtx);
+		if (!wq.tasks.empty())
+		{
+			task = std::move(wq.tasks.back());
+			wq.tasks.pop_back();
+			ws_pending_--;
+			return true;
+		}
+	}
+	// 2nd: steal the oldest task from other workers:
+	for (std::size_t k = 1; k < N; k++)
+	{
+		auto& wq = *worker_queues_[(myIndex + k) % N];
+		std::unique_lock<std::mutex> lock(wq.mtx, std::try_to_lock);
+		if (!lock.owns_lock() || wq.tasks.empty()) continue;
+		task = std::move(wq.tasks.front());
+		wq.tasks.pop_front();
+		ws_pending_--;
+		return true;
+	}
+	return false;
+}
+
+void WorkerThreadsPool::ws_worker(std::size_t myIndex)
+{
+	tl_ws_pool = this;
+	tl_ws_index = myIndex;
+	for (;;)
+	{
+		try
+		{
+			std::function<void()> task;
+			if (!ws_pop(myIndex, task))
+			{
+				std::unique_lock<std::mutex> lock(queue_mutex_);
+				condition_.wait(
+					lock, [this] { return do_stop_ || ws_pending_ != 0; });
+				if (do_stop_) return;
+				// Retry: there is (at least) one task somewhere.
+				continue;
+			}
+			if (do_stop_) return;
+			// Execute:
+			task();
+		}
+		catch (std::exception& e)
+		{
+			std::cerr << "[WorkerThreadsPool] Exception:\n"
+					  << mrpt::exception_to_str(e) << "\n";
+		}
+	}
+}
+
+void WorkerThreadsPool::ParallelForState::run()
+{
+	for (;;)
+	{
+		const std::size_t blk = nextBlock++;
+		if (blk >= nBlocks) return;
+
+		const std::size_t i0 = begin + blk * grain;
+		const std::size_t i1 = std::min(end, i0 + grain);
+		try
+		{
+			body(i0, i1);
+		}
+		catch (...)
+		{
+			std::unique_lock<std::mutex> lck(mtx);
+			if (!error) error = std::current_exception();
+		}
+		if (++doneBlocks == nBlocks)
+		{
+			std::unique_lock<std::mutex> lck(mtx);
+			cv.notify_all();
+		}
+	}
+}
@@ -28,3 +28,134 @@ TEST(WorkerThreadsPool, runTasks)
 	}
 	EXPECT_EQ(accum, 6);
 }
+
+TEST(WorkerThreadsPool, runTasksWorkStealing)
+{
+	std::atomic_int accum{0};
+	{
+		mrpt::WorkerThreadsPool pool(
+			3, mrpt::WorkerThreadsPool::POLICY_WORK_STEALING);
+
+		std::vector<std::future<void>> futs;
+		for (int i = 1; i <= 100; i++)
+			futs.emplace_back(pool.enqueue([&accum](int x) { accum += x; }, i));
+		for (auto& f : futs) f.get();
+	}
+	EXPECT_EQ(accum, 5050);
+}
+
+TEST(WorkerThreadsPool, parallel_for)
+{
+	for (auto policy : {mrpt::WorkerThreadsPool::POLICY_FIFO,
+						mrpt::WorkerThreadsPool::POLICY_WORK_STEALING})
+	{
+		mrpt::WorkerThreadsPool pool(4, policy);
+
+		std::vector<int> v(1000, 0);
+		for (std::size_t grain : {0, 1, 7, 1000, 5000})
+		{
+			pool.parallel_for(
+				0, v.size(),
+				[&v](std::size_t i0, std::size_t i1) {
+					for (std::size_t i = i0; i < i1; i++) v[i]++;
+				},
+				grain);
+		}
+		for (const auto& e : v) EXPECT_EQ(e, 5);
+	}
+}
+
+TEST(WorkerThreadsPool, parallel_reduce)
+{
+	mrpt::WorkerThreadsPool pool(
+		4, mrpt::WorkerThreadsPool::POLICY_WORK_STEALING);
+
+	const auto sum = pool.parallel_reduce(
+		1, 10001, std::size_t(0),
+		[](std::size_t i0, std::size_t i1) {
+			std::size_t s = 0;
+			for (std::size_t i = i0; i < i1; i++) s += i;
+			return s;
+		},
+		[](std::size_t a, std::size_t b) { return a + b; }, 13);
+	EXPECT_EQ(sum, 50005000U);
+}
+
+TEST(WorkerThreadsPool, parallel_for_nested)
+{
+	for (auto policy : {mrpt::WorkerThreadsPool::POLICY_FIFO,
+						mrpt::WorkerThreadsPool::POLICY_WORK_STEALING})
+	{
+		// Less threads than outer blocks: all of them will be busy when
+		// launching the inner loops, which must not deadlock.
+		mrpt::WorkerThreadsPool pool(2, policy);
+
+		std::atomic_size_t count{0};
+		pool.parallel_for(
+			0, 8,
+			[&](std::size_t i0, std::size_t i1) {
+				for (std::size_t i = i0; i < i1; i++)
+					pool.parallel_for(
+						0, 100,
+						[&](std::size_t j0, std::size_t j1) {
+							count += j1 - j0;
+						},
+						10);
+			},
+			1);
+		EXPECT_EQ(count, 800U);
+	}
+}
+
+TEST(WorkerThreadsPool, parallel_for_exception)
+{
+	mrpt::WorkerThreadsPool pool(2);
+	EXPECT_THROW(
+		pool.parallel_for(
+			0, 100,
+			[](std::size_t i0, std::size_t) {
+				if (i0 == 50) throw std::runtime_error("test");
+			},
+			10),
+		std::runtime_error);
+}
+
+TEST(WorkerThreadsPool, sharedPool)
+{
+	const unsigned int nCores =
+		std::max(1U, std::thread::hardware_concurrency());
+	EXPECT_EQ(mrpt::WorkerThreadsPool::clampNumThreads(0), nCores);
+	EXPECT_EQ(mrpt::WorkerThreadsPool::clampNumThreads(1), 1U);
+	EXPECT_EQ(mrpt::WorkerThreadsPool::clampNumThreads(nCores + 1), nCores);
+
+	auto& pool = mrpt::WorkerThreadsPool::sharedPool();
+	EXPECT_EQ(&pool, &mrpt::WorkerThreadsPool::sharedPool());
+	EXPECT_EQ(pool.size(), nCores - 1);
+
+	std::atomic_size_t count{0};
+	pool.parallel_for(
+		0, 1000, [&](std::size_t i0, std::size_t i1) { count += i1 - i0; });
+	EXPECT_EQ(count, 1000U);
+}
+
+TEST(WorkerThreadsPool, overrideNumCores)
+{
+	const unsigned int former = mrpt::WorkerThreadsPool::overrideNumCores(3);
+	EXPECT_EQ(mrpt::WorkerThreadsPool::clampNumThreads(0), 3U);
+	EXPECT_EQ(mrpt::WorkerThreadsPool::clampNumThreads(2), 2U);
+	EXPECT_EQ(mrpt::WorkerThreadsPool::clampNumThreads(5), 3U);
+
+	auto& pool = mrpt::WorkerThreadsPool::sharedPool();
+	EXPECT_EQ(pool.size(), 2U);
+
+	std::atomic_size_t count{0};
+	pool.parallel_for(
+		0, 1000, [&](std::size_t i0, std::size_t i1) { count += i1 - i0; });
+	EXPECT_EQ(count, 1000U);
+
+	EXPECT_EQ(mrpt::WorkerThreadsPool::overrideNumCores(former), 3U);
+	const unsigned int nCores =
+		std::max(1U, std::thread::hardware_concurrency());
+	EXPECT_EQ(mrpt::WorkerThreadsPool::clampNumThreads(0), nCores);
+	EXPECT_EQ(mrpt::WorkerThreadsPool::sharedPool().size(), nCores - 1);
+}
@@ -13,8 +13,12 @@
 #include "graphslam/types.h"
 
 // Graph SLAM: Batch solvers
+#include "graphslam/CSparseCholeskySolver.h"
 #include "graphslam/levmarq.h"
 
+// Graph SLAM: Incremental solvers
+#include "graphslam/CIncrementalGraphOptimizer.h"
+
 // Interfaces for implementing deciders/optimizers
 #include "graphslam/interfaces/CEdgeRegistrationDecider.h"
 #include "graphslam/interfaces/CGraphSlamOptimizer.h"
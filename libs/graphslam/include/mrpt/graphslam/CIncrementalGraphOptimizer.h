@@ -0,0 +1,375 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2020, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <mrpt/containers/yaml.h>
+#include <mrpt/graphslam/CSparseCholeskySolver.h>
+#include <mrpt/graphslam/levmarq.h>
+#include <mrpt/graphslam/types.h>
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace mrpt::graphslam
+{
+/** Incremental (iSAM-like) optimizer of pose graphs which grow over time, as
+ * in online SLAM.
+ *
+ * Each call to update() only processes the nodes and edges added to the graph
+ * since the former call: new edges are linearized once and their
+ * contributions added to the Hessian of the problem, whose Cholesky factor is
+ * then updated incrementally by a CSparseCholeskySolverSupernodal in
+ * incremental mode (only the columns of the factor touched by the new edges
+ * are recomputed). The new node estimates are the result of one Gauss-Newton
+ * step from their linearization points.
+ *
+ * Since linearization errors accumulate, a batch step (a full
+ * optimize_graph_spa_levmarq() call, followed by a relinearization of all
+ * edges and a new fill-reducing ordering) is run every
+ * TOptions::relinearize_every updates, or whenever requested with
+ * requestBatchStep().
+ *
+ * \code
+ * CIncrementalGraphOptimizer<CNetworkOfPoses2DInf> opt;
+ * for (...) {
+ *    // Add nodes and edges to the graph...
+ *    opt.update(graph);
+ * }
+ * \endcode
+ *
+ * \tparam GRAPH_T Any mrpt::graphs::CNetworkOfPoses<> supported by
+ * optimize_graph_spa_levmarq().
+ * \sa CLevMarqGSO
+ * \ingroup mrpt_graphslam_grp
+ * \note (New in MRPT 2.1.0)
+ */
+template <class GRAPH_T>
+class CIncrementalGraphOptimizer
+{
+   public:
+	using gst = graphslam_traits<GRAPH_T>;
+
+	struct TOptions
+	{
+		/** Run a batch optimization and relinearization every N updates (0:
+		 * only when requested with requestBatchStep()) */
+		size_t relinearize_every{50};
+		/** Damping term added to the diagonal of the Hessian */
+		double lambda{1e-6};
+		/** Parameters for optimize_graph_spa_levmarq() in batch steps. The
+		 * "linear_solver" is always set to "supernodal". */
+		mrpt::containers::yaml batch_params;
+	};
+
+	/** Information on the last call to update() */
+	struct TUpdateInfo
+	{
+		/** Whether it was a batch step */
+		bool batch_step{false};
+		/** Number of free nodes (blocks of the Hessian) */
+		size_t num_free_nodes{0};
+		/** Number of new edges linearized in this update */
+		size_t num_new_edges{0};
+		/** First column of the Cholesky factor which had to be recomputed */
+		size_t first_refactorized_block{0};
+	};
+
+	CIncrementalGraphOptimizer() { m_solver.options.incremental = true; }
+
+	TOptions options;
+
+	/** Incorporates all nodes and edges added to \a graph since the last call
+	 * and updates the estimates in graph.nodes. Removing or modifying edges,
+	 * or changing the root node, triggers a batch step. */
+	void update(GRAPH_T& graph, TUpdateInfo* info = nullptr);
+
+	/** Forces the next update() to be a batch step. Can be called from a
+	 * thread other than the one running update(). */
+	void requestBatchStep() { m_batchRequested = true; }
+
+	/** Discards all the state: the next update() will be a batch step. */
+	void reset()
+	{
+		m_nodeIdx.clear();
+		m_x0.clear();
+		m_edges.clear();
+		m_numEdges = 0;
+		m_H = TBlockSparseMatrix();
+		m_g.resize(0);
+		m_solver.reset();
+		m_updatesSinceBatch = 0;
+		m_batchRequested = true;
+	}
+
+	/** The underlying incremental sparse solver */
+	const CSparseCholeskySolverSupernodal& solver() const { return m_solver; }
+
+   private:
+	using pose_t = typename gst::edge_poses_type;
+	using edge_entry_t = typename gst::edge_map_entry_t;
+
+	/** Index of each free node in the Hessian */
+	std::map<mrpt::graphs::TNodeID, size_t> m_nodeIdx;
+	/** Linearization point of each free node */
+	std::map<mrpt::graphs::TNodeID, pose_t> m_x0;
+	/** Measurements of the edges already linearized, for each pair of
+	 * nodes, in the order of graph.edges */
+	std::map<std::pair<mrpt::graphs::TNodeID, mrpt::graphs::TNodeID>,
+			 std::vector<pose_t>>
+		m_edges;
+	size_t m_numEdges{0};
+	mrpt::graphs::TNodeID m_root{0};
+
+	TBlockSparseMatrix m_H;
+	mrpt::math::CVectorDouble m_g;
+	CSparseCholeskySolverSupernodal m_solver;
+
+	size_t m_updatesSinceBatch{0};
+	std::atomic_bool m_batchRequested{true};
+
+	void batchStep(GRAPH_T& graph, TUpdateInfo& info);
+	/** Adds the linearization of one edge to m_H and m_g, and records it in
+	 * m_edges */
+	void linearizeEdge(const GRAPH_T& graph, const edge_entry_t& edge);
+	/** Returns the edges which are not in m_edges yet, or false if any edge
+	 * in m_edges was removed or modified */
+	bool findNewEdges(
+		const GRAPH_T& graph, std::vector<const edge_entry_t*>& newEdges) const;
+	/** Assigns indices and linearization points to new free nodes */
+	void addNewNodes(const GRAPH_T& graph);
+};
+
+template <class GRAPH_T>
+void CIncrementalGraphOptimizer<GRAPH_T>::update(
+	GRAPH_T& graph, TUpdateInfo* out_info)
+{
+	MRPT_START
+
+	TUpdateInfo info;
+
+	// Consume the request now, so one made while updating is not lost:
+	bool doBatch = m_batchRequested.exchange(false) || graph.root != m_root ||
+		graph.edges.size() < m_numEdges ||
+		(options.relinearize_every > 0 &&
+		 m_updatesSinceBatch + 1 >= options.relinearize_every);
+
+	std::vector<const edge_entry_t*> newEdges;
+	if (!doBatch) doBatch = !findNewEdges(graph, newEdges);
+
+	if (!doBatch)
+	{
+		addNewNodes(graph);
+		const size_t nFree = m_nodeIdx.size();
+		if (!nFree)
+		{
+			if (out_info) *out_info = info;
+			return;
+		}
+		m_H.growTo(nFree);
+		m_g.resize(nFree * m_H.blockSize, true /*zero new elements*/);
+		for (const auto e : newEdges) linearizeEdge(graph, *e);
+		info.num_new_edges = newEdges.size();
+
+		// Incremental factorization and solution of H*d=g:
+		mrpt::math::CVectorDouble d;
+		try
+		{
+			m_solver.factorize(m_H, options.lambda);
+			m_solver.solve(m_g, d);
+		}
+		catch (const mrpt::math::CExceptionNotDefPos&)
+		{
+			doBatch = true;
+		}
+
+		if (!doBatch)
+		{
+			// New estimates: x = x0 (+) exp(-d)
+			constexpr auto DIMS_POSE = gst::SE_TYPE::DOFs;
+			for (const auto& n : m_nodeIdx)
+			{
+				typename gst::Array_O exp_delta;
+				for (size_t i = 0; i < DIMS_POSE; i++)
+					exp_delta[i] = -d[n.second * DIMS_POSE + i];
+				graph.nodes[n.first] =
+					m_x0.at(n.first) + gst::SE_TYPE::exp(exp_delta);
+			}
+			m_updatesSinceBatch++;
+			info.num_free_nodes = nFree;
+			info.first_refactorized_block =
+				m_solver.lastFirstRefactorizedBlock();
+		}
+	}
+
+	if (doBatch) batchStep(graph, info);
+
+	if (out_info) *out_info = info;
+
+	MRPT_END
+}
+
+template <class GRAPH_T>
+void CIncrementalGraphOptimizer<GRAPH_T>::batchStep(
+	GRAPH_T& graph, TUpdateInfo& info)
+{
+	MRPT_START
+
+	info = TUpdateInfo();
+	info.batch_step = true;
+
+	const bool anyFreeNode = std::any_of(
+		graph.nodes.begin(), graph.nodes.end(),
+		[&](const auto& n) { return n.first != graph.root; });
+	if (!graph.edges.empty() && anyFreeNode)
+	{
+		mrpt::containers::yaml params = options.batch_params;
+		params["linear_solver"] = "supernodal";
+		TResultInfoSpaLevMarq levmarq_info;
+		optimize_graph_spa_levmarq(graph, levmarq_info, nullptr, params);
+	}
+
+	// Relinearize everything at the new estimate:
+	m_nodeIdx.clear();
+	m_x0.clear();
+	m_edges.clear();
+	m_numEdges = 0;
+	m_root = graph.root;
+	m_H.clear(0, gst::SE_TYPE::DOFs);
+	m_g.resize(0);
+	addNewNodes(graph);
+	m_H.growTo(m_nodeIdx.size());
+	m_g.resize(m_nodeIdx.size() * m_H.blockSize, true /*zero new elements*/);
+	for (const auto& e : graph.edges) linearizeEdge(graph, e);
+
+	// Factorize with a new ordering, so the next updates are incremental:
+	m_solver.reset();
+	if (!m_nodeIdx.empty())
+	{
+		try
+		{
+			m_solver.factorize(m_H, options.lambda);
+		}
+		catch (const mrpt::math::CExceptionNotDefPos&)
+		{
+			// The next update() will try again.
+		}
+	}
+
+	info.num_free_nodes = m_nodeIdx.size();
+	info.num_new_edges = m_numEdges;
+	m_updatesSinceBatch = 0;
+
+	MRPT_END
+}
+
+template <class GRAPH_T>
+void CIncrementalGraphOptimizer<GRAPH_T>::addNewNodes(const GRAPH_T& graph)
+{
+	for (const auto& n : graph.nodes)
+	{
+		if (n.first == graph.root || m_nodeIdx.count(n.first)) continue;
+		const size_t idx = m_nodeIdx.size();
+		m_nodeIdx[n.first] = idx;
+		m_x0[n.first] = n.second;
+	}
+}
+
+template <class GRAPH_T>
+bool CIncrementalGraphOptimizer<GRAPH_T>::findNewEdges(
+	const GRAPH_T& graph, std::vector<const edge_entry_t*>& newEdges) const
+{
+	// Edges between the same nodes keep their relative order in the
+	// multimap, so the known ones must come first, with the same values:
+	size_t nKnown = 0;
+	for (auto it = graph.edges.begin(); it != graph.edges.end();)
+	{
+		const auto itKnown = m_edges.find(it->first);
+		const auto range = graph.edges.equal_range(it->first);
+		size_t k = 0;
+		for (it = range.first; it != range.second; ++it, ++k)
+		{
+			if (itKnown == m_edges.end() || k >= itKnown->second.size())
+				newEdges.push_back(&*it);
+			else if (!(pose_t(it->second.getPoseMean()) ==
+					   itKnown->second[k]))
+				return false;
+			else
+				nKnown++;
+		}
+	}
+	return nKnown == m_numEdges;
+}
+
+template <class GRAPH_T>
+void CIncrementalGraphOptimizer<GRAPH_T>::linearizeEdge(
+	const GRAPH_T& graph, const edge_entry_t& edge)
+{
+	MRPT_START
+
+	constexpr auto DIMS_POSE = gst::SE_TYPE::DOFs;
+	using aux = detail::AuxErrorEval<typename gst::edge_t, gst>;
+
+	// Linearization point of both ends (the root is fixed):
+	m_edges[edge.first].emplace_back(edge.second.getPoseMean());
+	m_numEdges++;
+
+	const auto id1 = edge.first.first, id2 = edge.first.second;
+	const auto itIdx1 = m_nodeIdx.find(id1), itIdx2 = m_nodeIdx.find(id2);
+	const bool free1 = itIdx1 != m_nodeIdx.end();
+	const bool free2 = itIdx2 != m_nodeIdx.end();
+	if (!free1 && !free2) return;
+
+	pose_t P1 = free1 ? m_x0.at(id1) : pose_t(graph.nodes.at(id1));
+	pose_t P2 = free2 ? m_x0.at(id2) : pose_t(graph.nodes.at(id2));
+
+	std::vector<typename gst::observation_info_t> obs(1);
+	obs[0].edge = &edge;
+	obs[0].edge_mean = &edge.second.getPoseMean();
+	obs[0].P1 = &P1;
+	obs[0].P2 = &P2;
+
+	std::vector<typename gst::TPairJacobs> jacobs;
+	std::vector<typename gst::Array_O> errs;
+	computeJacobiansAndErrors<GRAPH_T>(graph, obs, jacobs, errs);
+	const auto& J1 = jacobs[0].first;
+	const auto& J2 = jacobs[0].second;
+
+	typename gst::matrix_TxT JtJ(mrpt::math::UNINITIALIZED_MATRIX);
+	if (free1)
+	{
+		aux::multiplyJtLambdaJ(J1, JtJ, &edge);
+		m_H.addBlock(itIdx1->second, itIdx1->second, JtJ);
+		typename gst::Array_O g;
+		g.setZero();
+		aux::multiply_Jt_W_err(J1, &edge, errs[0], g);
+		for (size_t i = 0; i < DIMS_POSE; i++)
+			m_g[itIdx1->second * DIMS_POSE + i] += g[i];
+	}
+	if (free2)
+	{
+		aux::multiplyJtLambdaJ(J2, JtJ, &edge);
+		m_H.addBlock(itIdx2->second, itIdx2->second, JtJ);
+		typename gst::Array_O g;
+		g.setZero();
+		aux::multiply_Jt_W_err(J2, &edge, errs[0], g);
+		for (size_t i = 0; i < DIMS_POSE; i++)
+			m_g[itIdx2->second * DIMS_POSE + i] += g[i];
+	}
+	if (free1 && free2)
+	{
+		aux::multiplyJ1tLambdaJ2(J1, J2, JtJ, &edge);
+		m_H.addBlock(itIdx1->second, itIdx2->second, JtJ);
+	}
+
+	MRPT_END
+}
+
+}  // namespace mrpt::graphslam
@@ -0,0 +1,265 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2020, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <mrpt/math/CSparseMatrix.h>
+#include <mrpt/math/CVectorDynamic.h>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace mrpt::graphslam
+{
+/** \addtogroup mrpt_graphslam_grp
+ *  @{ */
+
+/** A symmetric, square sparse matrix made of dense BxB blocks, of which only
+ * the upper triangular part (block row <= block column) is stored.
+ *
+ * This is the natural representation of the Hessian of pose-graph problems,
+ * where each block corresponds to the pair of nodes of one constraint.
+ * Diagonal blocks must be stored in full (both halves).
+ *
+ * \sa CSparseCholeskySolver
+ * \note (New in MRPT 2.1.0)
+ */
+struct TBlockSparseMatrix
+{
+	/** Size of each (square) block */
+	size_t blockSize{0};
+	/** For each block column j: sorted list of (row i<=j, offset in values) */
+	std::vector<std::vector<std::pair<size_t, size_t>>> cols;
+	/** Block contents, each one stored as BxB consecutive values in
+	 * column-major order */
+	std::vector<double> values;
+
+	/** Empties the matrix and sets its size to nBlocks x nBlocks blocks */
+	void clear(size_t nBlocks, size_t B);
+	/** Enlarges the matrix to nBlocks x nBlocks blocks, keeping all existing
+	 * contents. */
+	void growTo(size_t nBlocks);
+	/** Number of block rows (or columns) */
+	size_t blockCount() const { return cols.size(); }
+	/** Total number of stored blocks */
+	size_t nonZeroBlockCount() const { return values.size() / square_B(); }
+
+	/** Returns a pointer to the block (i,j), i<=j, inserting it filled with
+	 * zeros if it did not exist yet. */
+	double* block(size_t i, size_t j);
+	/** Returns a pointer to the block (i,j), i<=j, or nullptr if it does not
+	 * exist. */
+	const double* findBlock(size_t i, size_t j) const;
+
+	/** Adds the BxB matrix \a m to the block (i,j), or its transpose to block
+	 * (j,i) if i>j, so only the upper triangular part is ever touched. */
+	template <class MATRIX>
+	void addBlock(size_t i, size_t j, const MATRIX& m)
+	{
+		const bool transposed = i > j;
+		double* b = transposed ? block(j, i) : block(i, j);
+		for (size_t c = 0; c < blockSize; c++)
+			for (size_t r = 0; r < blockSize; r++)
+				b[r + c * blockSize] += transposed ? m(c, r) : m(r, c);
+	}
+
+	/** Returns true if both matrices have exactly the same blocks, and they
+	 * are stored in the same order (i.e. the same \a cols). */
+	bool hasSamePatternAs(const TBlockSparseMatrix& o) const
+	{
+		return blockSize == o.blockSize && cols == o.cols;
+	}
+
+   private:
+	size_t square_B() const { return blockSize ? blockSize * blockSize : 1; }
+};
+
+/** Virtual base for sparse Cholesky solvers of symmetric, positive-definite
+ * block-sparse linear systems `(H + lambda I) x = b`.
+ *
+ * Implementations may keep any data from former calls to factorize() (e.g.
+ * the fill-reducing ordering or the symbolic analysis) and reuse it if the
+ * sparsity pattern of H does not change, as it is the case along the
+ * iterations of nonlinear least-squares solvers.
+ *
+ * Use Create() to instantiate a solver by name.
+ *
+ * \sa optimize_graph_spa_levmarq, CSparseCholeskySolverSimplicial,
+ * CSparseCholeskySolverSupernodal
+ * \note (New in MRPT 2.1.0)
+ */
+class CSparseCholeskySolver
+{
+   public:
+	using Ptr = std::shared_ptr<CSparseCholeskySolver>;
+
+	CSparseCholeskySolver() = default;
+	virtual ~CSparseCholeskySolver();
+
+	/** Computes the Cholesky factorization of (H + lambda I).
+	 * \exception mrpt::math::CExceptionNotDefPos If the matrix is not
+	 * positive definite.
+	 */
+	virtual void factorize(const TBlockSparseMatrix& H, double lambda = 0) = 0;
+
+	/** Solves the system for a given right hand vector, using the last
+	 * successful factorization. */
+	virtual void solve(
+		const mrpt::math::CVectorDouble& b,
+		mrpt::math::CVectorDouble& x) const = 0;
+
+	/** Discards all cached data (symbolic analysis, factorization). */
+	virtual void reset() = 0;
+
+	/** Number of symbolic analyses (orderings, elimination trees) computed
+	 * since creation */
+	size_t symbolicAnalysisCount() const { return m_symbolicCount; }
+	/** Number of numeric factorizations computed since creation */
+	size_t numericFactorizationCount() const { return m_numericCount; }
+
+	/** Creates a solver by name: "simplicial" (CSparseCholeskySolverSimplicial)
+	 * or "supernodal" (CSparseCholeskySolverSupernodal).
+	 * \exception std::exception If the name is not recognized. */
+	static Ptr Create(const std::string& name);
+
+   protected:
+	size_t m_symbolicCount{0}, m_numericCount{0};
+};
+
+/** Sparse Cholesky solver based on the scalar (simplicial) left-looking
+ * factorization of the bundled CSparse library, via
+ * mrpt::math::CSparseMatrix::CholeskyDecomp.
+ *
+ * The symbolic analysis is reused as long as the sparsity pattern of the
+ * input matrix does not change.
+ *
+ * \note (New in MRPT 2.1.0)
+ */
+class CSparseCholeskySolverSimplicial : public CSparseCholeskySolver
+{
+   public:
+	CSparseCholeskySolverSimplicial() = default;
+	~CSparseCholeskySolverSimplicial() override;
+
+	void factorize(const TBlockSparseMatrix& H, double lambda = 0) override;
+	void solve(
+		const mrpt::math::CVectorDouble& b,
+		mrpt::math::CVectorDouble& x) const override;
+	void reset() override;
+
+   private:
+	/** The factorized matrix, which must outlive m_chol */
+	std::unique_ptr<mrpt::math::CSparseMatrix> m_H;
+	std::unique_ptr<mrpt::math::CSparseMatrix::CholeskyDecomp> m_chol;
+	/** Used to detect changes in the sparsity pattern */
+	std::vector<std::vector<std::pair<size_t, size_t>>> m_pattern;
+};
+
+/** Block-supernodal sparse Cholesky solver.
+ *
+ * The factorization works on whole dense blocks (one per pose in graph-SLAM
+ * problems) instead of scalar entries: the fill-reducing ordering (AMD) and
+ * the elimination tree are computed on the much smaller block graph, and all
+ * arithmetic is done with dense, fixed-size block kernels. The symbolic
+ * analysis is reused while the block sparsity pattern does not change.
+ *
+ * In the \a incremental mode (see TOptions) the solver is meant to be fed
+ * with a matrix which only grows (new blocks) or changes in a few blocks
+ * between calls, as it happens in online SLAM: the ordering of existing
+ * blocks is kept, new blocks are appended at the end, and only the columns
+ * of the factor which are affected by the changes are recomputed, much like
+ * in iSAM. See lastFirstRefactorizedBlock().
+ *
+ * \note (New in MRPT 2.1.0)
+ */
+class CSparseCholeskySolverSupernodal : public CSparseCholeskySolver
+{
+   public:
+	struct TOptions
+	{
+		/** Apply a fill-reducing AMD ordering (default: true) */
+		bool reorder{true};
+		/** Keep the existing ordering and factor columns when possible
+		 * (default: false) */
+		bool incremental{false};
+	};
+
+	CSparseCholeskySolverSupernodal() = default;
+	CSparseCholeskySolverSupernodal(const TOptions& opts) : options(opts) {}
+	~CSparseCholeskySolverSupernodal() override;
+
+	TOptions options;
+
+	void factorize(const TBlockSparseMatrix& H, double lambda = 0) override;
+	void solve(
+		const mrpt::math::CVectorDouble& b,
+		mrpt::math::CVectorDouble& x) const override;
+	void reset() override;
+
+	/** Index (in elimination order) of the first block column of the factor
+	 * which was recomputed in the last call to factorize(). It is 0 for full
+	 * factorizations, and larger for partial ones in incremental mode. */
+	size_t lastFirstRefactorizedBlock() const { return m_lastFirstColumn; }
+	/** Number of block columns in the last factorization */
+	size_t blockCount() const { return m_perm.size(); }
+	/** Number of non-zero blocks in the lower triangle of the factor L */
+	size_t factorNonZeroBlockCount() const;
+
+   private:
+	/** One entry of the permuted input matrix, lower triangle */
+	struct TInputEntry
+	{
+		size_t row, offset;
+		bool transposed;
+	};
+	/** One entry of the row pattern of L: column and index in m_colPattern */
+	struct TRowEntry
+	{
+		size_t col, idx;
+	};
+
+	size_t m_B{0};
+	/** m_perm[k]: original block at position k; m_iperm: its inverse */
+	std::vector<size_t> m_perm, m_iperm;
+	/** Permuted input entries, per column */
+	std::vector<std::vector<TInputEntry>> m_input;
+	/** Elimination tree parent of each column (or size_t(-1) for roots) */
+	std::vector<size_t> m_parent;
+	/** For each column: the sorted rows of the strictly lower part of L */
+	std::vector<std::vector<size_t>> m_colPattern;
+	/** For each row: the columns with non-zero blocks of the strictly lower
+	 * part of L */
+	std::vector<std::vector<TRowEntry>> m_rowPattern;
+	/** For each column c: the diagonal block L(c,c) followed by the blocks of
+	 * m_colPattern[c], each as BxB column-major values */
+	std::vector<std::vector<double>> m_L;
+
+	/** The pattern of the last input matrix, used to detect changes, and its
+	 * values only in incremental mode (see m_lastHasValues) */
+	TBlockSparseMatrix m_lastH;
+	bool m_lastHasValues{false};
+	double m_lastLambda{0};
+	bool m_valid{false};
+	size_t m_lastFirstColumn{0};
+
+	void computeOrdering(const TBlockSparseMatrix& H);
+	void buildInput(const TBlockSparseMatrix& H);
+	/** Elimination tree and pattern of L for the columns >= firstCol.
+	 * Returns the first column which must be numerically refactorized. */
+	size_t symbolic(size_t firstCol);
+	void numeric(const TBlockSparseMatrix& H, double lambda, size_t firstCol);
+	/** Returns the first column (in elimination order) whose input entries
+	 * differ between H and m_lastH */
+	size_t firstChangedColumn(const TBlockSparseMatrix& H) const;
+};
+
+/**  @} */  // end of grouping
+
+}  // namespace mrpt::graphslam
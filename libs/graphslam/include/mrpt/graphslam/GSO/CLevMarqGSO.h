@@ -17,6 +17,7 @@
 #include <mrpt/poses/CPose2D.h>
 #include <mrpt/poses/CPose3D.h>
 
+#include <mrpt/graphslam/CIncrementalGraphOptimizer.h>
 #include <mrpt/graphslam/interfaces/CGraphSlamOptimizer.h>
 #include <mrpt/graphslam/levmarq.h>
 
@@ -100,6 +101,38 @@ namespace mrpt::graphslam::optimizers
  *  + \a Required      : FALSE
  *  + \a Description   : Refers to the Levenberg-Marquardt optimization.
  *
+ * - \b linear_solver
+ *  + \a Section       : OptimizerParameters
+ *  + \a Default value : simplicial
+ *  + \a Required      : FALSE
+ *  + \a Description   : Refers to the Levenberg-Marquardt optimization.
+ *  Sparse Cholesky solver: "simplicial" or "supernodal" (faster for large
+ *  graphs). See mrpt::graphslam::CSparseCholeskySolver.
+ *
+ * - \b num_threads
+ *  + \a Section       : OptimizerParameters
+ *  + \a Default value : 1
+ *  + \a Required      : FALSE
+ *  + \a Description   : Refers to the Levenberg-Marquardt optimization.
+ *  Number of threads used to build the linear system of each iteration
+ *  (0: all hardware cores).
+ *
+ * - \b incremental_optimization
+ *  + \a Section       : OptimizerParameters
+ *  + \a Default value : FALSE
+ *  + \a Required      : FALSE
+ *  + \a Description   : Instead of running Levenberg-Marquardt on (part of)
+ *  the graph after each new node, update the whole graph incrementally with
+ *  a mrpt::graphslam::CIncrementalGraphOptimizer. Loop closures are also
+ *  handled incrementally; \b optimization_distance is ignored.
+ *
+ * - \b incremental_relinearize_every
+ *  + \a Section       : OptimizerParameters
+ *  + \a Default value : 50
+ *  + \a Required      : FALSE
+ *  + \a Description   : In incremental mode, number of updates between
+ *  full batch optimizations (and relinearizations) of the graph.
+ *
  *  \note For a detailed description of the optimization parameters of the
  *  Levenberg-Marquardt scheme, refer to
  *
@@ -179,6 +212,12 @@ class CLevMarqGSO
 		// nodeID difference for an edge to be considered loop closure
 		int LC_min_nodeid_diff;
 
+		/**\brief Use the incremental optimizer instead of batch
+		 * Levenberg-Marquardt runs */
+		bool incremental_optimization{false};
+		/**\brief Updates between batch steps in incremental mode */
+		size_t incremental_relinearize_every{50};
+
 		// Map of TPairNodesID to their corresponding edge as recorded in the
 		// last update of the optimizer state
 		typename GRAPH_T::edges_map_t last_pair_nodes_to_edge;
@@ -386,6 +425,10 @@ class CLevMarqGSO
 
 	/**\brief Minimum number of nodes before we try optimizing the graph */
 	size_t m_min_nodes_for_optimization{3};
+
+	/**\brief Used if opt_params.incremental_optimization is set */
+	mrpt::graphslam::CIncrementalGraphOptimizer<GRAPH_T>
+		m_incremental_optimizer;
 };
 }  // namespace mrpt::graphslam::optimizers
 #include "CLevMarqGSO_impl.h"
@@ -107,6 +107,7 @@ void CLevMarqGSO<GRAPH_T>::notifyOfWindowEvents(
 
 		if (events_occurred.find(opt_params.keystroke_optimize_graph)->second)
 		{
+			m_incremental_optimizer.requestBatchStep();
 			this->_optimizeGraph(/*is_full_update=*/true);
 		}
 	}
@@ -407,6 +408,31 @@ void CLevMarqGSO<GRAPH_T>::_optimizeGraph(bool is_full_update /*=false*/)
 	mrpt::system::CTicTac optimization_timer;
 	optimization_timer.Tic();
 
+	if (opt_params.incremental_optimization)
+	{
+		// The whole graph is updated, and loop closures do not require a
+		// full batch optimization:
+		auto& opt = m_incremental_optimizer;
+		opt.options.relinearize_every =
+			opt_params.incremental_relinearize_every;
+		opt.options.batch_params = opt_params.cfg;
+
+		typename CIncrementalGraphOptimizer<GRAPH_T>::TUpdateInfo info;
+		opt.update(*(this->m_graph), &info);
+		m_just_fully_optimized_graph = info.batch_step;
+
+		this->logFmt(
+			mrpt::system::LVL_DEBUG,
+			"Incremental optimization took: %fs (batch step: %s, refactorized "
+			"blocks: %u/%u)",
+			optimization_timer.Tac(), info.batch_step ? "yes" : "no",
+			static_cast<unsigned>(
+				info.num_free_nodes - info.first_refactorized_block),
+			static_cast<unsigned>(info.num_free_nodes));
+		this->m_time_logger.leave("CLevMarqGSO::_optimizeGraph");
+		return;
+	}
+
 	// set of nodes for which the optimization procedure will take place
 	std::set<mrpt::graphs::TNodeID>* nodes_to_optimize;
 
@@ -720,6 +746,10 @@ void CLevMarqGSO<GRAPH_T>::OptimizationParams::dumpToTextStream(
 		<< (optimization_on_second_thread ? "TRUE" : "FALSE") << std::endl;
 	out << "Optimize nodes in distance     = " << optimization_distance << "\n";
 	out << "Min. node difference for LC    = " << LC_min_nodeid_diff << "\n";
+	out << "Incremental optimization       = "
+		<< (incremental_optimization ? "TRUE" : "FALSE") << std::endl;
+	out << "Incremental: relinearize every = " << incremental_relinearize_every
+		<< "\n";
 	// out << cfg.getAsString() << std::endl;
 	MRPT_END
 }
@@ -749,6 +779,14 @@ void CLevMarqGSO<GRAPH_T>::OptimizationParams::loadFromConfigFile(
 	cfg["scale_hessian"] =
 		source.read_double("Optimization", "scale_hessian", 0.2, false);
 	cfg["tau"] = source.read_double(section, "tau", 1e-3, false);
+	cfg["linear_solver"] =
+		source.read_string(section, "linear_solver", "simplicial", false);
+	cfg["num_threads"] = source.read_int(section, "num_threads", 1, false);
+
+	incremental_optimization =
+		source.read_bool(section, "incremental_optimization", false, false);
+	incremental_relinearize_every = source.read_uint64_t(
+		section, "incremental_relinearize_every", 50, false);
 
 	MRPT_END
 }
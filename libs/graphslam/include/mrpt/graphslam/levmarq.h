@@ -8,11 +8,12 @@
    +------------------------------------------------------------------------+ */
 #pragma once
 
-#include <mrpt/containers/stl_containers_utils.h>  // find_in_vector()
 #include <mrpt/containers/yaml.h>
+#include <mrpt/core/WorkerThreadsPool.h>
+#include <mrpt/graphslam/CSparseCholeskySolver.h>
 #include <mrpt/graphslam/types.h>
-#include <mrpt/math/CSparseMatrix.h>
 #include <mrpt/system/CTimeLogger.h>
+#include <algorithm>
 #include <map>
 #include <memory>
 
@@ -60,6 +61,13 @@ namespace mrpt::graphslam
  *		- "e2": (default=1e-6) Lev-marq algorithm iteration stopping criterion
  *#2:
  *|delta_incr| < e2*(x_norm+e2)
+ *		- "linear_solver": (default="simplicial") The sparse Cholesky solver
+ *used for each LM step, see CSparseCholeskySolver::Create(). Use
+ *"supernodal" for large graphs (New in MRPT 2.1.0).
+ *		- "num_threads": (default=1) Number of threads used to evaluate the
+ *errors and Jacobians of the constraints, and to build the gradient and the
+ *Hessian (0=all hardware cores). Results do not depend on this value (New in
+ *MRPT 2.1.0).
  *
  * \note The following graph types are supported:
  *mrpt::graphs::CNetworkOfPoses2D, mrpt::graphs::CNetworkOfPoses3D,
@@ -110,6 +118,10 @@ void optimize_graph_spa_levmarq(
 	const double tau = extra_params.getOrDefault<double>("tau", 1e-3);
 	const double e1 = extra_params.getOrDefault<double>("e1", 1e-6);
 	const double e2 = extra_params.getOrDefault<double>("e2", 1e-6);
+	const auto linear_solver = extra_params.getOrDefault<std::string>(
+		"linear_solver", "simplicial");
+	const unsigned int num_threads = mrpt::WorkerThreadsPool::clampNumThreads(
+		extra_params.getOrDefault<unsigned int>("num_threads", 1));
 
 	mrpt::system::CTimeLogger profiler(enable_profiler);
 	profiler.enter("optimize_graph_spa_levmarq (entire)");
@@ -193,17 +205,15 @@ void optimize_graph_spa_levmarq(
 	// problem:
 	const size_t nObservations = lstObservationData.size();
 	ASSERTDEB_GT_(nObservations, 0);
-	// Cholesky object, as a pointer to reuse it between iterations:
-
-	using SparseCholeskyDecompPtr =
-		std::unique_ptr<CSparseMatrix::CholeskyDecomp>;
-	SparseCholeskyDecompPtr ptrCh;
+	// Cholesky solver, reused between iterations since the sparsity pattern
+	// of H does not change:
+	const auto solver = CSparseCholeskySolver::Create(linear_solver);
 
 	// The list of Jacobians: for each constraint i->j,
 	//  we need the pair of Jacobians: { dh(xi,xj)_dxi, dh(xi,xj)_dxj },
 	//  which are "first" and "second" in each pair.
-	// Index of the map are the node IDs {i,j} for each contraint.
-	typename gst::map_pairIDs_pairJacobs_t lstJacobians;
+	// In the same order than lstObservationData.
+	std::vector<typename gst::TPairJacobs> lstJacobians;
 	// The vector of errors: err_k = SE(2/3)::pseudo_Ln( P_i * EDGE_ij *
 	// inv(P_j) )
 	// Separated vectors for each edge. i \in [0,nObservations-1], in
@@ -215,32 +225,43 @@ void optimize_graph_spa_levmarq(
 	// ===================================
 	profiler.enter("optimize_graph_spa_levmarq.Jacobians&err");
 	double total_sqr_err = computeJacobiansAndErrors<GRAPH_T>(
-		graph, lstObservationData, lstJacobians, errs);
+		graph, lstObservationData, lstJacobians, errs, num_threads);
 	profiler.leave("optimize_graph_spa_levmarq.Jacobians&err");
 
 	// Only once (since this will be static along iterations), build a quick
-	// look-up table with the
-	//  indices of the free nodes associated to the (first_id,second_id) of each
-	//  Jacobian pair:
+	// look-up table with the indices of the free nodes associated to the
+	// (first_id,second_id) of each constraint:
 	// ------------------------------------------------------------------------
 	vector<pair<size_t, size_t>> obsIdx2fnIdx;
 	// "relatedFreeNodeIndex" is in [0,nFreeNodes-1], or "-1" if that node
 	// is fixed, as defined by "nodes_to_optimize"
-	obsIdx2fnIdx.reserve(nObservations);
-	ASSERTDEB_(lstJacobians.size() == nObservations);
-	for (auto itJ = lstJacobians.begin(); itJ != lstJacobians.end(); ++itJ)
 	{
-		const TNodeID id1 = itJ->first.first;
-		const TNodeID id2 = itJ->first.second;
-		obsIdx2fnIdx.emplace_back(
-			mrpt::containers::find_in_vector(id1, *nodes_to_optimize),
-			mrpt::containers::find_in_vector(id2, *nodes_to_optimize));
+		std::map<TNodeID, size_t> freeNodeIdx;
+		for (const TNodeID id : *nodes_to_optimize)
+			freeNodeIdx.emplace_hint(
+				freeNodeIdx.end(), id, freeNodeIdx.size());
+		auto fnIdx = [&](TNodeID id) {
+			const auto it = freeNodeIdx.find(id);
+			return it == freeNodeIdx.end() ? string::npos : it->second;
+		};
+		obsIdx2fnIdx.reserve(nObservations);
+		for (const auto& obs : lstObservationData)
+			obsIdx2fnIdx.emplace_back(
+				fnIdx(obs.edge->first.first), fnIdx(obs.edge->first.second));
 	}
 
+	// Also static: the blocks of the gradient and the Hessian to which each
+	// constraint contributes, and the sparsity pattern of the Hessian.
+	profiler.enter("optimize_graph_spa_levmarq.sp_H:pattern");
+	// The upper triangular part of the Hessian, in blocks:
+	TBlockSparseMatrix H;
+	detail::TSpaAssemblyPlan assemblyPlan;
+	assemblyPlan.build(obsIdx2fnIdx, nFreeNodes, DIMS_POSE, H);
+	profiler.leave("optimize_graph_spa_levmarq.sp_H:pattern");
+
 	// other important vars for the main loop:
 	CVectorDouble grad(nFreeNodes * DIMS_POSE);
 	grad.setZero();
-	using map_ID2matrix_TxT_t = std::map<TNodeID, typename gst::matrix_TxT>;
 
 	double lambda = initial_lambda;  // Will be actually set on first iteration.
 	double v = 1;  // was 2, changed since it's modified in the first pass.
@@ -255,7 +276,6 @@ void optimize_graph_spa_levmarq(
 
 	for (size_t iter = 0; iter < max_iters; ++iter)
 	{
-		vector<map_ID2matrix_TxT_t> H_map(nFreeNodes);
 		last_iter = iter;
 
 		// This will be false only when the delta leads to a worst solution and
@@ -273,58 +293,9 @@ void optimize_graph_spa_levmarq(
 			// block-column of J and the vector of errors "errs"
 			profiler.enter("optimize_graph_spa_levmarq.grad");
 
-			grad.setZero();
-
-			// "lstJacobians" is sorted in the same order than
-			// "lstObservationData":
-			ASSERTDEB_EQUAL_(lstJacobians.size(), lstObservationData.size());
-			{
-				size_t idx_obs;
-				typename gst::map_pairIDs_pairJacobs_t::const_iterator itJ;
-
-				for (idx_obs = 0, itJ = lstJacobians.begin();
-					 itJ != lstJacobians.end(); ++itJ, ++idx_obs)
-				{
-					// make sure they're in the expected order!
-					ASSERTDEB_(
-						itJ->first == lstObservationData[idx_obs].edge->first);
-
-					//  grad[k] += J^t_{i->k} * Inf.Matrix * errs_i
-					//    k: [0,nFreeNodes-1]     <-- IDs.first & IDs.second
-					//    i: [0,nObservations-1]  <--- idx_obs
-
-					// Get the corresponding indices in the vector of "free
-					// variables" being optimized:
-					const size_t idx1 = obsIdx2fnIdx[idx_obs].first;
-					const size_t idx2 = obsIdx2fnIdx[idx_obs].second;
-
-					if (idx1 != string::npos)
-					{
-						typename gst::Array_O grad_idx1;
-						detail::AuxErrorEval<typename gst::edge_t, gst>::
-							multiply_Jt_W_err(
-								itJ->second.first /* J */,
-								lstObservationData[idx_obs].edge /* W */,
-								errs[idx_obs] /* err */, grad_idx1 /* out */
-							);
-						for (unsigned int i = 0; i < DIMS_POSE; i++)
-							grad[DIMS_POSE * idx1 + i] += grad_idx1[i];
-					}
-
-					if (idx2 != string::npos)
-					{
-						typename gst::Array_O grad_idx2;
-						detail::AuxErrorEval<typename gst::edge_t, gst>::
-							multiply_Jt_W_err(
-								itJ->second.second /* J */,
-								lstObservationData[idx_obs].edge /* W */,
-								errs[idx_obs] /* err */, grad_idx2 /* out */
-							);
-						for (unsigned int i = 0; i < DIMS_POSE; i++)
-							grad[DIMS_POSE * idx2 + i] += grad_idx2[i];
-					}
-				}
-			}
+			detail::assembleGradient<gst>(
+				assemblyPlan, lstObservationData, lstJacobians, errs, grad,
+				num_threads);
 			profiler.leave("optimize_graph_spa_levmarq.grad");
 
 			// End condition #1
@@ -342,82 +313,17 @@ void optimize_graph_spa_levmarq(
 				break;
 			}
 
-			profiler.enter("optimize_graph_spa_levmarq.sp_H:build map");
+			profiler.enter("optimize_graph_spa_levmarq.sp_H:build");
 			// ======================================================================
-			// Build sparse representation of the upper triangular part of
-			//  the Hessian matrix H = J^t * J
-			//
-			// Sparse memory structure is a vector of maps, such as:
-			//  - H_map[i]: corresponds to the i'th column of H.
-			//              Here "i" corresponds to [0,N-1] indices of
-			//              appearance in the map "*nodes_to_optimize".
-			//  - H_map[i][j] is the entry for the j'th row, with "j" also in
-			//  the range [0,N-1] as ordered in "*nodes_to_optimize".
+			// Build the upper triangular part of the Hessian matrix
+			// H = J^t * J, which is kept for the next iterations if only
+			// lambda changes. Note: we only need to fill out the upper
+			// diagonal part, since Cholesky will later on ignore the other
+			// part.
 			// ======================================================================
-			{
-				size_t idxObs;
-				typename gst::map_pairIDs_pairJacobs_t::const_iterator
-					itJacobPair;
-
-				for (idxObs = 0, itJacobPair = lstJacobians.begin();
-					 idxObs < nObservations; ++itJacobPair, ++idxObs)
-				{
-					const bool Hij_upper_triang =
-						itJacobPair->first.first < itJacobPair->first.second;
-
-					// Indices in the "H_map" vector:
-					const size_t idx_i = obsIdx2fnIdx[idxObs].first;
-					const size_t idx_j = obsIdx2fnIdx[idxObs].second;
-
-					const bool is_i_free_node = idx_i != string::npos;
-					const bool is_j_free_node = idx_j != string::npos;
-
-					// Take references to both Jacobians (wrt pose "i" and pose
-					// "j"), taking into account the possible
-					// switch in their order:
-					const typename gst::matrix_TxT& J1 =
-						itJacobPair->second.first;
-					const typename gst::matrix_TxT& J2 =
-						itJacobPair->second.second;
-
-					// Is "i" a free (to be optimized) node? -> Ji^t * Inf *  Ji
-					if (is_i_free_node)
-					{
-						typename gst::matrix_TxT JtJ(
-							mrpt::math::UNINITIALIZED_MATRIX);
-						detail::AuxErrorEval<typename gst::edge_t, gst>::
-							multiplyJtLambdaJ(
-								J1, JtJ, lstObservationData[idxObs].edge);
-						H_map[idx_i][idx_i] += JtJ;
-					}
-					// Is "j" a free (to be optimized) node? -> Jj^t * Inf *  Jj
-					if (is_j_free_node)
-					{
-						typename gst::matrix_TxT JtJ(
-							mrpt::math::UNINITIALIZED_MATRIX);
-						detail::AuxErrorEval<typename gst::edge_t, gst>::
-							multiplyJtLambdaJ(
-								J2, JtJ, lstObservationData[idxObs].edge);
-						H_map[idx_j][idx_j] += JtJ;
-					}
-					// Are both "i" and "j" free nodes? -> Ji^t * Inf *  Jj
-					if (is_i_free_node && is_j_free_node)
-					{
-						typename gst::matrix_TxT JtJ(
-							mrpt::math::UNINITIALIZED_MATRIX);
-						detail::AuxErrorEval<typename gst::edge_t, gst>::
-							multiplyJ1tLambdaJ2(
-								J1, J2, JtJ, lstObservationData[idxObs].edge);
-						// We sort IDs such as "i" < "j" and we can build just
-						// the upper triangular part of the Hessian:
-						if (Hij_upper_triang)  // H_map[col][row]
-							H_map[idx_j][idx_i] += JtJ;
-						else
-							H_map[idx_i][idx_j].sum_At(JtJ);
-					}
-				}
-			}
-			profiler.leave("optimize_graph_spa_levmarq.sp_H:build map");
+			detail::assembleHessian<gst>(
+				assemblyPlan, lstObservationData, lstJacobians, H, num_threads);
+			profiler.leave("optimize_graph_spa_levmarq.sp_H:build");
 
 			// Just in the first iteration, we need to calculate an estimate for
 			// the first value of "lamdba":
@@ -427,17 +333,13 @@ void optimize_graph_spa_levmarq(
 					"optimize_graph_spa_levmarq.lambda_init");  // ---\  .
 				double H_diagonal_max = 0;
 				for (size_t i = 0; i < nFreeNodes; i++)
-					for (auto it = H_map[i].begin(); it != H_map[i].end(); ++it)
-					{
-						const size_t j =
-							it->first;  // entry submatrix is for (i,j).
-						if (i == j)
-						{
-							for (size_t k = 0; k < DIMS_POSE; k++)
-								mrpt::keep_max(
-									H_diagonal_max, it->second(k, k));
-						}
-					}
+				{
+					const double* Hii = H.findBlock(i, i);
+					if (!Hii) continue;
+					for (size_t k = 0; k < DIMS_POSE; k++)
+						mrpt::keep_max(
+							H_diagonal_max, Hii[k + k * DIMS_POSE]);
+				}
 				lambda = tau * H_diagonal_max;
 
 				profiler.leave(
@@ -465,51 +367,7 @@ void optimize_graph_spa_levmarq(
 			functor_feedback(graph, iter, max_iters, total_sqr_err);
 		}
 
-		profiler.enter("optimize_graph_spa_levmarq.sp_H:build");
-		// Now, build the actual sparse matrix H:
-		// Note: we only need to fill out the upper diagonal part, since
-		// Cholesky will later on ignore the other part.
-		CSparseMatrix sp_H(nFreeNodes * DIMS_POSE, nFreeNodes * DIMS_POSE);
-		for (size_t i = 0; i < nFreeNodes; i++)
-		{
-			const size_t i_offset = i * DIMS_POSE;
-
-			for (auto it = H_map[i].begin(); it != H_map[i].end(); ++it)
-			{
-				const size_t j = it->first;  // entry submatrix is for (i,j).
-				const size_t j_offset = j * DIMS_POSE;
-
-				// For i==j (diagonal blocks), it's different, since we only
-				// need to insert their
-				// upper-diagonal half and also we have to add the lambda*I to
-				// the diagonal from the Lev-Marq. algorithm:
-				if (i == j)
-				{
-					for (size_t r = 0; r < DIMS_POSE; r++)
-					{
-						// c=r: add lambda from LM
-						sp_H.insert_entry_fast(
-							j_offset + r, i_offset + r,
-							it->second(r, r) + lambda);
-						// c>r:
-						for (size_t c = r + 1; c < DIMS_POSE; c++)
-						{
-							sp_H.insert_entry_fast(
-								j_offset + r, i_offset + c, it->second(r, c));
-						}
-					}
-				}
-				else
-				{
-					sp_H.insert_submatrix(j_offset, i_offset, it->second);
-				}
-			}
-		}  // end for each free node, build sp_H
-
-		sp_H.compressFromTriplet();
-		profiler.leave("optimize_graph_spa_levmarq.sp_H:build");
-
-		// Use the cparse Cholesky decomposition to efficiently solve:
+		// Use the sparse Cholesky decomposition to efficiently solve:
 		//   (H+\lambda*I) \delta = -J^t * (f(x)-z)
 		//          A         x   =  b         -->       x = A^{-1} * b
 		//
@@ -518,14 +376,11 @@ void optimize_graph_spa_levmarq(
 		try
 		{
 			profiler.enter("optimize_graph_spa_levmarq.sp_H:chol");
-			if (!ptrCh.get())
-				ptrCh = std::make_unique<CSparseMatrix::CholeskyDecomp>(sp_H);
-			else
-				ptrCh.get()->update(sp_H);
+			solver->factorize(H, lambda);
 			profiler.leave("optimize_graph_spa_levmarq.sp_H:chol");
 
 			profiler.enter("optimize_graph_spa_levmarq.sp_H:backsub");
-			ptrCh->backsub(grad, delta);
+			solver->solve(grad, delta);
 			profiler.leave("optimize_graph_spa_levmarq.sp_H:backsub");
 		}
 		catch (CExceptionNotDefPos&)
@@ -612,12 +467,13 @@ void optimize_graph_spa_levmarq(
 			// =============================================================
 			// Compute Jacobians & errors with the new "graph.nodes" info:
 			// =============================================================
-			typename gst::map_pairIDs_pairJacobs_t new_lstJacobians;
+			std::vector<typename gst::TPairJacobs> new_lstJacobians;
 			std::vector<typename gst::Array_O> new_errs;
 
 			profiler.enter("optimize_graph_spa_levmarq.Jacobians&err");
 			double new_total_sqr_err = computeJacobiansAndErrors<GRAPH_T>(
-				graph, lstObservationData, new_lstJacobians, new_errs);
+				graph, lstObservationData, new_lstJacobians, new_errs,
+				num_threads);
 			profiler.leave("optimize_graph_spa_levmarq.Jacobians&err");
 
 			// Now, to decide whether to accept the change:
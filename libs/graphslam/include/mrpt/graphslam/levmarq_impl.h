@@ -8,7 +8,10 @@
    +------------------------------------------------------------------------+ */
 #pragma once
 
+#include <mrpt/core/WorkerThreadsPool.h>
 #include <Eigen/Dense>
+#include <algorithm>
+#include <tuple>
 #include <vector>
 
 namespace mrpt
@@ -144,6 +147,239 @@ struct AuxErrorEval<CPose3DPDFGaussianInf, gst>
 	}
 };
 
+// Computes the Jacobians and the error vector of one constraint.
+template <class gst>
+inline void computeJacobianAndError(
+	const typename gst::observation_info_t& obs,
+	typename gst::TPairJacobs& jacobs, typename gst::Array_O& err)
+{
+	const auto& EDGE_POSE = *obs.edge_mean;
+	const auto& P1 = *obs.P1;
+	const auto& P2 = *obs.P2;
+
+	// Compute the residual pose error of these pair of nodes + its
+	// constraint:
+	// DinvP1invP2 = inv(EDGE) * inv(P1) * P2 = (P2 \ominus P1) \ominus EDGE
+	const typename gst::graph_t::constraint_t::type_value DinvP1invP2 =
+		(P2 - P1) - EDGE_POSE;
+	err = gst::SE_TYPE::log(DinvP1invP2);
+
+	// Compute the jacobians:
+	gst::SE_TYPE::jacob_dDinvP1invP2_de1e2(
+		-EDGE_POSE, P1, P2, jacobs.first, jacobs.second);
+}
+
+// Runs f(first,last) over blocks of [0,n), one per thread, in the shared
+// pool, or in the calling thread if numThreads==1 or there is too little
+// work for it.
+template <class F>
+inline void levmarqParallelFor(
+	unsigned int numThreads, size_t n, size_t minPerBlock, F&& f)
+{
+	if (numThreads <= 1 || n < 2 * minPerBlock)
+	{
+		f(size_t(0), n);
+		return;
+	}
+	const size_t grain =
+		std::max(minPerBlock, (n + numThreads - 1) / numThreads);
+	mrpt::WorkerThreadsPool::sharedPool().parallel_for(0, n, f, grain);
+}
+
+// Which blocks of the gradient and the Hessian each constraint contributes
+// to. Since it does not change along the LM iterations, it is built once, and
+// then each block is computed by gathering its own terms (in the order of
+// the constraints), so blocks can be assembled in parallel without any
+// synchronization, and the result does not depend on the number of threads.
+struct TSpaAssemblyPlan
+{
+	// Kinds of Hessian terms of one constraint i->j:
+	enum : size_t
+	{
+		J1t_J1 = 0,  // Ji^t * Inf * Ji
+		J2t_J2 = 1,  // Jj^t * Inf * Jj
+		J1t_J2 = 2,  // Ji^t * Inf * Jj
+		J1t_J2_transp = 3  // (Ji^t * Inf * Jj)^t
+	};
+
+	// Terms of the free node k of the gradient are
+	// gradTerms[gradStart[k]:gradStart[k+1]], each one encoded as
+	// 2*idx_obs+(0:Ji, 1:Jj)
+	std::vector<size_t> gradStart, gradTerms;
+	// Terms of the b'th block of H (in the order of H.values) are
+	// blockTerms[blockStart[b]:blockStart[b+1]], encoded as 4*idx_obs+kind
+	std::vector<size_t> blockStart, blockTerms;
+
+	// Builds the plan and the sparsity pattern of H, from the indices of the
+	// free nodes (or std::string::npos if fixed) of each constraint.
+	void build(
+		const std::vector<std::pair<size_t, size_t>>& obsIdx2fnIdx,
+		size_t nFreeNodes, size_t DIMS_POSE, TBlockSparseMatrix& H)
+	{
+		using std::string;
+		// (node, term), and (col, row, term):
+		std::vector<std::pair<size_t, size_t>> gTerms;
+		std::vector<std::tuple<size_t, size_t, size_t>> hTerms;
+		for (size_t idx_obs = 0; idx_obs < obsIdx2fnIdx.size(); idx_obs++)
+		{
+			const size_t idx_i = obsIdx2fnIdx[idx_obs].first;
+			const size_t idx_j = obsIdx2fnIdx[idx_obs].second;
+			const bool is_i_free_node = idx_i != string::npos;
+			const bool is_j_free_node = idx_j != string::npos;
+			if (is_i_free_node)
+			{
+				gTerms.emplace_back(idx_i, 2 * idx_obs);
+				hTerms.emplace_back(idx_i, idx_i, 4 * idx_obs + J1t_J1);
+			}
+			if (is_j_free_node)
+			{
+				gTerms.emplace_back(idx_j, 2 * idx_obs + 1);
+				hTerms.emplace_back(idx_j, idx_j, 4 * idx_obs + J2t_J2);
+			}
+			// Only the upper triangular part of H is built:
+			if (is_i_free_node && is_j_free_node)
+			{
+				if (idx_i < idx_j)
+					hTerms.emplace_back(idx_j, idx_i, 4 * idx_obs + J1t_J2);
+				else
+					hTerms.emplace_back(
+						idx_i, idx_j, 4 * idx_obs + J1t_J2_transp);
+			}
+		}
+		// Stable: keep the order of constraints within each block
+		std::stable_sort(
+			gTerms.begin(), gTerms.end(),
+			[](const auto& a, const auto& b) { return a.first < b.first; });
+		std::stable_sort(
+			hTerms.begin(), hTerms.end(), [](const auto& a, const auto& b) {
+				return std::get<0>(a) < std::get<0>(b) ||
+					(std::get<0>(a) == std::get<0>(b) &&
+					 std::get<1>(a) < std::get<1>(b));
+			});
+
+		gradStart.assign(nFreeNodes + 1, 0);
+		gradTerms.resize(gTerms.size());
+		for (size_t k = 0; k < gTerms.size(); k++)
+		{
+			gradStart[gTerms[k].first + 1]++;
+			gradTerms[k] = gTerms[k].second;
+		}
+		for (size_t k = 0; k < nFreeNodes; k++)
+			gradStart[k + 1] += gradStart[k];
+
+		// Blocks are created in column-major order, so the b'th block is
+		// at H.values[b*DIMS_POSE^2]:
+		H.clear(nFreeNodes, DIMS_POSE);
+		blockStart.clear();
+		blockTerms.resize(hTerms.size());
+		for (size_t k = 0; k < hTerms.size(); k++)
+		{
+			const auto [col, row, term] = hTerms[k];
+			if (k == 0 || col != std::get<0>(hTerms[k - 1]) ||
+				row != std::get<1>(hTerms[k - 1]))
+			{
+				H.block(row, col);
+				blockStart.push_back(k);
+			}
+			blockTerms[k] = term;
+		}
+		blockStart.push_back(hTerms.size());
+	}
+
+	size_t blockCount() const { return blockStart.size() - 1; }
+};
+
+// grad = J^t * Inf * errs
+template <class gst>
+void assembleGradient(
+	const TSpaAssemblyPlan& plan,
+	const std::vector<typename gst::observation_info_t>& lstObservationData,
+	const std::vector<typename gst::TPairJacobs>& jacobs,
+	const std::vector<typename gst::Array_O>& errs,
+	mrpt::math::CVectorDouble& grad, unsigned int numThreads)
+{
+	constexpr auto DIMS_POSE = gst::SE_TYPE::DOFs;
+	const size_t nFreeNodes = plan.gradStart.size() - 1;
+	grad.resize(nFreeNodes * DIMS_POSE);
+
+	levmarqParallelFor(numThreads, nFreeNodes, 256, [&](size_t k0, size_t k1) {
+		for (size_t k = k0; k < k1; k++)
+		{
+			//  grad[k] += J^t_{i->k} * Inf.Matrix * errs_i
+			typename gst::Array_O grad_k;
+			for (size_t t = plan.gradStart[k]; t < plan.gradStart[k + 1]; t++)
+			{
+				const size_t idx_obs = plan.gradTerms[t] / 2;
+				const auto& J = (plan.gradTerms[t] % 2) == 0
+					? jacobs[idx_obs].first
+					: jacobs[idx_obs].second;
+				typename gst::Array_O grad_incr;
+				AuxErrorEval<typename gst::edge_t, gst>::multiply_Jt_W_err(
+					J, lstObservationData[idx_obs].edge /* W */,
+					errs[idx_obs] /* err */, grad_incr /* out */);
+				grad_k.asEigen() += grad_incr.asEigen();
+			}
+			for (size_t i = 0; i < DIMS_POSE; i++)
+				grad[DIMS_POSE * k + i] = grad_k[i];
+		}
+	});
+}
+
+// H = J^t * Inf * J, upper triangular part, with the pattern set in
+// TSpaAssemblyPlan::build()
+template <class gst>
+void assembleHessian(
+	const TSpaAssemblyPlan& plan,
+	const std::vector<typename gst::observation_info_t>& lstObservationData,
+	const std::vector<typename gst::TPairJacobs>& jacobs,
+	TBlockSparseMatrix& H, unsigned int numThreads)
+{
+	using aux = AuxErrorEval<typename gst::edge_t, gst>;
+	constexpr auto DIMS_POSE = gst::SE_TYPE::DOFs;
+	const size_t nBlocks = plan.blockCount();
+	ASSERTDEB_EQUAL_(H.values.size(), nBlocks * DIMS_POSE * DIMS_POSE);
+
+	levmarqParallelFor(numThreads, nBlocks, 256, [&](size_t b0, size_t b1) {
+		for (size_t b = b0; b < b1; b++)
+		{
+			typename gst::matrix_TxT H_b;
+			for (size_t t = plan.blockStart[b]; t < plan.blockStart[b + 1];
+				 t++)
+			{
+				const size_t idx_obs = plan.blockTerms[t] / 4;
+				const auto& J1 = jacobs[idx_obs].first;
+				const auto& J2 = jacobs[idx_obs].second;
+				const auto edge = lstObservationData[idx_obs].edge;
+
+				typename gst::matrix_TxT JtJ(mrpt::math::UNINITIALIZED_MATRIX);
+				switch (plan.blockTerms[t] % 4)
+				{
+					case TSpaAssemblyPlan::J1t_J1:
+						aux::multiplyJtLambdaJ(J1, JtJ, edge);
+						H_b += JtJ;
+						break;
+					case TSpaAssemblyPlan::J2t_J2:
+						aux::multiplyJtLambdaJ(J2, JtJ, edge);
+						H_b += JtJ;
+						break;
+					case TSpaAssemblyPlan::J1t_J2:
+						aux::multiplyJ1tLambdaJ2(J1, J2, JtJ, edge);
+						H_b += JtJ;
+						break;
+					default:
+						aux::multiplyJ1tLambdaJ2(J1, J2, JtJ, edge);
+						H_b.sum_At(JtJ);
+						break;
+				}
+			}
+			double* dst = &H.values[b * DIMS_POSE * DIMS_POSE];
+			for (size_t c = 0; c < DIMS_POSE; c++)
+				for (size_t r = 0; r < DIMS_POSE; r++)
+					dst[r + c * DIMS_POSE] = H_b(r, c);
+		}
+	});
+}
+
 }  // namespace detail
 
 // Compute, at once, jacobians and the error vectors for each constraint in
@@ -162,37 +398,17 @@ double computeJacobiansAndErrors(
 	errs.clear();
 
 	const size_t nObservations = lstObservationData.size();
+	errs.resize(nObservations);
 
 	for (size_t i = 0; i < nObservations; i++)
 	{
 		const typename gst::observation_info_t& obs = lstObservationData[i];
-		auto e = obs.edge;
-		const typename gst::graph_t::constraint_t::type_value* EDGE_POSE =
-			obs.edge_mean;
-		typename gst::graph_t::constraint_t::type_value* P1 = obs.P1;
-		typename gst::graph_t::constraint_t::type_value* P2 = obs.P2;
-
-		const auto& ids = e->first;
-		// const auto& edge = e->second;
-
-		// Compute the residual pose error of these pair of nodes + its
-		// constraint:
-		// DinvP1invP2 = inv(EDGE) * inv(P1) * P2 = (P2 \ominus P1) \ominus EDGE
-		typename gst::graph_t::constraint_t::type_value DinvP1invP2 =
-			((*P2) - (*P1)) - *EDGE_POSE;
-
-		// Add to vector of errors:
-		errs.resize(errs.size() + 1);
-		errs.back() = gst::SE_TYPE::log(DinvP1invP2);
-
-		// Compute the jacobians:
+
 		alignas(MRPT_MAX_STATIC_ALIGN_BYTES)
 			std::pair<mrpt::graphs::TPairNodeIDs, typename gst::TPairJacobs>
 				newMapEntry;
-		newMapEntry.first = ids;
-		gst::SE_TYPE::jacob_dDinvP1invP2_de1e2(
-			-(*EDGE_POSE), *P1, *P2, newMapEntry.second.first,
-			newMapEntry.second.second);
+		newMapEntry.first = obs.edge->first;
+		detail::computeJacobianAndError<gst>(obs, newMapEntry.second, errs[i]);
 
 		// And insert into map of jacobians:
 		lstJacobians.insert(lstJacobians.end(), newMapEntry);
@@ -207,5 +423,39 @@ double computeJacobiansAndErrors(
 	return ret_err;
 }
 
+/** \overload With the Jacobians in a vector, in the same order than
+ * "lstObservationData". If \a numThreads>1, constraints are evaluated in
+ * parallel in WorkerThreadsPool::sharedPool(). The result does not depend on
+ * the number of threads.
+ * \note (New in MRPT 2.1.0) */
+template <class GRAPH_T>
+double computeJacobiansAndErrors(
+	[[maybe_unused]] const GRAPH_T& graph,
+	const std::vector<typename graphslam_traits<GRAPH_T>::observation_info_t>&
+		lstObservationData,
+	std::vector<typename graphslam_traits<GRAPH_T>::TPairJacobs>& jacobs,
+	std::vector<typename graphslam_traits<GRAPH_T>::Array_O>& errs,
+	unsigned int numThreads = 1)
+{
+	using gst = graphslam_traits<GRAPH_T>;
+
+	const size_t nObservations = lstObservationData.size();
+	jacobs.resize(nObservations);
+	errs.resize(nObservations);
+
+	detail::levmarqParallelFor(
+		numThreads, nObservations, 512, [&](size_t i0, size_t i1) {
+			for (size_t i = i0; i < i1; i++)
+				detail::computeJacobianAndError<gst>(
+					lstObservationData[i], jacobs[i], errs[i]);
+		});
+
+	// Sequential sum, so the result is always the same:
+	double ret_err = 0.0;
+	for (size_t i = 0; i < errs.size(); i++)
+		ret_err += mrpt::square(errs[i].norm());
+	return ret_err;
+}
+
 }  // namespace graphslam
 }  // namespace mrpt
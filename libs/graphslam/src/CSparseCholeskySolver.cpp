@@ -0,0 +1,552 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2020, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include "graphslam-precomp.h"  // Precompiled headers
+
+#include <mrpt/core/exceptions.h>
+#include <mrpt/graphslam/CSparseCholeskySolver.h>
+
+#include <Eigen/Dense>
+#include <Eigen/OrderingMethods>
+#include <Eigen/SparseCore>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+using namespace mrpt::graphslam;
+using mrpt::math::CVectorDouble;
+
+static constexpr size_t INVALID_IDX = std::numeric_limits<size_t>::max();
+
+// ------------------------------------------------------
+//                   TBlockSparseMatrix
+// ------------------------------------------------------
+void TBlockSparseMatrix::clear(size_t nBlocks, size_t B)
+{
+	blockSize = B;
+	cols.assign(nBlocks, {});
+	values.clear();
+}
+
+void TBlockSparseMatrix::growTo(size_t nBlocks)
+{
+	if (nBlocks > cols.size()) cols.resize(nBlocks);
+}
+
+double* TBlockSparseMatrix::block(size_t i, size_t j)
+{
+	ASSERTDEB_(i <= j);
+	ASSERTDEB_(j < cols.size());
+	auto& col = cols[j];
+	// Most common case when building matrices: rows in ascending order.
+	auto it = col.end();
+	if (!col.empty() && col.back().first >= i)
+		it = std::lower_bound(
+			col.begin(), col.end(), std::make_pair(i, size_t(0)),
+			[](const auto& a, const auto& b) { return a.first < b.first; });
+	if (it != col.end() && it->first == i) return &values[it->second];
+
+	const size_t offset = values.size();
+	values.resize(offset + blockSize * blockSize, 0.0);
+	col.emplace(it, i, offset);
+	return &values[offset];
+}
+
+const double* TBlockSparseMatrix::findBlock(size_t i, size_t j) const
+{
+	if (j >= cols.size()) return nullptr;
+	const auto& col = cols[j];
+	auto it = std::lower_bound(
+		col.begin(), col.end(), std::make_pair(i, size_t(0)),
+		[](const auto& a, const auto& b) { return a.first < b.first; });
+	if (it == col.end() || it->first != i) return nullptr;
+	return &values[it->second];
+}
+
+// ------------------------------------------------------
+//                   CSparseCholeskySolver
+// ------------------------------------------------------
+CSparseCholeskySolver::~CSparseCholeskySolver() = default;
+
+CSparseCholeskySolver::Ptr CSparseCholeskySolver::Create(
+	const std::string& name)
+{
+	if (name == "simplicial")
+		return std::make_shared<CSparseCholeskySolverSimplicial>();
+	if (name == "supernodal")
+		return std::make_shared<CSparseCholeskySolverSupernodal>();
+	THROW_EXCEPTION_FMT(
+		"Unknown sparse Cholesky solver: '%s'. Valid values are: "
+		"'simplicial', 'supernodal'.",
+		name.c_str());
+}
+
+// ------------------------------------------------------
+//             CSparseCholeskySolverSimplicial
+// ------------------------------------------------------
+CSparseCholeskySolverSimplicial::~CSparseCholeskySolverSimplicial()
+{
+	// m_chol holds a pointer to m_H: destroy it first.
+	m_chol.reset();
+}
+
+void CSparseCholeskySolverSimplicial::factorize(
+	const TBlockSparseMatrix& H, double lambda)
+{
+	// Note: no MRPT_START/MRPT_END here, so CExceptionNotDefPos exceptions
+	// reach the caller with their original type.
+	const size_t B = H.blockSize, N = H.blockCount() * B;
+	ASSERT_(N > 0);
+
+	// Build the upper triangular part of (H + lambda*I), since Cholesky will
+	// ignore the other part anyway:
+	auto sp_H = std::make_unique<mrpt::math::CSparseMatrix>(N, N);
+	for (size_t j = 0; j < H.blockCount(); j++)
+	{
+		for (const auto& e : H.cols[j])
+		{
+			const size_t i = e.first;
+			const double* b = &H.values[e.second];
+			for (size_t c = 0; c < B; c++)
+			{
+				const size_t lastRow = (i == j) ? c : B - 1;
+				for (size_t r = 0; r <= lastRow; r++)
+					sp_H->insert_entry_fast(
+						i * B + r, j * B + c,
+						b[r + c * B] + ((i == j && r == c) ? lambda : 0));
+			}
+		}
+	}
+	sp_H->compressFromTriplet();
+
+	m_numericCount++;
+	if (m_chol && H.cols == m_pattern)
+	{
+		// Same structure: reuse the symbolic decomposition. Keep the former
+		// matrix alive until update() has replaced the reference to it.
+		m_H.swap(sp_H);
+		m_chol->update(*m_H);
+	}
+	else
+	{
+		m_chol.reset();
+		m_H = std::move(sp_H);
+		m_pattern = H.cols;
+		m_symbolicCount++;
+		m_chol =
+			std::make_unique<mrpt::math::CSparseMatrix::CholeskyDecomp>(*m_H);
+	}
+}
+
+void CSparseCholeskySolverSimplicial::solve(
+	const CVectorDouble& b, CVectorDouble& x) const
+{
+	ASSERTMSG_(m_chol, "factorize() must be called before solve()");
+	m_chol->backsub(b, x);
+}
+
+void CSparseCholeskySolverSimplicial::reset()
+{
+	m_chol.reset();
+	m_H.reset();
+	m_pattern.clear();
+}
+
+// ------------------------------------------------------
+//             CSparseCholeskySolverSupernodal
+// ------------------------------------------------------
+namespace
+{
+// Block kernels, with fixed sizes for 2D (B=3) and 3D (B=6) poses:
+template <int B>
+struct BlockKernels
+{
+	using Mat = Eigen::Matrix<double, B, B>;
+	using Vec = Eigen::Matrix<double, B, 1>;
+	using MapMat = Eigen::Map<Mat>;
+	using CMapMat = Eigen::Map<const Mat>;
+	using MapVec = Eigen::Map<Vec>;
+
+	// Left-looking factorization of the columns [firstCol, n-1] of L:
+	template <class INPUT, class COL_PATTERN, class ROW_PATTERN, class L_T>
+	static void factor(
+		const size_t bs, const INPUT& input, const COL_PATTERN& colPattern,
+		const ROW_PATTERN& rowPattern, L_T& L, const double* Hvalues,
+		const double lambda, const size_t firstCol)
+	{
+		const size_t n = colPattern.size(), BB = bs * bs;
+		const auto ibs = static_cast<Eigen::Index>(bs);
+
+		std::vector<size_t> pos(n, INVALID_IDX);
+		std::vector<double> X;
+
+		for (size_t c = firstCol; c < n; c++)
+		{
+			const auto& pat = colPattern[c];
+			// X: accumulator for the column c: diagonal block + pattern:
+			X.assign((1 + pat.size()) * BB, 0.0);
+			pos[c] = 0;
+			for (size_t q = 0; q < pat.size(); q++) pos[pat[q]] = q + 1;
+
+			// Scatter the input column:
+			for (const auto& e : input[c])
+			{
+				MapMat Xr(&X[pos[e.row] * BB], ibs, ibs);
+				CMapMat Hb(Hvalues + e.offset, ibs, ibs);
+				if (e.transposed)
+					Xr += Hb.transpose();
+				else
+					Xr += Hb;
+			}
+			for (size_t d = 0; d < bs; d++) X[d + d * bs] += lambda;
+
+			// Subtract the contributions of all former columns k with
+			// L(c,k)!=0:  X(r) -= L(r,k) * L(c,k)^T for all rows r>=c
+			for (const auto& re : rowPattern[c])
+			{
+				const auto& Lk = L[re.col];
+				const auto& patk = colPattern[re.col];
+				CMapMat Lck(&Lk[(1 + re.idx) * BB], ibs, ibs);
+				for (size_t q = re.idx; q < patk.size(); q++)
+				{
+					MapMat Xr(&X[pos[patk[q]] * BB], ibs, ibs);
+					Xr.noalias() -=
+						CMapMat(&Lk[(1 + q) * BB], ibs, ibs) * Lck.transpose();
+				}
+			}
+
+			// Diagonal block:
+			Eigen::LLT<Mat> llt(MapMat(&X[0], ibs, ibs));
+			if (llt.info() != Eigen::Success)
+				throw mrpt::math::CExceptionNotDefPos(
+					"CSparseCholeskySolverSupernodal: Not positive definite "
+					"matrix.");
+
+			// Off-diagonal blocks: L(r,c) = X(r) * L(c,c)^{-T}
+			auto& Lc = L[c];
+			Lc.resize(X.size());
+			MapMat(&Lc[0], ibs, ibs) = llt.matrixL();
+			for (size_t q = 0; q < pat.size(); q++)
+			{
+				MapMat Xr(&X[(1 + q) * BB], ibs, ibs);
+				llt.matrixU().template solveInPlace<Eigen::OnTheRight>(Xr);
+				MapMat(&Lc[(1 + q) * BB], ibs, ibs) = Xr;
+			}
+
+			pos[c] = INVALID_IDX;
+			for (size_t r : pat) pos[r] = INVALID_IDX;
+		}
+	}
+
+	// Solves L*L^T*y = y, in place:
+	template <class COL_PATTERN, class L_T>
+	static void solve(
+		const size_t bs, const COL_PATTERN& colPattern, const L_T& L,
+		std::vector<double>& y)
+	{
+		const size_t n = colPattern.size(), BB = bs * bs;
+		const auto ibs = static_cast<Eigen::Index>(bs);
+
+		// Forward substitution: L*z = y
+		for (size_t c = 0; c < n; c++)
+		{
+			const auto& Lc = L[c];
+			MapVec yc(&y[c * bs], ibs);
+			CMapMat(&Lc[0], ibs, ibs)
+				.template triangularView<Eigen::Lower>()
+				.solveInPlace(yc);
+			const auto& pat = colPattern[c];
+			for (size_t q = 0; q < pat.size(); q++)
+				MapVec(&y[pat[q] * bs], ibs).noalias() -=
+					CMapMat(&Lc[(1 + q) * BB], ibs, ibs) * yc;
+		}
+		// Backward substitution: L^T*y = z
+		for (size_t c = n; c-- > 0;)
+		{
+			const auto& Lc = L[c];
+			MapVec yc(&y[c * bs], ibs);
+			const auto& pat = colPattern[c];
+			for (size_t q = 0; q < pat.size(); q++)
+				yc.noalias() -=
+					CMapMat(&Lc[(1 + q) * BB], ibs, ibs).transpose() *
+					MapVec(&y[pat[q] * bs], ibs);
+			CMapMat(&Lc[0], ibs, ibs)
+				.transpose()
+				.template triangularView<Eigen::Upper>()
+				.solveInPlace(yc);
+		}
+	}
+};
+}  // namespace
+
+CSparseCholeskySolverSupernodal::~CSparseCholeskySolverSupernodal() = default;
+
+void CSparseCholeskySolverSupernodal::reset()
+{
+	m_B = 0;
+	m_perm.clear();
+	m_iperm.clear();
+	m_input.clear();
+	m_parent.clear();
+	m_colPattern.clear();
+	m_rowPattern.clear();
+	m_L.clear();
+	m_lastH = TBlockSparseMatrix();
+	m_lastHasValues = false;
+	m_lastLambda = 0;
+	m_valid = false;
+	m_lastFirstColumn = 0;
+}
+
+size_t CSparseCholeskySolverSupernodal::factorNonZeroBlockCount() const
+{
+	size_t nnz = 0;
+	for (const auto& p : m_colPattern) nnz += 1 + p.size();
+	return nnz;
+}
+
+void CSparseCholeskySolverSupernodal::factorize(
+	const TBlockSparseMatrix& H, double lambda)
+{
+	const size_t n = H.blockCount();
+	ASSERT_(n > 0);
+	ASSERT_(H.blockSize > 0);
+
+	const bool samePattern = !m_perm.empty() && H.hasSamePatternAs(m_lastH);
+	size_t firstCol = 0;
+
+	if (options.incremental && m_valid && m_lastHasValues &&
+		H.blockSize == m_B && n >= m_perm.size() && lambda == m_lastLambda)
+	{
+		// Keep the elimination order of existing blocks, append new ones:
+		for (size_t k = m_perm.size(); k < n; k++)
+		{
+			m_perm.push_back(k);
+			m_iperm.push_back(k);
+		}
+		firstCol = firstChangedColumn(H);
+		if (!samePattern)
+		{
+			buildInput(H);
+			firstCol = symbolic(firstCol);
+		}
+	}
+	else if (!samePattern)
+	{
+		m_B = H.blockSize;
+		computeOrdering(H);
+		buildInput(H);
+		symbolic(0);
+	}
+
+	m_valid = false;
+	m_lastFirstColumn = firstCol;
+	numeric(H, lambda, firstCol);
+	m_valid = true;
+
+	// Keep what the next call needs to detect changes, reusing the memory:
+	if (!samePattern)
+	{
+		m_lastH.blockSize = H.blockSize;
+		m_lastH.cols = H.cols;
+	}
+	m_lastHasValues = options.incremental;
+	if (m_lastHasValues)
+		m_lastH.values.assign(H.values.begin(), H.values.end());
+	else
+		m_lastH.values.clear();
+	m_lastLambda = lambda;
+}
+
+void CSparseCholeskySolverSupernodal::computeOrdering(
+	const TBlockSparseMatrix& H)
+{
+	const size_t n = H.blockCount();
+	m_perm.resize(n);
+	m_iperm.resize(n);
+
+	if (!options.reorder)
+	{
+		for (size_t k = 0; k < n; k++) m_perm[k] = m_iperm[k] = k;
+		return;
+	}
+
+	// AMD ordering of the block graph (much smaller than the scalar one):
+	std::vector<Eigen::Triplet<double, int>> triplets;
+	for (size_t j = 0; j < n; j++)
+		for (const auto& e : H.cols[j])
+			triplets.emplace_back(int(e.first), int(j), 1.0);
+	const auto nn = static_cast<int>(n);
+	Eigen::SparseMatrix<double, Eigen::ColMajor, int> pattern(nn, nn);
+	pattern.setFromTriplets(triplets.begin(), triplets.end());
+
+	Eigen::PermutationMatrix<Eigen::Dynamic, Eigen::Dynamic, int> P;
+	Eigen::AMDOrdering<int> amd;
+	amd(pattern.selfadjointView<Eigen::Upper>(), P);
+
+	// P.indices()[k] is the original index of the k-th eliminated block:
+	for (size_t k = 0; k < n; k++)
+	{
+		m_perm[k] = static_cast<size_t>(P.indices()[k]);
+		m_iperm[m_perm[k]] = k;
+	}
+}
+
+void CSparseCholeskySolverSupernodal::buildInput(const TBlockSparseMatrix& H)
+{
+	const size_t n = H.blockCount();
+	m_input.assign(n, {});
+	for (size_t j = 0; j < n; j++)
+	{
+		for (const auto& e : H.cols[j])
+		{
+			// H(i,j) is A(pi,pj) in the permuted matrix A=P*H*P^T, of which
+			// we keep the lower triangle only:
+			const size_t pi = m_iperm[e.first], pj = m_iperm[j];
+			if (pi >= pj)
+				m_input[pj].push_back({pi, e.second, false});
+			else
+				m_input[pi].push_back({pj, e.second, true});
+		}
+	}
+}
+
+size_t CSparseCholeskySolverSupernodal::symbolic(size_t firstCol)
+{
+	const size_t n = m_input.size(), BB = m_B * m_B;
+	m_symbolicCount++;
+
+	// Rows of the factor before firstCol are unaffected by changes in
+	// columns >= firstCol, so only their entries in later rows are dropped:
+	m_parent.resize(n, INVALID_IDX);
+	m_colPattern.resize(n);
+	m_rowPattern.resize(n);
+	m_L.resize(n);
+	for (size_t c = 0; c < std::min(firstCol, n); c++)
+	{
+		auto& pat = m_colPattern[c];
+		pat.erase(
+			std::lower_bound(pat.begin(), pat.end(), firstCol), pat.end());
+		if (m_parent[c] != INVALID_IDX && m_parent[c] >= firstCol)
+			m_parent[c] = INVALID_IDX;
+	}
+
+	// Rows of the lower triangle of the input matrix:
+	std::vector<std::vector<size_t>> inputRows(n);
+	for (size_t c = 0; c < n; c++)
+		for (const auto& e : m_input[c])
+			if (e.row != c && e.row >= firstCol) inputRows[e.row].push_back(c);
+
+	// Elimination tree and pattern of L, row by row (as in LDL by T. Davis):
+	std::vector<size_t> flag(n, INVALID_IDX);
+	for (size_t k = firstCol; k < n; k++)
+	{
+		m_parent[k] = INVALID_IDX;
+		m_rowPattern[k].clear();
+		m_colPattern[k].clear();
+		flag[k] = k;
+		for (size_t i : inputRows[k])
+		{
+			for (; flag[i] != k; i = m_parent[i])
+			{
+				if (m_parent[i] == INVALID_IDX) m_parent[i] = k;
+				m_rowPattern[k].push_back({i, m_colPattern[i].size()});
+				m_colPattern[i].push_back(k);
+				flag[i] = k;
+			}
+		}
+	}
+
+	// Since columns are only modified by their own rows, the kept ones must
+	// have their former size. Otherwise, refactorize everything:
+	for (size_t c = 0; c < firstCol; c++)
+		if (m_L[c].size() != (1 + m_colPattern[c].size()) * BB) return 0;
+	return firstCol;
+}
+
+size_t CSparseCholeskySolverSupernodal::firstChangedColumn(
+	const TBlockSparseMatrix& H) const
+{
+	const size_t n = H.blockCount(), BB = H.blockSize * H.blockSize;
+	size_t first = n;
+	for (size_t j = 0; j < n; j++)
+	{
+		for (const auto& e : H.cols[j])
+		{
+			const size_t c = std::min(m_iperm[e.first], m_iperm[j]);
+			if (c >= first) continue;
+			const double* old = m_lastH.findBlock(e.first, j);
+			if (!old ||
+				std::memcmp(old, &H.values[e.second], BB * sizeof(double)))
+				first = c;
+		}
+	}
+	// Removed blocks:
+	for (size_t j = 0; j < m_lastH.blockCount(); j++)
+		for (const auto& e : m_lastH.cols[j])
+			if (!H.findBlock(e.first, j))
+				first = std::min(first, std::min(m_iperm[e.first], m_iperm[j]));
+	return first;
+}
+
+void CSparseCholeskySolverSupernodal::numeric(
+	const TBlockSparseMatrix& H, double lambda, size_t firstCol)
+{
+	m_numericCount++;
+	const double* Hvalues = H.values.data();
+	switch (m_B)
+	{
+		case 3:
+			BlockKernels<3>::factor(
+				m_B, m_input, m_colPattern, m_rowPattern, m_L, Hvalues, lambda,
+				firstCol);
+			break;
+		case 6:
+			BlockKernels<6>::factor(
+				m_B, m_input, m_colPattern, m_rowPattern, m_L, Hvalues, lambda,
+				firstCol);
+			break;
+		default:
+			BlockKernels<Eigen::Dynamic>::factor(
+				m_B, m_input, m_colPattern, m_rowPattern, m_L, Hvalues, lambda,
+				firstCol);
+			break;
+	};
+}
+
+void CSparseCholeskySolverSupernodal::solve(
+	const CVectorDouble& b, CVectorDouble& x) const
+{
+	ASSERTMSG_(m_valid, "factorize() must be called before solve()");
+	const size_t n = m_perm.size(), B = m_B;
+	ASSERT_EQUAL_(static_cast<size_t>(b.size()), n * B);
+
+	// y = P*b
+	std::vector<double> y(n * B);
+	for (size_t k = 0; k < n; k++)
+		for (size_t d = 0; d < B; d++) y[k * B + d] = b[m_perm[k] * B + d];
+
+	switch (m_B)
+	{
+		case 3:
+			BlockKernels<3>::solve(m_B, m_colPattern, m_L, y);
+			break;
+		case 6:
+			BlockKernels<6>::solve(m_B, m_colPattern, m_L, y);
+			break;
+		default:
+			BlockKernels<Eigen::Dynamic>::solve(m_B, m_colPattern, m_L, y);
+			break;
+	};
+
+	// x = P^T*y
+	x.resize(n * B);
+	for (size_t k = 0; k < n; k++)
+		for (size_t d = 0; d < B; d++) x[m_perm[k] * B + d] = y[k * B + d];
+}
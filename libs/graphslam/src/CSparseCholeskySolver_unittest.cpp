@@ -0,0 +1,176 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2020, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include <gtest/gtest.h>
+#include <Eigen/Dense>
+#include <mrpt/graphslam/CSparseCholeskySolver.h>
+#include <mrpt/math/CMatrixDynamic.h>
+#include <mrpt/math/CVectorDynamic.h>
+#include <mrpt/math/ops_matrices.h>
+#include <mrpt/random.h>
+
+using namespace mrpt::graphslam;
+using mrpt::math::CMatrixDouble;
+using mrpt::math::CVectorDouble;
+
+// A random, positive-definite, block-banded matrix with some long-range
+// blocks, similar to the Hessian of a pose graph with loop closures:
+static void randomBlockMatrix(
+	TBlockSparseMatrix& H, size_t n, size_t B, size_t nLoops)
+{
+	auto& rng = mrpt::random::getRandomGenerator();
+	H.clear(n, B);
+	auto addEdge = [&](size_t i, size_t j) {
+		// Add J^t*J for a random J=[J1 J2]:
+		CMatrixDouble J1(B, B), J2(B, B);
+		rng.drawGaussian1DMatrix(J1);
+		rng.drawGaussian1DMatrix(J2);
+		H.addBlock(i, i, CMatrixDouble(J1.transpose() * J1.asEigen()));
+		H.addBlock(j, j, CMatrixDouble(J2.transpose() * J2.asEigen()));
+		H.addBlock(i, j, CMatrixDouble(J1.transpose() * J2.asEigen()));
+	};
+	for (size_t i = 0; i + 1 < n; i++) addEdge(i, i + 1);
+	for (size_t k = 0; k < nLoops; k++)
+	{
+		const size_t i = rng.drawUniform32bit() % n,
+					 j = rng.drawUniform32bit() % n;
+		if (i != j) addEdge(i, j);
+	}
+	// Fix the gauge freedom:
+	CMatrixDouble I(B, B);
+	I.setIdentity();
+	H.addBlock(0, 0, I);
+}
+
+static CMatrixDouble toDense(const TBlockSparseMatrix& H, double lambda)
+{
+	const size_t B = H.blockSize, N = H.blockCount() * B;
+	CMatrixDouble D(N, N);
+	D.setZero();
+	for (size_t j = 0; j < H.blockCount(); j++)
+		for (const auto& e : H.cols[j])
+			for (size_t c = 0; c < B; c++)
+				for (size_t r = 0; r < B; r++)
+				{
+					const double v = H.values[e.second + r + c * B];
+					D(e.first * B + r, j * B + c) = v;
+					D(j * B + c, e.first * B + r) = v;
+				}
+	for (size_t i = 0; i < N; i++) D(i, i) += lambda;
+	return D;
+}
+
+static void checkSolution(
+	const TBlockSparseMatrix& H, double lambda, const CSparseCholeskySolver& s)
+{
+	const auto D = toDense(H, lambda);
+	CVectorDouble b(D.rows());
+	mrpt::random::getRandomGenerator().drawGaussian1DVector(b);
+	CVectorDouble x;
+	s.solve(b, x);
+	ASSERT_EQ(x.size(), b.size());
+	const CVectorDouble r = CVectorDouble(D.asEigen() * x.asEigen()) - b;
+	EXPECT_LT(r.norm(), 1e-8 * (1 + b.norm()));
+}
+
+TEST(CSparseCholeskySolver, simplicialAndSupernodal)
+{
+	mrpt::random::getRandomGenerator().randomize(123);
+	for (const size_t B : {3, 6, 2})
+	{
+		TBlockSparseMatrix H;
+		randomBlockMatrix(H, 40, B, 10);
+		for (const char* name : {"simplicial", "supernodal"})
+		{
+			auto s = CSparseCholeskySolver::Create(name);
+			s->factorize(H, 1e-3);
+			checkSolution(H, 1e-3, *s);
+			// Same pattern: the symbolic analysis is reused:
+			s->factorize(H, 1.0);
+			checkSolution(H, 1.0, *s);
+			EXPECT_EQ(s->symbolicAnalysisCount(), 1U) << name;
+			EXPECT_EQ(s->numericFactorizationCount(), 2U) << name;
+		}
+	}
+	EXPECT_ANY_THROW(CSparseCholeskySolver::Create("foo"));
+}
+
+TEST(CSparseCholeskySolver, notDefinitePositive)
+{
+	TBlockSparseMatrix H;
+	H.clear(2, 3);
+	CMatrixDouble M(3, 3);
+	M.setIdentity();
+	H.addBlock(0, 0, M);
+	M *= -1.0;
+	H.addBlock(1, 1, M);
+	CSparseCholeskySolverSupernodal s;
+	EXPECT_THROW(s.factorize(H), mrpt::math::CExceptionNotDefPos);
+	H.addBlock(1, 1, CMatrixDouble(M.asEigen() * -2.0));
+	EXPECT_NO_THROW(s.factorize(H));
+}
+
+TEST(CSparseCholeskySolver, incrementalSupernodal)
+{
+	mrpt::random::getRandomGenerator().randomize(456);
+	const size_t B = 3, n = 60;
+
+	TBlockSparseMatrix H;
+	randomBlockMatrix(H, n, B, 8);
+
+	CSparseCholeskySolverSupernodal::TOptions opts;
+	opts.incremental = true;
+	CSparseCholeskySolverSupernodal s(opts);
+	s.factorize(H);
+	EXPECT_EQ(s.lastFirstRefactorizedBlock(), 0U);
+	checkSolution(H, 0, s);
+
+	// Append new "poses", connected to the last one, as in online SLAM:
+	CMatrixDouble I(B, B);
+	I.setIdentity();
+	for (size_t k = 0; k < 5; k++)
+	{
+		const size_t last = H.blockCount() - 1;
+		H.growTo(last + 2);
+		H.addBlock(last, last, I);
+		H.addBlock(last + 1, last + 1, I);
+		H.addBlock(last, last + 1, CMatrixDouble(I.asEigen() * -0.5));
+		s.factorize(H);
+
+		// Only the columns of the factor from the modified one on, since
+		// appended blocks are eliminated last:
+		if (k > 0)
+		{
+			EXPECT_EQ(s.lastFirstRefactorizedBlock(), last);
+		}
+		EXPECT_EQ(s.blockCount(), H.blockCount());
+		checkSolution(H, 0, s);
+	}
+
+	// No changes at all:
+	s.factorize(H);
+	EXPECT_EQ(s.lastFirstRefactorizedBlock(), H.blockCount());
+	checkSolution(H, 0, s);
+
+	// A "loop closure" between the first and the last poses:
+	H.addBlock(0, H.blockCount() - 1, CMatrixDouble(I.asEigen() * 0.1));
+	H.addBlock(0, 0, I);
+	H.addBlock(H.blockCount() - 1, H.blockCount() - 1, I);
+	s.factorize(H);
+	checkSolution(H, 0, s);
+
+	// The same solution than a non-incremental solver:
+	CSparseCholeskySolverSupernodal full;
+	full.factorize(H);
+	CVectorDouble b(H.blockCount() * B), x1, x2;
+	mrpt::random::getRandomGenerator().drawGaussian1DVector(b);
+	s.solve(b, x1);
+	full.solve(b, x2);
+	EXPECT_LT(CVectorDouble(x1 - x2).norm(), 1e-8 * (1 + x2.norm()));
+}
@@ -10,6 +10,8 @@
 #include "graph_slam_levmarq_test_common.h"
 
 #include <gtest/gtest.h>
+#include <mrpt/core/WorkerThreadsPool.h>
+#include <mrpt/graphslam/CIncrementalGraphOptimizer.h>
 #include <mrpt/serialization/CArchive.h>
 #include <mrpt/system/filesystem.h>
 #include <test_mrpt_common.h>
@@ -77,6 +79,111 @@ class GraphTester : public GraphSlamLevMarqTest<my_graph_t>,
 
 	}  // end test_ring_path
 
+	void test_supernodal_solver()
+	{
+		my_graph_t graph;
+		GraphSlamLevMarqTest<my_graph_t>::create_ring_path(graph);
+		my_graph_t graph2 = graph;
+
+		mrpt::containers::yaml params;
+		params["max_iterations"] = 100;
+
+		graphslam::TResultInfoSpaLevMarq info1, info2;
+		graphslam::optimize_graph_spa_levmarq(graph, info1, nullptr, params);
+		params["linear_solver"] = "supernodal";
+		graphslam::optimize_graph_spa_levmarq(graph2, info2, nullptr, params);
+
+		// Both linear solvers must lead to the same solution:
+		EXPECT_EQ(info1.num_iters, info2.num_iters);
+		EXPECT_NEAR(
+			info1.final_total_sq_error, info2.final_total_sq_error, 1e-6);
+		compare_two_graphs(graph, graph2);
+	}
+
+	void test_parallel_assembly()
+	{
+		// Large enough for the parallel paths to be actually used:
+		my_graph_t graph;
+		GraphSlamLevMarqTest<my_graph_t>::create_ring_path(graph, 800, 2.5);
+		my_graph_t graph2 = graph;
+
+		mrpt::containers::yaml params;
+		params["max_iterations"] = 5;
+		params["linear_solver"] = "supernodal";
+
+		graphslam::TResultInfoSpaLevMarq info1, info2;
+		graphslam::optimize_graph_spa_levmarq(graph, info1, nullptr, params);
+		params["num_threads"] = 4;
+		// Run the parallel assembly even in single-core machines:
+		const auto formerNumCores = mrpt::WorkerThreadsPool::overrideNumCores(4);
+		graphslam::optimize_graph_spa_levmarq(graph2, info2, nullptr, params);
+		mrpt::WorkerThreadsPool::overrideNumCores(formerNumCores);
+
+		// The result must not depend on the number of threads at all:
+		EXPECT_EQ(info1.num_iters, info2.num_iters);
+		EXPECT_EQ(info1.final_total_sq_error, info2.final_total_sq_error);
+		ASSERT_EQ(graph.nodes.size(), graph2.nodes.size());
+		for (const auto& n : graph.nodes)
+			EXPECT_TRUE(n.second == graph2.nodes.at(n.first)) << n.first;
+	}
+
+	void test_incremental_optimizer()
+	{
+		my_graph_t full;
+		GraphSlamLevMarqTest<my_graph_t>::create_ring_path(full);
+
+		// Feed the graph node by node, as in online SLAM:
+		my_graph_t graph;
+		graph.root = full.root;
+
+		graphslam::CIncrementalGraphOptimizer<my_graph_t> opt;
+		opt.options.relinearize_every = 20;
+
+		size_t nIncremental = 0;
+		for (const auto& n : full.nodes)
+		{
+			graph.nodes[n.first] = n.second;
+			for (const auto& e : full.edges)
+				if (std::max(e.first.first, e.first.second) == n.first)
+					graph.insertEdge(e.first.first, e.first.second, e.second);
+
+			typename graphslam::CIncrementalGraphOptimizer<
+				my_graph_t>::TUpdateInfo info;
+			opt.update(graph, &info);
+			if (!info.batch_step)
+			{
+				nIncremental++;
+				EXPECT_EQ(info.num_free_nodes, graph.nodes.size() - 1);
+			}
+		}
+		EXPECT_EQ(graph.edges.size(), full.edges.size());
+		EXPECT_GT(nIncremental, full.nodes.size() / 2);
+
+		// No new edges: an incremental update with nothing to do.
+		typename graphslam::CIncrementalGraphOptimizer<my_graph_t>::TUpdateInfo
+			info;
+		opt.requestBatchStep();
+		opt.update(graph, &info);
+		opt.update(graph, &info);
+		EXPECT_FALSE(info.batch_step);
+		EXPECT_EQ(info.num_new_edges, 0U);
+
+		// Replacing an edge, with the same number of edges, is detected:
+		const auto replaced = graph.edges.begin()->first;
+		const auto newValue = std::next(graph.edges.begin())->second;
+		graph.edges.erase(graph.edges.begin());
+		graph.insertEdge(replaced.first, replaced.second, newValue);
+		opt.update(graph, &info);
+		EXPECT_TRUE(info.batch_step);
+		EXPECT_EQ(info.num_new_edges, full.edges.size());
+
+		const double err_init = full.chi2();
+		const double err_end = graph.chi2();
+		std::cout << "err_init: " << err_init << std::endl;
+		std::cout << "err_end: " << err_end << std::endl;
+		EXPECT_LT(err_end, 0.1 * err_init);
+	}
+
 	void compare_two_graphs(
 		const my_graph_t& g1, const my_graph_t& g2,
 		const double eps_node_pos = 1e-3, const double eps_edges = 1e-3)
@@ -235,6 +342,21 @@ using GraphTester3DInf = GraphTester<CNetworkOfPoses3DInf>;
 	TEST_F(_TYPE, OptimizeCompareKnownSolution)       \
 	{                                                 \
 		test_optimize_compare_known_solution(#_TYPE); \
+	}                                                 \
+	TEST_F(_TYPE, OptimizeSupernodalSolver)           \
+	{                                                 \
+		getRandomGenerator().randomize(123);          \
+		test_supernodal_solver();                     \
+	}                                                 \
+	TEST_F(_TYPE, IncrementalOptimizer)               \
+	{                                                 \
+		getRandomGenerator().randomize(123);          \
+		test_incremental_optimizer();                 \
+	}                                                 \
+	TEST_F(_TYPE, ParallelAssembly)                   \
+	{                                                 \
+		getRandomGenerator().randomize(123);          \
+		test_parallel_assembly();                     \
 	}
 
 GRAPHS_TESTS(GraphTester2D)
@@ -1020,6 +1020,8 @@ class CImage : public mrpt::serialization::CSerializable, public CCanvas
 	void getAsIplImage(IplImage* dest) const;
 
    protected:
+	friend class CImageCodecPool;
+
 	/** @name Data members
 		@{ */
 
@@ -0,0 +1,162 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2020, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <mrpt/core/WorkerThreadsPool.h>
+#include <mrpt/img/CImage.h>
+#include <condition_variable>
+#include <cstdint>
+#include <future>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace mrpt::img
+{
+/** A pool of worker threads to encode and decode images (JPEG, PNG, or any
+ * other format supported by CImage::saveToFile() and CImage::loadFromFile())
+ * without blocking the caller.
+ *
+ * - Writers enqueue encoding jobs with enqueueSaveToFile() or
+ * enqueueEncodeJPEG() and get a `std::future` with the result.
+ * - Readers of externally-stored images (see CImage::setExternalStorage())
+ * call prefetch() for the images they will need next, then load() when they
+ * actually need them. Decoded images are kept in a cache of bounded size,
+ * with a least-recently-used replacement policy, so images accessed again
+ * are not decoded twice.
+ *
+ * \code
+ * mrpt::img::CImageCodecPool pool;
+ * for (size_t i = 0; i < N; i++)
+ * {
+ *   // Decode ahead the next few images:
+ *   for (size_t j = i; j < std::min(N, i + 4); j++) pool.prefetch(imgs[j]);
+ *   pool.load(imgs[i]);  // Usually, already decoded.
+ *   ...
+ * }
+ * \endcode
+ *
+ * All methods are thread-safe.
+ *
+ * \note (New in MRPT 2.1.0)
+ * \ingroup mrpt_img_grp
+ */
+class CImageCodecPool
+{
+   public:
+	/** \param numThreads Number of worker threads (0=number of CPU cores),
+	 * see mrpt::WorkerThreadsPool::clampNumThreads().
+	 * \param cacheCapacity Max. number of decoded images in the cache.
+	 */
+	CImageCodecPool(std::size_t numThreads = 0, std::size_t cacheCapacity = 16);
+
+	/** Waits for all pending jobs before returning */
+	~CImageCodecPool();
+
+	CImageCodecPool(const CImageCodecPool&) = delete;
+	CImageCodecPool& operator=(const CImageCodecPool&) = delete;
+
+	/** @name Encoding
+		@{ */
+
+	/** Enqueues saving the image to a file, as CImage::saveToFile() does.
+	 * The image is a shallow copy (see CImage), so its pixels must not be
+	 * modified in-place until the job is done (clearing or assigning a new
+	 * image to it is safe).
+	 * \return A future with the value returned by CImage::saveToFile()
+	 */
+	std::future<bool> enqueueSaveToFile(
+		const CImage& img, const std::string& fileName,
+		int jpeg_quality = 95);
+
+	/** Enqueues encoding the image as JPEG in memory, as
+	 * CImage::saveToStreamAsJPEG() does. See notes in enqueueSaveToFile().
+	 */
+	std::future<std::vector<uint8_t>> enqueueEncodeJPEG(
+		const CImage& img, int jpeg_quality = 95);
+
+	/** Blocks until all enqueued jobs (encoding and decoding) are done */
+	void waitForPendingJobs();
+
+	/** @} */
+
+	/** @name Decoding of externally-stored images
+		@{ */
+
+	/** Starts decoding the image in the background, if it is an
+	 * externally-stored image not loaded yet and not in the cache.
+	 * Otherwise, it does nothing. */
+	void prefetch(const CImage& img);
+
+	/** Makes sure an externally-stored image is loaded in memory, like
+	 * CImage::forceLoad(), but taking it from the cache if it was already
+	 * decoded, or waiting for its decoding if it was prefetched.
+	 * The pixels are shared with the cached copy (shallow copy), so they must
+	 * not be modified in-place while in the cache.
+	 * \exception CExceptionExternalImageNotFound The failed image is also
+	 * removed from the cache, so it will be decoded again if requested.
+	 */
+	void load(const CImage& img);
+
+	/** Changes the max. number of decoded images in the cache (evicting the
+	 * least-recently used images, if needed). The most recently requested
+	 * image is always kept. */
+	void setCacheCapacity(std::size_t cacheCapacity);
+	std::size_t getCacheCapacity() const;
+	/** Number of images in the cache, including those being decoded */
+	std::size_t getCacheSize() const;
+	void clearCache();
+
+	struct TStats
+	{
+		/** Calls to load() or prefetch() for images already in the cache */
+		std::size_t cacheHits = 0;
+		/** Calls to load() or prefetch() which started a new decoding */
+		std::size_t cacheMisses = 0;
+	};
+	TStats getStats() const;
+
+	/** @} */
+
+   private:
+	using decoded_t = std::shared_future<CImage>;
+
+	mutable std::mutex m_cache_mtx;
+	std::size_t m_cacheCapacity;
+	/** Cached images, most-recently used first. */
+	std::list<std::pair<std::string, decoded_t>> m_lru;
+	std::map<std::string, decltype(m_lru)::iterator> m_cache;
+	TStats m_stats;
+
+	std::mutex m_jobs_mtx;
+	std::condition_variable m_jobs_cv;
+	std::size_t m_pendingJobs = 0;
+
+	/** Declared last, so worker threads are destroyed first */
+	mrpt::WorkerThreadsPool m_threads;
+
+	/** Returns the decoded image from the cache, enqueueing its decoding
+	 * first if not found. The caller must hold m_cache_mtx. */
+	decoded_t findOrDecode(const std::string& absPath);
+	void shrinkCache();
+	/** Removes the image from the cache if its decoding failed. The caller
+	 * must hold m_cache_mtx. */
+	void eraseIfFailed(const std::string& absPath);
+	/** Returns true if img is externally-stored and not loaded yet */
+	static bool needsLoading(const CImage& img);
+
+	/** Runs job in a worker thread, keeping track of pending jobs */
+	template <class F>
+	auto enqueueJob(F&& job) -> std::future<decltype(job())>;
+};
+
+}  // namespace mrpt::img
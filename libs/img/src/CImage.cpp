@@ -625,11 +625,11 @@ void CImage::serializeFrom(mrpt::serialization::CArchive& in, uint8_t version)
 			// Version 1: High quality JPEG image
 			uint32_t nBytes;
 			in >> nBytes;
-			std::vector<uint8_t> buf(nBytes);
-			in.ReadBuffer(buf.data(), nBytes);
+			// Decode directly from the source buffer, if possible:
+			const auto buf = in.ReadBufferBorrow(nBytes);
 
 			mrpt::io::CMemoryStream aux;
-			aux.assignMemoryNotOwn(buf.data(), buf.size());
+			aux.assignMemoryNotOwn(buf.get(), nBytes);
 			aux.Seek(0);
 			loadFromStreamAsJPEG(aux);
 		}
@@ -768,11 +768,12 @@ void CImage::serializeFrom(mrpt::serialization::CArchive& in, uint8_t version)
 						uint32_t nBytes;
 						in >> nBytes;
 
-						std::vector<uint8_t> buf(nBytes);
-						in.ReadBuffer(buf.data(), nBytes);
+						// Decode directly from the source buffer (e.g. a
+						// memory-mapped rawlog), if possible:
+						const auto buf = in.ReadBufferBorrow(nBytes);
 
 						mrpt::io::CMemoryStream aux;
-						aux.assignMemoryNotOwn(buf.data(), buf.size());
+						aux.assignMemoryNotOwn(buf.get(), nBytes);
 						aux.Seek(0);
 
 						loadFromStreamAsJPEG(aux);
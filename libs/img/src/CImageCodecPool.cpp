@@ -0,0 +1,217 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2020, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include "img-precomp.h"  // Precompiled headers
+
+#include <mrpt/core/WorkerThreadsPool.h>
+#include <mrpt/img/CImageCodecPool.h>
+#include <mrpt/io/CMemoryStream.h>
+#include "CImage_impl.h"
+
+using namespace mrpt::img;
+
+CImageCodecPool::CImageCodecPool(
+	std::size_t numThreads, std::size_t cacheCapacity)
+	: m_cacheCapacity(cacheCapacity)
+{
+	m_threads.resize(mrpt::WorkerThreadsPool::clampNumThreads(
+		static_cast<unsigned int>(numThreads)));
+}
+
+CImageCodecPool::~CImageCodecPool() { waitForPendingJobs(); }
+
+template <class F>
+auto CImageCodecPool::enqueueJob(F&& job) -> std::future<decltype(job())>
+{
+	{
+		std::lock_guard<std::mutex> lck(m_jobs_mtx);
+		m_pendingJobs++;
+	}
+	return m_threads.enqueue([this, job = std::forward<F>(job)]() {
+		// Decrement the counter even if the job throws:
+		struct OnExit
+		{
+			CImageCodecPool& p;
+			~OnExit()
+			{
+				std::lock_guard<std::mutex> lck(p.m_jobs_mtx);
+				if (--p.m_pendingJobs == 0) p.m_jobs_cv.notify_all();
+			}
+		} onExit{*this};
+		return job();
+	});
+}
+
+void CImageCodecPool::waitForPendingJobs()
+{
+	std::unique_lock<std::mutex> lck(m_jobs_mtx);
+	m_jobs_cv.wait(lck, [this]() { return m_pendingJobs == 0; });
+}
+
+std::future<bool> CImageCodecPool::enqueueSaveToFile(
+	const CImage& img, const std::string& fileName, int jpeg_quality)
+{
+	return enqueueJob([img, fileName, jpeg_quality]() {
+		return img.saveToFile(fileName, jpeg_quality);
+	});
+}
+
+std::future<std::vector<uint8_t>> CImageCodecPool::enqueueEncodeJPEG(
+	const CImage& img, int jpeg_quality)
+{
+	return enqueueJob([img, jpeg_quality]() {
+		mrpt::io::CMemoryStream buf;
+		img.saveToStreamAsJPEG(buf, jpeg_quality);
+		const auto p = reinterpret_cast<const uint8_t*>(buf.getRawBufferData());
+		return std::vector<uint8_t>(p, p + buf.getTotalBytesCount());
+	});
+}
+
+bool CImageCodecPool::needsLoading([[maybe_unused]] const CImage& img)
+{
+	if (!img.isExternallyStored()) return false;
+#if MRPT_HAS_OPENCV
+	return img.m_impl->img.empty();
+#else
+	return true;
+#endif
+}
+
+CImageCodecPool::decoded_t CImageCodecPool::findOrDecode(
+	const std::string& absPath)
+{
+	auto it = m_cache.find(absPath);
+	if (it != m_cache.end())
+	{
+		// Move to the front of the LRU list:
+		m_lru.splice(m_lru.begin(), m_lru, it->second);
+		m_stats.cacheHits++;
+		return it->second->second;
+	}
+
+	m_stats.cacheMisses++;
+	decoded_t decoded = enqueueJob([absPath]() {
+							CImage im;
+							if (!im.loadFromFile(absPath))
+								THROW_TYPED_EXCEPTION_FMT(
+									CExceptionExternalImageNotFound,
+									"Error loading externally-stored image "
+									"from: %s",
+									absPath.c_str());
+							return im;
+						}).share();
+
+	m_lru.emplace_front(absPath, decoded);
+	m_cache[absPath] = m_lru.begin();
+	shrinkCache();
+	return decoded;
+}
+
+void CImageCodecPool::eraseIfFailed(const std::string& absPath)
+{
+	auto it = m_cache.find(absPath);
+	if (it == m_cache.end()) return;
+	const decoded_t& decoded = it->second->second;
+	if (decoded.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		return;
+	try
+	{
+		decoded.get();
+	}
+	catch (...)
+	{
+		m_lru.erase(it->second);
+		m_cache.erase(it);
+	}
+}
+
+void CImageCodecPool::shrinkCache()
+{
+	// Always keep the most recent entry, which is about to be used:
+	while (m_lru.size() > std::max<std::size_t>(1, m_cacheCapacity))
+	{
+		m_cache.erase(m_lru.back().first);
+		m_lru.pop_back();
+	}
+}
+
+void CImageCodecPool::prefetch(const CImage& img)
+{
+	if (!needsLoading(img)) return;
+	const std::string absPath = img.getExternalStorageFileAbsolutePath();
+
+	std::lock_guard<std::mutex> lck(m_cache_mtx);
+	findOrDecode(absPath);
+}
+
+void CImageCodecPool::load(const CImage& img)
+{
+	MRPT_START
+	if (!needsLoading(img)) return;
+	const std::string absPath = img.getExternalStorageFileAbsolutePath();
+
+	decoded_t decoded;
+	{
+		std::lock_guard<std::mutex> lck(m_cache_mtx);
+		decoded = findOrDecode(absPath);
+	}
+	// Wait for the decoder without holding the lock:
+	try
+	{
+		decoded.get();
+	}
+	catch (...)
+	{
+		// Do not keep failed decodes in the cache:
+		std::lock_guard<std::mutex> lck(m_cache_mtx);
+		eraseIfFailed(absPath);
+		throw;
+	}
+	const CImage& im = decoded.get();
+#if MRPT_HAS_OPENCV
+	// Keep the external storage flag and file name, just like
+	// CImage::makeSureImageIsLoaded() does:
+	const_cast<cv::Mat&>(img.m_impl->img) = im.m_impl->img;
+#else
+	(void)im;
+#endif
+	MRPT_END
+}
+
+void CImageCodecPool::setCacheCapacity(std::size_t cacheCapacity)
+{
+	std::lock_guard<std::mutex> lck(m_cache_mtx);
+	m_cacheCapacity = cacheCapacity;
+	shrinkCache();
+}
+
+std::size_t CImageCodecPool::getCacheCapacity() const
+{
+	std::lock_guard<std::mutex> lck(m_cache_mtx);
+	return m_cacheCapacity;
+}
+
+std::size_t CImageCodecPool::getCacheSize() const
+{
+	std::lock_guard<std::mutex> lck(m_cache_mtx);
+	return m_lru.size();
+}
+
+void CImageCodecPool::clearCache()
+{
+	std::lock_guard<std::mutex> lck(m_cache_mtx);
+	m_cache.clear();
+	m_lru.clear();
+}
+
+CImageCodecPool::TStats CImageCodecPool::getStats() const
+{
+	std::lock_guard<std::mutex> lck(m_cache_mtx);
+	return m_stats;
+}
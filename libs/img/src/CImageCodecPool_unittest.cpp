@@ -0,0 +1,111 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2020, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include <gtest/gtest.h>
+#include <mrpt/config.h>
+#include <mrpt/core/WorkerThreadsPool.h>
+#include <mrpt/img/CImageCodecPool.h>
+#include <mrpt/system/filesystem.h>
+#include <test_mrpt_common.h>
+#include <vector>
+
+using namespace std::string_literals;
+
+TEST(CImageCodecPool, cacheAndMissingFiles)
+{
+	// Use two threads even in single-core machines:
+	const auto formerNumCores = mrpt::WorkerThreadsPool::overrideNumCores(2);
+	mrpt::img::CImageCodecPool pool(2, 2);
+	mrpt::WorkerThreadsPool::overrideNumCores(formerNumCores);
+
+	// Not externally-stored images are ignored:
+	mrpt::img::CImage img;
+	pool.prefetch(img);
+	EXPECT_EQ(pool.getCacheSize(), 0U);
+
+	std::vector<mrpt::img::CImage> imgs(3);
+	for (size_t i = 0; i < imgs.size(); i++)
+		imgs[i].setExternalStorage(
+			mrpt::system::getTempFileName() + "_missing_"s +
+			std::to_string(i) + ".png"s);
+
+	pool.prefetch(imgs[0]);
+	pool.prefetch(imgs[1]);
+	pool.prefetch(imgs[0]);
+	EXPECT_EQ(pool.getStats().cacheMisses, 2U);
+	EXPECT_EQ(pool.getStats().cacheHits, 1U);
+	EXPECT_EQ(pool.getCacheSize(), 2U);
+
+	// Evicts the least-recently used image (imgs[1]):
+	pool.prefetch(imgs[2]);
+	EXPECT_EQ(pool.getCacheSize(), 2U);
+	EXPECT_ANY_THROW(pool.load(imgs[1]));
+	EXPECT_EQ(pool.getStats().cacheMisses, 4U);
+	EXPECT_ANY_THROW(pool.load(imgs[0]));
+	EXPECT_EQ(pool.getStats().cacheMisses, 5U);
+
+	// Failed decodes are not kept in the cache:
+	EXPECT_EQ(pool.getCacheSize(), 1U);
+	EXPECT_ANY_THROW(pool.load(imgs[0]));
+	EXPECT_EQ(pool.getStats().cacheMisses, 6U);
+
+	pool.clearCache();
+	EXPECT_EQ(pool.getCacheSize(), 0U);
+}
+
+#if MRPT_HAS_OPENCV
+TEST(CImageCodecPool, encodeAndDecode)
+{
+	const auto tstImgFile =
+		mrpt::UNITTEST_BASEDIR + "/samples/img_basic_example/frame_color.jpg"s;
+	mrpt::img::CImage orgImg;
+	ASSERT_TRUE(orgImg.loadFromFile(tstImgFile));
+
+	// Use two threads even in single-core machines:
+	const auto formerNumCores = mrpt::WorkerThreadsPool::overrideNumCores(2);
+	mrpt::img::CImageCodecPool pool(2, 4);
+	mrpt::WorkerThreadsPool::overrideNumCores(formerNumCores);
+
+	// Encode to PNG files, and to JPEG in memory:
+	const std::string dir = mrpt::system::getTempFileName() + "_dir"s;
+	mrpt::system::createDirectory(dir);
+	std::vector<std::future<bool>> saved;
+	for (int i = 0; i < 5; i++)
+		saved.emplace_back(pool.enqueueSaveToFile(
+			orgImg, dir + "/img"s + std::to_string(i) + ".png"s));
+	auto jpeg = pool.enqueueEncodeJPEG(orgImg, 90);
+	for (auto& f : saved) EXPECT_TRUE(f.get());
+	EXPECT_GT(jpeg.get().size(), 1000U);
+
+	// Decode, with relative paths:
+	const std::string oldPathBase = mrpt::img::CImage::getImagesPathBase();
+	mrpt::img::CImage::setImagesPathBase(dir);
+	std::vector<mrpt::img::CImage> imgs(5);
+	for (int i = 0; i < 5; i++)
+		imgs[i].setExternalStorage("img"s + std::to_string(i) + ".png"s);
+	// Decodes all images, evicting #0 since the cache capacity is 4:
+	for (auto& im : imgs) pool.prefetch(im);
+	// Newest first: #4 to #1 are in the cache, #0 is decoded again:
+	for (int i = 4; i >= 0; i--)
+	{
+		auto& im = imgs[i];
+		pool.load(im);
+		EXPECT_TRUE(im.isExternallyStored());
+		EXPECT_EQ(im.getWidth(), orgImg.getWidth());
+		EXPECT_EQ(im.getHeight(), orgImg.getHeight());
+		// PNG is lossless:
+		EXPECT_EQ(im.at<uint8_t>(10, 20, 1), orgImg.at<uint8_t>(10, 20, 1));
+	}
+	EXPECT_EQ(pool.getStats().cacheMisses, 6U);
+	EXPECT_EQ(pool.getStats().cacheHits, 4U);
+
+	mrpt::img::CImage::setImagesPathBase(oldPathBase);
+	mrpt::system::deleteFilesInDirectory(dir, true /*delete dir too*/);
+}
+#endif
@@ -17,9 +17,15 @@ namespace mrpt::io
 /** Transparently opens a compressed "gz" file and reads uncompressed data from
  * it.
  *   If the file is not a .gz file, it silently reads data from the file.
+ *   zstd-compressed files are also detected (by their magic number) and
+ * transparently decompressed with CFileZstdInputStream.
  *  This class requires compiling MRPT with wxWidgets. If wxWidgets is not
  * available then the class is actually mapped to the standard CFileInputStream
  *
+ * If enabled with setReadAhead(), decompression runs in a background thread
+ * which reads ahead of Read() calls, so readers do not stall on inflate as
+ * long as they consume data slower than it is decompressed.
+ *
  * \sa CFileInputStream
  * \ingroup mrpt_io_grp
  */
@@ -56,6 +62,16 @@ class CFileGZInputStream : public CStream
 		mrpt::optional_ref<std::string> error_msg = std::nullopt);
 	/** Closes the file */
 	void close();
+
+	/** Enables or disables (default) decompression in a background thread
+	 * for the next call to open().
+	 * \param readAheadBytes Maximum amount of decompressed data kept ahead
+	 * of the reader.
+	 * Decompression errors found by the background thread are thrown by
+	 * Read().
+	 * \note (New in MRPT 2.1.0)
+	 */
+	void setReadAhead(bool enable, size_t readAheadBytes = 4 * 1024 * 1024);
 	/** Returns true if the file was open without errors. */
 	bool fileOpenCorrectly() const;
 	/** Returns true if the file was open without errors. */
@@ -20,6 +20,12 @@ namespace mrpt::io
  *  This class requires compiling MRPT with wxWidgets. If wxWidgets is not
  * available then the class is actually mapped to the standard CFileOutputStream
  *
+ * A multi-threaded mode, similar to that of the `pigz` tool, can be enabled
+ * with setParallelCompression(): data is split into blocks which are
+ * compressed in parallel by a pool of worker threads, while the calling
+ * thread only copies data and writes finished blocks to disk. The output is
+ * still a standard, single-member gzip file, readable by any gzip decoder.
+ *
  * \sa CFileOutputStream
  * \ingroup mrpt_io_grp
  */
@@ -56,8 +62,23 @@ class CFileGZOutputStream : public CStream
 	bool open(
 		const std::string& fileName, int compress_level = 1,
 		mrpt::optional_ref<std::string> error_msg = std::nullopt);
-	/** Close the file */
+	/** Close the file. In parallel compression mode, this compresses and
+	 * writes the pending data.
+	 * \exception std::exception On any error writing the pending data.
+	 * Errors are only printed to std::cerr if the file is closed by the
+	 * destructor instead. */
 	void close();
+
+	/** Enables (numThreads!=1) or disables (numThreads=1, the default) the
+	 * parallel compression mode for the next call to open().
+	 * \param numThreads Number of compression threads (0: all cores).
+	 * \param blockSize Size of each independently compressed block (the
+	 * last 32 KiB of each block are used as dictionary for the next one,
+	 * so the compression ratio is almost the same than in serial mode).
+	 * \note (New in MRPT 2.1.0)
+	 */
+	void setParallelCompression(
+		unsigned int numThreads, size_t blockSize = 128 * 1024);
 	/** Returns true if the file was open without errors. */
 	bool fileOpenCorrectly() const;
 	/** Returns true if the file was open without errors. */
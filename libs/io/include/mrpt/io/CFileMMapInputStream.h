@@ -0,0 +1,99 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2020, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <mrpt/core/optional_ref.h>
+#include <mrpt/core/pimpl.h>
+#include <mrpt/io/CStream.h>
+
+namespace mrpt::io
+{
+/** A read-only, binary stream over a file which is mapped into memory.
+ *
+ * The file contents are not read upon opening: pages are loaded by the OS on
+ * demand, so opening very large files is immediate and random accesses
+ * (Seek()) have no cost. The whole mapped file is also directly accessible
+ * via data(), e.g. to deserialize objects at arbitrary offsets with
+ * independent CMemoryStream objects (see CMemoryStream::assignMemoryNotOwn).
+ *
+ * Deserialization code can also read large payloads directly from the
+ * mapping, without copying them, via CStream::ReadBorrow() and
+ * mrpt::serialization::CArchive::ReadBufferBorrow().
+ *
+ * Note that the file is mapped "as is": unlike CFileGZInputStream,
+ * gz-compressed files are not decompressed.
+ *
+ * \sa CFileInputStream, CFileGZInputStream
+ * \note (New in MRPT 2.1.0)
+ * \ingroup mrpt_io_grp
+ */
+class CFileMMapInputStream : public CStream
+{
+   private:
+	struct Impl;
+	mrpt::pimpl<Impl> m_impl;
+	/** Start of the mapped region, or nullptr if not open */
+	const uint8_t* m_data{nullptr};
+	uint64_t m_size{0}, m_position{0};
+
+   public:
+	/** Constructor without open */
+	CFileMMapInputStream();
+
+	/** Constructor and open
+	 * \param fileName The file to be open in this stream
+	 * \exception std::exception If there's an error opening the file.
+	 */
+	CFileMMapInputStream(const std::string& fileName);
+
+	CFileMMapInputStream(const CFileMMapInputStream&) = delete;
+	CFileMMapInputStream& operator=(const CFileMMapInputStream&) = delete;
+
+	/** Dtor: unmaps the file */
+	~CFileMMapInputStream() override;
+
+	/** Opens and maps the file for read.
+	 * \param fileName The file to be open in this stream
+	 * \return false if there's an error opening or mapping the file, true
+	 * otherwise
+	 */
+	bool open(
+		const std::string& fileName,
+		mrpt::optional_ref<std::string> error_msg = std::nullopt);
+	/** Unmaps and closes the file */
+	void close();
+	/** Returns true if the file was open without errors. */
+	bool fileOpenCorrectly() const;
+	/** Returns true if the file was open without errors. */
+	bool is_open() { return fileOpenCorrectly(); }
+	/** Will be true if EOF has been already reached. */
+	bool checkEOF() const { return m_position >= m_size; }
+
+	/** Direct read-only access to the whole mapped file, which remains valid
+	 * until close() or the object is destroyed. Can be nullptr for empty
+	 * files. */
+	const uint8_t* data() const { return m_data; }
+	/** Size of the mapped file (bytes) */
+	uint64_t size() const { return m_size; }
+
+	// See docs in base class
+	uint64_t Seek(
+		int64_t off, CStream::TSeekOrigin Origin = sFromBeginning) override;
+	// See docs in base class
+	uint64_t getTotalBytesCount() const override;
+	// See docs in base class
+	uint64_t getPosition() const override;
+
+	size_t Read(void* Buffer, size_t Count) override;
+	size_t Write(const void* Buffer, size_t Count) override;
+	/** Returns a pointer into the mapped file which keeps it mapped, even
+	 * after close(), while in use. See CStream::ReadBorrow() */
+	std::shared_ptr<const uint8_t> ReadBorrow(size_t Count) override;
+};  // End of class def.
+}  // namespace mrpt::io
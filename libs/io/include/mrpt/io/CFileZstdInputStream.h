@@ -0,0 +1,99 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2020, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <mrpt/core/optional_ref.h>
+#include <mrpt/core/pimpl.h>
+#include <mrpt/io/CStream.h>
+
+namespace mrpt::io
+{
+/** Reads uncompressed data from a zstd-compressed file (".zst").
+ *
+ * Any zstd file can be read sequentially. If the file has a seek table
+ * (zstd "seekable format", as written by CFileZstdOutputStream), Seek() only
+ * decompresses the frame containing the target position; otherwise, seeking
+ * forward decompresses and discards data, and seeking backwards restarts
+ * from the beginning of the file.
+ *
+ * Note that CFileGZInputStream also opens zstd files, detected by their
+ * magic number, so applications reading rawlogs get support for this format
+ * without any change.
+ *
+ * This class requires compiling MRPT with the zstd library
+ * (`MRPT_HAS_ZSTD`). Otherwise, open() always fails.
+ *
+ * \sa CFileZstdOutputStream, CFileGZInputStream
+ * \ingroup mrpt_io_grp
+ * \note (New in MRPT 2.1.0)
+ */
+class CFileZstdInputStream : public CStream
+{
+   private:
+	struct Impl;
+	mrpt::pimpl<Impl> m_f;
+
+   public:
+	/** Constructor without open */
+	CFileZstdInputStream();
+
+	/** Constructor and open
+	 * \param fileName The file to be open in this stream
+	 * \exception std::exception If there's an error opening the file.
+	 */
+	CFileZstdInputStream(const std::string& fileName);
+
+	CFileZstdInputStream(const CFileZstdInputStream&) = delete;
+	CFileZstdInputStream& operator=(const CFileZstdInputStream&) = delete;
+
+	/** Dtor */
+	~CFileZstdInputStream() override;
+
+	/** Opens the file for read.
+	 * \param fileName The file to be open in this stream
+	 * \return false if there's an error opening the file, or it is not a
+	 * zstd file, true otherwise
+	 */
+	bool open(
+		const std::string& fileName,
+		mrpt::optional_ref<std::string> error_msg = std::nullopt);
+	/** Closes the file */
+	void close();
+
+	/** Returns true if the file starts with the magic number of a zstd frame
+	 * (or of a skippable frame). This does not require MRPT to be built with
+	 * zstd support. */
+	static bool isZstdFile(const std::string& fileName);
+
+	/** Returns true if the file was open without errors. */
+	bool fileOpenCorrectly() const;
+	/** Returns true if the file was open without errors. */
+	bool is_open() { return fileOpenCorrectly(); }
+	/** Will be true if EOF has been already reached. */
+	bool checkEOF();
+	/** Returns true if the open file has a seek table, hence Seek() works in
+	 * constant time and sFromEnd is supported. */
+	bool isSeekable() const;
+
+	/** Method for getting the total number of <b>compressed</b> bytes in the
+	 * file (the physical size of the compressed file). */
+	uint64_t getTotalBytesCount() const override;
+	/** Method for getting the current cursor position in the
+	 * <b>uncompressed</b> data. */
+	uint64_t getPosition() const override;
+
+	/** Moves the cursor in the <b>uncompressed</b> data. sFromEnd is only
+	 * supported in seekable files (see isSeekable()).
+	 * \return The new position */
+	uint64_t Seek(
+		int64_t off, CStream::TSeekOrigin org = sFromBeginning) override;
+	size_t Read(void* Buffer, size_t Count) override;
+	size_t Write(const void* Buffer, size_t Count) override;
+};  // End of class def.
+}  // namespace mrpt::io
@@ -0,0 +1,94 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2020, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <mrpt/core/optional_ref.h>
+#include <mrpt/core/pimpl.h>
+#include <mrpt/io/CStream.h>
+
+namespace mrpt::io
+{
+/** Saves data to a file compressed with the zstd algorithm, which is much
+ * faster than gzip, both compressing and decompressing, for similar
+ * compression ratios.
+ *
+ * Data is split into independent zstd frames of up to setFrameSize() bytes
+ * each, and a seek table following the zstd "seekable format" is appended
+ * at the end of the file, so CFileZstdInputStream can efficiently Seek()
+ * in the uncompressed data. The generated files ("file.zst") are standard
+ * zstd files, readable by the `zstd` command line tool.
+ *
+ * This class requires compiling MRPT with the zstd library
+ * (`MRPT_HAS_ZSTD`). Otherwise, open() always fails.
+ *
+ * \sa CFileZstdInputStream, CFileGZOutputStream
+ * \ingroup mrpt_io_grp
+ * \note (New in MRPT 2.1.0)
+ */
+class CFileZstdOutputStream : public CStream
+{
+   private:
+	struct Impl;
+	mrpt::pimpl<Impl> m_f;
+
+   public:
+	/** Constructor: opens an output file with the default compression level.
+	 * \param fileName The file to be open in this stream
+	 * \exception std::exception If there's an error opening the file.
+	 * \sa open
+	 */
+	CFileZstdOutputStream(const std::string& fileName);
+
+	/** Constructor, without opening the file.
+	 * \sa open
+	 */
+	CFileZstdOutputStream();
+
+	CFileZstdOutputStream(const CFileZstdOutputStream&) = delete;
+	CFileZstdOutputStream& operator=(const CFileZstdOutputStream&) = delete;
+
+	/** Destructor */
+	~CFileZstdOutputStream() override;
+
+	/** Open a file for write, choosing the compression level
+	 * \param fileName The file to be open in this stream
+	 * \param compress_level 1:fastest, ..., 19:best (levels up to 22, and
+	 * negative ones for even faster compression, are also accepted).
+	 * \return true on success, false on any error.
+	 */
+	bool open(
+		const std::string& fileName, int compress_level = 3,
+		mrpt::optional_ref<std::string> error_msg = std::nullopt);
+	/** Close the file, writing the last frame and the seek table */
+	void close();
+
+	/** Sets the maximum amount of uncompressed data in each frame, for the
+	 * next call to open(). Smaller frames allow faster random access, larger
+	 * ones give slightly better compression. Default: 1 MiB. */
+	void setFrameSize(size_t maxFrameSize);
+	/** Returns true if the file was open without errors. */
+	bool fileOpenCorrectly() const;
+	/** Returns true if the file was open without errors. */
+	bool is_open() { return fileOpenCorrectly(); }
+	/** Method for getting the current cursor position in the
+	 * <b>uncompressed</b> data. */
+	uint64_t getPosition() const override;
+
+	/** This method is not implemented in this class */
+	uint64_t Seek(int64_t, CStream::TSeekOrigin = sFromBeginning) override;
+	/** This method is not implemented in this class */
+	uint64_t getTotalBytesCount() const override;
+	size_t Read(void* Buffer, size_t Count) override;
+	size_t Write(const void* Buffer, size_t Count) override;
+};  // End of class def.
+static_assert(
+	!std::is_copy_constructible_v<CFileZstdOutputStream> &&
+		!std::is_copy_assignable_v<CFileZstdOutputStream>,
+	"Copy Check");
+}  // namespace mrpt::io
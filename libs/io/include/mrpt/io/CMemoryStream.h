@@ -28,6 +28,9 @@ class CMemoryStream : public CStream
    public:
 	size_t Read(void* Buffer, size_t Count) override;
 	size_t Write(const void* Buffer, size_t Count) override;
+	/** Returns a non-owning pointer into the internal buffer, see
+	 * CStream::ReadBorrow() */
+	std::shared_ptr<const uint8_t> ReadBorrow(size_t Count) override;
 
    protected:
 	/** Internal data */
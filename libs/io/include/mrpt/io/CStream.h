@@ -10,6 +10,7 @@
 
 #include <mrpt/core/common.h>  // MRPT_printf_format_check
 #include <cstdint>
+#include <memory>
 #include <string>
 
 namespace mrpt::io
@@ -64,6 +65,22 @@ class CStream
 		return Read(Buffer, Count);
 	}
 
+	/** Zero-copy read: returns a read-only pointer to the next Count bytes of
+	 * the stream and moves the read position past them, or nullptr (without
+	 * moving) if this stream does not keep its contents in memory, or there
+	 * are less than Count bytes left.
+	 *
+	 * If the stream is backed by a shared buffer (e.g. CFileMMapInputStream),
+	 * the returned pointer shares its ownership, so the data remains valid
+	 * even after closing the stream. Otherwise (e.g. CMemoryStream), the
+	 * data is only valid while the stream is not modified or destroyed.
+	 *
+	 * The default implementation returns nullptr.
+	 * \sa mrpt::serialization::CArchive::ReadBufferBorrow()
+	 * \note (New in MRPT 2.1.0)
+	 */
+	virtual std::shared_ptr<const uint8_t> ReadBorrow(size_t Count);
+
 	/** Introduces a pure virtual method for moving to a specified position in
 	 *the streamed resource.
 	 *   he Origin parameter indicates how to interpret the Offset parameter.
@@ -11,9 +11,19 @@
 
 #include <mrpt/core/exceptions.h>
 #include <mrpt/io/CFileGZInputStream.h>
+#include <mrpt/io/CFileZstdInputStream.h>
 #include <mrpt/system/filesystem.h>
+#include <algorithm>
 #include <cerrno>
+#include <condition_variable>
 #include <cstring>  // strerror
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 #include <zlib.h>
 
@@ -25,9 +35,156 @@ static_assert(
 		!std::is_copy_assignable_v<CFileGZInputStream>,
 	"Copy Check");
 
+namespace
+{
+/** Decompresses a file in a background thread, into a queue of chunks
+ * which is consumed by read() */
+class ReadAheadReader
+{
+   public:
+	/** Function which reads decompressed data, returning the number of
+	 * bytes read (0 at the end of file) */
+	using read_func_t = std::function<size_t(void*, size_t)>;
+
+	ReadAheadReader(read_func_t source, size_t maxQueuedBytes)
+		: m_source(std::move(source)),
+		  m_maxQueued(maxQueuedBytes),
+		  m_chunkSize(std::max<size_t>(4096, maxQueuedBytes / 8))
+	{
+		m_thread = std::thread([this]() { run(); });
+	}
+
+	~ReadAheadReader()
+	{
+		{
+			std::lock_guard<std::mutex> lck(m_mtx);
+			m_stop = true;
+		}
+		m_cv.notify_all();
+		if (m_thread.joinable()) m_thread.join();
+	}
+
+	size_t read(void* buffer, size_t count)
+	{
+		auto out = reinterpret_cast<uint8_t*>(buffer);
+		size_t done = 0;
+		while (done < count)
+		{
+			if (m_curPos == m_cur.size() && !nextChunk()) break;
+			const size_t n = std::min(count - done, m_cur.size() - m_curPos);
+			std::memcpy(out + done, &m_cur[m_curPos], n);
+			m_curPos += n;
+			done += n;
+		}
+		m_consumed += done;
+		return done;
+	}
+
+	/** Blocks until there is more data, or the end of file is reached */
+	bool eof()
+	{
+		return m_curPos == m_cur.size() && !nextChunk();
+	}
+
+	uint64_t position() const { return m_consumed; }
+
+   private:
+	read_func_t m_source;
+	const size_t m_maxQueued, m_chunkSize;
+	std::thread m_thread;
+	std::mutex m_mtx;
+	std::condition_variable m_cv;
+	std::deque<std::vector<uint8_t>> m_chunks;
+	size_t m_queuedBytes{0};
+	bool m_endOfData{false}, m_stop{false};
+	/** An exception thrown by m_source, rethrown from read() once all the
+	 * chunks queued before it are consumed */
+	std::exception_ptr m_error;
+
+	// Accessed from the consumer thread only:
+	std::vector<uint8_t> m_cur;
+	size_t m_curPos{0};
+	uint64_t m_consumed{0};
+
+	void run()
+	{
+		for (;;)
+		{
+			{
+				std::unique_lock<std::mutex> lck(m_mtx);
+				m_cv.wait(lck, [this]() {
+					return m_stop || m_queuedBytes < m_maxQueued;
+				});
+				if (m_stop) return;
+			}
+			std::vector<uint8_t> chunk(m_chunkSize);
+			size_t n = 0;
+			try
+			{
+				n = m_source(chunk.data(), chunk.size());
+			}
+			catch (...)
+			{
+				{
+					std::lock_guard<std::mutex> lck(m_mtx);
+					m_error = std::current_exception();
+					m_endOfData = true;
+				}
+				m_cv.notify_all();
+				return;
+			}
+			{
+				std::lock_guard<std::mutex> lck(m_mtx);
+				if (n == 0)
+				{
+					m_endOfData = true;
+				}
+				else
+				{
+					chunk.resize(n);
+					m_queuedBytes += chunk.size();
+					m_chunks.push_back(std::move(chunk));
+				}
+			}
+			m_cv.notify_all();
+			if (n == 0) return;
+		}
+	}
+
+	/** Moves the next chunk to m_cur. Returns false at the end of file, or
+	 * rethrows the error found while reading it */
+	bool nextChunk()
+	{
+		{
+			std::unique_lock<std::mutex> lck(m_mtx);
+			m_cv.wait(
+				lck, [this]() { return !m_chunks.empty() || m_endOfData; });
+			if (m_chunks.empty())
+			{
+				if (m_error) std::rethrow_exception(m_error);
+				return false;
+			}
+			m_cur = std::move(m_chunks.front());
+			m_chunks.pop_front();
+			m_queuedBytes -= m_cur.size();
+		}
+		m_cv.notify_all();
+		m_curPos = 0;
+		return true;
+	}
+};
+}  // namespace
+
 struct CFileGZInputStream::Impl
 {
 	gzFile f{nullptr};
+	/** Used instead of "f" for zstd files */
+	std::shared_ptr<CFileZstdInputStream> zstd;
+
+	bool readAhead{false};
+	size_t readAheadBytes{4 * 1024 * 1024};
+	/** Used in read-ahead mode. It must be destroyed before closing "f" */
+	std::shared_ptr<ReadAheadReader> reader;
 };
 
 CFileGZInputStream::CFileGZInputStream()
@@ -48,7 +205,7 @@ bool CFileGZInputStream::open(
 {
 	MRPT_START
 
-	if (m_f->f) gzclose(m_f->f);
+	close();
 
 	// Get compressed file size:
 	m_file_size = mrpt::system::getFileSize(fileName);
@@ -60,17 +217,55 @@ bool CFileGZInputStream::open(
 		return false;
 	}
 
-	// Open gz stream:
-	m_f->f = gzopen(fileName.c_str(), "rb");
-	if (m_f->f == nullptr && error_msg)
-		error_msg.value().get() = std::string(strerror(errno));
+	ReadAheadReader::read_func_t source;
+	if (CFileZstdInputStream::isZstdFile(fileName))
+	{
+		// zstd stream:
+		auto zstd = std::make_shared<CFileZstdInputStream>();
+		if (!zstd->open(fileName, error_msg)) return false;
+		m_f->zstd = zstd;
+		source = [zstd](void* buf, size_t n) { return zstd->Read(buf, n); };
+	}
+	else
+	{
+		// Open gz stream:
+		m_f->f = gzopen(fileName.c_str(), "rb");
+		if (m_f->f == nullptr)
+		{
+			if (error_msg)
+				error_msg.value().get() = std::string(strerror(errno));
+			return false;
+		}
+		gzFile f = m_f->f;
+		source = [f](void* buf, size_t n) {
+			const int r = gzread(f, buf, static_cast<unsigned>(n));
+			if (r < 0)
+			{
+				int errnum = 0;
+				THROW_EXCEPTION_FMT(
+					"Error decompressing gz data: %s", gzerror(f, &errnum));
+			}
+			return static_cast<size_t>(r);
+		};
+	}
+
+	if (m_f->readAhead)
+	{
+		ASSERT_ABOVE_(m_f->readAheadBytes, 0U);
+		// Larger reads from the file, since we have our own thread:
+		if (m_f->f) gzbuffer(m_f->f, 128 * 1024);
+		m_f->reader =
+			std::make_shared<ReadAheadReader>(source, m_f->readAheadBytes);
+	}
 
-	return m_f->f != nullptr;
+	return true;
 	MRPT_END
 }
 
 void CFileGZInputStream::close()
 {
+	m_f->reader.reset();
+	m_f->zstd.reset();
 	if (m_f->f)
 	{
 		gzclose(m_f->f);
@@ -81,14 +276,22 @@ void CFileGZInputStream::close()
 CFileGZInputStream::~CFileGZInputStream() { close(); }
 size_t CFileGZInputStream::Read(void* Buffer, size_t Count)
 {
-	if (!m_f->f)
+	if (!fileOpenCorrectly())
 	{
 		THROW_EXCEPTION("File is not open.");
 	}
+	if (m_f->reader) return m_f->reader->read(Buffer, Count);
+	if (m_f->zstd) return m_f->zstd->Read(Buffer, Count);
 
 	return gzread(m_f->f, Buffer, Count);
 }
 
+void CFileGZInputStream::setReadAhead(bool enable, size_t readAheadBytes)
+{
+	m_f->readAhead = enable;
+	m_f->readAheadBytes = readAheadBytes;
+}
+
 size_t CFileGZInputStream::Write(
 	[[maybe_unused]] const void* Buffer, [[maybe_unused]] size_t Count)
 {
@@ -97,7 +300,7 @@ size_t CFileGZInputStream::Write(
 
 uint64_t CFileGZInputStream::getTotalBytesCount() const
 {
-	if (!m_f->f)
+	if (!fileOpenCorrectly())
 	{
 		THROW_EXCEPTION("File is not open.");
 	}
@@ -106,18 +309,27 @@ uint64_t CFileGZInputStream::getTotalBytesCount() const
 
 uint64_t CFileGZInputStream::getPosition() const
 {
-	if (!m_f->f)
+	if (!fileOpenCorrectly())
 	{
 		THROW_EXCEPTION("File is not open.");
 	}
+	if (m_f->reader) return m_f->reader->position();
+	if (m_f->zstd) return m_f->zstd->getPosition();
 	return gztell(m_f->f);
 }
 
-bool CFileGZInputStream::fileOpenCorrectly() const { return m_f->f != nullptr; }
+bool CFileGZInputStream::fileOpenCorrectly() const
+{
+	return m_f->f != nullptr || m_f->zstd != nullptr;
+}
 bool CFileGZInputStream::checkEOF()
 {
-	if (!m_f->f)
+	if (!fileOpenCorrectly())
 		return true;
+	else if (m_f->reader)
+		return m_f->reader->eof();
+	else if (m_f->zstd)
+		return m_f->zstd->checkEOF();
 	else
 		return 0 != gzeof(m_f->f);
 }
@@ -9,19 +9,196 @@
 
 #include "io-precomp.h"  // Precompiled headers
 
+#include <mrpt/core/WorkerThreadsPool.h>
 #include <mrpt/core/exceptions.h>
 #include <mrpt/io/CFileGZOutputStream.h>
+#include <mrpt/io/CFileOutputStream.h>
+#include <algorithm>
 #include <cerrno>
 #include <cstring>  // strerror
+#include <deque>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
 
 #include <zlib.h>
 
 using namespace mrpt::io;
 using namespace std;
 
+namespace
+{
+/** Writes a gzip file whose data is compressed in parallel by blocks, as
+ * pigz does: each block is a piece of one raw deflate stream, ended with a
+ * sync flush (so it ends at a byte boundary) and using the end of the former
+ * block as dictionary. */
+class ParallelGzWriter
+{
+   public:
+	ParallelGzWriter(unsigned int numThreads, size_t blockSize, int level)
+		: m_pool(numThreads),
+		  m_maxPending(2 * numThreads),
+		  m_blockSize(blockSize),
+		  m_level(level)
+	{
+	}
+
+	bool open(const std::string& fileName, std::string& error_msg)
+	{
+		if (!m_out.open(fileName))
+		{
+			error_msg = std::string(strerror(errno));
+			return false;
+		}
+		// gzip header: magic, deflate, no flags, no mtime, xfl, OS=unknown:
+		const uint8_t xfl = m_level >= 9 ? 2 : (m_level == 1 ? 4 : 0);
+		const uint8_t header[10] = {0x1f, 0x8b, 8, 0, 0, 0, 0, 0, xfl, 255};
+		m_out.Write(header, sizeof(header));
+		m_cur = std::make_shared<std::vector<uint8_t>>();
+		m_cur->reserve(m_blockSize);
+		return true;
+	}
+
+	size_t write(const void* buffer, size_t count)
+	{
+		auto ptr = reinterpret_cast<const uint8_t*>(buffer);
+		size_t left = count;
+		while (left)
+		{
+			const size_t n = std::min(left, m_blockSize - m_cur->size());
+			m_cur->insert(m_cur->end(), ptr, ptr + n);
+			ptr += n;
+			left -= n;
+			if (m_cur->size() == m_blockSize) submit(false);
+		}
+		m_total += count;
+		return count;
+	}
+
+	/** Compresses the pending data and writes the gzip trailer */
+	void finish()
+	{
+		submit(true);
+		while (!m_pending.empty()) writeOldestBlock();
+
+		// gzip trailer: CRC32 and size of the uncompressed data (mod 2^32):
+		uint8_t trailer[8];
+		for (int i = 0; i < 4; i++)
+		{
+			trailer[i] = static_cast<uint8_t>(m_crc >> (8 * i));
+			trailer[4 + i] = static_cast<uint8_t>(m_total >> (8 * i));
+		}
+		m_out.Write(trailer, sizeof(trailer));
+		m_out.close();
+	}
+
+	uint64_t position() const { return m_total; }
+
+   private:
+	using buffer_t = std::shared_ptr<const std::vector<uint8_t>>;
+
+	struct TBlock
+	{
+		std::vector<uint8_t> data;
+		uLong crc, len;
+	};
+
+	mrpt::io::CFileOutputStream m_out;
+	mrpt::WorkerThreadsPool m_pool;
+	const size_t m_maxPending, m_blockSize;
+	const int m_level;
+	/** Data not submitted yet, and the former block (the dictionary) */
+	std::shared_ptr<std::vector<uint8_t>> m_cur;
+	buffer_t m_prev;
+	/** Blocks being compressed, in file order */
+	std::deque<std::future<TBlock>> m_pending;
+	uLong m_crc{crc32(0L, Z_NULL, 0)};
+	uint64_t m_total{0};
+
+	static TBlock compress(
+		const buffer_t& in, const buffer_t& dict, int level, bool last)
+	{
+		z_stream zs;
+		std::memset(&zs, 0, sizeof(zs));
+		// Negative window bits: raw deflate data, without zlib header.
+		if (deflateInit2(&zs, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) !=
+			Z_OK)
+			THROW_EXCEPTION("deflateInit2() failed");
+
+		constexpr size_t MAX_DICT = 32768;
+		if (dict && level > 0)
+		{
+			const size_t n = std::min(MAX_DICT, dict->size());
+			deflateSetDictionary(
+				&zs, dict->data() + dict->size() - n, static_cast<uInt>(n));
+		}
+
+		TBlock b;
+		b.len = static_cast<uLong>(in->size());
+		b.crc = crc32(0L, in->data(), static_cast<uInt>(in->size()));
+		b.data.resize(deflateBound(&zs, b.len) + 16);
+
+		zs.next_in = const_cast<Bytef*>(in->data());
+		zs.avail_in = static_cast<uInt>(in->size());
+		const int flush = last ? Z_FINISH : Z_SYNC_FLUSH;
+		size_t used = 0;
+		for (;;)
+		{
+			zs.next_out = b.data.data() + used;
+			zs.avail_out = static_cast<uInt>(b.data.size() - used);
+			const int ret = deflate(&zs, flush);
+			used = b.data.size() - zs.avail_out;
+			if (ret == Z_STREAM_ERROR)
+			{
+				deflateEnd(&zs);
+				THROW_EXCEPTION("deflate() failed");
+			}
+			if (last ? ret == Z_STREAM_END : zs.avail_out != 0) break;
+			b.data.resize(2 * b.data.size());
+		}
+		deflateEnd(&zs);
+		b.data.resize(used);
+		return b;
+	}
+
+	void submit(bool last)
+	{
+		buffer_t in = m_cur, dict = m_prev;
+		m_pending.push_back(m_pool.enqueue(
+			&ParallelGzWriter::compress, in, dict, m_level, last));
+		m_prev = in;
+		m_cur = std::make_shared<std::vector<uint8_t>>();
+		m_cur->reserve(m_blockSize);
+
+		// Write finished blocks, and wait for the oldest one if there are
+		// too many in flight, to bound the memory usage:
+		while (!m_pending.empty() &&
+			   (m_pending.size() > m_maxPending ||
+				m_pending.front().wait_for(std::chrono::seconds(0)) ==
+					std::future_status::ready))
+			writeOldestBlock();
+	}
+
+	void writeOldestBlock()
+	{
+		const TBlock b = m_pending.front().get();
+		m_pending.pop_front();
+		m_out.Write(b.data.data(), b.data.size());
+		m_crc = crc32_combine(m_crc, b.crc, b.len);
+	}
+};
+}  // namespace
+
 struct CFileGZOutputStream::Impl
 {
 	gzFile f{nullptr};
+
+	unsigned int numThreads{1};
+	size_t blockSize{128 * 1024};
+	/** Used instead of "f" in parallel mode */
+	std::shared_ptr<ParallelGzWriter> par;
 };
 
 CFileGZOutputStream::CFileGZOutputStream()
@@ -47,7 +224,26 @@ bool CFileGZOutputStream::open(
 {
 	MRPT_START
 
-	if (m_f->f) gzclose(m_f->f);
+	close();
+
+	if (m_f->numThreads != 1)
+	{
+		ASSERT_ABOVE_(m_f->blockSize, 0U);
+		ASSERT_(compress_level >= 0 && compress_level <= 9);
+		const unsigned int nThreads = m_f->numThreads != 0
+			? m_f->numThreads
+			: std::max(1U, std::thread::hardware_concurrency());
+		m_f->par = std::make_shared<ParallelGzWriter>(
+			nThreads, m_f->blockSize, compress_level);
+		std::string err_msg;
+		if (!m_f->par->open(fileName, err_msg))
+		{
+			m_f->par.reset();
+			if (error_msg) error_msg.value().get() = err_msg;
+			return false;
+		}
+		return true;
+	}
 
 	// Open gz stream:
 	m_f->f = gzopen(fileName.c_str(), format("wb%i", compress_level).c_str());
@@ -58,9 +254,27 @@ bool CFileGZOutputStream::open(
 	MRPT_END
 }
 
-CFileGZOutputStream::~CFileGZOutputStream() { close(); }
+CFileGZOutputStream::~CFileGZOutputStream()
+{
+	// Errors can only be reported from an explicit close():
+	try
+	{
+		close();
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << "[~CFileGZOutputStream] Exception:\n"
+				  << mrpt::exception_to_str(e);
+	}
+}
+
 void CFileGZOutputStream::close()
 {
+	if (m_f->par)
+	{
+		auto par = std::move(m_f->par);
+		par->finish();
+	}
 	if (m_f->f)
 	{
 		gzclose(m_f->f);
@@ -73,8 +287,16 @@ size_t CFileGZOutputStream::Read(void*, size_t)
 	THROW_EXCEPTION("Trying to read from an output file stream.");
 }
 
+void CFileGZOutputStream::setParallelCompression(
+	unsigned int numThreads, size_t blockSize)
+{
+	m_f->numThreads = numThreads;
+	m_f->blockSize = blockSize;
+}
+
 size_t CFileGZOutputStream::Write(const void* Buffer, size_t Count)
 {
+	if (m_f->par) return m_f->par->write(Buffer, Count);
 	if (!m_f->f)
 	{
 		THROW_EXCEPTION("File is not open.");
@@ -84,6 +306,7 @@ size_t CFileGZOutputStream::Write(const void* Buffer, size_t Count)
 
 uint64_t CFileGZOutputStream::getPosition() const
 {
+	if (m_f->par) return m_f->par->position();
 	if (!m_f->f)
 	{
 		THROW_EXCEPTION("File is not open.");
@@ -93,7 +316,7 @@ uint64_t CFileGZOutputStream::getPosition() const
 
 bool CFileGZOutputStream::fileOpenCorrectly() const
 {
-	return m_f->f != nullptr;
+	return m_f->f != nullptr || m_f->par;
 }
 uint64_t CFileGZOutputStream::Seek(int64_t, CStream::TSeekOrigin)
 {
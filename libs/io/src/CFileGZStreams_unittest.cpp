@@ -15,6 +15,7 @@
 #include <mrpt/system/filesystem.h>
 #include <test_mrpt_common.h>
 #include <algorithm>  // std::equal
+#include <fstream>
 
 const size_t tst_data_len = 1000U;
 
@@ -102,3 +103,85 @@ TEST(CFileGZStreams, compareWithTestGZFiles)
 			<< " compress_level:" << compress_level;
 	}
 }
+
+TEST(CFileGZStreams, parallelCompressionAndReadAhead)
+{
+	// Large enough for many blocks, with both compressible and random parts:
+	std::vector<uint8_t> tst_data(300000);
+	mrpt::random::Generator_MT19937 rng;
+	rng.seed(456);
+	for (size_t i = 0; i < tst_data.size(); i++)
+		tst_data[i] = (i / 50000) % 2 ? uint8_t(rng()) : uint8_t(i % 7);
+
+	for (const int compress_level : {0, 1, 9})
+	{
+		const std::string fil = mrpt::system::getTempFileName() + "_par" +
+			std::to_string(compress_level) + ".gz";
+		{
+			mrpt::io::CFileGZOutputStream fil_out;
+			fil_out.setParallelCompression(3, 20000);
+			ASSERT_TRUE(fil_out.open(fil, compress_level));
+			// Writes of several sizes, not aligned with blocks:
+			size_t pos = 0, len = 1;
+			while (pos < tst_data.size())
+			{
+				const size_t n = std::min(len, tst_data.size() - pos);
+				EXPECT_EQ(fil_out.Write(&tst_data[pos], n), n);
+				pos += n;
+				len = len * 3 + 1;
+			}
+			EXPECT_EQ(fil_out.getPosition(), tst_data.size());
+		}
+
+		// It must be a standard gzip file, readable with plain zlib, and
+		// also in read-ahead mode:
+		for (const bool readAhead : {false, true})
+		{
+			mrpt::io::CFileGZInputStream fil_in;
+			fil_in.setReadAhead(readAhead, 10000);
+			ASSERT_TRUE(fil_in.open(fil));
+
+			std::vector<uint8_t> rd_buf(tst_data.size() + 10);
+			size_t pos = 0;
+			for (size_t len = 1;; len = len * 2 + 1)
+			{
+				const size_t n = fil_in.Read(&rd_buf[pos], len);
+				pos += n;
+				if (n < len) break;
+			}
+			EXPECT_EQ(pos, tst_data.size()) << "readAhead:" << readAhead;
+			EXPECT_TRUE(fil_in.checkEOF());
+			EXPECT_TRUE(std::equal(
+				std::begin(tst_data), std::end(tst_data), std::begin(rd_buf)))
+				<< " compress_level:" << compress_level
+				<< " readAhead:" << readAhead;
+		}
+	}
+}
+
+TEST(CFileGZStreams, readAheadOfCorruptFile)
+{
+	std::vector<uint8_t> tst_data;
+	generate_test_data(tst_data);
+
+	const std::string fil = mrpt::system::getTempFileName() + "_bad.gz";
+	{
+		// Uncompressed blocks, so any changed byte breaks the CRC:
+		mrpt::io::CFileGZOutputStream fil_out;
+		ASSERT_TRUE(fil_out.open(fil, 0));
+		fil_out.Write(tst_data.data(), tst_data.size());
+	}
+	{
+		std::fstream f(fil, std::ios::in | std::ios::out | std::ios::binary);
+		f.seekg(mrpt::system::getFileSize(fil) / 2);
+		const char c = static_cast<char>(f.get() ^ 0xFF);
+		f.seekp(mrpt::system::getFileSize(fil) / 2);
+		f.put(c);
+	}
+
+	mrpt::io::CFileGZInputStream fil_in;
+	fil_in.setReadAhead(true, 100);
+	ASSERT_TRUE(fil_in.open(fil));
+	std::vector<uint8_t> rd_buf(tst_data.size() + 10);
+	EXPECT_ANY_THROW(fil_in.Read(rd_buf.data(), rd_buf.size()));
+}
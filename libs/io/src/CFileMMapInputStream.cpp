@@ -0,0 +1,233 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2020, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include "io-precomp.h"  // Precompiled headers
+
+#include <mrpt/core/exceptions.h>
+#include <mrpt/io/CFileMMapInputStream.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>  // strerror, memcpy
+#include <memory>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace mrpt::io;
+
+static_assert(
+	!std::is_copy_constructible_v<CFileMMapInputStream> &&
+		!std::is_copy_assignable_v<CFileMMapInputStream>,
+	"Copy Check");
+
+namespace
+{
+/** A mapped file. It is unmapped upon destruction, so pointers returned by
+ * ReadBorrow() can keep it alive after the stream is closed. */
+struct MappedFile
+{
+#ifdef _WIN32
+	HANDLE file{INVALID_HANDLE_VALUE};
+	HANDLE mapping{nullptr};
+#else
+	int fd{-1};
+#endif
+	void* addr{nullptr};
+	uint64_t length{0};
+
+	MappedFile() = default;
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	~MappedFile()
+	{
+#ifdef _WIN32
+		if (addr) UnmapViewOfFile(addr);
+		if (mapping) CloseHandle(mapping);
+		if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+#else
+		if (addr) ::munmap(addr, length);
+		if (fd >= 0) ::close(fd);
+#endif
+	}
+};
+}  // namespace
+
+struct CFileMMapInputStream::Impl
+{
+	std::shared_ptr<MappedFile> file;
+};
+
+CFileMMapInputStream::CFileMMapInputStream()
+	: m_impl(mrpt::make_impl<CFileMMapInputStream::Impl>())
+{
+}
+
+CFileMMapInputStream::CFileMMapInputStream(const std::string& fileName)
+	: CFileMMapInputStream()
+{
+	MRPT_START
+	std::string err;
+	if (!open(fileName, err))
+		THROW_EXCEPTION_FMT(
+			"Error mapping file '%s': %s", fileName.c_str(), err.c_str());
+	MRPT_END
+}
+
+CFileMMapInputStream::~CFileMMapInputStream() { close(); }
+
+bool CFileMMapInputStream::open(
+	const std::string& fileName, mrpt::optional_ref<std::string> error_msg)
+{
+	MRPT_START
+
+	close();
+
+	auto setError = [&](const std::string& s) {
+		if (error_msg) error_msg.value().get() = s;
+		close();
+		return false;
+	};
+
+	m_impl->file = std::make_shared<MappedFile>();
+	auto& d = *m_impl->file;
+#ifdef _WIN32
+	d.file = CreateFileA(
+		fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (d.file == INVALID_HANDLE_VALUE)
+		return setError(mrpt::format(
+			"Couldn't open the file '%s' (Win32 error code: %u)",
+			fileName.c_str(), static_cast<unsigned>(GetLastError())));
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(d.file, &fileSize))
+		return setError("Couldn't get the file size");
+	d.length = static_cast<uint64_t>(fileSize.QuadPart);
+
+	// Empty files cannot be mapped, but they are valid streams:
+	if (d.length > 0)
+	{
+		d.mapping =
+			CreateFileMappingA(d.file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!d.mapping)
+			return setError(mrpt::format(
+				"CreateFileMapping() failed (Win32 error code: %u)",
+				static_cast<unsigned>(GetLastError())));
+		d.addr = MapViewOfFile(d.mapping, FILE_MAP_READ, 0, 0, 0);
+		if (!d.addr)
+			return setError(mrpt::format(
+				"MapViewOfFile() failed (Win32 error code: %u)",
+				static_cast<unsigned>(GetLastError())));
+	}
+#else
+	d.fd = ::open(fileName.c_str(), O_RDONLY);
+	if (d.fd < 0) return setError(std::string(strerror(errno)));
+
+	struct stat st;
+	if (::fstat(d.fd, &st) != 0)
+		return setError(std::string(strerror(errno)));
+	d.length = static_cast<uint64_t>(st.st_size);
+
+	// Empty files cannot be mapped, but they are valid streams:
+	if (d.length > 0)
+	{
+		void* addr = ::mmap(nullptr, d.length, PROT_READ, MAP_SHARED, d.fd, 0);
+		if (addr == MAP_FAILED)
+			return setError(std::string(strerror(errno)));
+		d.addr = addr;
+	}
+#endif
+
+	m_data = static_cast<const uint8_t*>(d.addr);
+	m_size = d.length;
+	m_position = 0;
+	return true;
+
+	MRPT_END
+}
+
+void CFileMMapInputStream::close()
+{
+	m_impl->file.reset();
+	m_data = nullptr;
+	m_size = 0;
+	m_position = 0;
+}
+
+bool CFileMMapInputStream::fileOpenCorrectly() const
+{
+	return m_impl->file != nullptr;
+}
+
+size_t CFileMMapInputStream::Read(void* Buffer, size_t Count)
+{
+	if (!m_impl->file) THROW_EXCEPTION("File is not open.");
+
+	const size_t nToRead = static_cast<size_t>(
+		std::min<uint64_t>(Count, m_size - std::min(m_position, m_size)));
+	if (nToRead > 0) std::memcpy(Buffer, m_data + m_position, nToRead);
+	m_position += nToRead;
+	return nToRead;
+}
+
+std::shared_ptr<const uint8_t> CFileMMapInputStream::ReadBorrow(size_t Count)
+{
+	if (!m_impl->file || !Count || m_position + Count > m_size) return {};
+	const uint8_t* p = m_data + m_position;
+	m_position += Count;
+	// Aliasing constructor: keeps the file mapped while "p" is in use
+	return std::shared_ptr<const uint8_t>(m_impl->file, p);
+}
+
+size_t CFileMMapInputStream::Write(
+	[[maybe_unused]] const void* Buffer, [[maybe_unused]] size_t Count)
+{
+	THROW_EXCEPTION("Trying to write to an input file stream.");
+}
+
+uint64_t CFileMMapInputStream::Seek(int64_t off, CStream::TSeekOrigin origin)
+{
+	if (!m_impl->file) THROW_EXCEPTION("File is not open.");
+
+	int64_t newPos = 0;
+	switch (origin)
+	{
+		case sFromBeginning:
+			newPos = off;
+			break;
+		case sFromCurrent:
+			newPos = static_cast<int64_t>(m_position) + off;
+			break;
+		case sFromEnd:
+			newPos = static_cast<int64_t>(m_size) + off;
+			break;
+	};
+	// Clamp to the valid range [0,size]:
+	m_position = static_cast<uint64_t>(
+		std::clamp<int64_t>(newPos, 0, static_cast<int64_t>(m_size)));
+	return m_position;
+}
+
+uint64_t CFileMMapInputStream::getTotalBytesCount() const
+{
+	if (!m_impl->file) THROW_EXCEPTION("File is not open.");
+	return m_size;
+}
+
+uint64_t CFileMMapInputStream::getPosition() const
+{
+	if (!m_impl->file) THROW_EXCEPTION("File is not open.");
+	return m_position;
+}
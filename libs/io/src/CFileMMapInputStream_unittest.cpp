@@ -0,0 +1,98 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2020, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include <gtest/gtest.h>
+#include <mrpt/io/CFileMMapInputStream.h>
+#include <mrpt/io/CFileOutputStream.h>
+#include <mrpt/system/filesystem.h>
+#include <cstring>
+#include <vector>
+
+TEST(CFileMMapInputStream, readAndSeek)
+{
+	std::vector<uint8_t> tst_data(100000);
+	for (size_t i = 0; i < tst_data.size(); i++)
+		tst_data[i] = static_cast<uint8_t>(i * 7 + (i >> 8));
+
+	const std::string fil = mrpt::system::getTempFileName();
+	{
+		mrpt::io::CFileOutputStream fo(fil);
+		fo.Write(tst_data.data(), tst_data.size());
+	}
+
+	mrpt::io::CFileMMapInputStream fi;
+	ASSERT_TRUE(fi.open(fil));
+	EXPECT_EQ(fi.getTotalBytesCount(), tst_data.size());
+	ASSERT_TRUE(fi.data() != nullptr);
+	EXPECT_EQ(0, std::memcmp(fi.data(), tst_data.data(), tst_data.size()));
+
+	// Sequential reads:
+	std::vector<uint8_t> buf(1000);
+	EXPECT_EQ(fi.Read(buf.data(), buf.size()), buf.size());
+	EXPECT_EQ(0, std::memcmp(buf.data(), tst_data.data(), buf.size()));
+	EXPECT_EQ(fi.getPosition(), buf.size());
+
+	// Random access, and reads past the end:
+	EXPECT_EQ(fi.Seek(99500), 99500U);
+	EXPECT_EQ(fi.Read(buf.data(), buf.size()), 500U);
+	EXPECT_EQ(0, std::memcmp(buf.data(), &tst_data[99500], 500));
+	EXPECT_TRUE(fi.checkEOF());
+	EXPECT_EQ(fi.Read(buf.data(), buf.size()), 0U);
+
+	using mrpt::io::CStream;
+	EXPECT_EQ(fi.Seek(-10, CStream::sFromEnd), tst_data.size() - 10);
+	EXPECT_EQ(fi.Seek(-5, CStream::sFromCurrent), tst_data.size() - 15);
+
+	fi.close();
+	EXPECT_FALSE(fi.fileOpenCorrectly());
+	EXPECT_TRUE(fi.data() == nullptr);
+
+	// Empty files are valid streams:
+	{
+		mrpt::io::CFileOutputStream fo(fil);
+	}
+	ASSERT_TRUE(fi.open(fil));
+	EXPECT_EQ(fi.getTotalBytesCount(), 0U);
+	EXPECT_EQ(fi.Read(buf.data(), buf.size()), 0U);
+
+	// Non-existing files:
+	std::string errMsg;
+	EXPECT_FALSE(fi.open(fil + "_does_not_exist", errMsg));
+	EXPECT_FALSE(errMsg.empty());
+}
+
+TEST(CFileMMapInputStream, readBorrow)
+{
+	std::vector<uint8_t> tst_data(5000);
+	for (size_t i = 0; i < tst_data.size(); i++)
+		tst_data[i] = static_cast<uint8_t>(i * 3);
+
+	const std::string fil = mrpt::system::getTempFileName();
+	{
+		mrpt::io::CFileOutputStream fo(fil);
+		fo.Write(tst_data.data(), tst_data.size());
+	}
+
+	std::shared_ptr<const uint8_t> p;
+	{
+		mrpt::io::CFileMMapInputStream fi(fil);
+		fi.Seek(1000);
+		p = fi.ReadBorrow(3000);
+		ASSERT_TRUE(p != nullptr);
+		// No copies:
+		EXPECT_EQ(p.get(), fi.data() + 1000);
+		EXPECT_EQ(fi.getPosition(), 4000U);
+
+		// Not enough data: nothing is read
+		EXPECT_TRUE(fi.ReadBorrow(1001) == nullptr);
+		EXPECT_EQ(fi.getPosition(), 4000U);
+	}
+	// The mapping outlives the stream:
+	EXPECT_EQ(0, std::memcmp(p.get(), &tst_data[1000], 3000));
+}
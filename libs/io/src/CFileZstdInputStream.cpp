@@ -0,0 +1,362 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2020, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include "io-precomp.h"  // Precompiled headers
+
+#include <mrpt/config.h>
+#include <mrpt/core/exceptions.h>
+#include <mrpt/io/CFileInputStream.h>
+#include <mrpt/io/CFileZstdInputStream.h>
+#include <mrpt/system/filesystem.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <vector>
+
+#if MRPT_HAS_ZSTD
+#include <zstd.h>
+#endif
+
+using namespace mrpt::io;
+using namespace std;
+
+static_assert(
+	!std::is_copy_constructible_v<CFileZstdInputStream> &&
+		!std::is_copy_assignable_v<CFileZstdInputStream>,
+	"Copy Check");
+
+namespace
+{
+uint32_t get_uint32_le(const uint8_t* p)
+{
+	return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) |
+		(uint32_t(p[3]) << 24);
+}
+}  // namespace
+
+struct CFileZstdInputStream::Impl
+{
+	/** Not a CFileInputStream, since we need partial reads */
+	std::shared_ptr<std::ifstream> in;
+	/** Compressed file size */
+	uint64_t fileSize{0};
+#if MRPT_HAS_ZSTD
+	ZSTD_DCtx* dctx{nullptr};
+	/** Compressed data read from the file, not decompressed yet */
+	std::vector<uint8_t> inBuf;
+	size_t inPos{0}, inLen{0};
+	bool endOfFile{false};
+	/** Decompressed data, not returned by Read() yet */
+	std::vector<uint8_t> outBuf;
+	size_t outPos{0}, outLen{0};
+	/** Position in the uncompressed data */
+	uint64_t position{0};
+	/** Compressed and uncompressed offsets of each frame (plus one last
+	 * entry with the total sizes), if the file has a seek table. */
+	std::vector<uint64_t> frameCompOff, frameDecompOff;
+
+	/** Decompresses more data into outBuf. Returns false at the end of
+	 * file. */
+	bool decompressMore()
+	{
+		for (;;)
+		{
+			if (inPos == inLen && !endOfFile)
+			{
+				in->read(
+					reinterpret_cast<char*>(inBuf.data()), inBuf.size());
+				inLen = static_cast<size_t>(in->gcount());
+				inPos = 0;
+				if (!inLen) endOfFile = true;
+			}
+			ZSTD_inBuffer ib{inBuf.data(), inLen, inPos};
+			ZSTD_outBuffer ob{outBuf.data(), outBuf.size(), 0};
+			const size_t r = ZSTD_decompressStream(dctx, &ob, &ib);
+			if (ZSTD_isError(r))
+				THROW_EXCEPTION_FMT(
+					"Error decompressing zstd data: %s", ZSTD_getErrorName(r));
+			inPos = ib.pos;
+			outPos = 0;
+			outLen = ob.pos;
+			if (outLen) return true;
+			if (inPos == inLen && endOfFile) return false;
+		}
+	}
+
+	/** Reads (or just skips, if buffer is nullptr) uncompressed data */
+	size_t read(void* buffer, size_t count)
+	{
+		auto out = reinterpret_cast<uint8_t*>(buffer);
+		size_t done = 0;
+		while (done < count)
+		{
+			if (outPos == outLen && !decompressMore()) break;
+			const size_t n = std::min(count - done, outLen - outPos);
+			if (out) std::memcpy(out + done, &outBuf[outPos], n);
+			outPos += n;
+			done += n;
+		}
+		position += done;
+		return done;
+	}
+
+	/** Restarts decompression at the given compressed offset, which must be
+	 * the beginning of a frame, and which corresponds to the given position
+	 * in the uncompressed data. */
+	void restartAt(uint64_t compOff, uint64_t decompOff)
+	{
+		in->clear();
+		in->seekg(compOff);
+		ZSTD_DCtx_reset(dctx, ZSTD_reset_session_only);
+		inPos = inLen = outPos = outLen = 0;
+		endOfFile = false;
+		position = decompOff;
+	}
+
+	bool readAt(uint64_t offset, uint8_t* buf, size_t count)
+	{
+		in->clear();
+		in->seekg(offset);
+		in->read(reinterpret_cast<char*>(buf), count);
+		return static_cast<size_t>(in->gcount()) == count;
+	}
+
+	/** Loads the seek table at the end of the file, if it exists and is
+	 * consistent with the file size. */
+	void loadSeekTable()
+	{
+		frameCompOff.clear();
+		frameDecompOff.clear();
+		constexpr uint64_t footerSize = 9, headerSize = 8;
+		if (fileSize < footerSize + headerSize) return;
+
+		uint8_t footer[footerSize];
+		if (!readAt(fileSize - footerSize, footer, footerSize) ||
+			get_uint32_le(footer + 5) != 0x8F92EAB1)
+			return;
+		const uint64_t nFrames = get_uint32_le(footer);
+		const uint8_t descriptor = footer[4];
+		if (descriptor & 0x7c) return;  // reserved bits
+		const uint64_t entrySize = (descriptor & 0x80) ? 12 : 8;
+		const uint64_t frameSize = nFrames * entrySize + footerSize;
+		if (frameSize + headerSize > fileSize) return;
+
+		std::vector<uint8_t> table(frameSize + headerSize);
+		if (!readAt(fileSize - table.size(), table.data(), table.size()) ||
+			get_uint32_le(&table[0]) != 0x184D2A5E ||
+			get_uint32_le(&table[4]) != frameSize)
+			return;
+
+		std::vector<uint64_t> c(1, 0), d(1, 0);
+		for (uint64_t i = 0; i < nFrames; i++)
+		{
+			const uint8_t* e = &table[headerSize + i * entrySize];
+			c.push_back(c.back() + get_uint32_le(e));
+			d.push_back(d.back() + get_uint32_le(e + 4));
+		}
+		// The seek table must immediately follow the last frame:
+		if (c.back() != fileSize - table.size()) return;
+		frameCompOff = std::move(c);
+		frameDecompOff = std::move(d);
+	}
+#endif
+};
+
+CFileZstdInputStream::CFileZstdInputStream()
+	: m_f(mrpt::make_impl<CFileZstdInputStream::Impl>())
+{
+}
+
+CFileZstdInputStream::CFileZstdInputStream(const string& fileName)
+	: CFileZstdInputStream()
+{
+	MRPT_START
+	std::string err;
+	if (!open(fileName, err))
+		THROW_EXCEPTION_FMT(
+			"Error trying to open file: '%s', error: '%s'", fileName.c_str(),
+			err.c_str());
+	MRPT_END
+}
+
+CFileZstdInputStream::~CFileZstdInputStream() { close(); }
+
+bool CFileZstdInputStream::isZstdFile(const std::string& fileName)
+{
+	CFileInputStream f;
+	uint8_t magic[4];
+	if (!f.open(fileName) || f.Read(magic, sizeof(magic)) != sizeof(magic))
+		return false;
+	const uint32_t m = get_uint32_le(magic);
+	return m == 0xFD2FB528 ||  // zstd frame
+		(m & 0xFFFFFFF0) == 0x184D2A50;  // skippable frame
+}
+
+bool CFileZstdInputStream::open(
+	const std::string& fileName, mrpt::optional_ref<std::string> error_msg)
+{
+	MRPT_START
+
+	close();
+
+	if (!isZstdFile(fileName))
+	{
+		if (error_msg)
+			error_msg.value().get() = mrpt::format(
+				"Couldn't open '%s' as a zstd file", fileName.c_str());
+		return false;
+	}
+
+#if MRPT_HAS_ZSTD
+	auto& f = *m_f;
+	f.fileSize = mrpt::system::getFileSize(fileName);
+	f.in = std::make_shared<std::ifstream>(
+		fileName, std::ios_base::in | std::ios_base::binary);
+	if (!f.in->is_open())
+	{
+		if (error_msg)
+			error_msg.value().get() =
+				mrpt::format("Couldn't access the file '%s'", fileName.c_str());
+		f.in.reset();
+		return false;
+	}
+	f.dctx = ZSTD_createDCtx();
+	ASSERT_(f.dctx != nullptr);
+	f.inBuf.resize(ZSTD_DStreamInSize());
+	f.outBuf.resize(ZSTD_DStreamOutSize());
+	f.loadSeekTable();
+	f.restartAt(0, 0);
+	return true;
+#else
+	if (error_msg)
+		error_msg.value().get() = "MRPT was built without zstd support";
+	return false;
+#endif
+
+	MRPT_END
+}
+
+void CFileZstdInputStream::close()
+{
+#if MRPT_HAS_ZSTD
+	if (!m_f->in) return;
+	m_f->in.reset();
+	ZSTD_freeDCtx(m_f->dctx);
+	m_f->dctx = nullptr;
+	m_f->inBuf = std::vector<uint8_t>();
+	m_f->outBuf = std::vector<uint8_t>();
+	m_f->frameCompOff.clear();
+	m_f->frameDecompOff.clear();
+#endif
+}
+
+size_t CFileZstdInputStream::Read(void* Buffer, size_t Count)
+{
+	if (!m_f->in) THROW_EXCEPTION("File is not open.");
+#if MRPT_HAS_ZSTD
+	return m_f->read(Buffer, Count);
+#else
+	(void)Buffer;
+	(void)Count;
+	return 0;
+#endif
+}
+
+size_t CFileZstdInputStream::Write(
+	[[maybe_unused]] const void* Buffer, [[maybe_unused]] size_t Count)
+{
+	THROW_EXCEPTION("Trying to write to an input file stream.");
+}
+
+uint64_t CFileZstdInputStream::getTotalBytesCount() const
+{
+	if (!m_f->in) THROW_EXCEPTION("File is not open.");
+	return m_f->fileSize;
+}
+
+uint64_t CFileZstdInputStream::getPosition() const
+{
+	if (!m_f->in) THROW_EXCEPTION("File is not open.");
+#if MRPT_HAS_ZSTD
+	return m_f->position;
+#else
+	return 0;
+#endif
+}
+
+bool CFileZstdInputStream::fileOpenCorrectly() const
+{
+	return m_f->in != nullptr;
+}
+
+bool CFileZstdInputStream::isSeekable() const
+{
+#if MRPT_HAS_ZSTD
+	return m_f->in && !m_f->frameDecompOff.empty();
+#else
+	return false;
+#endif
+}
+
+bool CFileZstdInputStream::checkEOF()
+{
+	if (!m_f->in) return true;
+#if MRPT_HAS_ZSTD
+	return m_f->outPos == m_f->outLen && !m_f->decompressMore();
+#else
+	return true;
+#endif
+}
+
+uint64_t CFileZstdInputStream::Seek(int64_t off, CStream::TSeekOrigin org)
+{
+	MRPT_START
+	if (!m_f->in) THROW_EXCEPTION("File is not open.");
+#if MRPT_HAS_ZSTD
+	auto& f = *m_f;
+	int64_t target = off;
+	switch (org)
+	{
+		case sFromBeginning:
+			break;
+		case sFromCurrent:
+			target += static_cast<int64_t>(f.position);
+			break;
+		case sFromEnd:
+			ASSERTMSG_(
+				isSeekable(), "sFromEnd requires a zstd file with seek table");
+			target += static_cast<int64_t>(f.frameDecompOff.back());
+			break;
+	};
+	ASSERT_GE_(target, 0);
+	const auto pos = static_cast<uint64_t>(target);
+
+	if (isSeekable())
+	{
+		// Frame containing the target position (or the seek table itself,
+		// if the target is at or past the end):
+		const auto& d = f.frameDecompOff;
+		const size_t k = (std::upper_bound(d.begin(), d.end(), pos) -
+						  d.begin()) - 1;
+		if (f.position < d[k] || f.position > pos)
+			f.restartAt(f.frameCompOff[k], d[k]);
+	}
+	else if (f.position > pos)
+		f.restartAt(0, 0);
+
+	f.read(nullptr, pos - f.position);
+	return f.position;
+#else
+	(void)off;
+	(void)org;
+	return 0;
+#endif
+	MRPT_END
+}
@@ -0,0 +1,221 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2020, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include "io-precomp.h"  // Precompiled headers
+
+#include <mrpt/config.h>
+#include <mrpt/core/exceptions.h>
+#include <mrpt/io/CFileOutputStream.h>
+#include <mrpt/io/CFileZstdOutputStream.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>  // strerror
+#include <iostream>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#if MRPT_HAS_ZSTD
+#include <zstd.h>
+#endif
+
+using namespace mrpt::io;
+using namespace std;
+
+struct CFileZstdOutputStream::Impl
+{
+	size_t frameSize{1024 * 1024};
+	std::shared_ptr<CFileOutputStream> out;
+#if MRPT_HAS_ZSTD
+	ZSTD_CCtx* cctx{nullptr};
+	int level{3};
+	/** Uncompressed data of the current frame */
+	std::vector<uint8_t> buf;
+	std::vector<uint8_t> compressed;
+	/** Compressed and uncompressed size of each frame written so far */
+	std::vector<std::pair<uint32_t, uint32_t>> seekTable;
+	uint64_t position{0};
+
+	void writeFrame()
+	{
+		if (buf.empty()) return;
+		compressed.resize(ZSTD_compressBound(buf.size()));
+		const size_t n = ZSTD_compressCCtx(
+			cctx, compressed.data(), compressed.size(), buf.data(),
+			buf.size(), level);
+		if (ZSTD_isError(n))
+			THROW_EXCEPTION_FMT(
+				"Error compressing data: %s", ZSTD_getErrorName(n));
+		out->Write(compressed.data(), n);
+		seekTable.emplace_back(
+			static_cast<uint32_t>(n), static_cast<uint32_t>(buf.size()));
+		buf.clear();
+	}
+
+	/** Appends the seek table, as a skippable frame. See the zstd "seekable
+	 * format" specification. */
+	void writeSeekTable()
+	{
+		std::vector<uint8_t> t;
+		auto put32 = [&t](uint32_t v) {
+			for (int i = 0; i < 4; i++) t.push_back((v >> (8 * i)) & 0xff);
+		};
+		const auto nFrames = static_cast<uint32_t>(seekTable.size());
+		put32(0x184D2A5E);  // skippable frame magic
+		put32(nFrames * 8 + 9);  // frame size
+		for (const auto& e : seekTable)
+		{
+			put32(e.first);
+			put32(e.second);
+		}
+		put32(nFrames);
+		t.push_back(0);  // descriptor: no checksums
+		put32(0x8F92EAB1);  // seekable format magic
+		out->Write(t.data(), t.size());
+	}
+#endif
+};
+
+CFileZstdOutputStream::CFileZstdOutputStream(const std::string& fileName)
+	: CFileZstdOutputStream()
+{
+	MRPT_START
+	std::string err;
+	if (!open(fileName, 3, err))
+		THROW_EXCEPTION_FMT(
+			"Error trying to open file: '%s', error: '%s'", fileName.c_str(),
+			err.c_str());
+	MRPT_END
+}
+
+CFileZstdOutputStream::CFileZstdOutputStream()
+	: m_f(mrpt::make_impl<CFileZstdOutputStream::Impl>())
+{
+}
+
+bool CFileZstdOutputStream::open(
+	const std::string& fileName, int compress_level,
+	mrpt::optional_ref<std::string> error_msg)
+{
+	MRPT_START
+
+	close();
+
+#if MRPT_HAS_ZSTD
+	m_f->out = std::make_shared<CFileOutputStream>();
+	if (!m_f->out->open(fileName))
+	{
+		if (error_msg) error_msg.value().get() = std::string(strerror(errno));
+		m_f->out.reset();
+		return false;
+	}
+	m_f->cctx = ZSTD_createCCtx();
+	ASSERT_(m_f->cctx != nullptr);
+	m_f->level = compress_level;
+	m_f->buf.reserve(m_f->frameSize);
+	m_f->seekTable.clear();
+	m_f->position = 0;
+	return true;
+#else
+	(void)fileName;
+	(void)compress_level;
+	if (error_msg)
+		error_msg.value().get() = "MRPT was built without zstd support";
+	return false;
+#endif
+
+	MRPT_END
+}
+
+void CFileZstdOutputStream::close()
+{
+#if MRPT_HAS_ZSTD
+	if (!m_f->out) return;
+	m_f->writeFrame();
+	m_f->writeSeekTable();
+	m_f->out.reset();
+	ZSTD_freeCCtx(m_f->cctx);
+	m_f->cctx = nullptr;
+	m_f->buf = std::vector<uint8_t>();
+	m_f->compressed = std::vector<uint8_t>();
+#endif
+}
+
+CFileZstdOutputStream::~CFileZstdOutputStream()
+{
+	// Errors can only be reported from an explicit close():
+	try
+	{
+		close();
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << "[~CFileZstdOutputStream] Exception:\n"
+				  << mrpt::exception_to_str(e);
+	}
+}
+
+void CFileZstdOutputStream::setFrameSize(size_t maxFrameSize)
+{
+	// Sizes in the seek table are 32-bit:
+	ASSERT_(maxFrameSize > 0 && maxFrameSize < (size_t(1) << 30));
+	m_f->frameSize = maxFrameSize;
+}
+
+size_t CFileZstdOutputStream::Read(
+	[[maybe_unused]] void* Buffer, [[maybe_unused]] size_t Count)
+{
+	THROW_EXCEPTION("Cannot read from an output file stream.");
+}
+
+size_t CFileZstdOutputStream::Write(const void* Buffer, size_t Count)
+{
+	if (!m_f->out) THROW_EXCEPTION("File is not open.");
+#if MRPT_HAS_ZSTD
+	auto in = reinterpret_cast<const uint8_t*>(Buffer);
+	size_t done = 0;
+	while (done < Count)
+	{
+		const size_t n =
+			std::min(Count - done, m_f->frameSize - m_f->buf.size());
+		m_f->buf.insert(m_f->buf.end(), in + done, in + done + n);
+		done += n;
+		if (m_f->buf.size() == m_f->frameSize) m_f->writeFrame();
+	}
+	m_f->position += Count;
+#else
+	(void)Buffer;
+#endif
+	return Count;
+}
+
+uint64_t CFileZstdOutputStream::getPosition() const
+{
+	if (!m_f->out) THROW_EXCEPTION("File is not open.");
+#if MRPT_HAS_ZSTD
+	return m_f->position;
+#else
+	return 0;
+#endif
+}
+
+bool CFileZstdOutputStream::fileOpenCorrectly() const
+{
+	return m_f->out != nullptr;
+}
+
+uint64_t CFileZstdOutputStream::Seek(int64_t, CStream::TSeekOrigin)
+{
+	THROW_EXCEPTION("Method not available in this class.");
+}
+
+uint64_t CFileZstdOutputStream::getTotalBytesCount() const
+{
+	THROW_EXCEPTION("Method not available in this class.");
+}
@@ -0,0 +1,135 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2020, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include <gtest/gtest.h>
+#include <mrpt/config.h>
+#include <mrpt/io/CFileGZInputStream.h>
+#include <mrpt/io/CFileGZOutputStream.h>
+#include <mrpt/io/CFileZstdInputStream.h>
+#include <mrpt/io/CFileZstdOutputStream.h>
+#include <mrpt/system/filesystem.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#if MRPT_HAS_ZSTD
+
+static std::vector<uint8_t> test_data()
+{
+	std::vector<uint8_t> d(100000);
+	for (size_t i = 0; i < d.size(); i++)
+		d[i] = static_cast<uint8_t>((i * 7 + (i >> 10)) % 13);
+	return d;
+}
+
+TEST(CFileZstdStreams, readWriteAndSeek)
+{
+	const auto tst_data = test_data();
+	const std::string fil = mrpt::system::getTempFileName();
+	{
+		mrpt::io::CFileZstdOutputStream fo;
+		fo.setFrameSize(8192);
+		ASSERT_TRUE(fo.open(fil, 5));
+		// Write in pieces which do not match the frame size:
+		for (size_t i = 0; i < tst_data.size(); i += 3000)
+			fo.Write(
+				&tst_data[i], std::min<size_t>(3000, tst_data.size() - i));
+		EXPECT_EQ(fo.getPosition(), tst_data.size());
+	}
+	EXPECT_TRUE(mrpt::io::CFileZstdInputStream::isZstdFile(fil));
+
+	mrpt::io::CFileZstdInputStream fi;
+	ASSERT_TRUE(fi.open(fil));
+	EXPECT_TRUE(fi.isSeekable());
+	EXPECT_LT(fi.getTotalBytesCount(), tst_data.size() / 4);
+
+	std::vector<uint8_t> buf(tst_data.size() + 10);
+	EXPECT_EQ(fi.Read(buf.data(), buf.size()), tst_data.size());
+	EXPECT_EQ(0, std::memcmp(buf.data(), tst_data.data(), tst_data.size()));
+	EXPECT_TRUE(fi.checkEOF());
+
+	// Random access, backwards and forwards, within and across frames:
+	using mrpt::io::CStream;
+	for (const size_t pos : {50000U, 100U, 8190U, 8300U, 99990U, 0U})
+	{
+		EXPECT_EQ(fi.Seek(pos), pos);
+		const size_t n = std::min<size_t>(1000, tst_data.size() - pos);
+		ASSERT_EQ(fi.Read(buf.data(), 1000), n);
+		EXPECT_EQ(0, std::memcmp(buf.data(), &tst_data[pos], n)) << pos;
+	}
+	EXPECT_EQ(fi.Seek(-10, CStream::sFromEnd), tst_data.size() - 10);
+	EXPECT_EQ(fi.Seek(-5, CStream::sFromCurrent), tst_data.size() - 15);
+	EXPECT_EQ(fi.Read(buf.data(), buf.size()), 15U);
+	EXPECT_EQ(0, std::memcmp(buf.data(), &tst_data[tst_data.size() - 15], 15));
+	fi.close();
+
+	// CFileGZInputStream transparently reads zstd files:
+	for (const bool readAhead : {false, true})
+	{
+		mrpt::io::CFileGZInputStream gz;
+		gz.setReadAhead(readAhead, 10000);
+		ASSERT_TRUE(gz.open(fil));
+		std::vector<uint8_t> buf2(tst_data.size());
+		EXPECT_EQ(gz.Read(buf2.data(), buf2.size()), tst_data.size());
+		EXPECT_TRUE(buf2 == tst_data);
+		EXPECT_TRUE(gz.checkEOF());
+	}
+
+	// Empty files:
+	{
+		mrpt::io::CFileZstdOutputStream fo(fil);
+	}
+	ASSERT_TRUE(fi.open(fil));
+	EXPECT_TRUE(fi.isSeekable());
+	EXPECT_EQ(fi.Read(buf.data(), buf.size()), 0U);
+	EXPECT_TRUE(fi.checkEOF());
+}
+
+TEST(CFileZstdStreams, corruptFrame)
+{
+	const auto tst_data = test_data();
+	const std::string fil = mrpt::system::getTempFileName();
+	{
+		mrpt::io::CFileZstdOutputStream fo(fil);
+		fo.Write(tst_data.data(), tst_data.size());
+	}
+	{
+		// A frame header with its reserved bit set:
+		const uint8_t bad[] = {0x28, 0xB5, 0x2F, 0xFD, 0x08, 0, 0, 0, 0, 0};
+		std::ofstream f(fil, std::ios::binary | std::ios::app);
+		f.write(reinterpret_cast<const char*>(bad), sizeof(bad));
+	}
+
+	for (const bool readAhead : {false, true})
+	{
+		mrpt::io::CFileGZInputStream gz;
+		gz.setReadAhead(readAhead, 10000);
+		ASSERT_TRUE(gz.open(fil));
+		std::vector<uint8_t> buf(tst_data.size() + 10);
+		EXPECT_ANY_THROW(gz.Read(buf.data(), buf.size())) << readAhead;
+	}
+}
+
+#endif
+
+TEST(CFileZstdStreams, notZstdFiles)
+{
+	const std::string fil = mrpt::system::getTempFileName();
+	{
+		mrpt::io::CFileGZOutputStream fo(fil);
+		fo.Write("hello", 5);
+	}
+	EXPECT_FALSE(mrpt::io::CFileZstdInputStream::isZstdFile(fil));
+	std::string errMsg;
+	mrpt::io::CFileZstdInputStream fi;
+	EXPECT_FALSE(fi.open(fil, errMsg));
+	EXPECT_FALSE(errMsg.empty());
+	EXPECT_FALSE(fi.fileOpenCorrectly());
+}
@@ -100,6 +100,16 @@ size_t CMemoryStream::Read(void* Buffer, size_t Count)
 	return nToRead;
 }
 
+std::shared_ptr<const uint8_t> CMemoryStream::ReadBorrow(size_t Count)
+{
+	if (!Count || m_position + Count > m_bytesWritten) return {};
+	const auto* p =
+		reinterpret_cast<const uint8_t*>(m_memory.get()) + m_position;
+	m_position += Count;
+	// Aliasing constructor, with an empty owner:
+	return std::shared_ptr<const uint8_t>(std::shared_ptr<void>(), p);
+}
+
 size_t CMemoryStream::Write(const void* Buffer, size_t Count)
 {
 	ASSERT_(Buffer != nullptr);
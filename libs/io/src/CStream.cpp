@@ -24,6 +24,12 @@ using namespace mrpt::io;
 using namespace std;
 
 CStream::~CStream() = default;
+std::shared_ptr<const uint8_t> CStream::ReadBorrow(
+	[[maybe_unused]] size_t Count)
+{
+	return {};
+}
+
 /*---------------------------------------------------------------
 			Writes an elemental data type to stream.
  ---------------------------------------------------------------*/
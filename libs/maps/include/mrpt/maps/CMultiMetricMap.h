@@ -210,6 +210,10 @@ class CMultiMetricMap : public mrpt::maps::CMetricMap
 	void saveMetricMapRepresentationToFile(
 		const std::string& filNamePrefix) const override;
 	void auxParticleFilterCleanUp() override;
+	bool prepareForConcurrentLikelihood(
+		const mrpt::obs::CSensoryFrame& sf,
+		const mrpt::math::TPoint3D& posesMin,
+		const mrpt::math::TPoint3D& posesMax) override;
 	void getAs3DObject(mrpt::opengl::CSetOfObjects::Ptr& outObj) const override;
 	const mrpt::maps::CSimplePointsMap* getAsSimplePointsMap() const override;
 
@@ -74,6 +74,7 @@ class COccupancyGridMap2D
    protected:
 	friend class CMultiMetricMap;
 	friend class CMultiMetricMapPDF;
+	friend class CTiledOccupancyGridMap2D;
 
 	/** Frees the dynamic memory buffers of map. */
 	void freeMap();
@@ -94,6 +95,10 @@ class COccupancyGridMap2D
 	 * (see TLikelihoodOptions::enableLikelihoodCache). */
 	std::vector<double> precomputedLikelihood;
 	bool m_likelihoodCacheOutDated{true};
+	/** Set by prepareForConcurrentLikelihood(): until the cache is outdated,
+	 * cells missing in precomputedLikelihood are not stored on evaluation,
+	 * since other threads may be reading it. */
+	bool m_likelihoodCacheConcurrent{false};
 
 	/** Used for Voronoi calculation.Same struct as "map", but contains a "0" if
 	 * not a basis point. */
@@ -179,6 +184,9 @@ class COccupancyGridMap2D
 	double computeObservationLikelihood_likelihoodField_II(
 		const mrpt::obs::CObservation& obs,
 		const mrpt::poses::CPose2D& takenFrom);
+	/** Internal: evaluates the likelihood field (lmLikelihoodField_Thrun)
+	 * of one cell, without using the cache. */
+	double computeLikelihoodField_Thrun_cell(int cx, int cy) const;
 
 	/** Clear the map: It set all cells to their default occupancy value (0.5),
 	 * without changing the resolution (the grid extension is reset to the
@@ -523,6 +531,15 @@ class COccupancyGridMap2D
 		/** Enabled: Rays widen with distance to approximate the real behavior
 		 * of lasers, disabled: insert rays as simple lines (Default=false) */
 		bool wideningBeamsWithDistance{false};
+		/** (Default=1) Number of threads for inserting 2D range scans as
+		 * simple rays (i.e. with wideningBeamsWithDistance=false). Beams are
+		 * split into angular sectors, ray-cast in parallel into per-thread
+		 * lists of cell updates, which are then applied in parallel by bands
+		 * of rows. 0 means as many threads as hardware cores. Only worth for
+		 * scans with many beams (e.g. >1000): at least 128 beams are assigned
+		 * to each thread. The resulting map does not depend on this value.
+		 * \note (New in MRPT 2.1.0) */
+		unsigned int numThreads{1};
 	};
 
 	/** With this struct options are provided to the observation insertion
@@ -928,6 +945,52 @@ class COccupancyGridMap2D
 		const CPointsMap* pm,
 		const mrpt::poses::CPose2D* relativePose = nullptr);
 
+	/** Evaluates computeLikelihoodField_Thrun() for one set of points (in
+	 * local coordinates) and many candidate poses at once, e.g. for scoring
+	 * all the particles of a PF, or the hypotheses of a scan matcher.
+	 * Points are decimated and converted into a compact layout only once, then
+	 * all poses are evaluated with SIMD-optimized kernels (SSE2/AVX2, selected
+	 * at runtime) to transform points and fetch the likelihood field values.
+	 * Results are equal to those of computeLikelihoodField_Thrun() up to
+	 * floating point rounding.
+	 *
+	 * \param[in] pm The points map, in local coordinates.
+	 * \param[in] poses The candidate poses of the points map in this map's
+	 * coordinates.
+	 * \param[out] out_log_liks The log-likelihood for each pose.
+	 * \note Only the default product of likelihoods with the likelihood cache
+	 * enabled is vectorized. Other configurations fall back to calling
+	 * computeLikelihoodField_Thrun() for each pose.
+	 * \note (New in MRPT 2.1.0)
+	 */
+	void computeLikelihoodField_Thrun(
+		const CPointsMap* pm, const std::vector<mrpt::math::TPose2D>& poses,
+		std::vector<double>& out_log_liks);
+
+	/** Computes the log-likelihood of one observation for many candidate
+	 * robot poses. For 2D range scans and the lmLikelihoodField_Thrun
+	 * method, the batch, vectorized computeLikelihoodField_Thrun() is used.
+	 * Otherwise, this is equivalent to calling computeObservationLikelihood()
+	 * for each pose.
+	 * \note (New in MRPT 2.1.0)
+	 */
+	void computeObservationLikelihoodMultiplePoses(
+		const mrpt::obs::CObservation& obs,
+		const std::vector<mrpt::math::TPose2D>& poses,
+		std::vector<double>& out_log_liks);
+
+	/** See base class docs. For lmLikelihoodField_Thrun, the likelihood cache
+	 * of the cells within the range of the observations from the given poses
+	 * is computed now (in parallel), so concurrent evaluations only read it.
+	 * Returns false for lmMeanInformation and lmConsensusOWA, which modify
+	 * the map while being evaluated.
+	 * \note (New in MRPT 2.1.0)
+	 */
+	bool prepareForConcurrentLikelihood(
+		const mrpt::obs::CSensoryFrame& sf,
+		const mrpt::math::TPoint3D& posesMin,
+		const mrpt::math::TPoint3D& posesMax) override;
+
 	/** Computes the likelihood [0,1] of a set of points, given the current grid
 	 * map as reference.
 	 * \param pm The points map
@@ -82,6 +82,9 @@ class COctoMapBase : public mrpt::maps::CMetricMap
 			// Copy all but the m_parent pointer!
 			maxrange = o.maxrange;
 			pruning = o.pruning;
+			batchedInsertion = o.batchedInsertion;
+			numThreads = o.numThreads;
+			lazyInnerNodesUpdate = o.lazyInnerNodesUpdate;
 			const bool o_has_parent = o.m_parent.get() != nullptr;
 			setOccupancyThres(
 				o_has_parent ? o.getOccupancyThres() : o.occupancyThres);
@@ -106,6 +109,25 @@ class COctoMapBase : public mrpt::maps::CMetricMap
 		bool pruning{true};  //!< whether the tree is (losslessly) pruned after
 		//! insertion (default: true)
 
+		/** (Default:false) If true, point clouds are inserted with a batched
+		 * algorithm instead of octomap's `insertPointCloud()`: the voxel keys
+		 * along all rays are computed in parallel (see numThreads), free and
+		 * occupied keys are deduplicated (occupied ones take precedence, as
+		 * in octomap's `computeUpdate()`) and all voxels are then updated in
+		 * one pass. Leaf voxels end up with the same occupancy as with
+		 * octomap's `insertPointCloud()`; the tree is pruned afterwards if
+		 * `pruning` is set.
+		 * \note (New in MRPT 2.1.0) */
+		bool batchedInsertion{false};
+		/** (Default:1) Number of threads used in batched insertion. `0`
+		 * means using all CPU cores. */
+		unsigned int numThreads{1};
+		/** (Default:true) In batched insertion, update only leaf voxels
+		 * while applying the updates, then recompute the occupancy of all
+		 * inner nodes at once. Faster, unless the map is large compared to
+		 * each point cloud. */
+		bool lazyInnerNodesUpdate{true};
+
 		/// (key name in .ini files: "occupancyThres") sets the threshold for
 		/// occupancy (sensor model) (Default=0.5)
 		void setOccupancyThres(double prob)
@@ -316,7 +338,9 @@ class COctoMapBase : public mrpt::maps::CMetricMap
 	/** Update the octomap with a 2D or 3D scan, given directly as a point cloud
 	 * and the 3D location of the sensor (the origin of the rays) in this map's
 	 * frame of reference.
-	 * Insertion parameters can be found in \a insertionOptions.
+	 * Insertion parameters can be found in \a insertionOptions. Unless
+	 * TInsertionOptions::batchedInsertion is set, each point is inserted as
+	 * an independent ray.
 	 * \sa The generic observation insertion method
 	 * CMetricMap::insertObservation()
 	 */
@@ -377,6 +401,13 @@ class COctoMapBase : public mrpt::maps::CMetricMap
 		const mrpt::poses::CPose3D* robotPose, octomap_point3d& sensorPt,
 		octomap_pointcloud& scan) const;
 
+	/** Inserts the rays from `sensorPt` to all points in `scan` (an
+	 * "octomap::Pointcloud") with the batched algorithm described in
+	 * TInsertionOptions::batchedInsertion. The tree is not pruned. */
+	template <class octomap_point3d, class octomap_pointcloud>
+	void internal_insertPointCloudBatched(
+		const octomap_point3d& sensorPt, const octomap_pointcloud& scan);
+
 	struct Impl;
 
 	mrpt::pimpl<Impl> m_impl;
@@ -22,7 +22,9 @@
 #include <mrpt/opengl/PLY_import_export.h>
 #include <mrpt/opengl/pointcloud_adapters.h>
 #include <mrpt/serialization/CSerializable.h>
+#include <atomic>
 #include <iosfwd>
+#include <mutex>
 
 // Add for declaration of mexplus::from template specialization
 DECLARE_MEXPLUS_FROM(mrpt::maps::CPointsMap)
@@ -145,7 +147,7 @@ class CPointsMap : public CMetricMap,
 
 	/** Resizes all point buffers so they can hold the given number of points:
 	 * newly created points are set to default values,
-	 *  and old contents are not changed.
+	 *  and old contents are not changed. The KD-tree is always invalidated.
 	 * \sa reserve, setPoint, setPointFast, setSize
 	 */
 	virtual void resize(size_t newLength) = 0;
@@ -215,6 +217,15 @@ class CPointsMap : public CMetricMap,
 		return squareDistanceToClosestCorrespondence(d2f(p0.x), d2f(p0.y));
 	}
 
+	/** See base class docs. Builds the 2D and 3D KD-trees now, so concurrent
+	 * likelihood evaluations only query them.
+	 * \note (New in MRPT 2.1.0)
+	 */
+	bool prepareForConcurrentLikelihood(
+		const mrpt::obs::CSensoryFrame& sf,
+		const mrpt::math::TPoint3D& posesMin,
+		const mrpt::math::TPoint3D& posesMax) override;
+
 	/** With this struct options are provided to the observation insertion
 	 * process.
 	 * \sa CObservation::insertIntoPointsMap
@@ -658,7 +669,7 @@ class CPointsMap : public CMetricMap,
 	inline void insertPoint(float x, float y, float z = 0)
 	{
 		insertPointFast(x, y, z);
-		mark_as_modified();
+		mark_as_appended();
 	}
 	/// \overload
 	inline void insertPoint(const mrpt::math::TPoint3D& p)
@@ -739,6 +750,7 @@ class CPointsMap : public CMetricMap,
 	{
 		ASSERT_LT_(index, this->size());
 		setPointAllFieldsFast(index, point_data);
+		mark_as_modified();
 	}
 
 	/** Delete points out of the given "z" axis range have been removed.
@@ -847,10 +859,12 @@ class CPointsMap : public CMetricMap,
 	 * and rotated according to the \a sensorPose field in the observation and,
 	 * if provided, to the \a robotPose parameter.
 	 *
-	 * \param scan The Raw LIDAR data to be inserted into this map. It MUST
-	 * contain point cloud data, generated by calling to \a
-	 * mrpt::obs::CObservationVelodyneScan::generatePointCloud() prior to
-	 * insertion in this map.
+	 * \param scan The Raw LIDAR data to be inserted into this map. If it
+	 * contains point cloud data (see \a
+	 * mrpt::obs::CObservationVelodyneScan::generatePointCloud()), those points
+	 * are inserted. Otherwise, points are decoded from the raw packets with
+	 * default parameters directly into this map (new in MRPT 2.1.0), leaving
+	 * the observation untouched.
 	 * \param robotPose Default to (0,0,0|0deg,0deg,0deg). Changes the frame of
 	 * reference for the point cloud (i.e. the vehicle/robot pose in world
 	 * coordinates).
@@ -947,6 +961,39 @@ class CPointsMap : public CMetricMap,
 		pMax.z = dmy6;
 	}
 
+	/** Local surface structure around each point of the map. See
+	 * getLocalStructure() */
+	struct TLocalStructure
+	{
+		/** Unit normal of the plane fitted to the neighborhood of each point.
+		 * Its sign is arbitrary. */
+		std::vector<mrpt::math::TVector3Df> normals;
+		/** Covariance of the neighborhood of each point, regularized to a
+		 * plane-like shape as in Generalized-ICP (Segal et al., RSS 2009):
+		 * its eigenvalues are replaced by (epsilon, 1, 1), with epsilon the
+		 * constant LOCAL_STRUCTURE_PLANE_EPSILON. */
+		std::vector<mrpt::math::CMatrixFloat33> planeCovs;
+	};
+
+	/** Ratio between the smallest and the other two eigenvalues of the
+	 * covariances in TLocalStructure::planeCovs */
+	static constexpr float LOCAL_STRUCTURE_PLANE_EPSILON = 1e-3f;
+
+	/** Returns the local surface normal and covariance of each point,
+	 * estimated from its `knn` nearest neighbors (including itself) in 3D.
+	 *
+	 * Results are cached until the map is modified, so repeated
+	 * registrations against the same map (e.g. with mrpt::slam::CICP
+	 * point-to-plane or GICP methods) do not recompute them.
+	 *
+	 * \param numThreads Number of threads for the computation (0=all cores).
+	 * \note The returned reference remains valid until the map is modified
+	 * or this method is called again with a different `knn`.
+	 * \note (New in MRPT 2.1.0)
+	 */
+	const TLocalStructure& getLocalStructure(
+		size_t knn = 20, unsigned int numThreads = 1) const;
+
 	/** Extracts the points in the map within a cylinder in 3D defined the
 	 * provided radius and zmin/zmax values.
 	 */
@@ -1127,10 +1174,44 @@ class CPointsMap : public CMetricMap,
 	{
 		m_largestDistanceFromOriginIsUpdated = false;
 		m_boundingBoxIsUpdated = false;
+		m_localStructureKNN = 0;
 		kdtree_mark_as_outdated();
 	}
 
+	/** Like mark_as_modified(), for changes that only append new points at
+	 * the end of the map, which are indexed without rebuilding the whole
+	 * KD-tree if `kdtree_search_params.incremental` is set.
+	 * \note (New in MRPT 2.1.0) */
+	inline void mark_as_appended() const
+	{
+		m_largestDistanceFromOriginIsUpdated = false;
+		m_boundingBoxIsUpdated = false;
+		m_localStructureKNN = 0;
+		kdtree_mark_as_appended();
+	}
+
    protected:
+	/** Like resize(), for insertions which only write new points at the end
+	 * of the map: the KD-tree of the former points is kept. Callers must not
+	 * change any of the former points, and must call mark_as_appended() once
+	 * the new points are set.
+	 * \note (New in MRPT 2.1.0) */
+	void resizeForAppending(size_t newLength);
+
+	/** To be called from resize() in derived classes: invalidates the
+	 * KD-tree, unless called from resizeForAppending().
+	 * \note (New in MRPT 2.1.0) */
+	inline void mark_as_resized() const
+	{
+		if (m_resizingForAppending)
+			mark_as_appended();
+		else
+			mark_as_modified();
+	}
+
+	/** Only set while resizeForAppending() runs */
+	bool m_resizingForAppending{false};
+
 	/** The point coordinates */
 	mrpt::aligned_std_vector<float> m_x, m_y, m_z;
 
@@ -1151,6 +1232,12 @@ class CPointsMap : public CMetricMap,
 	mutable float m_bb_min_x, m_bb_max_x, m_bb_min_y, m_bb_max_y, m_bb_min_z,
 		m_bb_max_z;
 
+	/** Cache for getLocalStructure(), valid if m_localStructureKNN!=0 */
+	mutable TLocalStructure m_localStructure;
+	/** Number of neighbors used for m_localStructure, or 0 if outdated */
+	mutable std::atomic_size_t m_localStructureKNN{0};
+	mutable std::mutex m_localStructureMtx;
+
 	/** This is a common version of CMetricMap::insertObservation() for point
 	 * maps (actually, CMetricMap::internal_insertObservation),
 	 *   so derived classes don't need to worry implementing that method unless
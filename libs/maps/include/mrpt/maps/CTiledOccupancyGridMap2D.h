@@ -0,0 +1,241 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2020, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <mrpt/config/CLoadableOptions.h>
+#include <mrpt/maps/CLogOddsGridMap2D.h>
+#include <mrpt/maps/CMetricMap.h>
+#include <mrpt/maps/COccupancyGridMap2D.h>
+#include <mrpt/maps/OccupancyGridCellType.h>
+#include <mrpt/serialization/CSerializable.h>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace mrpt::maps
+{
+/** A 2D occupancy grid map with a tiled storage layout, intended for large
+ * environments.
+ *
+ * Cells hold log-odds occupancy values, exactly like in COccupancyGridMap2D,
+ * but instead of one row-major array they are stored in square tiles of
+ * TILE_SIZE x TILE_SIZE cells (64x64), each one a contiguous block of
+ * memory:
+ *  - Tiles are only allocated when one of their cells is observed. Unknown
+ * areas cost no memory, and reading them returns 0.5.
+ *  - The map has no fixed bounds: cells are addressed with global indices,
+ * `cx=floor(x/resolution)`. Growing the map only reallocates the table of
+ * tile pointers, never copying the contents of cells, unlike
+ * COccupancyGridMap2D::resizeGrid().
+ *  - Ray casting stays within the same tile for up to 64 steps in any
+ * direction, so vertical rays do not jump one full map row per cell.
+ *
+ * Observations of type mrpt::obs::CObservation2DRangeScan are inserted as
+ * simple rays, with the same options and update rules than in
+ * COccupancyGridMap2D (see COccupancyGridMap2D::TInsertionOptions, of which
+ * the beam-widening and sonar-related fields are ignored). Observation
+ * likelihoods are evaluated with Thrun's likelihood field.
+ *
+ * Algorithms written for COccupancyGridMap2D (e.g. those using its
+ * COccupancyGridMap2D::getRow() or COccupancyGridMap2D::getCell() methods)
+ * can be applied to a dense copy of the known area, obtained with
+ * getAsOccupancyGridMap2D(). The opposite conversion is
+ * loadFromOccupancyGridMap2D().
+ *
+ * \note (New in MRPT 2.1.0)
+ * \ingroup mrpt_maps_grp
+ **/
+class CTiledOccupancyGridMap2D
+	: public CMetricMap,
+	  public CLogOddsGridMap2D<OccGridCellTraits::cellType>
+{
+	DEFINE_SERIALIZABLE(CTiledOccupancyGridMap2D, mrpt::maps)
+
+   public:
+	using cellType = OccGridCellTraits::cellType;
+
+	/** Tiles have TILE_SIZE x TILE_SIZE cells, TILE_SIZE=2^TILE_BITS */
+	static constexpr int TILE_BITS = 6;
+	static constexpr int TILE_SIZE = 1 << TILE_BITS;
+	static constexpr int TILE_MASK = TILE_SIZE - 1;
+	/** Cells of one tile, row by row */
+	using tile_t = std::array<cellType, TILE_SIZE * TILE_SIZE>;
+
+	/** Constructor, with the size of cells (meters) */
+	CTiledOccupancyGridMap2D(float resolution = 0.05f);
+
+	CTiledOccupancyGridMap2D(const CTiledOccupancyGridMap2D& o);
+	CTiledOccupancyGridMap2D& operator=(const CTiledOccupancyGridMap2D& o);
+	CTiledOccupancyGridMap2D(CTiledOccupancyGridMap2D&&) = default;
+	CTiledOccupancyGridMap2D& operator=(CTiledOccupancyGridMap2D&&) = default;
+
+	/** Changes the size of cells (meters), erasing the map contents */
+	void setResolution(float resolution);
+	/** Returns the size of cells (meters) */
+	float getResolution() const { return m_resolution; }
+
+	/** Transform a coordinate (meters) into a global cell index */
+	int x2idx(double x) const
+	{
+		return static_cast<int>(std::floor(x * m_resolution_inv));
+	}
+	int y2idx(double y) const { return x2idx(y); }
+	/** Transform a global cell index into the coordinate of its center */
+	float idx2x(int cx) const { return (cx + 0.5f) * m_resolution; }
+	float idx2y(int cy) const { return idx2x(cy); }
+
+	/** Read the real valued [0,1] contents of a cell, given its global
+	 * indices. Unknown cells read as 0.5 */
+	float getCell(int cx, int cy) const
+	{
+		return COccupancyGridMap2D::l2p(getRawCell(cx, cy));
+	}
+	/** Change the contents [0,1] of a cell, given its global indices.
+	 * Allocates its tile if needed. */
+	void setCell(int cx, int cy, float value);
+
+	/** Read the real valued [0,1] contents of a cell, given its coordinates */
+	float getPos(float x, float y) const
+	{
+		return getCell(x2idx(x), y2idx(y));
+	}
+	/** Change the contents [0,1] of a cell, given its coordinates */
+	void setPos(float x, float y, float value)
+	{
+		setCell(x2idx(x), y2idx(y), value);
+	}
+
+	/** Raw contents of a cell (in log-odds units) */
+	cellType getRawCell(int cx, int cy) const
+	{
+		const tile_t* t = getTile(cx >> TILE_BITS, cy >> TILE_BITS);
+		return t ? (*t)[tileOffset(cx, cy)] : UNKNOWN_CELL;
+	}
+
+	/** Returns the tile with tile indices (tx,ty), i.e. with cells
+	 * `[tx*TILE_SIZE, (tx+1)*TILE_SIZE)` in x, or nullptr if it is not
+	 * allocated */
+	const tile_t* getTile(int tx, int ty) const
+	{
+		const unsigned dx = static_cast<unsigned>(tx - m_tx0),
+					   dy = static_cast<unsigned>(ty - m_ty0);
+		// The x> comparison implicitly holds if x<0
+		if (dx >= m_ntx || dy >= m_nty) return nullptr;
+		return m_tiles[dx + dy * m_ntx].get();
+	}
+
+	/** Number of allocated tiles */
+	size_t tileCount() const { return m_num_tiles; }
+
+	/** Gets the bounding box (meters) of all allocated tiles.
+	 * \return false if the map is empty */
+	bool getKnownArea(
+		float& x_min, float& x_max, float& y_min, float& y_max) const;
+
+	/** Returns a dense occupancy grid map with the contents of all allocated
+	 * tiles, so existing code for COccupancyGridMap2D can be used on this map.
+	 * Its options are not modified. */
+	void getAsOccupancyGridMap2D(COccupancyGridMap2D& out) const;
+
+	/** Replaces the contents of this map with those of a dense occupancy
+	 * grid, and its resolution. Tiles whose cells are all unknown are not
+	 * allocated. */
+	void loadFromOccupancyGridMap2D(const COccupancyGridMap2D& in);
+
+	// See docs in base class
+	bool isEmpty() const override;
+
+	/** Saves the known area like
+	 * COccupancyGridMap2D::saveMetricMapRepresentationToFile() */
+	void saveMetricMapRepresentationToFile(const std::string& f) const override;
+
+	/** Returns a 3D representation of the known area, like
+	 * COccupancyGridMap2D::getAs3DObject() */
+	void getAs3DObject(mrpt::opengl::CSetOfObjects::Ptr& outObj) const override;
+
+	/** Options for the insertion of observations. Only those relevant to the
+	 * insertion of 2D range scans as simple rays are used. */
+	COccupancyGridMap2D::TInsertionOptions insertionOptions;
+
+	/** Options for the computation of observations likelihood, with the same
+	 * meaning than in COccupancyGridMap2D::TLikelihoodOptions */
+	struct TLikelihoodOptions : public mrpt::config::CLoadableOptions
+	{
+		void loadFromConfigFile(
+			const mrpt::config::CConfigFileBase& source,
+			const std::string& section) override;
+		void saveToConfigFile(
+			mrpt::config::CConfigFileBase& target,
+			const std::string& section) const override;
+
+		/** The laser range "sigma" used in computations (meters) */
+		float LF_stdHit{0.35f};
+		/** Ratios of the hit/random components of the likelihood */
+		float LF_zHit{0.95f}, LF_zRandom{0.05f};
+		/** The max. range of the sensor (meters) */
+		float LF_maxRange{81.0f};
+		/** Only consider one out of N points of each scan */
+		uint32_t LF_decimation{5};
+		/** The max. distance for searching correspondences around each
+		 * sensed point (meters) */
+		float LF_maxCorrsDistance{0.3f};
+	};
+	TLikelihoodOptions likelihoodOptions;
+
+   protected:
+	/** The log-odds of an unknown (p=0.5) cell */
+	static constexpr cellType UNKNOWN_CELL = 0;
+
+	float m_resolution{0.05f}, m_resolution_inv{1.0f / 0.05f};
+
+	/** Table of tiles, row by row, covering tile indices
+	 * `[m_tx0, m_tx0+m_ntx) x [m_ty0, m_ty0+m_nty)`. Unknown tiles are
+	 * nullptr. */
+	std::vector<std::unique_ptr<tile_t>> m_tiles;
+	int m_tx0{0}, m_ty0{0};
+	unsigned int m_ntx{0}, m_nty{0};
+	size_t m_num_tiles{0};
+
+	static int tileOffset(int cx, int cy)
+	{
+		return (cx & TILE_MASK) + ((cy & TILE_MASK) << TILE_BITS);
+	}
+	/** Grows the table of tiles so it covers the given range of tile
+	 * indices (inclusive). Existing tiles are moved, not copied. */
+	void reserveTiles(int tx_min, int tx_max, int ty_min, int ty_max);
+	/** Returns the tile (tx,ty), allocating it if needed */
+	tile_t& getTileForWrite(int tx, int ty);
+
+	/** Distance (meters) from the cell (cx,cy) to the closest occupied
+	 * cell, up to `maxDist` */
+	float closestOccupiedDistance(int cx, int cy, float maxDist) const;
+
+	// See docs in base class
+	void internal_clear() override;
+	bool internal_insertObservation(
+		const mrpt::obs::CObservation& obs,
+		const mrpt::poses::CPose3D* robotPose = nullptr) override;
+	double internal_computeObservationLikelihood(
+		const mrpt::obs::CObservation& obs,
+		const mrpt::poses::CPose3D& takenFrom) override;
+	bool internal_canComputeObservationLikelihood(
+		const mrpt::obs::CObservation& obs) const override;
+
+	MAP_DEFINITION_START(CTiledOccupancyGridMap2D)
+	/** See CTiledOccupancyGridMap2D::CTiledOccupancyGridMap2D */
+	float resolution{0.05f};
+
+	mrpt::maps::COccupancyGridMap2D::TInsertionOptions insertionOpts;
+	mrpt::maps::CTiledOccupancyGridMap2D::TLikelihoodOptions likelihoodOpts;
+	MAP_DEFINITION_END(CTiledOccupancyGridMap2D)
+};
+
+}  // namespace mrpt::maps
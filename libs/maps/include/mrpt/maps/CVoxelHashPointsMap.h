@@ -0,0 +1,264 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2020, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <mrpt/config/CLoadableOptions.h>
+#include <mrpt/img/TColor.h>
+#include <mrpt/maps/CMetricMap.h>
+#include <mrpt/math/TPoint3D.h>
+#include <mrpt/serialization/CSerializable.h>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace mrpt::maps
+{
+class CPointsMap;
+
+/** A sparse 3D point map, storing points into a hash table of fixed-size
+ * voxels, intended for large-scale (e.g. LiDAR) mapping.
+ *
+ * Unlike CPointsMap and its KD-tree, which must be rebuilt from scratch
+ * after each modification, all operations here are local:
+ *  - Inserting a point costs O(1): its voxel is looked up in the hash table
+ * and the point appended to it, or discarded if the voxel already holds
+ * getMaxPointsPerVoxel() points (which acts as a voxel-grid downsampling).
+ *  - Nearest neighbor searches (nn_single_search()) visit the voxels around
+ * the query in growing cubic shells, stopping as soon as no closer point may
+ * exist. Since voxels hold a bounded number of points, the cost of a query
+ * only depends on the search radius, not on the size of the map.
+ *  - Voxels far from the robot can be evicted with removeVoxelsFartherThan(),
+ * or automatically after each observation insertion, see
+ * TInsertionOptions::eviction_distance.
+ *
+ * Points are stored in structure-of-arrays layout: voxel `i` owns the slots
+ * `[i*M, (i+1)*M)` of three contiguous `x[]`, `y[]`, `z[]` arrays, with `M`
+ * the maximum number of points per voxel. Point indices (as returned in the
+ * `this_idx` field of matching pairs) refer to those slots, and remain valid
+ * until the next call to removeVoxelsFartherThan() or clear().
+ *
+ * This map implements determineMatching3D() so it can be used as reference
+ * map in mrpt::slam::CICP (classic ICP) or within a CMultiMetricMap.
+ * Observations are converted into points exactly like in CSimplePointsMap.
+ *
+ * \note (New in MRPT 2.1.0)
+ * \ingroup mrpt_maps_grp
+ **/
+class CVoxelHashPointsMap : public CMetricMap
+{
+	DEFINE_SERIALIZABLE(CVoxelHashPointsMap, mrpt::maps)
+
+   public:
+	/** Constructor, with the voxel edge length (meters) and the maximum
+	 * number of points stored in each voxel. */
+	CVoxelHashPointsMap(
+		double voxel_size = 0.20, uint32_t max_points_per_voxel = 16);
+
+	/** Changes the voxel edge length (meters) and the maximum number of points
+	 * per voxel. Existing points are re-inserted with the new settings. */
+	void setVoxelProperties(double voxel_size, uint32_t max_points_per_voxel);
+
+	double getVoxelSize() const { return m_voxel_size; }
+	uint32_t getMaxPointsPerVoxel() const { return m_max_points_per_voxel; }
+
+	/** Number of points in the map */
+	size_t size() const { return m_num_points; }
+	/** Number of non-empty voxels in the map */
+	size_t voxelCount() const { return m_voxel_keys.size(); }
+
+	/** Inserts one point, in map coordinates.
+	 * \return false if the point was discarded because its voxel is already
+	 * full, or it lies out of the representable range of voxel indices
+	 * (about +/-10^6 voxels from the origin). */
+	bool insertPoint(float x, float y, float z);
+	bool insertPoint(const mrpt::math::TPoint3Df& p)
+	{
+		return insertPoint(p.x, p.y, p.z);
+	}
+
+	/** Inserts all points of a point cloud, transformed by the given pose.
+	 * \return The number of points actually inserted */
+	size_t insertPointCloud(
+		const mrpt::maps::CPointsMap& pts,
+		const mrpt::poses::CPose3D& pointsPose);
+
+	/** Looks for the closest point to (x,y,z) within a distance of `maxDist`
+	 * meters. Thread-safe, as long as the map is not modified meanwhile.
+	 * \param[out] out_idx Index of the closest point, for use in getPoint().
+	 * \param[out] out_dist_sqr Squared distance to the closest point.
+	 * \return false if there is no point closer than `maxDist`. */
+	bool nn_single_search(
+		float x, float y, float z, float maxDist, size_t& out_idx,
+		float& out_dist_sqr) const;
+
+	/** Returns the coordinates of the point with index `idx`, as returned by
+	 * nn_single_search(). */
+	void getPoint(size_t idx, float& x, float& y, float& z) const
+	{
+		x = m_x[idx];
+		y = m_y[idx];
+		z = m_z[idx];
+	}
+
+	/** Removes all voxels whose center is farther than `maxDist` meters from
+	 * `center`. Point indices are invalidated.
+	 * \return The number of removed points */
+	size_t removeVoxelsFartherThan(
+		const mrpt::math::TPoint3D& center, double maxDist);
+
+	/** Calls `f(x,y,z)` for each point in the map */
+	template <class FUNCTOR>
+	void visitAllPoints(FUNCTOR&& f) const
+	{
+		const size_t M = m_max_points_per_voxel;
+		for (size_t v = 0; v < m_voxel_counts.size(); v++)
+			for (size_t i = v * M; i < v * M + m_voxel_counts[v]; i++)
+				f(m_x[i], m_y[i], m_z[i]);
+	}
+
+	// See docs in base class
+	bool isEmpty() const override;
+
+	/** See docs in base class. Points of `otherMap` (which must be a
+	 * CPointsMap) are matched in 3D, so their z coordinates must be
+	 * consistent with those in this map. */
+	void determineMatching2D(
+		const mrpt::maps::CMetricMap* otherMap,
+		const mrpt::poses::CPose2D& otherMapPose,
+		mrpt::tfest::TMatchingPairList& correspondences,
+		const TMatchingParams& params,
+		TMatchingExtraResults& extraResults) const override;
+
+	/** See docs in base class. `otherMap` must be a CPointsMap. The search
+	 * of correspondences runs in parallel if `params.numThreads!=1`. */
+	void determineMatching3D(
+		const mrpt::maps::CMetricMap* otherMap,
+		const mrpt::poses::CPose3D& otherMapPose,
+		mrpt::tfest::TMatchingPairList& correspondences,
+		const TMatchingParams& params,
+		TMatchingExtraResults& extraResults) const override;
+
+	// See docs in base class
+	float compute3DMatchingRatio(
+		const mrpt::maps::CMetricMap* otherMap,
+		const mrpt::poses::CPose3D& otherMapPose,
+		const TMatchingRatioParams& params) const override;
+
+	/** Saves all points as a text file "<prefix>.txt", one "X Y Z" per line */
+	void saveMetricMapRepresentationToFile(const std::string& f) const override;
+
+	/** Returns a CPointCloud with all points, according to renderOptions */
+	void getAs3DObject(mrpt::opengl::CSetOfObjects::Ptr& outObj) const override;
+
+	/** Options for the insertion of observations */
+	struct TInsertionOptions : public mrpt::config::CLoadableOptions
+	{
+		void loadFromConfigFile(
+			const mrpt::config::CConfigFileBase& source,
+			const std::string& section) override;
+		void saveToConfigFile(
+			mrpt::config::CConfigFileBase& target,
+			const std::string& section) const override;
+
+		/** If >0, after inserting each observation, voxels farther than this
+		 * distance (meters) from the robot are removed, bounding the memory
+		 * of the map (Default: 0, disabled) */
+		double eviction_distance{0};
+	};
+	TInsertionOptions insertionOptions;
+
+	/** Options for the computation of observations likelihood, with the same
+	 * meaning than in CPointsMap::TLikelihoodOptions */
+	struct TLikelihoodOptions : public mrpt::config::CLoadableOptions
+	{
+		void loadFromConfigFile(
+			const mrpt::config::CConfigFileBase& source,
+			const std::string& section) override;
+		void saveToConfigFile(
+			mrpt::config::CConfigFileBase& target,
+			const std::string& section) const override;
+
+		/** Sigma squared (variance, in meters) of the exponential used to
+		 * model the likelihood (default= 0.05^2 meters) */
+		double sigma_dist{0.0025};
+		/** Maximum distance in meters to consider for the numerator divided
+		 * by "sigma_dist" (default=1.0 meters) */
+		double max_corr_distance{1.0};
+		/** Only consider one out of N points (default=10) */
+		uint32_t decimation{10};
+	};
+	TLikelihoodOptions likelihoodOptions;
+
+	/** Rendering options, used in getAs3DObject() */
+	struct TRenderOptions : public mrpt::config::CLoadableOptions
+	{
+		void loadFromConfigFile(
+			const mrpt::config::CConfigFileBase& source,
+			const std::string& section) override;
+		void saveToConfigFile(
+			mrpt::config::CConfigFileBase& target,
+			const std::string& section) const override;
+
+		float point_size{1.0f};
+		mrpt::img::TColorf color{.0f, .0f, 1.0f};
+	};
+	TRenderOptions renderOptions;
+
+   protected:
+	double m_voxel_size{0.20}, m_voxel_size_inv{1.0 / 0.20};
+	uint32_t m_max_points_per_voxel{16};
+	size_t m_num_points{0};
+
+	/** Voxel key -> voxel index */
+	std::unordered_map<uint64_t, uint32_t> m_voxel_index;
+	/** Key and number of points of each voxel, by voxel index */
+	std::vector<uint64_t> m_voxel_keys;
+	std::vector<uint32_t> m_voxel_counts;
+	/** Point coordinates, m_max_points_per_voxel slots per voxel */
+	std::vector<float> m_x, m_y, m_z;
+
+	/** Number of bits of each voxel coordinate in a voxel key */
+	static constexpr int KEY_BITS = 21;
+	static constexpr int32_t KEY_OFFSET = int32_t(1) << (KEY_BITS - 1);
+
+	static uint64_t voxelKey(int32_t cx, int32_t cy, int32_t cz)
+	{
+		return (uint64_t(uint32_t(cx + KEY_OFFSET)) << (2 * KEY_BITS)) |
+			   (uint64_t(uint32_t(cy + KEY_OFFSET)) << KEY_BITS) |
+			   uint64_t(uint32_t(cz + KEY_OFFSET));
+	}
+	int32_t coord2idx(float v) const
+	{
+		return static_cast<int32_t>(std::floor(v * m_voxel_size_inv));
+	}
+	/** Voxel center from its key */
+	mrpt::math::TPoint3D voxelCenter(uint64_t key) const;
+
+	// See docs in base class
+	void internal_clear() override;
+	bool internal_insertObservation(
+		const mrpt::obs::CObservation& obs,
+		const mrpt::poses::CPose3D* robotPose = nullptr) override;
+	double internal_computeObservationLikelihood(
+		const mrpt::obs::CObservation& obs,
+		const mrpt::poses::CPose3D& takenFrom) override;
+
+	MAP_DEFINITION_START(CVoxelHashPointsMap)
+	/** See CVoxelHashPointsMap::CVoxelHashPointsMap */
+	double voxel_size{0.20};
+	uint32_t max_points_per_voxel{16};
+
+	mrpt::maps::CVoxelHashPointsMap::TInsertionOptions insertionOpts;
+	mrpt::maps::CVoxelHashPointsMap::TLikelihoodOptions likelihoodOpts;
+	mrpt::maps::CVoxelHashPointsMap::TRenderOptions renderOpts;
+	MAP_DEFINITION_END(CVoxelHashPointsMap)
+};
+
+}  // namespace mrpt::maps
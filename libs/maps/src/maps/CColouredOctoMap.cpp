@@ -194,9 +194,15 @@ bool CColouredOctoMap::internal_insertObservation(
 		}
 
 		// Insert rays:
-		m_impl->m_octomap.insertPointCloud(
-			scan, sensorPt, insertionOptions.maxrange,
-			insertionOptions.pruning);
+		if (insertionOptions.batchedInsertion)
+		{
+			internal_insertPointCloudBatched(sensorPt, scan);
+			if (insertionOptions.pruning) m_impl->m_octomap.prune();
+		}
+		else
+			m_impl->m_octomap.insertPointCloud(
+				scan, sensorPt, insertionOptions.maxrange,
+				insertionOptions.pruning);
 		return true;
 	}
 	else if (IS_CLASS(obs, CObservation3DRangeScan))
@@ -236,19 +242,24 @@ bool CColouredOctoMap::internal_insertObservation(
 		}
 
 		// Insert rays:
-		octomap::KeySet free_cells, occupied_cells;
-		m_impl->m_octomap.computeUpdate(
-			scan, sensorPt, free_cells, occupied_cells,
-			insertionOptions.maxrange);
-
-		// insert data into tree  -----------------------
-		for (const auto& free_cell : free_cells)
-		{
-			m_impl->m_octomap.updateNode(free_cell, false, false);
-		}
-		for (const auto& occupied_cell : occupied_cells)
+		if (insertionOptions.batchedInsertion)
+			internal_insertPointCloudBatched(sensorPt, scan);
+		else
 		{
-			m_impl->m_octomap.updateNode(occupied_cell, true, false);
+			octomap::KeySet free_cells, occupied_cells;
+			m_impl->m_octomap.computeUpdate(
+				scan, sensorPt, free_cells, occupied_cells,
+				insertionOptions.maxrange);
+
+			// insert data into tree  -----------------------
+			for (const auto& free_cell : free_cells)
+			{
+				m_impl->m_octomap.updateNode(free_cell, false, false);
+			}
+			for (const auto& occupied_cell : occupied_cells)
+			{
+				m_impl->m_octomap.updateNode(occupied_cell, true, false);
+			}
 		}
 
 		// Update color -----------------------
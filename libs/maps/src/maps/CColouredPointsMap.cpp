@@ -91,7 +91,7 @@ void CColouredPointsMap::resize(size_t newLength)
 	m_color_R.resize(newLength, 1);
 	m_color_G.resize(newLength, 1);
 	m_color_B.resize(newLength, 1);
-	mark_as_modified();
+	mark_as_resized();
 }
 
 // Resizes all point buffers so they can hold the given number of points,
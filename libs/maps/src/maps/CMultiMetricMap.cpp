@@ -304,6 +304,22 @@ void CMultiMetricMap::auxParticleFilterCleanUp()
 	MRPT_END
 }
 
+bool CMultiMetricMap::prepareForConcurrentLikelihood(
+	const CSensoryFrame& sf, const mrpt::math::TPoint3D& posesMin,
+	const mrpt::math::TPoint3D& posesMax)
+{
+	MRPT_START
+	bool ok = true;
+	std::for_each(maps.begin(), maps.end(), [&](auto& ptr) {
+		// Maps not evaluating likelihoods do not care:
+		if (!ptr->genericMapParams.enableObservationLikelihood) return;
+		ok = ptr->prepareForConcurrentLikelihood(sf, posesMin, posesMax) &&
+			ok;
+	});
+	return ok;
+	MRPT_END
+}
+
 const CSimplePointsMap* CMultiMetricMap::getAsSimplePointsMap() const
 {
 	MRPT_START
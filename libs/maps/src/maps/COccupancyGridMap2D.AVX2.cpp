@@ -0,0 +1,121 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2020, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include "maps-precomp.h"  // Precomp header
+
+#include <mrpt/config.h>
+
+#if MRPT_ARCH_INTEL_COMPATIBLE
+// ---------------------------------------------------------------------------
+//   This file contains the AVX2 optimized functions for
+//   mrpt::maps::COccupancyGridMap2D
+//    See the sources and the doxygen documentation page "sse_optimizations" for
+//    more details.
+// ---------------------------------------------------------------------------
+
+#include <immintrin.h>
+#include <cmath>
+#include "COccupancyGridMap2D.SSEx.h"
+
+/** \addtogroup sse_optimizations
+ *  SSE optimized functions
+ *  @{
+ */
+
+/** AVX2 version of occgrid_SSE2_points_to_cells() */
+void occgrid_AVX2_points_to_cells(
+	const double* xs, const double* ys, std::size_t N, double px, double py,
+	double ccos, double ssin, const occgrid_cells_params_t& g,
+	int32_t* out_idxs)
+{
+	const __m256d c = _mm256_set1_pd(ccos), s = _mm256_set1_pd(ssin);
+	const __m256d x0 = _mm256_set1_pd(px), y0 = _mm256_set1_pd(py);
+	const __m256d gx0 = _mm256_set1_pd(g.x_min), gy0 = _mm256_set1_pd(g.y_min);
+	const __m256d res = _mm256_set1_pd(g.resolution);
+	const __m128i sx = _mm_set1_epi32(static_cast<int32_t>(g.size_x));
+	const __m128i max_cx = _mm_set1_epi32(static_cast<int32_t>(g.size_x) - 2);
+	const __m128i max_cy = _mm_set1_epi32(static_cast<int32_t>(g.size_y) - 2);
+	const __m128i minus1 = _mm_set1_epi32(-1);
+	const __m128i zero = _mm_setzero_si128();
+
+	const std::size_t N4 = N & ~static_cast<std::size_t>(3);
+	for (std::size_t i = 0; i < N4; i += 4)
+	{
+		const __m256d lx = _mm256_loadu_pd(xs + i);
+		const __m256d ly = _mm256_loadu_pd(ys + i);
+		// Note: no FMA on purpose, to keep the same rounding than the
+		// non-vectorized code:
+		const __m256d gx = _mm256_sub_pd(
+			_mm256_add_pd(x0, _mm256_mul_pd(lx, c)), _mm256_mul_pd(ly, s));
+		const __m256d gy = _mm256_add_pd(
+			_mm256_add_pd(y0, _mm256_mul_pd(lx, s)), _mm256_mul_pd(ly, c));
+		const __m128i cx = _mm256_cvttpd_epi32(
+			_mm256_div_pd(_mm256_sub_pd(gx, gx0), res));
+		const __m128i cy = _mm256_cvttpd_epi32(
+			_mm256_div_pd(_mm256_sub_pd(gy, gy0), res));
+		// Out of the grid if cx<0 || cx>=size_x-1 || cy<0 || cy>=size_y-1:
+		const __m128i out = _mm_or_si128(
+			_mm_or_si128(_mm_cmplt_epi32(cx, zero), _mm_cmplt_epi32(cy, zero)),
+			_mm_or_si128(
+				_mm_cmpgt_epi32(cx, max_cx), _mm_cmpgt_epi32(cy, max_cy)));
+		const __m128i idx = _mm_add_epi32(cx, _mm_mullo_epi32(cy, sx));
+		_mm_storeu_si128(
+			reinterpret_cast<__m128i*>(out_idxs + i),
+			_mm_blendv_epi8(idx, minus1, out));
+	}
+	if (N4 != N)
+		occgrid_SSE2_points_to_cells(
+			xs + N4, ys + N4, N - N4, px, py, ccos, ssin, g, out_idxs + N4);
+}
+
+/** Returns the sum of `log(table[idxs[i]])` for i in [0,N-1], using
+ * `outOfMapLik` for those entries with `idxs[i]<0`. All table entries must be
+ * valid (i.e. already evaluated). To save logarithms, likelihood values are
+ * multiplied in groups of 8 (per SIMD lane) before taking their logarithm,
+ * hence the result may differ from a sequential sum of logarithms in the
+ * last bits only.
+ */
+double occgrid_AVX2_sum_log_lik(
+	const double* table, const int32_t* idxs, std::size_t N,
+	double outOfMapLik)
+{
+	constexpr std::size_t PRODS_PER_LOG = 8;
+	const __m256d outLik = _mm256_set1_pd(outOfMapLik);
+	const __m128i minus1 = _mm_set1_epi32(-1);
+
+	double ret = 0;
+	alignas(32) double prods[4];
+
+	const std::size_t N4 = N & ~static_cast<std::size_t>(3);
+	std::size_t i = 0;
+	while (i < N4)
+	{
+		__m256d prod = _mm256_set1_pd(1.0);
+		for (std::size_t k = 0; k < PRODS_PER_LOG && i < N4; k++, i += 4)
+		{
+			const __m128i idx =
+				_mm_loadu_si128(reinterpret_cast<const __m128i*>(idxs + i));
+			// Mask: lanes with idx>=0
+			const __m256d mask = _mm256_castsi256_pd(
+				_mm256_cvtepi32_epi64(_mm_cmpgt_epi32(idx, minus1)));
+			const __m256d liks =
+				_mm256_mask_i32gather_pd(outLik, table, idx, mask, 8);
+			prod = _mm256_mul_pd(prod, liks);
+		}
+		_mm256_store_pd(prods, prod);
+		for (double p : prods) ret += std::log(p);
+	}
+	for (; i < N; i++)
+		ret += std::log(idxs[i] < 0 ? outOfMapLik : table[idxs[i]]);
+	return ret;
+}
+
+/** @} */
+
+#endif  // end if MRPT_ARCH_INTEL_COMPATIBLE
@@ -0,0 +1,83 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2020, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include "maps-precomp.h"  // Precomp header
+
+#include <mrpt/config.h>
+
+#if MRPT_ARCH_INTEL_COMPATIBLE
+// ---------------------------------------------------------------------------
+//   This file contains the SSE2 optimized functions for
+//   mrpt::maps::COccupancyGridMap2D
+//    See the sources and the doxygen documentation page "sse_optimizations" for
+//    more details.
+// ---------------------------------------------------------------------------
+
+#include <mrpt/core/SSE_types.h>
+#include "COccupancyGridMap2D.SSEx.h"
+
+/** \addtogroup sse_optimizations
+ *  SSE optimized functions
+ *  @{
+ */
+
+/** Transforms N local points (xs,ys) with the 2D pose (px,py,phi), given as
+ * (px,py,cos(phi),sin(phi)), and stores the linear index `cx+cy*size_x` of
+ * the cell each point falls in, or `-1` if it is out of the grid (excluding
+ * its last row and column). The arithmetic is exactly the same than in the
+ * non-vectorized COccupancyGridMap2D::computeLikelihoodField_Thrun().
+ */
+void occgrid_SSE2_points_to_cells(
+	const double* xs, const double* ys, std::size_t N, double px, double py,
+	double ccos, double ssin, const occgrid_cells_params_t& g,
+	int32_t* out_idxs)
+{
+	const __m128d c = _mm_set1_pd(ccos), s = _mm_set1_pd(ssin);
+	const __m128d x0 = _mm_set1_pd(px), y0 = _mm_set1_pd(py);
+	const __m128d gx0 = _mm_set1_pd(g.x_min), gy0 = _mm_set1_pd(g.y_min);
+	const __m128d res = _mm_set1_pd(g.resolution);
+	const unsigned size_x_1 = g.size_x - 1, size_y_1 = g.size_y - 1;
+
+	const std::size_t N2 = N & ~static_cast<std::size_t>(1);
+	alignas(16) int32_t cxs[4], cys[4];
+	for (std::size_t i = 0; i < N2; i += 2)
+	{
+		const __m128d lx = _mm_loadu_pd(xs + i), ly = _mm_loadu_pd(ys + i);
+		const __m128d gx =
+			_mm_sub_pd(_mm_add_pd(x0, _mm_mul_pd(lx, c)), _mm_mul_pd(ly, s));
+		const __m128d gy =
+			_mm_add_pd(_mm_add_pd(y0, _mm_mul_pd(lx, s)), _mm_mul_pd(ly, c));
+		_mm_store_si128(
+			reinterpret_cast<__m128i*>(cxs),
+			_mm_cvttpd_epi32(_mm_div_pd(_mm_sub_pd(gx, gx0), res)));
+		_mm_store_si128(
+			reinterpret_cast<__m128i*>(cys),
+			_mm_cvttpd_epi32(_mm_div_pd(_mm_sub_pd(gy, gy0), res)));
+		for (int k = 0; k < 2; k++)
+			out_idxs[i + k] = (static_cast<unsigned>(cxs[k]) >= size_x_1 ||
+							   static_cast<unsigned>(cys[k]) >= size_y_1)
+				? -1
+				: cxs[k] + cys[k] * static_cast<int32_t>(g.size_x);
+	}
+	for (std::size_t i = N2; i < N; i++)
+	{
+		const double gx = px + xs[i] * ccos - ys[i] * ssin;
+		const double gy = py + xs[i] * ssin + ys[i] * ccos;
+		const int cx = static_cast<int>((gx - g.x_min) / g.resolution);
+		const int cy = static_cast<int>((gy - g.y_min) / g.resolution);
+		out_idxs[i] = (static_cast<unsigned>(cx) >= size_x_1 ||
+					   static_cast<unsigned>(cy) >= size_y_1)
+			? -1
+			: cx + cy * static_cast<int32_t>(g.size_x);
+	}
+}
+
+/** @} */
+
+#endif  // end if MRPT_ARCH_INTEL_COMPATIBLE
@@ -0,0 +1,36 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2020, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <mrpt/config.h>
+#include <cstddef>
+#include <cstdint>
+
+// See documentation in the .cpp files COccupancyGridMap2D.SSE2.cpp, etc.
+
+/** Parameters of the grid required to map points into cells */
+struct occgrid_cells_params_t
+{
+	double x_min, y_min, resolution;
+	uint32_t size_x, size_y;
+};
+
+void occgrid_SSE2_points_to_cells(
+	const double* xs, const double* ys, std::size_t N, double px, double py,
+	double ccos, double ssin, const occgrid_cells_params_t& g,
+	int32_t* out_idxs);
+
+void occgrid_AVX2_points_to_cells(
+	const double* xs, const double* ys, std::size_t N, double px, double py,
+	double ccos, double ssin, const occgrid_cells_params_t& g,
+	int32_t* out_idxs);
+
+double occgrid_AVX2_sum_log_lik(
+	const double* table, const int32_t* idxs, std::size_t N,
+	double outOfMapLik);
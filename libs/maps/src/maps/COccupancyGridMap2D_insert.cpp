@@ -9,12 +9,15 @@
 
 #include "maps-precomp.h"  // Precomp header
 
+#include <mrpt/core/WorkerThreadsPool.h>
 #include <mrpt/core/round.h>  // round()
 #include <mrpt/maps/COccupancyGridMap2D.h>
 #include <mrpt/obs/CObservation2DRangeScan.h>
 #include <mrpt/obs/CObservationRange.h>
 #include <mrpt/serialization/CArchive.h>
 #include <mrpt/system/memory.h>  // alloca()
+#include <algorithm>
+#include <cstdint>
 
 #if HAVE_ALLOCA_H
 #include <alloca.h>
@@ -35,6 +38,26 @@ struct TLocalPoint
 	int cx{0}, cy{0};
 };
 
+namespace
+{
+/** One log-odds update of a cell, in the parallel insertion of range scans */
+struct TCellUpdate
+{
+	uint32_t cell;
+	int32_t logodd;
+};
+
+/** Number of threads used to insert a range scan with `nRays` rays */
+unsigned int rayCastingThreads(unsigned int numThreads, size_t nRays)
+{
+	// Below this, the overhead of dispatching tasks does not pay off:
+	constexpr size_t MIN_RAYS_PER_THREAD = 128;
+	numThreads = mrpt::WorkerThreadsPool::clampNumThreads(numThreads);
+	return static_cast<unsigned int>(std::max<size_t>(
+		1, std::min<size_t>(numThreads, nRays / MIN_RAYS_PER_THREAD)));
+}
+}  // namespace
+
 /*---------------------------------------------------------------
 					insertObservation
 
@@ -120,7 +143,7 @@ bool COccupancyGridMap2D::internal_insertObservation(
 			// ---------------------------------------------
 			//		Insert the scan as simple rays:
 			// ---------------------------------------------
-			int cx, cy, N = o.getScanSize();
+			int N = o.getScanSize();
 			float A, dAK;
 
 			// Parameters values:
@@ -252,19 +275,20 @@ bool COccupancyGridMap2D::internal_insertObservation(
 					x2idx(px);  // Remember: This must be after the resizeGrid!!
 				int cy0 = y2idx(py);
 
-				// Insert rays:
-				for (idx = 0; idx < nRanges; idx += K)
-				{
-					if (!o.getScanRangeValidity(idx) && !invalidAsFree)
-						continue;
+				// Ray-casts the beam "idx", calling update(cx,cy,logodd) for
+				// each traversed cell, with logodd>0 for free cells and <0
+				// for the occupied cell at the end of the beam:
+				const auto castRay = [&](size_t beam, auto&& update) {
+					if (!o.getScanRangeValidity(beam) && !invalidAsFree)
+						return;
 
 					// Starting position: Laser position
-					cx = cx0;
-					cy = cy0;
+					int cx = cx0;
+					int cy = cy0;
 
 					// Target, in cell indexes:
-					int trg_cx = x2idx(scanPoints_x[idx]);
-					int trg_cy = y2idx(scanPoints_y[idx]);
+					int trg_cx = x2idx(scanPoints_x[beam]);
+					int trg_cy = y2idx(scanPoints_y[beam]);
 
 					// The x> comparison implicitly holds if x<0
 					ASSERT_(
@@ -280,7 +304,7 @@ bool COccupancyGridMap2D::internal_insertObservation(
 					int Acy_ = std::abs(Acy);
 
 					int nStepsRay = max(Acx_, Acy_);
-					if (!nStepsRay) continue;  // May be...
+					if (!nStepsRay) return;  // May be...
 
 					// Integers store "float values * 128"
 					float N_1 = 1.0f / nStepsRay;  // Avoid division twice.
@@ -293,15 +317,13 @@ bool COccupancyGridMap2D::internal_insertObservation(
 
 					int frCX = cx << FRBITS;
 					int frCY = cy << FRBITS;
-					const auto logodd_free = o.getScanRangeValidity(idx)
-												 ? logodd_observation_free
-												 : logodd_noecho_free;
+					const int logodd_free = o.getScanRangeValidity(beam)
+												? logodd_observation_free
+												: logodd_noecho_free;
 
 					for (int nStep = 0; nStep < nStepsRay; nStep++)
 					{
-						updateCell_fast_free(
-							cx, cy, logodd_free, logodd_thres_free, theMapArray,
-							theMapSize_x);
+						update(cx, cy, logodd_free);
 
 						frCX += frAcx;
 						frCY += frAcy;
@@ -314,13 +336,81 @@ bool COccupancyGridMap2D::internal_insertObservation(
 					// Only if:
 					//  - It was a valid ray, and
 					//  - The ray was not truncated
-					if (o.getScanRangeValidity(idx) &&
-						o.getScanRange(idx) < maxDistanceInsertion)
+					if (o.getScanRangeValidity(beam) &&
+						o.getScanRange(beam) < maxDistanceInsertion)
+						update(trg_cx, trg_cy, -logodd_observation_occupied);
+				};
+
+				// Saturating update of one cell:
+				const auto applyUpdate = [&](cellType* cell, int logodd) {
+					if (logodd > 0)
+						updateCell_fast_free(
+							cell, static_cast<cellType>(logodd),
+							logodd_thres_free);
+					else
 						updateCell_fast_occupied(
-							trg_cx, trg_cy, logodd_observation_occupied,
-							logodd_thres_occupied, theMapArray, theMapSize_x);
-
-				}  // End of each range
+							cell, static_cast<cellType>(-logodd),
+							logodd_thres_occupied);
+				};
+
+				const size_t nRays = (nRanges + K - 1) / K;
+				const unsigned int nThreads =
+					rayCastingThreads(insertionOptions.numThreads, nRays);
+				if (nThreads > 1 && map.size() <= UINT32_MAX)
+				{
+					// Parallel insertion: beams are split into one angular
+					// sector per thread, each one ray-cast into its own
+					// sparse list of cell updates, bucketed by bands of rows:
+					const size_t nBands = 4 * nThreads;
+					const size_t rowsPerBand = (size_y + nBands - 1) / nBands;
+					std::vector<std::vector<TCellUpdate>> updates(
+						nThreads * nBands);
+
+					const auto castSector = [&](size_t sector) {
+						auto* sectorUpdates = &updates[sector * nBands];
+						const size_t r0 = sector * nRays / nThreads;
+						const size_t r1 = (sector + 1) * nRays / nThreads;
+						for (size_t r = r0; r < r1; r++)
+							castRay(r * K, [&](int cx, int cy, int logodd) {
+								sectorUpdates[cy / rowsPerBand].push_back(
+									{static_cast<uint32_t>(cx + cy * size_x),
+									 logodd});
+							});
+					};
+					// Merge, one band of rows per task. Within each band,
+					// sectors are applied in order, so each cell receives its
+					// updates in the same order than in the serial version:
+					const auto mergeBand = [&](size_t band) {
+						for (size_t sector = 0; sector < nThreads; sector++)
+							for (const auto& u :
+								 updates[sector * nBands + band])
+								applyUpdate(theMapArray + u.cell, u.logodd);
+					};
+
+					mrpt::WorkerThreadsPool::sharedPool().parallel_for(
+						0, nThreads,
+						[&](size_t s0, size_t s1) {
+							for (size_t sector = s0; sector < s1; sector++)
+								castSector(sector);
+						},
+						1);
+					mrpt::WorkerThreadsPool::sharedPool().parallel_for(
+						0, nBands,
+						[&](size_t b0, size_t b1) {
+							for (size_t band = b0; band < b1; band++)
+								mergeBand(band);
+						},
+						1);
+				}
+				else
+				{
+					// Insert rays:
+					for (idx = 0; idx < nRanges; idx += K)
+						castRay(idx, [&](int cx, int cy, int logodd) {
+							applyUpdate(
+								theMapArray + cx + cy * theMapSize_x, logodd);
+						});
+				}
 
 				mrpt_alloca_free(scanPoints_x);
 				mrpt_alloca_free(scanPoints_y);
@@ -1338,6 +1428,7 @@ void COccupancyGridMap2D::TInsertionOptions::loadFromConfigFile(
 	MRPT_LOAD_CONFIG_VAR(CFD_features_gaussian_size, float, iniFile, section);
 	MRPT_LOAD_CONFIG_VAR(CFD_features_median_size, float, iniFile, section);
 	MRPT_LOAD_CONFIG_VAR(wideningBeamsWithDistance, bool, iniFile, section);
+	MRPT_LOAD_CONFIG_VAR(numThreads, int, iniFile, section);
 }
 
 /*---------------------------------------------------------------
@@ -1362,6 +1453,7 @@ void COccupancyGridMap2D::TInsertionOptions::dumpToTextStream(
 	LOADABLEOPTS_DUMP_VAR(CFD_features_gaussian_size, float)
 	LOADABLEOPTS_DUMP_VAR(CFD_features_median_size, float)
 	LOADABLEOPTS_DUMP_VAR(wideningBeamsWithDistance, bool)
+	LOADABLEOPTS_DUMP_VAR(numThreads, int)
 
 	out << "\n";
 }
@@ -9,10 +9,14 @@
 
 #include "maps-precomp.h"  // Precomp header
 
+#include <mrpt/core/WorkerThreadsPool.h>
+#include <mrpt/core/cpu.h>
 #include <mrpt/maps/COccupancyGridMap2D.h>
 #include <mrpt/maps/CSimplePointsMap.h>
+#include <mrpt/math/TPose2D.h>
 #include <mrpt/obs/CObservation2DRangeScan.h>
 #include <mrpt/obs/CObservationRange.h>
+#include <mrpt/obs/CSensoryFrame.h>
 #include <mrpt/serialization/CArchive.h>
 
 using namespace mrpt;
@@ -22,6 +26,9 @@ using namespace mrpt::obs;
 using namespace mrpt::poses;
 using namespace std;
 
+// Prototypes of SSE2/AVX2 optimized functions:
+#include "COccupancyGridMap2D.SSEx.h"
+
 /*---------------------------------------------------------------
  Computes the likelihood that a given observation was taken from a given pose in
  the world being modeled with this map.
@@ -521,9 +528,6 @@ double COccupancyGridMap2D::computeLikelihoodField_Thrun(
 
 	double ret;
 	size_t N = pm->size();
-	int K = (int)ceil(
-		likelihoodOptions.LF_maxCorrsDistance /*m*/ /
-		resolution);  // The size of the checking area for matchings:
 
 	bool Product_T_OrSum_F = !likelihoodOptions.LF_alternateAverageMethod;
 
@@ -565,16 +569,12 @@ double COccupancyGridMap2D::computeLikelihoodField_Thrun(
 				precomputedLikelihood.clear();
 
 			m_likelihoodCacheOutDated = false;
+			m_likelihoodCacheConcurrent = false;
 		}
 	}
 
-	cellType thresholdCellValue = p2l(0.5f);
 	int decimation = likelihoodOptions.LF_decimation;
 
-	const double _resolution = this->resolution;
-	const double constDist2DiscrUnits = 100 / (_resolution * _resolution);
-	const double constDist2DiscrUnits_INV = 1.0 / constDist2DiscrUnits;
-
 	if (N < 10) decimation = 1;
 
 	TPoint2D pointLocal;
@@ -628,61 +628,11 @@ double COccupancyGridMap2D::computeLikelihoodField_Thrun(
 				thisLik == LIK_LF_CACHE_INVALID)
 			{
 				// Compute now:
-				// -------------
-				// Find the closest occupied cell in a certain range, given by
-				// K:
-				int xx1 = max(0, cx - K);
-				int xx2 = min(size_x_1, (unsigned)(cx + K));
-				int yy1 = max(0, cy - K);
-				int yy2 = min(size_y_1, (unsigned)(cy + K));
-
-				// Optimized code: this part will be invoked a *lot* of times:
-				float occupiedMinDist;
-				{
-					cellType* mapPtr =
-						&map[xx1 + yy1 * size_x];  // Initial pointer position
-					unsigned incrAfterRow = size_x - ((xx2 - xx1) + 1);
-
-					signed int Ax0 = 10 * (xx1 - cx);
-					signed int Ay = 10 * (yy1 - cy);
-
-					unsigned int occupiedMinDistInt =
-						mrpt::round(maxCorrDist_sq * constDist2DiscrUnits);
-
-					for (int yy = yy1; yy <= yy2; yy++)
-					{
-						unsigned int Ay2 =
-							square((unsigned int)(Ay));  // Square is faster
-						// with unsigned.
-						signed short Ax = Ax0;
-						cellType cell;
-
-						for (int xx = xx1; xx <= xx2; xx++)
-						{
-							if ((cell = *mapPtr++) < thresholdCellValue)
-							{
-								unsigned int d =
-									square((unsigned int)(Ax)) + Ay2;
-								keep_min(occupiedMinDistInt, d);
-							}
-							Ax += 10;
-						}
-						// Go to (xx1,yy++)
-						mapPtr += incrAfterRow;
-						Ay += 10;
-					}
-
-					occupiedMinDist =
-						occupiedMinDistInt * constDist2DiscrUnits_INV;
-				}
-
-				if (likelihoodOptions.LF_useSquareDist)
-					occupiedMinDist *= occupiedMinDist;
-
-				thisLik = zRandomTerm + zHit * exp(Q * occupiedMinDist);
-
-				if (likelihoodOptions.enableLikelihoodCache)
-					// And save it into the table and into "thisLik":
+				thisLik = computeLikelihoodField_Thrun_cell(cx, cy);
+				// And save it into the table, unless other threads may be
+				// reading it (see prepareForConcurrentLikelihood()):
+				if (likelihoodOptions.enableLikelihoodCache &&
+					!m_likelihoodCacheConcurrent)
 					precomputedLikelihood[cx + cy * size_x] = thisLik;
 			}
 		}
@@ -706,6 +656,339 @@ double COccupancyGridMap2D::computeLikelihoodField_Thrun(
 	MRPT_END
 }
 
+/*---------------------------------------------------------------
+				computeLikelihoodField_Thrun_cell
+ ---------------------------------------------------------------*/
+double COccupancyGridMap2D::computeLikelihoodField_Thrun_cell(
+	int cx, int cy) const
+{
+	// The size of the checking area for matchings:
+	const int K = (int)ceil(likelihoodOptions.LF_maxCorrsDistance / resolution);
+
+	const float zHit = likelihoodOptions.LF_zHit;
+	const float zRandomTerm =
+		likelihoodOptions.LF_zRandom / likelihoodOptions.LF_maxRange;
+	const float Q = -0.5f / square(likelihoodOptions.LF_stdHit);
+	const double maxCorrDist_sq =
+		square(likelihoodOptions.LF_maxCorrsDistance);
+
+	const unsigned int size_x_1 = size_x - 1;
+	const unsigned int size_y_1 = size_y - 1;
+	const cellType thresholdCellValue = p2l(0.5f);
+
+	const double _resolution = this->resolution;
+	const double constDist2DiscrUnits = 100 / (_resolution * _resolution);
+	const double constDist2DiscrUnits_INV = 1.0 / constDist2DiscrUnits;
+
+	// Find the closest occupied cell in a certain range, given by K:
+	int xx1 = max(0, cx - K);
+	int xx2 = min(size_x_1, (unsigned)(cx + K));
+	int yy1 = max(0, cy - K);
+	int yy2 = min(size_y_1, (unsigned)(cy + K));
+
+	// Optimized code: this part will be invoked a *lot* of times:
+	float occupiedMinDist;
+	{
+		const cellType* mapPtr =
+			&map[xx1 + yy1 * size_x];  // Initial pointer position
+		unsigned incrAfterRow = size_x - ((xx2 - xx1) + 1);
+
+		signed int Ax0 = 10 * (xx1 - cx);
+		signed int Ay = 10 * (yy1 - cy);
+
+		unsigned int occupiedMinDistInt =
+			mrpt::round(maxCorrDist_sq * constDist2DiscrUnits);
+
+		for (int yy = yy1; yy <= yy2; yy++)
+		{
+			unsigned int Ay2 = square((unsigned int)(Ay));  // Square is faster
+			// with unsigned.
+			signed short Ax = Ax0;
+			cellType cell;
+
+			for (int xx = xx1; xx <= xx2; xx++)
+			{
+				if ((cell = *mapPtr++) < thresholdCellValue)
+				{
+					unsigned int d = square((unsigned int)(Ax)) + Ay2;
+					keep_min(occupiedMinDistInt, d);
+				}
+				Ax += 10;
+			}
+			// Go to (xx1,yy++)
+			mapPtr += incrAfterRow;
+			Ay += 10;
+		}
+
+		occupiedMinDist = occupiedMinDistInt * constDist2DiscrUnits_INV;
+	}
+
+	if (likelihoodOptions.LF_useSquareDist)
+		occupiedMinDist *= occupiedMinDist;
+
+	return zRandomTerm + zHit * exp(Q * occupiedMinDist);
+}
+
+/*---------------------------------------------------------------
+					computeLikelihoodField_Thrun
+ ---------------------------------------------------------------*/
+void COccupancyGridMap2D::computeLikelihoodField_Thrun(
+	const CPointsMap* pm, const std::vector<mrpt::math::TPose2D>& poses,
+	std::vector<double>& out_log_liks)
+{
+	MRPT_START
+
+	ASSERT_(pm != nullptr);
+	const size_t nPoses = poses.size();
+	out_log_liks.resize(nPoses);
+	if (!nPoses) return;
+
+	const size_t N = pm->size();
+	if (!N)
+	{
+		// No way to estimate this likelihood!!
+		out_log_liks.assign(nPoses, -100);
+		return;
+	}
+
+	// Only the default, product of likelihoods method with the cache
+	// enabled is vectorized:
+	if (likelihoodOptions.LF_alternateAverageMethod ||
+		!likelihoodOptions.enableLikelihoodCache || map.empty())
+	{
+		for (size_t i = 0; i < nPoses; i++)
+		{
+			const CPose2D p(poses[i]);
+			out_log_liks[i] = computeLikelihoodField_Thrun(pm, &p);
+		}
+		return;
+	}
+
+	// Reset the precomputed likelihood values map
+	if (m_likelihoodCacheOutDated)
+	{
+		precomputedLikelihood.assign(map.size(), LIK_LF_CACHE_INVALID);
+		m_likelihoodCacheOutDated = false;
+		m_likelihoodCacheConcurrent = false;
+	}
+
+	const float zHit = likelihoodOptions.LF_zHit;
+	const float zRandomTerm =
+		likelihoodOptions.LF_zRandom / likelihoodOptions.LF_maxRange;
+	const float Q = -0.5f / square(likelihoodOptions.LF_stdHit);
+	const double minimumLik = zRandomTerm +
+		zHit * exp(Q * square(likelihoodOptions.LF_maxCorrsDistance));
+
+	// Decimated points, in SoA layout:
+	const size_t decimation =
+		N < 10 ? 1 : std::max<size_t>(1, likelihoodOptions.LF_decimation);
+	std::vector<double> xs, ys;
+	xs.reserve(N / decimation + 1);
+	ys.reserve(N / decimation + 1);
+	for (size_t j = 0; j < N; j += decimation)
+	{
+		TPoint2D pt;
+		pm->getPoint(j, pt);
+		xs.push_back(pt.x);
+		ys.push_back(pt.y);
+	}
+	const size_t nPts = xs.size();
+
+	occgrid_cells_params_t g;
+	g.x_min = x_min;
+	g.y_min = y_min;
+	g.resolution = resolution;
+	g.size_x = size_x;
+	g.size_y = size_y;
+
+	const bool useAVX2 = mrpt::cpu::supports(mrpt::cpu::feature::AVX2);
+	const bool useSSE2 = mrpt::cpu::supports(mrpt::cpu::feature::SSE2);
+
+	std::vector<int32_t> idxs(nPts);
+	for (size_t i = 0; i < nPoses; i++)
+	{
+		const TPose2D& p = poses[i];
+		const double ccos = cos(p.phi), ssin = sin(p.phi);
+
+		// 1) Transform points and get their cell indices:
+#if MRPT_ARCH_INTEL_COMPATIBLE
+		if (useAVX2)
+			occgrid_AVX2_points_to_cells(
+				xs.data(), ys.data(), nPts, p.x, p.y, ccos, ssin, g,
+				idxs.data());
+		else if (useSSE2)
+			occgrid_SSE2_points_to_cells(
+				xs.data(), ys.data(), nPts, p.x, p.y, ccos, ssin, g,
+				idxs.data());
+		else
+#endif
+		{
+			for (size_t k = 0; k < nPts; k++)
+			{
+				const int cx = x2idx(p.x + xs[k] * ccos - ys[k] * ssin);
+				const int cy = y2idx(p.y + xs[k] * ssin + ys[k] * ccos);
+				idxs[k] = (static_cast<unsigned>(cx) >= size_x - 1 ||
+						   static_cast<unsigned>(cy) >= size_y - 1)
+					? -1
+					: cx + cy * static_cast<int32_t>(size_x);
+			}
+		}
+
+		// 2) Make sure all the involved cells are already in the cache:
+		for (size_t k = 0; k < nPts; k++)
+		{
+			const int32_t idx = idxs[k];
+			if (idx < 0 || precomputedLikelihood[idx] != LIK_LF_CACHE_INVALID)
+				continue;
+			precomputedLikelihood[idx] = computeLikelihoodField_Thrun_cell(
+				idx % static_cast<int32_t>(size_x),
+				idx / static_cast<int32_t>(size_x));
+		}
+
+		// 3) Accumulate log-likelihoods:
+		double ret = 0;
+#if MRPT_ARCH_INTEL_COMPATIBLE
+		if (useAVX2)
+			ret = occgrid_AVX2_sum_log_lik(
+				precomputedLikelihood.data(), idxs.data(), nPts, minimumLik);
+		else
+#endif
+		{
+			for (size_t k = 0; k < nPts; k++)
+				ret += log(
+					idxs[k] < 0 ? minimumLik : precomputedLikelihood[idxs[k]]);
+		}
+		out_log_liks[i] = ret;
+	}
+
+	MRPT_END
+}
+
+/*---------------------------------------------------------------
+		computeObservationLikelihoodMultiplePoses
+ ---------------------------------------------------------------*/
+void COccupancyGridMap2D::computeObservationLikelihoodMultiplePoses(
+	const CObservation& obs, const std::vector<mrpt::math::TPose2D>& poses,
+	std::vector<double>& out_log_liks)
+{
+	MRPT_START
+
+	// Use the batch implementation of the likelihood field for planar
+	// scans at the altitude of this map, exactly as in
+	// computeObservationLikelihood_likelihoodField_Thrun():
+	if (likelihoodOptions.likelihoodMethod == lmLikelihoodField_Thrun &&
+		IS_CLASS(obs, CObservation2DRangeScan))
+	{
+		const auto& o = dynamic_cast<const CObservation2DRangeScan&>(obs);
+		const bool validScan =
+			o.isPlanarScan(insertionOptions.horizontalTolerance) &&
+			(!insertionOptions.useMapAltitude ||
+			 fabs(insertionOptions.mapAltitude - o.sensorPose.z()) <= 0.01);
+		if (!validScan)
+		{
+			out_log_liks.assign(poses.size(), -10);
+			return;
+		}
+
+		CPointsMap::TInsertionOptions opts;
+		opts.minDistBetweenLaserPoints = resolution * 0.5f;
+		opts.isPlanarMap = true;  // Already filtered above!
+		opts.horizontalTolerance = insertionOptions.horizontalTolerance;
+
+		computeLikelihoodField_Thrun(
+			o.buildAuxPointsMap<mrpt::maps::CPointsMap>(&opts), poses,
+			out_log_liks);
+		return;
+	}
+
+	// Default: one by one.
+	out_log_liks.resize(poses.size());
+	for (size_t i = 0; i < poses.size(); i++)
+		out_log_liks[i] =
+			computeObservationLikelihood(obs, mrpt::poses::CPose2D(poses[i]));
+
+	MRPT_END
+}
+
+/*---------------------------------------------------------------
+		prepareForConcurrentLikelihood
+ ---------------------------------------------------------------*/
+bool COccupancyGridMap2D::prepareForConcurrentLikelihood(
+	const CSensoryFrame& sf, const TPoint3D& posesMin, const TPoint3D& posesMax)
+{
+	MRPT_START
+
+	switch (likelihoodOptions.likelihoodMethod)
+	{
+		// These ones modify members of the map while being evaluated:
+		case lmMeanInformation:
+		case lmConsensusOWA:
+			return false;
+
+		case lmLikelihoodField_Thrun:
+			break;
+
+		// The rest ones only read the map:
+		default:
+			return true;
+	};
+
+	if (!likelihoodOptions.enableLikelihoodCache || map.empty()) return true;
+
+	if (m_likelihoodCacheOutDated)
+	{
+		precomputedLikelihood.assign(map.size(), LIK_LF_CACHE_INVALID);
+		m_likelihoodCacheOutDated = false;
+	}
+	// From now on, cells out of the region below are evaluated without
+	// storing them in the cache:
+	m_likelihoodCacheConcurrent = true;
+
+	// Only the observations evaluated by
+	// computeObservationLikelihood_likelihoodField_Thrun() look up the cache,
+	// for points up to their maximum range from the robot poses:
+	double maxRange = -1;
+	for (const auto& obs : sf)
+	{
+		if (IS_CLASS(*obs, CObservation2DRangeScan))
+		{
+			const auto& o = static_cast<const CObservation2DRangeScan&>(*obs);
+			maxRange = std::max(maxRange, o.maxRange + o.sensorPose.norm());
+		}
+		else if (IS_CLASS(*obs, CObservationRange))
+		{
+			const auto& o = static_cast<const CObservationRange&>(*obs);
+			for (const auto& m : o.sensedData)
+				maxRange = std::max(
+					maxRange, o.maxSensorDistance + m.sensorPose.norm());
+		}
+	}
+	if (maxRange < 0) return true;
+
+	// Cells in the last row and column are never looked up:
+	const int cx0 = std::max(0, x2idx(posesMin.x - maxRange));
+	const int cx1 = std::min<int>(size_x - 1, x2idx(posesMax.x + maxRange) + 1);
+	const int cy0 = std::max(0, y2idx(posesMin.y - maxRange));
+	const int cy1 = std::min<int>(size_y - 1, y2idx(posesMax.y + maxRange) + 1);
+	if (cx0 >= cx1 || cy0 >= cy1) return true;
+
+	// Each thread writes to different cells:
+	mrpt::WorkerThreadsPool::sharedPool().parallel_for(
+		cy0, cy1, [&](size_t cyFirst, size_t cyLast) {
+			for (size_t cy = cyFirst; cy < cyLast; cy++)
+				for (int cx = cx0; cx < cx1; cx++)
+				{
+					double& lik = precomputedLikelihood[cx + cy * size_x];
+					if (lik != LIK_LF_CACHE_INVALID) continue;
+					lik = computeLikelihoodField_Thrun_cell(
+						cx, static_cast<int>(cy));
+				}
+		});
+	return true;
+
+	MRPT_END
+}
+
 /*---------------------------------------------------------------
 					computeLikelihoodField_II
  ---------------------------------------------------------------*/
@@ -8,9 +8,15 @@
    +------------------------------------------------------------------------+ */
 
 #include <gtest/gtest.h>
+#include <mrpt/core/WorkerThreadsPool.h>
+#include <mrpt/core/cpu.h>
 #include <mrpt/maps/COccupancyGridMap2D.h>
+#include <mrpt/maps/CSimplePointsMap.h>
+#include <mrpt/math/TPose2D.h>
 #include <mrpt/obs/CObservation2DRangeScan.h>
+#include <mrpt/obs/CSensoryFrame.h>
 #include <mrpt/obs/stock_observations.h>
+#include <mrpt/random.h>
 
 using namespace mrpt;
 using namespace mrpt::maps;
@@ -33,3 +39,110 @@ TEST(COccupancyGridMap2DTests, insert2DScan)
 		// should have a high "freeness"
 	}
 }
+
+TEST(COccupancyGridMap2DTests, likelihoodFieldManyPoses)
+{
+	mrpt::obs::CObservation2DRangeScan scan1;
+	stock_observations::example2DRangeScan(scan1);
+
+	COccupancyGridMap2D grid(-20.0f, 20.0f, -20.0f, 20.0f, 0.05f);
+	grid.insertObservation(scan1);
+
+	CSimplePointsMap pts;
+	pts.insertObservation(scan1);
+
+	std::vector<TPose2D> poses;
+	for (int i = 0; i < 50; i++)
+		poses.emplace_back(
+			-0.5 + 0.02 * i, 0.3 - 0.01 * i, mrpt::DEG2RAD(-10.0 + 0.4 * i));
+	// Far away, out of the grid:
+	poses.emplace_back(100.0, 100.0, 0.0);
+
+	const bool hadAVX2 = mrpt::cpu::supports(mrpt::cpu::feature::AVX2);
+	for (bool avx2 : {true, false})
+	{
+		if (avx2 && !hadAVX2) continue;
+		mrpt::cpu::overrideDetectedFeature(mrpt::cpu::feature::AVX2, avx2);
+
+		std::vector<double> liks;
+		grid.computeLikelihoodField_Thrun(&pts, poses, liks);
+		ASSERT_EQ(liks.size(), poses.size());
+
+		for (size_t i = 0; i < poses.size(); i++)
+		{
+			const CPose2D p(poses[i]);
+			const double lik = grid.computeLikelihoodField_Thrun(&pts, &p);
+			EXPECT_NEAR(lik, liks[i], 1e-6 * std::abs(lik)) << "i=" << i;
+		}
+	}
+	mrpt::cpu::overrideDetectedFeature(mrpt::cpu::feature::AVX2, hadAVX2);
+}
+
+TEST(COccupancyGridMap2DTests, prepareForConcurrentLikelihood)
+{
+	auto scan = CObservation2DRangeScan::Create();
+	stock_observations::example2DRangeScan(*scan);
+	scan->maxRange = 5.0f;
+
+	COccupancyGridMap2D grid(-20.0f, 20.0f, -20.0f, 20.0f, 0.05f);
+	grid.likelihoodOptions.likelihoodMethod =
+		COccupancyGridMap2D::lmLikelihoodField_Thrun;
+	grid.insertObservation(*scan);
+	COccupancyGridMap2D gridPrepared = grid;
+
+	// Only the cells within the scan range of these poses are cached:
+	CSensoryFrame sf;
+	sf.insert(scan);
+	EXPECT_TRUE(gridPrepared.prepareForConcurrentLikelihood(
+		sf, TPoint3D(-0.5, -0.5, 0), TPoint3D(0.5, 0.5, 0)));
+
+	// Poses out of that region must give the same likelihood anyway:
+	for (const auto& p : {CPose3D(0.2, -0.3, 0, 0.1, 0, 0),
+						  CPose3D(10.0, 10.0, 0, 0, 0, 0),
+						  CPose3D(-15.0, 5.0, 0, 2.0, 0, 0)})
+	{
+		EXPECT_EQ(
+			grid.computeObservationLikelihood(*scan, p),
+			gridPrepared.computeObservationLikelihood(*scan, p));
+	}
+}
+
+TEST(COccupancyGridMap2DTests, insert2DScanMultiThread)
+{
+	// A wide-FOV, high-resolution scan in a random environment, with some
+	// invalid ranges:
+	auto& rng = mrpt::random::getRandomGenerator();
+	rng.randomize(1234);
+	CObservation2DRangeScan scan;
+	scan.aperture = mrpt::DEG2RAD(270.0f);
+	scan.maxRange = 30.0f;
+	scan.resizeScan(2160);
+	for (size_t i = 0; i < scan.getScanSize(); i++)
+	{
+		scan.setScanRange(i, rng.drawUniform(0.5f, 20.0f));
+		scan.setScanRangeValidity(i, rng.drawUniform(0.0, 1.0) > 0.05);
+	}
+
+	const std::vector<CPose3D> poses = {CPose3D(0, 0, 0, 0, 0, 0),
+										CPose3D(1.0, 0.5, 0, 0.3, 0, 0),
+										CPose3D(-2.0, 1.0, 0, -2.0, 0, 0)};
+
+	// Run the parallel insertion even in single-core machines:
+	const auto formerNumCores = mrpt::WorkerThreadsPool::overrideNumCores(4);
+
+	COccupancyGridMap2D grid1(-10.0f, 10.0f, -10.0f, 10.0f, 0.05f);
+	COccupancyGridMap2D gridN = grid1;
+	gridN.insertionOptions.numThreads = 4;
+	for (const auto& p : poses)
+	{
+		grid1.insertObservation(scan, &p);
+		gridN.insertObservation(scan, &p);
+	}
+
+	mrpt::WorkerThreadsPool::overrideNumCores(formerNumCores);
+
+	// The result must be exactly the same than that of the serial insertion:
+	ASSERT_EQ(grid1.getSizeX(), gridN.getSizeX());
+	ASSERT_EQ(grid1.getSizeY(), gridN.getSizeY());
+	EXPECT_TRUE(grid1.getRawMap() == gridN.getRawMap());
+}
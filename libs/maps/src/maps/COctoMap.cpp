@@ -143,8 +143,15 @@ bool COctoMap::internal_insertObservation(
 			obs, robotPose, sensorPt, scan))
 		return false;  // Nothing to do.
 	// Insert rays:
-	m_impl->m_octomap.insertPointCloud(
-		scan, sensorPt, insertionOptions.maxrange, insertionOptions.pruning);
+	if (insertionOptions.batchedInsertion)
+	{
+		internal_insertPointCloudBatched(sensorPt, scan);
+		if (insertionOptions.pruning) m_impl->m_octomap.prune();
+	}
+	else
+		m_impl->m_octomap.insertPointCloud(
+			scan, sensorPt, insertionOptions.maxrange,
+			insertionOptions.pruning);
 	return true;
 }
 
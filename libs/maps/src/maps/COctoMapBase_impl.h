@@ -8,6 +8,7 @@
    +------------------------------------------------------------------------+ */
 
 // This file is to be included from <mrpt/maps/COctoMapBase.h>
+#include <mrpt/core/WorkerThreadsPool.h>
 #include <mrpt/io/CFileOutputStream.h>
 #include <mrpt/maps/CPointsMap.h>
 #include <mrpt/obs/CObservation2DRangeScan.h>
@@ -15,6 +16,9 @@
 #include <mrpt/obs/CObservationPointCloud.h>
 #include <mrpt/obs/CObservationVelodyneScan.h>
 #include <mrpt/serialization/CArchive.h>
+#include <algorithm>
+#include <functional>
+#include <vector>
 
 namespace mrpt::maps
 {
@@ -265,6 +269,15 @@ void COctoMapBase<OCTREE, OCTREE_NODE>::insertPointCloud(
 	size_t N;
 	const float *xs, *ys, *zs;
 	ptMap.getPointsBuffer(N, xs, ys, zs);
+	if (insertionOptions.batchedInsertion)
+	{
+		octomap::Pointcloud scan;
+		scan.reserve(N);
+		for (size_t i = 0; i < N; i++) scan.push_back(xs[i], ys[i], zs[i]);
+		internal_insertPointCloudBatched(sensorPt, scan);
+		if (insertionOptions.pruning) m_impl->m_octomap.prune();
+		return;
+	}
 	for (size_t i = 0; i < N; i++)
 		m_impl->m_octomap.insertRay(
 			sensorPt, octomap::point3d(xs[i], ys[i], zs[i]),
@@ -272,6 +285,120 @@ void COctoMapBase<OCTREE, OCTREE_NODE>::insertPointCloud(
 	MRPT_END
 }
 
+template <class OCTREE, class OCTREE_NODE>
+template <class octomap_point3d, class octomap_pointcloud>
+void COctoMapBase<OCTREE, OCTREE_NODE>::internal_insertPointCloudBatched(
+	const octomap_point3d& sensorPt, const octomap_pointcloud& scan)
+{
+	MRPT_START
+
+	using octomap::KeySet;
+	using octomap::OcTreeKey;
+
+	auto& tree = m_impl->m_octomap;
+	const size_t N = scan.size();
+	const double maxrange = insertionOptions.maxrange;
+
+	const unsigned int numThreads =
+		mrpt::WorkerThreadsPool::clampNumThreads(insertionOptions.numThreads);
+
+	// Points are split in one chunk per thread. The keys found in each chunk
+	// are stored in one hash set per "shard", so sets of all chunks can be
+	// later merged in parallel, shard by shard:
+	const size_t nChunks = std::max<size_t>(1, std::min<size_t>(numThreads, N));
+	const size_t nShards = (nChunks == 1) ? 1 : 4 * nChunks;
+	const auto shardOf = [nShards](const OcTreeKey& k) -> size_t {
+		// A hash function different than the one in KeySet:
+		return ((k[0] * 73856093U) ^ (k[1] * 19349663U) ^
+				(k[2] * 83492791U)) %
+			   nShards;
+	};
+	// Indices: [chunk * nShards + shard]
+	std::vector<KeySet> freeCells(nChunks * nShards),
+		occupiedCells(nChunks * nShards);
+
+	const auto runParallel = [&](size_t n,
+								 const std::function<void(size_t)>& f) {
+		if (nChunks == 1)
+		{
+			for (size_t i = 0; i < n; i++) f(i);
+			return;
+		}
+		mrpt::WorkerThreadsPool::sharedPool().parallel_for(
+			0, n,
+			[&](size_t first, size_t last) {
+				for (size_t i = first; i < last; i++) f(i);
+			},
+			1);
+	};
+
+	// 1) Key rays, as in octomap's computeUpdate():
+	const size_t chunkSize = (N + nChunks - 1) / nChunks;
+	runParallel(nChunks, [&](size_t chunk) {
+		KeySet* freeSets = &freeCells[chunk * nShards];
+		KeySet* occupiedSets = &occupiedCells[chunk * nShards];
+		octomap::KeyRay ray;
+		const auto addFreeRay = [&](const octomap_point3d& end) {
+			if (tree.computeRayKeys(sensorPt, end, ray))
+				for (const auto& k : ray) freeSets[shardOf(k)].insert(k);
+		};
+
+		const size_t last = std::min(N, (chunk + 1) * chunkSize);
+		for (size_t i = chunk * chunkSize; i < last; i++)
+		{
+			const octomap_point3d p = scan.getPoint(static_cast<unsigned>(i));
+			if (maxrange < 0.0 || (p - sensorPt).norm() <= maxrange)
+			{
+				// free cells, and occupied endpoint:
+				addFreeRay(p);
+				OcTreeKey key;
+				if (tree.coordToKeyChecked(p, key))
+					occupiedSets[shardOf(key)].insert(key);
+			}
+			else
+			{
+				// user set a maxrange and length is above:
+				const octomap_point3d direction = (p - sensorPt).normalized();
+				addFreeRay(sensorPt + direction * static_cast<float>(maxrange));
+			}
+		}
+	});
+
+	// 2) Merge all chunks into those of chunk #0, and prefer occupied cells
+	// over free ones (making sets disjoint):
+	runParallel(nShards, [&](size_t shard) {
+		KeySet& freeSet = freeCells[shard];
+		KeySet& occupiedSet = occupiedCells[shard];
+		for (size_t chunk = 1; chunk < nChunks; chunk++)
+		{
+			KeySet& f = freeCells[chunk * nShards + shard];
+			KeySet& o = occupiedCells[chunk * nShards + shard];
+			freeSet.insert(f.begin(), f.end());
+			occupiedSet.insert(o.begin(), o.end());
+			KeySet().swap(f);
+			KeySet().swap(o);
+		}
+		for (auto it = freeSet.begin(); it != freeSet.end();)
+		{
+			if (occupiedSet.count(*it) != 0)
+				it = freeSet.erase(it);
+			else
+				++it;
+		}
+	});
+
+	// 3) Update the tree:
+	const bool lazy = insertionOptions.lazyInnerNodesUpdate;
+	for (size_t shard = 0; shard < nShards; shard++)
+		for (const auto& k : freeCells[shard]) tree.updateNode(k, false, lazy);
+	for (size_t shard = 0; shard < nShards; shard++)
+		for (const auto& k : occupiedCells[shard])
+			tree.updateNode(k, true, lazy);
+	if (lazy) tree.updateInnerOccupancy();
+
+	MRPT_END
+}
+
 template <class OCTREE, class OCTREE_NODE>
 bool COctoMapBase<OCTREE, OCTREE_NODE>::castRay(
 	const mrpt::math::TPoint3D& origin, const mrpt::math::TPoint3D& direction,
@@ -356,6 +483,9 @@ void COctoMapBase<OCTREE, OCTREE_NODE>::TInsertionOptions::dumpToTextStream(
 
 	LOADABLEOPTS_DUMP_VAR(maxrange, double);
 	LOADABLEOPTS_DUMP_VAR(pruning, bool);
+	LOADABLEOPTS_DUMP_VAR(batchedInsertion, bool);
+	LOADABLEOPTS_DUMP_VAR(numThreads, int);
+	LOADABLEOPTS_DUMP_VAR(lazyInnerNodesUpdate, bool);
 
 	LOADABLEOPTS_DUMP_VAR(getOccupancyThres(), double);
 	LOADABLEOPTS_DUMP_VAR(getProbHit(), double);
@@ -385,6 +515,9 @@ void COctoMapBase<OCTREE, OCTREE_NODE>::TInsertionOptions::loadFromConfigFile(
 {
 	MRPT_LOAD_CONFIG_VAR(maxrange, double, iniFile, section);
 	MRPT_LOAD_CONFIG_VAR(pruning, bool, iniFile, section);
+	MRPT_LOAD_CONFIG_VAR(batchedInsertion, bool, iniFile, section);
+	MRPT_LOAD_CONFIG_VAR(numThreads, int, iniFile, section);
+	MRPT_LOAD_CONFIG_VAR(lazyInnerNodesUpdate, bool, iniFile, section);
 
 	MRPT_LOAD_CONFIG_VAR(occupancyThres, double, iniFile, section);
 	MRPT_LOAD_CONFIG_VAR(probHit, double, iniFile, section);
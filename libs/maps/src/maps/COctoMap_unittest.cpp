@@ -8,6 +8,7 @@
    +------------------------------------------------------------------------+ */
 
 #include <gtest/gtest.h>
+#include <mrpt/core/WorkerThreadsPool.h>
 #include <mrpt/maps/COctoMap.h>
 #include <mrpt/obs/CObservation2DRangeScan.h>
 #include <mrpt/obs/stock_observations.h>
@@ -60,3 +61,47 @@ TEST(COctoMapTests, insert2DScan)
 		map.insertObservation(scan1);
 	}
 }
+
+TEST(COctoMapTests, insert2DScanBatched)
+{
+	mrpt::obs::CObservation2DRangeScan scan1;
+	stock_observations::example2DRangeScan(scan1);
+	const CPose3D robotPose(0.5, -0.2, 0.1, 0.3, 0.05, 0.02);
+
+	COctoMap map_ref(0.1);
+	map_ref.insertObservation(scan1, &robotPose);
+
+	// Run the parallel insertion even in single-core machines:
+	const auto formerNumCores = mrpt::WorkerThreadsPool::overrideNumCores(3);
+
+	for (const unsigned int numThreads : {1U, 3U})
+	{
+		for (const bool lazy : {true, false})
+		{
+			COctoMap map(0.1);
+			map.insertionOptions.batchedInsertion = true;
+			map.insertionOptions.numThreads = numThreads;
+			map.insertionOptions.lazyInnerNodesUpdate = lazy;
+			map.insertObservation(scan1, &robotPose);
+
+			// Same occupancy for all voxels, free or occupied:
+			size_t nMapped = 0;
+			for (float x = -5.95f; x < 6.0f; x += 0.1f)
+				for (float y = -5.95f; y < 6.0f; y += 0.1f)
+					for (float z = -0.45f; z < 0.6f; z += 0.1f)
+					{
+						double occ_ref = 0, occ = 0;
+						const bool is_mapped =
+							map.getPointOccupancy(x, y, z, occ);
+						EXPECT_EQ(
+							is_mapped,
+							map_ref.getPointOccupancy(x, y, z, occ_ref));
+						if (!is_mapped) continue;
+						EXPECT_NEAR(occ, occ_ref, 1e-6);
+						nMapped++;
+					}
+			EXPECT_GT(nMapped, 100U);
+		}
+	}
+	mrpt::WorkerThreadsPool::overrideNumCores(formerNumCores);
+}
@@ -25,12 +25,15 @@
 #include <mrpt/system/CTicTac.h>
 #include <mrpt/system/CTimeLogger.h>
 #include <mrpt/system/os.h>
+#include <Eigen/Dense>
 #include <fstream>
 #include <sstream>
 
 #include <mrpt/core/SSE_macros.h>
 #include <mrpt/core/SSE_types.h>
 
+#include "parallelPointsLoop.h"
+
 #if MRPT_HAS_MATLAB
 #include <mexplus.h>
 #endif
@@ -46,6 +49,8 @@ using namespace std;
 
 IMPLEMENTS_VIRTUAL_SERIALIZABLE(CPointsMap, CMetricMap, mrpt::maps)
 
+using mrpt::maps::internal::parallelPointsLoop;
+
 /*---------------------------------------------------------------
 						Constructor
   ---------------------------------------------------------------*/
@@ -312,12 +317,6 @@ void CPointsMap::determineMatching2D(
 	float global_y_min = std::numeric_limits<float>::max(),
 		  global_y_max = -std::numeric_limits<float>::max();
 
-	double maxDistForCorrespondenceSquared;
-	float x_local, y_local;
-	unsigned int localIdx;
-
-	const float *x_other_it, *y_other_it, *z_other_it;
-
 	// Prepare output: no correspondences initially:
 	correspondences.clear();
 	correspondences.reserve(nLocalPoints);
@@ -444,37 +443,43 @@ void CPointsMap::determineMatching2D(
 		local_y_min > global_y_max || local_y_max < global_y_min)
 		return;  // We know for sure there is no matching at all
 
-	// Loop for each point in local map:
+	// Nearest neighbor of each decimated local point in "this" (global)
+	// map, by means of the KD-tree:
 	// --------------------------------------------------
-	for (localIdx = params.offset_other_map_points,
-		x_other_it = &otherMap->m_x[params.offset_other_map_points],
-		y_other_it = &otherMap->m_y[params.offset_other_map_points],
-		z_other_it = &otherMap->m_z[params.offset_other_map_points];
-		 localIdx < nLocalPoints;
-		 x_other_it += params.decimation_other_map_points,
-		y_other_it += params.decimation_other_map_points,
-		z_other_it += params.decimation_other_map_points,
-		localIdx += params.decimation_other_map_points)
+	const size_t offset = params.offset_other_map_points;
+	const size_t decim = params.decimation_other_map_points;
+	const size_t nQueries =
+		offset < nLocalPoints ? (nLocalPoints - offset + decim - 1) / decim
+							  : 0;
+
+	std::vector<float> qxs(nQueries), qys(nQueries);
+	for (size_t k = 0; k < nQueries; k++)
 	{
-		// For speed-up:
-		x_local = x_locals[localIdx];  // *x_locals_it;
-		y_local = y_locals[localIdx];  // *y_locals_it;
-
-		// Find all the matchings in the requested distance:
+		qxs[k] = x_locals[offset + k * decim];
+		qys[k] = y_locals[offset + k * decim];
+	}
 
-		// KD-TREE implementation =================================
-		// Use a KD-tree to look for the nearnest neighbor of:
-		//   (x_local, y_local, z_local)
-		// In "this" (global/reference) points map.
+	std::vector<size_t> nnIdxs(nQueries);
+	std::vector<float> nnSqrDists(nQueries);
+	// Built from this thread, not lazily by the first worker:
+	kdTreeEnsureIndexBuilt2D();
+	parallelPointsLoop(nQueries, params.numThreads, [&](size_t i0, size_t i1) {
+		kdTreeClosestPoint2DBatch(
+			qxs.data() + i0, qys.data() + i0, i1 - i0, nnIdxs.data() + i0,
+			nnSqrDists.data() + i0);
+	});
 
-		float tentativ_err_sq;
-		unsigned int tentativ_this_idx = kdTreeClosestPoint2D(
-			x_local, y_local,  // Look closest to this guy
-			tentativ_err_sq  // save here the min. distance squared
-		);
+	// Loop for each point in local map:
+	// --------------------------------------------------
+	for (size_t k = 0; k < nQueries; k++)
+	{
+		const size_t localIdx = offset + k * decim;
+		const float x_local = qxs[k], y_local = qys[k];
+		const size_t tentativ_this_idx = nnIdxs[k];
+		const float tentativ_err_sq = nnSqrDists[k];
 
 		// Compute max. allowed distance:
-		maxDistForCorrespondenceSquared = square(
+		const double maxDistForCorrespondenceSquared = square(
 			params.maxAngularDistForCorrespondence *
 				std::sqrt(
 					square(params.angularDistPivotPoint.x - x_local) +
@@ -495,9 +500,9 @@ void CPointsMap::determineMatching2D(
 			p.this_z = m_z[tentativ_this_idx];
 
 			p.other_idx = localIdx;
-			p.other_x = *x_other_it;
-			p.other_y = *y_other_it;
-			p.other_z = *z_other_it;
+			p.other_x = otherMap->m_x[localIdx];
+			p.other_y = otherMap->m_y[localIdx];
+			p.other_z = otherMap->m_z[localIdx];
 
 			p.errorSquareAfterTransformation = tentativ_err_sq;
 
@@ -870,6 +875,19 @@ void CPointsMap::getAllPoints(
 	MRPT_END
 }
 
+/*---------------------------------------------------------------
+						prepareForConcurrentLikelihood
+---------------------------------------------------------------*/
+bool CPointsMap::prepareForConcurrentLikelihood(
+	[[maybe_unused]] const CSensoryFrame& sf,
+	[[maybe_unused]] const TPoint3D& posesMin,
+	[[maybe_unused]] const TPoint3D& posesMax)
+{
+	kdTreeEnsureIndexBuilt2D();
+	kdTreeEnsureIndexBuilt3D();
+	return true;
+}
+
 /*---------------------------------------------------------------
 						squareDistanceToClosestCorrespondence
 ---------------------------------------------------------------*/
@@ -1037,6 +1055,72 @@ void CPointsMap::boundingBox(
 	MRPT_END
 }
 
+const CPointsMap::TLocalStructure& CPointsMap::getLocalStructure(
+	size_t knn, unsigned int numThreads) const
+{
+	MRPT_START
+	ASSERT_GE_(knn, 3U);
+
+	std::lock_guard<std::mutex> lck(m_localStructureMtx);
+	if (m_localStructureKNN == knn) return m_localStructure;
+
+	const size_t N = size();
+	const size_t k = std::min(knn, N);
+
+	auto& ls = m_localStructure;
+	ls.normals.resize(N);
+	ls.planeCovs.resize(N);
+
+	// Built from this thread, not lazily by the first worker:
+	if (k >= 3) kdTreeEnsureIndexBuilt3D();
+	parallelPointsLoop(N, numThreads, [&](size_t i0, size_t i1) {
+		std::vector<size_t> idxs;
+		std::vector<float> dists;
+		for (size_t i = i0; i < i1; i++)
+		{
+			if (k < 3)
+			{
+				// Not enough points to fit a plane:
+				ls.normals[i] = mrpt::math::TVector3Df(0, 0, 1);
+				ls.planeCovs[i].setIdentity();
+				continue;
+			}
+
+			kdTreeNClosestPoint3DIdx(m_x[i], m_y[i], m_z[i], k, idxs, dists);
+
+			Eigen::Vector3d mean = Eigen::Vector3d::Zero();
+			for (const size_t j : idxs)
+				mean += Eigen::Vector3d(m_x[j], m_y[j], m_z[j]);
+			mean /= static_cast<double>(k);
+
+			Eigen::Matrix3d cov = Eigen::Matrix3d::Zero();
+			for (const size_t j : idxs)
+			{
+				const Eigen::Vector3d d =
+					Eigen::Vector3d(m_x[j], m_y[j], m_z[j]) - mean;
+				cov += d * d.transpose();
+			}
+
+			// Eigenvalues in increasing order: the first eigenvector is the
+			// plane normal.
+			const Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> es(cov);
+			const Eigen::Matrix3d& V = es.eigenvectors();
+
+			ls.normals[i] = mrpt::math::TVector3Df(
+				d2f(V(0, 0)), d2f(V(1, 0)), d2f(V(2, 0)));
+
+			const Eigen::Vector3d regEigVals(
+				LOCAL_STRUCTURE_PLANE_EPSILON, 1.0, 1.0);
+			ls.planeCovs[i] =
+				(V * regEigVals.asDiagonal() * V.transpose()).cast<float>();
+		}
+	});
+
+	m_localStructureKNN = knn;
+	return m_localStructure;
+	MRPT_END
+}
+
 /*---------------------------------------------------------------
 				computeMatchingWith3D
 ---------------------------------------------------------------*/
@@ -1070,8 +1154,6 @@ void CPointsMap::determineMatching3D(
 	float local_z_min = std::numeric_limits<float>::max(),
 		  local_z_max = -std::numeric_limits<float>::max();
 
-	double maxDistForCorrespondenceSquared;
-
 	// Prepare output: no correspondences initially:
 	correspondences.clear();
 	correspondences.reserve(nLocalPoints);
@@ -1083,22 +1165,26 @@ void CPointsMap::determineMatching3D(
 	if (!nGlobalPoints || !nLocalPoints) return;
 
 	// Try to do matching only if the bounding boxes have some overlap:
-	// Transform all local points:
-	vector<float> x_locals(nLocalPoints), y_locals(nLocalPoints),
-		z_locals(nLocalPoints);
+	// Transform all the (decimated) local points:
+	const size_t offset = params.offset_other_map_points;
+	const size_t decim = params.decimation_other_map_points;
+	const size_t nQueries =
+		offset < nLocalPoints ? (nLocalPoints - offset + decim - 1) / decim
+							  : 0;
+
+	vector<float> x_locals(nQueries), y_locals(nQueries), z_locals(nQueries);
 
-	for (unsigned int localIdx = params.offset_other_map_points;
-		 localIdx < nLocalPoints;
-		 localIdx += params.decimation_other_map_points)
+	for (size_t k = 0; k < nQueries; k++)
 	{
+		const size_t localIdx = offset + k * decim;
 		float x_local, y_local, z_local;
 		otherMapPose.composePoint(
 			otherMap->m_x[localIdx], otherMap->m_y[localIdx],
 			otherMap->m_z[localIdx], x_local, y_local, z_local);
 
-		x_locals[localIdx] = x_local;
-		y_locals[localIdx] = y_local;
-		z_locals[localIdx] = z_local;
+		x_locals[k] = x_local;
+		y_locals[k] = y_local;
+		z_locals[k] = z_local;
 
 		// Find the bounding box:
 		local_x_min = min(local_x_min, x_local);
@@ -1122,65 +1208,60 @@ void CPointsMap::determineMatching3D(
 		local_y_min > global_y_max || local_y_max < global_y_min)
 		return;  // No need to compute: matching is ZERO.
 
+	// KD-TREE implementation: look for the nearest neighbor of each local
+	// point in "this" (global/reference) points map:
+	std::vector<size_t> nnIdxs(nQueries);
+	std::vector<float> nnSqrDists(nQueries);
+	// Built from this thread, not lazily by the first worker:
+	kdTreeEnsureIndexBuilt3D();
+	parallelPointsLoop(nQueries, params.numThreads, [&](size_t i0, size_t i1) {
+		kdTreeClosestPoint3DBatch(
+			x_locals.data() + i0, y_locals.data() + i0, z_locals.data() + i0,
+			i1 - i0, nnIdxs.data() + i0, nnSqrDists.data() + i0);
+	});
+
 	// Loop for each point in local map:
 	// --------------------------------------------------
-	for (unsigned int localIdx = params.offset_other_map_points;
-		 localIdx < nLocalPoints;
-		 localIdx += params.decimation_other_map_points)
+	for (size_t k = 0; k < nQueries; k++)
 	{
-		// For speed-up:
-		const float x_local = x_locals[localIdx];
-		const float y_local = y_locals[localIdx];
-		const float z_local = z_locals[localIdx];
-
-		{
-			// KD-TREE implementation
-			// Use a KD-tree to look for the nearnest neighbor of:
-			//   (x_local, y_local, z_local)
-			// In "this" (global/reference) points map.
-
-			float tentativ_err_sq;
-			const unsigned int tentativ_this_idx = kdTreeClosestPoint3D(
-				x_local, y_local, z_local,  // Look closest to this guy
-				tentativ_err_sq  // save here the min. distance squared
-			);
+		const size_t localIdx = offset + k * decim;
+		const size_t tentativ_this_idx = nnIdxs[k];
+		const float tentativ_err_sq = nnSqrDists[k];
 
-			// Compute max. allowed distance:
-			maxDistForCorrespondenceSquared = square(
-				params.maxAngularDistForCorrespondence *
-					params.angularDistPivotPoint.distanceTo(
-						TPoint3D(x_local, y_local, z_local)) +
-				params.maxDistForCorrespondence);
-
-			// Distance below the threshold??
-			if (tentativ_err_sq < maxDistForCorrespondenceSquared)
-			{
-				// Save all the correspondences:
-				tempCorrs.resize(tempCorrs.size() + 1);
+		// Compute max. allowed distance:
+		const double maxDistForCorrespondenceSquared = square(
+			params.maxAngularDistForCorrespondence *
+				params.angularDistPivotPoint.distanceTo(
+					TPoint3D(x_locals[k], y_locals[k], z_locals[k])) +
+			params.maxDistForCorrespondence);
 
-				TMatchingPair& p = tempCorrs.back();
+		// Distance below the threshold??
+		if (tentativ_err_sq < maxDistForCorrespondenceSquared)
+		{
+			// Save all the correspondences:
+			tempCorrs.resize(tempCorrs.size() + 1);
 
-				p.this_idx = tentativ_this_idx;
-				p.this_x = m_x[tentativ_this_idx];
-				p.this_y = m_y[tentativ_this_idx];
-				p.this_z = m_z[tentativ_this_idx];
+			TMatchingPair& p = tempCorrs.back();
 
-				p.other_idx = localIdx;
-				p.other_x = otherMap->m_x[localIdx];
-				p.other_y = otherMap->m_y[localIdx];
-				p.other_z = otherMap->m_z[localIdx];
+			p.this_idx = tentativ_this_idx;
+			p.this_x = m_x[tentativ_this_idx];
+			p.this_y = m_y[tentativ_this_idx];
+			p.this_z = m_z[tentativ_this_idx];
 
-				p.errorSquareAfterTransformation = tentativ_err_sq;
+			p.other_idx = localIdx;
+			p.other_x = otherMap->m_x[localIdx];
+			p.other_y = otherMap->m_y[localIdx];
+			p.other_z = otherMap->m_z[localIdx];
 
-				// At least one:
-				nOtherMapPointsWithCorrespondence++;
+			p.errorSquareAfterTransformation = tentativ_err_sq;
 
-				// Accumulate the MSE:
-				_sumSqrDist += p.errorSquareAfterTransformation;
-				_sumSqrCount++;
-			}
+			// At least one:
+			nOtherMapPointsWithCorrespondence++;
 
-		}  // End of test_match
+			// Accumulate the MSE:
+			_sumSqrDist += p.errorSquareAfterTransformation;
+			_sumSqrCount++;
+		}
 	}  // For each local point
 
 	// Additional consistency filter: "onlyKeepTheClosest" up to now
@@ -1637,6 +1718,21 @@ void CPointsMap::PLY_export_get_vertex(
 	pt.z = m_z[idx];
 }
 
+void CPointsMap::resizeForAppending(size_t newLength)
+{
+	m_resizingForAppending = true;
+	try
+	{
+		resize(newLength);
+	}
+	catch (...)
+	{
+		m_resizingForAppending = false;
+		throw;
+	}
+	m_resizingForAppending = false;
+}
+
 // Generic implementation (a more optimized one should exist in derived
 // classes):
 void CPointsMap::addFrom(const CPointsMap& anotherMap)
@@ -1646,7 +1742,7 @@ void CPointsMap::addFrom(const CPointsMap& anotherMap)
 
 	const size_t nTot = nThis + nOther;
 
-	this->resize(nTot);
+	this->resizeForAppending(nTot);
 
 	for (size_t i = 0, j = nThis; i < nOther; i++, j++)
 	{
@@ -1658,7 +1754,7 @@ void CPointsMap::addFrom(const CPointsMap& anotherMap)
 	// Also copy other data fields (color, ...)
 	addFrom_classSpecific(anotherMap, nThis);
 
-	mark_as_modified();
+	mark_as_appended();
 }
 
 /*---------------------------------------------------------------
@@ -1697,7 +1793,7 @@ void CPointsMap::insertAnotherMap(
 	const size_t N_other = otherMap->size();
 
 	// Set the new size:
-	this->resize(N_this + N_other);
+	this->resizeForAppending(N_this + N_other);
 
 	mrpt::math::TPoint3Df pt;
 	size_t src, dst;
@@ -1717,7 +1813,7 @@ void CPointsMap::insertAnotherMap(
 	// Also copy other data fields (color, ...)
 	addFrom_classSpecific(*otherMap, N_this);
 
-	mark_as_modified();
+	mark_as_appended();
 }
 
 /** Helper method for ::copyFrom() */
@@ -1738,6 +1834,7 @@ void CPointsMap::base_copyFrom(const CPointsMap& obj)
 	// Fill missing fields (R,G,B,min_dist) with default values.
 	this->resize(m_x.size());
 
+	m_localStructureKNN = 0;
 	kdtree_mark_as_outdated();
 
 	MRPT_END
@@ -1771,7 +1868,7 @@ bool CPointsMap::internal_insertObservation(
 		/********************************************************************
 					OBSERVATION TYPE: CObservation2DRangeScan
 		 ********************************************************************/
-		mark_as_modified();
+		mark_as_appended();
 
 		const auto& o = static_cast<const CObservation2DRangeScan&>(obs);
 		// Insert only HORIZONTAL scans??
@@ -1865,7 +1962,7 @@ bool CPointsMap::internal_insertObservation(
 		/********************************************************************
 					OBSERVATION TYPE: CObservation3DRangeScan
 		 ********************************************************************/
-		mark_as_modified();
+		mark_as_appended();
 
 		const auto& o = static_cast<const CObservation3DRangeScan&>(obs);
 		// Insert only HORIZONTAL scans??
@@ -1922,7 +2019,7 @@ bool CPointsMap::internal_insertObservation(
 		/********************************************************************
 					OBSERVATION TYPE: CObservationRange  (IRs, Sonars, etc.)
 		 ********************************************************************/
-		mark_as_modified();
+		mark_as_appended();
 
 		const auto& o = static_cast<const CObservationRange&>(obs);
 
@@ -1967,7 +2064,7 @@ bool CPointsMap::internal_insertObservation(
 		/********************************************************************
 					OBSERVATION TYPE: CObservationVelodyneScan
 		 ********************************************************************/
-		mark_as_modified();
+		mark_as_appended();
 
 		const auto& o = static_cast<const CObservationVelodyneScan&>(obs);
 
@@ -1995,7 +2092,7 @@ bool CPointsMap::internal_insertObservation(
 	}
 	else if (IS_CLASS(obs, CObservationPointCloud))
 	{
-		mark_as_modified();
+		mark_as_appended();
 
 		const auto& o = static_cast<const CObservationPointCloud&>(obs);
 		ASSERT_(o.pointcloud);
@@ -2118,6 +2215,8 @@ void CPointsMap::fuseWith(
 			if (notFusedPoints) (*notFusedPoints).push_back(false);
 		}
 	}
+	// Existing points have been moved since the KD-tree was last built:
+	mark_as_modified();
 }
 
 void CPointsMap::loadFromVelodyneScan(
@@ -2128,20 +2227,27 @@ void CPointsMap::loadFromVelodyneScan(
 	ASSERT_EQUAL_(scan.point_cloud.x.size(), scan.point_cloud.z.size());
 	ASSERT_EQUAL_(scan.point_cloud.x.size(), scan.point_cloud.intensity.size());
 
-	if (scan.point_cloud.x.empty()) return;
-
-	this->mark_as_modified();
+	// Without a point cloud, points are decoded from the raw packets:
+	const bool fromPackets = scan.point_cloud.x.empty();
+	if (fromPackets && scan.scan_packets.empty()) return;
 
 	// Insert vs. load and replace:
-	if (!insertionOptions.addToExistingPointsMap)
-		resize(0);  // Resize to 0 instead of clear() so the std::vector<>
-	// memory is not actually deallocated and can be reused.
+	if (insertionOptions.addToExistingPointsMap)
+		this->mark_as_appended();
+	else
+	{
+		this->mark_as_modified();
+		// Resize to 0 instead of clear() so the std::vector<> memory is not
+		// actually deallocated and can be reused.
+		resize(0);
+	}
 
 	// Alloc space:
 	const size_t nOldPtsCount = this->size();
-	const size_t nScanPts = scan.point_cloud.size();
+	const size_t nScanPts =
+		fromPackets ? scan.maxPointCount() : scan.point_cloud.size();
 	const size_t nNewPtsCount = nOldPtsCount + nScanPts;
-	this->resize(nNewPtsCount);
+	this->resizeForAppending(nNewPtsCount);
 
 	const float K = 1.0f / 255;  // Intensity scale.
 
@@ -2160,20 +2266,42 @@ void CPointsMap::loadFromVelodyneScan(
 	const double m20 = HM(2, 0), m21 = HM(2, 1), m22 = HM(2, 2), m23 = HM(2, 3);
 
 	// Copy points:
-	for (size_t i = 0; i < nScanPts; i++)
+	const auto copyPoints = [&](size_t outIdx, size_t n, const float* xs,
+								const float* ys, const float* zs,
+								const uint8_t* intensities) {
+		for (size_t i = 0; i < n; i++)
+		{
+			const float inten = intensities[i] * K;
+			const double lx = xs[i];
+			const double ly = ys[i];
+			const double lz = zs[i];
+
+			const double gx = m00 * lx + m01 * ly + m02 * lz + m03;
+			const double gy = m10 * lx + m11 * ly + m12 * lz + m13;
+			const double gz = m20 * lx + m21 * ly + m22 * lz + m23;
+
+			this->setPointRGB(
+				outIdx + i, gx, gy, gz,  // XYZ
+				inten, inten, inten  // RGB
+			);
+		}
+	};
+
+	if (!fromPackets)
 	{
-		const float inten = scan.point_cloud.intensity[i] * K;
-		const double lx = scan.point_cloud.x[i];
-		const double ly = scan.point_cloud.y[i];
-		const double lz = scan.point_cloud.z[i];
-
-		const double gx = m00 * lx + m01 * ly + m02 * lz + m03;
-		const double gy = m10 * lx + m11 * ly + m12 * lz + m13;
-		const double gz = m20 * lx + m21 * ly + m22 * lz + m23;
-
-		this->setPointRGB(
-			nOldPtsCount + i, gx, gy, gz,  // XYZ
-			inten, inten, inten  // RGB
-		);
+		const auto& pc = scan.point_cloud;
+		copyPoints(
+			nOldPtsCount, nScanPts, &pc.x[0], &pc.y[0], &pc.z[0],
+			&pc.intensity[0]);
+		return;
 	}
+
+	// Decoded points go straight into this map:
+	const size_t nDecoded = scan.generatePointCloudBatch(
+		[&](const CObservationVelodyneScan::TDecodedPoints& pts) {
+			copyPoints(
+				nOldPtsCount + pts.outIdx, pts.count, pts.x, pts.y, pts.z,
+				pts.intensity);
+		});
+	this->resizeForAppending(nOldPtsCount + nDecoded);
 }
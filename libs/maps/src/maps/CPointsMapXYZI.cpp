@@ -86,7 +86,7 @@ void CPointsMapXYZI::resize(size_t newLength)
 	m_y.resize(newLength, 0);
 	m_z.resize(newLength, 0);
 	m_intensity.resize(newLength, 1);
-	mark_as_modified();
+	mark_as_resized();
 }
 
 // Resizes all point buffers so they can hold the given number of points,
@@ -9,6 +9,8 @@
 
 #include <gtest/gtest.h>
 #include <mrpt/maps/CPointsMapXYZI.h>
+#include <mrpt/obs/CObservationVelodyneScan.h>
+#include <mrpt/obs/CRawlog.h>
 #include <mrpt/system/filesystem.h>
 #include <test_mrpt_common.h>
 #include <iostream>
@@ -30,3 +32,40 @@ TEST(CPointsMapXYZI, loadFromKittiVelodyneFile)
 	EXPECT_TRUE(read_ok);
 	EXPECT_EQ(124668U, m.size());
 }
+
+TEST(CPointsMapXYZI, loadFromVelodyneScan)
+{
+	using namespace std;
+	const string fil = mrpt::UNITTEST_BASEDIR +
+					   string("/share/mrpt/datasets/test_velodyne_VLP16.rawlog");
+	if (!mrpt::system::fileExists(fil))
+	{
+		cerr << "WARNING: Skipping test due to missing file: " << fil << "\n";
+		return;
+	}
+	mrpt::obs::CRawlog rawlog;
+	ASSERT_TRUE(rawlog.loadFromRawLogFile(fil));
+	auto obs = rawlog.asObservation<mrpt::obs::CObservationVelodyneScan>(0);
+	ASSERT_TRUE(obs);
+	obs->point_cloud.clear();
+
+	const mrpt::poses::CPose3D robotPose(1.0, 2.0, 0.5, 0.3, 0.1, -0.2);
+
+	// Straight from the raw packets:
+	mrpt::maps::CPointsMapXYZI m1;
+	m1.loadFromVelodyneScan(*obs, &robotPose);
+	EXPECT_TRUE(obs->point_cloud.x.empty());
+
+	// From the observation point cloud:
+	obs->generatePointCloud();
+	mrpt::maps::CPointsMapXYZI m2;
+	m2.loadFromVelodyneScan(*obs, &robotPose);
+
+	ASSERT_EQ(m1.size(), obs->point_cloud.size());
+	ASSERT_EQ(m1.size(), m2.size());
+	EXPECT_EQ(m1.getPointsBufferRef_x(), m2.getPointsBufferRef_x());
+	EXPECT_EQ(m1.getPointsBufferRef_y(), m2.getPointsBufferRef_y());
+	EXPECT_EQ(m1.getPointsBufferRef_z(), m2.getPointsBufferRef_z());
+	for (size_t i = 0; i < m1.size(); i++)
+		EXPECT_EQ(m1.getPointIntensity(i), m2.getPointIntensity(i));
+}
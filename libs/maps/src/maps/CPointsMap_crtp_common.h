@@ -24,7 +24,11 @@ struct loadFromRangeImpl
 		using namespace mrpt::poses;
 		using mrpt::DEG2RAD;
 		using mrpt::square;
-		obj.mark_as_modified();
+		// Only new points are added, unless the map is cleared below:
+		if (obj.insertionOptions.addToExistingPointsMap)
+			obj.mark_as_appended();
+		else
+			obj.mark_as_modified();
 
 		// The next may seem useless, but it's required in case the observation
 		// underwent a move or copy operator, which may change the reserved mem
@@ -375,7 +379,11 @@ struct loadFromRangeImpl
 	{
 		using namespace mrpt::poses;
 		using mrpt::square;
-		obj.mark_as_modified();
+		// Only new points are added, unless the map is cleared below:
+		if (obj.insertionOptions.addToExistingPointsMap)
+			obj.mark_as_appended();
+		else
+			obj.mark_as_modified();
 
 		// If robot pose is supplied, compute sensor pose relative to it.
 		CPose3D sensorPose3D(UNINITIALIZED_POSE);
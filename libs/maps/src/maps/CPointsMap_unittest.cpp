@@ -12,7 +12,13 @@
 #include <mrpt/maps/CPointsMapXYZI.h>
 #include <mrpt/maps/CSimplePointsMap.h>
 #include <mrpt/maps/CWeightedPointsMap.h>
+#include <mrpt/obs/CObservation2DRangeScan.h>
+#include <mrpt/obs/stock_observations.h>
 #include <mrpt/poses/CPoint2D.h>
+#include <mrpt/poses/CPose2D.h>
+#include <mrpt/poses/CPose3D.h>
+#include <mrpt/random.h>
+#include <Eigen/Dense>
 #include <sstream>
 
 using namespace mrpt;
@@ -20,6 +26,7 @@ using namespace mrpt::maps;
 using namespace mrpt::obs;
 using namespace mrpt::poses;
 using namespace mrpt::math;
+using namespace mrpt::tfest;
 using namespace std;
 
 const size_t demo9_N = 9;
@@ -263,3 +270,191 @@ TEST(CColouredPointsMapTests, loadSaveStreams)
 {
 	do_tests_loadSaveStreams<CColouredPointsMap>();
 }
+
+TEST(CSimplePointsMapTests, determineMatchingMultiThread)
+{
+	auto& rng = mrpt::random::getRandomGenerator();
+	rng.randomize(1234);
+
+	// Reference map: a noisy, wavy surface
+	CSimplePointsMap globalMap, localMap;
+	for (int i = 0; i < 20000; i++)
+	{
+		const float x = rng.drawUniform(-20.0f, 20.0f);
+		const float y = rng.drawUniform(-20.0f, 20.0f);
+		const float z = std::sin(0.3f * x) + rng.drawGaussian1D(0, 0.05);
+		globalMap.insertPoint(x, y, z);
+		if (i % 4 == 0)
+			localMap.insertPoint(
+				x + rng.drawGaussian1D(0, 0.1), y + rng.drawGaussian1D(0, 0.1),
+				z);
+	}
+
+	TMatchingParams params;
+	params.maxDistForCorrespondence = 0.3f;
+	params.decimation_other_map_points = 2;
+	params.offset_other_map_points = 1;
+
+	const CPose3D pose3D(0.05, -0.02, 0.01, 0.02, 0, 0);
+	const CPose2D pose2D(0.05, -0.02, 0.02);
+
+	for (int is3D = 0; is3D < 2; is3D++)
+	{
+		TMatchingPairList corrs[2];
+		TMatchingExtraResults extra[2];
+		const unsigned int nThreads[2] = {1, 4};
+		for (int k = 0; k < 2; k++)
+		{
+			params.numThreads = nThreads[k];
+			if (is3D)
+				globalMap.determineMatching3D(
+					&localMap, pose3D, corrs[k], params, extra[k]);
+			else
+				globalMap.determineMatching2D(
+					&localMap, pose2D, corrs[k], params, extra[k]);
+		}
+
+		// The result must not depend on the number of threads:
+		ASSERT_GT(corrs[0].size(), 1000U);
+		ASSERT_EQ(corrs[0].size(), corrs[1].size());
+		EXPECT_EQ(extra[0].sumSqrDist, extra[1].sumSqrDist);
+		for (size_t i = 0; i < corrs[0].size(); i++)
+		{
+			EXPECT_EQ(corrs[0][i].this_idx, corrs[1][i].this_idx);
+			EXPECT_EQ(corrs[0][i].other_idx, corrs[1][i].other_idx);
+		}
+
+		// Check against brute-force nearest neighbors (decimated):
+		for (size_t i = 0; i < corrs[0].size(); i += 97)
+		{
+			const auto& c = corrs[0][i];
+			float gx, gy, gz;
+			if (is3D)
+				pose3D.composePoint(
+					c.other_x, c.other_y, c.other_z, gx, gy, gz);
+			else
+			{
+				double gxd, gyd;
+				pose2D.composePoint(c.other_x, c.other_y, gxd, gyd);
+				gx = d2f(gxd);
+				gy = d2f(gyd);
+				gz = 0;
+			}
+			float minDistSqr = std::numeric_limits<float>::max();
+			for (size_t j = 0; j < globalMap.size(); j++)
+			{
+				float px, py, pz;
+				globalMap.getPoint(j, px, py, pz);
+				minDistSqr = std::min(
+					minDistSqr, square(px - gx) + square(py - gy) +
+									(is3D ? square(pz - gz) : .0f));
+			}
+			EXPECT_NEAR(c.errorSquareAfterTransformation, minDistSqr, 1e-4f);
+		}
+	}
+}
+
+TEST(CSimplePointsMapTests, getLocalStructure)
+{
+	auto& rng = mrpt::random::getRandomGenerator();
+	rng.randomize(123);
+
+	// Points on the plane z = 0.5*x:
+	CSimplePointsMap m;
+	for (int i = 0; i < 2000; i++)
+	{
+		const float x = rng.drawUniform(-5.0, 5.0);
+		const float y = rng.drawUniform(-5.0, 5.0);
+		m.insertPoint(x, y, 0.5f * x);
+	}
+	const Eigen::Vector3f n_gt = Eigen::Vector3f(-0.5f, 0, 1).normalized();
+
+	const auto& ls = m.getLocalStructure(10);
+	ASSERT_EQ(ls.normals.size(), m.size());
+	ASSERT_EQ(ls.planeCovs.size(), m.size());
+	for (size_t i = 0; i < m.size(); i += 13)
+	{
+		const auto& nf = ls.normals[i];
+		const Eigen::Vector3f n(nf.x, nf.y, nf.z);
+		EXPECT_NEAR(std::abs(n.dot(n_gt)), 1.0f, 1e-4f);
+
+		// Small variance along the normal, unit variance in the plane:
+		const Eigen::Matrix3f C = ls.planeCovs[i].asEigen();
+		EXPECT_NEAR(
+			n_gt.dot(C * n_gt), CPointsMap::LOCAL_STRUCTURE_PLANE_EPSILON,
+			1e-4f);
+		EXPECT_NEAR(
+			C.trace(), 2 + CPointsMap::LOCAL_STRUCTURE_PLANE_EPSILON, 1e-4f);
+	}
+
+	// The cache must be invalidated when the map changes:
+	m.insertPoint(0, 0, 0);
+	EXPECT_EQ(m.getLocalStructure(10).normals.size(), m.size());
+}
+
+TEST(CSimplePointsMapTests, incrementalKDTree)
+{
+	CObservation2DRangeScan scan;
+	mrpt::obs::stock_observations::example2DRangeScan(scan);
+
+	// The same sequence of changes, with and without incremental KD-trees:
+	CSimplePointsMap mInc, mRef;
+	mInc.kdtree_search_params.incremental = true;
+
+	auto& rng = mrpt::random::getRandomGenerator();
+	rng.randomize(1234);
+	auto checkSameNN = [&]() {
+		ASSERT_EQ(mInc.size(), mRef.size());
+		for (int q = 0; q < 100; q++)
+		{
+			const float x = rng.drawUniform(-5.0f, 15.0f);
+			const float y = rng.drawUniform(-10.0f, 10.0f);
+			float dInc, dRef;
+			const size_t iInc = mInc.kdTreeClosestPoint2D(x, y, dInc);
+			const size_t iRef = mRef.kdTreeClosestPoint2D(x, y, dRef);
+			EXPECT_FLOAT_EQ(dInc, dRef);
+			EXPECT_EQ(iInc, iRef);
+		}
+	};
+
+	for (int i = 0; i < 10; i++)
+	{
+		const CPose3D pose(0.2 * i, 0.1 * i, 0, 0.05 * i, 0, 0);
+		mInc.insertObservation(scan, &pose);
+		mRef.insertObservation(scan, &pose);
+		checkSameNN();
+
+		mInc.insertPoint(i, -i, 0);
+		mRef.insertPoint(i, -i, 0);
+		checkSameNN();
+	}
+
+	// Non-append changes must still rebuild the KD-tree:
+	mInc.clipOutOfRange(TPoint2D(0, 0), 5.0f);
+	mRef.clipOutOfRange(TPoint2D(0, 0), 5.0f);
+	checkSameNN();
+	mInc.setPoint(0, 100.0f, 100.0f, 0);
+	mRef.setPoint(0, 100.0f, 100.0f, 0);
+	checkSameNN();
+	mInc.setPointAllFields(1, {-100.0f, 100.0f, 0});
+	mRef.setPointAllFields(1, {-100.0f, 100.0f, 0});
+	checkSameNN();
+
+	// Other maps are appended:
+	CSimplePointsMap other;
+	other.insertPoint(20.0f, 20.0f, 0);
+	mInc.addFrom(other);
+	mRef.addFrom(other);
+	checkSameNN();
+
+	// Growing with resize() and rewriting all points, as done through
+	// mrpt::opengl::PointCloudAdapter:
+	for (auto m : {&mInc, &mRef})
+	{
+		const size_t n = m->size();
+		m->resize(n + 1);
+		for (size_t i = 0; i <= n; i++)
+			m->setPointFast(i, 0.1f * i, -0.1f * i, 0);
+	}
+	checkSameNN();
+}
@@ -73,7 +73,7 @@ void CSimplePointsMap::resize(size_t newLength)
 	m_x.resize(newLength, 0);
 	m_y.resize(newLength, 0);
 	m_z.resize(newLength, 0);
-	mark_as_modified();
+	mark_as_resized();
 }
 
 // Resizes all point buffers so they can hold the given number of points,
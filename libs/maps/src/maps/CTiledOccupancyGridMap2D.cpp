@@ -0,0 +1,616 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2020, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include "maps-precomp.h"  // Precomp header
+
+#include <mrpt/config/CConfigFileBase.h>
+#include <mrpt/core/bits_math.h>
+#include <mrpt/core/round.h>
+#include <mrpt/maps/CPointsMap.h>
+#include <mrpt/maps/CTiledOccupancyGridMap2D.h>
+#include <mrpt/obs/CObservation2DRangeScan.h>
+#include <mrpt/poses/CPose2D.h>
+#include <mrpt/poses/CPose3D.h>
+#include <mrpt/serialization/CArchive.h>
+#include <algorithm>
+#include <climits>
+
+using namespace mrpt;
+using namespace mrpt::maps;
+using namespace mrpt::obs;
+using namespace mrpt::poses;
+
+//  =========== Begin of Map definition ============
+MAP_DEFINITION_REGISTER(
+	"mrpt::maps::CTiledOccupancyGridMap2D,tiledOccupancyGrid",
+	mrpt::maps::CTiledOccupancyGridMap2D)
+
+CTiledOccupancyGridMap2D::TMapDefinition::TMapDefinition() = default;
+
+void CTiledOccupancyGridMap2D::TMapDefinition::loadFromConfigFile_map_specific(
+	const mrpt::config::CConfigFileBase& source, const std::string& sect)
+{
+	using namespace std::string_literals;
+
+	// [<sect>+"_creationOpts"]
+	const auto sSectCreation = sect + "_creationOpts"s;
+	MRPT_LOAD_CONFIG_VAR(resolution, float, source, sSectCreation);
+
+	insertionOpts.loadFromConfigFile(source, sect + "_insertOpts"s);
+	likelihoodOpts.loadFromConfigFile(source, sect + "_likelihoodOpts"s);
+}
+
+void CTiledOccupancyGridMap2D::TMapDefinition::dumpToTextStream_map_specific(
+	std::ostream& out) const
+{
+	LOADABLEOPTS_DUMP_VAR(resolution, float);
+
+	this->insertionOpts.dumpToTextStream(out);
+	this->likelihoodOpts.dumpToTextStream(out);
+}
+
+mrpt::maps::CMetricMap*
+	CTiledOccupancyGridMap2D::internal_CreateFromMapDefinition(
+		const mrpt::maps::TMetricMapInitializer& _def)
+{
+	auto& def =
+		dynamic_cast<const CTiledOccupancyGridMap2D::TMapDefinition&>(_def);
+	auto* obj = new CTiledOccupancyGridMap2D(def.resolution);
+	obj->insertionOptions = def.insertionOpts;
+	obj->likelihoodOptions = def.likelihoodOpts;
+	return obj;
+}
+//  =========== End of Map definition Block =========
+
+IMPLEMENTS_SERIALIZABLE(CTiledOccupancyGridMap2D, CMetricMap, mrpt::maps)
+
+CTiledOccupancyGridMap2D::CTiledOccupancyGridMap2D(float resolution)
+{
+	setResolution(resolution);
+}
+
+CTiledOccupancyGridMap2D::CTiledOccupancyGridMap2D(
+	const CTiledOccupancyGridMap2D& o)
+{
+	*this = o;
+}
+
+CTiledOccupancyGridMap2D& CTiledOccupancyGridMap2D::operator=(
+	const CTiledOccupancyGridMap2D& o)
+{
+	if (this == &o) return *this;
+	CMetricMap::operator=(o);
+	insertionOptions = o.insertionOptions;
+	likelihoodOptions = o.likelihoodOptions;
+	m_resolution = o.m_resolution;
+	m_resolution_inv = o.m_resolution_inv;
+	m_tx0 = o.m_tx0;
+	m_ty0 = o.m_ty0;
+	m_ntx = o.m_ntx;
+	m_nty = o.m_nty;
+	m_num_tiles = o.m_num_tiles;
+	m_tiles.clear();
+	m_tiles.resize(o.m_tiles.size());
+	for (size_t i = 0; i < m_tiles.size(); i++)
+		if (o.m_tiles[i]) m_tiles[i] = std::make_unique<tile_t>(*o.m_tiles[i]);
+	return *this;
+}
+
+void CTiledOccupancyGridMap2D::setResolution(float resolution)
+{
+	ASSERT_GT_(resolution, 0.0f);
+	internal_clear();
+	m_resolution = resolution;
+	m_resolution_inv = 1.0f / resolution;
+}
+
+void CTiledOccupancyGridMap2D::internal_clear()
+{
+	m_tiles.clear();
+	m_tx0 = m_ty0 = 0;
+	m_ntx = m_nty = 0;
+	m_num_tiles = 0;
+}
+
+bool CTiledOccupancyGridMap2D::isEmpty() const { return m_num_tiles == 0; }
+
+void CTiledOccupancyGridMap2D::reserveTiles(
+	int tx_min, int tx_max, int ty_min, int ty_max)
+{
+	const int old_tx1 = m_tx0 + static_cast<int>(m_ntx),
+			  old_ty1 = m_ty0 + static_cast<int>(m_nty);
+	if (!m_tiles.empty() && tx_min >= m_tx0 && ty_min >= m_ty0 &&
+		tx_max < old_tx1 && ty_max < old_ty1)
+		return;  // Nothing to do
+
+	int new_tx0 = tx_min, new_tx1 = tx_max + 1;
+	int new_ty0 = ty_min, new_ty1 = ty_max + 1;
+	if (!m_tiles.empty())
+	{
+		// Grow with a margin proportional to the current size, so the cost of
+		// reallocating the table is amortized while the map grows:
+		const int mx = std::max<int>(2, m_ntx / 2),
+				  my = std::max<int>(2, m_nty / 2);
+		new_tx0 = tx_min < m_tx0 ? tx_min - mx : m_tx0;
+		new_tx1 = tx_max >= old_tx1 ? tx_max + 1 + mx : old_tx1;
+		new_ty0 = ty_min < m_ty0 ? ty_min - my : m_ty0;
+		new_ty1 = ty_max >= old_ty1 ? ty_max + 1 + my : old_ty1;
+	}
+
+	const auto new_ntx = static_cast<unsigned int>(new_tx1 - new_tx0);
+	const auto new_nty = static_cast<unsigned int>(new_ty1 - new_ty0);
+	std::vector<std::unique_ptr<tile_t>> new_tiles(size_t(new_ntx) * new_nty);
+	for (unsigned int dy = 0; dy < m_nty; dy++)
+		for (unsigned int dx = 0; dx < m_ntx; dx++)
+		{
+			const unsigned int ndx = dx + (m_tx0 - new_tx0),
+							   ndy = dy + (m_ty0 - new_ty0);
+			new_tiles[ndx + ndy * new_ntx] =
+				std::move(m_tiles[dx + dy * m_ntx]);
+		}
+
+	m_tiles = std::move(new_tiles);
+	m_tx0 = new_tx0;
+	m_ty0 = new_ty0;
+	m_ntx = new_ntx;
+	m_nty = new_nty;
+}
+
+CTiledOccupancyGridMap2D::tile_t& CTiledOccupancyGridMap2D::getTileForWrite(
+	int tx, int ty)
+{
+	reserveTiles(tx, tx, ty, ty);
+	auto& t = m_tiles[(tx - m_tx0) + (ty - m_ty0) * m_ntx];
+	if (!t)
+	{
+		t = std::make_unique<tile_t>();
+		t->fill(UNKNOWN_CELL);
+		m_num_tiles++;
+	}
+	return *t;
+}
+
+void CTiledOccupancyGridMap2D::setCell(int cx, int cy, float value)
+{
+	getTileForWrite(cx >> TILE_BITS, cy >> TILE_BITS)[tileOffset(cx, cy)] =
+		COccupancyGridMap2D::p2l(value);
+}
+
+bool CTiledOccupancyGridMap2D::getKnownArea(
+	float& x_min, float& x_max, float& y_min, float& y_max) const
+{
+	if (!m_num_tiles) return false;
+
+	int tx_min = INT_MAX, tx_max = INT_MIN, ty_min = INT_MAX, ty_max = INT_MIN;
+	for (unsigned int dy = 0; dy < m_nty; dy++)
+		for (unsigned int dx = 0; dx < m_ntx; dx++)
+		{
+			if (!m_tiles[dx + dy * m_ntx]) continue;
+			mrpt::keep_min(tx_min, m_tx0 + static_cast<int>(dx));
+			mrpt::keep_max(tx_max, m_tx0 + static_cast<int>(dx));
+			mrpt::keep_min(ty_min, m_ty0 + static_cast<int>(dy));
+			mrpt::keep_max(ty_max, m_ty0 + static_cast<int>(dy));
+		}
+	x_min = tx_min * TILE_SIZE * m_resolution;
+	x_max = (tx_max + 1) * TILE_SIZE * m_resolution;
+	y_min = ty_min * TILE_SIZE * m_resolution;
+	y_max = (ty_max + 1) * TILE_SIZE * m_resolution;
+	return true;
+}
+
+void CTiledOccupancyGridMap2D::getAsOccupancyGridMap2D(
+	COccupancyGridMap2D& out) const
+{
+	MRPT_START
+
+	float x_min, x_max, y_min, y_max;
+	if (!getKnownArea(x_min, x_max, y_min, y_max))
+	{
+		// An empty map: a grid with one unknown tile
+		const float L = TILE_SIZE * m_resolution;
+		out.setSize(0, L, 0, L, m_resolution, 0.5f);
+		return;
+	}
+	out.setSize(x_min, x_max, y_min, y_max, m_resolution, 0.5f);
+
+	// Global indices of the first cell in the dense grid:
+	const int cx0 = mrpt::round(x_min * m_resolution_inv),
+			  cy0 = mrpt::round(y_min * m_resolution_inv);
+	const int tx0 = cx0 >> TILE_BITS, ty0 = cy0 >> TILE_BITS;
+	const int ntx = static_cast<int>(out.size_x) / TILE_SIZE,
+			  nty = static_cast<int>(out.size_y) / TILE_SIZE;
+	ASSERT_EQUAL_(out.size_x, static_cast<unsigned int>(ntx * TILE_SIZE));
+	ASSERT_EQUAL_(out.size_y, static_cast<unsigned int>(nty * TILE_SIZE));
+
+	for (int ty = 0; ty < nty; ty++)
+		for (int tx = 0; tx < ntx; tx++)
+		{
+			const tile_t* t = getTile(tx0 + tx, ty0 + ty);
+			if (!t) continue;
+			for (int r = 0; r < TILE_SIZE; r++)
+				std::copy_n(
+					t->data() + r * TILE_SIZE, TILE_SIZE,
+					out.getRow(ty * TILE_SIZE + r) + tx * TILE_SIZE);
+		}
+	out.m_is_empty = false;
+
+	MRPT_END
+}
+
+void CTiledOccupancyGridMap2D::loadFromOccupancyGridMap2D(
+	const COccupancyGridMap2D& in)
+{
+	MRPT_START
+
+	setResolution(in.getResolution());
+
+	// Global indices of the first cell of the dense grid:
+	const int cx0 = mrpt::round(in.getXMin() * m_resolution_inv),
+			  cy0 = mrpt::round(in.getYMin() * m_resolution_inv);
+	const int sx = static_cast<int>(in.getSizeX()),
+			  sy = static_cast<int>(in.getSizeY());
+	if (!sx || !sy) return;
+
+	reserveTiles(
+		cx0 >> TILE_BITS, (cx0 + sx - 1) >> TILE_BITS, cy0 >> TILE_BITS,
+		(cy0 + sy - 1) >> TILE_BITS);
+
+	for (int y = 0; y < sy; y++)
+	{
+		const cellType* row = in.getRow(y);
+		for (int x = 0; x < sx; x++)
+		{
+			if (row[x] == UNKNOWN_CELL) continue;
+			const int cx = cx0 + x, cy = cy0 + y;
+			getTileForWrite(cx >> TILE_BITS, cy >> TILE_BITS)[tileOffset(
+				cx, cy)] = row[x];
+		}
+	}
+
+	MRPT_END
+}
+
+bool CTiledOccupancyGridMap2D::internal_insertObservation(
+	const CObservation& obs, const CPose3D* robotPose)
+{
+	MRPT_START
+
+	if (!IS_CLASS(obs, CObservation2DRangeScan)) return false;
+	const auto& o = dynamic_cast<const CObservation2DRangeScan&>(obs);
+
+	const CPose3D sensorPose3D =
+		robotPose ? (*robotPose + o.sensorPose) : o.sensorPose;
+	const CPose2D laserPose(sensorPose3D);
+
+	// Insert only HORIZONTAL scans at the altitude of the map (if enabled):
+	if (!o.isPlanarScan(insertionOptions.horizontalTolerance)) return false;
+	if (insertionOptions.useMapAltitude &&
+		std::abs(insertionOptions.mapAltitude - sensorPose3D.z()) > 0.001)
+		return false;
+
+	// Log-odds of the updates, exactly as in COccupancyGridMap2D:
+	const float maxCertainty = insertionOptions.maxOccupancyUpdateCertainty;
+	float maxFreeCertainty = insertionOptions.maxFreenessUpdateCertainty;
+	if (maxFreeCertainty == .0f) maxFreeCertainty = maxCertainty;
+	float maxFreeCertaintyNoEcho = insertionOptions.maxFreenessInvalidRanges;
+	if (maxFreeCertaintyNoEcho == .0f) maxFreeCertaintyNoEcho = maxCertainty;
+
+	const cellType logodd_observation_free =
+		std::max<cellType>(1, COccupancyGridMap2D::p2l(maxFreeCertainty));
+	const cellType logodd_observation_occupied =
+		3 * std::max<cellType>(1, COccupancyGridMap2D::p2l(maxCertainty));
+	const cellType logodd_noecho_free =
+		std::max<cellType>(1, COccupancyGridMap2D::p2l(maxFreeCertaintyNoEcho));
+	const cellType logodd_thres_occupied =
+		CELLTYPE_MIN + logodd_observation_occupied;
+	const cellType logodd_thres_free =
+		CELLTYPE_MAX - std::max(logodd_noecho_free, logodd_observation_free);
+
+	// Horizontal scans with the sensor bottom-up:
+	const bool sensorIsBottomwards =
+		sensorPose3D.getHomogeneousMatrixVal<
+			mrpt::math::CMatrixDouble44>()(2, 2) < 0;
+
+	const size_t nRanges = o.getScanSize();
+	const size_t K = std::max<size_t>(1, insertionOptions.decimation);
+	const float maxDistanceInsertion = insertionOptions.maxDistanceInsertion;
+	const bool invalidAsFree =
+		insertionOptions.considerInvalidRangesAsFreeSpace;
+	if (!nRanges) return false;
+
+	float A, dAK;
+	if (o.rightToLeft ^ sensorIsBottomwards)
+	{
+		A = d2f(laserPose.phi() - 0.5f * o.aperture);
+		dAK = K * o.aperture / nRanges;
+	}
+	else
+	{
+		A = d2f(laserPose.phi() + 0.5f * o.aperture);
+		dAK = -K * o.aperture / nRanges;
+	}
+
+	const float px = d2f(laserPose.x()), py = d2f(laserPose.y());
+	const int cx0 = x2idx(px), cy0 = y2idx(py);
+
+	// Cells at the end of each ray, and the bounding box of all of them:
+	std::vector<int> trg_cx(nRanges), trg_cy(nRanges);
+	int cx_min = cx0, cx_max = cx0, cy_min = cy0, cy_max = cy0;
+	float last_valid_range = maxDistanceInsertion;
+	for (size_t idx = 0; idx < nRanges; idx += K, A += dAK)
+	{
+		float R = 0;
+		if (o.getScanRangeValidity(idx))
+		{
+			R = std::min(maxDistanceInsertion, o.getScanRange(idx));
+			last_valid_range = o.getScanRange(idx);
+		}
+		else if (invalidAsFree)
+			R = std::min(maxDistanceInsertion, 0.5f * last_valid_range);
+
+		trg_cx[idx] = x2idx(px + std::cos(A) * R);
+		trg_cy[idx] = y2idx(py + std::sin(A) * R);
+		mrpt::keep_min(cx_min, trg_cx[idx]);
+		mrpt::keep_max(cx_max, trg_cx[idx]);
+		mrpt::keep_min(cy_min, trg_cy[idx]);
+		mrpt::keep_max(cy_max, trg_cy[idx]);
+	}
+
+	// Make room in the table of tiles once; tiles themselves are only
+	// allocated below, as rays traverse them:
+	reserveTiles(
+		cx_min >> TILE_BITS, cx_max >> TILE_BITS, cy_min >> TILE_BITS,
+		cy_max >> TILE_BITS);
+
+	// Pointer to the cell (cx,cy), only looking up the table of tiles when
+	// the ray enters a different tile:
+	tile_t* tile = nullptr;
+	int cur_tx = INT_MIN, cur_ty = INT_MIN;
+	const auto cellPtr = [&](int cx, int cy) {
+		const int tx = cx >> TILE_BITS, ty = cy >> TILE_BITS;
+		if (tx != cur_tx || ty != cur_ty)
+		{
+			tile = &getTileForWrite(tx, ty);
+			cur_tx = tx;
+			cur_ty = ty;
+		}
+		return tile->data() + tileOffset(cx, cy);
+	};
+
+	// Ray-casting with "fractional integers", like COccupancyGridMap2D:
+	constexpr int FRBITS = 9;
+	for (size_t idx = 0; idx < nRanges; idx += K)
+	{
+		const bool valid = o.getScanRangeValidity(idx);
+		if (!valid && !invalidAsFree) continue;
+
+		const int Acx = trg_cx[idx] - cx0, Acy = trg_cy[idx] - cy0;
+		const int Acx_ = std::abs(Acx), Acy_ = std::abs(Acy);
+		const int nStepsRay = std::max(Acx_, Acy_);
+		if (!nStepsRay) continue;
+
+		const float N_1 = 1.0f / nStepsRay;
+		const int frAcx = (Acx < 0 ? -1 : +1) * round((Acx_ << FRBITS) * N_1);
+		const int frAcy = (Acy < 0 ? -1 : +1) * round((Acy_ << FRBITS) * N_1);
+
+		int cx = cx0, cy = cy0;
+		int frCX = cx * (1 << FRBITS), frCY = cy * (1 << FRBITS);
+		const cellType logodd_free =
+			valid ? logodd_observation_free : logodd_noecho_free;
+
+		for (int nStep = 0; nStep < nStepsRay; nStep++)
+		{
+			updateCell_fast_free(
+				cellPtr(cx, cy), logodd_free, logodd_thres_free);
+			frCX += frAcx;
+			frCY += frAcy;
+			cx = frCX >> FRBITS;
+			cy = frCY >> FRBITS;
+		}
+
+		// The occupied cell at the end, unless the ray was truncated:
+		if (valid && o.getScanRange(idx) < maxDistanceInsertion)
+			updateCell_fast_occupied(
+				cellPtr(trg_cx[idx], trg_cy[idx]), logodd_observation_occupied,
+				logodd_thres_occupied);
+	}
+
+	return true;
+
+	MRPT_END
+}
+
+float CTiledOccupancyGridMap2D::closestOccupiedDistance(
+	int cx, int cy, float maxDist) const
+{
+	const int W = static_cast<int>(std::ceil(maxDist * m_resolution_inv));
+	int minDist2 = mrpt::round(square(maxDist * m_resolution_inv));
+
+	// Visit the window, tile by tile, only looking at allocated tiles:
+	const int x0 = cx - W, x1 = cx + W, y0 = cy - W, y1 = cy + W;
+	for (int ty = y0 >> TILE_BITS; ty <= (y1 >> TILE_BITS); ty++)
+		for (int tx = x0 >> TILE_BITS; tx <= (x1 >> TILE_BITS); tx++)
+		{
+			const tile_t* t = getTile(tx, ty);
+			if (!t) continue;
+			const int tcx = tx << TILE_BITS, tcy = ty << TILE_BITS;
+			const int xx0 = std::max(x0, tcx),
+					  xx1 = std::min(x1, tcx + TILE_MASK);
+			const int yy0 = std::max(y0, tcy),
+					  yy1 = std::min(y1, tcy + TILE_MASK);
+			for (int yy = yy0; yy <= yy1; yy++)
+			{
+				const cellType* row = t->data() + ((yy - tcy) << TILE_BITS);
+				const int dy2 = square(yy - cy);
+				for (int xx = xx0; xx <= xx1; xx++)
+					if (row[xx - tcx] < UNKNOWN_CELL)
+						mrpt::keep_min(minDist2, square(xx - cx) + dy2);
+			}
+		}
+	return std::sqrt(static_cast<float>(minDist2)) * m_resolution;
+}
+
+double CTiledOccupancyGridMap2D::internal_computeObservationLikelihood(
+	const CObservation& obs, const CPose3D& takenFrom)
+{
+	MRPT_START
+
+	if (!IS_CLASS(obs, CObservation2DRangeScan)) return 0;
+	const auto& o = dynamic_cast<const CObservation2DRangeScan&>(obs);
+	if (!o.isPlanarScan(insertionOptions.horizontalTolerance)) return -10;
+
+	CPointsMap::TInsertionOptions opts;
+	opts.minDistBetweenLaserPoints = m_resolution * 0.5f;
+	opts.isPlanarMap = true;
+	opts.horizontalTolerance = insertionOptions.horizontalTolerance;
+	const auto* pts = o.buildAuxPointsMap<mrpt::maps::CPointsMap>(&opts);
+
+	const size_t N = pts->size();
+	if (!N) return -100;  // No way to estimate this likelihood!!
+
+	const auto& lo = likelihoodOptions;
+	const double zRandomTerm = lo.LF_zRandom / lo.LF_maxRange;
+	const double Q = -0.5 / square(lo.LF_stdHit);
+	const size_t decimation =
+		N < 10 ? 1 : std::max<size_t>(1, lo.LF_decimation);
+
+	const CPose2D pose(takenFrom);
+	const double ccos = std::cos(pose.phi()), ssin = std::sin(pose.phi());
+
+	double ret = 0;
+	for (size_t j = 0; j < N; j += decimation)
+	{
+		float lx, ly, lz;
+		pts->getPoint(j, lx, ly, lz);
+		const double gx = pose.x() + lx * ccos - ly * ssin;
+		const double gy = pose.y() + lx * ssin + ly * ccos;
+
+		const float d = closestOccupiedDistance(
+			x2idx(gx), y2idx(gy), lo.LF_maxCorrsDistance);
+		ret += std::log(zRandomTerm + lo.LF_zHit * std::exp(Q * square(d)));
+	}
+	return ret;
+
+	MRPT_END
+}
+
+bool CTiledOccupancyGridMap2D::internal_canComputeObservationLikelihood(
+	const CObservation& obs) const
+{
+	if (!IS_CLASS(obs, CObservation2DRangeScan)) return false;
+	const auto& scan = dynamic_cast<const CObservation2DRangeScan&>(obs);
+	if (!scan.isPlanarScan(insertionOptions.horizontalTolerance)) return false;
+	if (insertionOptions.useMapAltitude &&
+		std::abs(insertionOptions.mapAltitude - scan.sensorPose.z()) > 0.01)
+		return false;
+	return true;
+}
+
+void CTiledOccupancyGridMap2D::saveMetricMapRepresentationToFile(
+	const std::string& filNamePrefix) const
+{
+	COccupancyGridMap2D dense;
+	getAsOccupancyGridMap2D(dense);
+	dense.saveMetricMapRepresentationToFile(filNamePrefix);
+}
+
+void CTiledOccupancyGridMap2D::getAs3DObject(
+	mrpt::opengl::CSetOfObjects::Ptr& outObj) const
+{
+	if (!genericMapParams.enableSaveAs3DObject) return;
+
+	COccupancyGridMap2D dense;
+	getAsOccupancyGridMap2D(dense);
+	dense.insertionOptions.mapAltitude = insertionOptions.mapAltitude;
+	dense.getAs3DObject(outObj);
+}
+
+void CTiledOccupancyGridMap2D::TLikelihoodOptions::loadFromConfigFile(
+	const mrpt::config::CConfigFileBase& c, const std::string& s)
+{
+	MRPT_LOAD_CONFIG_VAR(LF_stdHit, float, c, s);
+	MRPT_LOAD_CONFIG_VAR(LF_zHit, float, c, s);
+	MRPT_LOAD_CONFIG_VAR(LF_zRandom, float, c, s);
+	MRPT_LOAD_CONFIG_VAR(LF_maxRange, float, c, s);
+	MRPT_LOAD_CONFIG_VAR(LF_decimation, int, c, s);
+	MRPT_LOAD_CONFIG_VAR(LF_maxCorrsDistance, float, c, s);
+}
+
+void CTiledOccupancyGridMap2D::TLikelihoodOptions::saveToConfigFile(
+	mrpt::config::CConfigFileBase& c, const std::string& s) const
+{
+	MRPT_SAVE_CONFIG_VAR_COMMENT(
+		LF_stdHit, "The laser range sigma used in computations (meters)");
+	MRPT_SAVE_CONFIG_VAR_COMMENT(LF_zHit, "Ratio of the hit component");
+	MRPT_SAVE_CONFIG_VAR_COMMENT(LF_zRandom, "Ratio of the random component");
+	MRPT_SAVE_CONFIG_VAR_COMMENT(
+		LF_maxRange, "The max. range of the sensor (meters)");
+	MRPT_SAVE_CONFIG_VAR_COMMENT(
+		LF_decimation, "Only consider one out of N points");
+	MRPT_SAVE_CONFIG_VAR_COMMENT(
+		LF_maxCorrsDistance,
+		"The max. distance for searching correspondences (meters)");
+}
+
+uint8_t CTiledOccupancyGridMap2D::serializeGetVersion() const { return 0; }
+void CTiledOccupancyGridMap2D::serializeTo(
+	mrpt::serialization::CArchive& out) const
+{
+	out << m_resolution;
+
+	// Allocated tiles only:
+	out.WriteAs<uint64_t>(m_num_tiles);
+	for (unsigned int dy = 0; dy < m_nty; dy++)
+		for (unsigned int dx = 0; dx < m_ntx; dx++)
+		{
+			const auto& t = m_tiles[dx + dy * m_ntx];
+			if (!t) continue;
+			out.WriteAs<int32_t>(m_tx0 + static_cast<int>(dx));
+			out.WriteAs<int32_t>(m_ty0 + static_cast<int>(dy));
+			out.WriteBufferFixEndianness(t->data(), t->size());
+		}
+
+	out << likelihoodOptions.LF_stdHit << likelihoodOptions.LF_zHit
+		<< likelihoodOptions.LF_zRandom << likelihoodOptions.LF_maxRange
+		<< likelihoodOptions.LF_decimation
+		<< likelihoodOptions.LF_maxCorrsDistance;
+	out << genericMapParams;
+}
+
+void CTiledOccupancyGridMap2D::serializeFrom(
+	mrpt::serialization::CArchive& in, uint8_t version)
+{
+	switch (version)
+	{
+		case 0:
+		{
+			float resolution;
+			in >> resolution;
+			setResolution(resolution);
+
+			const auto nTiles = in.ReadAs<uint64_t>();
+			for (uint64_t i = 0; i < nTiles; i++)
+			{
+				const auto tx = in.ReadAs<int32_t>();
+				const auto ty = in.ReadAs<int32_t>();
+				auto& t = getTileForWrite(tx, ty);
+				in.ReadBufferFixEndianness(t.data(), t.size());
+			}
+
+			in >> likelihoodOptions.LF_stdHit >> likelihoodOptions.LF_zHit >>
+				likelihoodOptions.LF_zRandom >> likelihoodOptions.LF_maxRange >>
+				likelihoodOptions.LF_decimation >>
+				likelihoodOptions.LF_maxCorrsDistance;
+			in >> genericMapParams;
+		}
+		break;
+		default:
+			MRPT_THROW_UNKNOWN_SERIALIZATION_VERSION(version);
+	};
+}
@@ -0,0 +1,182 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2020, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include <gtest/gtest.h>
+#include <mrpt/io/CMemoryStream.h>
+#include <mrpt/maps/COccupancyGridMap2D.h>
+#include <mrpt/maps/CTiledOccupancyGridMap2D.h>
+#include <mrpt/obs/CObservation2DRangeScan.h>
+#include <mrpt/obs/stock_observations.h>
+#include <mrpt/poses/CPose3D.h>
+#include <mrpt/serialization/CArchive.h>
+
+using namespace mrpt;
+using namespace mrpt::maps;
+using namespace mrpt::poses;
+
+namespace
+{
+// Checks that all cells of a dense grid have the same contents in the tiled
+// map, returning the ratio of equal cells:
+double ratioOfEqualCells(
+	const COccupancyGridMap2D& dense, const CTiledOccupancyGridMap2D& tiled)
+{
+	size_t nEqual = 0;
+	for (unsigned int cy = 0; cy < dense.getSizeY(); cy++)
+		for (unsigned int cx = 0; cx < dense.getSizeX(); cx++)
+			if (dense.getRow(cy)[cx] ==
+				tiled.getRawCell(
+					tiled.x2idx(dense.idx2x(cx)), tiled.y2idx(dense.idx2y(cy))))
+				nEqual++;
+	return double(nEqual) / (dense.getSizeX() * dense.getSizeY());
+}
+}  // namespace
+
+TEST(CTiledOccupancyGridMap2D, setGetCells)
+{
+	CTiledOccupancyGridMap2D m(0.1f);
+	EXPECT_TRUE(m.isEmpty());
+	EXPECT_FLOAT_EQ(m.getCell(10, -20), 0.5f);
+
+	// Cells far apart, with negative indices, and in the same tile:
+	m.setCell(0, 0, 0.1f);
+	m.setCell(-1, -1, 0.9f);
+	m.setCell(63, 63, 0.2f);
+	m.setCell(100000, -50000, 0.8f);
+	EXPECT_FALSE(m.isEmpty());
+	EXPECT_EQ(m.tileCount(), 3U);
+
+	EXPECT_NEAR(m.getCell(0, 0), 0.1f, 0.01f);
+	EXPECT_NEAR(m.getCell(-1, -1), 0.9f, 0.01f);
+	EXPECT_NEAR(m.getCell(63, 63), 0.2f, 0.01f);
+	EXPECT_NEAR(m.getCell(100000, -50000), 0.8f, 0.01f);
+	EXPECT_FLOAT_EQ(m.getCell(64, 0), 0.5f);
+	EXPECT_FLOAT_EQ(m.getCell(1, 0), 0.5f);
+
+	// Coordinates (meters):
+	EXPECT_EQ(m.x2idx(-0.05), -1);
+	EXPECT_NEAR(m.getPos(-0.05f, -0.05f), 0.9f, 0.01f);
+
+	float x_min, x_max, y_min, y_max;
+	ASSERT_TRUE(m.getKnownArea(x_min, x_max, y_min, y_max));
+	EXPECT_NEAR(x_min, -6.4f, 1e-3f);
+	EXPECT_NEAR(x_max, 10003.2f, 1e-1f);
+	EXPECT_NEAR(y_min, -5004.8f, 1e-1f);
+	EXPECT_NEAR(y_max, 6.4f, 1e-3f);
+
+	m.clear();
+	EXPECT_TRUE(m.isEmpty());
+	EXPECT_FLOAT_EQ(m.getCell(0, 0), 0.5f);
+}
+
+TEST(CTiledOccupancyGridMap2D, insertScanLikeDenseGrid)
+{
+	mrpt::obs::CObservation2DRangeScan scan;
+	mrpt::obs::stock_observations::example2DRangeScan(scan);
+
+	COccupancyGridMap2D dense(-10.0f, 10.0f, -10.0f, 10.0f, 0.05f);
+	CTiledOccupancyGridMap2D tiled(0.05f);
+	// (Poses not at cell boundaries, where the round-off errors of both maps
+	// could place the sensor at different cells)
+	for (const auto& p : {CPose3D(0.012, 0.021, 0, 0, 0, 0),
+						  CPose3D(0.512, -0.337, 0, 0.2, 0, 0),
+						  CPose3D(-1.013, 0.722, 0, -0.4, 0, 0)})
+	{
+		dense.insertObservation(scan, &p);
+		tiled.insertObservation(scan, &p);
+	}
+
+	// Both maps must have the same contents, up to a few cells whose
+	// discretization may differ due to round-off errors:
+	EXPECT_GT(ratioOfEqualCells(dense, tiled), 0.999);
+
+	// Only the observed area is allocated:
+	EXPECT_LT(
+		tiled.tileCount() * CTiledOccupancyGridMap2D::TILE_SIZE *
+			CTiledOccupancyGridMap2D::TILE_SIZE,
+		size_t(dense.getSizeX()) * dense.getSizeY());
+}
+
+TEST(CTiledOccupancyGridMap2D, growthFarAway)
+{
+	mrpt::obs::CObservation2DRangeScan scan;
+	mrpt::obs::stock_observations::example2DRangeScan(scan);
+
+	CTiledOccupancyGridMap2D m(0.05f);
+	const CPose3D p1(0, 0, 0, 0, 0, 0), p2(2000.0, -1600.0, 0, 0, 0, 0);
+	m.insertObservation(scan, &p1);
+	const size_t nTiles1 = m.tileCount();
+	ASSERT_GT(nTiles1, 0U);
+
+	// Kilometers away (and at the same position within a tile): only the new
+	// tiles are allocated, up to round-off errors at tile boundaries
+	m.insertObservation(scan, &p2);
+	EXPECT_GE(m.tileCount() + 2, 2 * nTiles1);
+	EXPECT_LE(m.tileCount(), 2 * nTiles1 + 2);
+
+	// And the first observation is still there:
+	CTiledOccupancyGridMap2D m1(0.05f);
+	m1.insertObservation(scan, &p1);
+	for (int cy = -200; cy < 200; cy++)
+		for (int cx = -200; cx < 200; cx++)
+			ASSERT_EQ(m.getRawCell(cx, cy), m1.getRawCell(cx, cy));
+}
+
+TEST(CTiledOccupancyGridMap2D, denseConversionAndSerialization)
+{
+	mrpt::obs::CObservation2DRangeScan scan;
+	mrpt::obs::stock_observations::example2DRangeScan(scan);
+
+	CTiledOccupancyGridMap2D m(0.1f);
+	const CPose3D p(-3.0, 2.0, 0, 0.5, 0, 0);
+	m.insertObservation(scan, &p);
+
+	// To a dense grid, for use with existing algorithms:
+	COccupancyGridMap2D dense;
+	m.getAsOccupancyGridMap2D(dense);
+	EXPECT_FLOAT_EQ(dense.getResolution(), 0.1f);
+	EXPECT_DOUBLE_EQ(ratioOfEqualCells(dense, m), 1.0);
+	EXPECT_NEAR(dense.getPos(-3.0f, 2.0f), m.getPos(-3.0f, 2.0f), 1e-6f);
+
+	// ...and back:
+	CTiledOccupancyGridMap2D m2;
+	m2.loadFromOccupancyGridMap2D(dense);
+	EXPECT_FLOAT_EQ(m2.getResolution(), 0.1f);
+	EXPECT_EQ(m2.tileCount(), m.tileCount());
+	EXPECT_DOUBLE_EQ(ratioOfEqualCells(dense, m2), 1.0);
+
+	// Serialization round trip:
+	mrpt::io::CMemoryStream buf;
+	auto arch = mrpt::serialization::archiveFrom(buf);
+	arch << m;
+	buf.Seek(0);
+	CTiledOccupancyGridMap2D m3;
+	arch >> m3;
+	EXPECT_EQ(m3.tileCount(), m.tileCount());
+	EXPECT_DOUBLE_EQ(ratioOfEqualCells(dense, m3), 1.0);
+}
+
+TEST(CTiledOccupancyGridMap2D, observationLikelihood)
+{
+	mrpt::obs::CObservation2DRangeScan scan;
+	mrpt::obs::stock_observations::example2DRangeScan(scan);
+
+	CTiledOccupancyGridMap2D m(0.05f);
+	const CPose3D p(1.0, 2.0, 0, 0.3, 0, 0);
+	m.insertObservation(scan, &p);
+	ASSERT_TRUE(m.canComputeObservationLikelihood(scan));
+
+	const double likTrue = m.computeObservationLikelihood(scan, p);
+	const double likFar = m.computeObservationLikelihood(
+		scan, CPose3D(1.5, 2.0, 0, 0.3, 0, 0));
+	const double likRot = m.computeObservationLikelihood(
+		scan, CPose3D(1.0, 2.0, 0, 0.5, 0, 0));
+	EXPECT_GT(likTrue, likFar);
+	EXPECT_GT(likTrue, likRot);
+}
@@ -0,0 +1,607 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2020, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include "maps-precomp.h"  // Precomp header
+
+#include <mrpt/config/CConfigFileBase.h>
+#include <mrpt/core/bits_math.h>
+#include <mrpt/maps/CSimplePointsMap.h>
+#include <mrpt/maps/CVoxelHashPointsMap.h>
+#include <mrpt/opengl/CPointCloud.h>
+#include <mrpt/poses/CPose2D.h>
+#include <mrpt/poses/CPose3D.h>
+#include <mrpt/serialization/CArchive.h>
+#include <fstream>
+
+#include "parallelPointsLoop.h"
+
+using namespace mrpt;
+using namespace mrpt::maps;
+using mrpt::maps::internal::parallelPointsLoop;
+
+//  =========== Begin of Map definition ============
+MAP_DEFINITION_REGISTER(
+	"mrpt::maps::CVoxelHashPointsMap,voxelHashPointsMap",
+	mrpt::maps::CVoxelHashPointsMap)
+
+CVoxelHashPointsMap::TMapDefinition::TMapDefinition() = default;
+
+void CVoxelHashPointsMap::TMapDefinition::loadFromConfigFile_map_specific(
+	const mrpt::config::CConfigFileBase& source, const std::string& sect)
+{
+	using namespace std::string_literals;
+
+	// [<sect>+"_creationOpts"]
+	const auto sSectCreation = sect + "_creationOpts"s;
+	MRPT_LOAD_CONFIG_VAR(voxel_size, double, source, sSectCreation);
+	MRPT_LOAD_CONFIG_VAR(max_points_per_voxel, int, source, sSectCreation);
+
+	insertionOpts.loadFromConfigFile(source, sect + "_insertOpts"s);
+	likelihoodOpts.loadFromConfigFile(source, sect + "_likelihoodOpts"s);
+	renderOpts.loadFromConfigFile(source, sect + "_renderOpts"s);
+}
+
+void CVoxelHashPointsMap::TMapDefinition::dumpToTextStream_map_specific(
+	std::ostream& out) const
+{
+	LOADABLEOPTS_DUMP_VAR(voxel_size, double);
+	LOADABLEOPTS_DUMP_VAR(max_points_per_voxel, int);
+
+	this->insertionOpts.dumpToTextStream(out);
+	this->likelihoodOpts.dumpToTextStream(out);
+	this->renderOpts.dumpToTextStream(out);
+}
+
+mrpt::maps::CMetricMap* CVoxelHashPointsMap::internal_CreateFromMapDefinition(
+	const mrpt::maps::TMetricMapInitializer& _def)
+{
+	auto& def = dynamic_cast<const CVoxelHashPointsMap::TMapDefinition&>(_def);
+	auto* obj =
+		new CVoxelHashPointsMap(def.voxel_size, def.max_points_per_voxel);
+	obj->insertionOptions = def.insertionOpts;
+	obj->likelihoodOptions = def.likelihoodOpts;
+	obj->renderOptions = def.renderOpts;
+	return obj;
+}
+//  =========== End of Map definition Block =========
+
+IMPLEMENTS_SERIALIZABLE(CVoxelHashPointsMap, CMetricMap, mrpt::maps)
+
+CVoxelHashPointsMap::CVoxelHashPointsMap(
+	double voxel_size, uint32_t max_points_per_voxel)
+{
+	setVoxelProperties(voxel_size, max_points_per_voxel);
+}
+
+void CVoxelHashPointsMap::setVoxelProperties(
+	double voxel_size, uint32_t max_points_per_voxel)
+{
+	MRPT_START
+	ASSERT_GT_(voxel_size, 0.0);
+	ASSERT_GT_(max_points_per_voxel, 0U);
+
+	// Keep the current points, to re-insert them:
+	std::vector<mrpt::math::TPoint3Df> pts;
+	pts.reserve(m_num_points);
+	visitAllPoints(
+		[&](float x, float y, float z) { pts.emplace_back(x, y, z); });
+
+	internal_clear();
+	m_voxel_size = voxel_size;
+	m_voxel_size_inv = 1.0 / voxel_size;
+	m_max_points_per_voxel = max_points_per_voxel;
+
+	for (const auto& p : pts) insertPoint(p);
+	MRPT_END
+}
+
+void CVoxelHashPointsMap::internal_clear()
+{
+	m_num_points = 0;
+	m_voxel_index.clear();
+	m_voxel_keys.clear();
+	m_voxel_counts.clear();
+	m_x.clear();
+	m_y.clear();
+	m_z.clear();
+}
+
+bool CVoxelHashPointsMap::isEmpty() const { return m_num_points == 0; }
+
+bool CVoxelHashPointsMap::insertPoint(float x, float y, float z)
+{
+	const int32_t cx = coord2idx(x), cy = coord2idx(y), cz = coord2idx(z);
+	if (std::abs(cx) >= KEY_OFFSET || std::abs(cy) >= KEY_OFFSET ||
+		std::abs(cz) >= KEY_OFFSET)
+		return false;
+
+	const uint64_t key = voxelKey(cx, cy, cz);
+	const auto itNew = m_voxel_index.emplace(
+		key, static_cast<uint32_t>(m_voxel_keys.size()));
+	const uint32_t v = itNew.first->second;
+	if (itNew.second)
+	{
+		// New voxel: append its block of slots:
+		m_voxel_keys.push_back(key);
+		m_voxel_counts.push_back(0);
+		const size_t nSlots = m_voxel_keys.size() * m_max_points_per_voxel;
+		m_x.resize(nSlots);
+		m_y.resize(nSlots);
+		m_z.resize(nSlots);
+	}
+
+	uint32_t& count = m_voxel_counts[v];
+	if (count >= m_max_points_per_voxel) return false;
+
+	const size_t idx = size_t(v) * m_max_points_per_voxel + count;
+	m_x[idx] = x;
+	m_y[idx] = y;
+	m_z[idx] = z;
+	count++;
+	m_num_points++;
+	return true;
+}
+
+size_t CVoxelHashPointsMap::insertPointCloud(
+	const mrpt::maps::CPointsMap& pts, const mrpt::poses::CPose3D& pointsPose)
+{
+	const auto& xs = pts.getPointsBufferRef_x();
+	const auto& ys = pts.getPointsBufferRef_y();
+	const auto& zs = pts.getPointsBufferRef_z();
+
+	size_t nInserted = 0;
+	for (size_t i = 0; i < xs.size(); i++)
+	{
+		float gx, gy, gz;
+		pointsPose.composePoint(xs[i], ys[i], zs[i], gx, gy, gz);
+		if (insertPoint(gx, gy, gz)) nInserted++;
+	}
+	return nInserted;
+}
+
+bool CVoxelHashPointsMap::nn_single_search(
+	float x, float y, float z, float maxDist, size_t& out_idx,
+	float& out_dist_sqr) const
+{
+	if (!m_num_points || maxDist <= 0) return false;
+
+	const int32_t cx = coord2idx(x), cy = coord2idx(y), cz = coord2idx(z);
+	const int32_t maxRing =
+		static_cast<int32_t>(std::ceil(maxDist * m_voxel_size_inv));
+	const size_t M = m_max_points_per_voxel;
+
+	float bestSqr = mrpt::square(maxDist);
+	bool found = false;
+
+	const auto visitVoxel = [&](int32_t ix, int32_t iy, int32_t iz) {
+		const auto it = m_voxel_index.find(voxelKey(ix, iy, iz));
+		if (it == m_voxel_index.end()) return;
+		const size_t i0 = it->second * M;
+		const size_t i1 = i0 + m_voxel_counts[it->second];
+		for (size_t i = i0; i < i1; i++)
+		{
+			const float d2 = mrpt::square(m_x[i] - x) +
+							 mrpt::square(m_y[i] - y) +
+							 mrpt::square(m_z[i] - z);
+			if (d2 < bestSqr)
+			{
+				bestSqr = d2;
+				out_idx = i;
+				found = true;
+			}
+		}
+	};
+
+	// Visit the cubic shells of voxels at Chebyshev distance r from the
+	// query voxel, in increasing order:
+	for (int32_t r = 0; r <= maxRing; r++)
+	{
+		for (int32_t dx = -r; dx <= r; dx++)
+		{
+			for (int32_t dy = -r; dy <= r; dy++)
+			{
+				// Inner (dx,dy) columns only have two voxels on the shell:
+				const bool onShell = std::abs(dx) == r || std::abs(dy) == r;
+				const int32_t dzStep = onShell ? 1 : 2 * r;
+				for (int32_t dz = -r; dz <= r; dz += dzStep)
+					visitVoxel(cx + dx, cy + dy, cz + dz);
+			}
+		}
+		// Points beyond shell "r" are farther than r*voxel_size:
+		if (found && bestSqr <= mrpt::square(r * m_voxel_size)) break;
+	}
+
+	if (found) out_dist_sqr = bestSqr;
+	return found;
+}
+
+mrpt::math::TPoint3D CVoxelHashPointsMap::voxelCenter(uint64_t key) const
+{
+	constexpr uint64_t mask = (uint64_t(1) << KEY_BITS) - 1;
+	const auto keyCoord = [&](int shift) {
+		return (int32_t((key >> shift) & mask) - KEY_OFFSET + 0.5) *
+			   m_voxel_size;
+	};
+	return {keyCoord(2 * KEY_BITS), keyCoord(KEY_BITS), keyCoord(0)};
+}
+
+size_t CVoxelHashPointsMap::removeVoxelsFartherThan(
+	const mrpt::math::TPoint3D& center, double maxDist)
+{
+	const size_t M = m_max_points_per_voxel;
+	const double maxDistSqr = mrpt::square(maxDist);
+	size_t nRemoved = 0;
+
+	for (size_t v = 0; v < m_voxel_keys.size();)
+	{
+		if ((voxelCenter(m_voxel_keys[v]) - center).sqrNorm() <= maxDistSqr)
+		{
+			v++;
+			continue;
+		}
+
+		// Remove voxel "v" by moving the last voxel into its place:
+		nRemoved += m_voxel_counts[v];
+		m_voxel_index.erase(m_voxel_keys[v]);
+
+		const size_t last = m_voxel_keys.size() - 1;
+		if (v != last)
+		{
+			m_voxel_keys[v] = m_voxel_keys[last];
+			m_voxel_counts[v] = m_voxel_counts[last];
+			m_voxel_index[m_voxel_keys[v]] = static_cast<uint32_t>(v);
+			for (size_t j = 0; j < m_voxel_counts[v]; j++)
+			{
+				m_x[v * M + j] = m_x[last * M + j];
+				m_y[v * M + j] = m_y[last * M + j];
+				m_z[v * M + j] = m_z[last * M + j];
+			}
+		}
+		m_voxel_keys.pop_back();
+		m_voxel_counts.pop_back();
+	}
+
+	m_x.resize(m_voxel_keys.size() * M);
+	m_y.resize(m_voxel_keys.size() * M);
+	m_z.resize(m_voxel_keys.size() * M);
+	m_num_points -= nRemoved;
+	return nRemoved;
+}
+
+bool CVoxelHashPointsMap::internal_insertObservation(
+	const mrpt::obs::CObservation& obs, const mrpt::poses::CPose3D* robotPose)
+{
+	MRPT_START
+
+	// Reuse the conversion of observations into points of point maps:
+	CSimplePointsMap pts;
+	if (!pts.insertObservation(obs, robotPose)) return false;
+
+	insertPointCloud(pts, mrpt::poses::CPose3D());
+
+	if (insertionOptions.eviction_distance > 0)
+	{
+		const auto center = robotPose ? mrpt::math::TPoint3D(
+											robotPose->x(), robotPose->y(),
+											robotPose->z())
+									  : mrpt::math::TPoint3D(0, 0, 0);
+		removeVoxelsFartherThan(center, insertionOptions.eviction_distance);
+	}
+	return true;
+
+	MRPT_END
+}
+
+double CVoxelHashPointsMap::internal_computeObservationLikelihood(
+	const mrpt::obs::CObservation& obs, const mrpt::poses::CPose3D& takenFrom)
+{
+	MRPT_START
+
+	CSimplePointsMap pts;
+	pts.insertObservation(obs, &takenFrom);
+
+	const size_t N = pts.size();
+	if (!N || !m_num_points) return -100;
+
+	const auto& xs = pts.getPointsBufferRef_x();
+	const auto& ys = pts.getPointsBufferRef_y();
+	const auto& zs = pts.getPointsBufferRef_z();
+
+	const auto maxDist =
+		static_cast<float>(likelihoodOptions.max_corr_distance);
+	const double maxSqrErr = mrpt::square(maxDist);
+	const size_t decim = std::max<size_t>(1, likelihoodOptions.decimation);
+
+	double sumSqrDist = 0;
+	size_t nPtsForAverage = 0;
+	for (size_t i = 0; i < N; i += decim, nPtsForAverage++)
+	{
+		size_t idx;
+		float d2;
+		sumSqrDist += nn_single_search(xs[i], ys[i], zs[i], maxDist, idx, d2)
+						  ? std::min<double>(d2, maxSqrErr)
+						  : maxSqrErr;
+	}
+	sumSqrDist /= nPtsForAverage;
+
+	// Log-likelihood:
+	return -sumSqrDist / likelihoodOptions.sigma_dist;
+
+	MRPT_END
+}
+
+void CVoxelHashPointsMap::determineMatching2D(
+	const mrpt::maps::CMetricMap* otherMap,
+	const mrpt::poses::CPose2D& otherMapPose,
+	mrpt::tfest::TMatchingPairList& correspondences,
+	const TMatchingParams& params, TMatchingExtraResults& extraResults) const
+{
+	determineMatching3D(
+		otherMap, mrpt::poses::CPose3D(otherMapPose), correspondences, params,
+		extraResults);
+}
+
+void CVoxelHashPointsMap::determineMatching3D(
+	const mrpt::maps::CMetricMap* otherMap2,
+	const mrpt::poses::CPose3D& otherMapPose,
+	mrpt::tfest::TMatchingPairList& correspondences,
+	const TMatchingParams& params, TMatchingExtraResults& extraResults) const
+{
+	MRPT_START
+
+	extraResults = TMatchingExtraResults();
+	correspondences.clear();
+
+	ASSERT_GT_(params.decimation_other_map_points, 0);
+	ASSERT_LT_(
+		params.offset_other_map_points, params.decimation_other_map_points);
+	ASSERT_(IS_DERIVED(*otherMap2, CPointsMap));
+	const auto* otherMap = static_cast<const CPointsMap*>(otherMap2);
+
+	const size_t nLocalPoints = otherMap->size();
+	if (!nLocalPoints || !m_num_points) return;
+
+	const auto& oxs = otherMap->getPointsBufferRef_x();
+	const auto& oys = otherMap->getPointsBufferRef_y();
+	const auto& ozs = otherMap->getPointsBufferRef_z();
+
+	const size_t offset = params.offset_other_map_points;
+	const size_t decim = params.decimation_other_map_points;
+	const size_t nQueries =
+		offset < nLocalPoints ? (nLocalPoints - offset + decim - 1) / decim
+							  : 0;
+
+	// Transform the (decimated) local points and search for their closest
+	// point in this map, within the max. distance of each one:
+	std::vector<float> qxs(nQueries), qys(nQueries), qzs(nQueries);
+	std::vector<size_t> nnIdxs(nQueries);
+	std::vector<float> nnSqrDists(nQueries);
+	std::vector<uint8_t> nnFound(nQueries);
+
+	parallelPointsLoop(nQueries, params.numThreads, [&](size_t i0, size_t i1) {
+		for (size_t k = i0; k < i1; k++)
+		{
+			const size_t localIdx = offset + k * decim;
+			otherMapPose.composePoint(
+				oxs[localIdx], oys[localIdx], ozs[localIdx], qxs[k], qys[k],
+				qzs[k]);
+
+			const double maxDist =
+				params.maxAngularDistForCorrespondence *
+					params.angularDistPivotPoint.distanceTo(
+						mrpt::math::TPoint3D(qxs[k], qys[k], qzs[k])) +
+				params.maxDistForCorrespondence;
+
+			nnFound[k] = nn_single_search(
+				qxs[k], qys[k], qzs[k], static_cast<float>(maxDist),
+				nnIdxs[k], nnSqrDists[k]);
+		}
+	});
+
+	// Assemble the pairs in order, so the result does not depend on the
+	// number of threads:
+	mrpt::tfest::TMatchingPairList tempCorrs;
+	tempCorrs.reserve(nQueries);
+	double sumSqrDist = 0;
+
+	for (size_t k = 0; k < nQueries; k++)
+	{
+		if (!nnFound[k]) continue;
+
+		const size_t localIdx = offset + k * decim;
+		const size_t thisIdx = nnIdxs[k];
+
+		mrpt::tfest::TMatchingPair p;
+		p.this_idx = thisIdx;
+		p.this_x = m_x[thisIdx];
+		p.this_y = m_y[thisIdx];
+		p.this_z = m_z[thisIdx];
+
+		p.other_idx = localIdx;
+		p.other_x = oxs[localIdx];
+		p.other_y = oys[localIdx];
+		p.other_z = ozs[localIdx];
+
+		p.errorSquareAfterTransformation = nnSqrDists[k];
+		sumSqrDist += nnSqrDists[k];
+
+		tempCorrs.push_back(p);
+	}
+	const size_t nMatched = tempCorrs.size();
+
+	if (params.onlyUniqueRobust)
+	{
+		ASSERTMSG_(
+			params.onlyKeepTheClosest,
+			"ERROR: onlyKeepTheClosest must be also set to true when "
+			"onlyUniqueRobust=true.");
+		tempCorrs.filterUniqueRobustPairs(m_x.size(), correspondences);
+	}
+	else
+	{
+		correspondences = std::move(tempCorrs);
+	}
+
+	extraResults.sumSqrDist = nMatched ? sumSqrDist / nMatched : 0;
+	extraResults.correspondencesRatio =
+		decim * nMatched / static_cast<float>(nLocalPoints);
+
+	MRPT_END
+}
+
+float CVoxelHashPointsMap::compute3DMatchingRatio(
+	const mrpt::maps::CMetricMap* otherMap,
+	const mrpt::poses::CPose3D& otherMapPose,
+	const TMatchingRatioParams& mrp) const
+{
+	mrpt::tfest::TMatchingPairList correspondences;
+	TMatchingParams params;
+	TMatchingExtraResults extraResults;
+
+	params.maxDistForCorrespondence = mrp.maxDistForCorr;
+
+	this->determineMatching3D(
+		otherMap, otherMapPose, correspondences, params, extraResults);
+
+	return extraResults.correspondencesRatio;
+}
+
+void CVoxelHashPointsMap::saveMetricMapRepresentationToFile(
+	const std::string& filNamePrefix) const
+{
+	std::ofstream f(filNamePrefix + ".txt");
+	if (!f.is_open()) return;
+	visitAllPoints([&](float x, float y, float z) {
+		f << x << " " << y << " " << z << "\n";
+	});
+}
+
+void CVoxelHashPointsMap::getAs3DObject(
+	mrpt::opengl::CSetOfObjects::Ptr& outObj) const
+{
+	MRPT_START
+	if (!genericMapParams.enableSaveAs3DObject) return;
+
+	auto obj = mrpt::opengl::CPointCloud::Create();
+	obj->reserve(m_num_points);
+	visitAllPoints(
+		[&](float x, float y, float z) { obj->insertPoint(x, y, z); });
+	obj->setColor(renderOptions.color);
+	obj->setPointSize(renderOptions.point_size);
+	obj->enableColorFromZ(false);
+	outObj->insert(obj);
+	MRPT_END
+}
+
+void CVoxelHashPointsMap::TInsertionOptions::loadFromConfigFile(
+	const mrpt::config::CConfigFileBase& c, const std::string& s)
+{
+	MRPT_LOAD_CONFIG_VAR(eviction_distance, double, c, s);
+}
+
+void CVoxelHashPointsMap::TInsertionOptions::saveToConfigFile(
+	mrpt::config::CConfigFileBase& c, const std::string& s) const
+{
+	MRPT_SAVE_CONFIG_VAR_COMMENT(
+		eviction_distance,
+		"If >0, voxels farther than this distance (meters) from the robot are "
+		"removed after inserting each observation (Default: 0, disabled)");
+}
+
+void CVoxelHashPointsMap::TLikelihoodOptions::loadFromConfigFile(
+	const mrpt::config::CConfigFileBase& c, const std::string& s)
+{
+	MRPT_LOAD_CONFIG_VAR(sigma_dist, double, c, s);
+	MRPT_LOAD_CONFIG_VAR(max_corr_distance, double, c, s);
+	MRPT_LOAD_CONFIG_VAR(decimation, int, c, s);
+}
+
+void CVoxelHashPointsMap::TLikelihoodOptions::saveToConfigFile(
+	mrpt::config::CConfigFileBase& c, const std::string& s) const
+{
+	MRPT_SAVE_CONFIG_VAR_COMMENT(
+		sigma_dist,
+		"Sigma squared (variance, in meters) of the exponential used to model "
+		"the likelihood");
+	MRPT_SAVE_CONFIG_VAR_COMMENT(
+		max_corr_distance,
+		"Maximum distance (meters) to consider for each point error");
+	MRPT_SAVE_CONFIG_VAR_COMMENT(
+		decimation, "Only consider one out of N points");
+}
+
+void CVoxelHashPointsMap::TRenderOptions::loadFromConfigFile(
+	const mrpt::config::CConfigFileBase& c, const std::string& s)
+{
+	MRPT_LOAD_CONFIG_VAR(point_size, float, c, s);
+	MRPT_LOAD_CONFIG_VAR(color.R, float, c, s);
+	MRPT_LOAD_CONFIG_VAR(color.G, float, c, s);
+	MRPT_LOAD_CONFIG_VAR(color.B, float, c, s);
+}
+
+void CVoxelHashPointsMap::TRenderOptions::saveToConfigFile(
+	mrpt::config::CConfigFileBase& c, const std::string& s) const
+{
+	MRPT_SAVE_CONFIG_VAR_COMMENT(point_size, "Point size (pixels)");
+	MRPT_SAVE_CONFIG_VAR_COMMENT(color.R, "Point color (R channel)");
+	MRPT_SAVE_CONFIG_VAR_COMMENT(color.G, "Point color (G channel)");
+	MRPT_SAVE_CONFIG_VAR_COMMENT(color.B, "Point color (B channel)");
+}
+
+uint8_t CVoxelHashPointsMap::serializeGetVersion() const { return 0; }
+void CVoxelHashPointsMap::serializeTo(mrpt::serialization::CArchive& out) const
+{
+	out << m_voxel_size << m_max_points_per_voxel;
+
+	// Points, in storage order, so they end up in the same voxel slots when
+	// re-inserted:
+	out.WriteAs<uint64_t>(m_num_points);
+	visitAllPoints([&](float x, float y, float z) { out << x << y << z; });
+
+	out << insertionOptions.eviction_distance;
+	out << likelihoodOptions.sigma_dist << likelihoodOptions.max_corr_distance
+		<< likelihoodOptions.decimation;
+	out << renderOptions.point_size << renderOptions.color;
+	out << genericMapParams;
+}
+
+void CVoxelHashPointsMap::serializeFrom(
+	mrpt::serialization::CArchive& in, uint8_t version)
+{
+	switch (version)
+	{
+		case 0:
+		{
+			double voxel_size;
+			uint32_t max_points_per_voxel;
+			in >> voxel_size >> max_points_per_voxel;
+
+			internal_clear();
+			setVoxelProperties(voxel_size, max_points_per_voxel);
+
+			const auto N = in.ReadAs<uint64_t>();
+			for (uint64_t i = 0; i < N; i++)
+			{
+				float x, y, z;
+				in >> x >> y >> z;
+				insertPoint(x, y, z);
+			}
+
+			in >> insertionOptions.eviction_distance;
+			in >> likelihoodOptions.sigma_dist >>
+				likelihoodOptions.max_corr_distance >>
+				likelihoodOptions.decimation;
+			in >> renderOptions.point_size >> renderOptions.color;
+			in >> genericMapParams;
+		}
+		break;
+		default:
+			MRPT_THROW_UNKNOWN_SERIALIZATION_VERSION(version);
+	};
+}
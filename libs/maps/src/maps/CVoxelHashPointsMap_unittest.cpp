@@ -0,0 +1,217 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2020, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include <gtest/gtest.h>
+#include <mrpt/config/CConfigFileMemory.h>
+#include <mrpt/io/CMemoryStream.h>
+#include <mrpt/maps/CMultiMetricMap.h>
+#include <mrpt/maps/CSimplePointsMap.h>
+#include <mrpt/maps/CVoxelHashPointsMap.h>
+#include <mrpt/obs/CObservation2DRangeScan.h>
+#include <mrpt/obs/stock_observations.h>
+#include <mrpt/poses/CPose3D.h>
+#include <mrpt/random.h>
+#include <mrpt/serialization/CArchive.h>
+#include <limits>
+
+using namespace mrpt;
+using namespace mrpt::maps;
+
+namespace
+{
+void fillRandom(CVoxelHashPointsMap& m, size_t N, float L)
+{
+	auto& rng = mrpt::random::getRandomGenerator();
+	rng.randomize(123);
+	for (size_t i = 0; i < N; i++)
+		m.insertPoint(
+			rng.drawUniform(-L, L), rng.drawUniform(-L, L),
+			rng.drawUniform(-L, L));
+}
+
+// Checks nn_single_search() against a brute-force search:
+void checkNN(const CVoxelHashPointsMap& m, float L, float maxDist)
+{
+	auto& rng = mrpt::random::getRandomGenerator();
+	for (int q = 0; q < 200; q++)
+	{
+		const float qx = rng.drawUniform(-L, L), qy = rng.drawUniform(-L, L),
+					qz = rng.drawUniform(-L, L);
+
+		float bfDistSqr = std::numeric_limits<float>::max();
+		m.visitAllPoints([&](float x, float y, float z) {
+			mrpt::keep_min(
+				bfDistSqr, square(x - qx) + square(y - qy) + square(z - qz));
+		});
+
+		size_t idx = 0;
+		float distSqr = 0;
+		const bool found =
+			m.nn_single_search(qx, qy, qz, maxDist, idx, distSqr);
+
+		EXPECT_EQ(found, bfDistSqr < square(maxDist));
+		if (!found) continue;
+
+		EXPECT_FLOAT_EQ(distSqr, bfDistSqr);
+		float x, y, z;
+		m.getPoint(idx, x, y, z);
+		EXPECT_FLOAT_EQ(
+			distSqr, square(x - qx) + square(y - qy) + square(z - qz));
+	}
+}
+}  // namespace
+
+TEST(CVoxelHashPointsMap, insertAndNN)
+{
+	CVoxelHashPointsMap m(0.5, 8);
+	EXPECT_TRUE(m.isEmpty());
+
+	fillRandom(m, 20000, 5.0f);
+	EXPECT_FALSE(m.isEmpty());
+
+	// No voxel may hold more than the maximum number of points:
+	EXPECT_LE(m.size(), m.voxelCount() * m.getMaxPointsPerVoxel());
+	EXPECT_LT(m.size(), 20000U);
+
+	// Within one voxel, and spanning several shells of voxels:
+	checkNN(m, 5.0f, 0.3f);
+	checkNN(m, 5.0f, 2.0f);
+}
+
+TEST(CVoxelHashPointsMap, removeVoxelsFartherThan)
+{
+	CVoxelHashPointsMap m(0.5, 8);
+	fillRandom(m, 20000, 5.0f);
+
+	const size_t nBefore = m.size();
+	const mrpt::math::TPoint3D center(1.0, 0.5, 0);
+	const double maxDist = 3.0;
+	const size_t nRemoved = m.removeVoxelsFartherThan(center, maxDist);
+
+	EXPECT_GT(nRemoved, 0U);
+	EXPECT_EQ(m.size() + nRemoved, nBefore);
+
+	// All remaining points are within the radius, plus half a voxel diagonal:
+	const double tol = 0.5 * std::sqrt(3.0) * m.getVoxelSize();
+	size_t nVisited = 0;
+	m.visitAllPoints([&](float x, float y, float z) {
+		nVisited++;
+		EXPECT_LE(
+			(mrpt::math::TPoint3D(x, y, z) - center).norm(), maxDist + tol);
+	});
+	EXPECT_EQ(nVisited, m.size());
+
+	// Voxels moved around during removal must remain searchable:
+	checkNN(m, 5.0f, 1.0f);
+}
+
+TEST(CVoxelHashPointsMap, determineMatching3D)
+{
+	// Large enough voxels to keep all points, so the result must match that
+	// of a CSimplePointsMap with the same points:
+	CVoxelHashPointsMap m(0.5, 1000);
+	CSimplePointsMap ref;
+	fillRandom(m, 5000, 5.0f);
+	m.visitAllPoints(
+		[&](float x, float y, float z) { ref.insertPoint(x, y, z); });
+	ASSERT_EQ(m.size(), 5000U);
+
+	CSimplePointsMap other;
+	auto& rng = mrpt::random::getRandomGenerator();
+	for (int i = 0; i < 2000; i++)
+		other.insertPoint(
+			rng.drawUniform(-5.0, 5.0), rng.drawUniform(-5.0, 5.0),
+			rng.drawUniform(-5.0, 5.0));
+	const mrpt::poses::CPose3D otherPose(0.1, -0.2, 0.05, 0.2, 0.1, -0.1);
+
+	TMatchingParams params;
+	params.maxDistForCorrespondence = 0.4f;
+	params.maxAngularDistForCorrespondence = 0.02f;
+
+	TMatchingExtraResults extraRef, extra1, extraN;
+	mrpt::tfest::TMatchingPairList corrsRef, corrs1, corrsN;
+	ref.determineMatching3D(&other, otherPose, corrsRef, params, extraRef);
+	m.determineMatching3D(&other, otherPose, corrs1, params, extra1);
+	params.numThreads = 4;
+	m.determineMatching3D(&other, otherPose, corrsN, params, extraN);
+
+	ASSERT_GT(corrsRef.size(), 100U);
+	ASSERT_EQ(corrs1.size(), corrsRef.size());
+	ASSERT_EQ(corrsN.size(), corrs1.size());
+	EXPECT_NEAR(
+		extra1.correspondencesRatio, extraRef.correspondencesRatio, 1e-6);
+
+	for (size_t i = 0; i < corrs1.size(); i++)
+	{
+		EXPECT_EQ(corrs1[i].other_idx, corrsRef[i].other_idx);
+		EXPECT_FLOAT_EQ(corrs1[i].this_x, corrsRef[i].this_x);
+		EXPECT_FLOAT_EQ(corrs1[i].this_y, corrsRef[i].this_y);
+		EXPECT_FLOAT_EQ(corrs1[i].this_z, corrsRef[i].this_z);
+		EXPECT_EQ(corrsN[i].this_idx, corrs1[i].this_idx);
+		EXPECT_EQ(corrsN[i].other_idx, corrs1[i].other_idx);
+	}
+}
+
+TEST(CVoxelHashPointsMap, insertObservationAndEviction)
+{
+	mrpt::obs::CObservation2DRangeScan scan;
+	mrpt::obs::stock_observations::example2DRangeScan(scan);
+
+	CVoxelHashPointsMap m(0.1, 4);
+	m.insertionOptions.eviction_distance = 15.0;
+
+	const mrpt::poses::CPose3D p1(0, 0, 0, 0, 0, 0);
+	const mrpt::poses::CPose3D p2(40.0, 0, 0, 0, 0, 0);
+	m.insertObservation(scan, &p1);
+	EXPECT_GT(m.size(), 0U);
+
+	// Far away: the points of the first scan get evicted
+	m.insertObservation(scan, &p2);
+	EXPECT_GT(m.size(), 0U);
+	m.visitAllPoints([&](float x, float, float) { EXPECT_GT(x, 20.0f); });
+}
+
+TEST(CVoxelHashPointsMap, CMultiMetricMapAndSerialization)
+{
+	mrpt::config::CConfigFileMemory cfg;
+	cfg.write("map", "voxelHashPointsMap_count", 1);
+	cfg.write("map_voxelHashPointsMap_00_creationOpts", "voxel_size", 0.3);
+	cfg.write(
+		"map_voxelHashPointsMap_00_creationOpts", "max_points_per_voxel", 5);
+
+	TSetOfMetricMapInitializers mapInits;
+	mapInits.loadFromConfigFile(cfg, "map");
+
+	CMultiMetricMap mm;
+	mm.setListOfMaps(mapInits);
+	auto vm = mm.mapByClass<CVoxelHashPointsMap>();
+	ASSERT_TRUE(vm);
+	EXPECT_DOUBLE_EQ(vm->getVoxelSize(), 0.3);
+	EXPECT_EQ(vm->getMaxPointsPerVoxel(), 5U);
+
+	mrpt::obs::CObservation2DRangeScan scan;
+	mrpt::obs::stock_observations::example2DRangeScan(scan);
+	mm.insertObservation(scan);
+	EXPECT_FALSE(vm->isEmpty());
+
+	// Serialization round trip:
+	mrpt::io::CMemoryStream buf;
+	auto arch = mrpt::serialization::archiveFrom(buf);
+	arch << *vm;
+	buf.Seek(0);
+	CVoxelHashPointsMap m2;
+	arch >> m2;
+	EXPECT_DOUBLE_EQ(m2.getVoxelSize(), 0.3);
+	ASSERT_EQ(m2.size(), vm->size());
+	EXPECT_EQ(m2.voxelCount(), vm->voxelCount());
+	std::vector<float> xs1, xs2;
+	vm->visitAllPoints([&](float x, float, float) { xs1.push_back(x); });
+	m2.visitAllPoints([&](float x, float, float) { xs2.push_back(x); });
+	EXPECT_EQ(xs1, xs2);
+}
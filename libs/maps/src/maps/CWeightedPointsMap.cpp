@@ -76,6 +76,7 @@ void CWeightedPointsMap::resize(size_t newLength)
 	m_y.resize(newLength, 0);
 	m_z.resize(newLength, 0);
 	pointWeight.resize(newLength, 1);
+	mark_as_resized();
 }
 
 // Resizes all point buffers so they can hold the given number of points,
@@ -87,6 +88,7 @@ void CWeightedPointsMap::setSize(size_t newLength)
 	m_y.assign(newLength, 0);
 	m_z.assign(newLength, 0);
 	pointWeight.assign(newLength, 1);
+	mark_as_modified();
 }
 
 void CWeightedPointsMap::insertPointFast(float x, float y, float z)
@@ -0,0 +1,40 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2020, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <mrpt/core/WorkerThreadsPool.h>
+#include <algorithm>
+#include <cstddef>
+
+namespace mrpt::maps::internal
+{
+/** Runs `search(i0,i1)` over the query range [0,nQueries), split into
+ * contiguous blocks among `numThreads` threads (0=all hardware cores). Used
+ * for nearest-neighbor searches, e.g. in determineMatching2D/3D(). */
+template <class F>
+void parallelPointsLoop(size_t nQueries, unsigned int numThreads, F&& search)
+{
+	// Below this, the overhead of dispatching tasks does not pay off:
+	constexpr size_t MIN_QUERIES_PER_THREAD = 256;
+
+	numThreads = mrpt::WorkerThreadsPool::clampNumThreads(numThreads);
+
+	if (numThreads == 1 || nQueries < 2 * MIN_QUERIES_PER_THREAD)
+	{
+		search(0, nQueries);
+		return;
+	}
+
+	// One contiguous block per thread keeps queries spatially coherent:
+	const size_t grain = std::max(
+		MIN_QUERIES_PER_THREAD, (nQueries + numThreads - 1) / numThreads);
+	mrpt::WorkerThreadsPool::sharedPool().parallel_for(
+		0, nQueries, search, grain);
+}
+}  // namespace mrpt::maps::internal
@@ -30,7 +30,9 @@ MRPT_INITIALIZER(registerAllClasses_mrpt_maps)
 	registerClass(CLASS_ID(CColouredPointsMap));
 	registerClass(CLASS_ID(CWeightedPointsMap));
 	registerClass(CLASS_ID(CPointsMapXYZI));
+	registerClass(CLASS_ID(CVoxelHashPointsMap));
 	registerClass(CLASS_ID(COccupancyGridMap2D));
+	registerClass(CLASS_ID(CTiledOccupancyGridMap2D));
 	registerClass(CLASS_ID(COccupancyGridMap3D));
 	registerClass(CLASS_ID(CGasConcentrationGridMap2D));
 	registerClass(CLASS_ID(CWirelessPowerGridMap2D));
@@ -13,14 +13,34 @@
 #include <mrpt/core/exceptions.h>
 #include <mrpt/math/TPoint2D.h>
 #include <mrpt/math/TPoint3D.h>
+#include <algorithm>
 #include <array>
 #include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <limits>
 #include <memory>  // unique_ptr
 #include <mutex>
 #include <nanoflann.hpp>
+#include <vector>
 
 namespace mrpt::math
 {
+namespace internal
+{
+/** Rebinds a nanoflann metric adaptor `METRIC<T,DataSource,DistanceType>` to
+ * another data source type. */
+template <class METRIC, class DATASOURCE>
+struct rebind_kdtree_metric;
+template <
+	template <class, class, class> class METRIC, class T, class DS0,
+	class DIST, class DATASOURCE>
+struct rebind_kdtree_metric<METRIC<T, DS0, DIST>, DATASOURCE>
+{
+	using type = METRIC<T, DATASOURCE, DIST>;
+};
+}  // namespace internal
+
 /** \addtogroup kdtree_grp KD-Trees
  *  \ingroup mrpt_math_grp
  *  @{ */
@@ -65,6 +85,17 @@ namespace mrpt::math
  * The KD-tree index will be built on demand only upon call of any of the query
  * methods provided by this class.
  *
+ * By default, any change marked with kdtree_mark_as_outdated() causes the
+ * whole KD-tree to be rebuilt on the next query. If
+ * `kdtree_search_params.incremental` is set, derived classes which only
+ * append new points at the end of the data set may call
+ * kdtree_mark_as_appended() instead: new points are then indexed in a new
+ * sub-tree, and sub-trees are merged following the logarithmic method (the
+ * newest sub-tree is rebuilt together with the previous one while the latter
+ * is not larger), so the amortized cost of an insertion depends on the number
+ * of inserted points, not on the size of the data set. Points can also be
+ * lazily removed from the index with kdtree_mark_as_deleted().
+ *
  *  Notice that there is only ONE internal cached KD-tree, so if a method to
  * query a 2D point is called,
  *  then another method for 3D points, then again the 2D method, three KD-trees
@@ -89,10 +120,23 @@ class KDTreeCapable
 
 	/// Constructor
 	inline KDTreeCapable() = default;
-	KDTreeCapable(const KDTreeCapable&) : KDTreeCapable() {}
-	KDTreeCapable& operator=(const KDTreeCapable&)
+	/** Copy constructor: copies the search parameters and the list of deleted
+	 * points, but not the KD-tree, which will be rebuilt on demand. */
+	KDTreeCapable(const KDTreeCapable& o)
+		: kdtree_search_params(o.kdtree_search_params)
+	{
+		std::lock_guard<std::mutex> lck(o.m_kdtree_mtx);
+		m_kdtree_deleted = o.m_kdtree_deleted;
+	}
+	KDTreeCapable& operator=(const KDTreeCapable& o)
 	{
+		if (&o == this) return *this;
+		kdtree_search_params = o.kdtree_search_params;
 		kdtree_mark_as_outdated();
+		std::lock(m_kdtree_mtx, o.m_kdtree_mtx);
+		std::lock_guard<std::mutex> lck1(m_kdtree_mtx, std::adopt_lock);
+		std::lock_guard<std::mutex> lck2(o.m_kdtree_mtx, std::adopt_lock);
+		m_kdtree_deleted = o.m_kdtree_deleted;
 		return *this;
 	}
 
@@ -108,6 +152,11 @@ class KDTreeCapable
 		TKDTreeSearchParams() = default;
 		/** Max points per leaf */
 		size_t leaf_max_size{10};
+		/** If true, points appended to the data set (see
+		 * kdtree_mark_as_appended()) are indexed in new sub-trees instead of
+		 * rebuilding the whole KD-tree (Default: false).
+		 * \note (New in MRPT 2.1.0) */
+		bool incremental{false};
 	};
 
 	/** Parameters to tune the ANN searches */
@@ -148,8 +197,9 @@ class KDTreeCapable
 		resultSet.init(&ret_index, &out_dist_sqr);
 
 		const std::array<num_t, 2> query_point{{x0, y0}};
-		m_kdtree2d_data.index->findNeighbors(
-			resultSet, &query_point[0], nanoflann::SearchParams());
+		kdtree_find_neighbors(
+			m_kdtree2d_data, resultSet, &query_point[0],
+			nanoflann::SearchParams());
 
 		// Copy output to user vars:
 		out_x = derived().kdtree_get_pt(ret_index, 0);
@@ -174,8 +224,9 @@ class KDTreeCapable
 		resultSet.init(&ret_index, &out_dist_sqr);
 
 		const std::array<num_t, 2> query_point{{x0, y0}};
-		m_kdtree2d_data.index->findNeighbors(
-			resultSet, &query_point[0], nanoflann::SearchParams());
+		kdtree_find_neighbors(
+			m_kdtree2d_data, resultSet, &query_point[0],
+			nanoflann::SearchParams());
 
 		return ret_index;
 		MRPT_END
@@ -244,8 +295,9 @@ class KDTreeCapable
 		resultSet.init(&ret_indexes[0], &ret_sqdist[0]);
 
 		const std::array<num_t, 2> query_point{{x0, y0}};
-		m_kdtree2d_data.index->findNeighbors(
-			resultSet, &query_point[0], nanoflann::SearchParams());
+		kdtree_find_neighbors(
+			m_kdtree2d_data, resultSet, &query_point[0],
+			nanoflann::SearchParams());
 
 		// Copy output to user vars:
 		out_x1 = derived().kdtree_get_pt(ret_indexes[0], 0);
@@ -311,8 +363,9 @@ class KDTreeCapable
 		resultSet.init(&ret_indexes[0], &out_dist_sqr[0]);
 
 		const std::array<num_t, 2> query_point{{x0, y0}};
-		m_kdtree2d_data.index->findNeighbors(
-			resultSet, &query_point[0], nanoflann::SearchParams());
+		kdtree_find_neighbors(
+			m_kdtree2d_data, resultSet, &query_point[0],
+			nanoflann::SearchParams());
 
 		for (size_t i = 0; i < knn; i++)
 		{
@@ -370,8 +423,9 @@ class KDTreeCapable
 		resultSet.init(&out_idx[0], &out_dist_sqr[0]);
 
 		const std::array<num_t, 2> query_point{{x0, y0}};
-		m_kdtree2d_data.index->findNeighbors(
-			resultSet, &query_point[0], nanoflann::SearchParams());
+		kdtree_find_neighbors(
+			m_kdtree2d_data, resultSet, &query_point[0],
+			nanoflann::SearchParams());
 		MRPT_END
 	}
 
@@ -417,8 +471,9 @@ class KDTreeCapable
 		resultSet.init(&ret_index, &out_dist_sqr);
 
 		const std::array<num_t, 3> query_point{{x0, y0, z0}};
-		m_kdtree3d_data.index->findNeighbors(
-			resultSet, &query_point[0], nanoflann::SearchParams());
+		kdtree_find_neighbors(
+			m_kdtree3d_data, resultSet, &query_point[0],
+			nanoflann::SearchParams());
 
 		// Copy output to user vars:
 		out_x = derived().kdtree_get_pt(ret_index, 0);
@@ -444,8 +499,9 @@ class KDTreeCapable
 		resultSet.init(&ret_index, &out_dist_sqr);
 
 		const std::array<num_t, 3> query_point{{x0, y0, z0}};
-		m_kdtree3d_data.index->findNeighbors(
-			resultSet, &query_point[0], nanoflann::SearchParams());
+		kdtree_find_neighbors(
+			m_kdtree3d_data, resultSet, &query_point[0],
+			nanoflann::SearchParams());
 
 		return ret_index;
 		MRPT_END
@@ -506,8 +562,9 @@ class KDTreeCapable
 		resultSet.init(&ret_indexes[0], &out_dist_sqr[0]);
 
 		const std::array<num_t, 3> query_point{{x0, y0, z0}};
-		m_kdtree3d_data.index->findNeighbors(
-			resultSet, &query_point[0], nanoflann::SearchParams());
+		kdtree_find_neighbors(
+			m_kdtree3d_data, resultSet, &query_point[0],
+			nanoflann::SearchParams());
 
 		for (size_t i = 0; i < knn; i++)
 		{
@@ -561,8 +618,9 @@ class KDTreeCapable
 		resultSet.init(&out_idx[0], &out_dist_sqr[0]);
 
 		const std::array<num_t, 3> query_point{{x0, y0, z0}};
-		m_kdtree3d_data.index->findNeighbors(
-			resultSet, &query_point[0], nanoflann::SearchParams());
+		kdtree_find_neighbors(
+			m_kdtree3d_data, resultSet, &query_point[0],
+			nanoflann::SearchParams());
 
 		for (size_t i = 0; i < knn; i++)
 		{
@@ -617,9 +675,8 @@ class KDTreeCapable
 		if (m_kdtree3d_data.m_num_points != 0)
 		{
 			const num_t xyz[3] = {x0, y0, z0};
-			m_kdtree3d_data.index->radiusSearch(
-				&xyz[0], maxRadiusSqr, out_indices_dist,
-				nanoflann::SearchParams());
+			kdtree_radius_search(
+				m_kdtree3d_data, &xyz[0], maxRadiusSqr, out_indices_dist);
 		}
 		return out_indices_dist.size();
 		MRPT_END
@@ -651,9 +708,8 @@ class KDTreeCapable
 		if (m_kdtree2d_data.m_num_points != 0)
 		{
 			const num_t xyz[2] = {x0, y0};
-			m_kdtree2d_data.index->radiusSearch(
-				&xyz[0], maxRadiusSqr, out_indices_dist,
-				nanoflann::SearchParams());
+			kdtree_radius_search(
+				m_kdtree2d_data, &xyz[0], maxRadiusSqr, out_indices_dist);
 		}
 		return out_indices_dist.size();
 		MRPT_END
@@ -691,8 +747,9 @@ class KDTreeCapable
 		resultSet.init(&out_idx[0], &out_dist_sqr[0]);
 
 		const std::array<num_t, 3> query_point{{x0, y0, z0}};
-		m_kdtree3d_data.index->findNeighbors(
-			resultSet, &query_point[0], nanoflann::SearchParams());
+		kdtree_find_neighbors(
+			m_kdtree3d_data, resultSet, &query_point[0],
+			nanoflann::SearchParams());
 		MRPT_END
 	}
 
@@ -704,8 +761,59 @@ class KDTreeCapable
 			d2f(p0.x), d2f(p0.y), d2f(p0.z), N, outIdx, outDistSqr);
 	}
 
-	inline void kdTreeEnsureIndexBuilt3D() { rebuild_kdTree_3D(); }
-	inline void kdTreeEnsureIndexBuilt2D() { rebuild_kdTree_2D(); }
+	/** Batched version of kdTreeClosestPoint2D(): finds the closest point to
+	 * each of the `N` query points `(xs[i],ys[i])`, and stores its index and
+	 * squared distance in `out_idx[i]` and `out_dist_sqr[i]`.
+	 *
+	 * Queries are assumed to be spatially coherent (e.g. consecutive points of
+	 * a range scan): the result of each query is used as an initial upper
+	 * bound of the distance for the next one, so far branches of the tree are
+	 * discarded earlier. Results are exactly those of kdTreeClosestPoint2D(),
+	 * including the choice among equidistant neighbors, so they do not depend
+	 * on how queries are split into batches.
+	 *
+	 * Once the KD-tree is built, this method can be safely invoked from
+	 * several threads at once, on disjoint output ranges.
+	 *
+	 * \sa kdTreeClosestPoint3DBatch
+	 * \note (New in MRPT 2.1.0)
+	 */
+	inline void kdTreeClosestPoint2DBatch(
+		const num_t* xs, const num_t* ys, size_t N, size_t* out_idx,
+		num_t* out_dist_sqr) const
+	{
+		MRPT_START
+		rebuild_kdTree_2D();  // First: Create the 2D KD-Tree if required
+		if (!m_kdtree2d_data.m_num_points)
+			THROW_EXCEPTION("There are no points in the KD-tree.");
+
+		const std::array<const num_t*, 2> coords{{xs, ys}};
+		kdtree_closest_batch(
+			m_kdtree2d_data, coords, N, out_idx, out_dist_sqr);
+		MRPT_END
+	}
+
+	/** Batched version of kdTreeClosestPoint3D(). See
+	 * kdTreeClosestPoint2DBatch() for details.
+	 * \note (New in MRPT 2.1.0)
+	 */
+	inline void kdTreeClosestPoint3DBatch(
+		const num_t* xs, const num_t* ys, const num_t* zs, size_t N,
+		size_t* out_idx, num_t* out_dist_sqr) const
+	{
+		MRPT_START
+		rebuild_kdTree_3D();  // First: Create the 3D KD-Tree if required
+		if (!m_kdtree3d_data.m_num_points)
+			THROW_EXCEPTION("There are no points in the KD-tree.");
+
+		const std::array<const num_t*, 3> coords{{xs, ys, zs}};
+		kdtree_closest_batch(
+			m_kdtree3d_data, coords, N, out_idx, out_dist_sqr);
+		MRPT_END
+	}
+
+	inline void kdTreeEnsureIndexBuilt3D() const { rebuild_kdTree_3D(); }
+	inline void kdTreeEnsureIndexBuilt2D() const { rebuild_kdTree_2D(); }
 
 	/* @} */
 
@@ -715,9 +823,104 @@ class KDTreeCapable
 	{
 		std::lock_guard<std::mutex> lck(m_kdtree_mtx);
 		m_kdtree_is_uptodate = false;
+		m_kdtree_deleted.clear();
+	}
+
+	/** To be called by child classes when new points have been appended at
+	 * the end of the data set, while all former points remain unchanged. In
+	 * incremental mode (see TKDTreeSearchParams::incremental) only the new
+	 * points will be indexed in the next query, otherwise this is equivalent
+	 * to kdtree_mark_as_outdated().
+	 * \note (New in MRPT 2.1.0) */
+	inline void kdtree_mark_as_appended() const
+	{
+		if (kdtree_search_params.incremental) return;
+		std::lock_guard<std::mutex> lck(m_kdtree_mtx);
+		m_kdtree_is_uptodate = false;
+	}
+
+	/** To be called by child classes to lazily remove the point with index
+	 * `idx` from the results of all queries, without changing the indices of
+	 * the rest of points. Points are actually removed from the sub-trees in
+	 * incremental mode, once more than half the points of a sub-tree are
+	 * deleted. kdtree_mark_as_outdated() restores all points.
+	 * \note (New in MRPT 2.1.0) */
+	void kdtree_mark_as_deleted(size_t idx) const
+	{
+		std::lock_guard<std::mutex> lck(m_kdtree_mtx);
+		if (m_kdtree_deleted.size() <= idx) m_kdtree_deleted.resize(idx + 1, 0);
+		if (m_kdtree_deleted[idx]) return;
+		m_kdtree_deleted[idx] = 1;
+		if (!m_kdtree_is_uptodate) return;
+		kdtree_on_deleted(m_kdtree2d_data, idx);
+		kdtree_on_deleted(m_kdtree3d_data, idx);
 	}
 
    private:
+	/** Dataset adaptor exposing a subset of the points of the derived class,
+	 * for each sub-tree in incremental mode. */
+	struct TSubsetAdaptor
+	{
+		const Derived* data = nullptr;
+		/** Indices of the points in the derived class, in increasing order */
+		std::vector<size_t> ids;
+
+		inline size_t kdtree_get_point_count() const { return ids.size(); }
+		inline num_t kdtree_get_pt(const size_t idx, int dim) const
+		{
+			return data->kdtree_get_pt(ids[idx], dim);
+		}
+		inline num_t kdtree_distance(
+			const num_t* p1, const size_t idx_p2, size_t size) const
+		{
+			return data->kdtree_distance(p1, ids[idx_p2], size);
+		}
+		template <class BBOX>
+		bool kdtree_get_bbox(BBOX&) const
+		{
+			return false;
+		}
+	};
+
+	/** One of the sub-trees of the incremental mode */
+	template <int _DIM>
+	struct TSubTree
+	{
+		using kdtree_index_t = nanoflann::KDTreeSingleIndexAdaptor<
+			typename internal::rebind_kdtree_metric<
+				metric_t, TSubsetAdaptor>::type,
+			TSubsetAdaptor, _DIM>;
+
+		/** The index keeps a reference to this, so it must not move */
+		TSubsetAdaptor points;
+		std::unique_ptr<kdtree_index_t> index;
+		/** Number of indexed points marked as deleted afterwards */
+		size_t num_deleted = 0;
+
+		size_t num_alive() const { return points.ids.size() - num_deleted; }
+	};
+
+	/** Result set adaptor for searches within a sub-tree (or the whole data
+	 * set, if `ids==nullptr`), which translates point indices and skips
+	 * deleted points. */
+	template <class RESULTSET>
+	struct TFilteredResultSet
+	{
+		RESULTSET& results;
+		const size_t* ids;
+		const std::vector<uint8_t>& deleted;
+
+		inline size_t size() const { return results.size(); }
+		inline bool full() const { return results.full(); }
+		inline num_t worstDist() const { return results.worstDist(); }
+		inline void addPoint(num_t dist, size_t idx)
+		{
+			if (ids) idx = ids[idx];
+			if (idx < deleted.size() && deleted[idx]) return;
+			results.addPoint(dist, idx);
+		}
+	};
+
 	/** Internal structure with the KD-tree representation (mainly used to avoid
 	 * copying pointers with the = operator) */
 	template <int _DIM = -1>
@@ -738,16 +941,35 @@ class KDTreeCapable
 		}
 
 		/** Free memory (if allocated)  */
-		inline void clear() noexcept { index.reset(); }
+		inline void clear() noexcept
+		{
+			index.reset();
+			subtrees.clear();
+			m_built = false;
+			m_needs_purge = false;
+			m_num_points = 0;
+			m_num_indexed = 0;
+		}
 		using kdtree_index_t =
 			nanoflann::KDTreeSingleIndexAdaptor<metric_t, Derived, _DIM>;
 
 		/** nullptr or the up-to-date index */
 		std::unique_ptr<kdtree_index_t> index;
+		/** Incremental mode: sub-trees over increasing, disjoint ranges of
+		 * point indices, from the oldest (and largest) to the newest one. */
+		std::vector<std::unique_ptr<TSubTree<_DIM>>> subtrees;
 
 		/** Dimensionality. typ: 2,3 */
 		size_t m_dim = _DIM;
+		/** Number of non-deleted indexed points */
 		size_t m_num_points = 0;
+		/** Points with indices in [0,m_num_indexed) have been indexed.
+		 * Atomic, like the flags below, since they are checked without
+		 * locking the mutex in rebuild_kdTree(). */
+		std::atomic<size_t> m_num_indexed{0};
+		/** Set only once the index has been completely built */
+		std::atomic_bool m_built{false};
+		std::atomic_bool m_incremental{false}, m_needs_purge{false};
 	};
 
 	mutable std::mutex m_kdtree_mtx;
@@ -755,15 +977,108 @@ class KDTreeCapable
 	mutable TKDTreeDataHolder<3> m_kdtree3d_data;
 	/** whether the KD tree needs to be rebuilt or not. */
 	mutable std::atomic_bool m_kdtree_is_uptodate{false};
+	/** Flags of points marked with kdtree_mark_as_deleted(), by index */
+	mutable std::vector<uint8_t> m_kdtree_deleted;
+
+	inline bool kdtree_is_deleted(size_t idx) const
+	{
+		return idx < m_kdtree_deleted.size() && m_kdtree_deleted[idx];
+	}
+
+	/// Runs a query on either the whole KD-tree or each of the sub-trees.
+	template <int DIM, class RESULTSET>
+	void kdtree_find_neighbors(
+		const TKDTreeDataHolder<DIM>& kd, RESULTSET& resultSet,
+		const num_t* query_point, const nanoflann::SearchParams& params) const
+	{
+		if (kd.index)
+		{
+			if (m_kdtree_deleted.empty())
+				kd.index->findNeighbors(resultSet, query_point, params);
+			else
+			{
+				TFilteredResultSet<RESULTSET> rs{resultSet, nullptr,
+												 m_kdtree_deleted};
+				kd.index->findNeighbors(rs, query_point, params);
+			}
+			return;
+		}
+		for (const auto& st : kd.subtrees)
+		{
+			TFilteredResultSet<RESULTSET> rs{resultSet, st->points.ids.data(),
+											 m_kdtree_deleted};
+			st->index->findNeighbors(rs, query_point, params);
+		}
+	}
+
+	/// Radius search, with results sorted by ascending distance.
+	template <int DIM>
+	void kdtree_radius_search(
+		const TKDTreeDataHolder<DIM>& kd, const num_t* query_point,
+		const num_t maxRadiusSqr,
+		std::vector<std::pair<size_t, num_t>>& out_indices_dist) const
+	{
+		nanoflann::RadiusResultSet<num_t, size_t> resultSet(
+			maxRadiusSqr, out_indices_dist);
+		kdtree_find_neighbors(
+			kd, resultSet, query_point, nanoflann::SearchParams());
+		std::sort(
+			out_indices_dist.begin(), out_indices_dist.end(),
+			nanoflann::IndexDist_Sorter());
+	}
+
+	/// Common implementation of the batched single-NN queries.
+	template <int DIM, class COORDS>
+	void kdtree_closest_batch(
+		const TKDTreeDataHolder<DIM>& kd, const COORDS& coords, size_t N,
+		size_t* out_idx, num_t* out_dist_sqr) const
+	{
+		const metric_t distance(derived());
+		std::array<num_t, DIM> query_point;
+		for (size_t i = 0; i < N; i++)
+		{
+			for (int d = 0; d < DIM; d++)
+				query_point[d] = coords[d][i];
+
+			nanoflann::KNNResultSet<num_t> resultSet(1);
+			resultSet.init(&out_idx[i], &out_dist_sqr[i]);
+			// Warm start: the previous answer bounds the NN distance. The
+			// bound is slightly larger than its distance, so it is always
+			// replaced, and ties are resolved as without a warm start:
+			if (i > 0)
+				resultSet.addPoint(
+					std::nextafter(
+						distance(&query_point[0], out_idx[i - 1], DIM),
+						std::numeric_limits<num_t>::max()),
+					out_idx[i - 1]);
+
+			kdtree_find_neighbors(
+				kd, resultSet, &query_point[0], nanoflann::SearchParams());
+		}
+	}
 
 	/// Rebuild, if needed the KD-tree for 2D (nDims=2), 3D (nDims=3), ...
 	/// asking the child class for the data points.
-	void rebuild_kdTree_2D() const
+	void rebuild_kdTree_2D() const { rebuild_kdTree(m_kdtree2d_data); }
+	/// \overload
+	void rebuild_kdTree_3D() const { rebuild_kdTree(m_kdtree3d_data); }
+
+	template <int DIM>
+	void rebuild_kdTree(TKDTreeDataHolder<DIM>& kd) const
 	{
-		if (m_kdtree_is_uptodate) return;
+		const bool incremental = kdtree_search_params.incremental;
+		const auto isUpToDate = [&]() {
+			return m_kdtree_is_uptodate && kd.m_built && !kd.m_needs_purge &&
+				kd.m_incremental == incremental &&
+				(!incremental ||
+				 kd.m_num_indexed == derived().kdtree_get_point_count());
+		};
+		// Fast path, for concurrent queries once the index is built:
+		if (isUpToDate()) return;
 
 		std::lock_guard<std::mutex> lck(m_kdtree_mtx);
-		using tree2d_t = typename TKDTreeDataHolder<2>::kdtree_index_t;
+		// Another thread may have built it while we waited for the lock:
+		if (isUpToDate()) return;
 
 		if (!m_kdtree_is_uptodate)
 		{
@@ -771,60 +1086,131 @@ class KDTreeCapable
 			m_kdtree3d_data.clear();
 		}
 
-		if (!m_kdtree2d_data.index)
+		const size_t N = derived().kdtree_get_point_count();
+		// Erase previous tree if it cannot be updated:
+		if (kd.m_built &&
+			(kd.m_incremental != incremental || N < kd.m_num_indexed))
+			kd.clear();
+
+		if (!kd.m_built)
 		{
-			// Erase previous tree:
-			m_kdtree2d_data.clear();
-			// And build new index:
-			const size_t N = derived().kdtree_get_point_count();
-			m_kdtree2d_data.m_num_points = N;
-			m_kdtree2d_data.m_dim = 2;
-			if (N)
+			kd.m_incremental = incremental;
+			kd.m_dim = DIM;
+			if (!incremental)
 			{
-				m_kdtree2d_data.index.reset(new tree2d_t(
-					2, derived(),
-					nanoflann::KDTreeSingleIndexAdaptorParams(
-						kdtree_search_params.leaf_max_size)));
-				m_kdtree2d_data.index->buildIndex();
+				// And build new index:
+				kd.m_num_points = N;
+				for (size_t i = 0; i < std::min(N, m_kdtree_deleted.size());
+					 i++)
+					if (m_kdtree_deleted[i]) kd.m_num_points--;
+				if (N)
+				{
+					using tree_t =
+						typename TKDTreeDataHolder<DIM>::kdtree_index_t;
+					kd.index.reset(new tree_t(
+						DIM, derived(),
+						nanoflann::KDTreeSingleIndexAdaptorParams(
+							kdtree_search_params.leaf_max_size)));
+					kd.index->buildIndex();
+				}
+				kd.m_num_indexed = N;
 			}
-			m_kdtree_is_uptodate = true;
 		}
+		if (incremental)
+		{
+			if (kd.m_needs_purge) kdtree_purge_subtrees(kd);
+			if (N > kd.m_num_indexed) kdtree_append_subtree(kd, N);
+		}
+		// Published last, so the fast path never sees a half-built index:
+		kd.m_built = true;
+		m_kdtree_is_uptodate = true;
 	}
 
-	/// Rebuild, if needed the KD-tree for 2D (nDims=2), 3D (nDims=3), ...
-	/// asking the child class for the data points.
-	void rebuild_kdTree_3D() const
+	/// Creates and indexes a new sub-tree with the given points
+	template <int DIM>
+	std::unique_ptr<TSubTree<DIM>> kdtree_build_subtree(
+		std::vector<size_t>&& ids) const
 	{
-		if (m_kdtree_is_uptodate) return;
-		std::lock_guard<std::mutex> lck(m_kdtree_mtx);
-		using tree3d_t = typename TKDTreeDataHolder<3>::kdtree_index_t;
+		auto st = std::make_unique<TSubTree<DIM>>();
+		st->points.data = &derived();
+		st->points.ids = std::move(ids);
+		st->index = std::make_unique<typename TSubTree<DIM>::kdtree_index_t>(
+			DIM, st->points,
+			nanoflann::KDTreeSingleIndexAdaptorParams(
+				kdtree_search_params.leaf_max_size));
+		st->index->buildIndex();
+		return st;
+	}
 
-		if (!m_kdtree_is_uptodate)
+	/// Indexes the points in [kd.m_num_indexed, N), merging the new sub-tree
+	/// with the latest ones while they are not larger.
+	template <int DIM>
+	void kdtree_append_subtree(TKDTreeDataHolder<DIM>& kd, size_t N) const
+	{
+		std::vector<size_t> ids;
+		ids.reserve(N - kd.m_num_indexed);
+		for (size_t i = kd.m_num_indexed; i < N; i++)
+			if (!kdtree_is_deleted(i)) ids.push_back(i);
+		kd.m_num_points += ids.size();
+
+		while (!kd.subtrees.empty() &&
+			   kd.subtrees.back()->num_alive() <= ids.size())
 		{
-			m_kdtree2d_data.clear();
-			m_kdtree3d_data.clear();
+			const auto& prev = kd.subtrees.back()->points.ids;
+			std::vector<size_t> merged;
+			merged.reserve(prev.size() + ids.size());
+			for (const size_t i : prev)
+				if (!kdtree_is_deleted(i)) merged.push_back(i);
+			merged.insert(merged.end(), ids.begin(), ids.end());
+			ids.swap(merged);
+			kd.subtrees.pop_back();
 		}
+		if (!ids.empty())
+			kd.subtrees.emplace_back(kdtree_build_subtree<DIM>(std::move(ids)));
+		kd.m_num_indexed = N;
+	}
 
-		if (!m_kdtree3d_data.index)
+	/// Rebuilds the sub-trees with more than half their points deleted.
+	template <int DIM>
+	void kdtree_purge_subtrees(TKDTreeDataHolder<DIM>& kd) const
+	{
+		auto& subtrees = kd.subtrees;
+		for (auto& st : subtrees)
 		{
-			// Erase previous tree:
-			m_kdtree3d_data.clear();
-			// And build new index:
-			const size_t N = derived().kdtree_get_point_count();
-			m_kdtree3d_data.m_num_points = N;
-			m_kdtree3d_data.m_dim = 3;
-			if (N)
-			{
-				m_kdtree3d_data.index.reset(new tree3d_t(
-					3, derived(),
-					nanoflann::KDTreeSingleIndexAdaptorParams(
-						kdtree_search_params.leaf_max_size)));
-				m_kdtree3d_data.index->buildIndex();
-			}
-			m_kdtree_is_uptodate = true;
+			if (2 * st->num_deleted <= st->points.ids.size()) continue;
+			std::vector<size_t> ids;
+			ids.reserve(st->num_alive());
+			for (const size_t i : st->points.ids)
+				if (!kdtree_is_deleted(i)) ids.push_back(i);
+			if (ids.empty())
+				st.reset();
+			else
+				st = kdtree_build_subtree<DIM>(std::move(ids));
 		}
+		subtrees.erase(
+			std::remove(subtrees.begin(), subtrees.end(), nullptr),
+			subtrees.end());
+		kd.m_needs_purge = false;
 	}
 
+	/// Updates the counters of deleted points after kdtree_mark_as_deleted()
+	template <int DIM>
+	static void kdtree_on_deleted(TKDTreeDataHolder<DIM>& kd, size_t idx)
+	{
+		if (!kd.m_built || idx >= kd.m_num_indexed) return;
+		kd.m_num_points--;
+		if (!kd.m_incremental) return;
+		// The sub-tree holding idx is the last one starting at or before it:
+		auto it = std::upper_bound(
+			kd.subtrees.begin(), kd.subtrees.end(), idx,
+			[](size_t i, const std::unique_ptr<TSubTree<DIM>>& st) {
+				return i < st->points.ids.front();
+			});
+		if (it == kd.subtrees.begin()) return;
+		auto& st = **std::prev(it);
+		if (2 * (++st.num_deleted) > st.points.ids.size())
+			kd.m_needs_purge = true;
+	}
 };  // end of KDTreeCapable
 
 /**  @} */  // end of grouping
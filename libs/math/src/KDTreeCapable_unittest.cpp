@@ -10,10 +10,242 @@
 #include <gtest/gtest.h>
 #include <mrpt/math/KDTreeCapable.h>
 #include <mrpt/random.h>
+#include <algorithm>
+#include <limits>
+#include <thread>
 
 using namespace mrpt;
 using namespace mrpt::math;
 using namespace mrpt::random;
 using namespace std;
 
-TEST(KDTreeCapable, test1) { MRPT_TODO("Write me!"); }
+namespace
+{
+// A minimal 3D point cloud with a KD-tree:
+class TestPointCloud : public KDTreeCapable<TestPointCloud>
+{
+   public:
+	std::vector<TPoint3Df> pts;
+
+	void append(size_t N)
+	{
+		auto& rng = getRandomGenerator();
+		for (size_t i = 0; i < N; i++)
+			pts.emplace_back(
+				rng.drawUniform(-10.0f, 10.0f), rng.drawUniform(-10.0f, 10.0f),
+				rng.drawUniform(-10.0f, 10.0f));
+		kdtree_mark_as_appended();
+	}
+	void remove(size_t idx) { kdtree_mark_as_deleted(idx); }
+	void removeFromStorage(size_t N)
+	{
+		pts.resize(pts.size() - N);
+		kdtree_mark_as_outdated();
+	}
+
+	inline size_t kdtree_get_point_count() const { return pts.size(); }
+	inline float kdtree_get_pt(const size_t idx, int dim) const
+	{
+		return dim == 0 ? pts[idx].x : (dim == 1 ? pts[idx].y : pts[idx].z);
+	}
+	inline float kdtree_distance(
+		const float* p1, const size_t idx_p2, size_t size) const
+	{
+		float d = 0;
+		for (size_t i = 0; i < size; i++)
+			d += square(p1[i] - kdtree_get_pt(idx_p2, i));
+		return d;
+	}
+	template <typename BBOX>
+	bool kdtree_get_bbox(BBOX&) const
+	{
+		return false;
+	}
+};
+
+// Compares the KD-tree queries against a brute-force search:
+void checkQueries(const TestPointCloud& pc, const std::vector<bool>& deleted)
+{
+	auto& rng = getRandomGenerator();
+	for (int q = 0; q < 50; q++)
+	{
+		const float qx = rng.drawUniform(-10.0f, 10.0f),
+					qy = rng.drawUniform(-10.0f, 10.0f),
+					qz = rng.drawUniform(-10.0f, 10.0f);
+		const float query[3] = {qx, qy, qz};
+
+		std::vector<std::pair<float, size_t>> bf;
+		for (size_t i = 0; i < pc.pts.size(); i++)
+			if (!deleted[i])
+				bf.emplace_back(pc.kdtree_distance(query, i, 3), i);
+		std::sort(bf.begin(), bf.end());
+		ASSERT_FALSE(bf.empty());
+
+		// Closest point:
+		float x, y, z, distSqr;
+		const size_t idx =
+			pc.kdTreeClosestPoint3D(qx, qy, qz, x, y, z, distSqr);
+		EXPECT_EQ(idx, bf[0].second);
+		EXPECT_FLOAT_EQ(distSqr, bf[0].first);
+
+		// k-NN:
+		const size_t K = std::min<size_t>(5, bf.size());
+		std::vector<size_t> knnIdx;
+		std::vector<float> knnDist;
+		pc.kdTreeNClosestPoint3DIdx(qx, qy, qz, K, knnIdx, knnDist);
+		for (size_t k = 0; k < K; k++)
+		{
+			EXPECT_EQ(knnIdx[k], bf[k].second);
+			EXPECT_FLOAT_EQ(knnDist[k], bf[k].first);
+		}
+
+		// Radius search:
+		const float radiusSqr =
+			bf[std::min<size_t>(20, bf.size() - 1)].first;
+		std::vector<std::pair<size_t, float>> inRadius;
+		pc.kdTreeRadiusSearch3D(qx, qy, qz, radiusSqr, inRadius);
+		size_t nExpected = 0;
+		while (nExpected < bf.size() && bf[nExpected].first < radiusSqr)
+			nExpected++;
+		ASSERT_EQ(inRadius.size(), nExpected);
+		for (size_t k = 0; k < nExpected; k++)
+			EXPECT_EQ(inRadius[k].first, bf[k].second);
+	}
+}
+}  // namespace
+
+TEST(KDTreeCapable, appendQueries)
+{
+	for (const bool incremental : {false, true})
+	{
+		getRandomGenerator().randomize(1234);
+		TestPointCloud pc;
+		pc.kdtree_search_params.incremental = incremental;
+
+		// Appends of assorted sizes, with queries in between:
+		for (const size_t n : {1, 1, 100, 3, 1000, 50, 1, 7, 300})
+		{
+			pc.append(n);
+			checkQueries(pc, std::vector<bool>(pc.pts.size(), false));
+		}
+	}
+}
+
+TEST(KDTreeCapable, batchQueriesWithTies)
+{
+	// Points on a grid, and queries equidistant to 8 of them:
+	TestPointCloud pc;
+	for (int i = 0; i < 20; i++)
+		for (int j = 0; j < 20; j++)
+			for (int k = 0; k < 2; k++)
+				pc.pts.emplace_back(float(i), float(j), float(k));
+	std::vector<float> qx, qy, qz;
+	for (int i = 0; i < 19; i++)
+		for (int j = 0; j < 19; j++)
+		{
+			qx.push_back(i + 0.5f);
+			qy.push_back(j + 0.5f);
+			qz.push_back(0.5f);
+		}
+	const size_t N = qx.size();
+
+	// Each result must be that of a single query, for any batch split:
+	std::vector<size_t> ref(N);
+	for (size_t i = 0; i < N; i++)
+	{
+		float d;
+		ref[i] = pc.kdTreeClosestPoint3D(qx[i], qy[i], qz[i], d);
+	}
+	for (const size_t batch : {N, size_t(7)})
+	{
+		std::vector<size_t> idx(N);
+		std::vector<float> dist(N);
+		for (size_t i = 0; i < N; i += batch)
+			pc.kdTreeClosestPoint3DBatch(
+				&qx[i], &qy[i], &qz[i], std::min(batch, N - i), &idx[i],
+				&dist[i]);
+		EXPECT_EQ(idx, ref) << "batch: " << batch;
+	}
+}
+
+TEST(KDTreeCapable, lazyDeletion)
+{
+	for (const bool incremental : {false, true})
+	{
+		getRandomGenerator().randomize(4321);
+		TestPointCloud pc;
+		pc.kdtree_search_params.incremental = incremental;
+
+		pc.append(500);
+		std::vector<bool> deleted(pc.pts.size(), false);
+		checkQueries(pc, deleted);
+
+		// Delete most points, so sub-trees get purged:
+		for (size_t i = 0; i < 400; i += 1 + (i % 3 == 0 ? 0 : 1))
+		{
+			pc.remove(i);
+			deleted[i] = true;
+		}
+		checkQueries(pc, deleted);
+
+		// Points deleted before being indexed are never returned:
+		pc.append(200);
+		deleted.resize(pc.pts.size(), false);
+		for (size_t i = 550; i < 600; i++)
+		{
+			pc.remove(i);
+			deleted[i] = true;
+		}
+		checkQueries(pc, deleted);
+
+		// A full update restores all points:
+		pc.removeFromStorage(10);
+		checkQueries(pc, std::vector<bool>(pc.pts.size(), false));
+	}
+}
+
+TEST(KDTreeCapable, concurrentQueriesOnFirstUse)
+{
+	for (const bool incremental : {false, true})
+	{
+		getRandomGenerator().randomize(5678);
+		TestPointCloud pc;
+		pc.kdtree_search_params.incremental = incremental;
+		pc.append(20000);
+
+		std::vector<TPoint3Df> queries;
+		for (int q = 0; q < 200; q++)
+			queries.emplace_back(
+				static_cast<float>(q % 20) - 10.f,
+				static_cast<float>(q / 20) - 5.f, 0.5f);
+
+		// All threads query the index before it is built:
+		const size_t nThreads = 4;
+		std::vector<std::vector<size_t>> results(nThreads);
+		std::vector<std::thread> threads;
+		for (size_t t = 0; t < nThreads; t++)
+			threads.emplace_back([&, t]() {
+				for (const auto& q : queries)
+				{
+					float x, y, z, distSqr;
+					results[t].push_back(pc.kdTreeClosestPoint3D(
+						q.x, q.y, q.z, x, y, z, distSqr));
+				}
+			});
+		for (auto& th : threads) th.join();
+
+		for (size_t i = 0; i < queries.size(); i++)
+		{
+			const float query[3] = {queries[i].x, queries[i].y, queries[i].z};
+			float minDist = std::numeric_limits<float>::max();
+			for (size_t j = 0; j < pc.pts.size(); j++)
+				mrpt::keep_min(minDist, pc.kdtree_distance(query, j, 3));
+			for (size_t t = 0; t < nThreads; t++)
+			{
+				ASSERT_EQ(results[t].size(), queries.size());
+				EXPECT_FLOAT_EQ(
+					pc.kdtree_distance(query, results[t][i], 3), minDist);
+			}
+		}
+	}
+}
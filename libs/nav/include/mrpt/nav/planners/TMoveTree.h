@@ -10,9 +10,16 @@
 #pragma once
 
 #include <mrpt/containers/traits_map.h>
+#include <mrpt/core/bits_math.h>
 #include <mrpt/graphs/CDirectedTree.h>
 #include <mrpt/math/wrap2pi.h>
 #include <mrpt/poses/CPose2D.h>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <set>
+#include <unordered_map>
+#include <vector>
 
 #include <mrpt/nav/tpspace/CParameterizedTrajectoryGenerator.h>
 
@@ -79,7 +86,18 @@ class TMoveTree : public mrpt::graphs::CDirectedTree<EDGE_TYPE>
 	/** A topological path up-tree */
 	using path_t = std::list<node_t>;
 
-	/** Finds the nearest node to a given pose, using the given metric */
+	/** Finds the nearest node to a given pose, using the given metric.
+	 * Nodes are searched in a grid index over their (x,y) coordinates,
+	 * visiting cells in rings of increasing distance around the query, until
+	 * `distanceMetricEvaluator.cannotBeNearerThan()` tells us that no node in
+	 * the remaining rings can be nearer than the best one found so far.
+	 * Hence, the cost of each query depends on the node density around the
+	 * query, not on the tree size. Ties are resolved in favor of the node
+	 * with the lowest ID.
+	 * \return INVALID_NODEID if the metric finds no reachable node (that
+	 * is, all distances are std::numeric_limits<double>::max()).
+	 * \sa setSpatialIndexCellSize
+	 */
 	template <class NODE_TYPE_FOR_METRIC>
 	mrpt::graphs::TNodeID getNearestNode(
 		const NODE_TYPE_FOR_METRIC& query_pt,
@@ -90,21 +108,77 @@ class TMoveTree : public mrpt::graphs::CDirectedTree<EDGE_TYPE>
 		ASSERT_(!m_nodes.empty());
 		double min_d = std::numeric_limits<double>::max();
 		auto min_id = INVALID_NODEID;
-		for (auto it = m_nodes.begin(); it != m_nodes.end(); ++it)
-		{
+		const NODE_TYPE_FOR_METRIC ptTo(query_pt.state);
+
+		auto checkNode = [&](const mrpt::graphs::TNodeID id,
+							 const node_t& node) {
 			if (ignored_nodes &&
-				ignored_nodes->find(it->first) != ignored_nodes->end())
-				continue;  // ignore it
-			const NODE_TYPE_FOR_METRIC ptTo(query_pt.state);
-			const NODE_TYPE_FOR_METRIC ptFrom(it->second.state);
+				ignored_nodes->find(id) != ignored_nodes->end())
+				return;  // ignore it
+			const NODE_TYPE_FOR_METRIC ptFrom(node.state);
 			if (distanceMetricEvaluator.cannotBeNearerThan(ptFrom, ptTo, min_d))
-				continue;  // Skip the more expensive calculation of exact
+				return;  // Skip the more expensive calculation of exact
 			// distance
-			double d = distanceMetricEvaluator.distance(ptFrom, ptTo);
-			if (d < min_d)
+			const double d = distanceMetricEvaluator.distance(ptFrom, ptTo);
+			// Unreachable nodes (max. distance) are never returned:
+			if (d == std::numeric_limits<double>::max()) return;
+			if (d < min_d || (d == min_d && id < min_id))
 			{
 				min_d = d;
-				min_id = it->first;
+				min_id = id;
+			}
+		};
+
+		const int qx = cellIndex(query_pt.state.x);
+		const int qy = cellIndex(query_pt.state.y);
+		// Number of rings of cells around the query covering all nodes:
+		const int maxR = std::max(
+			std::max(std::abs(qx - m_gridMinX), std::abs(qx - m_gridMaxX)),
+			std::max(std::abs(qy - m_gridMinY), std::abs(qy - m_gridMaxY)));
+
+		if (mrpt::square(2.0 * maxR + 1) > 4.0 * m_nodes.size())
+		{
+			// Query far away from a small tree: a linear scan is cheaper than
+			// visiting the (mostly empty) cells in between.
+			for (const auto& n : m_nodes) checkNode(n.first, n.second);
+		}
+		else
+		{
+			auto checkCell = [&](const int cx, const int cy) {
+				auto itCell = m_grid.find(cellKey(cx, cy));
+				if (itCell == m_grid.end()) return;
+				for (const auto id : itCell->second)
+					checkNode(id, m_nodes.find(id)->second);
+			};
+
+			for (int r = 0; r <= maxR; r++)
+			{
+				// All nodes in this ring (and beyond) are at a distance of at
+				// least (r-1)*cellSize from the query, in either x or y:
+				if (r >= 2 && min_id != INVALID_NODEID)
+				{
+					auto bound = query_pt.state;
+					bound.x += (r - 1) * m_gridCellSize;
+					if (distanceMetricEvaluator.cannotBeNearerThan(
+							NODE_TYPE_FOR_METRIC(bound), ptTo, min_d))
+						break;
+				}
+				const int x0 = std::max(qx - r, m_gridMinX),
+						  x1 = std::min(qx + r, m_gridMaxX);
+				const int y0 = std::max(qy - r + 1, m_gridMinY),
+						  y1 = std::min(qy + r - 1, m_gridMaxY);
+				// Top and bottom rows of the ring:
+				for (int cx = x0; cx <= x1; cx++)
+				{
+					checkCell(cx, qy - r);
+					if (r > 0) checkCell(cx, qy + r);
+				}
+				// Left and right columns (without corners):
+				for (int cy = y0; cy <= y1; cy++)
+				{
+					checkCell(qx - r, cy);
+					checkCell(qx + r, cy);
+				}
 			}
 		}
 		if (out_distance) *out_distance = min_d;
@@ -126,6 +200,7 @@ class TMoveTree : public mrpt::graphs::CDirectedTree<EDGE_TYPE>
 		m_nodes[new_child_id] = node_t(
 			new_child_id, parent_id, &edges_of_parent.back().data,
 			new_child_node_data);
+		insertIntoGrid(new_child_id, new_child_node_data);
 	}
 
 	/** Insert a node without edges (should be used only for a tree root node)
@@ -134,8 +209,25 @@ class TMoveTree : public mrpt::graphs::CDirectedTree<EDGE_TYPE>
 		const mrpt::graphs::TNodeID node_id, const NODE_TYPE_DATA& node_data)
 	{
 		m_nodes[node_id] = node_t(node_id, INVALID_NODEID, nullptr, node_data);
+		insertIntoGrid(node_id, node_data);
 	}
 
+	/** Changes the size of the cells of the grid used to speed up
+	 * getNearestNode() (Default: 1.0). For best performance, it should be
+	 * in the order of the distance between nodes and their nearest
+	 * neighbors. Existing nodes are re-indexed.
+	 * \note (New in MRPT 2.1.0) */
+	void setSpatialIndexCellSize(double cellSize)
+	{
+		ASSERT_GT_(cellSize, 0.0);
+		m_gridCellSize = cellSize;
+		m_grid.clear();
+		m_gridMinX = m_gridMinY = std::numeric_limits<int>::max();
+		m_gridMaxX = m_gridMaxY = std::numeric_limits<int>::min();
+		for (const auto& n : m_nodes) insertIntoGrid(n.first, n.second);
+	}
+	double getSpatialIndexCellSize() const { return m_gridCellSize; }
+
 	mrpt::graphs::TNodeID getNextFreeNodeID() const { return m_nodes.size(); }
 	const node_map_t& getAllNodes() const { return m_nodes; }
 	/** Builds the path (sequence of nodes, with info about next edge) up-tree
@@ -176,6 +268,38 @@ class TMoveTree : public mrpt::graphs::CDirectedTree<EDGE_TYPE>
 	/** Info per node */
 	node_map_t m_nodes;
 
+	/** @name Grid index of node IDs by (x,y) coordinates
+		@{ */
+	double m_gridCellSize{1.0};
+	std::unordered_map<uint64_t, std::vector<mrpt::graphs::TNodeID>> m_grid;
+	/** Bounding box of non-empty cells */
+	int m_gridMinX{std::numeric_limits<int>::max()};
+	int m_gridMaxX{std::numeric_limits<int>::min()};
+	int m_gridMinY{std::numeric_limits<int>::max()};
+	int m_gridMaxY{std::numeric_limits<int>::min()};
+
+	int cellIndex(double coord) const
+	{
+		return static_cast<int>(std::floor(coord / m_gridCellSize));
+	}
+	static uint64_t cellKey(int cx, int cy)
+	{
+		return (static_cast<uint64_t>(static_cast<uint32_t>(cx)) << 32) |
+			static_cast<uint32_t>(cy);
+	}
+	void insertIntoGrid(
+		const mrpt::graphs::TNodeID id, const NODE_TYPE_DATA& node_data)
+	{
+		const int cx = cellIndex(node_data.state.x);
+		const int cy = cellIndex(node_data.state.y);
+		m_grid[cellKey(cx, cy)].push_back(id);
+		mrpt::keep_min(m_gridMinX, cx);
+		mrpt::keep_max(m_gridMaxX, cx);
+		mrpt::keep_min(m_gridMinY, cy);
+		mrpt::keep_max(m_gridMaxY, cy);
+	}
+	/** @} */
+
 };  // end TMoveTree
 
 /** An edge for the move tree used for planning in SE2 and TP-space */
@@ -225,8 +349,9 @@ struct PoseDistanceMetric<TNodeSE2>
 	bool cannotBeNearerThan(
 		const TNodeSE2& a, const TNodeSE2& b, const double d) const
 	{
-		if (std::abs(a.state.x - b.state.x) > d) return true;
-		if (std::abs(a.state.y - b.state.y) > d) return true;
+		// Note that distance() returns squared distances:
+		if (mrpt::square(a.state.x - b.state.x) > d) return true;
+		if (mrpt::square(a.state.y - b.state.y) > d) return true;
 		return false;
 	}
 
@@ -263,6 +263,8 @@ class CAbstractNavigator : public mrpt::system::COutputLogger
 	{
 		return m_timlog_delays;
 	}
+	/** \overload, e.g. to clear() it */
+	mrpt::system::CTimeLogger& getDelaysTimeLogger() { return m_timlog_delays; }
 
 	/** Publicly available time profiling object. Default: disabled */
 	mrpt::system::CTimeLogger m_navProfiler{false,
@@ -221,6 +221,15 @@ class CAbstractPTGBasedReactive : public CWaypointsNavigator
 		/** Max dist [meters] to use time-based path prediction for NOP
 		 * evaluation. */
 		double max_dist_for_timebased_path_prediction{2.0};
+		/** Number of threads to evaluate PTGs in parallel (transformation of
+		 * obstacles to TP-Space, holonomic method and scores of each
+		 * candidate). 1 (default) evaluates them sequentially, 0 uses all CPU
+		 * cores. Per-PTG timings are stored in
+		 * CLogFileRecord::TInfoPerPTG::timeForPTGEvaluation. If evaluated in
+		 * parallel, the time of the inner steps of each PTG evaluation is not
+		 * recorded in the time loggers, only the total time of each one.
+		 * \note (New in MRPT 2.1.0) */
+		unsigned int ptg_eval_num_threads{1};
 
 		void loadFromConfigFile(
 			const mrpt::config::CConfigFileBase& c,
@@ -250,6 +259,8 @@ class CAbstractPTGBasedReactive : public CWaypointsNavigator
 	{
 		return m_timelogger;
 	}
+	/** \overload, e.g. to clear() it */
+	mrpt::system::CTimeLogger& getTimeLogger() { return m_timelogger; }
 
 	/** Returns the number of different PTGs that have been setup */
 	virtual size_t getPTG_count() const = 0;
@@ -314,7 +325,7 @@ class CAbstractPTGBasedReactive : public CWaypointsNavigator
 
 	/** @name Variables for CReactiveNavigationSystem::performNavigationStep
 		@{ */
-	mrpt::system::CTicTac totalExecutionTime, executionTime, tictac;
+	mrpt::system::CTicTac totalExecutionTime, executionTime;
 	mrpt::math::LowPassFilter_IIR1 meanExecutionTime{0.7, 1};
 	mrpt::math::LowPassFilter_IIR1 meanTotalExecutionTime{0.7, 1};
 	/** Runtime estimation of execution period of the method. */
@@ -50,6 +50,13 @@ class CLogFileRecord : public mrpt::serialization::CSerializable
 		mrpt::math::TPoint2D TP_Robot;
 		/** Time, in seconds. */
 		double timeForTPObsTransformation, timeForHolonomicMethod;
+		/** Time, in seconds, to evaluate the score of the candidate motion
+		 * \note (New in MRPT 2.1.0) */
+		double timeForMoveCandidateScores{0};
+		/** Total time, in seconds, to evaluate this PTG (obstacles
+		 * transformation, holonomic method, scores and logging).
+		 * \note (New in MRPT 2.1.0) */
+		double timeForPTGEvaluation{0};
 		/** The results from the holonomic method. */
 		double desiredDirection, desiredSpeed;
 		/** Final score of this candidate */
@@ -77,6 +84,9 @@ class CLogFileRecord : public mrpt::serialization::CSerializable
 	/** Known values:
 	 *	- "executionTime": The total computation time, excluding sensing.
 	 *	- "estimatedExecutionPeriod": The estimated execution period.
+	 *	- "timeForPTGsEvaluation": Time to evaluate all PTGs (may be less
+	 * than the sum of TInfoPerPTG::timeForPTGEvaluation, if evaluated in
+	 * parallel).
 	 */
 	std::map<std::string, double> values;
 	/** Known values:
@@ -21,8 +21,6 @@ using namespace mrpt::system;
 using namespace mrpt::poses;
 using namespace std;
 
-MRPT_TODO("Optimize getNearestNode() with KD-tree!")
-
 PlannerRRT_SE2_TPS::PlannerRRT_SE2_TPS() = default;
 /** Load all params from a config file source */
 void PlannerRRT_SE2_TPS::loadConfig(
@@ -60,6 +58,8 @@ void PlannerRRT_SE2_TPS::solve(
 	if (result.move_tree.getAllNodes().empty())
 	{
 		result.move_tree.root = 0;
+		// New nodes are at most `maxLength` away from their parents:
+		result.move_tree.setSpatialIndexCellSize(params.maxLength);
 		result.move_tree.insertNode(
 			result.move_tree.root, TNodeSE2_TP(pi.start_pose));
 	}
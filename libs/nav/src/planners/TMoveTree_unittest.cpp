@@ -0,0 +1,118 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2020, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include <gtest/gtest.h>
+#include <mrpt/config/CConfigFileMemory.h>
+#include <mrpt/nav/planners/TMoveTree.h>
+#include <mrpt/nav/tpspace/CPTG_DiffDrive_C.h>
+#include <mrpt/random.h>
+#include <limits>
+#include <set>
+
+TEST(TMoveTree, getNearestNode)
+{
+	using namespace mrpt::nav;
+	using mrpt::graphs::TNodeID;
+	using mrpt::math::TPose2D;
+
+	auto& rnd = mrpt::random::getRandomGenerator();
+	rnd.randomize(1234);
+
+	TMoveTreeSE2_TP tree;
+	tree.setSpatialIndexCellSize(0.5);
+	tree.insertNode(0, TNodeSE2_TP(TPose2D(0, 0, 0)));
+	for (TNodeID id = 1; id < 2000; id++)
+	{
+		const TPose2D p(
+			rnd.drawUniform(-10.0, 10.0), rnd.drawUniform(-5.0, 5.0),
+			rnd.drawUniform(-M_PI, M_PI));
+		tree.insertNodeAndEdge(
+			id - 1, id, TNodeSE2_TP(p), TMoveEdgeSE2_TP(id - 1, p));
+	}
+	const std::set<TNodeID> ignored = {5, 10, 15};
+
+	// Compare against brute force search:
+	const PoseDistanceMetric<TNodeSE2> metric;
+	for (int i = 0; i < 500; i++)
+	{
+		// Include queries far from all nodes:
+		const double R = (i % 10) == 0 ? 100.0 : 12.0;
+		const TNodeSE2 q(TPose2D(
+			rnd.drawUniform(-R, R), rnd.drawUniform(-R, R),
+			rnd.drawUniform(-M_PI, M_PI)));
+		const bool useIgnored = (i % 2) == 0;
+
+		double bestD = std::numeric_limits<double>::max();
+		TNodeID bestId = INVALID_NODEID;
+		for (const auto& n : tree.getAllNodes())
+		{
+			if (useIgnored && ignored.count(n.first)) continue;
+			const double d = metric.distance(TNodeSE2(n.second.state), q);
+			if (d < bestD)
+			{
+				bestD = d;
+				bestId = n.first;
+			}
+		}
+
+		double d;
+		const TNodeID id = tree.getNearestNode(
+			q, metric, &d, useIgnored ? &ignored : nullptr);
+		EXPECT_EQ(id, bestId) << "query: " << q.state.asString();
+		EXPECT_DOUBLE_EQ(d, bestD);
+	}
+
+	// Re-indexing keeps the same results:
+	const TNodeSE2 q(TPose2D(1.0, 2.0, 0.5));
+	const TNodeID id = tree.getNearestNode(q, metric);
+	tree.setSpatialIndexCellSize(3.0);
+	EXPECT_EQ(tree.getNearestNode(q, metric), id);
+}
+
+TEST(TMoveTree, getNearestNodeUnreachable)
+{
+	using namespace mrpt::nav;
+	using mrpt::graphs::TNodeID;
+	using mrpt::math::TPose2D;
+
+	// Circular arcs, forward only, up to 3 meters:
+	mrpt::config::CConfigFileMemory cfg(
+		"[PTG]\n"
+		"resolution = 0.25\n"
+		"refDistance = 3.0\n"
+		"num_paths = 31\n"
+		"v_max_mps = 1.0\n"
+		"w_max_dps = 60\n"
+		"K = 1.0\n"
+		"shape_x0 = -0.2\nshape_y0 = 0.3\n"
+		"shape_x1 = 0.5\nshape_y1 = 0.3\n"
+		"shape_x2 = 0.5\nshape_y2 = -0.3\n"
+		"shape_x3 = -0.2\nshape_y3 = -0.3\n");
+	CPTG_DiffDrive_C ptg(cfg, "PTG");
+	ptg.initialize(std::string(), false /*verbose*/);
+	const PoseDistanceMetric<TNodeSE2_TP> metric(ptg);
+
+	TMoveTreeSE2_TP tree;
+	tree.insertNode(0, TNodeSE2_TP(TPose2D(0, 0, 0)));
+	for (TNodeID id = 1; id < 10; id++)
+	{
+		const TPose2D p(0.5 * id, 0, 0);
+		tree.insertNodeAndEdge(
+			id - 1, id, TNodeSE2_TP(p), TMoveEdgeSE2_TP(id - 1, p));
+	}
+
+	// Ahead of the last node: reachable
+	EXPECT_EQ(
+		tree.getNearestNode(TNodeSE2_TP(TPose2D(5.0, 0, 0)), metric), 9U);
+
+	// Straight behind all nodes: no forward arc can reach it
+	EXPECT_EQ(
+		tree.getNearestNode(TNodeSE2_TP(TPose2D(-5.0, 0, 0)), metric),
+		INVALID_NODEID);
+}
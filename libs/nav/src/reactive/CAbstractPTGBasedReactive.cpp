@@ -11,6 +11,7 @@
 
 #include <mrpt/containers/copy_container_typecasting.h>
 #include <mrpt/containers/printf_vector.h>
+#include <mrpt/core/WorkerThreadsPool.h>
 #include <mrpt/core/lock_helper.h>
 #include <mrpt/io/CFileGZOutputStream.h>
 #include <mrpt/io/CMemoryStream.h>
@@ -520,8 +521,7 @@ void CAbstractPTGBasedReactive::performNavigationStep()
 			nPTGs + 1);  // the last extra one is for the evaluation of "NOP
 		// motion command" choice.
 
-		for (size_t indexPTG = 0; indexPTG < nPTGs; indexPTG++)
-		{
+		auto evalPTG = [&](const size_t indexPTG, CLogFileRecord& logRec) {
 			mrpt::system::CTimeLoggerEntry tle2(
 				m_navProfiler,
 				"CAbstractPTGBasedReactive::performNavigationStep().eval_"
@@ -542,9 +542,80 @@ void CAbstractPTGBasedReactive::performNavigationStep()
 			ASSERT_(m_navigationParams);
 			build_movement_candidate(
 				ptg, indexPTG, relTargets, rel_pose_PTG_origin_wrt_sense, ipf,
-				cm, newLogRec, false /* this is a regular PTG reactive case */,
+				cm, logRec, false /* this is a regular PTG reactive case */,
 				*holoMethod, tim_start_iteration, *m_navigationParams);
-		}  // end for each PTG
+		};
+
+		CTicTac tictacPTGs;
+		const unsigned int nThreads = mrpt::WorkerThreadsPool::clampNumThreads(
+			params_abstract_ptg_navigator.ptg_eval_num_threads);
+		if (nThreads <= 1 || nPTGs <= 1)
+		{
+			for (size_t indexPTG = 0; indexPTG < nPTGs; indexPTG++)
+				evalPTG(indexPTG, newLogRec);
+		}
+		else
+		{
+			// Each PTG fills in its own log record, merged below in the same
+			// order than in the sequential evaluation:
+			std::vector<CLogFileRecord> ptgLogRecs(nPTGs);
+			for (size_t i = 0; i < nPTGs; i++)
+			{
+				ptgLogRecs[i].infoPerPTG.resize(nPTGs + 1);
+				std::swap(
+					ptgLogRecs[i].infoPerPTG[i], newLogRec.infoPerPTG[i]);
+			}
+
+			// CTimeLogger is not thread-safe: the profilers are disabled
+			// while PTGs are evaluated in worker threads, and the time of
+			// each PTG evaluation is registered afterwards, from this thread.
+			struct ProfilersDisabler
+			{
+				mrpt::system::CTimeLogger &tl, &prof;
+				const bool tlEnabled = tl.isEnabled(),
+						   profEnabled = prof.isEnabled();
+				ProfilersDisabler(
+					mrpt::system::CTimeLogger& tl_,
+					mrpt::system::CTimeLogger& prof_)
+					: tl(tl_), prof(prof_)
+				{
+					tl.disable();
+					prof.disable();
+				}
+				~ProfilersDisabler()
+				{
+					tl.enable(tlEnabled);
+					prof.enable(profEnabled);
+				}
+			};
+			std::vector<double> ptgEvalTimes(nPTGs);
+			{
+				ProfilersDisabler disabler(m_timelogger, m_navProfiler);
+				mrpt::WorkerThreadsPool::sharedPool().parallel_for(
+					0, nPTGs,
+					[&](size_t first, size_t last) {
+						for (size_t i = first; i < last; i++)
+						{
+							CTicTac tictacPTG;
+							evalPTG(i, ptgLogRecs[i]);
+							ptgEvalTimes[i] = tictacPTG.Tac();
+						}
+					},
+					(nPTGs + nThreads - 1) / nThreads);
+			}
+			for (size_t i = 0; i < nPTGs; i++)
+			{
+				m_navProfiler.registerUserMeasure(
+					"CAbstractPTGBasedReactive::performNavigationStep().eval_"
+					"regular_PTG",
+					ptgEvalTimes[i], true);
+				std::swap(
+					ptgLogRecs[i].infoPerPTG[i], newLogRec.infoPerPTG[i]);
+				for (const auto& m : ptgLogRecs[i].additional_debug_msgs)
+					newLogRec.additional_debug_msgs[m.first] = m.second;
+			}
+		}
+		newLogRec.values["timeForPTGsEvaluation"] = tictacPTGs.Tac();
 
 		// check for collision, which is reflected by ALL TP-Obstacles being
 		// zero:
@@ -1574,7 +1645,10 @@ void CAbstractPTGBasedReactive::build_movement_candidate(
 		}
 	}
 
-	double timeForTPObsTransformation = .0, timeForHolonomicMethod = .0;
+	// Local timers, since PTGs may be evaluated in parallel:
+	CTicTac tictac, tictacTotal;
+	double timeForTPObsTransformation = .0, timeForHolonomicMethod = .0,
+		   timeForMoveCandidateScores = .0;
 
 	// Normal PTG validity filter: check if target falls into the PTG domain:
 	bool any_TPTarget_is_valid = false;
@@ -1732,6 +1806,7 @@ void CAbstractPTGBasedReactive::build_movement_candidate(
 		{
 			CTimeLoggerEntry tle2(
 				m_timelogger, "navigationStep.calc_move_candidate_scores");
+			tictac.Tic();
 
 			calc_move_candidate_scores(
 				cm, ipf.TP_Obstacles, ipf.clearance, relTargets, ipf.targets,
@@ -1746,6 +1821,7 @@ void CAbstractPTGBasedReactive::build_movement_candidate(
 
 			//  SAVE LOG
 			newLogRec.infoPerPTG[idx_in_log_infoPerPTGs].evalFactors = cm.props;
+			timeForMoveCandidateScores = tictac.Tac();
 		}
 
 	}  // end "valid_TP"
@@ -1777,6 +1853,8 @@ void CAbstractPTGBasedReactive::build_movement_candidate(
 		ipp.desiredSpeed = cm.speed;
 		ipp.timeForTPObsTransformation = timeForTPObsTransformation;
 		ipp.timeForHolonomicMethod = timeForHolonomicMethod;
+		ipp.timeForMoveCandidateScores = timeForMoveCandidateScores;
+		ipp.timeForPTGEvaluation = tictacTotal.Tac();
 	}
 }
 
@@ -1800,6 +1878,7 @@ void CAbstractPTGBasedReactive::TAbstractPTGNavigatorParams::loadFromConfigFile(
 	MRPT_LOAD_CONFIG_VAR_CS(enable_obstacle_filtering, bool);
 	MRPT_LOAD_CONFIG_VAR_CS(evaluate_clearance, bool);
 	MRPT_LOAD_CONFIG_VAR_CS(max_dist_for_timebased_path_prediction, double);
+	MRPT_LOAD_CONFIG_VAR_CS(ptg_eval_num_threads, int);
 
 	MRPT_END
 }
@@ -1876,6 +1955,10 @@ void CAbstractPTGBasedReactive::TAbstractPTGNavigatorParams::saveToConfigFile(
 		max_dist_for_timebased_path_prediction,
 		"Max dist [meters] to use time-based path prediction for NOP "
 		"evaluation");
+	MRPT_SAVE_CONFIG_VAR_COMMENT(
+		ptg_eval_num_threads,
+		"Number of threads to evaluate PTGs in parallel (default=1: "
+		"sequential evaluation, 0: all CPU cores)");
 }
 
 CAbstractPTGBasedReactive::TAbstractPTGNavigatorParams::
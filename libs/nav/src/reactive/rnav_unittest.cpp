@@ -9,6 +9,7 @@
 
 #include <gtest/gtest.h>
 #include <mrpt/config/CConfigFile.h>
+#include <mrpt/core/WorkerThreadsPool.h>
 #include <mrpt/kinematics/CVehicleSimul_DiffDriven.h>
 #include <mrpt/maps/COccupancyGridMap2D.h>
 #include <mrpt/nav/reactive/CReactiveNavigationSystem.h>
@@ -18,13 +19,90 @@
 
 using mrpt::math::TPoint2D;
 
+namespace
+{
+// Creates a grid map with a synthetic test environment with a simple
+// obstacle:
+void createTestGrid(
+	mrpt::maps::COccupancyGridMap2D& grid, const TPoint2D& world_topleft,
+	const TPoint2D& world_rightbottom, const TPoint2D& block_obstacle_topleft,
+	const TPoint2D& block_obstacle_rightbottom)
+{
+	grid.setSize(
+		world_topleft.x, world_rightbottom.x, world_rightbottom.y,
+		world_topleft.y, 0.10f /*resolution*/);
+	grid.fill(0.9f);
+
+	// Create obstacle:
+	const int xi0 = grid.x2idx(block_obstacle_topleft.x),
+			  xi1 = grid.x2idx(block_obstacle_rightbottom.x);
+	const int yi0 = grid.y2idx(block_obstacle_rightbottom.y),
+			  yi1 = grid.y2idx(block_obstacle_topleft.y);
+
+	for (int xi = xi0; xi < xi1; xi++)
+	{
+		for (int yi = yi0; yi < yi1; yi++)
+		{
+			grid.setCell(xi, yi, 0);
+		}
+	}
+}
+
+struct MyDummyRobotIF
+	: public mrpt::nav::CRobot2NavInterfaceForSimulator_DiffDriven
+{
+	mrpt::maps::COccupancyGridMap2D& m_grid;
+
+	MyDummyRobotIF(
+		mrpt::kinematics::CVehicleSimul_DiffDriven& sim,
+		mrpt::maps::COccupancyGridMap2D& grid)
+		: CRobot2NavInterfaceForSimulator_DiffDriven(sim), m_grid(grid)
+	{
+		this->setMinLoggingLevel(
+			mrpt::system::LVL_ERROR);  // less verbose output for tests
+	}
+
+	void sendNavigationStartEvent() override {}
+	void sendNavigationEndEvent() override {}
+	bool senseObstacles(
+		mrpt::maps::CSimplePointsMap& obstacles,
+		mrpt::system::TTimeStamp& timestamp) override
+	{
+		obstacles.clear();
+		timestamp = mrpt::system::now();
+
+		mrpt::math::TPose2D curPose, odomPose;
+		std::string pose_frame_id;
+		mrpt::math::TTwist2D curVel;
+		mrpt::system::TTimeStamp pose_tim;
+		getCurrentPoseAndSpeeds(
+			curPose, curVel, pose_tim, odomPose, pose_frame_id);
+
+		mrpt::obs::CObservation2DRangeScan scan;
+		scan.aperture = mrpt::DEG2RAD(270.0);
+		scan.maxRange = 20.0;
+		scan.sensorPose.z(0.4);  // height of the lidar (important! it must
+		// intersect with the robot height)
+
+		m_grid.laserScanSimulator(
+			scan, mrpt::poses::CPose2D(curPose), 0.4f, 180);
+
+		obstacles.insertionOptions.minDistBetweenLaserPoints = .0;
+		obstacles.loadFromRangeScan(scan);
+
+		return true;
+	}
+};
+}  // namespace
+
 template <typename RNAVCLASS>
 void run_rnav_test(
 	const std::string& sFilename, const std::string& sHoloMethod,
 	const TPoint2D& nav_target, const TPoint2D& world_topleft,
 	const TPoint2D& world_rightbottom,
 	const TPoint2D& block_obstacle_topleft = TPoint2D(0, 0),
-	const TPoint2D& block_obstacle_rightbottom = TPoint2D(0, 0))
+	const TPoint2D& block_obstacle_rightbottom = TPoint2D(0, 0),
+	unsigned int ptg_eval_num_threads = 1)
 {
 	using namespace std;
 	using namespace mrpt;
@@ -43,76 +121,19 @@ void run_rnav_test(
 
 	mrpt::config::CConfigFile cfg(sFil);
 	cfg.write("CAbstractPTGBasedReactive", "holonomic_method", sHoloMethod);
+	cfg.write(
+		"CAbstractPTGBasedReactive", "ptg_eval_num_threads",
+		ptg_eval_num_threads);
+	// The 3D config file only enables one PTG by default. Use all of them, so
+	// there are several PTGs to evaluate in parallel:
+	if (ptg_eval_num_threads != 1)
+		cfg.write("CReactiveNavigationSystem3D", "PTG_COUNT", 3);
 	cfg.discardSavingChanges();
 
-	// Create a grid map with a synthetic test environment with a simple
-	// obstacle:
 	mrpt::maps::COccupancyGridMap2D grid;
-	grid.setSize(
-		world_topleft.x, world_rightbottom.x, world_rightbottom.y,
-		world_topleft.y, 0.10f /*resolution*/);
-	grid.fill(0.9f);
-
-	// Create obstacle:
-	{
-		const int xi0 = grid.x2idx(block_obstacle_topleft.x),
-				  xi1 = grid.x2idx(block_obstacle_rightbottom.x);
-		const int yi0 = grid.y2idx(block_obstacle_rightbottom.y),
-				  yi1 = grid.y2idx(block_obstacle_topleft.y);
-
-		for (int xi = xi0; xi < xi1; xi++)
-		{
-			for (int yi = yi0; yi < yi1; yi++)
-			{
-				grid.setCell(xi, yi, 0);
-			}
-		}
-	}
-
-	struct MyDummyRobotIF : public CRobot2NavInterfaceForSimulator_DiffDriven
-	{
-		mrpt::maps::COccupancyGridMap2D& m_grid;
-
-		MyDummyRobotIF(
-			mrpt::kinematics::CVehicleSimul_DiffDriven& sim,
-			mrpt::maps::COccupancyGridMap2D& grid)
-			: CRobot2NavInterfaceForSimulator_DiffDriven(sim), m_grid(grid)
-		{
-			this->setMinLoggingLevel(
-				mrpt::system::LVL_ERROR);  // less verbose output for tests
-		}
-
-		void sendNavigationStartEvent() override {}
-		void sendNavigationEndEvent() override {}
-		bool senseObstacles(
-			mrpt::maps::CSimplePointsMap& obstacles,
-			mrpt::system::TTimeStamp& timestamp) override
-		{
-			obstacles.clear();
-			timestamp = mrpt::system::now();
-
-			mrpt::math::TPose2D curPose, odomPose;
-			std::string pose_frame_id;
-			mrpt::math::TTwist2D curVel;
-			mrpt::system::TTimeStamp pose_tim;
-			getCurrentPoseAndSpeeds(
-				curPose, curVel, pose_tim, odomPose, pose_frame_id);
-
-			mrpt::obs::CObservation2DRangeScan scan;
-			scan.aperture = mrpt::DEG2RAD(270.0);
-			scan.maxRange = 20.0;
-			scan.sensorPose.z(0.4);  // height of the lidar (important! it must
-			// intersect with the robot height)
-
-			m_grid.laserScanSimulator(
-				scan, mrpt::poses::CPose2D(curPose), 0.4f, 180);
-
-			obstacles.insertionOptions.minDistBetweenLaserPoints = .0;
-			obstacles.loadFromRangeScan(scan);
-
-			return true;
-		}
-	};
+	createTestGrid(
+		grid, world_topleft, world_rightbottom, block_obstacle_topleft,
+		block_obstacle_rightbottom);
 
 	mrpt::kinematics::CVehicleSimul_DiffDriven robot_simul;
 	MyDummyRobotIF robot2nav_if(robot_simul, grid);
@@ -168,10 +189,8 @@ void run_rnav_test(
 		(TPoint2D(robot_simul.getCurrentGTPose()) - nav_target).norm(), 0.4);
 	EXPECT_TRUE(rnav.getCurrentState() == CAbstractNavigator::IDLE);
 
-	const_cast<mrpt::system::CTimeLogger&>(rnav.getTimeLogger())
-		.clear(true);  // do not show timelog table to console
-	const_cast<mrpt::system::CTimeLogger&>(rnav.getDelaysTimeLogger())
-		.clear(true);
+	rnav.getTimeLogger().clear(true);  // do not show timelog table to console
+	rnav.getDelaysTimeLogger().clear(true);
 }
 
 const TPoint2D no_obs_trg(2.0, 0.4), no_obs_topleft(-10, 10),
@@ -254,3 +273,117 @@ TEST(CReactiveNavigationSystem3D, with_obstacle_nav_FullEval)
 		"reactive3d_config.ini", "CHolonomicFullEval", with_obs_trg,
 		with_obs_topleft, with_obs_bottomright, obs_tl, obs_br);
 }
+
+// The parallel tests emulate 3 cores, so PTGs are evaluated in parallel even
+// in single-core machines:
+TEST(CReactiveNavigationSystem, with_obstacle_nav_FullEval_parallel)
+{
+	const auto formerNumCores = mrpt::WorkerThreadsPool::overrideNumCores(3);
+	run_rnav_test<mrpt::nav::CReactiveNavigationSystem>(
+		"reactive2d_config.ini", "CHolonomicFullEval", with_obs_trg,
+		with_obs_topleft, with_obs_bottomright, obs_tl, obs_br, 3);
+	mrpt::WorkerThreadsPool::overrideNumCores(formerNumCores);
+}
+TEST(CReactiveNavigationSystem3D, with_obstacle_nav_ND_parallel)
+{
+	const auto formerNumCores = mrpt::WorkerThreadsPool::overrideNumCores(3);
+	run_rnav_test<mrpt::nav::CReactiveNavigationSystem3D>(
+		"reactive3d_config.ini", "CHolonomicND", with_obs_trg, with_obs_topleft,
+		with_obs_bottomright, obs_tl, obs_br, 3);
+	mrpt::WorkerThreadsPool::overrideNumCores(formerNumCores);
+}
+
+// Runs a few navigation steps, without moving the robot, and returns the
+// log records:
+template <typename RNAVCLASS>
+std::vector<mrpt::nav::CLogFileRecord> collect_rnav_logs(
+	const std::string& sFilename, const std::string& sHoloMethod,
+	unsigned int ptg_eval_num_threads)
+{
+	const std::string sFil = mrpt::system::find_mrpt_shared_dir() +
+		std::string("config_files/navigation-ptgs/") + sFilename;
+	if (!mrpt::system::fileExists(sFil)) return {};
+
+	mrpt::config::CConfigFile cfg(sFil);
+	cfg.write("CAbstractPTGBasedReactive", "holonomic_method", sHoloMethod);
+	cfg.write(
+		"CAbstractPTGBasedReactive", "ptg_eval_num_threads",
+		ptg_eval_num_threads);
+	// The 3D config file only enables one PTG by default. Use all of them, so
+	// there are several PTGs to evaluate in parallel:
+	cfg.write("CReactiveNavigationSystem3D", "PTG_COUNT", 3);
+	cfg.discardSavingChanges();
+
+	mrpt::maps::COccupancyGridMap2D grid;
+	createTestGrid(grid, with_obs_topleft, with_obs_bottomright, obs_tl, obs_br);
+
+	mrpt::kinematics::CVehicleSimul_DiffDriven robot_simul;
+	MyDummyRobotIF robot2nav_if(robot_simul, grid);
+	auto rnav = std::make_unique<RNAVCLASS>(robot2nav_if, false);
+	rnav->enableTimeLog(true);
+	rnav->setMinLoggingLevel(mrpt::system::LVL_ERROR);
+	rnav->enableKeepLogRecords();
+	rnav->loadConfigFile(cfg);
+	rnav->initialize();
+
+	mrpt::nav::CAbstractNavigator::TNavigationParams np;
+	np.target.target_coords = mrpt::math::TPose2D(with_obs_trg);
+	np.target.targetAllowedDistance = 0.35f;
+	rnav->navigate(&np);
+
+	std::vector<mrpt::nav::CLogFileRecord> logs(5);
+	for (auto& log : logs)
+	{
+		rnav->navigationStep();
+		rnav->getLastLogRecord(log);
+	}
+
+	rnav->getTimeLogger().clear(true);
+	rnav->getDelaysTimeLogger().clear(true);
+	return logs;
+}
+
+template <typename RNAVCLASS>
+void test_parallel_navlogs(
+	const std::string& sFilename, const std::string& sHoloMethod)
+{
+	const auto formerNumCores = mrpt::WorkerThreadsPool::overrideNumCores(3);
+	const auto seqLogs =
+		collect_rnav_logs<RNAVCLASS>(sFilename, sHoloMethod, 1);
+	const auto parLogs =
+		collect_rnav_logs<RNAVCLASS>(sFilename, sHoloMethod, 3);
+	mrpt::WorkerThreadsPool::overrideNumCores(formerNumCores);
+	ASSERT_EQ(seqLogs.size(), parLogs.size());
+
+	for (size_t step = 0; step < seqLogs.size(); step++)
+	{
+		const auto &s = seqLogs[step], &p = parLogs[step];
+		EXPECT_GT(s.nPTGs, 0U);
+		EXPECT_EQ(s.nPTGs, p.nPTGs);
+		ASSERT_EQ(s.infoPerPTG.size(), p.infoPerPTG.size());
+		// Regular PTGs (the last entry is the "NOP motion" evaluation, which
+		// depends on the wall clock):
+		for (size_t i = 0; i < s.nPTGs; i++)
+		{
+			const auto &si = s.infoPerPTG[i], &pi = p.infoPerPTG[i];
+			EXPECT_EQ(si.PTG_desc, pi.PTG_desc);
+			EXPECT_EQ(si.TP_Obstacles, pi.TP_Obstacles);
+			EXPECT_EQ(si.TP_Targets, pi.TP_Targets);
+			EXPECT_EQ(si.desiredDirection, pi.desiredDirection);
+			EXPECT_EQ(si.desiredSpeed, pi.desiredSpeed);
+			EXPECT_EQ(si.evaluation, pi.evaluation);
+			EXPECT_EQ(si.evalFactors, pi.evalFactors);
+		}
+	}
+}
+
+TEST(CReactiveNavigationSystem, parallel_PTG_eval_same_navlog)
+{
+	test_parallel_navlogs<mrpt::nav::CReactiveNavigationSystem>(
+		"reactive2d_config.ini", "CHolonomicFullEval");
+}
+TEST(CReactiveNavigationSystem3D, parallel_PTG_eval_same_navlog)
+{
+	test_parallel_navlogs<mrpt::nav::CReactiveNavigationSystem3D>(
+		"reactive3d_config.ini", "CHolonomicND");
+}
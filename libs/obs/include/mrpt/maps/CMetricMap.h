@@ -11,6 +11,7 @@
 #include <mrpt/maps/CMetricMapEvents.h>
 #include <mrpt/maps/TMetricMapInitializer.h>
 #include <mrpt/maps/metric_map_types.h>
+#include <mrpt/math/TPoint3D.h>
 #include <mrpt/math/math_frwds.h>
 #include <mrpt/obs/CObservation.h>
 #include <mrpt/obs/obs_frwds.h>
@@ -283,6 +284,26 @@ class CMetricMap : public mrpt::serialization::CSerializable,
 	{ /* Default implementation: do nothing. */
 	}
 
+	/** Prepares the map for computeObservationLikelihood() to be called from
+	 * several threads at once, e.g. by building now, from the calling thread,
+	 * the internal caches that would be otherwise lazily built during the
+	 * likelihood evaluation. The observations to evaluate are those in `sf`,
+	 * taken from robot poses within the box `[posesMin, posesMax]`. Returns
+	 * false if this map (with its current options) does not support
+	 * concurrent likelihood evaluations, which is the default
+	 * implementation. The map must not be modified until all those
+	 * concurrent evaluations are done. Used by particle filters with the
+	 * `parallelProcessing` option, see mrpt::bayes::CParticleFilter.
+	 * \note (New in MRPT 2.1.0)
+	 */
+	virtual bool prepareForConcurrentLikelihood(
+		[[maybe_unused]] const mrpt::obs::CSensoryFrame& sf,
+		[[maybe_unused]] const mrpt::math::TPoint3D& posesMin,
+		[[maybe_unused]] const mrpt::math::TPoint3D& posesMax)
+	{
+		return false;
+	}
+
 	/** Returns the square distance from the 2D point (x0,y0) to the closest
 	 * correspondence in the map. */
 	virtual float squareDistanceToClosestCorrespondence(
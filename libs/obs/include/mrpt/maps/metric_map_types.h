@@ -40,6 +40,11 @@ struct TMatchingParams
 	/** The point used to calculate angular distances: e.g. the coordinates of
 	 * the sensor for a 2D laser scanner. */
 	mrpt::math::TPoint3D angularDistPivotPoint{0, 0, 0};
+	/** (Default=1) Number of threads for the nearest-neighbor search of
+	 * correspondences, in those maps supporting it (e.g. point maps). 0 means
+	 * as many threads as hardware cores. The result does not depend on this
+	 * value. \note (New in MRPT 2.1.0) */
+	unsigned int numThreads{1};
 
 	/** Ctor: default values */
 	TMatchingParams() = default;
@@ -16,6 +16,15 @@
 #include <mrpt/obs/TRangeImageFilter.h>
 #include <mrpt/opengl/pointcloud_adapters.h>
 #include <Eigen/Dense>  // block<>()
+#include <algorithm>
+#include <array>
+#include <functional>
+
+namespace mrpt::opengl
+{
+class CPointCloud;
+class CPointCloudColoured;
+}  // namespace mrpt::opengl
 
 namespace mrpt::obs::detail
 {
@@ -30,20 +39,76 @@ void do_project_3d_pointcloud(
 	const mrpt::obs::TRangeImageFilterParams& fp, bool MAKE_ORGANIZED,
 	const int DECIM);
 template <class POINTMAP>
-void do_project_3d_pointcloud_SSE2(
+void do_project_3d_pointcloud_SIMD(
 	const int H, const int W, const float* kxs, const float* kys,
 	const float* kzs, mrpt::math::CMatrix_u16& rangeImage,
 	const float rangeUnits, mrpt::opengl::PointCloudAdapter<POINTMAP>& pca,
 	std::vector<uint16_t>& idxs_x, std::vector<uint16_t>& idxs_y,
-	const mrpt::obs::TRangeImageFilterParams& fp, bool MAKE_ORGANIZED);
+	const mrpt::obs::TRangeImageFilterParams& fp, bool MAKE_ORGANIZED,
+	const int DECIM, const float* T, unsigned int numThreads);
+
+/** Input to unprojectRangeImage() */
+struct unproject_input_t
+{
+	int H = 0, W = 0, DECIM = 1;
+	const float *kxs = nullptr, *kys = nullptr, *kzs = nullptr;
+	mrpt::math::CMatrix_u16* rangeImage = nullptr;
+	float rangeUnits = 1e-3f;
+	mrpt::obs::TRangeImageFilterParams fp;
+	/** If true, points are transformed with the 3x4 row-major matrix `T` */
+	bool applyTransform = false;
+	std::array<float, 12> T;
+	/** If true, output indices are those of an organized cloud */
+	bool organized = false;
+};
+
+/** The valid points of one (decimated) row of the range image */
+struct unproject_row_t
+{
+	/** Index of the (decimated) row */
+	int row = 0;
+	/** Index of the first point in the output point cloud: that of the first
+	 * point of the row for organized clouds, or the number of valid points
+	 * in all previous rows otherwise. */
+	size_t outIdx = 0;
+	/** Number of valid points */
+	size_t count = 0;
+	const float *xs = nullptr, *ys = nullptr, *zs = nullptr;
+	/** Range image pixel coordinates of each point, as in
+	 * CObservation3DRangeScan::points3D_idxs_x and points3D_idxs_y */
+	const uint16_t *idxs_x = nullptr, *idxs_y = nullptr;
+};
+
+/** Filters and unprojects a range image with the fastest available SIMD
+ * kernels, splitting rows among `numThreads` threads (0: all cores).
+ * `outputRow` is invoked once per row, possibly from several threads at
+ * once, but always for distinct output points. Returns the total number of
+ * output points. Used by do_project_3d_pointcloud_SIMD(). */
+size_t unprojectRangeImage(
+	const unproject_input_t& in, unsigned int numThreads,
+	const std::function<void(const unproject_row_t&)>& outputRow);
+
+/** Whether do_project_3d_pointcloud_SIMD() is to be used: with only one
+ * thread and without AVX2, the portable kernels are not faster than
+ * do_project_3d_pointcloud(). */
+inline bool use_SIMD_unprojection(
+	const mrpt::obs::T3DPointsProjectionParams& pp)
+{
+	return pp.USE_SSE2 &&
+		   (pp.numThreads != 1 ||
+			mrpt::cpu::supports(mrpt::cpu::feature::AVX2));
+}
 
+// `full_transform`, if provided, is applied to all points. Only used if
+// use_SIMD_unprojection() is true.
 template <typename POINTMAP>
 inline void range2XYZ_LUT(
 	mrpt::opengl::PointCloudAdapter<POINTMAP>& pca,
 	mrpt::obs::CObservation3DRangeScan& src_obs,
 	const mrpt::obs::T3DPointsProjectionParams& pp,
 	const mrpt::obs::TRangeImageFilterParams& fp, const int H, const int W,
-	const int DECIM, const bool use_rotated_LUT)
+	const int DECIM, const bool use_rotated_LUT,
+	const mrpt::math::CMatrixDouble44* full_transform = nullptr)
 {
 	const size_t WH = W * H;
 	const auto& lut = src_obs.get_unproj_lut();
@@ -75,20 +140,37 @@ inline void range2XYZ_LUT(
 		pp.layer.empty() ? &src_obs.rangeImage
 						 : &src_obs.rangeImageOtherLayers.at(pp.layer);
 
-#if MRPT_HAS_SSE2
-	// if image width is not 8*N, use standard method
-	if ((W & 0x07) == 0 && pp.USE_SSE2 && DECIM == 1 &&
-		mrpt::cpu::supports(mrpt::cpu::feature::SSE2))
-		do_project_3d_pointcloud_SSE2(
-			H, W, kxs, kys, kzs, *ri, src_obs.rangeUnits, pca,
-			src_obs.points3D_idxs_x, src_obs.points3D_idxs_y, fp,
-			pp.MAKE_ORGANIZED);
-	else
-#endif
-		do_project_3d_pointcloud(
+	if (use_SIMD_unprojection(pp))
+	{
+		// Sensor translation (if using the rotated LUT) or the full 6D
+		// transform, applied to each point by the SIMD kernels:
+		std::array<float, 12> T;
+		const bool applyTransform = use_rotated_LUT || full_transform;
+		if (use_rotated_LUT)
+		{
+			T = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0};
+			T[3] = static_cast<float>(src_obs.sensorPose.x());
+			T[7] = static_cast<float>(src_obs.sensorPose.y());
+			T[11] = static_cast<float>(src_obs.sensorPose.z());
+		}
+		else if (full_transform)
+		{
+			for (int r = 0; r < 3; r++)
+				for (int c = 0; c < 4; c++)
+					T[r * 4 + c] = static_cast<float>((*full_transform)(r, c));
+		}
+		do_project_3d_pointcloud_SIMD(
 			H, W, kxs, kys, kzs, *ri, src_obs.rangeUnits, pca,
 			src_obs.points3D_idxs_x, src_obs.points3D_idxs_y, fp,
-			pp.MAKE_ORGANIZED, DECIM);
+			pp.MAKE_ORGANIZED, DECIM, applyTransform ? T.data() : nullptr,
+			pp.numThreads);
+		return;
+	}
+
+	do_project_3d_pointcloud(
+		H, W, kxs, kys, kzs, *ri, src_obs.rangeUnits, pca,
+		src_obs.points3D_idxs_x, src_obs.points3D_idxs_y, fp, pp.MAKE_ORGANIZED,
+		DECIM);
 
 	// Do final traslation, if we were generating points in the vehicle frame:
 	if (use_rotated_LUT)
@@ -176,7 +258,32 @@ void unprojectInto(
 		pca.resize(WHd);
 		if (pp.MAKE_ORGANIZED) pca.setDimensions(Hd, Wd);
 	}
-	range2XYZ_LUT<POINTMAP>(pca, src_obs, pp, fp, H, W, DECIM, use_rotated_LUT);
+
+	// The 6D transformation of Stage 3 can be done along Stage 1 by the SIMD
+	// kernels, unless local coordinates are needed for the colors of Stage 2:
+	const bool need_transform =
+		!use_rotated_LUT &&
+		(pp.takeIntoAccountSensorPoseOnRobot || pp.robotPoseInTheWorld);
+	const bool fuse_transform = need_transform && use_SIMD_unprojection(pp) &&
+								(!pca.HAS_RGB || !src_obs.hasIntensityImage);
+	mrpt::math::CMatrixDouble44 HM;
+	if (need_transform)
+	{
+		mrpt::poses::CPose3D transf_to_apply;  // Either ROBOTPOSE or
+		// ROBOTPOSE(+)SENSORPOSE or
+		// SENSORPOSE
+		if (pp.takeIntoAccountSensorPoseOnRobot)
+			transf_to_apply = src_obs.sensorPose;
+		if (pp.robotPoseInTheWorld)
+			transf_to_apply.composeFrom(
+				*pp.robotPoseInTheWorld, mrpt::poses::CPose3D(transf_to_apply));
+		HM = transf_to_apply
+				 .getHomogeneousMatrixVal<mrpt::math::CMatrixDouble44>();
+	}
+
+	range2XYZ_LUT<POINTMAP>(
+		pca, src_obs, pp, fp, H, W, DECIM, use_rotated_LUT,
+		fuse_transform ? &HM : nullptr);
 
 	// -------------------------------------------------------------
 	// Stage 2/3: Project local points into RGB image to get colors
@@ -292,22 +399,9 @@ void unprojectInto(
 	// ------------------------------------------------------------
 	// Stage 3/3: Apply 6D transformations
 	// ------------------------------------------------------------
-	if (!use_rotated_LUT &&
-		(pp.takeIntoAccountSensorPoseOnRobot || pp.robotPoseInTheWorld))
+	if (need_transform && !fuse_transform)
 	{
-		mrpt::poses::CPose3D transf_to_apply;  // Either ROBOTPOSE or
-		// ROBOTPOSE(+)SENSORPOSE or
-		// SENSORPOSE
-		if (pp.takeIntoAccountSensorPoseOnRobot)
-			transf_to_apply = src_obs.sensorPose;
-		if (pp.robotPoseInTheWorld)
-			transf_to_apply.composeFrom(
-				*pp.robotPoseInTheWorld, mrpt::poses::CPose3D(transf_to_apply));
-
-		const auto HM =
-			transf_to_apply
-				.getHomogeneousMatrixVal<mrpt::math::CMatrixDouble44>()
-				.cast_float();
+		const auto HMf = HM.cast_float();
 		mrpt::math::CVectorFixedFloat<4> pt, pt_transf;
 		pt[3] = 1;
 
@@ -315,7 +409,7 @@ void unprojectInto(
 		for (size_t i = 0; i < nPts; i++)
 		{
 			pca.getPointXYZ(i, pt[0], pt[1], pt[2]);
-			pt_transf = HM * pt;
+			pt_transf = HMf * pt;
 			pca.setPointXYZ(i, pt_transf[0], pt_transf[1], pt_transf[2]);
 		}
 	}
@@ -402,151 +496,111 @@ inline void do_project_3d_pointcloud(
 	idxs_y.resize(idx);
 }
 
-// Auxiliary functions which implement (un)projection of 3D point clouds:
+/** Sets the points of do_project_3d_pointcloud_SIMD() from its worker
+ * threads. Adapters whose setPointXYZ() also updates state shared by all
+ * points (e.g. bounding boxes) only write the coordinates here, and are
+ * marked as modified by the final `pca.resize()`. */
+template <class POINTMAP>
+struct concurrent_point_writer
+{
+	template <class PCA>
+	static inline void set(PCA& pca, size_t idx, float x, float y, float z)
+	{
+		pca.setPointXYZ(idx, x, y, z);
+	}
+	template <class PCA>
+	static inline void setInvalid(PCA& pca, size_t idx)
+	{
+		pca.setInvalidPoint(idx);
+	}
+};
+template <class POINTMAP>
+struct concurrent_point_writer_opengl
+{
+	template <class PCA>
+	static inline void set(PCA& pca, size_t idx, float x, float y, float z)
+	{
+		pca.setPointXYZ_concurrent(idx, x, y, z);
+	}
+	template <class PCA>
+	static inline void setInvalid(PCA& pca, size_t idx)
+	{
+		pca.setPointXYZ_concurrent(idx, 0, 0, 0);
+	}
+};
+template <>
+struct concurrent_point_writer<mrpt::opengl::CPointCloud>
+	: concurrent_point_writer_opengl<mrpt::opengl::CPointCloud>
+{
+};
+template <>
+struct concurrent_point_writer<mrpt::opengl::CPointCloudColoured>
+	: concurrent_point_writer_opengl<mrpt::opengl::CPointCloudColoured>
+{
+};
+
+// SIMD and multi-threaded version of do_project_3d_pointcloud(), which also
+// applies the optional 3x4 transformation `T` to the points:
 template <class POINTMAP>
-inline void do_project_3d_pointcloud_SSE2(
+inline void do_project_3d_pointcloud_SIMD(
 	const int H, const int W, const float* kxs, const float* kys,
 	const float* kzs, mrpt::math::CMatrix_u16& rangeImage,
 	const float rangeUnits, mrpt::opengl::PointCloudAdapter<POINTMAP>& pca,
 	std::vector<uint16_t>& idxs_x, std::vector<uint16_t>& idxs_y,
-	const mrpt::obs::TRangeImageFilterParams& fp, bool MAKE_ORGANIZED)
+	const mrpt::obs::TRangeImageFilterParams& fp, bool MAKE_ORGANIZED,
+	const int DECIM, const float* T, unsigned int numThreads)
 {
-#if MRPT_HAS_SSE2
-	// Preconditions: minRangeMask() has the right size
-	// Use optimized version:
-	const int W_4 = W >> 2;  // /=4 , since we process 4 values at a time.
-	size_t idx = 0;
-	alignas(MRPT_MAX_STATIC_ALIGN_BYTES) float xs[4], ys[4], zs[4];
-	const __m128 D_zeros = _mm_set_ps(.0f, .0f, .0f, .0f);
-	const __m128 xormask =
-		(fp.rangeCheckBetween) ? _mm_cmpneq_ps(D_zeros, D_zeros)
-							   :  // want points BETWEEN min and max to be valid
-			_mm_cmpeq_ps(
-				D_zeros,
-				D_zeros);  // want points OUTSIDE of min and max to be valid
-	for (int r = 0; r < H; r++)
-	{
-		const uint16_t* Du16_ptr = &rangeImage(r, 0);
-		const float* Dgt_ptr =
-			!fp.rangeMask_min ? nullptr : &(*fp.rangeMask_min)(r, 0);
-		const float* Dlt_ptr =
-			!fp.rangeMask_max ? nullptr : &(*fp.rangeMask_max)(r, 0);
-
-		for (int c = 0; c < W_4; c++)
+	unproject_input_t in;
+	in.H = H;
+	in.W = W;
+	in.DECIM = DECIM;
+	in.kxs = kxs;
+	in.kys = kys;
+	in.kzs = kzs;
+	in.rangeImage = &rangeImage;
+	in.rangeUnits = rangeUnits;
+	in.fp = fp;
+	in.applyTransform = (T != nullptr);
+	if (T) std::copy(T, T + 12, in.T.begin());
+	in.organized = MAKE_ORGANIZED;
+
+	// Points are stored in the same order than do_project_3d_pointcloud():
+	using writer_t = concurrent_point_writer<POINTMAP>;
+	const int Wd = W / DECIM;
+	const auto outputRow = [&](const unproject_row_t& row) {
+		size_t idx = row.outIdx;
+		if (!MAKE_ORGANIZED)
 		{
-			// Let the compiler optimize this as MMX instructions (tested in
-			// godbolt):
-			alignas(16) float tmp[4];
-			for (int b = 0; b < 4; b++) tmp[b] = Du16_ptr[b] * rangeUnits;
-
-			const __m128 D = _mm_load_ps(&tmp[0]);
-			const __m128 nz_mask = _mm_cmpgt_ps(D, D_zeros);
-			__m128 valid_range_mask;
-			if (!fp.rangeMask_min && !fp.rangeMask_max)
-			{  // No filter: just skip D=0 points
-				valid_range_mask = nz_mask;
-			}
-			else
+			for (size_t k = 0; k < row.count; k++, idx++)
 			{
-				if (!fp.rangeMask_min || !fp.rangeMask_max)
-				{  // Only one filter
-					if (fp.rangeMask_min)
-					{
-						const __m128 Dmin = _mm_load_ps(Dgt_ptr);
-						valid_range_mask = _mm_or_ps(
-							_mm_cmpgt_ps(D, Dmin), _mm_cmpeq_ps(Dmin, D_zeros));
-					}
-					else
-					{
-						const __m128 Dmax = _mm_load_ps(Dlt_ptr);
-						valid_range_mask = _mm_or_ps(
-							_mm_cmplt_ps(D, Dmax), _mm_cmpeq_ps(Dmax, D_zeros));
-					}
-					valid_range_mask = _mm_and_ps(
-						valid_range_mask, nz_mask);  // Filter out D=0 points
-				}
-				else
-				{
-					// We have both: D>Dmin and D<Dmax conditions, with XOR to
-					// optionally invert the selection:
-					const __m128 Dmin = _mm_load_ps(Dgt_ptr);
-					const __m128 Dmax = _mm_load_ps(Dlt_ptr);
-
-					const __m128 gt_mask = _mm_or_ps(
-						_mm_cmpgt_ps(D, Dmin), _mm_cmpeq_ps(Dmin, D_zeros));
-					const __m128 lt_mask = _mm_or_ps(
-						_mm_cmplt_ps(D, Dmax), _mm_cmpeq_ps(Dmax, D_zeros));
-					// (D>Dmin && D<Dmax) & skip points at zero
-					valid_range_mask =
-						_mm_and_ps(nz_mask, _mm_and_ps(gt_mask, lt_mask));
-					valid_range_mask = _mm_xor_ps(valid_range_mask, xormask);
-					// Add the case of D_min & D_max = 0 (no filtering)
-					valid_range_mask = _mm_or_ps(
-						valid_range_mask, _mm_and_ps(
-											  _mm_cmpeq_ps(Dmin, D_zeros),
-											  _mm_cmpeq_ps(Dmax, D_zeros)));
-					// Finally, ensure no invalid ranges get thru:
-					valid_range_mask = _mm_and_ps(valid_range_mask, nz_mask);
-				}
-			}
-			const int valid_range_maski = _mm_movemask_epi8(
-				_mm_castps_si128(valid_range_mask));  // 0x{f|0}{f|0}{f|0}{f|0}
-			if (valid_range_maski != 0)  // Any of the 4 values is valid?
-			{
-				const __m128 KX = _mm_load_ps(kxs);
-				const __m128 KY = _mm_load_ps(kys);
-				const __m128 KZ = _mm_load_ps(kzs);
-
-				_mm_storeu_ps(xs, _mm_mul_ps(KX, D));
-				_mm_storeu_ps(ys, _mm_mul_ps(KY, D));
-				_mm_storeu_ps(zs, _mm_mul_ps(KZ, D));
-
-				for (int q = 0; q < 4; q++)
-				{
-					const int actual_c = (c << 2) + q;
-					if ((valid_range_maski & (1 << (q * 4))) != 0)
-					{
-						pca.setPointXYZ(idx, xs[q], ys[q], zs[q]);
-						idxs_x[idx] = actual_c;
-						idxs_y[idx] = r;
-						++idx;
-					}
-					else
-					{
-						if (MAKE_ORGANIZED)
-						{
-							pca.setInvalidPoint(idx);
-							++idx;
-						}
-						if (fp.mark_invalid_ranges)
-							rangeImage.coeffRef(r, actual_c) = 0;
-					}
-				}
+				writer_t::set(pca, idx, row.xs[k], row.ys[k], row.zs[k]);
+				idxs_x[idx] = row.idxs_x[k];
+				idxs_y[idx] = row.idxs_y[k];
 			}
-			else if (MAKE_ORGANIZED)
+			return;
+		}
+		// Organized: fill in the gaps with invalid points
+		size_t k = 0;
+		for (int cd = 0; cd < Wd; cd++, idx++)
+		{
+			if (k == row.count || row.idxs_x[k] != cd * DECIM + DECIM / 2)
 			{
-				for (int q = 0; q < 4; q++)
-				{
-					pca.setInvalidPoint(idx);
-					++idx;
-					const int actual_c = (c << 2) + q;
-					if (fp.mark_invalid_ranges)
-						rangeImage.coeffRef(r, actual_c) = 0;
-				}
+				writer_t::setInvalid(pca, idx);
+				continue;
 			}
-			Du16_ptr += 4;
-			if (Dgt_ptr) Dgt_ptr += 4;
-			if (Dlt_ptr) Dlt_ptr += 4;
-			kxs += 4;
-			kys += 4;
-			kzs += 4;
+			writer_t::set(pca, idx, row.xs[k], row.ys[k], row.zs[k]);
+			idxs_x[idx] = row.idxs_x[k];
+			idxs_y[idx] = row.idxs_y[k];
+			k++;
 		}
-	}
+	};
+	const size_t idx = unprojectRangeImage(in, numThreads, outputRow);
+
+	// This also marks the cloud as modified, after the concurrent writes:
 	pca.resize(idx);
 	// Make sure indices are also resized down to the actual number of points,
 	// even if they are not part of the object PCA refers to:
 	idxs_x.resize(idx);
 	idxs_y.resize(idx);
-#endif
 }
 }  // namespace mrpt::obs::detail
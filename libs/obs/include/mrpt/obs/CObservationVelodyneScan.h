@@ -14,6 +14,7 @@
 #include <mrpt/obs/VelodyneCalibration.h>
 #include <mrpt/poses/CPose3D.h>
 #include <mrpt/serialization/CSerializable.h>
+#include <functional>
 #include <vector>
 
 namespace mrpt
@@ -313,6 +314,10 @@ class CObservationVelodyneScan : public CObservation
 		bool generatePerPointAzimuth{false};
 		/** (Default:false) If `true`, populate pointsForLaserID */
 		bool generatePointsForLaserID{false};
+		/** (Default:1) Number of threads among which data packets are split
+		 * for decoding. `0` means using all CPU cores.
+		 * \note (New in MRPT 2.1.0) */
+		unsigned int numThreads{1};
 	};
 
 	/** Derive from this class to generate pointclouds into custom containers.
@@ -331,6 +336,56 @@ class CObservationVelodyneScan : public CObservation
 			uint16_t laser_id) = 0;
 	};
 
+	/** The points decoded from one data packet, as passed to the sink of
+	 * generatePointCloudBatch(). Arrays have `count` elements, in the same
+	 * order in which points are passed to PointCloudStorageWrapper::add_point()
+	 * \note (New in MRPT 2.1.0) */
+	struct TDecodedPoints
+	{
+		/** Index of the packet in scan_packets */
+		std::size_t packetIndex{0};
+		/** Index of the first point in the whole point cloud, i.e. the number
+		 * of points decoded from all previous packets */
+		std::size_t outIdx{0};
+		/** Number of points */
+		std::size_t count{0};
+		/** Timestamp of the packet, shared by all its points */
+		mrpt::system::TTimeStamp timestamp{INVALID_TIMESTAMP};
+		/** Point coordinates, in sensor-centric coordinates */
+		const float *x{nullptr}, *y{nullptr}, *z{nullptr};
+		const uint8_t* intensity{nullptr};
+		/** Corrected azimuth, in hundredths of degree (not wrapped to
+		 * [0,ROTATION_MAX_UNITS)) */
+		const float* azimuth{nullptr};
+		const uint16_t* laser_id{nullptr};
+	};
+
+	/** Upper bound of the number of points that generatePointCloudBatch()
+	 * may generate, useful to allocate sink storage in advance. */
+	std::size_t maxPointCount() const
+	{
+		return scan_packets.size() * BLOCKS_PER_PACKET * SCANS_PER_FIRING;
+	}
+
+	/** Decodes scan_packets and hands over the points of each packet, as
+	 * plain arrays, to `sink`. This avoids the per-point virtual calls of
+	 * PointCloudStorageWrapper, and allows filling any kind of sink storage
+	 * without intermediary copies.
+	 *
+	 * If `params.numThreads!=1`, packets are decoded in parallel and `sink`
+	 * may be invoked from several threads at once (always for distinct
+	 * output indices), in no particular order. Otherwise, it is invoked
+	 * from the calling thread in packet order.
+	 *
+	 * \return The total number of decoded points.
+	 * \sa generatePointCloud(), maxPointCount()
+	 * \note (New in MRPT 2.1.0)
+	 */
+	std::size_t generatePointCloudBatch(
+		const std::function<void(const TDecodedPoints&)>& sink,
+		const TGeneratePointCloudParameters& params =
+			TGeneratePointCloudParameters()) const;
+
 	/** Generates the point cloud into the point cloud data fields in \a
 	 * CObservationVelodyneScan::point_cloud
 	 * where it is stored in local coordinates wrt the sensor (neither the
@@ -13,6 +13,12 @@
 #include <mrpt/obs/CObservationComment.h>
 #include <mrpt/obs/CSensoryFrame.h>
 #include <mrpt/poses/CPose2D.h>
+#include <memory>
+
+namespace mrpt::io
+{
+class CFileMMapInputStream;
+}
 
 namespace mrpt::obs
 {
@@ -57,6 +63,8 @@ using TListTimeAndObservations =
  * \note The format #2 is supported since MRPT version 0.6.0.
  * \note There is a static helper method "detectImagesDirectory" for localizing
  *the external images directory of a rawlog.
+ * \note Large rawlog files can be opened without loading them into memory,
+ *see loadFromRawLogFileLazy() (New in MRPT 2.1.0).
  *
  * \sa CSensoryFrame, CPose2D, <a href="http://www.mrpt.org/Rawlog_Format">
  *RawLog file format</a>.
@@ -68,8 +76,9 @@ class CRawlog : public mrpt::serialization::CSerializable
 
    private:
 	using TListObjects = std::vector<mrpt::serialization::CSerializable::Ptr>;
-	/** The list where the objects really are in. */
-	TListObjects m_seqOfActObs;
+	/** The list where the objects really are in. In lazy mode, entries are
+	 * nullptr until they are first accessed. */
+	mutable TListObjects m_seqOfActObs;
 
 	/** Comments of the rawlog. */
 	CObservationComment m_commentTexts;
@@ -138,6 +147,103 @@ class CRawlog : public mrpt::serialization::CSerializable
 	bool loadFromRawLogFile(
 		const std::string& fileName, bool non_obs_objects_are_legal = false);
 
+	/** One entry in the index of a rawlog file, see buildIndex() */
+	struct TIndexEntry
+	{
+		/** Position (bytes) of the serialized object within the uncompressed
+		 * rawlog file, and its length */
+		uint64_t offset{0}, length{0};
+		/** Timestamp of observations (INVALID_TIMESTAMP for other classes) */
+		mrpt::system::TTimeStamp timestamp{INVALID_TIMESTAMP};
+		/** The name of the object class */
+		std::string className;
+		/** The sensor label of observations (empty for other classes) */
+		std::string sensorLabel;
+		/** The object class, or nullptr if it is not registered. It is not
+		 * saved in index files, but looked up while loading them. */
+		const mrpt::rtti::TRuntimeClassId* classId{nullptr};
+	};
+	using TIndex = std::vector<TIndexEntry>;
+
+	/** Builds the index of all the objects in a rawlog file, in one streaming
+	 * pass: objects are deserialized one by one to read their timestamps and
+	 * sensor labels, then discarded. Like loadFromRawLogFile(), it stops
+	 * reading at the end of the file or at the first unknown class.
+	 * Offsets are positions in the uncompressed data, which are only valid
+	 * as file offsets for non-compressed rawlogs.
+	 * \return false if the file cannot be open.
+	 * \sa saveIndexFile, loadFromRawLogFileLazy
+	 * \note (New in MRPT 2.1.0)
+	 */
+	static bool buildIndex(const std::string& rawlogFile, TIndex& index);
+
+	/** The default name of the index file of a rawlog: `<rawlogFile>.idx` */
+	static std::string getIndexFileName(const std::string& rawlogFile);
+
+	/** Saves a rawlog index to a sidecar file, along with the size and
+	 * modification time of the rawlog file, so outdated indices are
+	 * detected by loadIndexFile().
+	 * \param indexFile If empty, getIndexFileName(rawlogFile) is used.
+	 * \return false on any error writing the file.
+	 * \note (New in MRPT 2.1.0)
+	 */
+	static bool saveIndexFile(
+		const std::string& rawlogFile, const TIndex& index,
+		const std::string& indexFile = std::string());
+
+	/** Loads a rawlog index from a sidecar file written by saveIndexFile().
+	 * \param indexFile If empty, getIndexFileName(rawlogFile) is used.
+	 * \return false if the index file does not exist, is corrupt, or it does
+	 * not match the current size and modification time of the rawlog file.
+	 * \note (New in MRPT 2.1.0)
+	 */
+	static bool loadIndexFile(
+		const std::string& rawlogFile, TIndex& index,
+		const std::string& indexFile = std::string());
+
+	/** Opens a rawlog file in "lazy" mode: the file is mapped into memory
+	 * and each object is only deserialized the first time it is accessed
+	 * (by means of getAsObservation(), iterators, etc.). Objects are
+	 * located with the sidecar index of the rawlog (see loadIndexFile()),
+	 * which is built and saved if it does not exist or is outdated.
+	 *
+	 * Hence, opening large files is fast, memory usage only grows with the
+	 * accessed objects (see unloadEntry()), and size(), getType() and
+	 * findObservationsByClassInRange() use the index, without deserializing
+	 * anything but the objects being returned.
+	 *
+	 * This mode requires non-compressed rawlog files. For gz or
+	 * zstd-compressed files (e.g. those written by saveToRawLogFile()), and
+	 * for files containing one serialized CRawlog object, this method falls
+	 * back to loadFromRawLogFile(). Compressed files can be converted with
+	 * `gunzip` or rawlog-edit `--transcode`.
+	 *
+	 * Accessing entries modifies internal caches: if a CRawlog in lazy mode
+	 * is used from several threads, accesses must be externally
+	 * synchronized.
+	 *
+	 * \param save_index_file Whether to save the index file if it has to be
+	 * built. Errors writing it (e.g. read-only directories) are ignored.
+	 * \return false upon error reading or accessing the file.
+	 * \sa isLazy, loadFromRawLogFile
+	 * \note (New in MRPT 2.1.0)
+	 */
+	bool loadFromRawLogFileLazy(
+		const std::string& fileName, bool non_obs_objects_are_legal = false,
+		bool save_index_file = true);
+
+	/** Returns true if the rawlog was loaded with loadFromRawLogFileLazy()
+	 * from a memory-mapped file */
+	bool isLazy() const { return m_lazyFile != nullptr; }
+
+	/** In lazy mode, frees the memory of one deserialized entry, which will
+	 * be deserialized again from the file upon next access, losing any
+	 * modification. It has no effect on entries not read from the file, or
+	 * if the rawlog is not in lazy mode.
+	 * \sa loadFromRawLogFileLazy
+	 */
+	void unloadEntry(size_t index);
+
 	/** Saves the contents to a rawlog-file, compatible with RawlogViewer (As
 	 * the sequence of internal objects).
 	 *  The file is saved with gz-commpressed if MRPT has gz-streams.
@@ -228,18 +334,30 @@ class CRawlog : public mrpt::serialization::CSerializable
 	 * type of each entry in the sequence. */
 	class iterator
 	{
+		friend class CRawlog;
+
 	   protected:
 		TListObjects::iterator m_it;
+		/** Only needed for loading entries in lazy mode */
+		const CRawlog* m_rawlog{nullptr};
 
 	   public:
 		iterator() : m_it() {}
-		iterator(const TListObjects::iterator& it) : m_it(it) {}
+		iterator(
+			const TListObjects::iterator& it, const CRawlog* rawlog = nullptr)
+			: m_it(it), m_rawlog(rawlog)
+		{
+		}
 		virtual ~iterator() = default;
 		iterator& operator=(const iterator& o) = default;
 
 		bool operator==(const iterator& o) { return m_it == o.m_it; }
 		bool operator!=(const iterator& o) { return m_it != o.m_it; }
-		mrpt::serialization::CSerializable::Ptr operator*() { return *m_it; }
+		mrpt::serialization::CSerializable::Ptr operator*()
+		{
+			if (!*m_it && m_rawlog) return m_rawlog->entry(index());
+			return *m_it;
+		}
 		inline iterator operator++(int)
 		{
 			iterator aux = *this;
@@ -265,15 +383,22 @@ class CRawlog : public mrpt::serialization::CSerializable
 
 		TEntryType getType() const
 		{
-			if ((*m_it)->GetRuntimeClass()->derivedFrom(CLASS_ID(CObservation)))
+			const auto* cls = *m_it ? (*m_it)->GetRuntimeClass()
+									: m_rawlog->entryClass(index());
+			if (cls->derivedFrom(CLASS_ID(CObservation)))
 				return etObservation;
-			else if ((*m_it)->GetRuntimeClass()->derivedFrom(
-						 CLASS_ID(CSensoryFrame)))
+			else if (cls->derivedFrom(CLASS_ID(CSensoryFrame)))
 				return etSensoryFrame;
 			else
 				return etActionCollection;
 		}
 
+		/** The position of this entry in the rawlog */
+		size_t index() const
+		{
+			return static_cast<size_t>(m_it - m_rawlog->m_seqOfActObs.begin());
+		}
+
 		static iterator erase(TListObjects& lst, const iterator& it)
 		{
 			return lst.erase(it.m_it);
@@ -286,15 +411,23 @@ class CRawlog : public mrpt::serialization::CSerializable
 	{
 	   protected:
 		TListObjects::const_iterator m_it;
+		/** Only needed for loading entries in lazy mode */
+		const CRawlog* m_rawlog{nullptr};
 
 	   public:
 		const_iterator() : m_it() {}
-		const_iterator(const TListObjects::const_iterator& it) : m_it(it) {}
+		const_iterator(
+			const TListObjects::const_iterator& it,
+			const CRawlog* rawlog = nullptr)
+			: m_it(it), m_rawlog(rawlog)
+		{
+		}
 		virtual ~const_iterator() = default;
 		bool operator==(const const_iterator& o) { return m_it == o.m_it; }
 		bool operator!=(const const_iterator& o) { return m_it != o.m_it; }
 		const mrpt::serialization::CSerializable::Ptr operator*() const
 		{
+			if (!*m_it && m_rawlog) return m_rawlog->entry(index());
 			return *m_it;
 		}
 
@@ -323,23 +456,34 @@ class CRawlog : public mrpt::serialization::CSerializable
 
 		TEntryType getType() const
 		{
-			if ((*m_it)->GetRuntimeClass()->derivedFrom(CLASS_ID(CObservation)))
+			const auto* cls = *m_it ? (*m_it)->GetRuntimeClass()
+									: m_rawlog->entryClass(index());
+			if (cls->derivedFrom(CLASS_ID(CObservation)))
 				return etObservation;
-			else if ((*m_it)->GetRuntimeClass()->derivedFrom(
-						 CLASS_ID(CSensoryFrame)))
+			else if (cls->derivedFrom(CLASS_ID(CSensoryFrame)))
 				return etSensoryFrame;
 			else
 				return etActionCollection;
 		}
+
+		/** The position of this entry in the rawlog */
+		size_t index() const
+		{
+			return static_cast<size_t>(
+				m_it - m_rawlog->m_seqOfActObs.cbegin());
+		}
 	};
 
-	const_iterator begin() const { return m_seqOfActObs.begin(); }
-	iterator begin() { return m_seqOfActObs.begin(); }
-	const_iterator end() const { return m_seqOfActObs.end(); }
-	iterator end() { return m_seqOfActObs.end(); }
+	const_iterator begin() const { return {m_seqOfActObs.cbegin(), this}; }
+	iterator begin() { return {m_seqOfActObs.begin(), this}; }
+	const_iterator end() const { return {m_seqOfActObs.cend(), this}; }
+	iterator end() { return {m_seqOfActObs.end(), this}; }
 	iterator erase(const iterator& it)
 	{
-		return iterator::erase(m_seqOfActObs, it);
+		if (isLazy())
+			m_lazyIndex.erase(
+				m_lazyIndex.begin() + (it.m_it - m_seqOfActObs.begin()));
+		return {iterator::erase(m_seqOfActObs, it).m_it, this};
 	}
 
 	/** Returns the sub-set of observations of a given class whose time-stamp t
@@ -425,6 +569,22 @@ class CRawlog : public mrpt::serialization::CSerializable
 	 */
 	static std::string detectImagesDirectory(const std::string& rawlogFilename);
 
+   private:
+	/** Lazy mode: the memory-mapped rawlog file, and the index entry of each
+	 * element in m_seqOfActObs. See loadFromRawLogFileLazy() */
+	std::shared_ptr<mrpt::io::CFileMMapInputStream> m_lazyFile;
+	std::string m_lazyFileName;
+	TIndex m_lazyIndex;
+
+	/** Returns the i'th element, deserializing it first in lazy mode. The
+	 * index must be valid. */
+	const mrpt::serialization::CSerializable::Ptr& entry(size_t index) const;
+	/** The class of the i'th element, without deserializing it */
+	const mrpt::rtti::TRuntimeClassId* entryClass(size_t index) const;
+	/** The timestamp of the i'th element, without deserializing it.
+	 * \exception std::exception If it is not an observation */
+	mrpt::system::TTimeStamp entryTimestamp(size_t index) const;
+
 };  // End of class def.
 
 }  // namespace mrpt::obs
@@ -27,9 +27,16 @@ struct T3DPointsProjectionParams
 	/** (Default: nullptr) Read takeIntoAccountSensorPoseOnRobot */
 	const mrpt::poses::CPose3D* robotPoseInTheWorld = nullptr;
 
-	/** (Default:true) If possible, use SSE2 optimized code. */
+	/** (Default:true) If possible, use SIMD optimized code (AVX2, if
+	 * detected at runtime), which may also run in parallel (see numThreads).
+	 */
 	bool USE_SSE2 = true;
 
+	/** (Default:1) Number of threads to unproject the range image with, if
+	 * USE_SSE2 is true. 0 means as many as CPU cores.
+	 * \note (New in MRPT 2.1.0) */
+	unsigned int numThreads = 1;
+
 	/** (Default:false) set to true if you want an organized point cloud */
 	bool MAKE_ORGANIZED = false;
 
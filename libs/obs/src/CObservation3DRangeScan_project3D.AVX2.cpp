@@ -0,0 +1,185 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2020, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include "obs-precomp.h"  // Precompiled headers
+
+#include <mrpt/config.h>
+
+#if MRPT_ARCH_INTEL_COMPATIBLE
+// ---------------------------------------------------------------------------
+//   This file contains the AVX2 optimized functions for
+//   mrpt::obs::CObservation3DRangeScan::unprojectInto()
+//    See the sources and the doxygen documentation page "sse_optimizations" for
+//    more details.
+// ---------------------------------------------------------------------------
+
+#include <immintrin.h>
+#include "CObservation3DRangeScan_project3D.SSEx.h"
+
+/** \addtogroup sse_optimizations
+ *  SSE optimized functions
+ *  @{
+ */
+
+namespace
+{
+// For each 8-bit mask of valid lanes, the permutation that moves those lanes
+// to the front of a __m256 (a "compress" operation):
+struct CompressLUT
+{
+	alignas(32) uint32_t perm[256][8];
+	uint8_t count[256];
+	CompressLUT()
+	{
+		for (unsigned m = 0; m < 256; m++)
+		{
+			unsigned n = 0;
+			for (unsigned i = 0; i < 8; i++)
+				if (m & (1U << i)) perm[m][n++] = i;
+			count[m] = static_cast<uint8_t>(n);
+			for (; n < 8; n++) perm[m][n] = 0;
+		}
+	}
+};
+}  // namespace
+
+/** Range filter, 8 pixels at once. Range masks are compared with ordered
+ * predicates and "is filter present" with an unordered one, so NaN masks
+ * behave like in TRangeImageFilter::do_range_filter(). */
+void unproj_AVX2_filter_row(
+	uint16_t* ri, const float* minMask, const float* maxMask, std::size_t W,
+	float rangeUnits, bool rangeCheckBetween, bool markInvalid, float* out)
+{
+	const __m256 units = _mm256_set1_ps(rangeUnits);
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 ones = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+	const __m256 invert = rangeCheckBetween ? zero : ones;
+
+	std::size_t c = 0;
+	for (; c + 8 <= W; c += 8)
+	{
+		const __m128i raw =
+			_mm_loadu_si128(reinterpret_cast<const __m128i*>(ri + c));
+		const __m256 D = _mm256_mul_ps(
+			_mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(raw)), units);
+		__m256 valid = _mm256_cmp_ps(D, zero, _CMP_GT_OQ);
+
+		if (minMask || maxMask)
+		{
+			__m256 hasMin = zero, hasMax = zero, passGt = ones, passLt = ones;
+			if (minMask)
+			{
+				const __m256 m = _mm256_loadu_ps(minMask + c);
+				hasMin = _mm256_cmp_ps(m, zero, _CMP_NEQ_UQ);
+				passGt = _mm256_or_ps(
+					_mm256_andnot_ps(hasMin, ones),
+					_mm256_cmp_ps(D, m, _CMP_GE_OQ));
+			}
+			if (maxMask)
+			{
+				const __m256 m = _mm256_loadu_ps(maxMask + c);
+				hasMax = _mm256_cmp_ps(m, zero, _CMP_NEQ_UQ);
+				passLt = _mm256_or_ps(
+					_mm256_andnot_ps(hasMax, ones),
+					_mm256_cmp_ps(D, m, _CMP_LE_OQ));
+			}
+			// Outside-of-range check only if both filters are present:
+			const __m256 flip =
+				_mm256_and_ps(_mm256_and_ps(hasMin, hasMax), invert);
+			valid = _mm256_and_ps(
+				valid, _mm256_xor_ps(_mm256_and_ps(passGt, passLt), flip));
+		}
+		_mm256_storeu_ps(out + c, _mm256_and_ps(D, valid));
+
+		if (markInvalid)
+		{
+			// 32bit lane masks (0 or -1) to 16bit, with signed saturation:
+			const __m256i v = _mm256_castps_si256(valid);
+			const __m128i v16 = _mm_packs_epi32(
+				_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+			_mm_storeu_si128(
+				reinterpret_cast<__m128i*>(ri + c), _mm_and_si128(raw, v16));
+		}
+	}
+	if (c < W)
+		unproj_filter_row(
+			ri + c, minMask ? minMask + c : nullptr,
+			maxMask ? maxMask + c : nullptr, W - c, rangeUnits,
+			rangeCheckBetween, markInvalid, out + c);
+}
+
+/** Unprojection of 8 pixels at once. Valid points are packed with
+ * _mm256_permutevar8x32_ps() and full 8-lane (unaligned) stores, hence the
+ * slack required in the output buffers. No FMA is used, so results are
+ * bit-exact with the portable version. */
+std::size_t unproj_AVX2_points(
+	const float* D, const float* kx, const float* ky, const float* kz,
+	std::size_t N, const float* T, uint32_t pix0, float* xs, float* ys,
+	float* zs, uint32_t* pixIdx)
+{
+	// Not a global, so it is never initialized (with AVX2 code) unless AVX2
+	// is available:
+	static const CompressLUT compressLUT;
+
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256i lane = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	__m256 t[12];
+	if (T)
+		for (int k = 0; k < 12; k++) t[k] = _mm256_set1_ps(T[k]);
+
+	std::size_t n = 0, i = 0;
+	for (; i + 8 <= N; i += 8)
+	{
+		const __m256 d = _mm256_loadu_ps(D + i);
+		const int mask = _mm256_movemask_ps(_mm256_cmp_ps(d, zero, _CMP_GT_OQ));
+		if (!mask) continue;
+
+		__m256 x = _mm256_mul_ps(_mm256_loadu_ps(kx + i), d);
+		__m256 y = _mm256_mul_ps(_mm256_loadu_ps(ky + i), d);
+		__m256 z = _mm256_mul_ps(_mm256_loadu_ps(kz + i), d);
+		if (T)
+		{
+			const auto row = [&](int k) {
+				return _mm256_add_ps(
+					_mm256_add_ps(
+						_mm256_add_ps(
+							_mm256_mul_ps(t[k + 0], x),
+							_mm256_mul_ps(t[k + 1], y)),
+						_mm256_mul_ps(t[k + 2], z)),
+					t[k + 3]);
+			};
+			const __m256 x2 = row(0), y2 = row(4), z2 = row(8);
+			x = x2;
+			y = y2;
+			z = z2;
+		}
+
+		const __m256i perm = _mm256_load_si256(
+			reinterpret_cast<const __m256i*>(compressLUT.perm[mask]));
+		_mm256_storeu_ps(xs + n, _mm256_permutevar8x32_ps(x, perm));
+		_mm256_storeu_ps(ys + n, _mm256_permutevar8x32_ps(y, perm));
+		_mm256_storeu_ps(zs + n, _mm256_permutevar8x32_ps(z, perm));
+		const __m256i pix = _mm256_add_epi32(
+			_mm256_set1_epi32(static_cast<int>(pix0 + i)), lane);
+		_mm256_storeu_si256(
+			reinterpret_cast<__m256i*>(pixIdx + n),
+			_mm256_permutevar8x32_epi32(pix, perm));
+		n += compressLUT.count[mask];
+	}
+	if (i < N)
+		n += unproj_points(
+			D + i, kx + i, ky + i, kz + i, N - i, T,
+			pix0 + static_cast<uint32_t>(i), xs + n, ys + n, zs + n,
+			pixIdx + n);
+	return n;
+}
+
+/** @} */
+
+#endif  // MRPT_ARCH_INTEL_COMPATIBLE
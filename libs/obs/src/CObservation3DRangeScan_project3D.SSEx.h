@@ -0,0 +1,42 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2020, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <mrpt/config.h>
+#include <cstddef>
+#include <cstdint>
+
+// See documentation in CObservation3DRangeScan_project3D.AVX2.cpp
+
+// Converts one row of `W` raw ranges into metric ranges in `out`, with the
+// exact same semantics than TRangeImageFilter::do_range_filter(): pixels
+// which do not pass the filter are output as 0. `minMask` and `maxMask` may
+// be nullptr. If `markInvalid`, failing pixels are also set to 0 in `ri`.
+void unproj_filter_row(
+	uint16_t* ri, const float* minMask, const float* maxMask, std::size_t W,
+	float rangeUnits, bool rangeCheckBetween, bool markInvalid, float* out);
+
+// Unprojects the `N` ranges `D` with the LUT coefficients `kx,ky,kz`,
+// optionally transforming them with the 3x4 row-major matrix `T` (may be
+// nullptr). Only points with D>0 are stored, packed, in `xs,ys,zs`, together
+// with their index `pix0+i` in `pixIdx`. Returns the number of stored
+// points. Output arrays must have room for N+8 elements.
+std::size_t unproj_points(
+	const float* D, const float* kx, const float* ky, const float* kz,
+	std::size_t N, const float* T, uint32_t pix0, float* xs, float* ys,
+	float* zs, uint32_t* pixIdx);
+
+void unproj_AVX2_filter_row(
+	uint16_t* ri, const float* minMask, const float* maxMask, std::size_t W,
+	float rangeUnits, bool rangeCheckBetween, bool markInvalid, float* out);
+
+std::size_t unproj_AVX2_points(
+	const float* D, const float* kx, const float* ky, const float* kz,
+	std::size_t N, const float* T, uint32_t pix0, float* xs, float* ys,
+	float* zs, uint32_t* pixIdx);
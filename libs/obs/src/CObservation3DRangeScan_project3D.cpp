@@ -0,0 +1,295 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2020, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include "obs-precomp.h"  // Precompiled headers
+
+#include <mrpt/core/WorkerThreadsPool.h>
+#include <mrpt/core/cpu.h>
+#include <mrpt/obs/CObservation3DRangeScan.h>
+#include <algorithm>
+#include <limits>
+
+// Prototypes of SSE2/AVX2 optimized functions:
+#include "CObservation3DRangeScan_project3D.SSEx.h"
+
+using namespace mrpt::obs::detail;
+
+namespace
+{
+inline void transformPoint(const float* T, float& x, float& y, float& z)
+{
+	// Same order of operations than the AVX2 version:
+	const float x2 = ((T[0] * x + T[1] * y) + T[2] * z) + T[3];
+	const float y2 = ((T[4] * x + T[5] * y) + T[6] * z) + T[7];
+	const float z2 = ((T[8] * x + T[9] * y) + T[10] * z) + T[11];
+	x = x2;
+	y = y2;
+	z = z2;
+}
+}  // namespace
+
+// Portable versions of the kernels in CObservation3DRangeScan_project3D.AVX2:
+void unproj_filter_row(
+	uint16_t* ri, const float* minMask, const float* maxMask, std::size_t W,
+	float rangeUnits, bool rangeCheckBetween, bool markInvalid, float* out)
+{
+	if (!minMask && !maxMask)
+	{
+		// Common case: only D>0 is checked
+		for (std::size_t c = 0; c < W; c++)
+		{
+			const float D = ri[c] * rangeUnits;
+			out[c] = D > .0f ? D : .0f;
+		}
+		return;
+	}
+	for (std::size_t c = 0; c < W; c++)
+	{
+		const float D = ri[c] * rangeUnits;
+		bool valid = D > .0f;
+		if (valid)
+		{
+			bool pass_gt = true, pass_lt = true;
+			bool has_min_filter = false, has_max_filter = false;
+			if (minMask && minMask[c] != .0f)
+			{
+				has_min_filter = true;
+				pass_gt = (D >= minMask[c]);
+			}
+			if (maxMask && maxMask[c] != .0f)
+			{
+				has_max_filter = true;
+				pass_lt = (D <= maxMask[c]);
+			}
+			valid = (has_min_filter && has_max_filter && !rangeCheckBetween)
+						? !(pass_gt && pass_lt)
+						: (pass_gt && pass_lt);
+		}
+		out[c] = valid ? D : .0f;
+		if (!valid && markInvalid) ri[c] = 0;
+	}
+}
+
+std::size_t unproj_points(
+	const float* D, const float* kx, const float* ky, const float* kz,
+	std::size_t N, const float* T, uint32_t pix0, float* xs, float* ys,
+	float* zs, uint32_t* pixIdx)
+{
+	std::size_t n = 0;
+	for (std::size_t i = 0; i < N; i++)
+	{
+		if (!(D[i] > .0f)) continue;
+		float x = kx[i] * D[i], y = ky[i] * D[i], z = kz[i] * D[i];
+		if (T) transformPoint(T, x, y, z);
+		xs[n] = x;
+		ys[n] = y;
+		zs[n] = z;
+		pixIdx[n] = pix0 + static_cast<uint32_t>(i);
+		n++;
+	}
+	return n;
+}
+
+size_t mrpt::obs::detail::unprojectRangeImage(
+	const unproject_input_t& in, unsigned int numThreads,
+	const std::function<void(const unproject_row_t&)>& outputRow)
+{
+	using filter_row_t = decltype(&unproj_filter_row);
+	using points_t = decltype(&unproj_points);
+	filter_row_t filterRow = &unproj_filter_row;
+	points_t points = &unproj_points;
+#if MRPT_ARCH_INTEL_COMPATIBLE
+	if (mrpt::cpu::supports(mrpt::cpu::feature::AVX2))
+	{
+		filterRow = &unproj_AVX2_filter_row;
+		points = &unproj_AVX2_points;
+	}
+#endif
+
+	ASSERT_(in.rangeImage != nullptr);
+	ASSERT_GE_(in.DECIM, 1);
+	const int W = in.W, DECIM = in.DECIM;
+	const int Hd = in.H / DECIM, Wd = W / DECIM;
+	const float* T = in.applyTransform ? in.T.data() : nullptr;
+	const auto& fp = in.fp;
+
+	// Per-thread buffers for one row. Points are handed over to `outputRow`
+	// while still in the cache.
+	struct RowBuffers
+	{
+		RowBuffers(size_t W_, size_t Wd_)
+			: Df(W_),
+			  minRow(Wd_),
+			  xs(W_ + 8),
+			  ys(W_ + 8),
+			  zs(W_ + 8),
+			  cols(W_ + 8),
+			  idxs_x(W_),
+			  idxs_y(W_)
+		{
+		}
+		std::vector<float> Df, minRow, xs, ys, zs;
+		std::vector<uint32_t> cols;
+		std::vector<uint16_t> idxs_x, idxs_y;
+	};
+
+	const auto filterImageRow = [&](int r, bool markInvalid, float* Df) {
+		filterRow(
+			&(*in.rangeImage)(r, 0),
+			fp.rangeMask_min ? &(*fp.rangeMask_min)(r, 0) : nullptr,
+			fp.rangeMask_max ? &(*fp.rangeMask_max)(r, 0) : nullptr, W,
+			in.rangeUnits, fp.rangeCheckBetween, markInvalid, Df);
+	};
+
+	// Decimation: minimum valid range within each DECIMxDECIM block, or NONE
+	constexpr float NONE = std::numeric_limits<float>::max();
+	const auto decimateRow = [&](int rd, bool markInvalid, RowBuffers& buf) {
+		std::fill(buf.minRow.begin(), buf.minRow.end(), NONE);
+		for (int rb = 0; rb < DECIM; rb++)
+		{
+			filterImageRow(rd * DECIM + rb, markInvalid, buf.Df.data());
+			for (int cd = 0; cd < Wd; cd++)
+			{
+				float m = buf.minRow[cd];
+				for (int cb = 0; cb < DECIM; cb++)
+				{
+					const float D = buf.Df[cd * DECIM + cb];
+					if (D > .0f && D < m) m = D;
+				}
+				buf.minRow[cd] = m;
+			}
+		}
+	};
+
+	// Number of valid points in the decimated row `rd`:
+	const auto countRow = [&](int rd, RowBuffers& buf) {
+		size_t n = 0;
+		if (DECIM == 1)
+		{
+			filterImageRow(rd, false, buf.Df.data());
+			for (int c = 0; c < W; c++) n += (buf.Df[c] > .0f) ? 1 : 0;
+		}
+		else
+		{
+			decimateRow(rd, false, buf);
+			for (int cd = 0; cd < Wd; cd++) n += (buf.minRow[cd] != NONE);
+		}
+		return n;
+	};
+
+	// Unprojects the decimated row `rd` into `buf`:
+	const auto unprojectRow = [&](int rd, RowBuffers& buf) {
+		size_t n = 0;
+		if (DECIM == 1)
+		{
+			filterImageRow(rd, fp.mark_invalid_ranges, buf.Df.data());
+			const size_t off = static_cast<size_t>(rd) * W;
+			n = points(
+				buf.Df.data(), in.kxs + off, in.kys + off, in.kzs + off, W, T,
+				0, buf.xs.data(), buf.ys.data(), buf.zs.data(),
+				buf.cols.data());
+			for (size_t i = 0; i < n; i++)
+			{
+				buf.idxs_x[i] = static_cast<uint16_t>(buf.cols[i]);
+				buf.idxs_y[i] = static_cast<uint16_t>(rd);
+			}
+			return n;
+		}
+		// Decimated points are unprojected along the ray of the central
+		// pixel of each block:
+		decimateRow(rd, fp.mark_invalid_ranges, buf);
+		const int eq_r = rd * DECIM + DECIM / 2;
+		for (int cd = 0; cd < Wd; cd++)
+		{
+			const float D = buf.minRow[cd];
+			if (D == NONE) continue;
+			const int eq_c = cd * DECIM + DECIM / 2;
+			const size_t eq_idx = static_cast<size_t>(eq_r) * W + eq_c;
+			float x = in.kxs[eq_idx] * D, y = in.kys[eq_idx] * D,
+				  z = in.kzs[eq_idx] * D;
+			if (T) transformPoint(T, x, y, z);
+			buf.xs[n] = x;
+			buf.ys[n] = y;
+			buf.zs[n] = z;
+			buf.idxs_x[n] = static_cast<uint16_t>(eq_c);
+			buf.idxs_y[n] = static_cast<uint16_t>(eq_r);
+			n++;
+		}
+		return n;
+	};
+
+	// Blocks of consecutive (decimated) rows, one per thread:
+	constexpr int MIN_ROWS_PER_THREAD = 16;
+	numThreads = mrpt::WorkerThreadsPool::clampNumThreads(numThreads);
+	const int nBlocks = std::max(
+		1, std::min(static_cast<int>(numThreads), Hd / MIN_ROWS_PER_THREAD));
+	const int blockRows = (Hd + nBlocks - 1) / nBlocks;
+	const auto blockFirstRow = [&](size_t b) {
+		return std::min(Hd, static_cast<int>(b) * blockRows);
+	};
+
+	const auto runBlocks = [&](const std::function<void(size_t)>& f) {
+		if (nBlocks == 1)
+			f(0);
+		else
+			mrpt::WorkerThreadsPool::sharedPool().parallel_for(
+				0, nBlocks,
+				[&](size_t first, size_t last) {
+					for (size_t b = first; b < last; b++) f(b);
+				},
+				1);
+	};
+
+	// Output index of the first point of each block. Unless the cloud is
+	// organized, the number of valid points of previous blocks must be
+	// counted first:
+	std::vector<size_t> blockOutIdx(nBlocks + 1, 0);
+	if (in.organized)
+	{
+		for (int b = 0; b <= nBlocks; b++)
+			blockOutIdx[b] = static_cast<size_t>(blockFirstRow(b)) * Wd;
+	}
+	else if (nBlocks > 1)
+	{
+		runBlocks([&](size_t b) {
+			RowBuffers buf(W, Wd);
+			size_t n = 0;
+			for (int rd = blockFirstRow(b); rd < blockFirstRow(b + 1); rd++)
+				n += countRow(rd, buf);
+			blockOutIdx[b + 1] = n;
+		});
+		for (int b = 0; b < nBlocks; b++)
+			blockOutIdx[b + 1] += blockOutIdx[b];
+	}
+
+	std::vector<size_t> blockCount(nBlocks, 0);
+	runBlocks([&](size_t b) {
+		RowBuffers buf(W, Wd);
+		unproject_row_t row;
+		row.outIdx = blockOutIdx[b];
+		row.xs = buf.xs.data();
+		row.ys = buf.ys.data();
+		row.zs = buf.zs.data();
+		row.idxs_x = buf.idxs_x.data();
+		row.idxs_y = buf.idxs_y.data();
+		for (int rd = blockFirstRow(b); rd < blockFirstRow(b + 1); rd++)
+		{
+			row.row = rd;
+			row.count = unprojectRow(rd, buf);
+			outputRow(row);
+			blockCount[b] += row.count;
+			row.outIdx += in.organized ? Wd : row.count;
+		}
+	});
+
+	if (in.organized) return static_cast<size_t>(Hd) * Wd;
+	size_t total = 0;
+	for (const auto n : blockCount) total += n;
+	return total;
+}
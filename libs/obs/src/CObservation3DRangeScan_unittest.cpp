@@ -10,14 +10,19 @@
 #include <gtest/gtest.h>
 #include <mrpt/config.h>
 #include <mrpt/containers/copy_container_typecasting.h>
+#include <mrpt/core/WorkerThreadsPool.h>
+#include <mrpt/core/cpu.h>
 #include <mrpt/io/CFileGZInputStream.h>
 #include <mrpt/maps/CSimplePointsMap.h>
 #include <mrpt/math/CHistogram.h>
 #include <mrpt/obs/CObservation3DRangeScan.h>
 #include <mrpt/obs/CSensoryFrame.h>
+#include <mrpt/opengl/CPointCloud.h>
+#include <mrpt/opengl/CPointCloudColoured.h>
 #include <mrpt/serialization/CArchive.h>
 #include <mrpt/system/filesystem.h>
 #include <test_mrpt_common.h>
+#include <random>
 
 using namespace mrpt;
 using namespace std;
@@ -391,3 +396,176 @@ TEST(CObservation3DRangeScan, SyntheticDepth)
 	}
 }
 #endif
+
+// Compares the SIMD (and multi-threaded) unprojection against the portable
+// one. A synthetic LUT is used, so OpenCV is not required.
+TEST(CObservation3DRangeScan, Project3D_SIMD_vs_portable)
+{
+	// Width is not a multiple of 8, to test the kernel tails:
+	constexpr int W = 84, H = 60;
+	constexpr float rangeUnits = 1e-3f;
+
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<float> unif(-1.0f, 1.0f);
+	const auto randomMask = [&](float offset) {
+		mrpt::math::CMatrixF m(H, W);
+		for (int r = 0; r < H; r++)
+			for (int c = 0; c < W; c++)
+				m(r, c) = (rng() % 4) == 0 ? .0f : offset + 2 * unif(rng);
+		return m;
+	};
+
+	std::vector<float> kxs(W * H), kys(W * H), kzs(W * H);
+	for (int i = 0; i < W * H; i++)
+	{
+		kxs[i] = unif(rng);
+		kys[i] = unif(rng);
+		kzs[i] = unif(rng);
+	}
+	mrpt::math::CMatrix_u16 ri0(H, W);
+	for (int r = 0; r < H; r++)
+		for (int c = 0; c < W; c++)
+			ri0(r, c) = (rng() % 5) == 0 ? 0 : 1 + rng() % 6000;
+	const auto minMask = randomMask(2.0f), maxMask = randomMask(4.0f);
+	float T[12];
+	for (auto& t : T) t = unif(rng);
+	const auto transformPoint = [&](float& x, float& y, float& z) {
+		const float x2 = ((T[0] * x + T[1] * y) + T[2] * z) + T[3];
+		const float y2 = ((T[4] * x + T[5] * y) + T[6] * z) + T[7];
+		const float z2 = ((T[8] * x + T[9] * y) + T[10] * z) + T[11];
+		x = x2;
+		y = y2;
+		z = z2;
+	};
+
+	const bool hadAVX2 = mrpt::cpu::supports(mrpt::cpu::feature::AVX2);
+	for (int test_case = 0; test_case < 3 * 256; test_case++)
+	{
+		const int DECIM = 1 << (test_case % 3);
+		const int flags = test_case / 3;
+		const bool organized = (flags & 0x01) != 0;
+		const bool transform = (flags & 0x20) != 0;
+		const bool avx2 = (flags & 0x40) != 0;
+		const unsigned int nThreads = (flags & 0x80) ? 0 : 1;
+		if (avx2 && !hadAVX2) continue;
+		mrpt::cpu::overrideDetectedFeature(mrpt::cpu::feature::AVX2, avx2);
+
+		mrpt::obs::TRangeImageFilterParams fp;
+		if (flags & 0x02) fp.rangeMask_min = &minMask;
+		if (flags & 0x04) fp.rangeMask_max = &maxMask;
+		fp.rangeCheckBetween = (flags & 0x08) != 0;
+		fp.mark_invalid_ranges = (flags & 0x10) != 0;
+
+		const size_t N = (W / DECIM) * (H / DECIM);
+		mrpt::maps::CSimplePointsMap pts1, pts2;
+		mrpt::opengl::PointCloudAdapter<mrpt::maps::CPointsMap> pca1(pts1),
+			pca2(pts2);
+		pca1.resize(N);
+		pca2.resize(N);
+		std::vector<uint16_t> ix1(N), iy1(N), ix2(N), iy2(N);
+		auto ri1 = ri0, ri2 = ri0;
+
+		mrpt::obs::detail::do_project_3d_pointcloud(
+			H, W, &kxs[0], &kys[0], &kzs[0], ri1, rangeUnits, pca1, ix1, iy1,
+			fp, organized, DECIM);
+		mrpt::obs::detail::do_project_3d_pointcloud_SIMD(
+			H, W, &kxs[0], &kys[0], &kzs[0], ri2, rangeUnits, pca2, ix2, iy2,
+			fp, organized, DECIM, transform ? T : nullptr, nThreads);
+
+		const auto ctx = mrpt::format(
+			"DECIM=%i flags=0x%02x avx2=%i", DECIM, flags, avx2 ? 1 : 0);
+		ASSERT_EQ(pts1.size(), pts2.size()) << ctx;
+		EXPECT_TRUE(ri1 == ri2) << ctx;
+		EXPECT_TRUE(ix1 == ix2) << ctx;
+		EXPECT_TRUE(iy1 == iy2) << ctx;
+		for (size_t i = 0; i < pts1.size(); i++)
+		{
+			float x1, y1, z1, x2, y2, z2;
+			pca1.getPointXYZ(i, x1, y1, z1);
+			pca2.getPointXYZ(i, x2, y2, z2);
+			const bool isInvalid = organized && x1 == 0 && y1 == 0 && z1 == 0;
+			if (transform && !isInvalid) transformPoint(x1, y1, z1);
+			EXPECT_EQ(x1, x2) << ctx;
+			EXPECT_EQ(y1, y2) << ctx;
+			EXPECT_EQ(z1, z2) << ctx;
+		}
+	}
+	mrpt::cpu::overrideDetectedFeature(mrpt::cpu::feature::AVX2, hadAVX2);
+}
+
+// The multi-threaded unprojection into opengl point clouds must leave them
+// marked as modified, e.g. with their bounding boxes updated.
+template <class CLOUD>
+static void testProject3DIntoOpenGLCloud()
+{
+	constexpr int W = 64, H = 48;
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<float> unif(-1.0f, 1.0f);
+	std::vector<float> kxs(W * H), kys(W * H), kzs(W * H);
+	for (int i = 0; i < W * H; i++)
+	{
+		kxs[i] = unif(rng);
+		kys[i] = unif(rng);
+		kzs[i] = unif(rng);
+	}
+	mrpt::math::CMatrix_u16 ri(H, W);
+	for (int r = 0; r < H; r++)
+		for (int c = 0; c < W; c++)
+			ri(r, c) = (rng() % 5) == 0 ? 0 : 1 + rng() % 6000;
+
+	for (const bool organized : {false, true})
+	{
+		mrpt::maps::CSimplePointsMap ref;
+		CLOUD cloud;
+		mrpt::opengl::PointCloudAdapter<mrpt::maps::CPointsMap> pcaRef(ref);
+		mrpt::opengl::PointCloudAdapter<CLOUD> pca(cloud);
+
+		// Former contents, with an up-to-date bounding box:
+		pca.resize(1);
+		pca.setPointXYZ(0, 100.0f, 100.0f, 100.0f);
+		mrpt::math::TPoint3D bbMin, bbMax;
+		cloud.getBoundingBox(bbMin, bbMax);
+
+		const size_t N = W * H;
+		pcaRef.resize(N);
+		pca.resize(N);
+		std::vector<uint16_t> ix1(N), iy1(N), ix2(N), iy2(N);
+		auto ri1 = ri, ri2 = ri;
+		mrpt::obs::TRangeImageFilterParams fp;
+		mrpt::obs::detail::do_project_3d_pointcloud(
+			H, W, &kxs[0], &kys[0], &kzs[0], ri1, 1e-3f, pcaRef, ix1, iy1, fp,
+			organized, 1);
+		mrpt::obs::detail::do_project_3d_pointcloud_SIMD(
+			H, W, &kxs[0], &kys[0], &kzs[0], ri2, 1e-3f, pca, ix2, iy2, fp,
+			organized, 1, nullptr, 0);
+
+		ASSERT_EQ(ref.size(), cloud.size());
+		for (size_t i = 0; i < ref.size(); i++)
+		{
+			float x1, y1, z1, x2, y2, z2;
+			pcaRef.getPointXYZ(i, x1, y1, z1);
+			pca.getPointXYZ(i, x2, y2, z2);
+			EXPECT_EQ(x1, x2);
+			EXPECT_EQ(y1, y2);
+			EXPECT_EQ(z1, z2);
+		}
+		mrpt::math::TPoint3D refMin, refMax;
+		ref.boundingBox(refMin, refMax);
+		cloud.getBoundingBox(bbMin, bbMax);
+		EXPECT_NEAR(bbMin.x, refMin.x, 1e-4);
+		EXPECT_NEAR(bbMin.y, refMin.y, 1e-4);
+		EXPECT_NEAR(bbMin.z, refMin.z, 1e-4);
+		EXPECT_NEAR(bbMax.x, refMax.x, 1e-4);
+		EXPECT_NEAR(bbMax.y, refMax.y, 1e-4);
+		EXPECT_NEAR(bbMax.z, refMax.z, 1e-4);
+	}
+}
+
+TEST(CObservation3DRangeScan, Project3D_SIMD_intoOpenGLClouds)
+{
+	// Run the parallel unprojection even in single-core machines:
+	const auto formerNumCores = mrpt::WorkerThreadsPool::overrideNumCores(4);
+	testProject3DIntoOpenGLCloud<mrpt::opengl::CPointCloud>();
+	testProject3DIntoOpenGLCloud<mrpt::opengl::CPointCloudColoured>();
+	mrpt::WorkerThreadsPool::overrideNumCores(formerNumCores);
+}
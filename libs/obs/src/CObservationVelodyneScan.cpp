@@ -10,11 +10,14 @@
 #include "obs-precomp.h"  // Precompiled headers
 
 #include <mrpt/containers/stl_containers_utils.h>
+#include <mrpt/core/WorkerThreadsPool.h>
 #include <mrpt/core/round.h>
 #include <mrpt/obs/CObservationVelodyneScan.h>
 #include <mrpt/poses/CPose3DInterpolator.h>
 #include <mrpt/serialization/CArchive.h>
 #include <mrpt/serialization/stl_serialization.h>
+#include <algorithm>
+#include <array>
 #include <iostream>
 
 using namespace std;
@@ -135,361 +138,493 @@ static double VLP16AdjustTimeStamp(
 		   (firingwithinblock * VLP16_FIRING_TOFFSET);
 }
 
-static void velodyne_scan_to_pointcloud(
-	const Velo& scan, const Velo::TGeneratePointCloudParameters& params,
-	Velo::PointCloudStorageWrapper& out_pc)
+namespace
+{
+constexpr std::size_t MAX_POINTS_PER_PACKET =
+	Velo::BLOCKS_PER_PACKET * Velo::SCANS_PER_FIRING;
+
+// The points of one packet, as SoA arrays:
+struct PacketPoints
+{
+	std::size_t count = 0;
+	mrpt::system::TTimeStamp timestamp;
+	float x[MAX_POINTS_PER_PACKET], y[MAX_POINTS_PER_PACKET],
+		z[MAX_POINTS_PER_PACKET], azimuth[MAX_POINTS_PER_PACKET];
+	uint8_t intensity[MAX_POINTS_PER_PACKET];
+	uint16_t laser_id[MAX_POINTS_PER_PACKET];
+};
+
+// Everything needed to decode the packets of one scan which does not depend
+// on the packet contents: filter thresholds, per-laser calibration as SoA
+// arrays and azimuth interpolation factors.
+class VelodyneDecoder
+{
+   public:
+	VelodyneDecoder(
+		const Velo& scan, const Velo::TGeneratePointCloudParameters& params)
+		: scan_(scan), params_(params)
+	{
+		using mrpt::round;
+
+		// Access to sin/cos table:
+		mrpt::obs::T2DScanProperties scan_props;
+		scan_props.aperture = 2 * M_PI;
+		scan_props.nRays = Velo::ROTATION_MAX_UNITS;
+		scan_props.rightToLeft = true;
+		// The LUT contains sin/cos values for angles in this order: [180deg
+		// ... 0 deg ... -180 deg]
+		lut_sincos_ = &velodyne_sincos_tables.getSinCosForScan(scan_props);
+
+		minAzimuth_int_ = round(params.minAzimuth_deg * 100);
+		maxAzimuth_int_ = round(params.maxAzimuth_deg * 100);
+		realMinDist_ = std::max(mrpt::d2f(scan.minRange), params.minDistance);
+		realMaxDist_ = std::min(params.maxDistance, mrpt::d2f(scan.maxRange));
+		isolatedPointsFilterDistance_units_ = round(
+			params.isolatedPointsFilterDistance / Velo::DISTANCE_RESOLUTION);
+
+		// This is: 16,32,64 depending on the LIDAR model
+		num_lasers_ = scan.calibration.laser_corrections.size();
+
+		// Per-laser calibration. Padded with enough lasers for a whole bank,
+		// so points can be computed for all returns of a block and filtered
+		// afterwards:
+		const std::size_t nLasers =
+			std::max<std::size_t>(num_lasers_, 32 + Velo::SCANS_PER_FIRING);
+		distanceCorrection_.assign(nLasers, .0);
+		cosVert_.assign(nLasers, .0f);
+		sinVert_.assign(nLasers, .0f);
+		horzOffset_.assign(nLasers, .0f);
+		vertOffset_.assign(nLasers, .0f);
+		for (std::size_t i = 0; i < num_lasers_; i++)
+		{
+			const auto& calib = scan.calibration.laser_corrections[i];
+			distanceCorrection_[i] = calib.distanceCorrection;
+			cosVert_[i] = mrpt::d2f(calib.cosVertCorrection);
+			sinVert_[i] = mrpt::d2f(calib.sinVertCorrection);
+			horzOffset_[i] = mrpt::d2f(calib.horizontalOffsetCorrection);
+			vertOffset_[i] = mrpt::d2f(calib.verticalOffsetCorrection);
+		}
+
+		// Azimuth correction: correct for the laser rotation as a function of
+		// timing during the firings. Firings of lasers of the upper bank
+		// (the only one in VLP-16 and HDL-32) happen at dsr=laserId.
+		knownModel_ =
+			(num_lasers_ == 16 || num_lasers_ == 32 || num_lasers_ == 64);
+		for (int dual = 0; dual < 2; dual++)
+			for (int block = 0; block < Velo::BLOCKS_PER_PACKET; block++)
+				for (int dsr = 0; dsr < Velo::SCANS_PER_FIRING; dsr++)
+				{
+					// [us] since beginning of scan
+					double timestampadjustment = 0.0;
+					double blockdsr0 = 0.0;
+					double nextblockdsr0 = 1.0;
+					if (num_lasers_ == 16)
+					{
+						const int firingBlock = dual ? block / 2 : block;
+						timestampadjustment =
+							VLP16AdjustTimeStamp(firingBlock, dsr, 0);
+						nextblockdsr0 =
+							VLP16AdjustTimeStamp(firingBlock + 1, 0, 0);
+						blockdsr0 = VLP16AdjustTimeStamp(firingBlock, 0, 0);
+					}
+					else if (num_lasers_ == 32)
+					{
+						timestampadjustment = HDL32AdjustTimeStamp(block, dsr);
+						nextblockdsr0 = HDL32AdjustTimeStamp(block + 1, 0);
+						blockdsr0 = HDL32AdjustTimeStamp(block, 0);
+					}
+					azimuthAdjustmentFactor_[dual][block][dsr] =
+						(timestampadjustment - blockdsr0) /
+						(nextblockdsr0 - blockdsr0);
+				}
+	}
+
+	/** Decodes all points of one packet into `out` */
+	void decodePacket(std::size_t iPkt, PacketPoints& out) const;
+
+   private:
+	const Velo& scan_;
+	const Velo::TGeneratePointCloudParameters& params_;
+	const CSinCosLookUpTableFor2DScans::TSinCosValues* lut_sincos_ = nullptr;
+	int minAzimuth_int_ = 0, maxAzimuth_int_ = 0;
+	float realMinDist_ = 0, realMaxDist_ = 0;
+	int isolatedPointsFilterDistance_units_ = 0;
+	std::size_t num_lasers_ = 0;
+	bool knownModel_ = false;
+	std::vector<double> distanceCorrection_;
+	std::vector<float> cosVert_, sinVert_, horzOffset_, vertOffset_;
+	// Indices: [dual mode][block][dsr]
+	double azimuthAdjustmentFactor_[2][Velo::BLOCKS_PER_PACKET]
+								   [Velo::SCANS_PER_FIRING];
+};
+
+void VelodyneDecoder::decodePacket(std::size_t iPkt, PacketPoints& out) const
 {
 	// Initially based on code from ROS velodyne & from
 	// vtkVelodyneHDLReader::vtkInternal::ProcessHDLPacket().
 	using mrpt::round;
 
-	// Access to sin/cos table:
-	mrpt::obs::T2DScanProperties scan_props;
-	scan_props.aperture = 2 * M_PI;
-	scan_props.nRays = Velo::ROTATION_MAX_UNITS;
-	scan_props.rightToLeft = true;
-	// The LUT contains sin/cos values for angles in this order: [180deg ... 0
-	// deg ... -180 deg]
-	const CSinCosLookUpTableFor2DScans::TSinCosValues& lut_sincos =
-		velodyne_sincos_tables.getSinCosForScan(scan_props);
-
-	const int minAzimuth_int = round(params.minAzimuth_deg * 100);
-	const int maxAzimuth_int = round(params.maxAzimuth_deg * 100);
-	const float realMinDist =
-		std::max(mrpt::d2f(scan.minRange), params.minDistance);
-	const float realMaxDist =
-		std::min(params.maxDistance, mrpt::d2f(scan.maxRange));
-	const auto isolatedPointsFilterDistance_units = mrpt::round(
-		params.isolatedPointsFilterDistance / Velo::DISTANCE_RESOLUTION);
-
-	// This is: 16,32,64 depending on the LIDAR model
-	const size_t num_lasers = scan.calibration.laser_corrections.size();
-
-	out_pc.resizeLaserCount(num_lasers);
-	out_pc.reserve(
-		Velo::SCANS_PER_BLOCK * scan.scan_packets.size() *
-			Velo::BLOCKS_PER_PACKET +
-		16);
+	const Velo::TVelodyneRawPacket* raw = &scan_.scan_packets[iPkt];
+	const auto& params = params_;
+	const bool isDual = (raw->laser_return_mode == Velo::RETMODE_DUAL);
 
-	for (size_t iPkt = 0; iPkt < scan.scan_packets.size(); iPkt++)
+	out.count = 0;
 	{
-		const Velo::TVelodyneRawPacket* raw = &scan.scan_packets[iPkt];
-
-		mrpt::system::TTimeStamp pkt_tim;  // Find out timestamp of this pkt
+		// Find out timestamp of this pkt
+		const uint32_t us_pkt0 = scan_.scan_packets[0].gps_timestamp();
+		const uint32_t us_pkt_this = raw->gps_timestamp();
+		// Handle the case of time counter reset by new hour 00:00:00
+		const uint32_t us_ellapsed =
+			(us_pkt_this >= us_pkt0)
+				? (us_pkt_this - us_pkt0)
+				: (1000000UL * 3600UL + us_pkt_this - us_pkt0);
+		out.timestamp =
+			mrpt::system::timestampAdd(scan_.timestamp, us_ellapsed * 1e-6);
+	}
+
+	// Take the median rotational speed as a good value for interpolating
+	// the missing azimuths:
+	int median_azimuth_diff;
+	{
+		// In dual return, the azimuth rate is actually twice this
+		// estimation:
+		const unsigned int nBlocksPerAzimuth = isDual ? 2 : 1;
+		const size_t nDiffs = Velo::BLOCKS_PER_PACKET - nBlocksPerAzimuth;
+		std::array<int, Velo::BLOCKS_PER_PACKET> diffs;
+		for (size_t i = 0; i < nDiffs; ++i)
 		{
-			const uint32_t us_pkt0 = scan.scan_packets[0].gps_timestamp();
-			const uint32_t us_pkt_this = raw->gps_timestamp();
-			// Handle the case of time counter reset by new hour 00:00:00
-			const uint32_t us_ellapsed =
-				(us_pkt_this >= us_pkt0)
-					? (us_pkt_this - us_pkt0)
-					: (1000000UL * 3600UL + us_pkt_this - us_pkt0);
-			pkt_tim =
-				mrpt::system::timestampAdd(scan.timestamp, us_ellapsed * 1e-6);
+			int localDiff = (Velo::ROTATION_MAX_UNITS +
+							 raw->blocks[i + nBlocksPerAzimuth].rotation() -
+							 raw->blocks[i].rotation()) %
+							Velo::ROTATION_MAX_UNITS;
+			diffs[i] = localDiff;
 		}
+		std::nth_element(
+			diffs.begin(), diffs.begin() + Velo::BLOCKS_PER_PACKET / 2,
+			diffs.begin() + nDiffs);  // Calc median
+		median_azimuth_diff = diffs[Velo::BLOCKS_PER_PACKET / 2];
+	}
+
+	// Firings per packet
+	for (int block = 0; block < Velo::BLOCKS_PER_PACKET; block++)
+	{
+		const Velo::raw_block_t& blk = raw->blocks[block];
 
-		// Take the median rotational speed as a good value for interpolating
-		// the missing azimuths:
-		int median_azimuth_diff;
+		// ignore packets with mangled or otherwise different contents
+		if ((num_lasers_ != 64 && Velo::UPPER_BANK != blk.header()) ||
+			(blk.header() != Velo::UPPER_BANK &&
+			 blk.header() != Velo::LOWER_BANK))
 		{
-			// In dual return, the azimuth rate is actually twice this
-			// estimation:
-			const unsigned int nBlocksPerAzimuth =
-				(raw->laser_return_mode == Velo::RETMODE_DUAL) ? 2 : 1;
-			const size_t nDiffs = Velo::BLOCKS_PER_PACKET - nBlocksPerAzimuth;
-			std::vector<int> diffs(nDiffs);
-			for (size_t i = 0; i < nDiffs; ++i)
-			{
-				int localDiff = (Velo::ROTATION_MAX_UNITS +
-								 raw->blocks[i + nBlocksPerAzimuth].rotation() -
-								 raw->blocks[i].rotation()) %
-								Velo::ROTATION_MAX_UNITS;
-				diffs[i] = localDiff;
-			}
-			std::nth_element(
-				diffs.begin(), diffs.begin() + Velo::BLOCKS_PER_PACKET / 2,
-				diffs.end());  // Calc median
-			median_azimuth_diff = diffs[Velo::BLOCKS_PER_PACKET / 2];
+			cerr << "[Velo] skipping invalid packet: block " << block
+				 << " header value is " << blk.header();
+			continue;
 		}
 
-		// Firings per packet
-		for (int block = 0; block < Velo::BLOCKS_PER_PACKET; block++)
+		const int dsr_offset = (blk.header() == Velo::LOWER_BANK) ? 32 : 0;
+		const auto azimuth_raw_f = mrpt::d2f(blk.rotation());
+		const bool block_is_dual_2nd_ranges = (isDual && ((block & 0x01) != 0));
+		const bool block_is_dual_last_ranges =
+			(isDual && ((block & 0x01) == 0));
+
+		// Laser ID of the first return. Detect VLP-16 data and adjust laser
+		// ids if necessary:
+		const bool firingWithinBlock = (num_lasers_ == 16 && dsr_offset >= 16);
+		const std::size_t laserId0 =
+			firingWithinBlock ? dsr_offset - 16 : dsr_offset;
+
+		// 1st pass: decide which returns generate a point and find out their
+		// distance and azimuth:
+		bool valid[Velo::SCANS_PER_FIRING];
+		float distance[Velo::SCANS_PER_FIRING];
+		float azimuth_f[Velo::SCANS_PER_FIRING];
+		float cos_azimuth[Velo::SCANS_PER_FIRING];
+		float sin_azimuth[Velo::SCANS_PER_FIRING];
+		for (int dsr = 0, k = 0; dsr < Velo::SCANS_PER_FIRING; dsr++, k++)
 		{
-			// ignore packets with mangled or otherwise different contents
-			if ((num_lasers != 64 &&
-				 Velo::UPPER_BANK != raw->blocks[block].header()) ||
-				(raw->blocks[block].header() != Velo::UPPER_BANK &&
-				 raw->blocks[block].header() != Velo::LOWER_BANK))
-			{
-				cerr << "[Velo] skipping invalid packet: block " << block
-					 << " header value is " << raw->blocks[block].header();
-				continue;
-			}
+			valid[k] = false;
+			distance[k] = .0f;
+			cos_azimuth[k] = .0f;
+			sin_azimuth[k] = .0f;
+
+			const uint16_t dist_this = blk.laser_returns[k].distance();
+			if (!dist_this) continue;  // Invalid return?
+
+			const std::size_t laserId = laserId0 + dsr;
+			ASSERT_LT_(laserId, num_lasers_);
 
-			const int dsr_offset =
-				(raw->blocks[block].header() == Velo::LOWER_BANK) ? 32 : 0;
-			const auto azimuth_raw_f = mrpt::d2f(raw->blocks[block].rotation());
-			const bool block_is_dual_2nd_ranges =
-				(raw->laser_return_mode == Velo::RETMODE_DUAL &&
-				 ((block & 0x01) != 0));
-			const bool block_is_dual_last_ranges =
-				(raw->laser_return_mode == Velo::RETMODE_DUAL &&
-				 ((block & 0x01) == 0));
-
-			for (int dsr = 0, k = 0; dsr < Velo::SCANS_PER_FIRING; dsr++, k++)
+			// In dual return, if the distance is equal in both ranges,
+			// ignore one of them:
+			if (block_is_dual_2nd_ranges)
 			{
-				if (!raw->blocks[block]
-						 .laser_returns[k]
-						 .distance())  // Invalid return?
-					continue;
+				if (dist_this ==
+					raw->blocks[block - 1].laser_returns[k].distance())
+					continue;  // duplicated point
+				if (!params.dualKeepStrongest) continue;
+			}
+			if (block_is_dual_last_ranges && !params.dualKeepLast) continue;
 
-				const auto rawLaserId = static_cast<uint8_t>(dsr + dsr_offset);
-				uint8_t laserId = rawLaserId;
+			// Return distance:
+			const float dist = mrpt::d2f(
+				dist_this * Velo::DISTANCE_RESOLUTION +
+				distanceCorrection_[laserId]);
+			if (dist < realMinDist_ || dist > realMaxDist_) continue;
 
-				// Detect VLP-16 data and adjust laser id if necessary
-				bool firingWithinBlock = false;
-				if (num_lasers == 16)
+			// Isolated points filtering:
+			if (params.filterOutIsolatedPoints)
+			{
+				bool pass_filter = true;
+				const int16_t dist_this_i = dist_this;
+				if (k > 0)
 				{
-					if (laserId >= 16)
-					{
-						laserId -= 16;
-						firingWithinBlock = true;
-					}
+					const int16_t dist_prev =
+						blk.laser_returns[k - 1].distance();
+					if (!dist_prev ||
+						std::abs(dist_this_i - dist_prev) >
+							isolatedPointsFilterDistance_units_)
+						pass_filter = false;
 				}
-
-				ASSERT_LT_(laserId, num_lasers);
-				const mrpt::obs::VelodyneCalibration::PerLaserCalib& calib =
-					scan.calibration.laser_corrections[laserId];
-
-				// In dual return, if the distance is equal in both ranges,
-				// ignore one of them:
-				if (block_is_dual_2nd_ranges)
+				if (k < (Velo::SCANS_PER_FIRING - 1))
 				{
-					if (raw->blocks[block].laser_returns[k].distance() ==
-						raw->blocks[block - 1].laser_returns[k].distance())
-						continue;  // duplicated point
-					if (!params.dualKeepStrongest) continue;
+					const int16_t dist_next =
+						blk.laser_returns[k + 1].distance();
+					if (!dist_next ||
+						std::abs(dist_this_i - dist_next) >
+							isolatedPointsFilterDistance_units_)
+						pass_filter = false;
 				}
-				if (block_is_dual_last_ranges && !params.dualKeepLast) continue;
+				if (!pass_filter) continue;  // Filter out this point
+			}
 
-				// Return distance:
-				const float distance = mrpt::d2f(
-					raw->blocks[block].laser_returns[k].distance() *
-						Velo::DISTANCE_RESOLUTION +
-					calib.distanceCorrection);
-				if (distance < realMinDist || distance > realMaxDist) continue;
+			if (!knownModel_) THROW_EXCEPTION("Error: unhandled LIDAR model!");
 
-				// Isolated points filtering:
-				if (params.filterOutIsolatedPoints)
-				{
-					bool pass_filter = true;
-					const int16_t dist_this =
-						raw->blocks[block].laser_returns[k].distance();
-					if (k > 0)
-					{
-						const int16_t dist_prev =
-							raw->blocks[block].laser_returns[k - 1].distance();
-						if (!dist_prev ||
-							std::abs(dist_this - dist_prev) >
-								isolatedPointsFilterDistance_units)
-							pass_filter = false;
-					}
-					if (k < (Velo::SCANS_PER_FIRING - 1))
-					{
-						const int16_t dist_next =
-							raw->blocks[block].laser_returns[k + 1].distance();
-						if (!dist_next ||
-							std::abs(dist_this - dist_next) >
-								isolatedPointsFilterDistance_units)
-							pass_filter = false;
-					}
-					if (!pass_filter) continue;  // Filter out this point
-				}
+			const int azimuthadjustment = mrpt::round(
+				median_azimuth_diff *
+				azimuthAdjustmentFactor_[isDual ? 1 : 0][block][dsr]);
 
-				// Azimuth correction: correct for the laser rotation as a
-				// function of timing during the firings
-				double timestampadjustment =
-					0.0;  // [us] since beginning of scan
-				double blockdsr0 = 0.0;
-				double nextblockdsr0 = 1.0;
-				switch (num_lasers)
-				{
-					// VLP-16
-					case 16:
-					{
-						if (raw->laser_return_mode == Velo::RETMODE_DUAL)
-						{
-							timestampadjustment = VLP16AdjustTimeStamp(
-								block / 2, laserId, firingWithinBlock);
-							nextblockdsr0 =
-								VLP16AdjustTimeStamp(block / 2 + 1, 0, 0);
-							blockdsr0 = VLP16AdjustTimeStamp(block / 2, 0, 0);
-						}
-						else
-						{
-							timestampadjustment = VLP16AdjustTimeStamp(
-								block, laserId, firingWithinBlock);
-							nextblockdsr0 =
-								VLP16AdjustTimeStamp(block + 1, 0, 0);
-							blockdsr0 = VLP16AdjustTimeStamp(block, 0, 0);
-						}
-					}
-					break;
-					// HDL-32:
-					case 32:
-						timestampadjustment = HDL32AdjustTimeStamp(block, dsr);
-						nextblockdsr0 = HDL32AdjustTimeStamp(block + 1, 0);
-						blockdsr0 = HDL32AdjustTimeStamp(block, 0);
-						break;
-					case 64:
-						break;
-					default:
-					{
-						THROW_EXCEPTION("Error: unhandled LIDAR model!");
-					}
-				};
-
-				const int azimuthadjustment = mrpt::round(
-					median_azimuth_diff * ((timestampadjustment - blockdsr0) /
-										   (nextblockdsr0 - blockdsr0)));
-
-				const float azimuth_corrected_f =
-					azimuth_raw_f + azimuthadjustment;
-				const int azimuth_corrected =
-					((int)round(azimuth_corrected_f)) %
-					Velo::ROTATION_MAX_UNITS;
-
-				// Filter by azimuth:
-				if (!((minAzimuth_int < maxAzimuth_int &&
-					   azimuth_corrected >= minAzimuth_int &&
-					   azimuth_corrected <= maxAzimuth_int) ||
-					  (minAzimuth_int > maxAzimuth_int &&
-					   (azimuth_corrected <= maxAzimuth_int ||
-						azimuth_corrected >= minAzimuth_int))))
-					continue;
-
-				// Vertical axis mis-alignment calibration:
-				const float cos_vert_angle = mrpt::d2f(calib.cosVertCorrection);
-				const float sin_vert_angle = mrpt::d2f(calib.sinVertCorrection);
-				const float horz_offset =
-					mrpt::d2f(calib.horizontalOffsetCorrection);
-				const float vert_offset =
-					mrpt::d2f(calib.verticalOffsetCorrection);
-
-				float xy_distance = distance * cos_vert_angle;
-				if (vert_offset != .0f)
-					xy_distance += vert_offset * sin_vert_angle;
-
-				const int azimuth_corrected_for_lut =
-					(azimuth_corrected + (Velo::ROTATION_MAX_UNITS / 2)) %
-					Velo::ROTATION_MAX_UNITS;
-				const float cos_azimuth =
-					lut_sincos.ccos[azimuth_corrected_for_lut];
-				const float sin_azimuth =
-					lut_sincos.csin[azimuth_corrected_for_lut];
-
-				// Compute raw position
-				const mrpt::math::TPoint3Df pt(
-					xy_distance * cos_azimuth +
-						horz_offset * sin_azimuth,  // MRPT +X = Velodyne +Y
-					-(xy_distance * sin_azimuth -
-					  horz_offset * cos_azimuth),  // MRPT +Y = Velodyne -X
-					distance * sin_vert_angle + vert_offset);
-
-				bool add_point = true;
-				if (params.filterByROI &&
-					(pt.x > params.ROI_x_max || pt.x < params.ROI_x_min ||
-					 pt.y > params.ROI_y_max || pt.y < params.ROI_y_min ||
-					 pt.z > params.ROI_z_max || pt.z < params.ROI_z_min))
-					add_point = false;
-
-				if (params.filterBynROI &&
-					(pt.x <= params.nROI_x_max && pt.x >= params.nROI_x_min &&
-					 pt.y <= params.nROI_y_max && pt.y >= params.nROI_y_min &&
-					 pt.z <= params.nROI_z_max && pt.z >= params.nROI_z_min))
-					add_point = false;
-
-				if (!add_point) continue;
-
-				// Insert point:
-				out_pc.add_point(
-					pt.x, pt.y, pt.z,
-					raw->blocks[block].laser_returns[k].intensity(), pkt_tim,
-					azimuth_corrected_f, laserId);
-
-			}  // end for k,dsr=[0,31]
-		}  // end for each block [0,11]
-	}  // end for each data packet
-}
+			const float azimuth_corrected_f = azimuth_raw_f + azimuthadjustment;
+			const int azimuth_corrected =
+				((int)round(azimuth_corrected_f)) % Velo::ROTATION_MAX_UNITS;
 
-void Velo::generatePointCloud(
-	PointCloudStorageWrapper& dest, const TGeneratePointCloudParameters& params)
-{
-	velodyne_scan_to_pointcloud(*this, params, dest);
-}
+			// Filter by azimuth:
+			if (!((minAzimuth_int_ < maxAzimuth_int_ &&
+				   azimuth_corrected >= minAzimuth_int_ &&
+				   azimuth_corrected <= maxAzimuth_int_) ||
+				  (minAzimuth_int_ > maxAzimuth_int_ &&
+				   (azimuth_corrected <= maxAzimuth_int_ ||
+					azimuth_corrected >= minAzimuth_int_))))
+				continue;
 
-void Velo::generatePointCloud(const TGeneratePointCloudParameters& params)
-{
-	struct PointCloudStorageWrapper_Inner : public PointCloudStorageWrapper
-	{
-		Velo& me_;
-		const TGeneratePointCloudParameters& params_;
-		PointCloudStorageWrapper_Inner(
-			Velo& me, const TGeneratePointCloudParameters& p)
-			: me_(me), params_(p)
-		{
-			// Reset point cloud:
-			me_.point_cloud.clear();
+			const int azimuth_corrected_for_lut =
+				(azimuth_corrected + (Velo::ROTATION_MAX_UNITS / 2)) %
+				Velo::ROTATION_MAX_UNITS;
+
+			valid[k] = true;
+			distance[k] = dist;
+			azimuth_f[k] = azimuth_corrected_f;
+			cos_azimuth[k] = lut_sincos_->ccos[azimuth_corrected_for_lut];
+			sin_azimuth[k] = lut_sincos_->csin[azimuth_corrected_for_lut];
 		}
 
-		void resizeLaserCount(std::size_t n) override
+		// 2nd pass: compute the coordinates of all returns at once. Without
+		// branches nor indirect accesses, so the compiler can vectorize it.
+		const float* cos_vert_angle = &cosVert_[laserId0];
+		const float* sin_vert_angle = &sinVert_[laserId0];
+		const float* horz_offset = &horzOffset_[laserId0];
+		const float* vert_offset = &vertOffset_[laserId0];
+		float pt_x[Velo::SCANS_PER_FIRING], pt_y[Velo::SCANS_PER_FIRING],
+			pt_z[Velo::SCANS_PER_FIRING];
+		for (int k = 0; k < Velo::SCANS_PER_FIRING; k++)
 		{
-			me_.point_cloud.pointsForLaserID.resize(n);
+			// Vertical axis mis-alignment calibration:
+			const float xy_no_offset = distance[k] * cos_vert_angle[k];
+			const float xy_offset =
+				xy_no_offset + vert_offset[k] * sin_vert_angle[k];
+			const float xy_distance =
+				vert_offset[k] != .0f ? xy_offset : xy_no_offset;
+
+			// MRPT +X = Velodyne +Y
+			pt_x[k] = xy_distance * cos_azimuth[k] +
+					  horz_offset[k] * sin_azimuth[k];
+			// MRPT +Y = Velodyne -X
+			pt_y[k] = -(xy_distance * sin_azimuth[k] -
+						horz_offset[k] * cos_azimuth[k]);
+			pt_z[k] = distance[k] * sin_vert_angle[k] + vert_offset[k];
 		}
 
-		void reserve(std::size_t n) override
+		// 3rd pass: ROI filters and output:
+		for (int k = 0; k < Velo::SCANS_PER_FIRING; k++)
 		{
-			me_.point_cloud.reserve(n);
-			if (!me_.point_cloud.pointsForLaserID.empty())
-			{
-				const std::size_t n_per_ring =
-					100 + n / (me_.point_cloud.pointsForLaserID.size());
-				for (auto& v : me_.point_cloud.pointsForLaserID)
-					v.reserve(n_per_ring);
-			}
+			if (!valid[k]) continue;
+
+			if (params.filterByROI &&
+				(pt_x[k] > params.ROI_x_max || pt_x[k] < params.ROI_x_min ||
+				 pt_y[k] > params.ROI_y_max || pt_y[k] < params.ROI_y_min ||
+				 pt_z[k] > params.ROI_z_max || pt_z[k] < params.ROI_z_min))
+				continue;
+
+			if (params.filterBynROI &&
+				(pt_x[k] <= params.nROI_x_max && pt_x[k] >= params.nROI_x_min &&
+				 pt_y[k] <= params.nROI_y_max && pt_y[k] >= params.nROI_y_min &&
+				 pt_z[k] <= params.nROI_z_max && pt_z[k] >= params.nROI_z_min))
+				continue;
+
+			const std::size_t i = out.count++;
+			out.x[i] = pt_x[k];
+			out.y[i] = pt_y[k];
+			out.z[i] = pt_z[k];
+			out.intensity[i] = blk.laser_returns[k].intensity();
+			out.azimuth[i] = azimuth_f[k];
+			out.laser_id[i] = static_cast<uint16_t>(laserId0 + k);
 		}
+	}  // end for each block [0,11]
+}
+}  // namespace
 
-		void add_point(
-			float pt_x, float pt_y, float pt_z, uint8_t pt_intensity,
-			const mrpt::system::TTimeStamp& tim, const float azimuth,
-			uint16_t laser_id) override
+std::size_t Velo::generatePointCloudBatch(
+	const std::function<void(const TDecodedPoints&)>& sink,
+	const TGeneratePointCloudParameters& params) const
+{
+	MRPT_START
+
+	const VelodyneDecoder decoder(*this, params);
+	const std::size_t nPkts = scan_packets.size();
+
+	const auto emit = [&](std::size_t iPkt, std::size_t outIdx,
+						  const PacketPoints& pts) {
+		TDecodedPoints d;
+		d.packetIndex = iPkt;
+		d.outIdx = outIdx;
+		d.count = pts.count;
+		d.timestamp = pts.timestamp;
+		d.x = pts.x;
+		d.y = pts.y;
+		d.z = pts.z;
+		d.intensity = pts.intensity;
+		d.azimuth = pts.azimuth;
+		d.laser_id = pts.laser_id;
+		sink(d);
+	};
+
+	const unsigned int numThreads =
+		mrpt::WorkerThreadsPool::clampNumThreads(params.numThreads);
+
+	if (numThreads == 1 || nPkts < 2)
+	{
+		// Each packet is handed over to the sink while still in the cache:
+		PacketPoints pts;
+		std::size_t outIdx = 0;
+		for (std::size_t iPkt = 0; iPkt < nPkts; iPkt++)
 		{
-			const auto idx = me_.point_cloud.x.size();
-			me_.point_cloud.x.push_back(pt_x);
-			me_.point_cloud.y.push_back(pt_y);
-			me_.point_cloud.z.push_back(pt_z);
-			me_.point_cloud.intensity.push_back(pt_intensity);
-			if (params_.generatePerPointTimestamp)
-			{
-				me_.point_cloud.timestamp.push_back(tim);
-			}
-			if (params_.generatePerPointAzimuth)
-			{
-				const int azimuth_corrected =
-					round(azimuth) % Velo::ROTATION_MAX_UNITS;
-				me_.point_cloud.azimuth.push_back(
-					azimuth_corrected * ROTATION_RESOLUTION);
-			}
-			me_.point_cloud.laser_id.push_back(laser_id);
-			if (params_.generatePointsForLaserID)
-				me_.point_cloud.pointsForLaserID[laser_id].push_back(idx);
+			decoder.decodePacket(iPkt, pts);
+			emit(iPkt, outIdx, pts);
+			outIdx += pts.count;
 		}
-	};
+		return outIdx;
+	}
+
+	// Parallel version: the output index of each packet is only known once
+	// all previous packets have been decoded, so keep all of them:
+	std::vector<PacketPoints> pktPoints(nPkts);
+	const std::size_t grain = (nPkts + numThreads - 1) / numThreads;
+	mrpt::WorkerThreadsPool::sharedPool().parallel_for(
+		0, nPkts,
+		[&](std::size_t first, std::size_t last) {
+			for (std::size_t i = first; i < last; i++)
+				decoder.decodePacket(i, pktPoints[i]);
+		},
+		grain);
+
+	std::vector<std::size_t> outIdx(nPkts + 1, 0);
+	for (std::size_t i = 0; i < nPkts; i++)
+		outIdx[i + 1] = outIdx[i] + pktPoints[i].count;
+
+	mrpt::WorkerThreadsPool::sharedPool().parallel_for(
+		0, nPkts,
+		[&](std::size_t first, std::size_t last) {
+			for (std::size_t i = first; i < last; i++)
+				emit(i, outIdx[i], pktPoints[i]);
+		},
+		grain);
+
+	return outIdx[nPkts];
+
+	MRPT_END
+}
+
+void Velo::generatePointCloud(
+	PointCloudStorageWrapper& dest, const TGeneratePointCloudParameters& params)
+{
+	dest.resizeLaserCount(calibration.laser_corrections.size());
+	dest.reserve(
+		Velo::SCANS_PER_BLOCK * scan_packets.size() * Velo::BLOCKS_PER_PACKET +
+		16);
 
-	PointCloudStorageWrapper_Inner my_pc_wrap(*this, params);
-	point_cloud.clear();
+	// Custom storage may not be thread-safe:
+	auto serialParams = params;
+	serialParams.numThreads = 1;
+
+	generatePointCloudBatch(
+		[&](const TDecodedPoints& pts) {
+			for (std::size_t i = 0; i < pts.count; i++)
+				dest.add_point(
+					pts.x[i], pts.y[i], pts.z[i], pts.intensity[i],
+					pts.timestamp, pts.azimuth[i], pts.laser_id[i]);
+		},
+		serialParams);
+}
 
-	generatePointCloud(my_pc_wrap, params);
+void Velo::generatePointCloud(const TGeneratePointCloudParameters& params)
+{
+	auto& pc = point_cloud;
+
+	// Reset point cloud and make room for the worst case:
+	pc.clear();
+	const std::size_t maxPts = maxPointCount();
+	pc.x.resize(maxPts);
+	pc.y.resize(maxPts);
+	pc.z.resize(maxPts);
+	pc.intensity.resize(maxPts);
+	pc.laser_id.resize(maxPts);
+	if (params.generatePerPointTimestamp) pc.timestamp.resize(maxPts);
+	if (params.generatePerPointAzimuth) pc.azimuth.resize(maxPts);
+
+	const std::size_t n = generatePointCloudBatch(
+		[&](const TDecodedPoints& pts) {
+			const std::size_t i0 = pts.outIdx, n_pts = pts.count;
+			std::copy(pts.x, pts.x + n_pts, &pc.x[i0]);
+			std::copy(pts.y, pts.y + n_pts, &pc.y[i0]);
+			std::copy(pts.z, pts.z + n_pts, &pc.z[i0]);
+			std::copy(pts.intensity, pts.intensity + n_pts, &pc.intensity[i0]);
+			std::copy(pts.laser_id, pts.laser_id + n_pts, &pc.laser_id[i0]);
+			if (params.generatePerPointTimestamp)
+				std::fill_n(&pc.timestamp[i0], n_pts, pts.timestamp);
+			if (params.generatePerPointAzimuth)
+			{
+				for (std::size_t i = 0; i < n_pts; i++)
+				{
+					const int azimuth_corrected =
+						round(pts.azimuth[i]) % Velo::ROTATION_MAX_UNITS;
+					pc.azimuth[i0 + i] =
+						azimuth_corrected * ROTATION_RESOLUTION;
+				}
+			}
+		},
+		params);
+
+	pc.x.resize(n);
+	pc.y.resize(n);
+	pc.z.resize(n);
+	pc.intensity.resize(n);
+	pc.laser_id.resize(n);
+	if (params.generatePerPointTimestamp) pc.timestamp.resize(n);
+	if (params.generatePerPointAzimuth) pc.azimuth.resize(n);
+
+	pc.pointsForLaserID.resize(calibration.laser_corrections.size());
+	if (params.generatePointsForLaserID)
+	{
+		for (std::size_t i = 0; i < n; i++)
+			pc.pointsForLaserID[pc.laser_id[i]].push_back(i);
+	}
 }
 
 void Velo::generatePointCloudAlongSE3Trajectory(
@@ -555,7 +690,7 @@ void Velo::generatePointCloudAlongSE3Trajectory(
 
 	PointCloudStorageWrapper_SE3_Interp my_pc_wrap(
 		*this, vehicle_path, out_points, results_stats);
-	velodyne_scan_to_pointcloud(*this, params, my_pc_wrap);
+	generatePointCloud(my_pc_wrap, params);
 }
 
 void Velo::TPointCloud::clear()
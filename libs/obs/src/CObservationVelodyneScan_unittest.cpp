@@ -0,0 +1,176 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2020, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include <gtest/gtest.h>
+#include <mrpt/core/WorkerThreadsPool.h>
+#include <mrpt/core/round.h>
+#include <mrpt/obs/CObservationVelodyneScan.h>
+#include <mrpt/obs/CRawlog.h>
+#include <mrpt/system/filesystem.h>
+#include <test_mrpt_common.h>
+
+using Velo = mrpt::obs::CObservationVelodyneScan;
+
+static Velo::Ptr loadTestScan()
+{
+	const std::string fil = mrpt::UNITTEST_BASEDIR +
+							"/share/mrpt/datasets/test_velodyne_VLP16.rawlog";
+	if (!mrpt::system::fileExists(fil))
+	{
+		std::cerr << "WARNING: Skipping test due to missing file: " << fil
+				  << "\n";
+		return {};
+	}
+	mrpt::obs::CRawlog rawlog;
+	EXPECT_TRUE(rawlog.loadFromRawLogFile(fil));
+	return rawlog.asObservation<Velo>(0);
+}
+
+TEST(CObservationVelodyneScan, generatePointCloud)
+{
+	auto obs = loadTestScan();
+	if (!obs) return;
+
+	struct TestCase
+	{
+		std::function<void(Velo::TGeneratePointCloudParameters&)> setParams;
+		size_t count;
+		double sum_x, sum_y, sum_z;
+	};
+	const std::vector<TestCase> tests = {
+		{[](auto&) {}, 11305, 2211.9435, 4562.0960, -2268.6641},
+		{[](auto& p) { p.filterOutIsolatedPoints = true; }, 2146, -2945.1531,
+		 326.2885, -440.0074},
+		{[](auto& p) {
+			 p.minAzimuth_deg = 300;
+			 p.maxAzimuth_deg = 60;
+		 },
+		 4194, 42637.6339, 3331.4990, -1000.8278},
+		{[](auto& p) {
+			 p.filterByROI = true;
+			 p.ROI_x_min = p.ROI_y_min = -5;
+			 p.ROI_x_max = p.ROI_y_max = 5;
+			 p.ROI_z_min = -1;
+			 p.ROI_z_max = 1;
+		 },
+		 2300, 1600.5343, -2316.5047, 439.7954},
+		{[](auto& p) {
+			 p.filterBynROI = true;
+			 p.nROI_x_min = p.nROI_y_min = -5;
+			 p.nROI_x_max = p.nROI_y_max = 5;
+			 p.nROI_z_min = -1;
+			 p.nROI_z_max = 1;
+		 },
+		 9005, 611.4091, 6878.6008, -2708.4596},
+	};
+
+	for (const auto& t : tests)
+	{
+		Velo::TGeneratePointCloudParameters p;
+		p.generatePerPointAzimuth = true;
+		p.generatePerPointTimestamp = true;
+		p.generatePointsForLaserID = true;
+		t.setParams(p);
+		obs->generatePointCloud(p);
+		const auto& pc = obs->point_cloud;
+
+		ASSERT_EQ(pc.size(), t.count);
+		EXPECT_EQ(pc.intensity.size(), t.count);
+		EXPECT_EQ(pc.azimuth.size(), t.count);
+		EXPECT_EQ(pc.timestamp.size(), t.count);
+		EXPECT_EQ(pc.laser_id.size(), t.count);
+		EXPECT_EQ(pc.pointsForLaserID.size(), 16U);
+		double sx = 0, sy = 0, sz = 0;
+		for (size_t i = 0; i < pc.size(); i++)
+		{
+			sx += pc.x[i];
+			sy += pc.y[i];
+			sz += pc.z[i];
+		}
+		EXPECT_NEAR(sx, t.sum_x, 1e-2);
+		EXPECT_NEAR(sy, t.sum_y, 1e-2);
+		EXPECT_NEAR(sz, t.sum_z, 1e-2);
+
+		size_t nRings = 0;
+		for (const auto& idxs : pc.pointsForLaserID)
+		{
+			nRings += idxs.size();
+			for (const auto idx : idxs)
+				EXPECT_EQ(pc.laser_id.at(idx), pc.laser_id.at(idxs[0]));
+		}
+		EXPECT_EQ(nRings, t.count);
+	}
+}
+
+TEST(CObservationVelodyneScan, generatePointCloud_threads_and_wrapper)
+{
+	auto obs = loadTestScan();
+	if (!obs) return;
+
+	// Dual return mode, to also cover its filters:
+	for (auto& pkt : obs->scan_packets)
+		pkt.laser_return_mode = Velo::RETMODE_DUAL;
+
+	Velo::TGeneratePointCloudParameters p;
+	p.generatePerPointAzimuth = true;
+	p.generatePerPointTimestamp = true;
+	p.dualKeepLast = false;
+	obs->generatePointCloud(p);
+	const auto ref = obs->point_cloud;
+	ASSERT_GT(ref.size(), 0U);
+
+	// Run the parallel decoding even in single-core machines:
+	const auto formerNumCores = mrpt::WorkerThreadsPool::overrideNumCores(3);
+
+	for (const unsigned int numThreads : {0U, 3U})
+	{
+		p.numThreads = numThreads;
+		obs->generatePointCloud(p);
+		const auto& pc = obs->point_cloud;
+		EXPECT_EQ(pc.x, ref.x);
+		EXPECT_EQ(pc.y, ref.y);
+		EXPECT_EQ(pc.z, ref.z);
+		EXPECT_EQ(pc.intensity, ref.intensity);
+		EXPECT_EQ(pc.azimuth, ref.azimuth);
+		EXPECT_EQ(pc.timestamp, ref.timestamp);
+		EXPECT_EQ(pc.laser_id, ref.laser_id);
+	}
+	mrpt::WorkerThreadsPool::overrideNumCores(formerNumCores);
+
+	// Custom storage:
+	struct MyStorage : public Velo::PointCloudStorageWrapper
+	{
+		Velo::TPointCloud pc;
+		void add_point(
+			float pt_x, float pt_y, float pt_z, uint8_t pt_intensity,
+			const mrpt::system::TTimeStamp& tim, const float azimuth,
+			uint16_t laser_id) override
+		{
+			pc.x.push_back(pt_x);
+			pc.y.push_back(pt_y);
+			pc.z.push_back(pt_z);
+			pc.intensity.push_back(pt_intensity);
+			pc.timestamp.push_back(tim);
+			// In raw units here, in degrees in the point_cloud:
+			pc.azimuth.push_back(
+				(mrpt::round(azimuth) % Velo::ROTATION_MAX_UNITS) *
+				Velo::ROTATION_RESOLUTION);
+			pc.laser_id.push_back(laser_id);
+		}
+	};
+	MyStorage storage;
+	obs->generatePointCloud(storage, p);
+	EXPECT_EQ(storage.pc.x, ref.x);
+	EXPECT_EQ(storage.pc.y, ref.y);
+	EXPECT_EQ(storage.pc.z, ref.z);
+	EXPECT_EQ(storage.pc.intensity, ref.intensity);
+	EXPECT_EQ(storage.pc.azimuth, ref.azimuth);
+	EXPECT_EQ(storage.pc.timestamp, ref.timestamp);
+	EXPECT_EQ(storage.pc.laser_id, ref.laser_id);
+}
@@ -12,6 +12,10 @@
 #include <mrpt/io/CFileGZInputStream.h>
 #include <mrpt/io/CFileGZOutputStream.h>
 #include <mrpt/io/CFileInputStream.h>
+#include <mrpt/io/CFileMMapInputStream.h>
+#include <mrpt/io/CFileOutputStream.h>
+#include <mrpt/io/CFileZstdInputStream.h>
+#include <mrpt/io/CMemoryStream.h>
 #include <mrpt/obs/CRawlog.h>
 #include <mrpt/serialization/CArchive.h>
 #include <mrpt/system/filesystem.h>
@@ -29,18 +33,23 @@ void CRawlog::clear()
 {
 	m_seqOfActObs.clear();
 	m_commentTexts.text.clear();
+	m_lazyFile.reset();
+	m_lazyFileName.clear();
+	m_lazyIndex.clear();
 }
 
 void CRawlog::insert(CSensoryFrame& observations)
 {
 	m_seqOfActObs.push_back(std::dynamic_pointer_cast<CSerializable>(
 		observations.duplicateGetSmartPtr()));
+	if (isLazy()) m_lazyIndex.resize(m_seqOfActObs.size());
 }
 
 void CRawlog::insert(CActionCollection& actions)
 {
 	m_seqOfActObs.push_back(std::dynamic_pointer_cast<CSerializable>(
 		actions.duplicateGetSmartPtr()));
+	if (isLazy()) m_lazyIndex.resize(m_seqOfActObs.size());
 }
 void CRawlog::insert(const CSerializable::Ptr& obj)
 {
@@ -51,7 +60,10 @@ void CRawlog::insert(const CSerializable::Ptr& obj)
 		m_commentTexts = *o;
 	}
 	else
+	{
 		m_seqOfActObs.push_back(obj);
+		if (isLazy()) m_lazyIndex.resize(m_seqOfActObs.size());
+	}
 }
 
 void CRawlog::insert(CAction& action)
@@ -59,6 +71,7 @@ void CRawlog::insert(CAction& action)
 	CActionCollection::Ptr temp = std::make_shared<CActionCollection>();
 	temp->insert(action);
 	m_seqOfActObs.push_back(temp);
+	if (isLazy()) m_lazyIndex.resize(m_seqOfActObs.size());
 }
 
 size_t CRawlog::size() const { return m_seqOfActObs.size(); }
@@ -68,10 +81,8 @@ CActionCollection::Ptr CRawlog::getAsAction(size_t index) const
 
 	if (index >= m_seqOfActObs.size()) THROW_EXCEPTION("Index out of bounds");
 
-	CSerializable::Ptr obj = m_seqOfActObs[index];
-
-	if (obj->GetRuntimeClass() == CLASS_ID(CActionCollection))
-		return std::dynamic_pointer_cast<CActionCollection>(obj);
+	if (entryClass(index) == CLASS_ID(CActionCollection))
+		return std::dynamic_pointer_cast<CActionCollection>(entry(index));
 	else
 		THROW_EXCEPTION_FMT(
 			"Element at index %i is not a CActionCollection", (int)index);
@@ -84,10 +95,8 @@ CObservation::Ptr CRawlog::getAsObservation(size_t index) const
 
 	if (index >= m_seqOfActObs.size()) THROW_EXCEPTION("Index out of bounds");
 
-	CSerializable::Ptr obj = m_seqOfActObs[index];
-
-	if (obj->GetRuntimeClass()->derivedFrom(CLASS_ID(CObservation)))
-		return std::dynamic_pointer_cast<CObservation>(obj);
+	if (entryClass(index)->derivedFrom(CLASS_ID(CObservation)))
+		return std::dynamic_pointer_cast<CObservation>(entry(index));
 	else
 		THROW_EXCEPTION_FMT(
 			"Element at index %i is not a CObservation", (int)index);
@@ -99,7 +108,7 @@ CSerializable::Ptr CRawlog::getAsGeneric(size_t index) const
 	MRPT_START
 	if (index >= m_seqOfActObs.size()) THROW_EXCEPTION("Index out of bounds");
 
-	return m_seqOfActObs[index];
+	return entry(index);
 	MRPT_END
 }
 
@@ -108,13 +117,13 @@ CRawlog::TEntryType CRawlog::getType(size_t index) const
 	MRPT_START
 	if (index >= m_seqOfActObs.size()) THROW_EXCEPTION("Index out of bounds");
 
-	const CSerializable::Ptr& obj = m_seqOfActObs[index];
+	const auto* cls = entryClass(index);
 
-	if (obj->GetRuntimeClass()->derivedFrom(CLASS_ID(CObservation)))
+	if (cls->derivedFrom(CLASS_ID(CObservation)))
 		return etObservation;
-	else if (obj->GetRuntimeClass() == CLASS_ID(CActionCollection))
+	else if (cls == CLASS_ID(CActionCollection))
 		return etActionCollection;
-	else if (obj->GetRuntimeClass() == CLASS_ID(CSensoryFrame))
+	else if (cls == CLASS_ID(CSensoryFrame))
 		return etSensoryFrame;
 	else
 		return etOther;
@@ -127,10 +136,8 @@ CSensoryFrame::Ptr CRawlog::getAsObservations(size_t index) const
 	MRPT_START
 	if (index >= m_seqOfActObs.size()) THROW_EXCEPTION("Index out of bounds");
 
-	CSerializable::Ptr obj = m_seqOfActObs[index];
-
-	if (obj->GetRuntimeClass()->derivedFrom(CLASS_ID(CSensoryFrame)))
-		return std::dynamic_pointer_cast<CSensoryFrame>(obj);
+	if (entryClass(index)->derivedFrom(CLASS_ID(CSensoryFrame)))
+		return std::dynamic_pointer_cast<CSensoryFrame>(entry(index));
 	else
 		THROW_EXCEPTION_FMT(
 			"Element at index %i is not a CSensoryFrame", (int)index);
@@ -141,7 +148,7 @@ uint8_t CRawlog::serializeGetVersion() const { return 1; }
 void CRawlog::serializeTo(mrpt::serialization::CArchive& out) const
 {
 	out.WriteAs<uint32_t>(m_seqOfActObs.size());
-	for (const auto& a : m_seqOfActObs) out << a;
+	for (size_t i = 0; i < m_seqOfActObs.size(); i++) out << entry(i);
 	out << m_commentTexts;
 }
 
@@ -243,11 +250,242 @@ bool CRawlog::loadFromRawLogFile(
 	return true;
 }
 
+namespace
+{
+/** Identifies index files, and their format version */
+const char* RAWLOG_INDEX_MAGIC = "MRPT_RAWLOG_INDEX";
+const uint8_t RAWLOG_INDEX_VERSION = 0;
+}  // namespace
+
+std::string CRawlog::getIndexFileName(const std::string& rawlogFile)
+{
+	return rawlogFile + std::string(".idx");
+}
+
+bool CRawlog::buildIndex(const std::string& rawlogFile, TIndex& index)
+{
+	index.clear();
+
+	CFileGZInputStream fi;
+	if (!fi.open(rawlogFile)) return false;
+	auto fs = archiveFrom(fi);
+
+	for (;;)
+	{
+		TIndexEntry e;
+		e.offset = fi.getPosition();
+
+		CSerializable::Ptr obj;
+		try
+		{
+			obj = fs.ReadObject();
+		}
+		catch (CExceptionEOF&)
+		{  // EOF, just finish the loop
+			break;
+		}
+		catch (const std::exception& ex)
+		{
+			std::cerr << mrpt::exception_to_str(ex) << std::endl;
+			break;
+		}
+		if (!obj) break;
+
+		e.length = fi.getPosition() - e.offset;
+		e.classId = obj->GetRuntimeClass();
+		e.className = e.classId->className;
+		if (auto o = std::dynamic_pointer_cast<CObservation>(obj); o)
+		{
+			e.timestamp = o->timestamp;
+			e.sensorLabel = o->sensorLabel;
+		}
+		index.emplace_back(std::move(e));
+	}
+	return true;
+}
+
+bool CRawlog::saveIndexFile(
+	const std::string& rawlogFile, const TIndex& index,
+	const std::string& indexFile)
+{
+	try
+	{
+		CFileOutputStream fo;
+		if (!fo.open(
+				indexFile.empty() ? getIndexFileName(rawlogFile) : indexFile))
+			return false;
+		auto f = archiveFrom(fo);
+
+		f << std::string(RAWLOG_INDEX_MAGIC);
+		f.WriteAs<uint8_t>(RAWLOG_INDEX_VERSION);
+		f.WriteAs<uint64_t>(mrpt::system::getFileSize(rawlogFile));
+		f.WriteAs<int64_t>(mrpt::system::getFileModificationTime(rawlogFile));
+		f.WriteAs<uint64_t>(index.size());
+		for (const auto& e : index)
+			f << e.offset << e.length << e.timestamp << e.className
+			  << e.sensorLabel;
+		return true;
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << mrpt::exception_to_str(e) << std::endl;
+		return false;
+	}
+}
+
+bool CRawlog::loadIndexFile(
+	const std::string& rawlogFile, TIndex& index, const std::string& indexFile)
+{
+	index.clear();
+
+	const std::string idxFile =
+		indexFile.empty() ? getIndexFileName(rawlogFile) : indexFile;
+	if (!mrpt::system::fileExists(idxFile)) return false;
+
+	try
+	{
+		CFileInputStream fi;
+		if (!fi.open(idxFile)) return false;
+		auto f = archiveFrom(fi);
+
+		// Not an index file, or a different version:
+		if (f.ReadAs<std::string>() != RAWLOG_INDEX_MAGIC) return false;
+		if (f.ReadAs<uint8_t>() != RAWLOG_INDEX_VERSION) return false;
+
+		// Is it up to date?
+		if (f.ReadAs<uint64_t>() != mrpt::system::getFileSize(rawlogFile) ||
+			f.ReadAs<int64_t>() !=
+				mrpt::system::getFileModificationTime(rawlogFile))
+			return false;
+
+		index.resize(f.ReadAs<uint64_t>());
+		for (auto& e : index)
+		{
+			f >> e.offset >> e.length >> e.timestamp >> e.className >>
+				e.sensorLabel;
+			e.classId = mrpt::rtti::findRegisteredClass(e.className);
+		}
+		return true;
+	}
+	catch (const std::exception&)
+	{
+		// Corrupt or truncated file:
+		index.clear();
+		return false;
+	}
+}
+
+bool CRawlog::loadFromRawLogFileLazy(
+	const std::string& fileName, bool non_obs_objects_are_legal,
+	bool save_index_file)
+{
+	auto file = std::make_shared<CFileMMapInputStream>();
+	if (!file->open(fileName)) return false;
+
+	// gz or zstd-compressed files cannot be read at random offsets:
+	if ((file->size() >= 2 && file->data()[0] == 0x1f &&
+		 file->data()[1] == 0x8b) ||
+		CFileZstdInputStream::isZstdFile(fileName))
+		return loadFromRawLogFile(fileName, non_obs_objects_are_legal);
+
+	TIndex index;
+	if (!loadIndexFile(fileName, index))
+	{
+		if (!buildIndex(fileName, index)) return false;
+		if (save_index_file) saveIndexFile(fileName, index);
+	}
+
+	clear();  // Clear first
+	m_lazyFile = file;
+	m_lazyFileName = fileName;
+
+	// The same rules as in loadFromRawLogFile(), using only the index:
+	for (const auto& e : index)
+	{
+		// Unknown class, or an index not matching the file:
+		if (!e.classId || e.offset + e.length > file->size()) break;
+
+		bool add_obj = false;
+		if (e.classId == CLASS_ID(CRawlog))
+		{
+			// It is an entire object: it has to be loaded as a whole
+			return loadFromRawLogFile(fileName, non_obs_objects_are_legal);
+		}
+		else if (e.classId == CLASS_ID(CObservationComment))
+		{
+			CMemoryStream buf;
+			buf.assignMemoryNotOwn(file->data() + e.offset, e.length);
+			auto f = archiveFrom(buf);
+			f >> m_commentTexts;
+		}
+		else if (
+			e.classId->derivedFrom(CLASS_ID(CObservation)) ||
+			e.classId == CLASS_ID(CSensoryFrame) ||
+			e.classId == CLASS_ID(CActionCollection) ||
+			non_obs_objects_are_legal)
+		{
+			add_obj = true;
+		}
+		else
+			break;
+
+		if (add_obj)
+		{
+			m_seqOfActObs.emplace_back();
+			m_lazyIndex.push_back(e);
+		}
+	}
+	return true;
+}
+
+void CRawlog::unloadEntry(size_t index)
+{
+	MRPT_START
+	if (index >= m_seqOfActObs.size()) THROW_EXCEPTION("Index out of bounds");
+	if (isLazy() && m_lazyIndex[index].length > 0)
+		m_seqOfActObs[index].reset();
+	MRPT_END
+}
+
+const CSerializable::Ptr& CRawlog::entry(size_t index) const
+{
+	auto& obj = m_seqOfActObs[index];
+	if (!obj && isLazy())
+	{
+		const auto& e = m_lazyIndex[index];
+		CMemoryStream buf;
+		buf.assignMemoryNotOwn(m_lazyFile->data() + e.offset, e.length);
+		obj = archiveFrom(buf).ReadObject();
+	}
+	return obj;
+}
+
+const mrpt::rtti::TRuntimeClassId* CRawlog::entryClass(size_t index) const
+{
+	const auto& obj = m_seqOfActObs[index];
+	if (obj) return obj->GetRuntimeClass();
+	ASSERT_(isLazy());
+	return m_lazyIndex[index].classId;
+}
+
+mrpt::system::TTimeStamp CRawlog::entryTimestamp(size_t index) const
+{
+	if (!entryClass(index)->derivedFrom(CLASS_ID(CObservation)))
+		THROW_EXCEPTION("Element found which is not derived from CObservation");
+
+	const auto& obj = m_seqOfActObs[index];
+	const TTimeStamp t = obj ? dynamic_cast<CObservation&>(*obj).timestamp
+							 : m_lazyIndex[index].timestamp;
+	ASSERT_(t != INVALID_TIMESTAMP);
+	return t;
+}
+
 void CRawlog::remove(size_t index)
 {
 	MRPT_START
 	if (index >= m_seqOfActObs.size()) THROW_EXCEPTION("Index out of bounds");
 	m_seqOfActObs.erase(m_seqOfActObs.begin() + index);
+	if (isLazy()) m_lazyIndex.erase(m_lazyIndex.begin() + index);
 	MRPT_END
 }
 
@@ -260,6 +498,10 @@ void CRawlog::remove(size_t first_index, size_t last_index)
 	m_seqOfActObs.erase(
 		m_seqOfActObs.begin() + first_index,
 		m_seqOfActObs.begin() + last_index + 1);
+	if (isLazy())
+		m_lazyIndex.erase(
+			m_lazyIndex.begin() + first_index,
+			m_lazyIndex.begin() + last_index + 1);
 	MRPT_END
 }
 
@@ -267,10 +509,25 @@ bool CRawlog::saveToRawLogFile(const std::string& fileName) const
 {
 	try
 	{
+		// The mapped file cannot be overwritten while reading from it:
+		ASSERTMSG_(
+			!isLazy() || fileName != m_lazyFileName,
+			"Cannot overwrite the file of a rawlog opened in lazy mode");
+
 		CFileGZOutputStream fo(fileName);
 		auto f = archiveFrom(fo);
 		if (!m_commentTexts.text.empty()) f << m_commentTexts;
-		for (const auto& m_seqOfActOb : m_seqOfActObs) f << *m_seqOfActOb;
+		for (size_t i = 0; i < m_seqOfActObs.size(); i++)
+		{
+			if (!m_seqOfActObs[i] && isLazy())
+			{
+				// Not deserialized yet: just copy its bytes
+				const auto& e = m_lazyIndex[i];
+				fo.Write(m_lazyFile->data() + e.offset, e.length);
+			}
+			else
+				f << *m_seqOfActObs[i];
+		}
 		return true;
 	}
 	catch (const std::exception& e)
@@ -285,6 +542,9 @@ void CRawlog::swap(CRawlog& obj)
 	if (this == &obj) return;
 	m_seqOfActObs.swap(obj.m_seqOfActObs);
 	std::swap(m_commentTexts, obj.m_commentTexts);
+	m_lazyFile.swap(obj.m_lazyFile);
+	m_lazyFileName.swap(obj.m_lazyFileName);
+	m_lazyIndex.swap(obj.m_lazyIndex);
 }
 
 bool CRawlog::readActionObservationPair(
@@ -418,38 +678,23 @@ void CRawlog::findObservationsByClassInRange(
 
 	out_found.clear();
 
-	if (m_seqOfActObs.empty()) return;
-
 	// Find the first appearance of time_start:
+	// (In lazy mode, timestamps are read from the index, so this does not
+	// deserialize any object)
 	// ---------------------------------------------------
-	auto first = m_seqOfActObs.begin();
-	const auto last = m_seqOfActObs.end();
+	size_t first = 0;
+	const size_t last = m_seqOfActObs.size();
 	{
 		// The following is based on lower_bound:
-		size_t count, step;
-		count = std::distance(first, last);
+		size_t count = last - first;
 		while (count > 0)
 		{
-			auto it = first;
-			step = count / 2;
-			std::advance(it, step);
-
-			// The comparison function:
-			TTimeStamp this_timestamp;
-			if ((*it)->GetRuntimeClass()->derivedFrom(CLASS_ID(CObservation)))
-			{
-				CObservation::Ptr o =
-					std::dynamic_pointer_cast<CObservation>(*it);
-				this_timestamp = o->timestamp;
-				ASSERT_(this_timestamp != INVALID_TIMESTAMP);
-			}
-			else
-				THROW_EXCEPTION(
-					"Element found which is not derived from CObservation");
+			const size_t step = count / 2;
+			const size_t it = first + step;
 
-			if (this_timestamp < time_start)  // *it < time_start
+			if (entryTimestamp(it) < time_start)  // *it < time_start
 			{
-				first = ++it;
+				first = it + 1;
 				count -= step + 1;
 			}
 			else
@@ -459,31 +704,15 @@ void CRawlog::findObservationsByClassInRange(
 	}
 
 	// Iterate until we get out of the time window:
-	while (first != last)
+	for (; first != last; first++)
 	{
-		TTimeStamp this_timestamp;
-		if ((*first)->GetRuntimeClass()->derivedFrom(CLASS_ID(CObservation)))
-		{
-			CObservation::Ptr o =
-				std::dynamic_pointer_cast<CObservation>(*first);
-			this_timestamp = o->timestamp;
-			ASSERT_(this_timestamp != INVALID_TIMESTAMP);
-
-			if (this_timestamp < time_end)
-			{
-				if (o->GetRuntimeClass()->derivedFrom(class_type))
-					out_found.insert(TTimeObservationPair(this_timestamp, o));
-			}
-			else
-			{
-				break;  // end of time window!
-			}
-		}
-		else
-			THROW_EXCEPTION(
-				"Element found which is not derived from CObservation");
+		const TTimeStamp this_timestamp = entryTimestamp(first);
+		if (this_timestamp >= time_end) break;  // end of time window!
 
-		first++;
+		if (entryClass(first)->derivedFrom(class_type))
+			out_found.insert(TTimeObservationPair(
+				this_timestamp,
+				std::dynamic_pointer_cast<CObservation>(entry(first))));
 	}
 
 	MRPT_END
@@ -2,3 +2,200 @@
 #include <mrpt/obs/CRawlog.h>
 
 template class mrpt::CTraitsTest<mrpt::obs::CRawlog>;
+
+#include <gtest/gtest.h>
+#include <mrpt/config.h>
+#include <mrpt/io/CFileOutputStream.h>
+#include <mrpt/io/CFileZstdOutputStream.h>
+#include <mrpt/io/vector_loadsave.h>
+#include <mrpt/obs/CObservation2DRangeScan.h>
+#include <mrpt/obs/CObservationOdometry.h>
+#include <mrpt/obs/stock_observations.h>
+#include <mrpt/serialization/CArchive.h>
+#include <mrpt/system/filesystem.h>
+
+using namespace mrpt::obs;
+
+namespace
+{
+// Writes a non-compressed rawlog with a comment and N observations,
+// alternating 2D scans and odometry, one every 0.1 seconds:
+void writeTestRawlog(const std::string& fileName, size_t N)
+{
+	mrpt::io::CFileOutputStream fo(fileName);
+	auto f = mrpt::serialization::archiveFrom(fo);
+
+	CObservationComment comment;
+	comment.text = "test comment";
+	f << comment;
+
+	const auto t0 = mrpt::Clock::now();
+	for (size_t i = 0; i < N; i++)
+	{
+		const auto t = t0 + std::chrono::milliseconds(100 * i);
+		if (i % 2 == 0)
+		{
+			CObservation2DRangeScan scan;
+			stock_observations::example2DRangeScan(scan);
+			scan.timestamp = t;
+			scan.sensorLabel = "LASER";
+			f << scan;
+		}
+		else
+		{
+			CObservationOdometry odo;
+			odo.odometry = mrpt::poses::CPose2D(0.1 * i, 0, 0);
+			odo.timestamp = t;
+			odo.sensorLabel = "ODOMETRY";
+			f << odo;
+		}
+	}
+}
+}  // namespace
+
+TEST(CRawlog, loadFromRawLogFileLazy)
+{
+	const std::string fil = mrpt::system::getTempFileName() + ".rawlog";
+	const size_t N = 100;
+	writeTestRawlog(fil, N);
+
+	CRawlog eager, lazy;
+	ASSERT_TRUE(eager.loadFromRawLogFile(fil));
+	ASSERT_TRUE(lazy.loadFromRawLogFileLazy(fil));
+	EXPECT_FALSE(eager.isLazy());
+	EXPECT_TRUE(lazy.isLazy());
+	EXPECT_TRUE(mrpt::system::fileExists(CRawlog::getIndexFileName(fil)));
+
+	ASSERT_EQ(lazy.size(), N);
+	ASSERT_EQ(eager.size(), N);
+	EXPECT_EQ(lazy.getCommentText(), "test comment");
+
+	// Time-range queries, without deserializing the rest of entries:
+	const auto t0 = eager.getAsObservation(0)->timestamp;
+	TListTimeAndObservations foundEager, foundLazy;
+	const auto tStart = t0 + std::chrono::milliseconds(2050),
+			   tEnd = t0 + std::chrono::milliseconds(4000);
+	eager.findObservationsByClassInRange(
+		tStart, tEnd, CLASS_ID(CObservationOdometry), foundEager);
+	lazy.findObservationsByClassInRange(
+		tStart, tEnd, CLASS_ID(CObservationOdometry), foundLazy);
+	ASSERT_EQ(foundLazy.size(), 10U);
+	ASSERT_EQ(foundLazy.size(), foundEager.size());
+	for (auto itE = foundEager.begin(), itL = foundLazy.begin();
+		 itE != foundEager.end(); ++itE, ++itL)
+	{
+		EXPECT_EQ(itE->first, itL->first);
+		EXPECT_EQ(itL->second->sensorLabel, "ODOMETRY");
+		EXPECT_EQ(itE->second->timestamp, itL->second->timestamp);
+	}
+
+	// Random and sequential access:
+	EXPECT_EQ(lazy.getType(N - 1), CRawlog::etObservation);
+	auto scan = lazy.asObservation<CObservation2DRangeScan>(50);
+	EXPECT_EQ(scan->sensorLabel, "LASER");
+	EXPECT_EQ(
+		scan->getScanSize(),
+		eager.asObservation<CObservation2DRangeScan>(50)->getScanSize());
+	size_t i = 0;
+	for (auto it = lazy.begin(); it != lazy.end(); ++it, ++i)
+	{
+		EXPECT_EQ(it.getType(), CRawlog::etObservation);
+		EXPECT_EQ(
+			std::dynamic_pointer_cast<CObservation>(*it)->timestamp,
+			eager.getAsObservation(i)->timestamp);
+	}
+	EXPECT_EQ(i, N);
+
+	// Modified entries are kept until unloaded:
+	lazy.getAsObservation(10)->sensorLabel = "MODIFIED";
+	EXPECT_EQ(lazy.getAsObservation(10)->sensorLabel, "MODIFIED");
+	lazy.unloadEntry(10);
+	EXPECT_EQ(lazy.getAsObservation(10)->sensorLabel, "LASER");
+
+	// Removal keeps the index in sync:
+	lazy.remove(0, 9);
+	ASSERT_EQ(lazy.size(), N - 10);
+	EXPECT_EQ(
+		lazy.getAsObservation(0)->timestamp,
+		eager.getAsObservation(10)->timestamp);
+
+	// Saving copies non-deserialized entries:
+	const std::string fil2 = fil + "_2";
+	ASSERT_TRUE(lazy.saveToRawLogFile(fil2));
+	CRawlog reloaded;
+	ASSERT_TRUE(reloaded.loadFromRawLogFile(fil2));
+	ASSERT_EQ(reloaded.size(), N - 10);
+	EXPECT_EQ(reloaded.getCommentText(), "test comment");
+	EXPECT_EQ(
+		reloaded.getAsObservation(N - 11)->timestamp,
+		eager.getAsObservation(N - 1)->timestamp);
+
+	// Compressed files fall back to a regular load:
+	CRawlog lazyGz;
+	ASSERT_TRUE(lazyGz.loadFromRawLogFileLazy(fil2));
+	EXPECT_FALSE(lazyGz.isLazy());
+	EXPECT_EQ(lazyGz.size(), N - 10);
+}
+
+#if MRPT_HAS_ZSTD
+TEST(CRawlog, loadFromRawLogFileLazyZstd)
+{
+	const std::string fil = mrpt::system::getTempFileName() + ".rawlog";
+	const size_t N = 20;
+	writeTestRawlog(fil, N);
+
+	// The same rawlog, zstd-compressed:
+	const std::string filZstd = fil + ".zst";
+	{
+		std::vector<uint8_t> buf;
+		ASSERT_TRUE(mrpt::io::loadBinaryFile(buf, fil));
+		mrpt::io::CFileZstdOutputStream fo(filZstd);
+		fo.Write(buf.data(), buf.size());
+	}
+
+	// It cannot be read at random offsets: falls back to a regular load
+	CRawlog lazy;
+	ASSERT_TRUE(lazy.loadFromRawLogFileLazy(filZstd));
+	EXPECT_FALSE(lazy.isLazy());
+	ASSERT_EQ(lazy.size(), N);
+	EXPECT_EQ(lazy.getCommentText(), "test comment");
+	EXPECT_EQ(lazy.getAsObservation(1)->sensorLabel, "ODOMETRY");
+}
+#endif
+
+TEST(CRawlog, indexFile)
+{
+	const std::string fil = mrpt::system::getTempFileName() + ".rawlog";
+	const std::string idxFil = fil + ".myidx";
+	writeTestRawlog(fil, 20);
+
+	CRawlog::TIndex idx, idx2;
+	ASSERT_TRUE(CRawlog::buildIndex(fil, idx));
+	ASSERT_EQ(idx.size(), 21U);  // including the comment
+	EXPECT_EQ(idx[0].offset, 0U);
+	for (size_t i = 1; i < idx.size(); i++)
+	{
+		EXPECT_EQ(idx[i].offset, idx[i - 1].offset + idx[i - 1].length);
+		EXPECT_EQ(idx[i].sensorLabel, (i % 2 == 1) ? "LASER" : "ODOMETRY");
+		EXPECT_NE(idx[i].timestamp, INVALID_TIMESTAMP);
+	}
+	EXPECT_EQ(
+		idx.back().offset + idx.back().length, mrpt::system::getFileSize(fil));
+
+	ASSERT_TRUE(CRawlog::saveIndexFile(fil, idx, idxFil));
+	ASSERT_TRUE(CRawlog::loadIndexFile(fil, idx2, idxFil));
+	ASSERT_EQ(idx2.size(), idx.size());
+	for (size_t i = 0; i < idx.size(); i++)
+	{
+		EXPECT_EQ(idx2[i].offset, idx[i].offset);
+		EXPECT_EQ(idx2[i].timestamp, idx[i].timestamp);
+		EXPECT_EQ(idx2[i].className, idx[i].className);
+		EXPECT_EQ(idx2[i].classId, idx[i].classId);
+		EXPECT_EQ(idx2[i].sensorLabel, idx[i].sensorLabel);
+	}
+
+	// Outdated indices are detected:
+	writeTestRawlog(fil, 21);
+	EXPECT_FALSE(CRawlog::loadIndexFile(fil, idx2, idxFil));
+	EXPECT_FALSE(CRawlog::loadIndexFile(fil + "_none", idx2));
+}
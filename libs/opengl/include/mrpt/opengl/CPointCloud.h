@@ -197,6 +197,16 @@ class CPointCloud : public CRenderizableShaderPoints,
 		markAllPointsAsNew();
 	}
 
+	/** Like setPoint_fast(), but does not mark the cloud as modified, so it
+	 * can be called from several threads at once for distinct points. Call
+	 * resize() once all points are set.
+	 * \note (New in MRPT 2.1.0) */
+	inline void setPointConcurrent_fast(
+		size_t i, const float x, const float y, const float z)
+	{
+		m_points[i] = {x, y, z};
+	}
+
 	/** Load the points from any other point map class supported by the adapter
 	 * mrpt::opengl::PointCloudAdapter. */
 	template <class POINTSMAP>
@@ -330,6 +340,14 @@ class PointCloudAdapter<mrpt::opengl::CPointCloud>
 		m_obj.setPoint_fast(idx, x, y, z);
 	}
 
+	/** Like setPointXYZ(), for distinct points from several threads at once:
+	 * resize() must be called once all points are set. */
+	inline void setPointXYZ_concurrent(
+		const size_t idx, const coords_t x, const coords_t y, const coords_t z)
+	{
+		m_obj.setPointConcurrent_fast(idx, x, y, z);
+	}
+
 	/** Set XYZ coordinates of i'th point */
 	inline void setInvalidPoint(const size_t idx)
 	{
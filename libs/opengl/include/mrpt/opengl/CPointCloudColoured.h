@@ -125,6 +125,16 @@ class CPointCloudColoured : public CRenderizableShaderPoints,
 		markAllPointsAsNew();
 	}
 
+	/** Like setPoint_fast(), but does not mark the cloud as modified, so it
+	 * can be called from several threads at once for distinct points. Call
+	 * resize() once all points are set.
+	 * \note (New in MRPT 2.1.0) */
+	inline void setPointConcurrent_fast(
+		const size_t i, const float x, const float y, const float z)
+	{
+		m_points[i] = {x, y, z};
+	}
+
 	/** Like \c setPointColor but without checking for out-of-index erors */
 	inline void setPointColor_fast(
 		size_t index, float R, float G, float B, float A = 1)
@@ -275,6 +285,14 @@ class PointCloudAdapter<mrpt::opengl::CPointCloudColoured>
 		m_obj.setPoint_fast(idx, x, y, z);
 	}
 
+	/** Like setPointXYZ(), for distinct points from several threads at once:
+	 * resize() must be called once all points are set. */
+	inline void setPointXYZ_concurrent(
+		const size_t idx, const coords_t x, const coords_t y, const coords_t z)
+	{
+		m_obj.setPointConcurrent_fast(idx, x, y, z);
+	}
+
 	inline void setInvalidPoint(const size_t idx)
 	{
 		m_obj.setPoint_fast(idx, 0, 0, 0);
@@ -16,6 +16,7 @@
 #include <mrpt/typemeta/TTypeName.h>
 #include <cstdint>
 #include <cstring>  // memcpy
+#include <memory>
 #include <stdexcept>
 #include <string>
 #include <type_traits>  // remove_reference_t, is_polymorphic
@@ -70,6 +71,21 @@ class CArchive
 	 */
 	size_t ReadBuffer(void* Buffer, size_t Count);
 
+	/** Zero-copy version of ReadBuffer(): returns a read-only pointer to the
+	 * next Count bytes of the underlying stream, if it keeps its contents in
+	 * memory (e.g. mrpt::io::CFileMMapInputStream or
+	 * mrpt::io::CMemoryStream, see mrpt::io::CStream::ReadBorrow()).
+	 * Otherwise, the data is read with ReadBuffer() into a new buffer, owned
+	 * by the returned pointer.
+	 *
+	 * Use it to parse large payloads (e.g. compressed images) directly from
+	 * the source buffer. The data is valid at least until the archive or its
+	 * stream are modified or destroyed.
+	 *	\exception std::exception If there are less than Count bytes left.
+	 * \note (New in MRPT 2.1.0)
+	 */
+	std::shared_ptr<const uint8_t> ReadBufferBorrow(size_t Count);
+
 	/** Reads a sequence of elemental datatypes, taking care of reordering their
 	 *bytes from the MRPT stream standard (little endianness) to the format of
 	 *the running architecture.
@@ -380,6 +396,14 @@ class CArchive
 	 * \return Number of bytes actually read if >0.
 	 */
 	virtual size_t read(void* buf, size_t len) = 0;
+	/** Zero-copy read of a block of bytes, if supported by the underlying
+	 * stream.
+	 * \return nullptr (without consuming any data) if not supported.
+	 */
+	virtual std::shared_ptr<const uint8_t> borrow([[maybe_unused]] size_t len)
+	{
+		return {};
+	}
 	/** @} */
 
 	/** Read the object */
@@ -565,6 +589,20 @@ CArchive& operator>>(CArchive& in, std::shared_ptr<T>& pObj)
 	return in;
 }
 
+namespace detail
+{
+template <class STREAM, class = void>
+struct has_ReadBorrow : std::false_type
+{
+};
+template <class STREAM>
+struct has_ReadBorrow<
+	STREAM, std::void_t<decltype(std::declval<STREAM&>().ReadBorrow(0))>>
+	: std::true_type
+{
+};
+}  // namespace detail
+
 /** CArchive for mrpt::io::CStream classes (use as template argument).
  * \sa Easier to use via function archiveFrom() */
 template <class STREAM>
@@ -578,6 +616,13 @@ class CArchiveStreamBase : public CArchive
    protected:
 	size_t write(const void* d, size_t n) override { return m_s.Write(d, n); }
 	size_t read(void* d, size_t n) override { return m_s.Read(d, n); }
+	std::shared_ptr<const uint8_t> borrow(size_t n) override
+	{
+		if constexpr (detail::has_ReadBorrow<STREAM>::value)
+			return m_s.ReadBorrow(n);
+		else
+			return {};
+	}
 };
 
 /** Helper function to create a templatized wrapper CArchive object for a:
@@ -42,6 +42,20 @@ size_t CArchive::ReadBuffer(void* Buffer, size_t Count)
 		return 0;
 }
 
+std::shared_ptr<const uint8_t> CArchive::ReadBufferBorrow(size_t Count)
+{
+	if (!Count) return {};
+	if (auto p = this->borrow(Count); p) return p;
+
+	// Not supported by the stream: read into a new buffer
+	std::shared_ptr<uint8_t> buf(
+		new uint8_t[Count], std::default_delete<uint8_t[]>());
+	if (ReadBuffer(buf.get(), Count) != Count)
+		THROW_EXCEPTION(
+			"(EOF?) Cannot read requested number of bytes from stream");
+	return buf;
+}
+
 /*---------------------------------------------------------------
 WriteBuffer
 Writes a block of bytes to the stream.
@@ -11,7 +11,10 @@
 #include <mrpt/io/CMemoryStream.h>
 #include <mrpt/serialization/CArchive.h>
 #include <mrpt/serialization/CSerializable.h>
+#include <mrpt/serialization/archiveFrom_std_streams.h>
 #include <mrpt/serialization/optional_serialization.h>
+#include <cstring>
+#include <sstream>
 
 using namespace mrpt::serialization;
 
@@ -104,3 +107,27 @@ TEST(Serialization, optionalObjects)
 	EXPECT_EQ(c, c2);
 	EXPECT_EQ(d, d2);
 }
+
+TEST(Serialization, ReadBufferBorrow)
+{
+	const char data[] = "0123456789";
+	{
+		// Zero-copy from memory streams:
+		mrpt::io::CMemoryStream buf;
+		buf.assignMemoryNotOwn(data, sizeof(data));
+		auto arch = mrpt::serialization::archiveFrom(buf);
+		const auto p = arch.ReadBufferBorrow(4);
+		EXPECT_EQ(p.get(), reinterpret_cast<const uint8_t*>(data));
+		EXPECT_EQ(buf.getPosition(), 4U);
+		EXPECT_ANY_THROW(arch.ReadBufferBorrow(100));
+	}
+	{
+		// Fallback: a copy
+		std::stringstream ss(data);
+		auto arch = mrpt::serialization::archiveFrom<std::istream>(ss);
+		arch.ReadBufferBorrow(2);
+		const auto p = arch.ReadBufferBorrow(4);
+		ASSERT_TRUE(p != nullptr);
+		EXPECT_EQ(0, std::memcmp(p.get(), "2345", 4));
+	}
+}
@@ -19,7 +19,15 @@ namespace mrpt::slam
 enum TICPAlgorithm
 {
 	icpClassic = 0,
-	icpLevenbergMarquardt
+	icpLevenbergMarquardt,
+	/** 3D only: Gauss-Newton minimization of the distances from each point
+	 * to the plane fitted around its pair in the reference map.
+	 * \note (New in MRPT 2.1.0) */
+	icpPointToPlane,
+	/** 3D only: Generalized-ICP (Segal et al., RSS 2009), a plane-to-plane
+	 * metric from the local covariances of both maps.
+	 * \note (New in MRPT 2.1.0) */
+	icpGICP
 };
 
 /** ICP covariance estimation methods, used in mrpt::slam::CICP::options
@@ -174,6 +182,19 @@ class CICP : public mrpt::slam::CMetricMapsAlignmentAlgorithm
 		 * queries,
 		 *  the most expensive step in ICP */
 		uint32_t corresponding_points_decimation{5};
+		/** Number of threads for the nearest-neighbor search of
+		 * correspondences, the most expensive step in ICP with large point
+		 * clouds (default=1). 0 means as many as hardware cores.
+		 * \sa mrpt::maps::TMatchingParams::numThreads
+		 * \note (New in MRPT 2.1.0) */
+		uint32_t corresponding_points_numThreads{1};
+
+		/** [icpPointToPlane and icpGICP only] Number of nearest neighbors used
+		 * to estimate the local normals and covariances of the point maps
+		 * (default=20). These are cached in each map, see
+		 * mrpt::maps::CPointsMap::getLocalStructure()
+		 * \note (New in MRPT 2.1.0) */
+		uint32_t local_structure_knn{20};
 	};
 
 	/** The options employed by the ICP align. */
@@ -247,12 +268,19 @@ class CICP : public mrpt::slam::CMetricMapsAlignmentAlgorithm
 		const mrpt::maps::CMetricMap* m1, const mrpt::maps::CMetricMap* m2,
 		const mrpt::poses::CPose3DPDFGaussian& initialEstimationPDF,
 		TReturnInfo& outInfo);
+	/** Gauss-Newton solver for icpPointToPlane and icpGICP */
+	mrpt::poses::CPose3DPDF::Ptr ICP3D_Method_GaussNewton(
+		const mrpt::maps::CMetricMap* m1, const mrpt::maps::CMetricMap* m2,
+		const mrpt::poses::CPose3DPDFGaussian& initialEstimationPDF,
+		TReturnInfo& outInfo);
 };
 }  // namespace mrpt::slam
 MRPT_ENUM_TYPE_BEGIN(mrpt::slam::TICPAlgorithm)
 using namespace mrpt::slam;
 MRPT_FILL_ENUM(icpClassic);
 MRPT_FILL_ENUM(icpLevenbergMarquardt);
+MRPT_FILL_ENUM(icpPointToPlane);
+MRPT_FILL_ENUM(icpGICP);
 MRPT_ENUM_TYPE_END()
 
 MRPT_ENUM_TYPE_BEGIN(mrpt::slam::TICPCovarianceMethod)
@@ -71,6 +71,13 @@ class CMetricMapBuilderICP : public mrpt::slam::CMetricMapBuilder
 		 * position (default: 0.40) */
 		double minICPgoodnessToAccept;
 
+		/** (default:false) If true, the KD-trees of the points maps are
+		 * updated incrementally with the points of each new observation,
+		 * instead of being rebuilt from scratch after each insertion. See
+		 * mrpt::math::KDTreeCapable::TKDTreeSearchParams::incremental.
+		 * \note (New in MRPT 2.1.0) */
+		bool incrementalKDTree{false};
+
 		mrpt::system::VerbosityLevel& verbosity_level;
 
 		/** What maps to create (at least one points map and/or a grid map are
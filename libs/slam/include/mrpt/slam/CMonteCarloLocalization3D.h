@@ -120,6 +120,11 @@ class CMonteCarloLocalization3D
 		const size_t particleIndexForMap,
 		const mrpt::obs::CSensoryFrame& observation,
 		const mrpt::poses::CPose3D& x) const override;
+
+	bool PF_SLAM_prepareConcurrentLikelihood(
+		const mrpt::obs::CSensoryFrame& observation,
+		const mrpt::math::TPoint3D& posesMin,
+		const mrpt::math::TPoint3D& posesMax) override;
 	/** @} */
 
 };  // End of class def.
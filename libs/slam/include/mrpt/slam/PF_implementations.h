@@ -11,6 +11,7 @@
 
 #include <mrpt/bayes/CParticleFilterCapable.h>
 #include <mrpt/bayes/CParticleFilterData.h>
+#include <mrpt/core/WorkerThreadsPool.h>
 #include <mrpt/math/data_utils.h>  // averageLogLikelihood()
 #include <mrpt/math/distributions.h>  // chi2inv
 #include <mrpt/obs/CActionCollection.h>
@@ -231,7 +232,49 @@ void PF_implementation<PARTICLE_TYPE, MYSELF, STORAGE>::
 		}
 
 		// Update particle poses:
-		if (!PF_options.adaptiveSampleSize)
+		if (!PF_options.adaptiveSampleSize && PF_options.parallelProcessing)
+		{
+			const size_t M = me->m_particles.size();
+			// -------------------------------------------------------------
+			// FIXED SAMPLE SIZE, PARALLEL VERSION
+			// -------------------------------------------------------------
+			// All samples are drawn from this thread, in the same order than
+			// in the sequential version, so results are identical:
+			std::vector<mrpt::poses::CPose3D> incrPoses(M);
+			for (size_t i = 0; i < M; i++)
+				m_movementDrawer.drawSample(incrPoses[i]);
+
+			const unsigned int nThreads =
+				mrpt::WorkerThreadsPool::clampNumThreads(
+					PF_options.parallelNumThreads);
+			mrpt::WorkerThreadsPool::sharedPool().parallel_for(
+				0, M,
+				[&](size_t i0, size_t i1) {
+					for (size_t i = i0; i < i1; i++)
+					{
+						bool pose_is_valid;
+						const mrpt::poses::CPose3D finalPose =
+							mrpt::poses::CPose3D(
+								getLastPose(i, pose_is_valid)) +
+							incrPoses[i];
+						if constexpr (
+							STORAGE ==
+							mrpt::bayes::particle_storage_mode::POINTER)
+						{
+							PF_SLAM_implementation_custom_update_particle_with_new_pose(
+								me->m_particles[i].d.get(),
+								finalPose.asTPose());
+						}
+						else
+						{
+							PF_SLAM_implementation_custom_update_particle_with_new_pose(
+								&me->m_particles[i].d, finalPose.asTPose());
+						}
+					}
+				},
+				(M + nThreads - 1) / nThreads);
+		}
+		else if (!PF_options.adaptiveSampleSize)
 		{
 			const size_t M = me->m_particles.size();
 			// -------------------------------------------------------------
@@ -361,18 +404,56 @@ void PF_implementation<PARTICLE_TYPE, MYSELF, STORAGE>::
 		//	UPDATE STAGE
 		// ----------------------------------------------------------------------
 		// Compute all the likelihood values & update particles weight:
-		for (size_t i = 0; i < M; i++)
+		auto updateWeights = [&](size_t i0, size_t i1) {
+			for (size_t i = i0; i < i1; i++)
+			{
+				bool pose_is_valid;
+				const mrpt::math::TPose3D partPose =
+					getLastPose(i, pose_is_valid);  // Take the particle data:
+				auto partPose2 = mrpt::poses::CPose3D(partPose);
+				const double obs_log_lik =
+					PF_SLAM_computeObservationLikelihoodForParticle(
+						PF_options, i, *sf, partPose2);
+				ASSERT_(
+					!std::isnan(obs_log_lik) && std::isfinite(obs_log_lik));
+				me->m_particles[i].log_w += obs_log_lik * PF_options.powFactor;
+			}  // for each particle "i"
+		};
+
+		if (PF_options.parallelProcessing && M > 1)
 		{
+			// The first particle is evaluated from this thread, so all lazy
+			// caches in the observations are built before going
+			// multi-threaded:
+			updateWeights(0, 1);
+			// Bounding box of all particles:
 			bool pose_is_valid;
-			const mrpt::math::TPose3D partPose =
-				getLastPose(i, pose_is_valid);  // Take the particle data:
-			auto partPose2 = mrpt::poses::CPose3D(partPose);
-			const double obs_log_lik =
-				PF_SLAM_computeObservationLikelihoodForParticle(
-					PF_options, i, *sf, partPose2);
-			ASSERT_(!std::isnan(obs_log_lik) && std::isfinite(obs_log_lik));
-			me->m_particles[i].log_w += obs_log_lik * PF_options.powFactor;
-		}  // for each particle "i"
+			const mrpt::math::TPose3D p0 = getLastPose(0, pose_is_valid);
+			mrpt::math::TPoint3D posesMin(p0.x, p0.y, p0.z);
+			mrpt::math::TPoint3D posesMax = posesMin;
+			for (size_t i = 1; i < M; i++)
+			{
+				const mrpt::math::TPose3D p = getLastPose(i, pose_is_valid);
+				posesMin.x = std::min(posesMin.x, p.x);
+				posesMin.y = std::min(posesMin.y, p.y);
+				posesMin.z = std::min(posesMin.z, p.z);
+				posesMax.x = std::max(posesMax.x, p.x);
+				posesMax.y = std::max(posesMax.y, p.y);
+				posesMax.z = std::max(posesMax.z, p.z);
+			}
+			if (PF_SLAM_prepareConcurrentLikelihood(*sf, posesMin, posesMax))
+			{
+				const unsigned int nThreads =
+					mrpt::WorkerThreadsPool::clampNumThreads(
+						PF_options.parallelNumThreads);
+				mrpt::WorkerThreadsPool::sharedPool().parallel_for(
+					1, M, updateWeights, (M - 1 + nThreads - 1) / nThreads);
+			}
+			else
+				updateWeights(1, M);
+		}
+		else
+			updateWeights(0, M);
 
 		// Normalization of weights is done outside of this method
 		// automatically.
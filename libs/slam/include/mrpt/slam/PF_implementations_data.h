@@ -10,6 +10,7 @@
 
 #include <mrpt/bayes/CParticleFilterCapable.h>
 #include <mrpt/bayes/CParticleFilterData.h>
+#include <mrpt/math/TPoint3D.h>
 #include <mrpt/math/TPose3D.h>
 #include <mrpt/obs/CActionRobotMovement2D.h>
 #include <mrpt/poses/CPose3D.h>
@@ -279,6 +280,21 @@ class PF_implementation : public mrpt::system::COutputLogger
 		const mrpt::obs::CSensoryFrame& observation,
 		const mrpt::poses::CPose3D& x) const = 0;
 
+	/** Prepares the map(s) for PF_SLAM_computeObservationLikelihoodForParticle()
+	 * to be invoked from several threads at once, for `observation` and
+	 * particles within the box `[posesMin, posesMax]`, and returns false if
+	 * that is not supported, which is the default. Used if
+	 * TParticleFilterOptions::parallelProcessing is enabled.
+	 * \sa mrpt::maps::CMetricMap::prepareForConcurrentLikelihood()
+	 */
+	virtual bool PF_SLAM_prepareConcurrentLikelihood(
+		[[maybe_unused]] const mrpt::obs::CSensoryFrame& observation,
+		[[maybe_unused]] const mrpt::math::TPoint3D& posesMin,
+		[[maybe_unused]] const mrpt::math::TPoint3D& posesMax)
+	{
+		return false;
+	}
+
 	/** @} */
 
 	/** Auxiliary method called by PF implementations: return true if we have
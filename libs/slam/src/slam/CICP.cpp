@@ -19,6 +19,7 @@
 #include <mrpt/poses/CPosePDF.h>
 #include <mrpt/poses/CPosePDFGaussian.h>
 #include <mrpt/poses/CPosePDFSOG.h>
+#include <mrpt/poses/Lie/SE.h>
 #include <mrpt/serialization/CArchive.h>
 #include <mrpt/slam/CICP.h>
 #include <mrpt/system/CTicTac.h>
@@ -56,6 +57,10 @@ CPosePDF::Ptr CICP::AlignPDF(
 			resultPDF =
 				ICP_Method_LM(m1, mm2, initialEstimationPDF, outInfoVal);
 			break;
+		case icpPointToPlane:
+		case icpGICP:
+			THROW_EXCEPTION(
+				"icpPointToPlane and icpGICP are only implemented for ICP-3D");
 		default:
 			THROW_EXCEPTION_FMT(
 				"Invalid value for ICP_algorithm: %i",
@@ -121,6 +126,9 @@ void CICP::TConfigParams::loadFromConfigFile(
 
 	MRPT_LOAD_CONFIG_VAR(
 		corresponding_points_decimation, int, iniFile, section);
+	MRPT_LOAD_CONFIG_VAR(
+		corresponding_points_numThreads, int, iniFile, section);
+	MRPT_LOAD_CONFIG_VAR(local_structure_knn, int, iniFile, section);
 }
 
 void CICP::TConfigParams::saveToConfigFile(
@@ -169,6 +177,12 @@ void CICP::TConfigParams::saveToConfigFile(
 	MRPT_SAVE_CONFIG_VAR_COMMENT(skip_cov_calculation, "");
 	MRPT_SAVE_CONFIG_VAR_COMMENT(skip_quality_calculation, "");
 	MRPT_SAVE_CONFIG_VAR_COMMENT(corresponding_points_decimation, "");
+	MRPT_SAVE_CONFIG_VAR_COMMENT(
+		corresponding_points_numThreads,
+		"Threads for the correspondence search (0=all cores)");
+	MRPT_SAVE_CONFIG_VAR_COMMENT(
+		local_structure_knn,
+		"Neighbors for normals and covariances (point-to-plane, GICP)");
 }
 
 float CICP::kernel(float x2, float rho2)
@@ -231,6 +245,7 @@ CPosePDF::Ptr CICP::ICP_Method_Classic(
 	matchParams.onlyUniqueRobust = options.onlyUniqueRobust;
 	matchParams.decimation_other_map_points =
 		options.corresponding_points_decimation;
+	matchParams.numThreads = options.corresponding_points_numThreads;
 
 	// Ensure maps are not empty!
 	// ------------------------------------------------------
@@ -600,6 +615,7 @@ CPosePDF::Ptr CICP::ICP_Method_LM(
 	matchParams.onlyUniqueRobust = onlyUniqueRobust;
 	matchParams.decimation_other_map_points =
 		options.corresponding_points_decimation;
+	matchParams.numThreads = options.corresponding_points_numThreads;
 
 	// The gaussian PDF to estimate:
 	// ------------------------------------------------------
@@ -934,7 +950,13 @@ CPose3DPDF::Ptr CICP::Align3DPDF(
 				ICP3D_Method_Classic(m1, mm2, initialEstimationPDF, outInfoVal);
 			break;
 		case icpLevenbergMarquardt:
-			THROW_EXCEPTION("Only icpClassic is implemented for ICP-3D");
+			THROW_EXCEPTION(
+				"icpLevenbergMarquardt is not implemented for ICP-3D");
+			break;
+		case icpPointToPlane:
+		case icpGICP:
+			resultPDF = ICP3D_Method_GaussNewton(
+				m1, mm2, initialEstimationPDF, outInfoVal);
 			break;
 		default:
 			THROW_EXCEPTION_FMT(
@@ -1003,6 +1025,7 @@ CPose3DPDF::Ptr CICP::ICP3D_Method_Classic(
 	matchParams.onlyUniqueRobust = options.onlyUniqueRobust;
 	matchParams.decimation_other_map_points =
 		options.corresponding_points_decimation;
+	matchParams.numThreads = options.corresponding_points_numThreads;
 
 	// Ensure maps are not empty!
 	// ------------------------------------------------------
@@ -1114,3 +1137,169 @@ CPose3DPDF::Ptr CICP::ICP3D_Method_Classic(
 
 	MRPT_END
 }
+
+CPose3DPDF::Ptr CICP::ICP3D_Method_GaussNewton(
+	const mrpt::maps::CMetricMap* mm1, const mrpt::maps::CMetricMap* mm2,
+	const CPose3DPDFGaussian& initialEstimationPDF, TReturnInfo& outInfo)
+{
+	MRPT_START
+
+	using Vector6d = Eigen::Matrix<double, 6, 1>;
+	using Matrix6d = Eigen::Matrix<double, 6, 6>;
+
+	// Both maps must be point maps, to have their local structure:
+	ASSERT_(IS_DERIVED(*mm1, CPointsMap));
+	ASSERT_(IS_DERIVED(*mm2, CPointsMap));
+	const auto* m1 = static_cast<const CPointsMap*>(mm1);
+	const auto* m2 = static_cast<const CPointsMap*>(mm2);
+
+	const bool isGICP = (options.ICP_algorithm == icpGICP);
+
+	auto gaussPdf = std::make_shared<CPose3DPDFGaussian>();
+	gaussPdf->mean = initialEstimationPDF.mean;
+
+	outInfo.nIterations = 0;
+	outInfo.goodness = 0;
+	outInfo.quality = 0;
+
+	if (m1->isEmpty() || m2->isEmpty()) return gaussPdf;
+
+	// Normals and covariances (cached in the maps, so they are only computed
+	// once for each reference map):
+	const auto& ls1 = m1->getLocalStructure(
+		options.local_structure_knn, options.corresponding_points_numThreads);
+	const CPointsMap::TLocalStructure* ls2 = nullptr;
+	if (isGICP)
+		ls2 = &m2->getLocalStructure(
+			options.local_structure_knn,
+			options.corresponding_points_numThreads);
+
+	TMatchingParams matchParams;
+	TMatchingExtraResults matchExtraResults;
+	mrpt::tfest::TMatchingPairList correspondences;
+
+	matchParams.maxDistForCorrespondence = options.thresholdDist;
+	matchParams.maxAngularDistForCorrespondence = options.thresholdAng;
+	matchParams.onlyKeepTheClosest = true;
+	matchParams.onlyUniqueRobust = options.onlyUniqueRobust;
+	matchParams.decimation_other_map_points =
+		options.corresponding_points_decimation;
+	matchParams.offset_other_map_points = 0;
+	matchParams.numThreads = options.corresponding_points_numThreads;
+
+	const double rho2 = square(options.kernel_rho);
+	Matrix6d H;
+	bool validH = false;
+
+	while (outInfo.nIterations < options.maxIterations)
+	{
+		CPose3D& pose = gaussPdf->mean;
+		matchParams.angularDistPivotPoint =
+			TPoint3D(pose.x(), pose.y(), pose.z());
+
+		m1->determineMatching3D(
+			m2, pose, correspondences, matchParams, matchExtraResults);
+		outInfo.nIterations++;
+
+		// Not enough constraints for the 6 DOFs:
+		validH = correspondences.size() >= 6;
+		if (!validH) break;
+
+		// Build the linear system for the increment
+		// delta=[dx dy dz rx ry rz], applied to the left of the pose:
+		//  pose <- SE<3>::exp(delta) (+) pose
+		const Eigen::Matrix3d R = pose.getRotationMatrix().asEigen();
+		H.setZero();
+		Vector6d g = Vector6d::Zero();
+
+		for (const auto& c : correspondences)
+		{
+			double gx, gy, gz;
+			pose.composePoint(c.other_x, c.other_y, c.other_z, gx, gy, gz);
+			const Eigen::Vector3d err(
+				gx - c.this_x, gy - c.this_y, gz - c.this_z);
+
+			// Jacobian of the transformed point wrt delta: [ I | -[p]_x ]
+			Eigen::Matrix<double, 3, 6> Jp;
+			Jp << 1, 0, 0, 0, gz, -gy,  //
+				0, 1, 0, -gz, 0, gx,  //
+				0, 0, 1, gy, -gx, 0;
+
+			if (!isGICP)
+			{
+				// Point-to-plane: residual along the reference normal
+				const auto& nf = ls1.normals[c.this_idx];
+				const Eigen::Vector3d n(nf.x, nf.y, nf.z);
+				const double r = n.dot(err);
+				const double w =
+					options.use_kernel ? rho2 / (rho2 + r * r) : 1.0;
+				const Eigen::Matrix<double, 1, 6> J = n.transpose() * Jp;
+				H.noalias() += w * J.transpose() * J;
+				g.noalias() += (w * r) * J.transpose();
+			}
+			else
+			{
+				// GICP: Mahalanobis distance with the combined covariances
+				const Eigen::Matrix3d C =
+					ls1.planeCovs[c.this_idx].asEigen().cast<double>() +
+					R * ls2->planeCovs[c.other_idx].asEigen().cast<double>() *
+						R.transpose();
+				const Eigen::Matrix3d M = C.inverse();
+				const double w = options.use_kernel
+									 ? rho2 / (rho2 + err.squaredNorm())
+									 : 1.0;
+				H.noalias() += w * Jp.transpose() * M * Jp;
+				g.noalias() += w * Jp.transpose() * M * err;
+			}
+		}
+
+		const Vector6d delta = H.ldlt().solve(-g);
+		if (!delta.allFinite())
+		{
+			// Degenerate geometry:
+			validH = false;
+			break;
+		}
+
+		mrpt::poses::Lie::SE<3>::tangent_vector d;
+		for (int i = 0; i < 6; i++) d[i] = delta[i];
+		pose = mrpt::poses::Lie::SE<3>::exp(d) + pose;
+
+		// Converged?
+		if (delta.head<3>().cwiseAbs().maxCoeff() < options.minAbsStep_trans &&
+			delta.tail<3>().cwiseAbs().maxCoeff() < options.minAbsStep_rot)
+			break;
+	}
+
+	// Covariance: inverse of the Hessian, mapped from the increment space to
+	// the [x y z yaw pitch roll] parameterization of CPose3DPDFGaussian.
+	if (!options.skip_cov_calculation && validH)
+	{
+		const Matrix6d covDelta =
+			options.covariance_varPoints * H.ldlt().solve(Matrix6d::Identity());
+
+		const CPose3D& mean = gaussPdf->mean;
+		const double h = 1e-6;
+		Matrix6d J;
+		for (int k = 0; k < 6; k++)
+		{
+			mrpt::poses::Lie::SE<3>::tangent_vector d;
+			d.setZero();
+			d[k] = h;
+			const CPose3D p = mrpt::poses::Lie::SE<3>::exp(d) + mean;
+			J(0, k) = (p.x() - mean.x()) / h;
+			J(1, k) = (p.y() - mean.y()) / h;
+			J(2, k) = (p.z() - mean.z()) / h;
+			J(3, k) = mrpt::math::wrapToPi(p.yaw() - mean.yaw()) / h;
+			J(4, k) = mrpt::math::wrapToPi(p.pitch() - mean.pitch()) / h;
+			J(5, k) = mrpt::math::wrapToPi(p.roll() - mean.roll()) / h;
+		}
+		gaussPdf->cov = CMatrixDouble66(J * covDelta * J.transpose());
+	}
+
+	outInfo.goodness = matchExtraResults.correspondencesRatio;
+
+	return gaussPdf;
+
+	MRPT_END
+}
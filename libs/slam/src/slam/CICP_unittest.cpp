@@ -9,6 +9,7 @@
 
 #include <gtest/gtest.h>
 #include <mrpt/maps/CSimplePointsMap.h>
+#include <mrpt/maps/CVoxelHashPointsMap.h>
 #include <mrpt/obs/stock_observations.h>
 #include <mrpt/opengl/CAngularObservationMesh.h>
 #include <mrpt/opengl/CDisk.h>
@@ -19,6 +20,7 @@
 #include <mrpt/opengl/stock_objects.h>
 #include <mrpt/poses/CPose3DPDF.h>
 #include <mrpt/poses/CPosePDF.h>
+#include <mrpt/random.h>
 #include <mrpt/slam/CICP.h>
 #include <Eigen/Dense>
 
@@ -73,6 +75,61 @@ class ICPTests : public ::testing::Test
 		EXPECT_NEAR(good_pose.distanceTo(pdf->getMeanVal()), 0, 0.02);
 	}
 
+	// Random samples of a room corner (floor and two walls) with a ball:
+	static void sampleRoomCorner(CSimplePointsMap& m, unsigned int seed)
+	{
+		auto& rng = mrpt::random::getRandomGenerator();
+		rng.randomize(seed);
+		m.clear();
+		for (int i = 0; i < 4000; i++)
+		{
+			const float a = rng.drawUniform(-4.0, 4.0);
+			const float b = rng.drawUniform(-4.0, 4.0);
+			const float h = rng.drawUniform(0.0, 3.0);
+			m.insertPoint(a, b, 0);
+			m.insertPoint(4.0f, a, h);
+			m.insertPoint(a, 4.0f, h);
+
+			const float th = rng.drawUniform(-M_PI, M_PI);
+			const float ph = rng.drawUniform(-M_PI / 2, M_PI / 2);
+			m.insertPoint(
+				1 + std::cos(th) * std::cos(ph),
+				-1 + std::sin(th) * std::cos(ph), 1 + std::sin(ph));
+		}
+	}
+
+	void align3DPlanes(const TICPAlgorithm icp_method)
+	{
+		// Two different samplings of the same scene, so there are no exact
+		// point-to-point correspondences:
+		CSimplePointsMap M1, M2;
+		sampleRoomCorner(M1, 1);
+		sampleRoomCorner(M2, 2);
+
+		const CPose3D SCAN2_POSE_ERROR(0.15, -0.07, 0.10, -0.03, 0.1, 0.1);
+		M2.changeCoordinatesReference(SCAN2_POSE_ERROR);
+
+		CICP icp;
+		CICP::TReturnInfo icp_info;
+		icp.options.ICP_algorithm = icp_method;
+		icp.options.thresholdDist = 0.40f;
+		icp.options.thresholdAng = 0;
+
+		CPose3DPDF::Ptr pdf = icp.Align3D(&M2, &M1, CPose3D(), icp_info);
+		const CPose3D mean = pdf->getMeanVal();
+
+		EXPECT_NEAR(
+			0,
+			(mean.asVectorVal() - SCAN2_POSE_ERROR.asVectorVal())
+				.array()
+				.abs()
+				.mean(),
+			0.01)
+			<< "ICP output: mean= " << mean << endl
+			<< "Real displacement: " << SCAN2_POSE_ERROR << endl;
+		EXPECT_LE(icp_info.nIterations, 10U);
+	}
+
 	static void generateObjects(CSetOfObjects::Ptr& world)
 	{
 		CSphere::Ptr sph = std::make_shared<CSphere>(0.5);
@@ -218,3 +275,42 @@ TEST_F(ICPTests, RayTracingICP3D)
 		<< "ICP output: mean= " << mean << endl
 		<< "Real displacement: " << SCAN2_POSE_ERROR << endl;
 }
+
+TEST_F(ICPTests, AlignPlanes3D_icpPointToPlane)
+{
+	align3DPlanes(icpPointToPlane);
+}
+
+TEST_F(ICPTests, AlignPlanes3D_icpGICP) { align3DPlanes(icpGICP); }
+
+TEST_F(ICPTests, Align3D_VoxelHashPointsMap)
+{
+	CSimplePointsMap M1, M2;
+	sampleRoomCorner(M1, 1);
+	sampleRoomCorner(M2, 2);
+	M2.changeCoordinatesReference(CPose3D(0.1, -0.05, 0.05, 0.03, 0, 0));
+
+	// Large enough voxels to keep all points, so the reference map has
+	// exactly the same points in both cases:
+	mrpt::maps::CVoxelHashPointsMap V1(0.25, 1000);
+	V1.insertPointCloud(M1, CPose3D());
+	ASSERT_EQ(V1.size(), M1.size());
+
+	CICP icp;
+	CICP::TReturnInfo info1, info2;
+	icp.options.thresholdDist = 0.40f;
+	icp.options.thresholdAng = 0;
+
+	const CPose3D mean1 =
+		icp.Align3D(&M2, &M1, CPose3D(), info1)->getMeanVal();
+	const CPose3D mean2 =
+		icp.Align3D(&M2, &V1, CPose3D(), info2)->getMeanVal();
+
+	EXPECT_EQ(info1.nIterations, info2.nIterations);
+	EXPECT_NEAR(
+		0,
+		(mean1.asVectorVal() - mean2.asVectorVal()).array().abs().maxCoeff(),
+		1e-4)
+		<< "ICP with CSimplePointsMap: " << mean1 << endl
+		<< "ICP with CVoxelHashPointsMap: " << mean2 << endl;
+}
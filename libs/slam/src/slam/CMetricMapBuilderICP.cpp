@@ -75,6 +75,7 @@ CMetricMapBuilderICP::TConfigParams& CMetricMapBuilderICP::TConfigParams::
 	localizationLinDistance = other.localizationLinDistance;
 	localizationAngDistance = other.localizationAngDistance;
 	minICPgoodnessToAccept = other.minICPgoodnessToAccept;
+	incrementalKDTree = other.incrementalKDTree;
 	//	We can't copy a reference type
 	//	verbosity_level         = other.verbosity_level;
 	mapInitializers = other.mapInitializers;
@@ -93,6 +94,7 @@ void CMetricMapBuilderICP::TConfigParams::loadFromConfigFile(
 		section, "verbosity_level", verbosity_level);
 
 	MRPT_LOAD_CONFIG_VAR(minICPgoodnessToAccept, double, source, section)
+	MRPT_LOAD_CONFIG_VAR(incrementalKDTree, bool, source, section)
 
 	mapInitializers.loadFromConfigFile(source, section);
 }
@@ -120,6 +122,9 @@ void CMetricMapBuilderICP::TConfigParams::dumpToTextStream(
 		mrpt::typemeta::TEnumType<mrpt::system::VerbosityLevel>::value2name(
 			verbosity_level)
 			.c_str());
+	out << mrpt::format(
+		"incrementalKDTree                       = %s\n",
+		incrementalKDTree ? "true" : "false");
 
 	out << "  Now showing 'mapsInitializers':\n";
 	mapInitializers.dumpToTextStream(out);
@@ -538,6 +543,12 @@ void CMetricMapBuilderICP::initialize(
 
 	// Create metric maps:
 	metricMap.setListOfMaps(ICP_options.mapInitializers);
+	for (size_t i = 0;; i++)
+	{
+		auto pts = metricMap.mapByClass<CPointsMap>(i);
+		if (!pts) break;
+		pts->kdtree_search_params.incremental = ICP_options.incrementalKDTree;
+	}
 
 	// copy map:
 	SF_Poses_seq = initialMap;
@@ -9,6 +9,7 @@
 
 #include <gtest/gtest.h>
 #include <mrpt/config/CConfigFile.h>
+#include <mrpt/core/WorkerThreadsPool.h>
 #include <mrpt/io/CFileGZInputStream.h>
 #include <mrpt/maps/CMultiMetricMap.h>
 #include <mrpt/maps/COccupancyGridMap2D.h>
@@ -300,3 +301,88 @@ TEST(MonteCarlo2D, RunSampleDataset)
 		FAIL() << mrpt::exception_to_str(e);
 	}
 }
+
+// Runs a few PF steps and returns the final particles. numThreads=0 means
+// the sequential implementation:
+static std::vector<std::pair<TPose2D, double>> run_pf_steps(
+	const CMultiMetricMap& metricMap, const CRawlog& rawlog,
+	unsigned int numThreads)
+{
+	getRandomGenerator().randomize(1234);
+
+	CMonteCarloLocalization2D pdf(2000);
+	pdf.options.metricMap = const_cast<CMultiMetricMap*>(&metricMap);
+	pdf.resetUniform(-10, 10, -15, -5, -M_PI, M_PI, 2000);
+
+	CParticleFilter PF;
+	PF.m_options.PF_algorithm = CParticleFilter::pfStandardProposal;
+	PF.m_options.adaptiveSampleSize = false;
+	PF.m_options.parallelProcessing = (numThreads != 0);
+	PF.m_options.parallelNumThreads = numThreads;
+
+	CActionCollection::Ptr action;
+	CSensoryFrame::Ptr observations;
+	size_t rawlogEntry = 0;
+	for (int step = 0; step < 10 && rawlog.getActionObservationPair(
+										 action, observations, rawlogEntry);
+		 step++)
+		PF.executeOn(pdf, action.get(), observations.get());
+
+	std::vector<std::pair<TPose2D, double>> ret;
+	for (size_t i = 0; i < pdf.size(); i++)
+		ret.emplace_back(pdf.getParticlePose(i), pdf.getW(i));
+	return ret;
+}
+
+TEST(MonteCarlo2D, ParallelMatchesSequential)
+{
+	const string map_fil = UNITTEST_BASEDIR +
+		string("/share/mrpt/datasets/localization_demo.simplemap.gz");
+	const string rawlog_fil = UNITTEST_BASEDIR +
+		string("/share/mrpt/datasets/localization_demo.rawlog");
+	if (!fileExists(map_fil) || !fileExists(rawlog_fil))
+	{
+		cerr << "WARNING: Skipping test due to missing files.\n";
+		return;
+	}
+
+	CSimpleMap simpleMap;
+	{
+		CFileGZInputStream f(map_fil);
+		mrpt::serialization::archiveFrom(f) >> simpleMap;
+	}
+	TSetOfMetricMapInitializers mapList;
+	{
+		auto def = COccupancyGridMap2D::TMapDefinition();
+		def.resolution = 0.05f;
+		def.likelihoodOpts.likelihoodMethod =
+			COccupancyGridMap2D::lmLikelihoodField_Thrun;
+		mapList.push_back(def);
+	}
+	CMultiMetricMap metricMap;
+	metricMap.setListOfMaps(mapList);
+	metricMap.loadFromProbabilisticPosesAndObservations(simpleMap);
+
+	CRawlog rawlog;
+	rawlog.loadFromRawLogFile(rawlog_fil);
+
+	const auto resSeq = run_pf_steps(metricMap, rawlog, 0);
+
+	// Run the parallel weighting even in single-core machines:
+	const auto formerNumCores = mrpt::WorkerThreadsPool::overrideNumCores(4);
+	for (unsigned int numThreads : {1U, 4U})
+	{
+		const auto resPar = run_pf_steps(metricMap, rawlog, numThreads);
+
+		ASSERT_EQ(resSeq.size(), resPar.size());
+		for (size_t i = 0; i < resSeq.size(); i++)
+		{
+			// Bit-identical poses and weights:
+			EXPECT_EQ(resSeq[i].first.x, resPar[i].first.x);
+			EXPECT_EQ(resSeq[i].first.y, resPar[i].first.y);
+			EXPECT_EQ(resSeq[i].first.phi, resPar[i].first.phi);
+			EXPECT_EQ(resSeq[i].second, resPar[i].second);
+		}
+	}
+	mrpt::WorkerThreadsPool::overrideNumCores(formerNumCores);
+}
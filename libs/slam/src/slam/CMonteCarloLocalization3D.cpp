@@ -190,6 +190,22 @@ double
 	return ret;
 }
 
+bool CMonteCarloLocalization3D::PF_SLAM_prepareConcurrentLikelihood(
+	const CSensoryFrame& observation, const TPoint3D& posesMin,
+	const TPoint3D& posesMax)
+{
+	if (options.metricMap)
+		return options.metricMap->prepareForConcurrentLikelihood(
+			observation, posesMin, posesMax);
+
+	bool ok = true;
+	for (auto* map : options.metricMaps)
+		ok = map->prepareForConcurrentLikelihood(
+				 observation, posesMin, posesMax) &&
+			ok;
+	return ok;
+}
+
 // Specialization for my kind of particles:
 void CMonteCarloLocalization3D::
 	PF_SLAM_implementation_custom_update_particle_with_new_pose(
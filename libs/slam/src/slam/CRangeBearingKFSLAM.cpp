@@ -175,7 +175,7 @@ void CRangeBearingKFSLAM::getCurrentState(
 	out_fullState.resize(m_xkk.size());
 	std::copy(m_xkk.begin(), m_xkk.end(), out_fullState.begin());
 	// Full cov:
-	out_fullCovariance = m_pkk;
+	getFullCovariance(out_fullCovariance);
 
 	MRPT_END
 }
@@ -192,9 +192,7 @@ void CRangeBearingKFSLAM::processActionObservation(
 	m_SF = SF;
 
 	// Sanity check:
-	ASSERT_(
-		m_IDs.size() ==
-		(m_pkk.cols() - get_vehicle_size()) / get_feature_size());
+	ASSERT_(m_IDs.size() == getNumberOfLandmarksInTheMap());
 
 	// ===================================================================================================================
 	// Here's the meat!: Call the main method for the KF algorithm, which will
@@ -1003,10 +1001,7 @@ void CRangeBearingKFSLAM::getAs3DObject(
 		pointGauss.mean.z(
 			m_xkk[get_vehicle_size() + get_feature_size() * i + 2]);
 
-		pointGauss.cov =
-			m_pkk.blockCopy<get_feature_size(), get_feature_size()>(
-				get_vehicle_size() + get_feature_size() * i,
-				get_vehicle_size() + get_feature_size() * i);
+		getLandmarkCov(i, pointGauss.cov);
 
 		auto ellip = opengl::CEllipsoid3D::Create();
 
@@ -1172,7 +1167,8 @@ double CRangeBearingKFSLAM::computeOffDiagonalBlocksApproximationError(
 	MRPT_START
 
 	// Compute the information matrix:
-	CMatrixDynamic<kftype> fullCov(m_pkk);
+	CMatrixDynamic<kftype> fullCov;
+	getFullCovariance(fullCov);
 	size_t i;
 	for (i = 0; i < get_vehicle_size(); i++)
 		fullCov(i, i) = max(fullCov(i, i), 1e-6);
@@ -1265,9 +1261,11 @@ void CRangeBearingKFSLAM::saveMapAndPath2DRepresentationAsMATLABFile(
 	{
 		size_t idx = get_vehicle_size() + i * get_feature_size();
 
-		cov(0, 0) = m_pkk(idx + 0, idx + 0);
-		cov(1, 1) = m_pkk(idx + 1, idx + 1);
-		cov(0, 1) = cov(1, 0) = m_pkk(idx + 0, idx + 1);
+		KFMatrix_FxF lmCov;
+		getLandmarkCov(i, lmCov);
+		cov(0, 0) = lmCov(0, 0);
+		cov(1, 1) = lmCov(1, 1);
+		cov(0, 1) = cov(1, 0) = lmCov(0, 1);
 
 		mean[0] = m_xkk[idx + 0];
 		mean[1] = m_xkk[idx + 1];
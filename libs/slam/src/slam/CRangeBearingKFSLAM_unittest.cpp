@@ -0,0 +1,124 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2020, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include <gtest/gtest.h>
+#include <mrpt/config/CConfigFile.h>
+#include <mrpt/obs/CRawlog.h>
+#include <mrpt/slam/CRangeBearingKFSLAM.h>
+#include <mrpt/slam/CRangeBearingKFSLAM2D.h>
+#include <mrpt/system/filesystem.h>
+#include <test_mrpt_common.h>
+
+using namespace mrpt;
+using namespace mrpt::bayes;
+using namespace mrpt::slam;
+using namespace mrpt::math;
+using namespace mrpt::obs;
+using namespace std;
+
+static string kfslam_ini_file()
+{
+	return UNITTEST_BASEDIR +
+		string("/share/mrpt/config_files/kf-slam/EKF-SLAM_test.ini");
+}
+static string kfslam_rawlog_file()
+{
+	return UNITTEST_BASEDIR +
+		string("/share/mrpt/datasets/kf-slam_demo.rawlog");
+}
+
+// Runs the KF-SLAM over the demo dataset, and returns its final state:
+template <class KFSLAM, class POSE_PDF, class POINT>
+void run_kfslam(
+	TKFMethod method, unsigned int SEIF_max_active_landmarks,
+	CVectorDouble& fullState, CMatrixDouble& fullCov,
+	CMatrixDouble& robotPoseCov)
+{
+	KFSLAM kf;
+	kf.loadOptions(mrpt::config::CConfigFile(kfslam_ini_file()));
+	kf.KF_options.method = method;
+	kf.KF_options.SEIF_max_active_landmarks = SEIF_max_active_landmarks;
+	kf.KF_options.verbosity_level = mrpt::system::LVL_ERROR;
+
+	CRawlog rawlog;
+	ASSERT_(rawlog.loadFromRawLogFile(kfslam_rawlog_file()));
+
+	CActionCollection::Ptr action;
+	CSensoryFrame::Ptr SF;
+	size_t rawlogEntry = 0;
+	while (rawlogEntry + 1 < rawlog.size() &&
+		   rawlog.getActionObservationPair(action, SF, rawlogEntry))
+		kf.processActionObservation(action, SF);
+
+	POSE_PDF robotPose;
+	std::vector<POINT> LMs;
+	std::map<unsigned int, mrpt::maps::CLandmark::TLandmarkID> LM_IDs;
+	kf.getCurrentState(robotPose, LMs, LM_IDs, fullState, fullCov);
+	EXPECT_GT(LMs.size(), 10U);
+	robotPoseCov = CMatrixDouble(robotPose.cov);
+}
+
+template <class MAT>
+double maxAbsDiff(const MAT& a, const MAT& b)
+{
+	return (a.asEigen() - b.asEigen()).cwiseAbs().maxCoeff();
+}
+
+template <class KFSLAM, class POSE_PDF, class POINT>
+void test_kfslam_seif()
+{
+	if (!mrpt::system::fileExists(kfslam_ini_file()) ||
+		!mrpt::system::fileExists(kfslam_rawlog_file()))
+	{
+		cerr << "WARNING: Skipping test due to missing file: "
+			 << kfslam_rawlog_file() << "\n";
+		return;
+	}
+
+	CVectorDouble x_ekf, x_seif, x_sparse;
+	CMatrixDouble P_ekf, P_seif, P_sparse, Pv_ekf, Pv_seif, Pv_sparse;
+	run_kfslam<KFSLAM, POSE_PDF, POINT>(kfEKFNaive, 0, x_ekf, P_ekf, Pv_ekf);
+
+	// Without sparsification, the SEIF is an exact EKF in information form:
+	run_kfslam<KFSLAM, POSE_PDF, POINT>(
+		kfSEIF, 100000, x_seif, P_seif, Pv_seif);
+	ASSERT_EQ(x_seif.size(), x_ekf.size());
+	ASSERT_EQ(P_seif.cols(), P_ekf.cols());
+	EXPECT_NEAR(maxAbsDiff(x_seif, x_ekf), 0, 1e-4);
+	EXPECT_NEAR(maxAbsDiff(P_seif, P_ekf), 0, 1e-5);
+	EXPECT_NEAR(maxAbsDiff(Pv_seif, Pv_ekf), 0, 1e-5);
+
+	// Sparsified: an approximation to the EKF:
+	run_kfslam<KFSLAM, POSE_PDF, POINT>(
+		kfSEIF, 4, x_sparse, P_sparse, Pv_sparse);
+	ASSERT_EQ(x_sparse.size(), x_ekf.size());
+	ASSERT_EQ(P_sparse.cols(), P_ekf.cols());
+	EXPECT_NEAR(maxAbsDiff(x_sparse, x_ekf), 0, 0.05);
+	EXPECT_NEAR(maxAbsDiff(P_sparse, P_ekf), 0, 0.05);
+	// The vehicle covariance must be that of the sparsified information:
+	const auto nV = Pv_sparse.cols();
+	EXPECT_NEAR(
+		maxAbsDiff(
+			Pv_sparse, CMatrixDouble(P_sparse.asEigen().block(0, 0, nV, nV))),
+		0, 1e-9);
+}
+
+TEST(CRangeBearingKFSLAM, SEIF_vs_EKF)
+{
+	test_kfslam_seif<
+		CRangeBearingKFSLAM, mrpt::poses::CPose3DQuatPDFGaussian,
+		mrpt::math::TPoint3D>();
+}
+
+TEST(CRangeBearingKFSLAM2D, SEIF_vs_EKF)
+{
+	test_kfslam_seif<
+		CRangeBearingKFSLAM2D, mrpt::poses::CPosePDFGaussian,
+		mrpt::math::TPoint2D>();
+}
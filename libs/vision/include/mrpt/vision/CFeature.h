@@ -9,6 +9,7 @@
    */
 #pragma once
 
+#include <mrpt/core/aligned_std_vector.h>
 #include <mrpt/img/CImage.h>
 #include <mrpt/math/CMatrixF.h>
 #include <mrpt/math/KDTreeCapable.h>
@@ -269,6 +270,41 @@ class CFeature : public mrpt::serialization::CSerializable
 
 };  // end of class
 
+/** The descriptors of one type of all the features in a CFeatureList, packed
+ * as the rows of one contiguous and aligned buffer, as required by fast
+ * matching algorithms (see mrpt::vision::matchDescriptors()).
+ * Rows are zero-padded to a multiple of 32 bytes.
+ *
+ * SIFT, ORB, BLD and LATCH descriptors are stored in \a bytes, while SURF and
+ * spin image descriptors are stored in \a floats.
+ *
+ * \sa CFeatureList::getPackedDescriptors()
+ * \note (New in MRPT 2.1.0)
+ */
+struct TPackedDescriptors
+{
+	/** The type of the packed descriptors */
+	TDescriptorType type{descAny};
+	/** Number of descriptors (the number of features in the list) */
+	size_t rows{0};
+	/** Number of elements of each descriptor */
+	size_t length{0};
+	/** Number of elements between consecutive rows (length plus padding) */
+	size_t stride{0};
+	mrpt::aligned_std_vector<uint8_t> bytes;
+	mrpt::aligned_std_vector<float> floats;
+
+	/** Whether descriptors are compared with the Hamming distance (ORB), or
+	 * with the Euclidean distance (all other types) */
+	bool isBinary() const { return type == descORB; }
+	bool isFloat() const
+	{
+		return type == descSURF || type == descSpinImages;
+	}
+	const uint8_t* rowBytes(size_t i) const { return &bytes[i * stride]; }
+	const float* rowFloats(size_t i) const { return &floats[i * stride]; }
+};
+
 /** A list of visual features, to be used as output by detectors, as
  * input/output by trackers, etc.
  */
@@ -300,6 +336,17 @@ class CFeatureList : public mrpt::math::KDTreeCapable<CFeatureList>
 	/** Get the maximum ID into the list */
 	TFeatureID getMaxID() const;
 
+	/** Packs the descriptors of the given type of all features into one
+	 * contiguous buffer. Supported types are descSIFT, descSURF,
+	 * descSpinImages, descORB, descBLD and descLATCH.
+	 * \exception std::exception If any feature lacks that descriptor, or
+	 * their lengths differ.
+	 * \sa mrpt::vision::matchDescriptors()
+	 * \note (New in MRPT 2.1.0)
+	 */
+	void getPackedDescriptors(
+		TDescriptorType type, TPackedDescriptors& out) const;
+
 	/** Get a reference to a Feature from its ID */
 	const CFeature* getByID(const TFeatureID& ID) const;
 	const CFeature* getByID(const TFeatureID& ID, int& out_idx) const;
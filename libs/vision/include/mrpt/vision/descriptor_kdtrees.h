@@ -10,7 +10,10 @@
 #pragma once
 
 #include <mrpt/vision/CFeature.h>
+#include <mrpt/vision/descriptor_pairing.h>
 #include <mrpt/vision/types.h>
+#include <cstdint>
+#include <vector>
 
 namespace mrpt
 {
@@ -149,6 +152,144 @@ struct TSURFDescriptorsKDTreeIndex
 	const CFeatureList& m_feats;
 };  // end of TSURFDescriptorsKDTreeIndex
 
+/** Approximate nearest neighbors index for binary descriptors (ORB), with
+ * multi-probe Locality Sensitive Hashing (LSH) on the Hamming distance.
+ *
+ * Each of the `numTables` hash tables uses as key `keyBits` randomly-chosen
+ * bits of the descriptor. A query looks up its own bucket in each table and,
+ * with `multiProbeLevel>0`, also the buckets whose keys differ in up to that
+ * number of bits. Candidates are then ranked with their exact distance.
+ * Recall increases (and speed decreases) with more tables, fewer key bits,
+ * and a higher multi-probe level.
+ *
+ *  \code
+ *    TPackedDescriptors db;
+ *    dbFeats.getPackedDescriptors(descORB, db);
+ *    TBinaryDescriptorsLSHIndex index;
+ *    index.build(db);
+ *    std::vector<TDescriptorMatch> nn;
+ *    index.knnSearch(queries, queryRow, 2, nn);
+ *  \endcode
+ * \sa TDescriptorsKDForestIndex, CFeatureList::getPackedDescriptors
+ * \note (New in MRPT 2.1.0)
+ */
+struct TBinaryDescriptorsLSHIndex
+{
+   public:
+	struct TOptions
+	{
+		/** Number of hash tables */
+		unsigned int numTables{6};
+		/** Number of bits in the key of each table (max: 24). Each table has
+		 * an array of `2^keyBits` bucket offsets. Values close to
+		 * `log2(number of descriptors)` are a good trade-off. */
+		unsigned int keyBits{16};
+		/** Also probe buckets at this Hamming distance (0, 1 or 2) from the
+		 * query key */
+		unsigned int multiProbeLevel{1};
+		/** Seed for the selection of key bits */
+		uint32_t randomSeed{1234};
+	};
+	/** Must be set before calling build() */
+	TOptions options;
+
+	/** Builds the index from a copy of the given descriptors, which must be
+	 * binary (descORB).
+	 * \exception std::exception On invalid descriptors or options. */
+	void build(const TPackedDescriptors& descriptors);
+
+	/** Number of indexed descriptors */
+	size_t size() const { return m_data.rows; }
+
+	/** Approximate search of the (up to) `k` nearest neighbors of row
+	 * `queryRow` of `queries`, which must have the same type and length of
+	 * the indexed descriptors. Output entries have `idx1=queryRow`, `idx2`
+	 * the index of the neighbor, and are sorted by increasing distance.
+	 * `k` must be at least 1.
+	 * \return The number of neighbors found (may be less than `k`). */
+	size_t knnSearch(
+		const TPackedDescriptors& queries, size_t queryRow, size_t k,
+		std::vector<TDescriptorMatch>& out) const;
+
+   private:
+	TPackedDescriptors m_data;
+	/** For each table: the bit indices used as key */
+	std::vector<std::vector<uint32_t>> m_keyBits;
+	/** For each table: the descriptor indices, sorted by key, and the offset
+	 * of the first one of each key (`2^keyBits+1` entries) */
+	std::vector<std::vector<uint32_t>> m_bucketIdxs, m_bucketStart;
+
+	uint32_t computeKey(size_t table, const uint8_t* desc) const;
+};
+
+/** Approximate nearest neighbors index for descriptors compared with the
+ * Euclidean distance (SIFT, SURF, spin images, BLD, LATCH), with a forest of
+ * randomized KD-trees (Silpa-Anan & Hartley, as popularized by FLANN).
+ *
+ * Each tree splits at the mean of a dimension chosen randomly among those
+ * with the largest variance, hence trees are different. All trees are
+ * searched at once in best-bin-first order, until `maxChecks` descriptors
+ * have been compared. Recall increases (and speed decreases) with both
+ * `numTrees` and `maxChecks`.
+ *
+ * \sa TBinaryDescriptorsLSHIndex, CFeatureList::getPackedDescriptors
+ * \note (New in MRPT 2.1.0)
+ */
+struct TDescriptorsKDForestIndex
+{
+   public:
+	struct TOptions
+	{
+		/** Number of randomized trees */
+		unsigned int numTrees{4};
+		/** Maximum number of descriptors in a leaf */
+		unsigned int leafSize{8};
+		/** Split dimensions are drawn from this many with the largest
+		 * variance */
+		unsigned int randomDims{5};
+		/** Seed for the random choice of split dimensions */
+		uint32_t randomSeed{1234};
+	};
+	/** Must be set before calling build() */
+	TOptions options;
+
+	/** Maximum number of distance evaluations per query. Can be changed
+	 * without rebuilding the index. */
+	size_t maxChecks{256};
+
+	/** Builds the index from a copy of the given descriptors, which must not
+	 * be binary.
+	 * \exception std::exception On invalid descriptors or options. */
+	void build(const TPackedDescriptors& descriptors);
+
+	/** Number of indexed descriptors */
+	size_t size() const { return m_data.rows; }
+
+	/** Approximate search of the (up to) `k` nearest neighbors. See
+	 * TBinaryDescriptorsLSHIndex::knnSearch() */
+	size_t knnSearch(
+		const TPackedDescriptors& queries, size_t queryRow, size_t k,
+		std::vector<TDescriptorMatch>& out) const;
+
+	struct TNode
+	{
+		/** Split dimension, or -1 for leaves */
+		int32_t dim{-1};
+		/** Split value, for inner nodes */
+		float split{0};
+		/** Children indices (inner nodes), or range in the list of
+		 * descriptor indices of the tree (leaves) */
+		uint32_t first{0}, second{0};
+	};
+
+   private:
+	TPackedDescriptors m_data;
+	/** For each tree: its nodes (the root is the first one) and the
+	 * descriptor indices referenced by its leaves */
+	std::vector<std::vector<TNode>> m_nodes;
+	std::vector<std::vector<uint32_t>> m_leafIdxs;
+};
+
 /** @} */
 
 namespace detail
@@ -9,7 +9,9 @@
 
 #pragma once
 
+#include <mrpt/vision/CFeature.h>
 #include <mrpt/vision/types.h>
+#include <limits>
 
 namespace mrpt::vision
 {
@@ -149,5 +151,60 @@ size_t find_descriptor_pairings(
 	MRPT_END
 }
 
+/** One pairing found by matchDescriptors() \note (New in MRPT 2.1.0) */
+struct TDescriptorMatch
+{
+	TDescriptorMatch() = default;
+	TDescriptorMatch(size_t i1, size_t i2, float d)
+		: idx1(i1), idx2(i2), distance(d)
+	{
+	}
+	/** Row indices in the first and second descriptor sets */
+	size_t idx1{0}, idx2{0};
+	/** Hamming distance (ORB) or Euclidean distance (all other types) */
+	float distance{0};
+};
+
+/** Parameters for matchDescriptors() \note (New in MRPT 2.1.0) */
+struct TDescriptorMatchingParams
+{
+	/** Lowe's ratio test: a match is accepted only if its distance is below
+	 * `maxRatio` times the distance to the second-best candidate. Set to 1
+	 * (or larger) to disable. */
+	float maxRatio{0.8f};
+	/** Matches with a larger distance are discarded. */
+	float maxDistance{std::numeric_limits<float>::max()};
+	/** Keep only pairs (i,j) where `i` is also the best match of `j`. */
+	bool crossCheck{true};
+	/** Number of threads (0=all cores). */
+	unsigned int numThreads{1};
+};
+
+/** Brute-force matching between two blocks of packed descriptors, as
+ * returned by CFeatureList::getPackedDescriptors(). For each row of `d1`,
+ * all rows of `d2` are scanned and the best one is kept if it passes the
+ * ratio test, the distance threshold, and (optionally) the cross-check.
+ *
+ * Distances are the same as in CFeature::descriptorDistanceTo() (without
+ * normalization): Hamming for ORB, Euclidean for the rest. The inner loops
+ * use AVX2 if available, and rows of `d1` can be split among several threads.
+ * The output is independent of the number of threads and of the SIMD path.
+ *
+ * \code
+ *  TPackedDescriptors d1, d2;
+ *  feats1.getPackedDescriptors(descORB, d1);
+ *  feats2.getPackedDescriptors(descORB, d2);
+ *  std::vector<TDescriptorMatch> matches;
+ *  mrpt::vision::matchDescriptors(d1, d2, matches);
+ * \endcode
+ *
+ * \return The number of matches, sorted by `idx1`.
+ * \note (New in MRPT 2.1.0)
+ */
+size_t matchDescriptors(
+	const TPackedDescriptors& d1, const TPackedDescriptors& d2,
+	std::vector<TDescriptorMatch>& matches,
+	const TDescriptorMatchingParams& params = TDescriptorMatchingParams());
+
 /** @} */
 }  // namespace mrpt::vision
@@ -1083,6 +1083,84 @@ void CFeatureList::copyListFrom(const CFeatureList& otherList)
 	}
 }  // end-copyListFrom
 
+template <typename T, typename GET>
+static void packDescriptors(
+	const CFeatureList& feats, GET get, const char* name,
+	TPackedDescriptors& out, mrpt::aligned_std_vector<T>& buf)
+{
+	for (size_t i = 0; i < feats.size(); i++)
+	{
+		const auto& d = get(feats[i].descriptors);
+		if (!d)
+			THROW_EXCEPTION_FMT(
+				"Feature #%u has no %s descriptor", static_cast<unsigned>(i),
+				name);
+		if (i == 0)
+			out.length = d->size();
+		else
+			ASSERT_EQUAL_(d->size(), out.length);
+	}
+	// Pad rows to 32 bytes:
+	constexpr size_t pad = 32 / sizeof(T);
+	out.stride = ((out.length + pad - 1) / pad) * pad;
+	buf.assign(out.rows * out.stride, T(0));
+	for (size_t i = 0; i < feats.size(); i++)
+	{
+		const auto& d = *get(feats[i].descriptors);
+		std::copy(d.begin(), d.end(), &buf[i * out.stride]);
+	}
+}
+
+void CFeatureList::getPackedDescriptors(
+	TDescriptorType type, TPackedDescriptors& out) const
+{
+	MRPT_START
+	out.type = type;
+	out.rows = size();
+	out.length = out.stride = 0;
+	out.bytes.clear();
+	out.floats.clear();
+	using D = CFeature::TDescriptors;
+	switch (type)
+	{
+		case descSIFT:
+			packDescriptors(
+				*this, [](const D& d) -> auto& { return d.SIFT; }, "SIFT", out,
+				out.bytes);
+			break;
+		case descSURF:
+			packDescriptors(
+				*this, [](const D& d) -> auto& { return d.SURF; }, "SURF", out,
+				out.floats);
+			break;
+		case descSpinImages:
+			packDescriptors(
+				*this, [](const D& d) -> auto& { return d.SpinImg; },
+				"SpinImg", out, out.floats);
+			break;
+		case descORB:
+			packDescriptors(
+				*this, [](const D& d) -> auto& { return d.ORB; }, "ORB", out,
+				out.bytes);
+			break;
+		case descBLD:
+			packDescriptors(
+				*this, [](const D& d) -> auto& { return d.BLD; }, "BLD", out,
+				out.bytes);
+			break;
+		case descLATCH:
+			packDescriptors(
+				*this, [](const D& d) -> auto& { return d.LATCH; }, "LATCH",
+				out, out.bytes);
+			break;
+		default:
+			THROW_EXCEPTION_FMT(
+				"Descriptor type cannot be packed: %u",
+				static_cast<unsigned>(type));
+	};
+	MRPT_END
+}
+
 const CFeature* CFeatureList::getByID(const TFeatureID& ID) const
 {
 	for (const auto& f : *this)
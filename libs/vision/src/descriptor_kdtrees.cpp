@@ -0,0 +1,427 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2020, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include "vision-precomp.h"  // Precompiled headers
+
+#include <mrpt/random/RandomGenerators.h>
+#include <mrpt/vision/descriptor_kdtrees.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <queue>
+
+// Prototypes of the distance kernels:
+#include "descriptor_pairing.SSEx.h"
+
+using namespace mrpt;
+using namespace mrpt::vision;
+
+namespace
+{
+/** The k best (squared distance, index) pairs found so far */
+class KnnResults
+{
+   public:
+	explicit KnnResults(size_t k) : m_k(k) { m_res.reserve(k + 1); }
+
+	float worst() const
+	{
+		return m_res.size() < m_k ? std::numeric_limits<float>::max()
+								  : m_res.back().first;
+	}
+	void insert(float d, uint32_t idx)
+	{
+		if (d >= worst()) return;
+		for (const auto& r : m_res)
+			if (r.second == idx) return;  // Already found in another tree
+		const auto it = std::upper_bound(
+			m_res.begin(), m_res.end(), std::make_pair(d, idx));
+		m_res.insert(it, std::make_pair(d, idx));
+		if (m_res.size() > m_k) m_res.pop_back();
+	}
+	size_t toMatches(
+		size_t queryRow, bool sqrtDist, std::vector<TDescriptorMatch>& out)
+	{
+		out.clear();
+		for (const auto& r : m_res)
+			out.emplace_back(
+				queryRow, r.second, sqrtDist ? std::sqrt(r.first) : r.first);
+		return out.size();
+	}
+
+   private:
+	const size_t m_k;
+	std::vector<std::pair<float, uint32_t>> m_res;
+};
+
+void checkQuery(
+	const TPackedDescriptors& data, const TPackedDescriptors& queries,
+	size_t queryRow, size_t k)
+{
+	ASSERTMSG_(queries.type == data.type, "Descriptor types do not match");
+	ASSERT_EQUAL_(queries.length, data.length);
+	ASSERT_EQUAL_(queries.stride, data.stride);
+	ASSERT_LT_(queryRow, queries.rows);
+	ASSERT_GT_(k, 0U);
+}
+}  // namespace
+
+// --------------------------------------------------
+//        TBinaryDescriptorsLSHIndex
+// --------------------------------------------------
+void TBinaryDescriptorsLSHIndex::build(const TPackedDescriptors& descriptors)
+{
+	MRPT_START
+
+	ASSERTMSG_(
+		descriptors.isBinary(), "LSH index requires binary descriptors");
+	ASSERT_EQUAL_(
+		descriptors.bytes.size(), descriptors.rows * descriptors.stride);
+	ASSERT_LT_(descriptors.rows, std::numeric_limits<uint32_t>::max());
+	ASSERT_GE_(options.numTables, 1U);
+	ASSERT_GE_(options.keyBits, 1U);
+	ASSERT_LE_(options.keyBits, 24U);
+	ASSERT_LE_(options.keyBits, 8 * descriptors.length);
+	ASSERT_LE_(options.multiProbeLevel, 2U);
+
+	m_data = descriptors;
+
+	const size_t N = m_data.rows, nTables = options.numTables;
+	const uint32_t nKeys = 1U << options.keyBits;
+	const uint32_t nBits = static_cast<uint32_t>(8 * m_data.length);
+
+	mrpt::random::CRandomGenerator rng(options.randomSeed);
+	m_keyBits.assign(nTables, {});
+	m_bucketIdxs.assign(nTables, {});
+	m_bucketStart.assign(nTables, {});
+
+	std::vector<uint32_t> allBits(nBits), keys(N);
+	for (size_t t = 0; t < nTables; t++)
+	{
+		// Random subset of bits (partial Fisher-Yates shuffle):
+		std::iota(allBits.begin(), allBits.end(), 0);
+		for (uint32_t i = 0; i < options.keyBits; i++)
+			std::swap(
+				allBits[i], allBits[i + rng.drawUniform32bit() % (nBits - i)]);
+		m_keyBits[t].assign(
+			allBits.begin(), allBits.begin() + options.keyBits);
+
+		// Counting sort of descriptors by key:
+		auto& start = m_bucketStart[t];
+		start.assign(nKeys + 1, 0);
+		for (size_t i = 0; i < N; i++)
+		{
+			keys[i] = computeKey(t, m_data.rowBytes(i));
+			start[keys[i] + 1]++;
+		}
+		std::partial_sum(start.begin(), start.end(), start.begin());
+
+		auto& idxs = m_bucketIdxs[t];
+		idxs.resize(N);
+		std::vector<uint32_t> next(start.begin(), start.end() - 1);
+		for (size_t i = 0; i < N; i++)
+			idxs[next[keys[i]]++] = static_cast<uint32_t>(i);
+	}
+
+	MRPT_END
+}
+
+uint32_t TBinaryDescriptorsLSHIndex::computeKey(
+	size_t table, const uint8_t* desc) const
+{
+	const auto& bits = m_keyBits[table];
+	uint32_t key = 0;
+	for (size_t j = 0; j < bits.size(); j++)
+		key |= static_cast<uint32_t>((desc[bits[j] >> 3] >> (bits[j] & 7)) & 1)
+			<< j;
+	return key;
+}
+
+size_t TBinaryDescriptorsLSHIndex::knnSearch(
+	const TPackedDescriptors& queries, size_t queryRow, size_t k,
+	std::vector<TDescriptorMatch>& out) const
+{
+	MRPT_START
+	checkQuery(m_data, queries, queryRow, k);
+	ASSERTMSG_(!m_keyBits.empty(), "build() must be called first");
+
+	const uint8_t* q = queries.rowBytes(queryRow);
+	const unsigned int nKeyBits = options.keyBits;
+
+	// Gather candidates from all probed buckets:
+	std::vector<uint32_t> cands;
+	for (size_t t = 0; t < m_keyBits.size(); t++)
+	{
+		const auto& start = m_bucketStart[t];
+		const auto& idxs = m_bucketIdxs[t];
+		const auto probe = [&](uint32_t key) {
+			cands.insert(
+				cands.end(), idxs.begin() + start[key],
+				idxs.begin() + start[key + 1]);
+		};
+		const uint32_t key = computeKey(t, q);
+		probe(key);
+		if (options.multiProbeLevel < 1) continue;
+		for (unsigned int b1 = 0; b1 < nKeyBits; b1++)
+		{
+			probe(key ^ (1U << b1));
+			if (options.multiProbeLevel < 2) continue;
+			for (unsigned int b2 = b1 + 1; b2 < nKeyBits; b2++)
+				probe(key ^ (1U << b1) ^ (1U << b2));
+		}
+	}
+	std::sort(cands.begin(), cands.end());
+	cands.erase(std::unique(cands.begin(), cands.end()), cands.end());
+
+	const auto kernel = desc_select_u8_kernel(true);
+	KnnResults res(k);
+	for (const uint32_t idx : cands)
+	{
+		float d;
+		kernel(q, m_data.rowBytes(idx), 1, m_data.stride, &d);
+		res.insert(d, idx);
+	}
+	return res.toMatches(queryRow, false, out);
+	MRPT_END
+}
+
+// --------------------------------------------------
+//        TDescriptorsKDForestIndex
+// --------------------------------------------------
+namespace
+{
+template <typename T>
+class KDForestBuilder
+{
+   public:
+	using TNode = TDescriptorsKDForestIndex::TNode;
+
+	KDForestBuilder(
+		const T* data, size_t stride, size_t dims,
+		const TDescriptorsKDForestIndex::TOptions& opts,
+		mrpt::random::CRandomGenerator& rng, std::vector<TNode>& nodes,
+		std::vector<uint32_t>& idxs)
+		: m_data(data),
+		  m_stride(stride),
+		  m_dims(dims),
+		  m_opts(opts),
+		  m_rng(rng),
+		  m_nodes(nodes),
+		  m_idxs(idxs),
+		  m_mean(dims),
+		  m_var(dims),
+		  m_order(dims)
+	{
+	}
+
+	/** Builds the subtree for descriptors in idxs[first,last), returning the
+	 * index of its root node */
+	uint32_t build(uint32_t first, uint32_t last)
+	{
+		const uint32_t nodeIdx = static_cast<uint32_t>(m_nodes.size());
+		m_nodes.emplace_back();
+		TNode node;
+		node.first = first;
+		node.second = last;
+		if (last - first > m_opts.leafSize) chooseSplit(first, last, node);
+		if (node.dim < 0)
+		{
+			m_nodes[nodeIdx] = node;
+			return nodeIdx;
+		}
+
+		// Partition at the split value. If all descriptors fall in the same
+		// side (e.g. repeated values), split at the median instead:
+		const auto val = [&](uint32_t i) {
+			return static_cast<float>(m_data[i * m_stride + node.dim]);
+		};
+		auto* itFirst = &m_idxs[first];
+		auto* itLast = itFirst + (last - first);
+		auto* itMid = std::partition(
+			itFirst, itLast, [&](uint32_t i) { return val(i) < node.split; });
+		if (itMid == itFirst || itMid == itLast)
+		{
+			itMid = itFirst + (last - first) / 2;
+			std::nth_element(
+				itFirst, itMid, itLast,
+				[&](uint32_t a, uint32_t b) { return val(a) < val(b); });
+			node.split = val(*itMid);
+		}
+		const auto mid = static_cast<uint32_t>(first + (itMid - itFirst));
+		node.first = build(first, mid);
+		node.second = build(mid, last);
+		m_nodes[nodeIdx] = node;
+		return nodeIdx;
+	}
+
+   private:
+	const T* m_data;
+	const size_t m_stride, m_dims;
+	const TDescriptorsKDForestIndex::TOptions& m_opts;
+	mrpt::random::CRandomGenerator& m_rng;
+	std::vector<TNode>& m_nodes;
+	std::vector<uint32_t>& m_idxs;
+	std::vector<double> m_mean, m_var;
+	std::vector<uint32_t> m_order;
+
+	/** Picks a random dimension among those with the largest variance, and
+	 * its mean as split value. Leaves `node.dim=-1` if all are constant. */
+	void chooseSplit(uint32_t first, uint32_t last, TNode& node)
+	{
+		// Estimate statistics from a subsample, as in FLANN:
+		constexpr uint32_t MAX_SAMPLES = 100;
+		const uint32_t n = last - first;
+		const uint32_t nSamples = std::min(n, MAX_SAMPLES);
+		std::fill(m_mean.begin(), m_mean.end(), 0.0);
+		std::fill(m_var.begin(), m_var.end(), 0.0);
+		for (uint32_t s = 0; s < nSamples; s++)
+		{
+			const T* row =
+				m_data + m_idxs[first + (s * size_t(n)) / nSamples] * m_stride;
+			for (size_t d = 0; d < m_dims; d++)
+			{
+				m_mean[d] += row[d];
+				m_var[d] += double(row[d]) * row[d];
+			}
+		}
+		for (size_t d = 0; d < m_dims; d++)
+		{
+			m_mean[d] /= nSamples;
+			m_var[d] = m_var[d] / nSamples - m_mean[d] * m_mean[d];
+		}
+
+		const size_t nTop =
+			std::min<size_t>(std::max(1U, m_opts.randomDims), m_dims);
+		std::iota(m_order.begin(), m_order.end(), 0);
+		std::partial_sort(
+			m_order.begin(), m_order.begin() + nTop, m_order.end(),
+			[&](uint32_t a, uint32_t b) { return m_var[a] > m_var[b]; });
+		const uint32_t dim = m_order[m_rng.drawUniform32bit() % nTop];
+		if (!(m_var[dim] > 0)) return;
+		node.dim = static_cast<int32_t>(dim);
+		node.split = static_cast<float>(m_mean[dim]);
+	}
+};
+
+template <typename T, typename KERNEL>
+size_t kdForestSearch(
+	const T* q, const T* data, size_t stride,
+	const std::vector<std::vector<TDescriptorsKDForestIndex::TNode>>& nodes,
+	const std::vector<std::vector<uint32_t>>& leafIdxs, KERNEL kernel,
+	size_t maxChecks, KnnResults& res)
+{
+	struct Branch
+	{
+		float bound;
+		uint32_t tree, node;
+		bool operator<(const Branch& o) const { return bound > o.bound; }
+	};
+	std::priority_queue<Branch> branches;
+	size_t checks = 0;
+
+	// Descends to a leaf, queuing the non-visited branches by their
+	// (approximate) lower bound distance:
+	const auto descend = [&](uint32_t tree, uint32_t nodeIdx, float bound) {
+		const auto& tNodes = nodes[tree];
+		for (;;)
+		{
+			const auto& node = tNodes[nodeIdx];
+			if (node.dim < 0) break;
+			const float diff = static_cast<float>(q[node.dim]) - node.split;
+			const float farBound = bound + diff * diff;
+			if (farBound < res.worst())
+				branches.push(
+					{farBound, tree, diff < 0 ? node.second : node.first});
+			nodeIdx = diff < 0 ? node.first : node.second;
+		}
+		const auto& node = tNodes[nodeIdx];
+		for (uint32_t i = node.first; i < node.second; i++)
+		{
+			const uint32_t idx = leafIdxs[tree][i];
+			float d;
+			kernel(q, data + idx * stride, 1, stride, &d);
+			res.insert(d, idx);
+			checks++;
+		}
+	};
+
+	for (uint32_t t = 0; t < nodes.size(); t++) descend(t, 0, 0);
+	while (!branches.empty() && checks < maxChecks)
+	{
+		const Branch b = branches.top();
+		branches.pop();
+		if (b.bound >= res.worst()) break;
+		descend(b.tree, b.node, b.bound);
+	}
+	return checks;
+}
+}  // namespace
+
+void TDescriptorsKDForestIndex::build(const TPackedDescriptors& descriptors)
+{
+	MRPT_START
+
+	ASSERTMSG_(
+		!descriptors.isBinary(),
+		"KD-forest index requires non-binary descriptors");
+	const size_t dataSize = descriptors.isFloat() ? descriptors.floats.size()
+												  : descriptors.bytes.size();
+	ASSERT_EQUAL_(dataSize, descriptors.rows * descriptors.stride);
+	ASSERT_LT_(descriptors.rows, std::numeric_limits<uint32_t>::max());
+	ASSERT_GE_(options.numTrees, 1U);
+	ASSERT_GE_(options.leafSize, 1U);
+
+	m_data = descriptors;
+	const auto N = static_cast<uint32_t>(m_data.rows);
+
+	mrpt::random::CRandomGenerator rng(options.randomSeed);
+	m_nodes.assign(options.numTrees, {});
+	m_leafIdxs.assign(options.numTrees, {});
+	for (size_t t = 0; t < options.numTrees; t++)
+	{
+		auto& idxs = m_leafIdxs[t];
+		idxs.resize(N);
+		std::iota(idxs.begin(), idxs.end(), 0);
+		if (m_data.isFloat())
+			KDForestBuilder<float>(
+				m_data.floats.data(), m_data.stride, m_data.length, options,
+				rng, m_nodes[t], idxs)
+				.build(0, N);
+		else
+			KDForestBuilder<uint8_t>(
+				m_data.bytes.data(), m_data.stride, m_data.length, options,
+				rng, m_nodes[t], idxs)
+				.build(0, N);
+	}
+
+	MRPT_END
+}
+
+size_t TDescriptorsKDForestIndex::knnSearch(
+	const TPackedDescriptors& queries, size_t queryRow, size_t k,
+	std::vector<TDescriptorMatch>& out) const
+{
+	MRPT_START
+	checkQuery(m_data, queries, queryRow, k);
+	ASSERTMSG_(!m_nodes.empty(), "build() must be called first");
+
+	KnnResults res(k);
+	if (m_data.isFloat())
+		kdForestSearch(
+			queries.rowFloats(queryRow), m_data.floats.data(), m_data.stride,
+			m_nodes, m_leafIdxs, desc_select_f32_kernel(), maxChecks, res);
+	else
+		kdForestSearch(
+			queries.rowBytes(queryRow), m_data.bytes.data(), m_data.stride,
+			m_nodes, m_leafIdxs, desc_select_u8_kernel(false), maxChecks,
+			res);
+	return res.toMatches(queryRow, true, out);
+	MRPT_END
+}
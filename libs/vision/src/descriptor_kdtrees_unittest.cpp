@@ -0,0 +1,136 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2020, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include <gtest/gtest.h>
+#include <mrpt/random/RandomGenerators.h>
+#include <mrpt/vision/descriptor_kdtrees.h>
+
+using namespace mrpt::vision;
+
+// A database of random descriptors, and queries which are noisy copies of
+// some of them:
+static void makeDescriptors(
+	TDescriptorType type, size_t nDB, size_t nQueries, TPackedDescriptors& db,
+	TPackedDescriptors& queries, std::vector<size_t>& queryOrigin)
+{
+	auto& rng = mrpt::random::getRandomGenerator();
+	rng.randomize(4321);
+
+	CFeatureList fDB, fQ;
+	for (size_t i = 0; i < nDB; i++)
+	{
+		CFeature f;
+		if (type == descORB)
+		{
+			f.descriptors.ORB.emplace(32);
+			for (auto& v : *f.descriptors.ORB)
+				v = rng.drawUniform32bit() & 0xff;
+		}
+		else
+		{
+			f.descriptors.SURF.emplace(64);
+			for (auto& v : *f.descriptors.SURF)
+				v = rng.drawUniform(-1.0f, 1.0f);
+		}
+		fDB.push_back(f);
+	}
+	queryOrigin.clear();
+	for (size_t i = 0; i < nQueries; i++)
+	{
+		const size_t orig = rng.drawUniform32bit() % nDB;
+		CFeature f = fDB[orig];
+		for (int k = 0; k < 8; k++)
+		{
+			if (type == descORB)
+				(*f.descriptors.ORB)[rng.drawUniform32bit() % 32] ^=
+					1 << (rng.drawUniform32bit() % 8);
+			else
+				(*f.descriptors.SURF)[rng.drawUniform32bit() % 64] +=
+					rng.drawUniform(-0.1f, 0.1f);
+		}
+		fQ.push_back(f);
+		queryOrigin.push_back(orig);
+	}
+	fDB.getPackedDescriptors(type, db);
+	fQ.getPackedDescriptors(type, queries);
+}
+
+template <class INDEX>
+static double recall(
+	const INDEX& index, const TPackedDescriptors& queries,
+	const std::vector<size_t>& queryOrigin)
+{
+	size_t good = 0;
+	std::vector<TDescriptorMatch> nn;
+	for (size_t i = 0; i < queries.rows; i++)
+	{
+		const size_t n = index.knnSearch(queries, i, 3, nn);
+		EXPECT_LE(n, 3U);
+		EXPECT_EQ(n, nn.size());
+		for (size_t k = 1; k < nn.size(); k++)
+			EXPECT_LE(nn[k - 1].distance, nn[k].distance);
+		if (n && nn[0].idx2 == queryOrigin[i]) good++;
+	}
+	return double(good) / queries.rows;
+}
+
+TEST(TBinaryDescriptorsLSHIndex, recall)
+{
+	TPackedDescriptors db, queries;
+	std::vector<size_t> origin;
+	makeDescriptors(descORB, 20000, 500, db, queries, origin);
+
+	TBinaryDescriptorsLSHIndex index;
+	index.options.keyBits = 12;
+	index.build(db);
+	EXPECT_EQ(index.size(), db.rows);
+	EXPECT_GT(recall(index, queries, origin), 0.95);
+
+	// Fewer tables, no multi-probe: faster but still useful:
+	index.options.numTables = 2;
+	index.options.multiProbeLevel = 0;
+	index.build(db);
+	EXPECT_GT(recall(index, queries, origin), 0.5);
+
+	// Distances must be the exact Hamming ones:
+	std::vector<TDescriptorMatch> nn;
+	index.knnSearch(db, 10, 1, nn);
+	ASSERT_EQ(nn.size(), 1U);
+	EXPECT_EQ(nn[0].idx2, 10U);
+	EXPECT_EQ(nn[0].distance, 0);
+	EXPECT_THROW(index.knnSearch(db, 10, 0, nn), std::exception);
+}
+
+TEST(TDescriptorsKDForestIndex, recall)
+{
+	TPackedDescriptors db, queries;
+	std::vector<size_t> origin;
+	makeDescriptors(descSURF, 20000, 500, db, queries, origin);
+
+	TDescriptorsKDForestIndex index;
+	index.build(db);
+	EXPECT_EQ(index.size(), db.rows);
+	EXPECT_GT(recall(index, queries, origin), 0.9);
+
+	// More checks, better recall:
+	index.maxChecks = 4096;
+	EXPECT_GT(recall(index, queries, origin), 0.98);
+
+	std::vector<TDescriptorMatch> nn;
+	EXPECT_THROW(index.knnSearch(db, 10, 0, nn), std::exception);
+}
+
+TEST(TDescriptorsKDForestIndex, wrongType)
+{
+	TPackedDescriptors db, queries;
+	std::vector<size_t> origin;
+	makeDescriptors(descORB, 100, 10, db, queries, origin);
+	TDescriptorsKDForestIndex index;
+	EXPECT_THROW(index.build(db), std::exception);
+}
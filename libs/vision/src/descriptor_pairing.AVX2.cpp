@@ -0,0 +1,151 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2020, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include "vision-precomp.h"  // Precompiled headers
+
+#include <mrpt/config.h>
+
+#if MRPT_ARCH_INTEL_COMPATIBLE
+// ---------------------------------------------------------------------------
+//   This file contains the AVX2 optimized functions for
+//   mrpt::vision::matchDescriptors()
+//    See the sources and the doxygen documentation page "sse_optimizations" for
+//    more details.
+// ---------------------------------------------------------------------------
+
+#include <immintrin.h>
+#include "descriptor_pairing.SSEx.h"
+
+/** \addtogroup sse_optimizations
+ *  SSE optimized functions
+ *  @{
+ */
+
+static inline int32_t hsum_epi32(__m256i v)
+{
+	__m128i s = _mm_add_epi32(
+		_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+	s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(1, 0, 3, 2)));
+	s = _mm_add_epi32(s, _mm_shuffle_epi32(s, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_cvtsi128_si32(s);
+}
+
+/** Hamming distances, with the nibble look-up-table popcount (Mula et al.)
+ * and _mm256_sad_epu8() to add up the per-byte counts. `stride` must be a
+ * multiple of 32. */
+void desc_AVX2_hamming(
+	const uint8_t* q, const uint8_t* rows, std::size_t n, std::size_t stride,
+	float* out)
+{
+	const __m256i lut = _mm256_setr_epi8(
+		0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1, 2, 1, 2, 2, 3,
+		1, 2, 2, 3, 2, 3, 3, 4);
+	const __m256i low4 = _mm256_set1_epi8(0x0f);
+	const __m256i zero = _mm256_setzero_si256();
+
+	const auto popcnt = [&](__m256i x) {
+		const __m256i lo = _mm256_and_si256(x, low4);
+		const __m256i hi = _mm256_and_si256(_mm256_srli_epi16(x, 4), low4);
+		return _mm256_sad_epu8(
+			_mm256_add_epi8(
+				_mm256_shuffle_epi8(lut, lo), _mm256_shuffle_epi8(lut, hi)),
+			zero);
+	};
+
+	std::size_t r = 0;
+	if (stride == 32)
+	{
+		// 256bit descriptors (e.g. ORB): 4 rows at once, to save the
+		// horizontal sums. Each count fits in the low 32bit of its qword.
+		const __m256i qv =
+			_mm256_loadu_si256(reinterpret_cast<const __m256i*>(q));
+		const auto row = [&](std::size_t i) {
+			return popcnt(_mm256_xor_si256(
+				qv, _mm256_loadu_si256(
+						reinterpret_cast<const __m256i*>(rows + 32 * i))));
+		};
+		for (; r + 4 <= n; r += 4, rows += 4 * 32)
+		{
+			const __m256i u =
+				_mm256_or_si256(row(0), _mm256_slli_epi64(row(1), 32));
+			const __m256i v =
+				_mm256_or_si256(row(2), _mm256_slli_epi64(row(3), 32));
+			const __m128i u2 = _mm_add_epi32(
+				_mm256_castsi256_si128(u), _mm256_extracti128_si256(u, 1));
+			const __m128i v2 = _mm_add_epi32(
+				_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+			const __m128i sum = _mm_add_epi32(
+				_mm_unpacklo_epi64(u2, v2), _mm_unpackhi_epi64(u2, v2));
+			_mm_storeu_ps(out + r, _mm_cvtepi32_ps(sum));
+		}
+	}
+	for (; r < n; r++, rows += stride)
+	{
+		__m256i acc = zero;
+		for (std::size_t k = 0; k < stride; k += 32)
+		{
+			const __m256i x = _mm256_xor_si256(
+				_mm256_loadu_si256(reinterpret_cast<const __m256i*>(q + k)),
+				_mm256_loadu_si256(
+					reinterpret_cast<const __m256i*>(rows + k)));
+			acc = _mm256_add_epi64(acc, popcnt(x));
+		}
+		// Each 64bit lane holds a small count: add them as 32bit words
+		out[r] = static_cast<float>(hsum_epi32(acc));
+	}
+}
+
+/** Squared Euclidean distances between uint8_t descriptors. Exact, since
+ * partial sums always fit in int32. `stride` must be a multiple of 32. */
+void desc_AVX2_sqr_l2_u8(
+	const uint8_t* q, const uint8_t* rows, std::size_t n, std::size_t stride,
+	float* out)
+{
+	for (std::size_t r = 0; r < n; r++, rows += stride)
+	{
+		__m256i acc = _mm256_setzero_si256();
+		for (std::size_t k = 0; k < stride; k += 16)
+		{
+			const __m256i a = _mm256_cvtepu8_epi16(
+				_mm_loadu_si128(reinterpret_cast<const __m128i*>(q + k)));
+			const __m256i b = _mm256_cvtepu8_epi16(
+				_mm_loadu_si128(reinterpret_cast<const __m128i*>(rows + k)));
+			const __m256i d = _mm256_sub_epi16(a, b);
+			acc = _mm256_add_epi32(acc, _mm256_madd_epi16(d, d));
+		}
+		out[r] = static_cast<float>(hsum_epi32(acc));
+	}
+}
+
+/** Squared Euclidean distances between float descriptors. `stride` must be a
+ * multiple of 8. */
+void desc_AVX2_sqr_l2_f32(
+	const float* q, const float* rows, std::size_t n, std::size_t stride,
+	float* out)
+{
+	for (std::size_t r = 0; r < n; r++, rows += stride)
+	{
+		__m256 acc = _mm256_setzero_ps();
+		for (std::size_t k = 0; k < stride; k += 8)
+		{
+			const __m256 d = _mm256_sub_ps(
+				_mm256_loadu_ps(q + k), _mm256_loadu_ps(rows + k));
+			acc = _mm256_add_ps(acc, _mm256_mul_ps(d, d));
+		}
+		__m128 s = _mm_add_ps(
+			_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+		s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+		s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+		out[r] = _mm_cvtss_f32(s);
+	}
+}
+
+/** @} */
+
+#endif  // MRPT_ARCH_INTEL_COMPATIBLE
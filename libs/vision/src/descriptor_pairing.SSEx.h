@@ -0,0 +1,56 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2020, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <mrpt/config.h>
+#include <cstddef>
+#include <cstdint>
+
+// See documentation in descriptor_pairing.AVX2.cpp
+
+// Each function computes the distance between the query row `q` and each
+// of the `n` rows starting at `rows`, separated by `stride` elements. All
+// `stride` elements are compared, since padding is zero in both operands.
+
+// Portable versions, in descriptor_pairing.cpp:
+void desc_hamming(
+	const uint8_t* q, const uint8_t* rows, std::size_t n, std::size_t stride,
+	float* out);
+
+void desc_sqr_l2_u8(
+	const uint8_t* q, const uint8_t* rows, std::size_t n, std::size_t stride,
+	float* out);
+
+void desc_sqr_l2_f32(
+	const float* q, const float* rows, std::size_t n, std::size_t stride,
+	float* out);
+
+using desc_u8_kernel_t = void (*)(
+	const uint8_t*, const uint8_t*, std::size_t, std::size_t, float*);
+using desc_f32_kernel_t =
+	void (*)(const float*, const float*, std::size_t, std::size_t, float*);
+
+/** Returns the fastest available kernel for the Hamming (`binary=true`) or
+ * squared L2 distance between uint8_t descriptors */
+desc_u8_kernel_t desc_select_u8_kernel(bool binary);
+/** Returns the fastest available kernel for the squared L2 distance between
+ * float descriptors */
+desc_f32_kernel_t desc_select_f32_kernel();
+
+void desc_AVX2_hamming(
+	const uint8_t* q, const uint8_t* rows, std::size_t n, std::size_t stride,
+	float* out);
+
+void desc_AVX2_sqr_l2_u8(
+	const uint8_t* q, const uint8_t* rows, std::size_t n, std::size_t stride,
+	float* out);
+
+void desc_AVX2_sqr_l2_f32(
+	const float* q, const float* rows, std::size_t n, std::size_t stride,
+	float* out);
@@ -0,0 +1,258 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2020, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include "vision-precomp.h"  // Precompiled headers
+
+#include <mrpt/core/WorkerThreadsPool.h>
+#include <mrpt/core/cpu.h>
+#include <mrpt/vision/descriptor_pairing.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+
+// Prototypes of SSE2/AVX2 optimized functions:
+#include "descriptor_pairing.SSEx.h"
+
+using namespace mrpt;
+using namespace mrpt::vision;
+
+namespace
+{
+inline uint64_t popcount64(uint64_t x)
+{
+	x = x - ((x >> 1) & 0x5555555555555555ULL);
+	x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+	x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+	return (x * 0x0101010101010101ULL) >> 56;
+}
+}  // namespace
+
+// Portable versions of the kernels in descriptor_pairing.AVX2.cpp:
+void desc_hamming(
+	const uint8_t* q, const uint8_t* rows, std::size_t n, std::size_t stride,
+	float* out)
+{
+	for (std::size_t r = 0; r < n; r++, rows += stride)
+	{
+		uint64_t cnt = 0;
+		for (std::size_t k = 0; k < stride; k += 8)
+		{
+			uint64_t a, b;
+			std::memcpy(&a, q + k, 8);
+			std::memcpy(&b, rows + k, 8);
+			cnt += popcount64(a ^ b);
+		}
+		out[r] = static_cast<float>(cnt);
+	}
+}
+
+void desc_sqr_l2_u8(
+	const uint8_t* q, const uint8_t* rows, std::size_t n, std::size_t stride,
+	float* out)
+{
+	for (std::size_t r = 0; r < n; r++, rows += stride)
+	{
+		int32_t acc = 0;
+		for (std::size_t k = 0; k < stride; k++)
+		{
+			const int32_t d = int32_t(q[k]) - int32_t(rows[k]);
+			acc += d * d;
+		}
+		out[r] = static_cast<float>(acc);
+	}
+}
+
+void desc_sqr_l2_f32(
+	const float* q, const float* rows, std::size_t n, std::size_t stride,
+	float* out)
+{
+	for (std::size_t r = 0; r < n; r++, rows += stride)
+	{
+		// Same order of additions than the AVX2 version, so both give
+		// exactly the same result:
+		float acc[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+		for (std::size_t k = 0; k < stride; k += 8)
+			for (int l = 0; l < 8; l++)
+			{
+				const float d = q[k + l] - rows[k + l];
+				acc[l] += d * d;
+			}
+		for (int l = 0; l < 4; l++) acc[l] += acc[l + 4];
+		out[r] = (acc[0] + acc[2]) + (acc[1] + acc[3]);
+	}
+}
+
+desc_u8_kernel_t desc_select_u8_kernel(bool binary)
+{
+#if MRPT_ARCH_INTEL_COMPATIBLE
+	if (mrpt::cpu::supports(mrpt::cpu::feature::AVX2))
+		return binary ? &desc_AVX2_hamming : &desc_AVX2_sqr_l2_u8;
+#endif
+	return binary ? &desc_hamming : &desc_sqr_l2_u8;
+}
+
+desc_f32_kernel_t desc_select_f32_kernel()
+{
+#if MRPT_ARCH_INTEL_COMPATIBLE
+	if (mrpt::cpu::supports(mrpt::cpu::feature::AVX2))
+		return &desc_AVX2_sqr_l2_f32;
+#endif
+	return &desc_sqr_l2_f32;
+}
+
+size_t mrpt::vision::matchDescriptors(
+	const TPackedDescriptors& d1, const TPackedDescriptors& d2,
+	std::vector<TDescriptorMatch>& matches,
+	const TDescriptorMatchingParams& params)
+{
+	MRPT_START
+
+	ASSERTMSG_(d1.type == d2.type, "Descriptor types do not match");
+	ASSERT_EQUAL_(d1.length, d2.length);
+	ASSERT_EQUAL_(d1.stride, d2.stride);
+	ASSERT_GT_(params.maxRatio, 0);
+
+	matches.clear();
+	const size_t n1 = d1.rows, n2 = d2.rows, stride = d1.stride;
+	if (!n1 || !n2) return 0;
+
+	// Distances between row `i` of d1 and rows [j0, j0+n) of d2. For L2, the
+	// squared distance is used until the end.
+	std::function<void(size_t, size_t, size_t, float*)> dists;
+	if (d1.isFloat())
+	{
+		ASSERT_EQUAL_(d1.floats.size(), n1 * stride);
+		ASSERT_EQUAL_(d2.floats.size(), n2 * stride);
+		const auto kernel = desc_select_f32_kernel();
+		dists = [&, kernel](size_t i, size_t j0, size_t n, float* out) {
+			kernel(d1.rowFloats(i), d2.rowFloats(j0), n, stride, out);
+		};
+	}
+	else
+	{
+		ASSERT_EQUAL_(d1.bytes.size(), n1 * stride);
+		ASSERT_EQUAL_(d2.bytes.size(), n2 * stride);
+		const auto kernel = desc_select_u8_kernel(d1.isBinary());
+		dists = [&, kernel](size_t i, size_t j0, size_t n, float* out) {
+			kernel(d1.rowBytes(i), d2.rowBytes(j0), n, stride, out);
+		};
+	}
+
+	// Best and second best candidates for each row in d1:
+	constexpr float INF = std::numeric_limits<float>::max();
+	std::vector<float> best1(n1, INF), best2(n1, INF);
+	std::vector<size_t> best1Idx(n1, 0);
+
+	// Rows of d1 are split in contiguous blocks, one per thread. Each block
+	// also keeps its own best row for each column of d2, for cross-checking:
+	constexpr size_t MIN_ROWS_PER_THREAD = 64;
+	const unsigned int numThreads =
+		mrpt::WorkerThreadsPool::clampNumThreads(params.numThreads);
+	const size_t nBlocks = std::max<size_t>(
+		1, std::min<size_t>(numThreads, n1 / MIN_ROWS_PER_THREAD));
+	const size_t blockRows = (n1 + nBlocks - 1) / nBlocks;
+
+	std::vector<std::vector<float>> colBest(nBlocks);
+	std::vector<std::vector<size_t>> colBestIdx(nBlocks);
+
+	auto processBlocks = [&](size_t firstBlock, size_t lastBlock) {
+		// Columns are visited in tiles, so they stay in the cache while all
+		// rows of the block are compared against them:
+		constexpr size_t TILE = 256;
+		float buf[TILE];
+		for (size_t b = firstBlock; b < lastBlock; b++)
+		{
+			const size_t i0 = b * blockRows, i1 = std::min(n1, i0 + blockRows);
+			auto& cb = colBest[b];
+			auto& cbIdx = colBestIdx[b];
+			if (params.crossCheck)
+			{
+				cb.assign(n2, INF);
+				cbIdx.assign(n2, 0);
+			}
+			for (size_t j0 = 0; j0 < n2; j0 += TILE)
+			{
+				const size_t n = std::min(TILE, n2 - j0);
+				for (size_t i = i0; i < i1; i++)
+				{
+					dists(i, j0, n, buf);
+					float b1 = best1[i], b2 = best2[i];
+					size_t b1Idx = best1Idx[i];
+					for (size_t k = 0; k < n; k++)
+					{
+						const float d = buf[k];
+						if (d < b2)
+						{
+							if (d < b1)
+							{
+								b2 = b1;
+								b1 = d;
+								b1Idx = j0 + k;
+							}
+							else
+								b2 = d;
+						}
+					}
+					best1[i] = b1;
+					best2[i] = b2;
+					best1Idx[i] = b1Idx;
+					if (params.crossCheck)
+					{
+						for (size_t k = 0; k < n; k++)
+						{
+							if (buf[k] < cb[j0 + k])
+							{
+								cb[j0 + k] = buf[k];
+								cbIdx[j0 + k] = i;
+							}
+						}
+					}
+				}
+			}
+		}
+	};
+
+	if (nBlocks == 1)
+		processBlocks(0, 1);
+	else
+		mrpt::WorkerThreadsPool::sharedPool().parallel_for(
+			0, nBlocks, processBlocks, 1);
+
+	// Merge the per-block best rows of each column. Ties are resolved to the
+	// lowest row index, as in the single-threaded case:
+	if (params.crossCheck)
+	{
+		for (size_t b = 1; b < nBlocks; b++)
+			for (size_t j = 0; j < n2; j++)
+				if (colBest[b][j] < colBest[0][j])
+				{
+					colBest[0][j] = colBest[b][j];
+					colBestIdx[0][j] = colBestIdx[b][j];
+				}
+	}
+
+	const bool isL2 = !d1.isBinary();
+	const bool doRatio = params.maxRatio < 1.0f;
+	const float ratio =
+		isL2 ? params.maxRatio * params.maxRatio : params.maxRatio;
+	for (size_t i = 0; i < n1; i++)
+	{
+		if (doRatio && best2[i] != INF && !(best1[i] < ratio * best2[i]))
+			continue;
+		const size_t j = best1Idx[i];
+		if (params.crossCheck && colBestIdx[0][j] != i) continue;
+		const float dist = isL2 ? std::sqrt(best1[i]) : best1[i];
+		if (dist > params.maxDistance) continue;
+		matches.emplace_back(i, j, dist);
+	}
+	return matches.size();
+
+	MRPT_END
+}
@@ -0,0 +1,168 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2020, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include <gtest/gtest.h>
+#include <mrpt/core/cpu.h>
+#include <mrpt/random/RandomGenerators.h>
+#include <mrpt/vision/descriptor_pairing.h>
+
+using namespace mrpt::vision;
+
+// Features in `f2` are noisy copies of those in `f1` (in reverse order),
+// plus some random distractors:
+static void makeFeatures(
+	TDescriptorType type, size_t N, CFeatureList& f1, CFeatureList& f2)
+{
+	auto& rng = mrpt::random::getRandomGenerator();
+	rng.randomize(1234);
+
+	auto randomFeature = [&]() {
+		CFeature f;
+		auto& d = f.descriptors;
+		switch (type)
+		{
+			case descORB:
+				d.ORB.emplace(32);
+				for (auto& v : *d.ORB) v = rng.drawUniform32bit() & 0xff;
+				break;
+			case descSIFT:
+				d.SIFT.emplace(128);
+				for (auto& v : *d.SIFT) v = rng.drawUniform32bit() & 0xff;
+				break;
+			case descSURF:
+				d.SURF.emplace(64);
+				for (auto& v : *d.SURF) v = rng.drawUniform(-1.0f, 1.0f);
+				break;
+			default:
+				THROW_EXCEPTION("Unexpected type");
+		};
+		return f;
+	};
+	auto perturb = [&](CFeature f) {
+		auto& d = f.descriptors;
+		for (int k = 0; k < 4; k++)
+		{
+			if (d.ORB) (*d.ORB)[rng.drawUniform32bit() % 32] ^= 1;
+			if (d.SIFT) (*d.SIFT)[rng.drawUniform32bit() % 128] ^= 3;
+			if (d.SURF)
+				(*d.SURF)[rng.drawUniform32bit() % 64] +=
+					rng.drawUniform(-0.05f, 0.05f);
+		}
+		return f;
+	};
+
+	f1.clear();
+	f2.clear();
+	for (size_t i = 0; i < N; i++) f1.push_back(randomFeature());
+	for (size_t i = 0; i < N; i++) f2.push_back(perturb(f1[N - 1 - i]));
+	for (size_t i = 0; i < N / 2; i++) f2.push_back(randomFeature());
+}
+
+// Reference implementation on CFeature's own descriptor distances:
+static std::vector<TDescriptorMatch> bruteForceMatch(
+	const CFeatureList& f1, const CFeatureList& f2, TDescriptorType type,
+	const TDescriptorMatchingParams& p)
+{
+	const auto dist = [&](size_t i, size_t j) {
+		return f1[i].descriptorDistanceTo(f2[j], type, false);
+	};
+	std::vector<size_t> best(f1.size());
+	std::vector<float> bestD(f1.size()), secondD(f1.size());
+	for (size_t i = 0; i < f1.size(); i++)
+	{
+		float b1 = std::numeric_limits<float>::max(), b2 = b1;
+		for (size_t j = 0; j < f2.size(); j++)
+		{
+			const float d = dist(i, j);
+			if (d < b1)
+			{
+				b2 = b1;
+				b1 = d;
+				best[i] = j;
+			}
+			else if (d < b2)
+				b2 = d;
+		}
+		bestD[i] = b1;
+		secondD[i] = b2;
+	}
+	std::vector<TDescriptorMatch> ret;
+	for (size_t i = 0; i < f1.size(); i++)
+	{
+		if (!(bestD[i] < p.maxRatio * secondD[i])) continue;
+		if (bestD[i] > p.maxDistance) continue;
+		if (p.crossCheck)
+		{
+			bool isBest = true;
+			for (size_t k = 0; k < f1.size() && isBest; k++)
+				if (dist(k, best[i]) < bestD[i] ||
+					(k < i && dist(k, best[i]) == bestD[i]))
+					isBest = false;
+			if (!isBest) continue;
+		}
+		ret.emplace_back(i, best[i], bestD[i]);
+	}
+	return ret;
+}
+
+static void test_match(TDescriptorType type)
+{
+	CFeatureList f1, f2;
+	makeFeatures(type, 300, f1, f2);
+
+	TPackedDescriptors d1, d2;
+	f1.getPackedDescriptors(type, d1);
+	f2.getPackedDescriptors(type, d2);
+	EXPECT_EQ(d1.rows, f1.size());
+	EXPECT_EQ(d2.rows, f2.size());
+	EXPECT_EQ(d1.stride % (32 / (d1.isFloat() ? 4 : 1)), 0U);
+
+	const bool hadAVX2 = mrpt::cpu::supports(mrpt::cpu::feature::AVX2);
+	for (const bool crossCheck : {false, true})
+	{
+		TDescriptorMatchingParams p;
+		p.crossCheck = crossCheck;
+		const auto gt = bruteForceMatch(f1, f2, type, p);
+		EXPECT_GT(gt.size(), f1.size() / 2);
+
+		for (const bool avx2 : {false, true})
+		{
+			if (avx2 && !hadAVX2) continue;
+			mrpt::cpu::overrideDetectedFeature(mrpt::cpu::feature::AVX2, avx2);
+			for (const unsigned int nThreads : {1U, 4U, 0U})
+			{
+				p.numThreads = nThreads;
+				std::vector<TDescriptorMatch> m;
+				matchDescriptors(d1, d2, m, p);
+
+				ASSERT_EQ(m.size(), gt.size())
+					<< "avx2=" << avx2 << " nThreads=" << nThreads;
+				for (size_t k = 0; k < m.size(); k++)
+				{
+					EXPECT_EQ(m[k].idx1, gt[k].idx1);
+					EXPECT_EQ(m[k].idx2, gt[k].idx2);
+					EXPECT_NEAR(m[k].distance, gt[k].distance, 1e-4);
+				}
+			}
+		}
+		mrpt::cpu::overrideDetectedFeature(mrpt::cpu::feature::AVX2, hadAVX2);
+	}
+}
+
+TEST(matchDescriptors, ORB) { test_match(descORB); }
+TEST(matchDescriptors, SIFT) { test_match(descSIFT); }
+TEST(matchDescriptors, SURF) { test_match(descSURF); }
+
+TEST(matchDescriptors, missingDescriptor)
+{
+	CFeatureList f1, f2;
+	makeFeatures(descORB, 10, f1, f2);
+	TPackedDescriptors d;
+	EXPECT_THROW(f1.getPackedDescriptors(descSIFT, d), std::exception);
+}